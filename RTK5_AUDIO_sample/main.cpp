@@ -16,8 +16,8 @@
 #include "common/tpu_io.hpp"
 #include "common/qspi_io.hpp"
 #include "sound/sound_out.hpp"
-#include "sound/mp3_in.hpp"
-#include "sound/wav_in.hpp"
+#include "sound/resampler.hpp"
+#include "sound/play_list.hpp"
 #include "graphics/font8x16.hpp"
 #include "graphics/kfont.hpp"
 #include "graphics/graphics.hpp"
@@ -116,6 +116,11 @@ namespace {
 	typedef device::tpu_io<device::TPU0, tpu_task> TPU0;
 	TPU0		tpu0_;
 
+	// デコーダーの出力は、固定の出力レートに変換する（曲毎にタイマーを変えない）
+	static const uint32_t SAMPLE_RATE = 44100;
+	typedef sound::resampler<SOUND_OUT> RESAMPLER;
+	RESAMPLER	resampler_(sound_out_, SAMPLE_RATE);
+
 	// GLCDC
 	static const int16_t LCD_X = 480;
 	static const int16_t LCD_Y = 272;
@@ -144,10 +149,9 @@ namespace {
 	typedef graphics::filer<SDC, RENDER> FILER;
 	FILER		filer_(sdc_, render_);
 
-	typedef sound::mp3_in MP3_IN;
-	MP3_IN		mp3_in_;
-	typedef sound::wav_in WAV_IN;
-	WAV_IN		wav_in_;
+	// 次の曲を先読みして、曲間を途切れさせない
+	typedef sound::play_list<RESAMPLER, 64> PLAY_LIST;
+	PLAY_LIST	play_list_;
 
 	uint8_t		pad_level_;
 
@@ -211,7 +215,7 @@ namespace {
 		}
 		if(chip::on(ptrg, chip::FAMIPAD_ST::START)) { // Cancel Play
 			ctrl = sound::af_play::CTRL::STOP;
-			sdc_.stall_dir_list();
+			play_list_.clear();
 			render_.clear(RENDER::COLOR::Black);
 		}
 
@@ -224,7 +228,7 @@ namespace {
 			touch_org_ = xy.x;
 		} else if(touch_num_ == 3 && tnum < 3) {  // Cancel Play（３点タッチが離れた瞬間）
 			ctrl = sound::af_play::CTRL::STOP;
-			sdc_.stall_dir_list();
+			play_list_.clear();
 			render_.clear(RENDER::COLOR::Black);
 			touch_org_ = xy.x;
 		} else if(touch_num_ == 0 && tnum == 1) {
@@ -276,81 +280,64 @@ namespace {
 	}
 
 
-	bool play_mp3_(const char* fname)
+	void play_()
 	{
-		utils::file_io fin;
-		if(!fin.open(fname, "rb")) {
-			return false;
-		}
-		mp3_in_.set_ctrl_task(sound_ctrl_task_);
-		mp3_in_.set_tag_task(sound_tag_task_);
-		mp3_in_.set_update_task(sound_update_task_);
-		bool ret = mp3_in_.decode(fin, sound_out_);
-		fin.close();
-		return ret;
+		play_list_.set_ctrl_task(sound_ctrl_task_);
+		play_list_.set_tag_task(sound_tag_task_);
+		play_list_.set_update_task(sound_update_task_);
+		play_list_.play(resampler_);
 	}
 
 
-	bool play_wav_(const char* fname)
+	void play_file_(const char* fname)
 	{
-		utils::file_io fin;
-		if(!fin.open(fname, "rb")) {
-			return false;
-		}
-		wav_in_.set_ctrl_task(sound_ctrl_task_);
-		wav_in_.set_tag_task(sound_tag_task_);
-		wav_in_.set_update_task(sound_update_task_);
-		bool ret = wav_in_.decode(fin, sound_out_);
-		fin.close();
-		return ret;
+		play_list_.clear();
+		play_list_.add(fname);
+		play_();
 	}
 
 
-	void play_loop_(const char*, const char*);
-
-
 	struct loop_t {
 		const char*	start;
 		bool	enable;
 	};
+	loop_t	loop_;
 
 
 	void play_loop_func_(const char* name, const FILINFO* fi, bool dir, void* option)
 	{
-		loop_t* t = static_cast<loop_t*>(option);
-		if(t->enable) {
-			if(strcmp(name, t->start) != 0) {
+		if(loop_.enable) {
+			if(strcmp(name, loop_.start) != 0) {
 				return;
 			} else {
-				t->enable = false;
+				loop_.enable = false;
 			}
 		}
 		if(dir) {
-			play_loop_(name, "");
+			sdc_.start_dir_list(name, play_loop_func_, true);
 		} else {
-			const char* ext = strrchr(name, '.');
-			if(ext != nullptr) {
-				if(strcmp(ext, ".mp3") == 0) {
-					play_mp3_(name);
-				} else if(strcmp(ext, ".wav") == 0) {
-					play_wav_(name);
-				}
-			}
+			play_list_.add(name);
 		}
 	}
 
 
+	// 曲を全て登録してから再生する（再生中に、ディレクトリーを読まない）
 	void play_loop_(const char* root, const char* start)
 	{
-		loop_t t;
-		t.start = start;
+		loop_.start = start;
 		if(strlen(start) != 0) {
-			t.enable = true;
+			loop_.enable = true;
 		} else {
-			t.enable = false;
+			loop_.enable = false;
+		}
+		play_list_.clear();
+		sdc_.set_dir_list_limit(10);
+		sdc_.start_dir_list(root, play_loop_func_, true);
+		uint32_t n;
+		while(sdc_.probe_dir_list(n)) {
+			sdc_.service(sdh_.service());
 		}
-		sdc_.set_dir_list_limit(1);
-		sdc_.start_dir_list(root, play_loop_func_, true, &t);
+		play_();
 	}
 
 
@@ -395,7 +382,7 @@ namespace {
 					if(std::strcmp(tmp, "*") == 0) {
 						play_loop_("", "");
 					} else {
-						play_mp3_(tmp);
+						play_file_(tmp);
 					}
 				} else {
 					play_loop_("", "");
@@ -534,7 +521,7 @@ int main(int argc, char** argv)
 	sound_out_.mute();
 
 	{  // サンプリング・タイマー設定
-		set_sample_rate(44100);
+		set_sample_rate(SAMPLE_RATE);
 	}
 
 	{  // DMAC マネージャー開始
@@ -8,7 +8,10 @@
                 https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <algorithm>
 #include "common/renesas.hpp"
+#include "peak_pyramid.hpp"
+#include "trigger.hpp"
 
 namespace utils {
 
@@ -26,18 +29,10 @@ namespace utils {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief  キャプチャー・トリガー
-	*/
-	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	enum class capture_trigger : uint8_t {
-		NONE,		///< 何もしない
-		SINGLE,		///< シングル取り込み
-	};
-
-
-	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	/*!
-		@brief  キャプチャー・クラス
+		@brief  キャプチャー・クラス @n
+				割り込みでリング・バッファに取り込み、トリガーの判定を行う。@n
+				取り込みが終わったら、service() でトリガー位置が「プリ・トリガー数」に @n
+				なる様に並べ替える。
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <uint32_t CAPN>
@@ -45,34 +40,30 @@ namespace utils {
 	public:
 		static const uint32_t CAP_NUM = CAPN;
 
+		typedef peak_pyramid<CAPN, capture_data> PEAK;
+		typedef typename PEAK::peak_t peak_t;
+		typedef trigger_engine<CAPN> TRIGGER;
+
 	private:
 		static capture_data				data_[CAPN];
 
 		typedef device::S12AD  ADC0;
 		typedef device::S12AD1 ADC1;
 
-		static volatile uint16_t		pos_;
-		static volatile capture_trigger	trigger_;
+		static TRIGGER					trigger_;
 
 		class tpu_task {
 		public:
 			void operator() ()
 			{
-				switch(trigger_) {
-				case capture_trigger::NONE:
-					ADC0::ADCSR = ADC0::ADCSR.ADCS.b(0b01) | ADC0::ADCSR.ADST.b();
-					ADC1::ADCSR = ADC1::ADCSR.ADCS.b(0b01) | ADC1::ADCSR.ADST.b();
-					break;
-				case capture_trigger::SINGLE:
-					data_[pos_].ch0_ = ADC0::ADDR(ADC0::analog::AIN000);
-					data_[pos_].ch1_ = ADC1::ADDR(ADC1::analog::AIN114);
-					ADC0::ADCSR = ADC0::ADCSR.ADCS.b(0b01) | ADC0::ADCSR.ADST.b();
-					ADC1::ADCSR = ADC1::ADCSR.ADCS.b(0b01) | ADC1::ADCSR.ADST.b();
-					++pos_;
-					if(pos_ >= CAPN) {
-						trigger_ = capture_trigger::NONE;
-					}
+				if(trigger_.is_store()) {
+					auto& d = data_[trigger_.get_pos()];
+					d.ch0_ = ADC0::ADDR(ADC0::analog::AIN000);
+					d.ch1_ = ADC1::ADDR(ADC1::analog::AIN114);
+					trigger_.update(trigger_.get_channel() == 0 ? d.ch0_ : d.ch1_);
 				}
+				ADC0::ADCSR = ADC0::ADCSR.ADCS.b(0b01) | ADC0::ADCSR.ADST.b();
+				ADC1::ADCSR = ADC1::ADCSR.ADCS.b(0b01) | ADC1::ADCSR.ADST.b();
 			}
 		};
 
@@ -81,13 +72,19 @@ namespace utils {
 
 		bool		start_cap_;
 
+		PEAK		peak_;
+		bool		ready_;		///< 並べ替えが済んだ
+		uint32_t	count_;
+
+		static const uint32_t PEAK_STEP = 4096;	///< service() 一回でピラミッドに加える数
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  コンストラクタ
 		*/
 		//-----------------------------------------------------------------//
-		capture() noexcept : start_cap_(false) { }
+		capture() noexcept : start_cap_(false), peak_(), ready_(false), count_(0) { }
 
 
 		//-----------------------------------------------------------------//
@@ -152,24 +149,61 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  トリガー設定
+			@brief  トリガー・エンジンの参照（トリガーの種類、プリ・トリガー数等の設定） @n
+					設定は、取り込みを止めて（set_trigger(NONE)）から行う。
+			@return トリガー・エンジン
+		*/
+		//-----------------------------------------------------------------//
+		TRIGGER& at_trigger() noexcept { return trigger_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  トリガー設定（取り込み開始）
 			@param[in]	trg		トリガー種別
 		*/
 		//-----------------------------------------------------------------//
 		void set_trigger(capture_trigger trigger) noexcept
 		{
-			pos_ = 0;
-			trigger_ = trigger;
+			trigger_.start(capture_trigger::NONE);
+			peak_.clear();
+			ready_ = false;
+			trigger_.start(trigger);
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  トリガー取得
+			@brief  トリガー取得（SINGLE は、取り込みが終わると NONE になる）
 			@return トリガー
 		*/
 		//-----------------------------------------------------------------//
-		capture_trigger  get_trigger() const noexcept { return trigger_; }
+		capture_trigger  get_trigger() const noexcept { return trigger_.get_mode(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  NORMAL、AUTO の場合、次の取り込みを始める @n
+					（描画、計測が終わって、波形を書き換えても良い時に呼ぶ）
+		*/
+		//-----------------------------------------------------------------//
+		void rearm() noexcept
+		{
+			auto mode = trigger_.get_mode();
+			if(!ready_ || (mode != capture_trigger::NORMAL && mode != capture_trigger::AUTO)) {
+				return;
+			}
+			set_trigger(mode);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  取り込みを終えた回数を取得（変化したら、新しい波形）
+			@return 回数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_count() const noexcept { return count_; }
 
 
 		//-----------------------------------------------------------------//
@@ -181,10 +215,49 @@ namespace utils {
 		{
 			return data_[pos & (CAPN - 1)];
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サービス（取り込みが終わったら並べ替え、ピーク・ピラミッドに追加） @n
+					メインループから呼ぶと、ピラミッドを少しずつ作る。
+			@param[in]	step	ピラミッドに加えるサンプル数
+		*/
+		//-----------------------------------------------------------------//
+		void service(uint32_t step = PEAK_STEP) noexcept
+		{
+			if(!ready_) {
+				if(trigger_.get_state() != TRIGGER::STATE::DONE) return;
+				std::rotate(data_, data_ + trigger_.get_start(), data_ + CAPN);
+				ready_ = true;
+				++count_;
+				if(trigger_.get_mode() == capture_trigger::SINGLE) {
+					trigger_.start(capture_trigger::NONE);
+				}
+			}
+			while(step > 0 && peak_.size() < CAPN) {
+				peak_.add(data_[peak_.size()]);
+				--step;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  範囲のピーク（最小、最大）を取得
+			@param[in]	pos		開始位置
+			@param[in]	len		サンプル数
+			@param[out]	out		ピーク
+			@return 範囲に取り込み済みのサンプルが無い場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool get_peak(int32_t pos, uint32_t len, peak_t& out) noexcept
+		{
+			service(CAPN);
+			return peak_.get(data_, pos, len, out);
+		}
 	};
 
 	template <uint32_t CAPN> capture_data capture<CAPN>::data_[CAPN];
-	template <uint32_t CAPN> volatile uint16_t capture<CAPN>::pos_ = 0;
-	template <uint32_t CAPN>
-	volatile capture_trigger capture<CAPN>::trigger_ = capture_trigger::NONE;
+	template <uint32_t CAPN> typename capture<CAPN>::TRIGGER capture<CAPN>::trigger_;
 }
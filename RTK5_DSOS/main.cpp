@@ -112,7 +112,7 @@ namespace {
 
 	utils::command<256> cmd_;
 
-	utils::capture_trigger	trigger_ = utils::capture_trigger::NONE;
+	uint32_t	capture_count_ = 0;
 
 
 	bool check_mount_() {
@@ -170,14 +170,38 @@ namespace {
 				utils::format("%s\n") % sdc_.get_current();
 				f = true;
 			} else if(cmd_.cmp_word(0, "cap")) { // capture
-				trigger_ = utils::capture_trigger::SINGLE;
-				capture_.set_trigger(trigger_);			
+				capture_.set_trigger(utils::capture_trigger::SINGLE);
 				f = true;
+			} else if(cmd_.cmp_word(0, "trg") && cmdn >= 2) { // trg mode [type [level [pre]]]
+				static const char* modes[] = { "stop", "single", "normal", "auto" };
+				static const char* types[] = {
+					"none", "rise", "fall", "high", "low", "window", "pulse+", "pulse-" };
+				uint32_t mode = 0;
+				while(mode < 4 && !cmd_.cmp_word(1, modes[mode])) ++mode;
+				uint32_t type = 0;
+				if(cmdn >= 3) {
+					while(type < 8 && !cmd_.cmp_word(2, types[type])) ++type;
+				}
+				int32_t level = 2048;
+				int32_t pre = 0;
+				if(mode < 4 && type < 8
+					&& (cmdn < 4 || cmd_.get_integer(3, level))
+					&& (cmdn < 5 || cmd_.get_integer(4, pre))) {
+					capture_.set_trigger(utils::capture_trigger::NONE);
+					auto& trg = capture_.at_trigger();
+					trg.at_eval().set(static_cast<utils::trigger_type>(type), level);
+					trg.set_pre(pre);
+					capture_.set_trigger(static_cast<utils::capture_trigger>(mode));
+					f = true;
+				}
 			} else if(cmd_.cmp_word(0, "help")) {
 				utils::format("    dir [path]\n");
 				utils::format("    cd [path]\n");
 				utils::format("    pwd\n");
 				utils::format("    cap   single trigger\n");
+				utils::format("    trg MODE [TYPE [LEVEL [PRE]]]\n");
+				utils::format("          MODE: stop, single, normal, auto\n");
+				utils::format("          TYPE: none, rise, fall, high, low, window, pulse+, pulse-\n");
 				f = true;
 			}
 			if(!f) {
@@ -334,8 +358,7 @@ int main(int argc, char** argv)
 	LED::DIR = 1;
 
 	{  // startup trigger...
-		trigger_ = utils::capture_trigger::SINGLE;
-		capture_.set_trigger(trigger_);			
+		capture_.set_trigger(utils::capture_trigger::SINGLE);
 	}
 
 	// タッチパネルの安定待ち
@@ -363,18 +386,31 @@ int main(int argc, char** argv)
 
 		sdc_.service(sdh_.service());
 
+		capture_.service();  // 取り込んだ波形を並べ替え、ピーク・ピラミッドを作る
+
 		command_();
 
 		// タッチ操作による画面更新が必要か？
 		bool f = render_wave_.ui_service();
 
+		// 計測（自動計測、FFT）が終わったら描画
+		if(render_wave_.service()) f = true;
+
 		// 波形をキャプチャーしたら描画
-		if(f || (trigger_ != utils::capture_trigger::NONE
-			&& capture_.get_trigger() == utils::capture_trigger::NONE)) {
-			trigger_ = utils::capture_trigger::NONE;
+		if(capture_count_ != capture_.get_count()) {
+			capture_count_ = capture_.get_count();
+			render_wave_.restart_measure();
+			f = true;
+		}
+		if(f) {
 			render_wave_.update();
 		}
 
+		// NORMAL、AUTO の場合、計測が終わったら次を取り込む
+		if(!render_wave_.is_measure()) {
+			capture_.rearm();
+		}
+
 		update_led_();
 	}
 }
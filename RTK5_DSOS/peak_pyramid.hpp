@@ -0,0 +1,173 @@
+#pragma once
+//=====================================================================//
+/*! @file
+    @brief  ピーク（最小、最大）ピラミッド・クラス @n
+			キャプチャー・データの２サンプル、４サンプル、８サンプル・・・毎の @n
+			最小値と最大値を段階的に保持し、任意の範囲のピークを O(log N) で求める。@n
+			サンプルを追加する毎に、完成したノードだけを上の段に伝える（平均 O(1)）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+    @copyright  Copyright (C) 2018 Kunihito Hiramatsu @n
+                Released under the MIT license @n
+                https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ピーク・ピラミッド・クラス
+		@param[in]	N		サンプル数（２のべき乗）
+		@param[in]	DATA	サンプルの型（ch0_、ch1_ を持つ）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t N, class DATA>
+	class peak_pyramid {
+
+		static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+	public:
+		//=================================================================//
+		/*!
+			@brief  ピーク（チャネル毎の最小値、最大値）
+		*/
+		//=================================================================//
+		struct peak_t {
+			uint16_t	min[2];
+			uint16_t	max[2];
+		};
+
+	private:
+		static constexpr uint32_t log2_(uint32_t n) { return n <= 1 ? 0 : 1 + log2_(n >> 1); }
+
+		static const uint32_t LEVELS = log2_(N);	///< 段数（０段目のノードは２サンプル）
+
+		// 段の先頭（０段目から N/2、N/4 ... 個のノードが並ぶ）
+		static uint32_t offset_(uint32_t level) noexcept { return N - (N >> level); }
+
+		peak_t		node_[N - 1];
+		uint32_t	num_;
+
+		static void set_(peak_t& p, const DATA& d) noexcept
+		{
+			p.min[0] = p.max[0] = d.ch0_;
+			p.min[1] = p.max[1] = d.ch1_;
+		}
+
+
+		static void merge_(peak_t& p, uint16_t v, uint32_t ch) noexcept
+		{
+			if(p.min[ch] > v) p.min[ch] = v;
+			if(p.max[ch] < v) p.max[ch] = v;
+		}
+
+
+		static void merge_(peak_t& p, const peak_t& t) noexcept
+		{
+			for(uint32_t ch = 0; ch < 2; ++ch) {
+				if(p.min[ch] > t.min[ch]) p.min[ch] = t.min[ch];
+				if(p.max[ch] < t.max[ch]) p.max[ch] = t.max[ch];
+			}
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクタ
+		*/
+		//-----------------------------------------------------------------//
+		peak_pyramid() noexcept : node_(), num_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  消去（サンプル数を０にする）
+		*/
+		//-----------------------------------------------------------------//
+		void clear() noexcept { num_ = 0; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  登録したサンプル数を取得
+			@return サンプル数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t size() const noexcept { return num_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルを追加
+			@param[in]	d	サンプル
+		*/
+		//-----------------------------------------------------------------//
+		void add(const DATA& d) noexcept
+		{
+			if(num_ >= N) return;
+
+			uint32_t i = num_++;
+			uint32_t idx = i >> 1;
+			peak_t& t = node_[offset_(0) + idx];
+			if((i & 1) == 0) {
+				set_(t, d);
+				return;
+			}
+			merge_(t, d.ch0_, 0);
+			merge_(t, d.ch1_, 1);
+
+			// 完成したノードを、上の段に伝える
+			for(uint32_t level = 1; level < LEVELS; ++level) {
+				const peak_t& c = node_[offset_(level - 1) + idx];
+				peak_t& p = node_[offset_(level) + (idx >> 1)];
+				if((idx & 1) == 0) {
+					p = c;
+					break;
+				}
+				merge_(p, c);
+				idx >>= 1;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  範囲のピークを取得
+			@param[in]	raw		サンプル列（段に揃わない端の計算に使う）
+			@param[in]	pos		開始位置
+			@param[in]	len		サンプル数
+			@param[out]	out		ピーク
+			@return 範囲に登録済みのサンプルが無い場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool get(const DATA* raw, int32_t pos, uint32_t len, peak_t& out) const noexcept
+		{
+			int32_t end = pos + static_cast<int32_t>(len);
+			if(end > static_cast<int32_t>(num_)) end = num_;
+			uint32_t i = pos < 0 ? 0 : pos;
+			if(static_cast<int32_t>(i) >= end) return false;
+
+			out.min[0] = out.min[1] = 0xffff;
+			out.max[0] = out.max[1] = 0;
+			while(static_cast<int32_t>(i) < end) {
+				// 位置が揃っていて、範囲に収まる一番上の段を使う
+				uint32_t level = 0;
+				while(level < LEVELS && (i & ((2 << level) - 1)) == 0
+					&& static_cast<int32_t>(i + (2 << level)) <= end) {
+					++level;
+				}
+				if(level == 0) {
+					merge_(out, raw[i].ch0_, 0);
+					merge_(out, raw[i].ch1_, 1);
+					++i;
+				} else {
+					--level;
+					merge_(out, node_[offset_(level) + (i >> (level + 1))]);
+					i += 2 << level;
+				}
+			}
+			return true;
+		}
+	};
+}
@@ -11,6 +11,8 @@
 #include <cstdint>
 #include "common/enum_utils.hpp"
 #include "common/intmath.hpp"
+#include "graphics/retained.hpp"
+#include "wave_measure.hpp"
 
 namespace utils {
 
@@ -36,12 +38,33 @@ namespace utils {
 		static const int16_t VOLT_BEGIN_POS   = 0;
 		static const int16_t VOLT_LIMIT_POS   = RENDER::width - MENU_SIZE;
 
+		// 波形の描画領域（枠を含む）
+		static const int16_t PLOT_X           = 0;
+		static const int16_t PLOT_Y           = 16;
+		static const int16_t PLOT_W           = 440;
+		static const int16_t PLOT_H           = 240;
+
+		// 縮小（１ピクセル当たりのサンプル数、２のべき乗）
+		static constexpr uint8_t zoom_max_(uint8_t z = 0) {
+			return (static_cast<uint32_t>(PLOT_W) << z) >= CAPTURE::CAP_NUM ? z : zoom_max_(z + 1);
+		}
+		static const uint8_t ZOOM_MAX         = zoom_max_();
+		static const int16_t ZOOM_STEP        = 40;	///< ピンチで一段変える距離
+
+		// 計測（FFT の点数は、キャプチャー数と同じ、最大 4096）
+		static const uint32_t FFT_NUM = CAPTURE::CAP_NUM >= 4096 ? 4096
+			: (CAPTURE::CAP_NUM >= 256 ? CAPTURE::CAP_NUM : 256);
+		typedef wave_measure<CAPTURE, FFT_NUM> MEASURE;
+		static const uint32_t MEASURE_BUDGET  = 4096;	///< service() 一回の計算量
+
 		RENDER&		render_;
 		CAPTURE&	capture_;
 		TOUCH&		touch_;
 
 		int16_t		time_pos_;
 		int16_t		time_org_;
+		uint8_t		time_zoom_;	///< １ピクセル当たり「1 << time_zoom_」サンプル
+		uint8_t		zoom_org_;
 
 		int16_t		ch0_vpos_;
 		int16_t		ch0_vorg_;
@@ -74,8 +97,11 @@ namespace utils {
 			NONE,
 			TIME,
 			VOLT,
+			AUTO,	///< 表示範囲の振幅、実効値、周波数
+			FFT,	///< 表示位置からの振幅スペクトル
 		};
 		MEASERE		measere_;
+		uint8_t		mes_ch_;	///< AUTO、FFT のチャネル
 		int16_t		mes_time_begin_;
 		int16_t		mes_time_size_;
 		int16_t		mes_time_org_;
@@ -88,6 +114,24 @@ namespace utils {
 		bool		touch_down_;
 		uint8_t		touch_num_;
 
+		// 前回と状態が同じウィジェットは描き直さない
+		enum class WIDGET : uint8_t {
+			MENU,				///< メニュー・ボタン（６個）
+			SAMPLING = MENU + 6,
+			CH0,
+			CH1,
+			OVERLAY,			///< 計測ライン、操作ガイド
+			MEASURE,			///< 計測の範囲（変化したら計測し直す）
+			NUM
+		};
+		graphics::retained<static_cast<uint16_t>(WIDGET::NUM)> retained_;
+
+		MEASURE		measure_;
+
+		// 前回描画した波形の、チャネル、列毎の縦の範囲（次回、この範囲だけ背景を戻す）
+		int16_t		span_min_[2][PLOT_W];
+		int16_t		span_max_[2][PLOT_W];
+
 
 		void update_measere_() noexcept
 		{
@@ -109,6 +153,221 @@ namespace utils {
 		}
 
 
+		bool update_widget_(WIDGET w, uint32_t sig) noexcept
+		{
+			return retained_.update(static_cast<uint8_t>(w), sig);
+		}
+
+
+		void reset_span_() noexcept
+		{
+			for(uint32_t ch = 0; ch < 2; ++ch) {
+				for(int16_t x = 0; x < PLOT_W; ++x) {
+					span_min_[ch][x] = 0x7fff;
+					span_max_[ch][x] = -1;
+				}
+			}
+		}
+
+
+		void add_span_(uint32_t ch, int16_t x, int16_t y0, int16_t y1) noexcept
+		{
+			if(y0 > y1) {
+				int16_t t = y0;
+				y0 = y1;
+				y1 = t;
+			}
+			if(span_min_[ch][x] > y0) span_min_[ch][x] = y0;
+			if(span_max_[ch][x] < y1) span_max_[ch][x] = y1;
+		}
+
+
+		// グリッドの破線パターン（draw_grid の破線と同じ）
+		static bool grid_dot_(int16_t pos) noexcept { return (pos & 7) >= 6; }
+
+
+		// 一列の背景（黒とグリッド）を、縦の範囲だけ描き直す
+		void restore_column_(int16_t x, int16_t y0, int16_t y1) noexcept
+		{
+			render_.line_v(x, y0, y1 - y0 + 1, RENDER::COLOR::Black);
+			if(((x - PLOT_X) % GRID) == 0) {
+				if(x == PLOT_X || x == (PLOT_X + PLOT_W)) {
+					render_.line_v(x, y0, y1 - y0 + 1, RENDER::COLOR::Aqua);
+					return;
+				}
+				for(int16_t y = y0; y <= y1; ++y) {
+					if(grid_dot_(y - PLOT_Y)) render_.plot(x, y, RENDER::COLOR::Aqua);
+				}
+			}
+			int16_t y = PLOT_Y + ((y0 - PLOT_Y + GRID - 1) / GRID) * GRID;
+			for(; y <= y1; y += GRID) {
+				if(y == PLOT_Y || y == (PLOT_Y + PLOT_H) || grid_dot_(x - PLOT_X)) {
+					render_.plot(x, y, RENDER::COLOR::Aqua);
+				}
+			}
+		}
+
+
+		void draw_overlay_() noexcept
+		{
+			if(measere_ == MEASERE::TIME || measere_ == MEASERE::VOLT) {
+				update_measere_();
+			} else if(touch_down_) {
+				render_.line(0, TIME_SCROLL_AREA, CH1_MOVE_AREA, TIME_SCROLL_AREA,
+					 RENDER::COLOR::Red);
+				render_.line(CH0_MOVE_AREA, TIME_SCROLL_AREA, CH0_MOVE_AREA, 272 - 16,
+					 RENDER::COLOR::Red);
+				render_.line(CH1_MOVE_AREA, TIME_SCROLL_AREA, CH1_MOVE_AREA, 272 - 16,
+					 RENDER::COLOR::Red);
+			}
+		}
+
+
+		// １ピクセル１サンプルの場合、サンプル間を線で結ぶ
+		void draw_line_() noexcept
+		{
+			for(int16_t x = 0; x < (PLOT_W - 1); ++x) {
+				int16_t p0 = time_pos_ + x;
+				int16_t p1 = time_pos_ + x + 1;
+				if(p1 >= static_cast<int16_t>(CAPTURE::CAP_NUM)) {
+					break;
+				}
+				const auto& d0 = capture_.get(p0);
+				const auto& d1 = capture_.get(p1);
+				{
+					int16_t ofs = ch0_vpos_ + 272 / 2;
+					int16_t y0 = wave_y_(ofs, d0.ch0_);
+					int16_t y1 = wave_y_(ofs, d1.ch0_);
+					render_.line(PLOT_X + x, y0, PLOT_X + x + 1, y1, RENDER::COLOR::Lime);
+					add_span_(0, x, y0, y1);
+					add_span_(0, x + 1, y0, y1);
+				}
+				{
+					int16_t ofs = ch1_vpos_ + 272 / 2;
+					int16_t y0 = wave_y_(ofs, d0.ch1_);
+					int16_t y1 = wave_y_(ofs, d1.ch1_);
+					render_.line(PLOT_X + x, y0, PLOT_X + x + 1, y1, RENDER::COLOR::Fuchsi);
+					add_span_(1, x, y0, y1);
+					add_span_(1, x + 1, y0, y1);
+				}
+			}
+		}
+
+
+		// １ピクセルに複数のサンプルがある場合、ピークを縦線で描く
+		void draw_peak_() noexcept
+		{
+			static const typename RENDER::value_type color[2] = { RENDER::COLOR::Lime, RENDER::COLOR::Fuchsi };
+			const int16_t ofs[2] = { static_cast<int16_t>(ch0_vpos_ + 272 / 2),
+				static_cast<int16_t>(ch1_vpos_ + 272 / 2) };
+			uint32_t n = 1 << time_zoom_;
+			int16_t prev[2][2];
+			bool cont = false;
+			for(int16_t x = 0; x < PLOT_W; ++x) {
+				typename CAPTURE::peak_t pk;
+				if(!capture_.get_peak(static_cast<int32_t>(time_pos_) + (x << time_zoom_), n, pk)) {
+					cont = false;
+					continue;
+				}
+				for(uint32_t ch = 0; ch < 2; ++ch) {
+					int16_t y0 = wave_y_(ofs[ch], pk.max[ch]);
+					int16_t y1 = wave_y_(ofs[ch], pk.min[ch]);
+					int16_t t0 = y0;
+					int16_t t1 = y1;
+					if(cont) {  // 前の列と離れている場合は繋げる
+						if(t1 < prev[ch][0]) t1 = prev[ch][0];
+						if(t0 > prev[ch][1]) t0 = prev[ch][1];
+					}
+					render_.line_v(PLOT_X + x, t0, t1 - t0 + 1, color[ch]);
+					add_span_(ch, x, t0, t1);
+					prev[ch][0] = y0;
+					prev[ch][1] = y1;
+				}
+				cont = true;
+			}
+		}
+
+
+		// 表示範囲が変わったら、計測し直す（結果は service() で少しずつ求める）
+		void start_measure_() noexcept
+		{
+			uint32_t sig = retained_.hash(static_cast<uint32_t>(measere_));
+			sig = retained_.hash(time_pos_, retained_.hash(time_zoom_, retained_.hash(mes_ch_, sig)));
+			if(!update_widget_(WIDGET::MEASURE, sig)) return;
+
+			uint32_t pos = time_pos_ < 0 ? 0 : time_pos_;
+			uint32_t len = pos < CAPTURE::CAP_NUM ? CAPTURE::CAP_NUM - pos : 0;
+			if(measere_ == MEASERE::AUTO) {
+				uint32_t n = static_cast<uint32_t>(PLOT_W) << time_zoom_;
+				if(len > n) len = n;
+				measure_.start(pos, len, mes_ch_);
+			} else {
+				measure_.start(pos, len, mes_ch_, MEASURE::fft_size(len));
+			}
+		}
+
+
+		// 振幅の対数（１６ピクセルで 6dB）
+		static int16_t fft_h_(uint16_t v) noexcept
+		{
+			if(v == 0) return 0;
+			int16_t e = 0;
+			while((v >> e) > 1) ++e;
+			int16_t f = e >= 4 ? (v >> (e - 4)) & 15 : (v << (4 - e)) & 15;
+			int16_t h = (e << 4) + f;
+			return h > PLOT_H ? PLOT_H : h;
+		}
+
+
+		// 振幅スペクトルを、列毎の最大値で描く
+		void draw_fft_() noexcept
+		{
+			uint32_t n = measure_.get_fft_size() / 2;
+			if(n == 0) return;
+
+			const uint16_t* mag = measure_.get_fft();
+			uint8_t ch = measure_.get_fft_channel();
+			auto c = ch == 0 ? RENDER::COLOR::Lime : RENDER::COLOR::Fuchsi;
+			int16_t base = PLOT_Y + PLOT_H;
+			for(int16_t x = 0; x < PLOT_W; ++x) {
+				uint32_t b0 = x * n / PLOT_W;
+				uint32_t b1 = (x + 1) * n / PLOT_W;
+				if(b1 <= b0) b1 = b0 + 1;
+				uint16_t m = 0;
+				for(uint32_t b = b0; b < b1; ++b) {
+					if(m < mag[b]) m = mag[b];
+				}
+				int16_t h = fft_h_(m);
+				if(h <= 0) continue;
+				render_.line_v(PLOT_X + x, base - h, h, c);
+				add_span_(ch, x, base - h, base - 1);
+			}
+		}
+
+
+		// A/D 変換のカウントを電圧にする
+		float volt_(uint8_t ch, float count) const noexcept
+		{
+			static const float div_f[] = {
+				0.05f, 0.1f, 0.25f, 0.5f, 1.0f, 2.5f, 5.0f, 10.0f
+			};
+			return count * div_f[ch == 0 ? ch0_div_ : ch1_div_] / static_cast<float>(GRID * 17);
+		}
+
+
+		static int16_t wave_y_(int16_t ofs, uint16_t v) noexcept
+		{
+			int16_t y = v;
+			y -= 2048;
+			y /= -17;
+			y += ofs;
+			// 波形は描画領域でクリップする（周りのウィジェットを壊さない為）
+			if(y < PLOT_Y) y = PLOT_Y;
+			else if(y > (PLOT_Y + PLOT_H)) y = PLOT_Y + PLOT_H;
+			return y;
+		}
+
+
 		void auto_scale_(float a, char unit, char* out, uint32_t len)
 		{
 			char sc = 0;
@@ -157,16 +416,84 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		render_wave(RENDER& render, CAPTURE& capture, TOUCH& touch) noexcept :
 			render_(render), capture_(capture), touch_(touch),
-			time_pos_(0), time_org_(0),
+			time_pos_(0), time_org_(0), time_zoom_(0), zoom_org_(0),
 			ch0_vpos_(0), ch0_vorg_(0), ch1_vpos_(0), ch1_vorg_(0),
 			rate_div_(11), ch0_div_(3), ch1_div_(3),
 			menu_(MENU::NONE), menu_run_(MENU::NONE),
-			measere_(MEASERE::NONE),
+			measere_(MEASERE::NONE), mes_ch_(0),
 			mes_time_begin_(0), mes_time_size_(40), mes_time_org_(0),
 			mes_volt_begin_(0), mes_volt_size_(40), mes_volt_org_(0),
 			mes_ref_size_(0), mes_ref_len_(0),
-			touch_down_(false), touch_num_(0)
-		{ }
+			touch_down_(false), touch_num_(0), retained_(), measure_(capture)
+		{
+			reset_span_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全体を描き直す様にする（他の描画で画面を壊した場合等）
+		*/
+		//-----------------------------------------------------------------//
+		void invalidate() noexcept
+		{
+			retained_.invalidate();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測し直す様にする（新しい波形をキャプチャーした場合等）
+		*/
+		//-----------------------------------------------------------------//
+		void restart_measure() noexcept
+		{
+			retained_.invalidate(static_cast<uint8_t>(WIDGET::MEASURE));
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測サービス（メインループから呼ぶ）
+			@param[in]	budget	一回の計算量（サンプル、又はバタフライの数）
+			@return 計測が終わり、描き直しが必要なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool service(uint32_t budget = MEASURE_BUDGET) noexcept
+		{
+			return measure_.service(budget);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測中か検査（計測中は、波形を書き換えない）
+			@return 計測中なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_measure() const noexcept { return measure_.busy(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  縮小の設定 @n
+					１ピクセルに複数のサンプルがある場合、最小から最大までを縦線で描く。
+			@param[in]	zoom	１ピクセル当たり「1 << zoom」サンプル
+		*/
+		//-----------------------------------------------------------------//
+		void set_zoom(uint8_t zoom) noexcept
+		{
+			time_zoom_ = zoom > ZOOM_MAX ? ZOOM_MAX : zoom;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  縮小の取得
+			@return １ピクセル当たり「1 << zoom」サンプル
+		*/
+		//-----------------------------------------------------------------//
+		uint8_t get_zoom() const noexcept { return time_zoom_; }
 
 
 		//-----------------------------------------------------------------//
@@ -208,10 +535,10 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  サンプリング情報描画
-			@param[in]	ch	チャネル
+			@param[in]	force	変化が無くても描画する場合「true」
 		*/
 		//-----------------------------------------------------------------//
-		void draw_sampling_info() noexcept
+		void draw_sampling_info(bool force = true) noexcept
 		{
 			static const char* freq[] = {
 				"100Hz", "250Hz", "500Hz",
@@ -228,23 +555,60 @@ namespace utils {
 				1e-3, 200e-6, 100e-6, 40e-6, 20e-6,
 				10e-6, 4e-6, 2e-6, 1e-6, 500e-9
 			};
+			static const float freq_f[] = {
+				100.0f, 250.0f, 500.0f,
+				1e3, 5e3, 10e3, 25e3, 50e3,
+				100e3, 250e3, 500e3, 1e6, 2e6
+			};
 
 			char tmp[64];
-			utils::sformat("%s (%s)", tmp, sizeof(tmp)) % freq[rate_div_] % rate[rate_div_];
-			render_.fill(0, 0, 480, 16, RENDER::COLOR::Black);
-			auto x = render_.draw_text(0, 0, tmp);
+			if(time_zoom_ > 0) {
+				utils::sformat("%s (%s) 1/%d", tmp, sizeof(tmp)) % freq[rate_div_] % rate[rate_div_]
+					% (1 << time_zoom_);
+			} else {
+				utils::sformat("%s (%s)", tmp, sizeof(tmp)) % freq[rate_div_] % rate[rate_div_];
+			}
+			auto sig = retained_.hash(tmp);
 
 			// 計測モード時結果
+			char mes[2][32];
+			mes[0][0] = 0;
+			mes[1][0] = 0;
 			if(measere_ == MEASERE::TIME) {
-				float a = static_cast<float>(mes_time_size_) * GRID_SCALE * rate_f[rate_div_];
-				auto_scale_(a, 'S', tmp, sizeof(tmp));
-				x = render_.draw_text(x + 8, 0, tmp);
-				freq_scale_(1.0f / a, tmp, sizeof(tmp));
-				render_.draw_text(x + 8, 0, tmp);
+				float a = static_cast<float>(mes_time_size_ << time_zoom_) * GRID_SCALE
+					* rate_f[rate_div_];
+				auto_scale_(a, 'S', mes[0], sizeof(mes[0]));
+				freq_scale_(1.0f / a, mes[1], sizeof(mes[1]));
+				sig = retained_.hash(mes[0], retained_.hash(mes[1], sig));
 			} else if(measere_ == MEASERE::VOLT) {
 //				float a = static_cast<float>(mes_time_size_) * GRID_SCALE * rate_f[rate_div_];
 //				utils::sformat("%4.3f", tmp, sizeof(tmp)) % a;
 //				render_.draw_text(x + 8, 0, tmp);
+			} else if(measere_ == MEASERE::AUTO && measure_.is_valid()) {
+				const auto& t = measure_.get_stat(mes_ch_);
+				utils::sformat("CH%d %4.3fVpp %4.3fVrms", mes[0], sizeof(mes[0])) % static_cast<uint32_t>(mes_ch_)
+					% volt_(mes_ch_, t.max - t.min) % volt_(mes_ch_, t.rms * (1.0f / 16.0f));
+				if(t.period > 0) {
+					freq_scale_(freq_f[rate_div_] * 256.0f / static_cast<float>(t.period),
+						mes[1], sizeof(mes[1]));
+				} else {
+					utils::sformat("--- [Hz]", mes[1], sizeof(mes[1]));
+				}
+				sig = retained_.hash(mes[0], retained_.hash(mes[1], sig));
+			} else if(measere_ == MEASERE::FFT && measure_.get_fft_size() > 0) {
+				auto n = measure_.get_fft_size();
+				utils::sformat("CH%d FFT %d", mes[0], sizeof(mes[0])) % static_cast<uint32_t>(measure_.get_fft_channel()) % n;
+				freq_scale_(freq_f[rate_div_] * static_cast<float>(measure_.get_fft_peak())
+					/ static_cast<float>(n), mes[1], sizeof(mes[1]));
+				sig = retained_.hash(mes[0], retained_.hash(mes[1], sig));
+			}
+			if(!update_widget_(WIDGET::SAMPLING, sig) && !force) return;
+
+			render_.fill_box(0, 0, 480, 16, RENDER::COLOR::Black);
+			auto x = render_.draw_text(0, 0, tmp);
+			if(mes[0][0] != 0) {
+				x = render_.draw_text(x + 8, 0, mes[0]);
+				render_.draw_text(x + 8, 0, mes[1]);
 			}
 		}
 
@@ -252,25 +616,31 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  チャネル情報描画
-			@param[in]	ch	チャネル
+			@param[in]	ch		チャネル
+			@param[in]	force	変化が無くても描画する場合「true」
 		*/
 		//-----------------------------------------------------------------//
-		void draw_channel_info(uint32_t ch) noexcept
+		void draw_channel_info(uint32_t ch, bool force = true) noexcept
 		{
 			static const char* divs[] = {
 				"0.05", "0.1", "0.25", "0.5", "1.0", "2.5", "5.0", "10.0" 
 			};
 
+			if(!update_widget_(ch == 0 ? WIDGET::CH0 : WIDGET::CH1, ch == 0 ? ch0_div_ : ch1_div_)
+				&& !force) {
+				return;
+			}
+
 			char tmp[32];
 			if(ch == 0) {
-				render_.fill(  0, 272 - 16 + 1, 15, 15, RENDER::COLOR::Lime);
-				render_.fill( 16, 272 - 16 + 1, 240 - 16, 15, RENDER::COLOR::Black);
+				render_.fill_box(  0, 272 - 16 + 1, 15, 15, RENDER::COLOR::Lime);
+				render_.fill_box( 16, 272 - 16 + 1, 240 - 16, 15, RENDER::COLOR::Black);
 				utils::sformat("CH0: %s [V]", tmp, sizeof(tmp)) % divs[ch0_div_];
 				render_.draw_text(  16, 272 - 16 + 1, tmp);
 			} else {
-				render_.fill(240, 272 - 16 + 1, 15, 15, RENDER::COLOR::Fuchsi);
+				render_.fill_box(240, 272 - 16 + 1, 15, 15, RENDER::COLOR::Fuchsi);
 				utils::sformat("CH1: %s [V]", tmp, sizeof(tmp)) % divs[ch1_div_];
-				render_.fill(240 + 16, 272 - 16 + 1, 240 - 16, 15, RENDER::COLOR::Black);
+				render_.fill_box(240 + 16, 272 - 16 + 1, 240 - 16, 15, RENDER::COLOR::Black);
 				render_.draw_text(240 + 16, 272 - 16 + 1, tmp);
 			}
 		}
@@ -295,10 +665,19 @@ namespace utils {
 					menu_run_ = menu_;
 					menu_ = MENU::NONE;
 					if(menu_run_ == MENU::TRG) {
-						// とりあえず、シングル・トリガー
-						capture_.set_trigger(utils::capture_trigger::SINGLE);
+						// 「trg」コマンドで設定したモード（NORMAL、AUTO）は、そのモードで取り込み直す
+						// 止まっている（NONE、又は SINGLE の取り込み済み）場合は、シングル・トリガー
+						auto mode = capture_.get_trigger();
+						if(mode == utils::capture_trigger::NONE) {
+							mode = utils::capture_trigger::SINGLE;
+						}
+						capture_.set_trigger(mode);
 					} else if(menu_run_ == MENU::MES) {
-						measere_ = enum_utils::inc(measere_, MEASERE::NONE, MEASERE::VOLT);
+						measere_ = enum_utils::inc(measere_, MEASERE::NONE, MEASERE::FFT);
+					} else if(menu_run_ == MENU::CH0) {
+						mes_ch_ = 0;
+					} else if(menu_run_ == MENU::CH1) {
+						mes_ch_ = 1;
 					}
 					return true;
 				} else {
@@ -309,6 +688,7 @@ namespace utils {
 			if(num == 1) {
 				if(p.event == TOUCH::EVENT::DOWN) {
 					time_org_ = time_pos_;
+					zoom_org_ = time_zoom_;
 					ch0_vorg_ = ch0_vpos_;
 					ch1_vorg_ = ch1_vpos_;
 					mes_time_org_ = mes_time_begin_;
@@ -334,7 +714,7 @@ namespace utils {
 						}
 					} else {
 						if(0 <= p.y && p.y < TIME_SCROLL_AREA) {
-							time_pos_ = time_org_ + dx;
+							time_pos_ = time_org_ + (dx << time_zoom_);
 							touch_down_ = true;
 						} else if(0 <= p.x && p.x < CH0_MOVE_AREA) {
 							ch0_vpos_ = ch0_vorg_ + dy;
@@ -372,8 +752,20 @@ namespace utils {
 						if(mes_volt_size_ < 0) mes_volt_size_ = 0;
 					}
 				} else {
-
-					return false;
+					// ピンチで縮小率を変える（指を開くと拡大）
+					auto dx = p.x - p2.x;
+					auto dy = p.y - p2.y;
+					auto len = intmath::sqrt16(dx * dx + dy * dy);
+					if(p2.event == TOUCH::EVENT::DOWN) {
+						zoom_org_ = time_zoom_;
+						mes_ref_len_  = len.val;
+						return false;
+					}
+					int16_t z = zoom_org_ - (static_cast<int16_t>(len.val) - mes_ref_len_) / ZOOM_STEP;
+					if(z < 0) z = 0;
+					else if(z > ZOOM_MAX) z = ZOOM_MAX;
+					if(z == time_zoom_) return false;
+					time_zoom_ = z;
 				}
 			} else if(num == 3) {
 
@@ -386,70 +778,74 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  アップ・デート（再描画）
+			@brief  アップ・デート（再描画） @n
+					変化の無いボタン、テキストは描き直さない。@n
+					波形の領域は、前回描いた波形の範囲だけ背景を戻す。
 		*/
 		//-----------------------------------------------------------------//
 		void update() noexcept
 		{
-			render_.fill(0, 16, 440, 240, RENDER::COLOR::Black);
-			draw_grid(0, 16, 440, 240, GRID);
-
-			if(measere_ != MEASERE::NONE) {
-				update_measere_();
-			} else if(touch_down_) {
-				render_.line(0, TIME_SCROLL_AREA, CH1_MOVE_AREA, TIME_SCROLL_AREA,
-					 RENDER::COLOR::Red);
-				render_.line(CH0_MOVE_AREA, TIME_SCROLL_AREA, CH0_MOVE_AREA, 272 - 16,
-					 RENDER::COLOR::Red);
-				render_.line(CH1_MOVE_AREA, TIME_SCROLL_AREA, CH1_MOVE_AREA, 272 - 16,
-					 RENDER::COLOR::Red);
+			// 計測ライン等が変化したら、波形の領域全体を描き直す
+			uint32_t sig = retained_.hash(static_cast<uint32_t>(measere_));
+			if(measere_ == MEASERE::TIME) {
+				sig = retained_.hash(mes_time_begin_, retained_.hash(mes_time_size_, sig));
+			} else if(measere_ == MEASERE::VOLT) {
+				sig = retained_.hash(mes_volt_begin_, retained_.hash(mes_volt_size_, sig));
+			} else {
+				sig = retained_.hash(touch_down_, sig);
+			}
+			if(update_widget_(WIDGET::OVERLAY, sig)) {
+				render_.fill_box(PLOT_X, PLOT_Y, PLOT_W, PLOT_H, RENDER::COLOR::Black);
+				draw_grid(PLOT_X, PLOT_Y, PLOT_W, PLOT_H, GRID);
+			} else {
+				for(int16_t x = 0; x < PLOT_W; ++x) {
+					int16_t y0 = span_min_[0][x];
+					int16_t y1 = span_max_[0][x];
+					int16_t y2 = span_min_[1][x];
+					int16_t y3 = span_max_[1][x];
+					if(y2 <= (y1 + 1) && y0 <= (y3 + 1)) {  // 重なる場合は一度に戻す
+						if(y0 > y2) y0 = y2;
+						if(y1 < y3) y1 = y3;
+						y2 = 0x7fff;
+						y3 = -1;
+					}
+					if(y0 <= y1) restore_column_(PLOT_X + x, y0, y1);
+					if(y2 <= y3) restore_column_(PLOT_X + x, y2, y3);
+				}
 			}
+			reset_span_();
+			draw_overlay_();
 
 			// メニュー・ボタンの描画
 			{
 				static const char* menu[] = {
 					"CH0", "CH1", "Trg", "Smp", "Mes", "Opt" };
 				for(int16_t i = 0; i < 6; ++i) {
+					bool sel = static_cast<MENU>(i + 1) == menu_;
+					if(!update_widget_(static_cast<WIDGET>(static_cast<uint8_t>(WIDGET::MENU) + i), sel)) {
+						continue;
+					}
 					uint16_t c = RENDER::COLOR::Olive;
-					if(static_cast<MENU>(i + 1) == menu_) c = RENDER::COLOR::Yellow;
+					if(sel) c = RENDER::COLOR::Yellow;
 					render_.set_back_color(c);
 					render_.draw_button(441, 16 + GRID * i + 1, GRID - 1, GRID - 1, menu[i]);
 				}
 			}
 
-			for(int16_t x = 0; x < (440 - 1); ++x) {
-				int16_t p0 = time_pos_ + x;
-				int16_t p1 = time_pos_ + x + 1;
-				if(p1 >= static_cast<int16_t>(CAPTURE::CAP_NUM)) {
-					break;
-				}
-				const auto& d0 = capture_.get(p0);
-				const auto& d1 = capture_.get(p1);
-				{
-					int16_t ofs = ch0_vpos_ + 272 / 2;
-					int16_t y0 = d0.ch0_;
-					y0 -= 2048;
-					y0 /= -17;
-					int16_t y1 = d1.ch0_;
-					y1 -= 2048;
-					y1 /= -17;
-					render_.line(x, ofs + y0, x + 1, ofs + y1, RENDER::COLOR::Lime);
-				}
-				{
-					int16_t ofs = ch1_vpos_ + 272 / 2;
-					int16_t y0 = d0.ch1_;
-					y0 -= 2048;
-					y0 /= -17;
-					int16_t y1 = d1.ch1_;
-					y1 -= 2048;
-					y1 /= -17;
-					render_.line(x, ofs + y0, x + 1, ofs + y1, RENDER::COLOR::Fuchsi);
-				}
+			if(measere_ == MEASERE::AUTO || measere_ == MEASERE::FFT) {
+				start_measure_();
+			}
+			if(measere_ == MEASERE::FFT) {
+				draw_fft_();
+			} else if(time_zoom_ > 0) {
+				draw_peak_();
+			} else {
+				draw_line_();
 			}
 
-			draw_sampling_info();
-			draw_channel_info(0);
-			draw_channel_info(1);
+			draw_sampling_info(false);
+			draw_channel_info(0, false);
+			draw_channel_info(1, false);
 		}
 	};
 }
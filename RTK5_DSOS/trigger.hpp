@@ -0,0 +1,443 @@
+#pragma once
+//=====================================================================//
+/*! @file
+    @brief  トリガー・クラス @n
+			サンプリング割り込みから、１サンプル毎に呼ぶ。@n
+			trigger_eval はトリガー条件の判定、trigger_engine はプリ・トリガー付きの @n
+			リング・バッファの書き込み位置と、取り込みの状態を管理する。@n
+			デバイスに依存しないので、ホストでも試験できる。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+    @copyright  Copyright (C) 2018 Kunihito Hiramatsu @n
+                Released under the MIT license @n
+                https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  キャプチャー・トリガー（取り込みモード）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	enum class capture_trigger : uint8_t {
+		NONE,		///< 何もしない
+		SINGLE,		///< シングル取り込み
+		NORMAL,		///< トリガー毎に取り込む（再開は rearm）
+		AUTO,		///< NORMAL と同じだが、トリガーが無い場合も一定時間で取り込む
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  トリガーの種類
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	enum class trigger_type : uint8_t {
+		NONE,		///< 直ぐにトリガー
+		RISE,		///< 立ち上がり（「level - hyst」以下から level 以上）
+		FALL,		///< 立ち下がり（「level + hyst」以上から level 以下）
+		HIGH,		///< level 以上
+		LOW,		///< level 以下
+		WINDOW,		///< 「level ～ level2」の範囲の内側から外側に出た
+		PULSE_P,	///< 幅が「width ～ width2」サンプルの正パルス（パルスの終わり）
+		PULSE_N,	///< 幅が「width ～ width2」サンプルの負パルス（パルスの終わり）
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  トリガー判定クラス @n
+				FALL、LOW、PULSE_N は、サンプルを反転して RISE、HIGH、PULSE_P と @n
+				同じ判定を行う（１サンプル当たり、比較が数回）。
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class trigger_eval {
+
+		enum class KIND : uint8_t {
+			NONE,
+			EDGE,
+			LEVEL,
+			WINDOW,
+			PULSE,
+		};
+
+		KIND		kind_;
+		uint16_t	xor_;	///< 反転する場合 0xffff
+		uint16_t	level_;
+		uint16_t	lo_;	///< 再トリガーの為の下側（EDGE、PULSE）、窓の下側（WINDOW）
+		uint16_t	hi_;	///< 窓の上側（WINDOW）
+		uint16_t	in_lo_;	///< 窓の内側に戻ったと見なす範囲
+		uint16_t	in_hi_;
+		uint32_t	wmin_;
+		uint32_t	wmax_;
+
+		bool		arm_;
+		bool		high_;
+		uint32_t	width_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクタ
+		*/
+		//-----------------------------------------------------------------//
+		trigger_eval() noexcept : kind_(KIND::NONE), xor_(0), level_(0), lo_(0), hi_(0),
+			in_lo_(0), in_hi_(0), wmin_(0), wmax_(0), arm_(false), high_(false), width_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  設定（判定の状態はリセットされる）
+			@param[in]	type	トリガーの種類
+			@param[in]	level	レベル（WINDOW の場合は下側）
+			@param[in]	hyst	ヒステリシス
+			@param[in]	level2	WINDOW の上側
+			@param[in]	width	PULSE の最小幅（サンプル）
+			@param[in]	width2	PULSE の最大幅（サンプル）
+		*/
+		//-----------------------------------------------------------------//
+		void set(trigger_type type, uint16_t level, uint16_t hyst = 16, uint16_t level2 = 0,
+			uint32_t width = 0, uint32_t width2 = 0xffffffff) noexcept
+		{
+			xor_ = 0;
+			switch(type) {
+			case trigger_type::FALL:
+			case trigger_type::LOW:
+			case trigger_type::PULSE_N:
+				xor_ = 0xffff;
+				level ^= xor_;
+				break;
+			default:
+				break;
+			}
+			switch(type) {
+			case trigger_type::RISE:
+			case trigger_type::FALL:
+				kind_ = KIND::EDGE;
+				break;
+			case trigger_type::HIGH:
+			case trigger_type::LOW:
+				kind_ = KIND::LEVEL;
+				break;
+			case trigger_type::WINDOW:
+				kind_ = KIND::WINDOW;
+				break;
+			case trigger_type::PULSE_P:
+			case trigger_type::PULSE_N:
+				kind_ = KIND::PULSE;
+				break;
+			default:
+				kind_ = KIND::NONE;
+				break;
+			}
+			level_ = level;
+			if(kind_ == KIND::WINDOW) {
+				lo_ = level < level2 ? level : level2;
+				hi_ = level < level2 ? level2 : level;
+				in_lo_ = (0xffff - lo_) > hyst ? lo_ + hyst : 0xffff;
+				in_hi_ = hi_ > hyst ? hi_ - hyst : 0;
+			} else {
+				lo_ = level > hyst ? level - hyst : 0;
+			}
+			wmin_ = width;
+			wmax_ = width2;
+			reset();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  判定の状態をリセット（エッジは、反対側を通過してから有効になる）
+		*/
+		//-----------------------------------------------------------------//
+		void reset() noexcept
+		{
+			arm_ = false;
+			high_ = false;
+			width_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルを判定
+			@param[in]	v	サンプル
+			@return トリガーした場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool operator() (uint16_t v) noexcept
+		{
+			v ^= xor_;
+			switch(kind_) {
+			case KIND::EDGE:
+				if(v <= lo_) {
+					arm_ = true;
+				} else if(arm_ && v >= level_) {
+					arm_ = false;
+					return true;
+				}
+				return false;
+
+			case KIND::LEVEL:
+				return v >= level_;
+
+			case KIND::WINDOW:
+				if(v < lo_ || v > hi_) {
+					if(arm_) {
+						arm_ = false;
+						return true;
+					}
+				} else if(in_lo_ <= v && v <= in_hi_) {
+					arm_ = true;
+				}
+				return false;
+
+			case KIND::PULSE:
+				if(high_) {
+					if(v <= lo_) {
+						high_ = false;
+						return wmin_ <= width_ && width_ <= wmax_;
+					}
+					if(width_ < 0xffffffff) ++width_;
+				} else if(v <= lo_) {
+					arm_ = true;
+				} else if(arm_ && v >= level_) {
+					high_ = true;
+					width_ = 1;
+				}
+				return false;
+
+			default:
+				return true;
+			}
+		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  トリガー・エンジン・クラス @n
+				リング・バッファにプリ・トリガー分を貯めてからトリガーを待ち、@n
+				トリガー後「CAPN - プリ・トリガー」サンプルで取り込みを終える。@n
+				割り込みでは is_store() の間、get_pos() の位置にサンプルを書き、@n
+				update() を呼ぶ。
+		@param[in]	CAPN	バッファの大きさ（２のべき乗）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t CAPN>
+	class trigger_engine {
+
+		static_assert(CAPN >= 2 && (CAPN & (CAPN - 1)) == 0, "CAPN must be a power of 2");
+
+	public:
+		//=================================================================//
+		/*!
+			@brief  取り込みの状態
+		*/
+		//=================================================================//
+		enum class STATE : uint8_t {
+			STOP,		///< 停止
+			PRE,		///< プリ・トリガー分を貯めている
+			ARM,		///< トリガー待ち
+			POST,		///< トリガー後を取り込み中
+			DONE,		///< 取り込み終了
+		};
+
+	private:
+		trigger_eval		eval_;
+		capture_trigger		mode_;
+		volatile STATE		state_;
+		volatile uint32_t	pos_;
+		uint32_t			count_;
+		uint32_t			pre_;
+		uint32_t			auto_;
+		uint32_t			start_;
+		uint8_t				ch_;
+		bool				forced_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクタ
+		*/
+		//-----------------------------------------------------------------//
+		trigger_engine() noexcept : eval_(), mode_(capture_trigger::NONE), state_(STATE::STOP),
+			pos_(0), count_(0), pre_(0), auto_(CAPN), start_(0), ch_(0), forced_(false) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  判定クラスの参照（停止中に設定する）
+			@return 判定クラス
+		*/
+		//-----------------------------------------------------------------//
+		trigger_eval& at_eval() noexcept { return eval_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  プリ・トリガーのサンプル数を設定（停止中に設定する）
+			@param[in]	pre	サンプル数（０ ～ CAPN - 1）
+		*/
+		//-----------------------------------------------------------------//
+		void set_pre(uint32_t pre) noexcept { pre_ = pre < CAPN ? pre : CAPN - 1; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  プリ・トリガーのサンプル数を取得（取り込み後のトリガー位置）
+			@return サンプル数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_pre() const noexcept { return pre_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  AUTO モードで、トリガーを待つサンプル数を設定
+			@param[in]	n	サンプル数
+		*/
+		//-----------------------------------------------------------------//
+		void set_auto(uint32_t n) noexcept { auto_ = n > 0 ? n : 1; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  トリガーを判定するチャネルを設定
+			@param[in]	ch	チャネル
+		*/
+		//-----------------------------------------------------------------//
+		void set_channel(uint8_t ch) noexcept { ch_ = ch; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  トリガーを判定するチャネルを取得
+			@return チャネル
+		*/
+		//-----------------------------------------------------------------//
+		uint8_t get_channel() const noexcept { return ch_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  取り込み開始（NONE の場合は停止）
+			@param[in]	mode	モード
+		*/
+		//-----------------------------------------------------------------//
+		void start(capture_trigger mode) noexcept
+		{
+			state_ = STATE::STOP;
+			mode_ = mode;
+			if(mode == capture_trigger::NONE) return;
+			eval_.reset();
+			pos_ = 0;
+			count_ = 0;
+			forced_ = false;
+			state_ = pre_ > 0 ? STATE::PRE : STATE::ARM;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  取り込みモードを取得
+			@return モード
+		*/
+		//-----------------------------------------------------------------//
+		capture_trigger get_mode() const noexcept { return mode_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  状態を取得
+			@return 状態
+		*/
+		//-----------------------------------------------------------------//
+		STATE get_state() const noexcept { return state_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルを書き込む状態か検査
+			@return 書き込む場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_store() const noexcept
+		{
+			return state_ == STATE::PRE || state_ == STATE::ARM || state_ == STATE::POST;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  次にサンプルを書き込む位置を取得
+			@return 位置
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_pos() const noexcept { return pos_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  取り込み後の、先頭サンプルの位置を取得
+			@return 位置
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_start() const noexcept { return start_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  AUTO モードで、トリガーが無いまま取り込んだか検査
+			@return トリガーが無かった場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_forced() const noexcept { return forced_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アップデート（get_pos() の位置にサンプルを書いた後に呼ぶ）
+			@param[in]	v	トリガーを判定するチャネルのサンプル
+		*/
+		//-----------------------------------------------------------------//
+		void update(uint16_t v) noexcept
+		{
+			pos_ = (pos_ + 1) & (CAPN - 1);
+			switch(state_) {
+			case STATE::PRE:
+				eval_(v);  // エッジの判定状態を作る
+				++count_;
+				if(count_ >= pre_) {
+					count_ = 0;
+					state_ = STATE::ARM;
+				}
+				break;
+			case STATE::ARM:
+				if(!eval_(v)) {
+					if(mode_ != capture_trigger::AUTO || ++count_ < auto_) break;
+					forced_ = true;
+				}
+				count_ = 1;  // トリガーしたサンプル
+				if(count_ >= (CAPN - pre_)) {
+					start_ = pos_;
+					state_ = STATE::DONE;
+				} else {
+					state_ = STATE::POST;
+				}
+				break;
+			case STATE::POST:
+				++count_;
+				if(count_ >= (CAPN - pre_)) {
+					start_ = pos_;
+					state_ = STATE::DONE;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	};
+}
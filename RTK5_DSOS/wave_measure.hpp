@@ -0,0 +1,534 @@
+#pragma once
+//=====================================================================//
+/*! @file
+    @brief  波形計測クラス @n
+			キャプチャー・データの最小、最大、平均、実効値と、ヒステリシス付きの @n
+			ゼロクロスによる周期を求める。@n
+			FFT（固定小数点、256 ～ 4096 点、窓関数付き）で振幅スペクトルを求める。@n
+			service() を呼ぶ毎に、指定した量だけ計算を進める（ヒープは使わない）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+    @copyright  Copyright (C) 2018 Kunihito Hiramatsu @n
+                Released under the MIT license @n
+                https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include "common/intmath.hpp"
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  波形計測クラス
+		@param[in]	CAPTURE	キャプチャー・クラス（get(pos) でサンプルを返す）
+		@param[in]	FFTN	FFT の最大点数（２５６ ～ ４０９６、２のべき乗）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class CAPTURE, uint32_t FFTN = 4096>
+	class wave_measure {
+
+		static_assert(FFTN >= 256 && FFTN <= 4096 && (FFTN & (FFTN - 1)) == 0,
+			"FFTN must be a power of 2 (256 to 4096)");
+
+	public:
+		static const uint32_t FFT_MIN = 256;	///< FFT の最小点数
+		static const uint32_t FFT_MAX = FFTN;	///< FFT の最大点数
+
+		//=================================================================//
+		/*!
+			@brief  窓関数
+		*/
+		//=================================================================//
+		enum class WINDOW : uint8_t {
+			RECT,		///< 矩形（窓無し）
+			HANN,		///< ハン
+			HAMMING,	///< ハミング
+		};
+
+
+		//=================================================================//
+		/*!
+			@brief  計測結果（値は A/D 変換のカウント）
+		*/
+		//=================================================================//
+		struct stat_t {
+			uint16_t	min;		///< 最小値
+			uint16_t	max;		///< 最大値
+			uint16_t	mean;		///< 平均値
+			uint16_t	rms;		///< 交流分の実効値（1/16 カウント）
+			uint32_t	period;		///< 周期（1/256 サンプル、求められない場合０）
+			uint16_t	cycles;		///< 周期を求めた波の数
+		};
+
+	private:
+		enum class TASK : uint8_t {
+			IDLE,
+			STAT,		///< 最小、最大、合計
+			CROSS,		///< ゼロクロス
+			LOAD,		///< 窓関数を掛けて、ビット反転の順に並べる
+			RADIX4,		///< 最初の２段（乗算の要らない４点バタフライ）
+			RADIX2,		///< 残りの段
+			MAG,		///< 振幅
+		};
+
+		struct acc_t {
+			uint32_t	sum;
+			uint64_t	sum2;
+			uint16_t	min;
+			uint16_t	max;
+			uint16_t	level;	///< ゼロクロスの基準
+			uint16_t	lo;		///< ヒステリシスの下側
+			uint16_t	hi;		///< ヒステリシスの上側
+			uint16_t	prev;
+			bool		arm;	///< 下側を通過した
+			uint32_t	cand;	///< 基準を横切った位置（1/256 サンプル）
+			uint32_t	first;
+			uint32_t	last;
+			uint32_t	rise;
+		};
+
+		static const uint32_t QUARTER = FFTN / 4;
+
+		CAPTURE&	capture_;
+
+		TASK		task_;
+		uint32_t	pos_;
+		uint32_t	len_;
+		uint32_t	idx_;
+
+		acc_t		acc_[2];
+		stat_t		stat_[2];
+		bool		stat_valid_;
+
+		uint8_t		fft_ch_;
+		WINDOW		window_;
+		uint32_t	fft_n_;		///< 計算中の点数
+		uint32_t	fft_size_;	///< 結果の点数（結果が無い場合０）
+		uint32_t	rev_;
+		uint32_t	half_;
+		uint32_t	fft_peak_;
+
+		int16_t		sin_[QUARTER + 1];	///< 1/4 周期の sin（Q15）
+		int16_t		re_[FFTN];
+		int16_t		im_[FFTN];
+		uint16_t	mag_[FFTN / 2];
+
+		// 角度は「2π * k / FFTN」
+		int16_t sin_k_(uint32_t k) const noexcept
+		{
+			k &= FFTN - 1;
+			if(k <= QUARTER) return sin_[k];
+			else if(k <= QUARTER * 2) return sin_[QUARTER * 2 - k];
+			else if(k <= QUARTER * 3) return -sin_[k - QUARTER * 2];
+			else return -sin_[QUARTER * 4 - k];
+		}
+
+
+		int16_t cos_k_(uint32_t k) const noexcept { return sin_k_(k + QUARTER); }
+
+
+		template <class DATA>
+		static uint16_t sample_(const DATA& d, uint8_t ch) noexcept
+		{
+			return ch == 0 ? d.ch0_ : d.ch1_;
+		}
+
+
+		static void add_stat_(acc_t& a, uint16_t v) noexcept
+		{
+			a.sum += v;
+			a.sum2 += static_cast<uint32_t>(v) * v;
+			if(a.min > v) a.min = v;
+			if(a.max < v) a.max = v;
+		}
+
+
+		static void add_cross_(acc_t& a, uint32_t i, uint16_t v) noexcept
+		{
+			if(v <= a.lo) {
+				a.arm = true;
+			} else if(a.arm) {
+				if(a.prev < a.level && v >= a.level) {  // 基準を横切った位置を補間する
+					a.cand = ((i - 1) << 8)
+						+ (static_cast<uint32_t>(a.level - a.prev) << 8) / (v - a.prev);
+				}
+				if(v >= a.hi) {
+					if(a.rise == 0) a.first = a.cand;
+					a.last = a.cand;
+					++a.rise;
+					a.arm = false;
+				}
+			}
+			a.prev = v;
+		}
+
+
+		void make_stat_(uint8_t ch) noexcept
+		{
+			const acc_t& a = acc_[ch];
+			stat_t& t = stat_[ch];
+			t.min = a.min;
+			t.max = a.max;
+			t.mean = a.sum / len_;
+			uint64_t m = (static_cast<uint64_t>(a.sum) << 8) / len_;  // 1/256
+			uint64_t e = (a.sum2 << 16) / len_;  // 1/65536
+			uint64_t var = e > (m * m) ? (e - m * m) >> 8 : 0;  // 1/256
+			if(var > 0xffffffff) var = 0xffffffff;
+			t.rms = intmath::sqrt32(static_cast<uint32_t>(var)).val;
+			if(a.rise >= 2) {
+				t.period = (a.last - a.first) / (a.rise - 1);
+				t.cycles = a.rise - 1;
+			} else {
+				t.period = 0;
+				t.cycles = 0;
+			}
+		}
+
+
+		uint32_t stat_task_(uint32_t budget) noexcept
+		{
+			while(budget > 0 && idx_ < len_) {
+				const auto& d = capture_.get(pos_ + idx_);
+				add_stat_(acc_[0], d.ch0_);
+				add_stat_(acc_[1], d.ch1_);
+				++idx_;
+				--budget;
+			}
+			if(idx_ >= len_) {
+				for(uint32_t ch = 0; ch < 2; ++ch) {
+					acc_t& a = acc_[ch];
+					a.level = (static_cast<uint32_t>(a.min) + a.max) / 2;
+					uint16_t h = (a.max - a.min) / 8;
+					if(h < 2) h = 2;
+					a.lo = a.level > h ? a.level - h : 0;
+					a.hi = a.level + h;
+					a.arm = false;
+					a.rise = 0;
+				}
+				idx_ = 0;
+				task_ = TASK::CROSS;
+			}
+			return budget;
+		}
+
+
+		uint32_t cross_task_(uint32_t budget) noexcept
+		{
+			while(budget > 0 && idx_ < len_) {
+				const auto& d = capture_.get(pos_ + idx_);
+				if(idx_ == 0) {
+					acc_[0].prev = d.ch0_;
+					acc_[1].prev = d.ch1_;
+				}
+				add_cross_(acc_[0], idx_, d.ch0_);
+				add_cross_(acc_[1], idx_, d.ch1_);
+				++idx_;
+				--budget;
+			}
+			if(idx_ >= len_) {
+				make_stat_(0);
+				make_stat_(1);
+				stat_valid_ = true;
+				idx_ = 0;
+				rev_ = 0;
+				task_ = fft_n_ > 0 ? TASK::LOAD : TASK::IDLE;
+			}
+			return budget;
+		}
+
+
+		uint32_t load_task_(uint32_t budget) noexcept
+		{
+			uint32_t step = FFTN / fft_n_;
+			int32_t mean = stat_[fft_ch_].mean;
+			while(budget > 0 && idx_ < fft_n_) {
+				int32_t v = static_cast<int32_t>(sample_(capture_.get(pos_ + idx_), fft_ch_)) - mean;
+				int32_t c = cos_k_(idx_ * step);
+				switch(window_) {
+				case WINDOW::HANN:
+					v = (v * ((32768 - c) >> 1)) >> 12;
+					break;
+				case WINDOW::HAMMING:
+					v = (v * (17695 - ((15073 * c) >> 15))) >> 12;
+					break;
+				default:
+					v <<= 3;
+					break;
+				}
+				if(v > 32767) v = 32767;
+				else if(v < -32767) v = -32767;
+				re_[rev_] = v;
+				im_[rev_] = 0;
+				// ビット反転したインデックスを進める
+				uint32_t bit = fft_n_ >> 1;
+				while(rev_ & bit) {
+					rev_ ^= bit;
+					bit >>= 1;
+				}
+				rev_ |= bit;
+				++idx_;
+				--budget;
+			}
+			if(idx_ >= fft_n_) {
+				idx_ = 0;
+				task_ = TASK::RADIX4;
+			}
+			return budget;
+		}
+
+
+		// 各段で 1/2 にするので、オーバーフローしない（結果は 1/N）
+		uint32_t radix4_task_(uint32_t budget) noexcept
+		{
+			while(budget > 0 && idx_ < fft_n_) {
+				uint32_t i = idx_;
+				int32_t s0r = re_[i] + re_[i + 1];
+				int32_t s0i = im_[i] + im_[i + 1];
+				int32_t s1r = re_[i] - re_[i + 1];
+				int32_t s1i = im_[i] - im_[i + 1];
+				int32_t s2r = re_[i + 2] + re_[i + 3];
+				int32_t s2i = im_[i + 2] + im_[i + 3];
+				int32_t s3r = re_[i + 2] - re_[i + 3];
+				int32_t s3i = im_[i + 2] - im_[i + 3];
+				re_[i    ] = (s0r + s2r) >> 2;
+				im_[i    ] = (s0i + s2i) >> 2;
+				re_[i + 2] = (s0r - s2r) >> 2;
+				im_[i + 2] = (s0i - s2i) >> 2;
+				re_[i + 1] = (s1r + s3i) >> 2;  // s1 - j * s3
+				im_[i + 1] = (s1i - s3r) >> 2;
+				re_[i + 3] = (s1r - s3i) >> 2;  // s1 + j * s3
+				im_[i + 3] = (s1i + s3r) >> 2;
+				idx_ += 4;
+				budget = budget > 4 ? budget - 4 : 0;
+			}
+			if(idx_ >= fft_n_) {
+				idx_ = 0;
+				half_ = 4;
+				task_ = TASK::RADIX2;
+			}
+			return budget;
+		}
+
+
+		uint32_t radix2_task_(uint32_t budget) noexcept
+		{
+			uint32_t step = FFTN / (half_ * 2);
+			while(budget > 0) {
+				if(idx_ >= (fft_n_ / 2)) {
+					half_ <<= 1;
+					idx_ = 0;
+					if(half_ >= fft_n_) {
+						task_ = TASK::MAG;
+						fft_size_ = 0;
+						fft_peak_ = 0;
+						break;
+					}
+					step >>= 1;
+				}
+				uint32_t j = idx_ & (half_ - 1);
+				uint32_t i = ((idx_ & ~(half_ - 1)) << 1) | j;
+				uint32_t k = i + half_;
+				int32_t c = cos_k_(j * step);
+				int32_t s = sin_k_(j * step);
+				// t = x[k] * exp(-j θ)
+				int32_t tr = (c * re_[k] + s * im_[k]) >> 15;
+				int32_t ti = (c * im_[k] - s * re_[k]) >> 15;
+				int32_t xr = re_[i];
+				int32_t xi = im_[i];
+				re_[i] = (xr + tr) >> 1;
+				im_[i] = (xi + ti) >> 1;
+				re_[k] = (xr - tr) >> 1;
+				im_[k] = (xi - ti) >> 1;
+				++idx_;
+				--budget;
+			}
+			return budget;
+		}
+
+
+		uint32_t mag_task_(uint32_t budget) noexcept
+		{
+			uint32_t n = fft_n_ / 2;
+			while(budget > 0 && idx_ < n) {
+				int32_t r = re_[idx_];
+				int32_t i = im_[idx_];
+				mag_[idx_] = intmath::sqrt32(static_cast<uint32_t>(r * r + i * i)).val;
+				if(idx_ > 0 && mag_[idx_] > mag_[fft_peak_]) fft_peak_ = idx_;
+				++idx_;
+				--budget;
+			}
+			if(idx_ >= n) {
+				if(fft_peak_ == 0 && n > 1) fft_peak_ = 1;
+				fft_size_ = fft_n_;
+				task_ = TASK::IDLE;
+			}
+			return budget;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクタ
+			@param[in]	capture	キャプチャー・クラス
+		*/
+		//-----------------------------------------------------------------//
+		wave_measure(CAPTURE& capture) noexcept : capture_(capture),
+			task_(TASK::IDLE), pos_(0), len_(0), idx_(0), acc_(), stat_(), stat_valid_(false),
+			fft_ch_(0), window_(WINDOW::HANN), fft_n_(0), fft_size_(0), rev_(0), half_(0),
+			fft_peak_(0)
+		{
+			intmath::build_sin<int16_t>(sin_, FFTN, 32767, 0, QUARTER + 1);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプル数から、使える FFT の点数を求める
+			@param[in]	len		サンプル数
+			@return FFT の点数（サンプルが足りない場合０）
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t fft_size(uint32_t len) noexcept
+		{
+			if(len < FFT_MIN) return 0;
+			uint32_t n = FFT_MAX;
+			while(n > len) n >>= 1;
+			return n;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測開始（前回の結果は、新しい結果が出るまで残る）
+			@param[in]	pos		開始位置
+			@param[in]	len		サンプル数
+			@param[in]	ch		FFT のチャネル
+			@param[in]	fft_n	FFT の点数（０なら FFT しない、開始位置から「fft_size(len)」まで）
+			@param[in]	window	窓関数
+		*/
+		//-----------------------------------------------------------------//
+		void start(uint32_t pos, uint32_t len, uint8_t ch = 0, uint32_t fft_n = 0,
+			WINDOW window = WINDOW::HANN) noexcept
+		{
+			pos_ = pos;
+			len_ = len;
+			idx_ = 0;
+			for(uint32_t i = 0; i < 2; ++i) {
+				acc_t& a = acc_[i];
+				a.sum = 0;
+				a.sum2 = 0;
+				a.min = 0xffff;
+				a.max = 0;
+			}
+			fft_ch_ = ch & 1;
+			window_ = window;
+			fft_n_ = fft_n > 0 ? fft_size(fft_n < len ? fft_n : len) : 0;
+			if(fft_n_ == 0) fft_size_ = 0;
+			task_ = len_ > 0 ? TASK::STAT : TASK::IDLE;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サービス（計算を進める）
+			@param[in]	budget	計算量（サンプル、又はバタフライの数）
+			@return この呼び出しで計測が終了した場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool service(uint32_t budget = 1024) noexcept
+		{
+			if(task_ == TASK::IDLE) return false;
+
+			while(budget > 0 && task_ != TASK::IDLE) {
+				switch(task_) {
+				case TASK::STAT:
+					budget = stat_task_(budget);
+					break;
+				case TASK::CROSS:
+					budget = cross_task_(budget);
+					break;
+				case TASK::LOAD:
+					budget = load_task_(budget);
+					break;
+				case TASK::RADIX4:
+					budget = radix4_task_(budget);
+					break;
+				case TASK::RADIX2:
+					budget = radix2_task_(budget);
+					break;
+				case TASK::MAG:
+					budget = mag_task_(budget);
+					break;
+				default:
+					break;
+				}
+			}
+			return task_ == TASK::IDLE;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測中か検査
+			@return 計測中なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool busy() const noexcept { return task_ != TASK::IDLE; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測結果が有効か検査
+			@return 有効なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_valid() const noexcept { return stat_valid_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  計測結果を取得
+			@param[in]	ch	チャネル
+			@return 計測結果
+		*/
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat(uint8_t ch) const noexcept { return stat_[ch & 1]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  FFT の点数を取得
+			@return FFT の点数（結果が無い場合０）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_fft_size() const noexcept { return fft_size_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  FFT の振幅を取得（「get_fft_size() / 2」個） @n
+					矩形窓の場合、振幅 A カウントの正弦波のビンは「4 * A」になる。
+			@return 振幅の配列
+		*/
+		//-----------------------------------------------------------------//
+		const uint16_t* get_fft() const noexcept { return mag_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  FFT の最大振幅のビン（直流を除く）を取得
+			@return ビン
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_fft_peak() const noexcept { return fft_peak_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  FFT のチャネルを取得
+			@return チャネル
+		*/
+		//-----------------------------------------------------------------//
+		uint8_t get_fft_channel() const noexcept { return fft_ch_; }
+	};
+}
@@ -22,6 +22,7 @@ namespace app {
 
 		uint32_t	lap_best_t_;
 		uint32_t	lap_best_n_;
+		uint32_t	lap_pos_;	///< ラップ表示を描いた時のラップ位置
 
 	public:
 		//-------------------------------------------------------------//
@@ -29,7 +30,7 @@ namespace app {
 			@brief	コンストラクター
 		*/
 		//-------------------------------------------------------------//
-		laptime() : lap_best_t_(0), lap_best_n_(0) { }
+		laptime() : lap_best_t_(0), lap_best_n_(0), lap_pos_(0) { }
 
 
 		//-------------------------------------------------------------//
@@ -42,11 +43,13 @@ namespace app {
 			at_scenes_base().at_cmt().at_task().enable();
 			lap_best_t_ = 0;
 			lap_best_n_ = 0;
+			lap_pos_ = 0xffffffff;
 
 			typedef scenes_base::RENDER RENDER;
 
 			auto& render = at_scenes_base().at_render();
 			render.clear(RENDER::COLOR::Black);
+			render.frame(0, RENDER::height - 10, RENDER::width, 10, RENDER::COLOR::White);
 		}
 
 
@@ -75,8 +78,7 @@ namespace app {
 //			res.draw_lap_24(x + 16, y, lap_best_n_, lap_best_t_);
 
 
-			// プログレスバー表示
-			render.frame(0, RENDER::height - 10, RENDER::width, 10, RENDER::COLOR::White);
+			// プログレスバー表示（枠は初期化で描く）
 			uint32_t bt = 0;
 			if(pos > 0) {
 				bt = watch.get_lap(pos - 1);
@@ -101,6 +103,9 @@ namespace app {
 				render.fill_box(1, RENDER::height - 10 + 1, per, 10 - 2, fc);
 			}
 
+			// ラップ一覧は、ラップが増えた時だけ描き直す
+			if(lap_pos_ == pos) return;
+			lap_pos_ = pos;
 			for(uint32_t i = 0; i < 4; ++i) {
 				if(i >= pos) {
 					break;
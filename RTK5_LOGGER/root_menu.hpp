@@ -42,6 +42,7 @@ namespace app {
 			at_scenes_base().at_menu().add("Lap Time");
 			at_scenes_base().at_menu().add("Recall");
 			at_scenes_base().at_menu().add("Setup");
+			at_scenes_base().at_render().clear(0);
 		}
 
 
@@ -52,8 +53,6 @@ namespace app {
 		//-------------------------------------------------------------//
 		void service()
 		{
-			at_scenes_base().at_render().clear(0);
-
 			const auto& touch = at_scenes_base().at_touch();
 			bool t = touch.get_touch_num() == 1 ? true : false;
 			int16_t x = touch.get_touch_pos(0).x;
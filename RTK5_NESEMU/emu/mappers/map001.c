@@ -108,14 +108,23 @@ static void map1_write(uint32 address, uint8 value)
 
    case 1:
       if (regs[0] & 0x10)
+      {
          mmc_bankvrom(4, 0x0000, value);
+         mmc_hintvrom(4, value + 1);
+      }
       else
+      {
          mmc_bankvrom(8, 0x0000, value >> 1);
+         mmc_hintvrom(8, (value >> 1) + 1);
+      }
       break;
 
    case 2:
       if (regs[0] & 0x10)
+      {
          mmc_bankvrom(4, 0x1000, value);
+         mmc_hintvrom(4, value + 1);
+      }
       break;
 
    case 3:
@@ -142,6 +151,9 @@ static void map1_write(uint32 address, uint8 value)
       else
          mmc_bankrom(16, 0xC000, ((regs[3] & 0xF) + bank_select));
 
+      /* banked data usually steps to the next bank */
+      mmc_hintrom(16, ((regs[3] & 0xF) + bank_select) + 1);
+
    default:
       break;
    }
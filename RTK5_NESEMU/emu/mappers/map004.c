@@ -57,6 +57,14 @@ static void map4_write(uint32 address, uint8 value)
       break;
 
    case 0x8001:
+      /* animated tiles / banked data usually step to the next bank */
+      if ((command & 0x07) < 2)
+         mmc_hintvrom(2, (value >> 1) + 1);
+      else if ((command & 0x07) < 6)
+         mmc_hintvrom(1, value + 1);
+      else
+         mmc_hintrom(8, value + 1);
+
       switch (command & 0x07)
       {
       case 0:
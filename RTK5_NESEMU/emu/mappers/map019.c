@@ -25,6 +25,7 @@
 
 #include "nes_mmc.h"
 #include "nes_ppu.h"
+#include "nes_bank.h"
 
 /* TODO: shouldn't there be an h-blank IRQ handler??? */
 
@@ -32,7 +33,7 @@
 #define N_BANK1(table, value) \
 { \
    if ((value) < 0xE0) \
-      ppu_setpage(1, (table) + 8, &mmc_getinfo()->vrom[((value) % (mmc_getinfo()->vrom_banks * 8)) << 10] - (0x2000 + ((table) << 10))); \
+      ppu_setpage(1, (table) + 8, bank_getchr((table) + 8, (value) % (mmc_getinfo()->vrom_banks * 8)) - (0x2000 + ((table) << 10))); \
    else \
       ppu_setpage(1, (table) + 8, &mmc_getinfo()->vram[((value) & 7) << 10] - (0x2000 + ((table) << 10))); \
    ppu_mirrorhipages(); \
@@ -42,8 +42,6 @@
 
 #define  NES_RAMSIZE          0x800
 
-#define  NES_SKIP_LIMIT       (NES_REFRESH_RATE / 5)   /* 12 or 10, depending on PAL/NTSC */
-
 static nes_t nes_;
 
 nes_t *nes_getcontext(void)
@@ -51,6 +49,21 @@ nes_t *nes_getcontext(void)
    return &nes_;
 }
 
+#ifdef NES_PROFILE
+static nesprof_t nes_prof_;
+
+nesprof_t *nes_getprofile(void)
+{
+	return &nes_prof_;
+}
+
+#define PROF_START()	uint32 prof_t_ = nes_profile_clock()
+#define PROF_LAP(sub)	{ uint32 t = nes_profile_clock(); nes_prof_.sub += (uint32)(t - prof_t_); prof_t_ = t; }
+#else
+#define PROF_START()
+#define PROF_LAP(sub)
+#endif
+
 /* find out if a file is ours */
 int nes_isourfile(const char *filename)
 {
@@ -266,17 +279,21 @@ static void nes_renderframe(bool draw_flag)
 	int elapsed_cycles;
 	const mapintf_t *mapintf = nes_.mmc->intf;
 	int in_vblank = 0;
+	PROF_START();
 
 	while(262 != nes_.scanline) {
 		ppu_scanline(nes_.vidbuf, nes_.scanline, draw_flag);
+		PROF_LAP(ppu);
 
 		if(241 == nes_.scanline) {
 			/* 7-9 cycle delay between when VINT flag goes up and NMI is taken */
 			elapsed_cycles = nes6502_execute(7);
 			nes_.scanline_cycles -= elapsed_cycles;
 			nes_checkfiq(elapsed_cycles);
+			PROF_LAP(cpu);
 
 			ppu_checknmi();
+			PROF_LAP(ppu);
 
 			if(mapintf->vblank) {
 				mapintf->vblank();
@@ -287,16 +304,23 @@ static void nes_renderframe(bool draw_flag)
 		if(mapintf->hblank) {
 			mapintf->hblank(in_vblank);
 		}
+		PROF_LAP(mmc);
 
 		nes_.scanline_cycles += (float) NES_SCANLINE_CYCLES;
 		elapsed_cycles = nes6502_execute((int) nes_.scanline_cycles);
 		nes_.scanline_cycles -= (float) elapsed_cycles;
 		nes_checkfiq(elapsed_cycles);
+		PROF_LAP(cpu);
 
 		ppu_endscanline(nes_.scanline);
+		PROF_LAP(ppu);
 		nes_.scanline++;
 	}
 	nes_.scanline = 0;
+#ifdef NES_PROFILE
+	++nes_prof_.frames;
+	if(draw_flag) ++nes_prof_.drawn;
+#endif
 }
 
 
@@ -319,6 +343,17 @@ void nes_emulate(int frames)
 	}
 }
 
+
+void nes_emulate_frame(int draw)
+{
+	if(nes_.pause) return;
+
+	nes_.scanline_cycles = 0;
+	nes_.fiq_cycles = (int) NES_FIQ_PERIOD;
+
+	nes_renderframe(draw ? true : false);
+}
+
 static void mem_trash(uint8 *buffer, int length)
 {
    int i;
@@ -369,6 +404,9 @@ void nes_pause(int enable)
 /* insert a cart into the NES */
 int nes_insert_cart(const char *filename)
 {
+	/* 前のカートリッジの VS パレットを戻す */
+	ppu_setdefaultpal();
+
 	/* rom file */
 	nes_.rominfo = rom_load(filename);
 	if(NULL == nes_.rominfo) {
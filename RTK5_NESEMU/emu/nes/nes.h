@@ -45,6 +45,9 @@
 #define  NES_REFRESH_RATE     60
 #endif /* !PAL */
 
+/* 連続して描画を省く最大フレーム数 */
+#define  NES_SKIP_LIMIT       (NES_REFRESH_RATE / 5)   /* 12 or 10, depending on PAL/NTSC */
+
 #define  MAX_MEM_HANDLERS     32
 
 enum
@@ -85,6 +88,18 @@ typedef struct nes_s
 
 } nes_t;
 
+#ifdef NES_PROFILE
+/// サブシステム毎の処理時間（ホストでの計測用、単位は nes_profile_clock）
+typedef struct nesprof_s
+{
+   uint64_t cpu;     ///< nes6502_execute
+   uint64_t ppu;     ///< ppu_scanline, ppu_endscanline, ppu_checknmi
+   uint64_t mmc;     ///< マッパーの hblank, vblank
+   uint32 frames;    ///< フレーム数
+   uint32 drawn;     ///< 描画したフレーム数
+} nesprof_t;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -104,6 +119,32 @@ extern void nes_nmi(void);
 extern void nes_irq(void);
 extern void nes_emulate(int frame);
 
+//-----------------------------------------------------------------//
+/*!
+	@brief	１フレームをエミュレート
+	@param[in]	draw	「0」なら描画を省く（CPU、APU、スプライト０ヒットは動かす）
+*/
+//-----------------------------------------------------------------//
+extern void nes_emulate_frame(int draw);
+
+#ifdef NES_PROFILE
+//-----------------------------------------------------------------//
+/*!
+	@brief	計測用の時計（ホスト側で用意する）
+	@return 時間（ns 等、差を取るだけなので回り込んでも良い）
+*/
+//-----------------------------------------------------------------//
+extern uint32 nes_profile_clock(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	サブシステム毎の処理時間を取得
+	@return 処理時間（クリアする場合は、直接書き換える）
+*/
+//-----------------------------------------------------------------//
+extern nesprof_t *nes_getprofile(void);
+#endif
+
 extern void nes_reset(int reset_type);
 
 extern void nes_poweroff(void);
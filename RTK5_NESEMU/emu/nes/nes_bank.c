@@ -0,0 +1,409 @@
+//=====================================================================//
+/*!	@file
+	@brief	NES ROM バンク・キャッシュ
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <string.h>
+
+#include "nes_bank.h"
+#include "log.h"
+
+// 先読みキューの大きさ（２のべき乗）
+#define  BANK_HINT_QUEUE   16
+
+typedef struct bankpool_s
+{
+	uint8 *mem;				///< スロットのメモリー
+	uint32 size;			///< スロット（バンク）のバイト数
+	int slots;
+	int banks;
+	long offset;			///< イメージのファイル位置
+	int windows;
+	int16 *slot_of;			///< バンク -> スロット（-1: 無い）
+	uint8 *nohint;			///< 先読みしても使われなかったバンク
+	int16 *bank_of;			///< スロット -> バンク（-1: 空き）
+	uint8 *pin;				///< スロットを指している窓の数
+	uint8 *fetched;			///< 先読みしたスロット
+	uint32 *stamp;			///< 最後に使った時刻（LRU）
+	int16 map[BANK_CHR_WINDOWS];	///< 窓 -> スロット（-1: 無い）
+} bankpool_t;
+
+typedef struct hint_s
+{
+	uint8 type;
+	int16 bank;
+} hint_t;
+
+typedef struct bank_s
+{
+	FILE *fp;
+	long pos;				///< ファイルの現在位置
+	uint32 clock;
+	bankpool_t pool[2];
+	hint_t hint[BANK_HINT_QUEUE];
+	uint32 hint_get, hint_put;
+	uint32 mark;			///< 前回の bank_service の時刻
+	bankstat_t stat;
+} bank_t;
+
+static bank_t bank_;
+static uint32 budget_[2] = { NES_BANK_PRG_BUDGET, NES_BANK_CHR_BUDGET };
+
+#ifdef NES_BANK_TRACE
+static FILE *trace_ = NULL;
+
+void bank_settrace(FILE *fp)
+{
+	trace_ = fp;
+}
+#define  BANK_TRACE(...)  { if (trace_) fprintf(trace_, __VA_ARGS__); }
+#else
+#define  BANK_TRACE(...)
+#endif
+
+
+static void read_(bankpool_t *pool, int bank, int slot, bool demand)
+{
+	long pos = pool->offset + (long)bank * pool->size;
+	uint8 *dst = pool->mem + (uint32)slot * pool->size;
+	size_t len = 0;
+
+	if (bank_.fp != NULL)
+	{
+		if (bank_.pos != pos)
+		{
+			fseek(bank_.fp, pos, SEEK_SET);
+			++bank_.stat.seeks;
+			if (demand)
+				++bank_.stat.stall_seeks;
+		}
+		len = fread(dst, 1, pool->size, bank_.fp);
+		bank_.pos = pos + (long)len;
+		++bank_.stat.reads;
+		bank_.stat.bytes += len;
+	}
+	// イメージが足りない場合（ヘッダーと合わない ROM）
+	if (len < pool->size)
+		memset(dst + len, 0xFF, pool->size - len);
+
+	if (demand)
+	{
+		++bank_.stat.stall_reads;
+		bank_.stat.stall_bytes += pool->size;
+	}
+}
+
+
+// 空きスロット、無ければ、どの窓からも指されていない一番古いスロット
+static int victim_(bankpool_t *pool)
+{
+	int i;
+	int slot = -1;
+	uint32 age = 0;
+
+	for (i = 0; i < pool->slots; ++i)
+	{
+		if (pool->bank_of[i] < 0)
+			return i;
+		if (pool->pin[i])
+			continue;
+		if (slot < 0 || (bank_.clock - pool->stamp[i]) > age)
+		{
+			slot = i;
+			age = bank_.clock - pool->stamp[i];
+		}
+	}
+	return slot;
+}
+
+
+static int fill_(bankpool_t *pool, int bank, bool demand)
+{
+	int slot = victim_(pool);
+	ASSERT(slot >= 0);
+
+	if (pool->bank_of[slot] >= 0)
+	{
+		// 使われずに追い出された場合、以後そのバンクのヒントは無視する
+		if (pool->fetched[slot])
+			pool->nohint[pool->bank_of[slot]] = 1;
+		pool->slot_of[pool->bank_of[slot]] = -1;
+	}
+	read_(pool, bank, slot, demand);
+	pool->slot_of[bank] = slot;
+	pool->bank_of[slot] = bank;
+	pool->fetched[slot] = 0;
+	return slot;
+}
+
+
+static uint8 *map_(bankpool_t *pool, int window, int bank)
+{
+	int slot = pool->slot_of[bank];
+	if (slot >= 0)
+	{
+		++bank_.stat.hits;
+		if (pool->fetched[slot])
+		{
+			++bank_.stat.prefetch_hits;
+			pool->fetched[slot] = 0;
+		}
+	}
+	else
+	{
+		++bank_.stat.misses;
+		pool->nohint[bank] = 0;
+		slot = fill_(pool, bank, true);
+	}
+
+	if (pool->map[window] >= 0)
+		--pool->pin[pool->map[window]];
+	++pool->pin[slot];
+	pool->map[window] = slot;
+	pool->stamp[slot] = ++bank_.clock;
+
+	return pool->mem + (uint32)slot * pool->size;
+}
+
+
+static void free_pool_(bankpool_t *pool)
+{
+	free(pool->mem);
+	free(pool->slot_of);
+	free(pool->nohint);
+	free(pool->bank_of);
+	free(pool->pin);
+	free(pool->fetched);
+	free(pool->stamp);
+	memset(pool, 0, sizeof(bankpool_t));
+}
+
+
+static int create_pool_(bankpool_t *pool, uint32 size, int windows, long offset, int banks, uint32 budget)
+{
+	int i;
+	int slots = budget / size;
+
+	pool->size = size;
+	pool->windows = windows;
+	pool->offset = offset;
+	pool->banks = banks;
+	for (i = 0; i < BANK_CHR_WINDOWS; ++i)
+		pool->map[i] = -1;
+	if (0 == banks)
+		return 0;
+
+	// 全ての窓が別のバンクを指していても、１つは入れ替えられる様にする
+	if (slots > banks)
+		slots = banks;
+	if (slots < banks && slots < (windows + 1))
+	{
+		slots = windows + 1;
+		if (slots > banks)
+			slots = banks;
+	}
+	pool->slots = slots;
+
+	pool->mem = malloc((uint32)slots * size);
+	pool->slot_of = malloc(sizeof(int16) * banks);
+	pool->nohint = malloc(banks);
+	pool->bank_of = malloc(sizeof(int16) * slots);
+	pool->pin = malloc(slots);
+	pool->fetched = malloc(slots);
+	pool->stamp = malloc(sizeof(uint32) * slots);
+	if (NULL == pool->mem || NULL == pool->slot_of || NULL == pool->nohint || NULL == pool->bank_of
+	 || NULL == pool->pin || NULL == pool->fetched || NULL == pool->stamp)
+	{
+		free_pool_(pool);
+		return -1;
+	}
+
+	for (i = 0; i < banks; ++i)
+		pool->slot_of[i] = -1;
+	memset(pool->nohint, 0, banks);
+	for (i = 0; i < slots; ++i)
+		pool->bank_of[i] = -1;
+	memset(pool->pin, 0, slots);
+	memset(pool->fetched, 0, slots);
+	memset(pool->stamp, 0, sizeof(uint32) * slots);
+
+	// 全て収まる場合は、先に読み込んでおく（以後ファイルは読まない）
+	if (slots == banks)
+	{
+		for (i = 0; i < banks; ++i)
+			fill_(pool, i, false);
+	}
+	return 0;
+}
+
+
+void bank_setbudget(uint32 prg, uint32 chr)
+{
+	budget_[BANK_PRG] = prg;
+	budget_[BANK_CHR] = chr;
+}
+
+
+int bank_create(FILE *fp, long prg_ofs, int prg_banks, long chr_ofs, int chr_banks)
+{
+	bank_destroy();
+
+	bank_.fp = fp;
+	bank_.pos = -1;
+
+	if (create_pool_(&bank_.pool[BANK_PRG], BANK_PRG_SIZE, BANK_PRG_WINDOWS,
+		prg_ofs, prg_banks, budget_[BANK_PRG]))
+	{
+		log_printf("Could not allocate space for PRG bank cache");
+		bank_destroy();
+		return -1;
+	}
+	if (create_pool_(&bank_.pool[BANK_CHR], BANK_CHR_SIZE, BANK_CHR_WINDOWS,
+		chr_ofs, chr_banks, budget_[BANK_CHR]))
+	{
+		log_printf("Could not allocate space for CHR bank cache");
+		bank_destroy();
+		return -1;
+	}
+
+	// 全て読み込んだ場合、ファイルは必要無い
+	if (bank_.pool[BANK_PRG].slots == prg_banks && bank_.pool[BANK_CHR].slots == chr_banks)
+	{
+		fclose(bank_.fp);
+		bank_.fp = NULL;
+	}
+
+	log_printf("Bank cache: PRG %d/%d, CHR %d/%d\n",
+		bank_.pool[BANK_PRG].slots, prg_banks, bank_.pool[BANK_CHR].slots, chr_banks);
+	BANK_TRACE("R %d %d\n", prg_banks, chr_banks);
+	return 0;
+}
+
+
+void bank_destroy(void)
+{
+	free_pool_(&bank_.pool[BANK_PRG]);
+	free_pool_(&bank_.pool[BANK_CHR]);
+	if (NULL != bank_.fp)
+		fclose(bank_.fp);
+	memset(&bank_, 0, sizeof(bank_t));
+}
+
+
+uint8 *bank_getprg(int window, int bank)
+{
+	bankpool_t *pool = &bank_.pool[BANK_PRG];
+	ASSERT(window >= 0 && window < BANK_PRG_WINDOWS);
+	ASSERT(bank >= 0 && bank < pool->banks);
+
+	BANK_TRACE("P %d %d\n", window, bank);
+	return map_(pool, window, bank);
+}
+
+
+uint8 *bank_getchr(int page, int bank)
+{
+	bankpool_t *pool = &bank_.pool[BANK_CHR];
+	ASSERT(page >= 0 && page < BANK_CHR_WINDOWS);
+	ASSERT(bank >= 0 && bank < pool->banks);
+
+	BANK_TRACE("C %d %d\n", page, bank);
+	return map_(pool, page, bank);
+}
+
+
+int bank_getmapped(banktype_t type, int window)
+{
+	const bankpool_t *pool = &bank_.pool[type];
+	if (window < 0 || window >= pool->windows || pool->map[window] < 0)
+		return -1;
+	return pool->bank_of[pool->map[window]];
+}
+
+
+void bank_hint(banktype_t type, int bank, int num)
+{
+	const bankpool_t *pool = &bank_.pool[type];
+
+	BANK_TRACE("H %d %d %d\n", (int)type, bank, num);
+	if (pool->banks == pool->slots)
+		return;
+
+	for (; num > 0; --num, ++bank)
+	{
+		int b = bank % pool->banks;
+		if (pool->slot_of[b] >= 0 || pool->nohint[b])
+			continue;
+		// 溢れた場合は、古いヒントを捨てる
+		if ((bank_.hint_put - bank_.hint_get) >= BANK_HINT_QUEUE)
+			++bank_.hint_get;
+		bank_.hint[bank_.hint_put % BANK_HINT_QUEUE].type = type;
+		bank_.hint[bank_.hint_put % BANK_HINT_QUEUE].bank = b;
+		++bank_.hint_put;
+	}
+}
+
+
+int bank_service(int limit)
+{
+	int n = 0;
+	uint32 mark = bank_.mark;
+	bank_.mark = bank_.clock;
+
+	BANK_TRACE("S %d\n", limit);
+	// 新しいヒントから
+	while (n < limit && bank_.hint_get != bank_.hint_put)
+	{
+		const hint_t *h = &bank_.hint[--bank_.hint_put % BANK_HINT_QUEUE];
+		bankpool_t *pool = &bank_.pool[h->type];
+		int slot;
+		uint32 stamp;
+
+		if (pool->slot_of[h->bank] >= 0)
+			continue;
+		// 前のフレームから使ったバンクは、追い出さない
+		slot = victim_(pool);
+		if (slot < 0)
+			break;
+		stamp = pool->stamp[slot];
+		if (pool->bank_of[slot] >= 0 && (int32)(stamp - mark) > 0)
+			continue;
+		slot = fill_(pool, h->bank, false);
+		pool->fetched[slot] = 1;
+		// 使われるまでは、一番古いバンクとして扱う
+		pool->stamp[slot] = stamp;
+		++bank_.stat.prefetches;
+		++n;
+	}
+	return n;
+}
+
+
+const bankstat_t *bank_getstat(void)
+{
+	return &bank_.stat;
+}
+
+
+void bank_clearstat(void)
+{
+	memset(&bank_.stat, 0, sizeof(bankstat_t));
+}
+
+
+uint32 bank_getmemory(void)
+{
+	uint32 sum = 0;
+	int i;
+	for (i = 0; i < 2; ++i)
+	{
+		const bankpool_t *pool = &bank_.pool[i];
+		sum += (uint32)pool->slots * (pool->size + sizeof(int16) + 2 + sizeof(uint32));
+		sum += (uint32)pool->banks * (sizeof(int16) + 1);
+	}
+	return sum;
+}
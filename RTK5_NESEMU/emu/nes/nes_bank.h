@@ -0,0 +1,174 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	NES ROM バンク・キャッシュ @n
+			PRG（８Ｋバイト単位）、CHR（１Ｋバイト単位）のバンクを、マッパーの @n
+			切り替え時に SD カードから読み込み、LRU で管理する。@n
+			CPU の mem_page[]、PPU の page[] が指しているバンクは、追い出さない。@n
+			ROM 全体がバジェットに収まる場合は、最初に全て読み込む。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <stdio.h>
+#include "nes_std.h"
+
+/// PRG キャッシュの標準サイズ（バイト）
+#ifndef NES_BANK_PRG_BUDGET
+#define  NES_BANK_PRG_BUDGET   (96 * 1024)
+#endif
+
+/// CHR キャッシュの標準サイズ（バイト）
+#ifndef NES_BANK_CHR_BUDGET
+#define  NES_BANK_CHR_BUDGET   (32 * 1024)
+#endif
+
+#define  BANK_PRG_SIZE     0x2000	///< PRG バンク・サイズ
+#define  BANK_CHR_SIZE     0x0400	///< CHR バンク・サイズ
+#define  BANK_PRG_WINDOWS  5		///< PRG の窓（$8000, $A000, $C000, $E000, $6000）
+#define  BANK_PRG_SRAM     4		///< $6000 に PRG を置くマッパー（40、42、50 など）の窓
+#define  BANK_CHR_WINDOWS  12		///< CHR の窓（$0000 〜 $2FFF の１Ｋバイト・ページ）
+
+typedef enum
+{
+	BANK_PRG = 0,
+	BANK_CHR = 1
+} banktype_t;
+
+/// 統計
+typedef struct bankstat_s
+{
+	uint32 hits;			///< 切り替え時に、キャッシュにあった
+	uint32 misses;			///< 切り替え時に、読み込んだ
+	uint32 prefetches;		///< 先読みで読み込んだ
+	uint32 prefetch_hits;	///< 先読みしたバンクが使われた
+	uint32 seeks;			///< ファイルのシーク回数
+	uint32 reads;			///< ファイルの読み込み回数
+	uint32 bytes;			///< ファイルから読み込んだバイト数
+	uint32 stall_reads;		///< 切り替え時の読み込み回数
+	uint32 stall_bytes;		///< 切り替え時に読み込んだバイト数
+	uint32 stall_seeks;		///< 切り替え時のシーク回数
+} bankstat_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	キャッシュのサイズを設定（次の bank_create から有効）
+	@param[in]	prg		PRG キャッシュのバイト数
+	@param[in]	chr		CHR キャッシュのバイト数
+*/
+//-----------------------------------------------------------------//
+extern void bank_setbudget(uint32 prg, uint32 chr);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	キャッシュを作成 @n
+			ファイルは（失敗した場合も）キャッシュが管理し、bank_destroy で閉じる
+	@param[in]	fp			ROM ファイル
+	@param[in]	prg_ofs		PRG イメージのファイル位置
+	@param[in]	prg_banks	PRG バンク数（８Ｋバイト単位）
+	@param[in]	chr_ofs		CHR イメージのファイル位置
+	@param[in]	chr_banks	CHR バンク数（１Ｋバイト単位、CHR-RAM の場合０）
+	@return 成功なら「0」
+*/
+//-----------------------------------------------------------------//
+extern int bank_create(FILE *fp, long prg_ofs, int prg_banks, long chr_ofs, int chr_banks);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	キャッシュを廃棄（ファイルも閉じる）
+*/
+//-----------------------------------------------------------------//
+extern void bank_destroy(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	PRG バンクを窓に割り当てる
+	@param[in]	window	窓（0: $8000, 1: $A000, 2: $C000, 3: $E000, 4: $6000）
+	@param[in]	bank	バンク（８Ｋバイト単位）
+	@return バンクの先頭
+*/
+//-----------------------------------------------------------------//
+extern uint8 *bank_getprg(int window, int bank);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	CHR バンクをページに割り当てる
+	@param[in]	page	PPU ページ（１Ｋバイト単位、0 〜 11）
+	@param[in]	bank	バンク（１Ｋバイト単位）
+	@return バンクの先頭
+*/
+//-----------------------------------------------------------------//
+extern uint8 *bank_getchr(int page, int bank);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	窓に割り当てているバンクを取得
+	@param[in]	type	種別
+	@param[in]	window	窓（PRG: 0 〜 4、CHR: 0 〜 11）
+	@return バンク（割り当てていない場合「-1」）
+*/
+//-----------------------------------------------------------------//
+extern int bank_getmapped(banktype_t type, int window);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	先読みのヒント（マッパーがバンク・レジスターに書いた時）@n
+			bank_service で読み込む
+	@param[in]	type	種別
+	@param[in]	bank	バンク（PRG: ８Ｋバイト、CHR: １Ｋバイト単位）
+	@param[in]	num		連続するバンク数
+*/
+//-----------------------------------------------------------------//
+extern void bank_hint(banktype_t type, int bank, int num);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	先読みを行う（フレームの空き時間に呼ぶ）
+	@param[in]	limit	読み込む最大バンク数
+	@return 読み込んだバンク数
+*/
+//-----------------------------------------------------------------//
+extern int bank_service(int limit);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	統計を取得
+	@return 統計
+*/
+//-----------------------------------------------------------------//
+extern const bankstat_t *bank_getstat(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	統計をクリア
+*/
+//-----------------------------------------------------------------//
+extern void bank_clearstat(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	キャッシュが使っているメモリーを取得
+	@return バイト数
+*/
+//-----------------------------------------------------------------//
+extern uint32 bank_getmemory(void);
+
+#ifdef NES_BANK_TRACE
+//-----------------------------------------------------------------//
+/*!
+	@brief	バンク操作の記録先を設定（nes_bench で再生できる）
+	@param[in]	fp	記録するファイル（止める場合「NULL」）
+*/
+//-----------------------------------------------------------------//
+extern void bank_settrace(FILE *fp);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "nes6502.h"
+#include "nes_bank.h"
 #include "nes_mmc.h"
 #include "nes_ppu.h"
 #include "libsnss.h"
@@ -60,6 +61,14 @@ mmc_t *mmc_getcontext(void)
    return &mmc_;
 }
 
+/* 1kB VROM pages, through the bank cache */
+static void mmc_setvrom(int page, int num, int bank)
+{
+   int i;
+   for (i = 0; i < num; i++, page++)
+      ppu_setpage(1, page, bank_getchr(page, bank + i) - (page << 10));
+}
+
 /* VROM bankswitching */
 void mmc_bankvrom(int size, uint32 address, int bank)
 {
@@ -71,25 +80,25 @@ void mmc_bankvrom(int size, uint32 address, int bank)
    case 1:
       if (bank == MMC_LASTBANK)
          bank = MMC_LAST1KVROM;
-      ppu_setpage(1, address >> 10, &mmc_.cart->vrom[(bank % MMC_1KVROM) << 10] - address);
+      mmc_setvrom(address >> 10, 1, bank % MMC_1KVROM);
       break;
 
    case 2:
       if (bank == MMC_LASTBANK)
          bank = MMC_LAST2KVROM;
-      ppu_setpage(2, address >> 10, &mmc_.cart->vrom[(bank % MMC_2KVROM) << 11] - address);
+      mmc_setvrom(address >> 10, 2, (bank % MMC_2KVROM) << 1);
       break;
 
    case 4:
       if (bank == MMC_LASTBANK)
          bank = MMC_LAST4KVROM;
-      ppu_setpage(4, address >> 10, &mmc_.cart->vrom[(bank % MMC_4KVROM) << 12] - address);
+      mmc_setvrom(address >> 10, 4, (bank % MMC_4KVROM) << 2);
       break;
 
    case 8:
       if (bank == MMC_LASTBANK)
          bank = MMC_LAST8KVROM;
-      ppu_setpage(8, 0, &mmc_.cart->vrom[(bank % MMC_8KVROM) << 13]);
+      mmc_setvrom(0, 8, (bank % MMC_8KVROM) << 3);
       break;
 
    default:
@@ -97,47 +106,47 @@ void mmc_bankvrom(int size, uint32 address, int bank)
    }
 }
 
-/* ROM bankswitching */
-void mmc_bankrom(int size, uint32 address, int bank)
+/* 8kB ROM pages (two 4kB CPU banks each), through the bank cache */
+static void mmc_setrom(int page, int num, int bank)
 {
 	nes6502_context* cpu = nes6502_getcontext(); 
+	int i;
+	for (i = 0; i < num; i++, page += 2) {
+		int window;
+		if (page >= 8)
+			window = (page - 8) >> 1;
+		else if (6 == page)
+			window = BANK_PRG_SRAM;  /* $6000-$7FFF (mappers 40, 42, 50) */
+		else {
+			log_printf("invalid ROM page $%04X\n", page << NES6502_BANKSHIFT);
+			return;
+		}
+		cpu->mem_page[page] = bank_getprg(window, bank + i);
+		cpu->mem_page[page + 1] = cpu->mem_page[page] + 0x1000;
+	}
+}
 
+/* ROM bankswitching */
+void mmc_bankrom(int size, uint32 address, int bank)
+{
 	switch (size)
 	{
 	case 8:
 		if (bank == MMC_LASTBANK)
 			bank = MMC_LAST8KROM;
-		{
-			int page = address >> NES6502_BANKSHIFT;
-			cpu->mem_page[page] = &mmc_.cart->rom[(bank % MMC_8KROM) << 13];
-			cpu->mem_page[page + 1] = cpu->mem_page[page] + 0x1000;
-		}
+		mmc_setrom(address >> NES6502_BANKSHIFT, 1, bank % MMC_8KROM);
 		break;
 
 	case 16:
 		if (bank == MMC_LASTBANK)
 			bank = MMC_LAST16KROM;
-		{
-			int page = address >> NES6502_BANKSHIFT;
-			cpu->mem_page[page] = &mmc_.cart->rom[(bank % MMC_16KROM) << 14];
-			cpu->mem_page[page + 1] = cpu->mem_page[page] + 0x1000;
-			cpu->mem_page[page + 2] = cpu->mem_page[page] + 0x2000;
-			cpu->mem_page[page + 3] = cpu->mem_page[page] + 0x3000;
-		}
+		mmc_setrom(address >> NES6502_BANKSHIFT, 2, (bank % MMC_16KROM) << 1);
 		break;
 
 	case 32:
 		if (bank == MMC_LASTBANK)
 			bank = MMC_LAST32KROM;
-
-		cpu->mem_page[8] = &mmc_.cart->rom[(bank % MMC_32KROM) << 15];
-		cpu->mem_page[9] = cpu->mem_page[8] + 0x1000;
-		cpu->mem_page[10] = cpu->mem_page[8] + 0x2000;
-		cpu->mem_page[11] = cpu->mem_page[8] + 0x3000;
-		cpu->mem_page[12] = cpu->mem_page[8] + 0x4000;
-		cpu->mem_page[13] = cpu->mem_page[8] + 0x5000;
-		cpu->mem_page[14] = cpu->mem_page[8] + 0x6000;
-		cpu->mem_page[15] = cpu->mem_page[8] + 0x7000;
+		mmc_setrom(8, 4, (bank % MMC_32KROM) << 2);
 		break;
 
 	default:
@@ -146,6 +155,21 @@ void mmc_bankrom(int size, uint32 address, int bank)
 	}
 }
 
+/* VROM/ROM bank prefetch hint (bank register written, switch is likely soon) */
+void mmc_hintvrom(int size, int bank)
+{
+   if (0 == mmc_.cart->vrom_banks || bank < 0)
+      return;
+   bank_hint(BANK_CHR, (bank * size) % MMC_1KVROM, size);
+}
+
+void mmc_hintrom(int size, int bank)
+{
+   if (bank < 0)
+      return;
+   bank_hint(BANK_PRG, (bank * (size >> 3)) % MMC_8KROM, size >> 3);
+}
+
 /* Check to see if this mapper is supported */
 bool mmc_peek(int map_num)
 {
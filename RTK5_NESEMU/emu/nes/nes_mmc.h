@@ -73,6 +73,9 @@ extern rominfo_t *mmc_getinfo(void);
 extern void mmc_bankvrom(int size, uint32 address, int bank);
 extern void mmc_bankrom(int size, uint32 address, int bank);
 
+extern void mmc_hintvrom(int size, int bank);
+extern void mmc_hintrom(int size, int bank);
+
 /* Prototypes */
 extern int mmc_create(rominfo_t *rominfo);
 
@@ -27,6 +27,7 @@
 
 #include "bitmap.h"
 #include "nes_pal.h"
+#include "nes_ppu.h"
 
 #ifndef PI
 #define PI 3.1415926535897932384626433832795
@@ -76,21 +77,25 @@ void pal_dechue(void)
 {
    hue -= 0.5f;
    pal_generate();
+   ppu_setdefaultpal();
 }
 void pal_inchue(void)
 {
    hue += 0.5f;
    pal_generate();
+   ppu_setdefaultpal();
 }
 void pal_dectint(void)
 {
    tint -= 0.01f;
    pal_generate();
+   ppu_setdefaultpal();
 }
 void pal_inctint(void)
 {
    tint += 0.01f;
    pal_generate();
+   ppu_setdefaultpal();
 }
 
 static const float brightness[4][4] = 
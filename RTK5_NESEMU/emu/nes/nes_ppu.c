@@ -50,6 +50,56 @@
 /* the NES PPU */
 static ppu_t ppu;
 
+/* 表示パレット（６４色）と、変更の度に増やす番号 */
+static rgb_t ppu_pal_[64];
+static uint32 ppu_pal_serial_ = 0;
+
+/* BG タイル・キャッシュ：パターン・テーブルのページ（$0000 〜 $1FFF）毎に、
+** ２ビットの色番号を１ピクセル１バイトに展開したタイル（ライン単位で展開）
+** ppu_setpage でページの世代を進め、CHR RAM への書き込みでタイルを無効にする
+*/
+#define  TILE_PAGES           8
+#define  TILE_PER_PAGE        64
+
+typedef struct tilecache_s
+{
+   uint8 data[TILE_PAGES][TILE_PER_PAGE][64];
+   uint16 gen[TILE_PAGES][TILE_PER_PAGE];    /* 展開した時のページの世代（0 は無効） */
+   uint8 rows[TILE_PAGES][TILE_PER_PAGE];    /* 展開したライン（ビット） */
+   uint16 page_gen[TILE_PAGES];
+} tilecache_t;
+
+static tilecache_t ppu_tile_;
+
+/* スキャンライン毎のスプライト（OAM の順、最大 PPU_MAXSPRITE 個） */
+static uint8 ppu_objline_[NES_SCREEN_HEIGHT][PPU_MAXSPRITE];
+static uint8 ppu_objcount_[NES_SCREEN_HEIGHT];
+static bool ppu_objdirty_ = true;
+
+static void ppu_flushpage(int page)
+{
+   if (0 == ++ppu_tile_.page_gen[page])
+   {
+      /* 世代が一周したら、ページの全てのタイルを無効にする */
+      memset(ppu_tile_.gen[page], 0, sizeof(ppu_tile_.gen[page]));
+      ppu_tile_.page_gen[page] = 1;
+   }
+}
+
+void ppu_flushtiles(void)
+{
+   int i;
+
+   for (i = 0; i < TILE_PAGES; i++)
+      ppu_flushpage(i);
+}
+
+INLINE void ppu_flushtile(uint32 address)
+{
+   if (address < 0x2000)
+      ppu_tile_.gen[address >> 10][(address >> 4) & (TILE_PER_PAGE - 1)] = 0;
+}
+
 void ppu_displaysprites(bool display)
 {
    ppu.drawsprites = display;
@@ -109,6 +159,8 @@ int ppu_create(void)
 	}
 
 	ppu_setdefaultpal();
+	ppu_flushtiles();
+	ppu_objdirty_ = true;
 
 #if 0
 	int nametab[4];
@@ -133,6 +185,12 @@ int ppu_create(void)
 
 void ppu_setpage(int size, int page_num, uint8 *location)
 {
+   int i;
+
+   /* パターン・テーブルは、同じ場所でも中身が変わる（バンク・キャッシュ）*/
+   for (i = page_num; i < (page_num + size) && i < TILE_PAGES; i++)
+      ppu_flushpage(i);
+
    /* deliberately fall through */
    switch (size)
    {
@@ -192,6 +250,7 @@ void ppu_reset(int reset_type)
 {
    if (HARD_RESET == reset_type)
       mem_trash(ppu.oam, 256);
+   ppu_objdirty_ = true;
 
    ppu.ctrl0 = 0;
    ppu.ctrl1 = PPU_CTRL1F_OBJON | PPU_CTRL1F_BGON;
@@ -234,6 +293,7 @@ static void ppu_oamdma(uint8 value)
       ppu.oam[oam_loc++] = nes6502_getbyte(cpu_address++);
    }
    while (oam_loc != ppu.oam_addr);
+   ppu_objdirty_ = true;
 
    /* TODO: enough with houdini */
    cpu_address -= 256;
@@ -386,6 +446,8 @@ void ppu_write(uint32 address, uint8 value)
    case PPU_CTRL0:
       ppu.ctrl0 = value;
 
+      if (ppu.obj_height != ((value & PPU_CTRL0F_OBJ16) ? 16 : 8))
+         ppu_objdirty_ = true;
       ppu.obj_height = (value & PPU_CTRL0F_OBJ16) ? 16 : 8;
       ppu.bg_base = (value & PPU_CTRL0F_BGADDR) ? 0x1000 : 0;
       ppu.obj_base = (value & PPU_CTRL0F_OBJADDR) ? 0x1000 : 0;
@@ -412,6 +474,7 @@ void ppu_write(uint32 address, uint8 value)
 
    case PPU_OAMDATA:
       ppu.oam[ppu.oam_addr++] = value;
+      ppu_objdirty_ = true;
       break;
 
    case PPU_SCROLL:
@@ -462,6 +525,7 @@ void ppu_write(uint32 address, uint8 value)
 //            log_printf("VRAM write to $%04X, scanline %d\n", 
 //                       ppu.vaddr, nes_getcontext()->scanline);
             PPU_MEM(ppu.vaddr) = 0xFF; /* corrupt */
+            ppu_flushtile(ppu.vaddr);
          }
          else 
          {
@@ -471,6 +535,7 @@ void ppu_write(uint32 address, uint8 value)
                ppu.vaddr -= 0x1000;
 
             PPU_MEM(addr) = value;
+            ppu_flushtile(addr);
          }
       }
       else
@@ -527,6 +592,16 @@ void ppu_setpal(rgb_t *pal)
 {
 	/// ppu_buildpalette(pal);
 	/// vid_setpalette(src_ppu->curpal);
+	/* VS のパレットはスタック上なので、複製しておく */
+	memcpy(ppu_pal_, pal, sizeof(ppu_pal_));
+	++ppu_pal_serial_;
+}
+
+const rgb_t *ppu_getpal(uint32 *serial)
+{
+	if (NULL != serial)
+		*serial = ppu_pal_serial_;
+	return ppu_pal_;
 }
 
 void ppu_setdefaultpal(void)
@@ -561,6 +636,55 @@ INLINE void draw_bgtile(uint8 *surface, uint8 pat1, uint8 pat2,
    *surface = colors[pattern & 3];
 }
 
+/* タイルのライン（address は、パターン・テーブルのタイル＋ライン）を展開して返す */
+INLINE const uint8 *ppu_tilerow(uint32 address)
+{
+   int page = address >> 10;
+   int tile = (address >> 4) & (TILE_PER_PAGE - 1);
+   int line = address & 7;
+   uint8 *row = ppu_tile_.data[page][tile] + (line << 3);
+
+   if (ppu_tile_.gen[page][tile] != ppu_tile_.page_gen[page])
+   {
+      ppu_tile_.gen[page][tile] = ppu_tile_.page_gen[page];
+      ppu_tile_.rows[page][tile] = 0;
+   }
+
+   if (0 == (ppu_tile_.rows[page][tile] & (1 << line)))
+   {
+      const uint8 *data_ptr = &PPU_MEM(address);
+      uint8 pat1 = data_ptr[0];
+      uint8 pat2 = data_ptr[8];
+      uint32 pattern = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
+                       | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
+
+      row[0] = (pattern >> 14) & 3;
+      row[1] = (pattern >> 6) & 3;
+      row[2] = (pattern >> 12) & 3;
+      row[3] = (pattern >> 4) & 3;
+      row[4] = (pattern >> 10) & 3;
+      row[5] = (pattern >> 2) & 3;
+      row[6] = (pattern >> 8) & 3;
+      row[7] = pattern & 3;
+      ppu_tile_.rows[page][tile] |= 1 << line;
+   }
+
+   return row;
+}
+
+/* 展開したラインの色番号に、属性（colors = palette + 上位２ビット）を付けて描く */
+INLINE void draw_bgrow(uint8 *surface, const uint8 *row, const uint8 *colors)
+{
+   surface[0] = colors[row[0]];
+   surface[1] = colors[row[1]];
+   surface[2] = colors[row[2]];
+   surface[3] = colors[row[3]];
+   surface[4] = colors[row[4]];
+   surface[5] = colors[row[5]];
+   surface[6] = colors[row[6]];
+   surface[7] = colors[row[7]];
+}
+
 INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1, 
                         uint8 pat2, const uint8 *col_tbl, bool check_strike)
 {
@@ -664,7 +788,8 @@ INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1,
 
 static void ppu_renderbg(uint8 *vidbuf)
 {
-   uint8 *bmp_ptr, *data_ptr, *tile_ptr, *attrib_ptr;
+   uint8 *bmp_ptr, *tile_ptr, *attrib_ptr;
+   const uint8 *row_ptr;
    uint32 refresh_vaddr, bg_offset, attrib_base;
    int tile_count;
    uint8 tile_index, x_tile, y_tile;
@@ -697,13 +822,13 @@ static void ppu_renderbg(uint8 *vidbuf)
    {
       /* Tile number from nametable */
       tile_index = *tile_ptr++;
-      data_ptr = &PPU_MEM(bg_offset + (tile_index << 4));
+      row_ptr = ppu_tilerow(bg_offset + (tile_index << 4));
 
       /* Handle $FD/$FE tile VROM switching (PunchOut) */
       if (ppu.latchfunc)
          ppu.latchfunc(ppu.bg_base, tile_index);
 
-      draw_bgtile(bmp_ptr, data_ptr[0], data_ptr[8], ppu.palette + col_high);
+      draw_bgrow(bmp_ptr, row_ptr, ppu.palette + col_high);
       bmp_ptr += 8;
 
       x_tile++;
@@ -752,18 +877,51 @@ typedef struct obj_s
    uint8 x_loc;
 } obj_t;
 
+/* スキャンライン毎に、表示するスプライトを OAM の順に並べる（フレーム毎、OAM を変えた時）*/
+static void ppu_sortoam(void)
+{
+   int sprite_num, line, end;
+   obj_t *sprite_ptr;
+
+   memset(ppu_objcount_, 0, sizeof(ppu_objcount_));
+
+   sprite_ptr = (obj_t *) ppu.oam;
+   for (sprite_num = 0; sprite_num < 64; sprite_num++, sprite_ptr++)
+   {
+      uint8 sprite_y = sprite_ptr->y_loc + 1;
+
+      if ((0 == sprite_y) || (sprite_y >= 240))
+         continue;
+
+      end = sprite_y + ppu.obj_height;
+      if (end > NES_SCREEN_HEIGHT)
+         end = NES_SCREEN_HEIGHT;
+
+      for (line = sprite_y; line < end; line++)
+      {
+         if (ppu_objcount_[line] < PPU_MAXSPRITE)
+            ppu_objline_[line][ppu_objcount_[line]++] = (uint8) sprite_num;
+      }
+   }
+
+   ppu_objdirty_ = false;
+}
+
 /* TODO: fetch valid OAM a scanline before, like the Real Thing */
 static void ppu_renderoam(uint8 *vidbuf, int scanline)
 {
    uint8 *buf_ptr;
    uint32 vram_offset, savecol[2];
-   int sprite_num, spritecount;
+   int sprite_num, spritecount, i;
    obj_t *sprite_ptr;
    uint8 sprite_height;
 
    if (false == ppu.obj_on)
       return;
 
+   if (ppu_objdirty_)
+      ppu_sortoam();
+
    /* Get our buffer pointer */
    buf_ptr = vidbuf;
 
@@ -776,11 +934,9 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
 
    sprite_height = ppu.obj_height;
    vram_offset = ppu.obj_base;
-   spritecount = 0;
-
-   sprite_ptr = (obj_t *) ppu.oam;
+   spritecount = ppu_objcount_[scanline];
 
-   for (sprite_num = 0; sprite_num < 64; sprite_num++, sprite_ptr++)
+   for (i = 0; i < spritecount; i++)
    {
       uint8 *data_ptr, *bmp_ptr;
       uint32 vram_adr;
@@ -790,13 +946,11 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
       bool check_strike;
       int strike_pixel;
 
+      /* 範囲のスプライトだけ（ppu_sortoam）*/
+      sprite_num = ppu_objline_[scanline][i];
+      sprite_ptr = (obj_t *) ppu.oam + sprite_num;
       sprite_y = sprite_ptr->y_loc + 1;
 
-      /* Check to see if sprite is out of range */
-      if ((sprite_y > scanline) || (sprite_y <= (scanline - sprite_height))
-          || (0 == sprite_y) || (sprite_y >= 240))
-         continue;
-
       sprite_x = sprite_ptr->x_loc;
       tile_index = sprite_ptr->tile;
       attrib = sprite_ptr->atr;
@@ -846,15 +1000,12 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
       strike_pixel = draw_oamtile(bmp_ptr, attrib, data_ptr[0], data_ptr[8], ppu.palette + 16 + col_high, check_strike);
       if (strike_pixel >= 0)
          ppu_setstrike(strike_pixel);
-
-      /* maximum of 8 sprites per scanline */
-      if (++spritecount == PPU_MAXSPRITE)
-      {
-         ppu.stat |= PPU_STATF_MAXSPRITE;
-         break;
-      }
    }
 
+   /* maximum of 8 sprites per scanline */
+   if (PPU_MAXSPRITE == spritecount)
+      ppu.stat |= PPU_STATF_MAXSPRITE;
+
    /* Restore lefthand column */
    if (ppu.obj_mask)
    {
@@ -982,6 +1133,10 @@ static void ppu_renderscanline(bitmap_t *bmp, int scanline, bool draw_flag)
 {
    uint8 *buf = &bmp->data[scanline * bmp->pitch];
 
+   /* スプライトの並べ替えは、フレーム毎 */
+   if (0 == scanline)
+      ppu_objdirty_ = true;
+
    /* start scanline - transfer ppu latch into vaddr */
    if (ppu.bg_on || ppu.obj_on)
    {
@@ -127,6 +127,14 @@ extern void ppu_mirror(int nt1, int nt2, int nt3, int nt4);
 extern void ppu_setpage(int size, int page_num, uint8 *location);
 extern uint8 *ppu_getpage(int page);
 
+//-----------------------------------------------------------------//
+/*!
+	@brief	BG タイル・キャッシュを全て無効にする @n
+			CHR RAM を ppu_write 以外で書き換えた場合（ステート・ロード等）
+*/
+//-----------------------------------------------------------------//
+extern void ppu_flushtiles(void);
+
 
 /* control */
 extern void ppu_reset(int reset_type);
@@ -148,6 +156,15 @@ extern void ppu_writehigh(uint32 address, uint8 value);
 extern void ppu_setpal(rgb_t *pal);
 extern void ppu_setdefaultpal(void);
 
+//-----------------------------------------------------------------//
+/*!
+	@brief	表示パレットを取得
+	@param[out]	serial	ppu_setpal の度に変わる番号（変換テーブルの再作成用）
+	@return ６４色のパレット
+*/
+//-----------------------------------------------------------------//
+extern const rgb_t *ppu_getpal(uint32 *serial);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
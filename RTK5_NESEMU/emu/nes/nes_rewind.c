@@ -0,0 +1,426 @@
+//=====================================================================//
+/*!	@file
+	@brief	NES 巻き戻し（メモリー上のスナップショット・リング）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <stdlib.h>
+#include <string.h>
+
+#include "nes_rewind.h"
+#include "nes.h"
+#include "nesstate.h"
+#include "nes6502.h"
+#include "log.h"
+
+// リングに置く差分の最大数
+#define  REWIND_RECORDS    256
+// 差分の中の一致がこれより短い場合は、次の差分とつなげる（ヘッダーの方が大きい）
+#define  REWIND_GAP        4
+// 状態の区間（rewindext_t、SNSS ブロック）の数
+#define  REWIND_SEGMENTS   6
+
+// 差分は、「前の差分の終わりからの距離（２バイト）、長さ（２バイト）、XOR（長さ）」の並び
+
+typedef struct rewindseg_s
+{
+	uint8 *ptr;				///< work の中の区間
+	uint32 len;
+} rewindseg_t;
+
+// SNSS に無い、フレームの間で残る状態（巻き戻した後、同じ画面を作る為）
+typedef struct rewindext_s
+{
+	uint32 vaddr_latch;
+	int tile_xofs, flipflop;
+	uint8 stat, latch, vdata_latch, strobe;
+	uint8 int_pending, int_latency, jammed;
+	int32 burn_cycles;
+} rewindext_t;
+
+typedef struct rewindrec_s
+{
+	uint32 ofs;				///< pool の位置
+	uint32 len;
+} rewindrec_t;
+
+typedef struct rewind_s
+{
+	SNSS_FILE *work;		///< state_capture、state_restore の作業領域
+	rewindext_t ext;
+	uint8 *image;			///< 最新のスナップショット（区間を詰めて並べる）
+	uint32 image_len;
+	bool valid;				///< image が有効
+	rewindseg_t seg[REWIND_SEGMENTS];
+	int segs;
+	uint8 *pool;
+	uint32 pool_size;
+	uint32 pos;				///< 次の差分を置く位置
+	rewindrec_t rec[REWIND_RECORDS];
+	int first;				///< 最も古い差分
+	int num;
+	int interval;
+	int since;				///< 最新のスナップショットから進めたフレーム数
+	rewindstat_t stat;
+} rewind_t;
+
+static rewind_t rewind_;
+
+
+static void add_segment_(void *ptr, uint32 len)
+{
+	if (len == 0)
+		return;
+
+	rewind_.seg[rewind_.segs].ptr = (uint8 *) ptr;
+	rewind_.seg[rewind_.segs].len = len;
+	++rewind_.segs;
+	rewind_.image_len += len;
+}
+
+
+// work と image を比べて、差分のバイト数を返す（out が NULL で無ければ、差分を書いて image を更新）
+static uint32 scan_(uint8 *out)
+{
+	uint32 size = 0;
+	uint32 last = 0;
+	uint32 g = 0;
+	int s;
+
+	for (s = 0; s < rewind_.segs; s++)
+	{
+		const uint8 *a = rewind_.seg[s].ptr;
+		uint8 *b = rewind_.image + g;
+		uint32 len = rewind_.seg[s].len;
+		uint32 i = 0;
+
+		while (i < len)
+		{
+			uint32 end, j, n, skip;
+
+			while ((i + 16) <= len && 0 == memcmp(a + i, b + i, 16))
+				i += 16;
+			while (i < len && a[i] == b[i])
+				++i;
+			if (i >= len)
+				break;
+
+			end = i + 1;
+			j = i + 1;
+			while (j < len && (j - end) < REWIND_GAP)
+			{
+				if (a[j] != b[j])
+					end = j + 1;
+				++j;
+			}
+
+			n = end - i;
+			skip = g + i - last;
+			if (out)
+			{
+				out[0] = skip & 0xFF;
+				out[1] = skip >> 8;
+				out[2] = n & 0xFF;
+				out[3] = n >> 8;
+				out += 4;
+				for (j = i; j < end; j++)
+				{
+					*out++ = a[j] ^ b[j];
+					b[j] = a[j];
+				}
+			}
+			size += 4 + n;
+			last = g + end;
+			i = end;
+		}
+		g += len;
+	}
+	return size;
+}
+
+
+// 差分を image に XOR する（XOR は戻しても同じ）
+static void apply_(const uint8 *src, uint32 len)
+{
+	const uint8 *end = src + len;
+	uint8 *dst = rewind_.image;
+
+	while (src < end)
+	{
+		uint32 skip = src[0] | (src[1] << 8);
+		uint32 n = src[2] | (src[3] << 8);
+
+		src += 4;
+		dst += skip;
+		while (n--)
+			*dst++ ^= *src++;
+	}
+}
+
+
+static void capture_(void)
+{
+	const ppu_t *ppu = ppu_getcontext();
+	const nes6502_context *cpu = nes6502_getcontext();
+	rewindext_t *e = &rewind_.ext;
+
+	state_capture(rewind_.work);
+
+	e->vaddr_latch = ppu->vaddr_latch;
+	e->tile_xofs = ppu->tile_xofs;
+	e->flipflop = ppu->flipflop;
+	e->stat = ppu->stat;
+	e->latch = ppu->latch;
+	e->vdata_latch = ppu->vdata_latch;
+	e->strobe = ppu->strobe;
+	e->int_pending = cpu->int_pending;
+	e->int_latency = cpu->int_latency;
+	e->jammed = cpu->jammed;
+	e->burn_cycles = cpu->burn_cycles;
+}
+
+
+static void pack_(void)
+{
+	uint32 g = 0;
+	int s;
+
+	for (s = 0; s < rewind_.segs; s++)
+	{
+		memcpy(rewind_.image + g, rewind_.seg[s].ptr, rewind_.seg[s].len);
+		g += rewind_.seg[s].len;
+	}
+}
+
+
+static void restore_(void)
+{
+	uint32 g = 0;
+	int s;
+	ppu_t *ppu;
+	nes6502_context *cpu;
+	const rewindext_t *e;
+
+	for (s = 0; s < rewind_.segs; s++)
+	{
+		memcpy(rewind_.seg[s].ptr, rewind_.image + g, rewind_.seg[s].len);
+		g += rewind_.seg[s].len;
+	}
+	state_restore(rewind_.work);
+
+	ppu = ppu_getcontext();
+	cpu = nes6502_getcontext();
+	e = &rewind_.ext;
+	ppu->vaddr_latch = e->vaddr_latch;
+	ppu->tile_xofs = e->tile_xofs;
+	ppu->flipflop = e->flipflop;
+	ppu->stat = e->stat;
+	ppu->latch = e->latch;
+	ppu->vdata_latch = e->vdata_latch;
+	ppu->strobe = e->strobe;
+	cpu->int_pending = e->int_pending;
+	cpu->int_latency = e->int_latency;
+	cpu->jammed = e->jammed;
+	cpu->burn_cycles = e->burn_cycles;
+
+	++rewind_.stat.restores;
+}
+
+
+static void evict_(void)
+{
+	rewind_.first = (rewind_.first + 1) % REWIND_RECORDS;
+	--rewind_.num;
+	++rewind_.stat.evicts;
+}
+
+
+int rewind_create(uint32 pool, int interval)
+{
+	nes_t *machine = nes_getcontext();
+	SNSS_FILE *w;
+
+	rewind_destroy();
+
+	if (NULL == machine || NULL == machine->rominfo || 0 == pool)
+		return -1;
+
+	rewind_.work = malloc(sizeof(SNSS_FILE));
+	if (NULL == rewind_.work)
+		return -1;
+	w = rewind_.work;
+	memset(w, 0, sizeof(SNSS_FILE));
+
+	// 区間の大きさは、ROM で決まる（state_capture で一度埋めてから決める）
+	state_capture(w);
+	memset(&rewind_.ext, 0, sizeof(rewind_.ext));
+	add_segment_(&rewind_.ext, sizeof(rewind_.ext));
+	add_segment_(&w->baseBlock, sizeof(w->baseBlock));
+	add_segment_(w->soundBlock.soundRegisters, sizeof(w->soundBlock.soundRegisters));
+	if (machine->mmc->intf->number)
+		add_segment_(&w->mapperBlock, sizeof(w->mapperBlock));
+	if (machine->rominfo->vram && machine->rominfo->vram_banks <= 2)
+		add_segment_(w->vramBlock.vram, w->vramBlock.vramSize);
+	add_segment_(w->sramBlock.sram, w->sramBlock.sramSize);
+
+	// 差分の距離、長さは２バイト
+	if (rewind_.image_len > 0xFFFF)
+	{
+		log_printf("rewind: state too large: %d\n", rewind_.image_len);
+		rewind_destroy();
+		return -1;
+	}
+
+	rewind_.image = malloc(rewind_.image_len);
+	rewind_.pool = malloc(pool);
+	if (NULL == rewind_.image || NULL == rewind_.pool)
+	{
+		rewind_destroy();
+		return -1;
+	}
+	rewind_.pool_size = pool;
+	rewind_.interval = interval > 0 ? interval : 1;
+	rewind_.stat.image = rewind_.image_len;
+
+	rewind_clear();
+	return 0;
+}
+
+
+void rewind_destroy(void)
+{
+	free(rewind_.work);
+	free(rewind_.image);
+	free(rewind_.pool);
+	memset(&rewind_, 0, sizeof(rewind_));
+}
+
+
+void rewind_clear(void)
+{
+	rewind_.valid = false;
+	rewind_.pos = 0;
+	rewind_.first = 0;
+	rewind_.num = 0;
+	rewind_.since = 0;
+}
+
+
+int rewind_frame(void)
+{
+	if (NULL == rewind_.pool)
+		return 0;
+
+	if (++rewind_.since < rewind_.interval)
+		return 0;
+
+	return 0 == rewind_capture();
+}
+
+
+int rewind_capture(void)
+{
+	uint32 len;
+	rewindrec_t *r;
+	int i, n;
+
+	if (NULL == rewind_.pool)
+		return -1;
+
+	capture_();
+	rewind_.since = 0;
+	++rewind_.stat.captures;
+
+	if (false == rewind_.valid)
+	{
+		pack_();
+		rewind_.valid = true;
+		return 0;
+	}
+
+	len = scan_(NULL);
+	if (len > rewind_.pool_size)
+	{
+		// 差分がリングに入らない場合は、これより前には戻れない
+		while (rewind_.num > 0)
+			evict_();
+		rewind_.pos = 0;
+		pack_();
+		return 0;
+	}
+
+	if ((rewind_.pos + len) > rewind_.pool_size)
+		rewind_.pos = 0;
+
+	// 置く場所に重なる差分（の中で最も新しい差分）まで、古い順に捨てる
+	n = 0;
+	for (i = 0; i < rewind_.num; i++)
+	{
+		const rewindrec_t *o = &rewind_.rec[(rewind_.first + i) % REWIND_RECORDS];
+
+		if (o->ofs < (rewind_.pos + len) && rewind_.pos < (o->ofs + o->len))
+			n = i + 1;
+	}
+	if (0 == n && REWIND_RECORDS == rewind_.num)
+		n = 1;
+	while (n--)
+		evict_();
+
+	r = &rewind_.rec[(rewind_.first + rewind_.num) % REWIND_RECORDS];
+	r->ofs = rewind_.pos;
+	r->len = len;
+	++rewind_.num;
+	scan_(rewind_.pool + rewind_.pos);
+	rewind_.pos += len;
+
+	rewind_.stat.bytes += len;
+	rewind_.stat.last = len;
+	if (len > rewind_.stat.peak)
+		rewind_.stat.peak = len;
+
+	return 0;
+}
+
+
+int rewind_back(void)
+{
+	const rewindrec_t *r;
+
+	if (NULL == rewind_.pool || false == rewind_.valid)
+		return -1;
+
+	if (rewind_.since > 0)
+	{
+		rewind_.since = 0;
+		restore_();
+		return 0;
+	}
+
+	if (0 == rewind_.num)
+		return -1;
+
+	--rewind_.num;
+	r = &rewind_.rec[(rewind_.first + rewind_.num) % REWIND_RECORDS];
+	apply_(rewind_.pool + r->ofs, r->len);
+	rewind_.pos = r->ofs;
+	restore_();
+	return 0;
+}
+
+
+int rewind_count(void)
+{
+	if (false == rewind_.valid)
+		return 0;
+
+	return rewind_.num + (rewind_.since > 0 ? 1 : 0);
+}
+
+
+const rewindstat_t *rewind_getstat(void)
+{
+	return &rewind_.stat;
+}
@@ -0,0 +1,113 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	NES 巻き戻し（メモリー上のスナップショット・リング） @n
+			N フレーム毎に、CPU、PPU、APU、マッパーの状態（state_capture）を取り、@n
+			前のスナップショットとの XOR 差分（変化した所だけ）をリングに積む。@n
+			最新のスナップショットは展開して持ち、差分を新しい順に戻して遡る。@n
+			リングが一杯になると、古い差分から捨てる。@n
+			１回のスナップショットの処理は、状態のバイト数に比例（最大でも @n
+			rewind_getstat()->image の２回の比較）で、フレームの中で収まる。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include "nes_std.h"
+
+/// リングの標準サイズ（バイト）
+#ifndef NES_REWIND_POOL
+#define  NES_REWIND_POOL       (48 * 1024)
+#endif
+
+/// スナップショットを取る間隔（フレーム）
+#ifndef NES_REWIND_INTERVAL
+#define  NES_REWIND_INTERVAL   8
+#endif
+
+/// 統計
+typedef struct rewindstat_s
+{
+	uint32 image;			///< スナップショットのバイト数（展開）
+	uint32 captures;		///< スナップショットを取った回数
+	uint32 restores;		///< 戻した回数
+	uint32 bytes;			///< 差分の合計バイト数
+	uint32 last;			///< 最後の差分のバイト数
+	uint32 peak;			///< 最大の差分のバイト数
+	uint32 evicts;			///< リングから捨てた差分の数
+} rewindstat_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	巻き戻しを作成（ROM を入れた後）
+	@param[in]	pool		リングのバイト数
+	@param[in]	interval	スナップショットを取る間隔（フレーム）
+	@return 成功なら「0」
+*/
+//-----------------------------------------------------------------//
+extern int rewind_create(uint32 pool, int interval);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	巻き戻しを廃棄
+*/
+//-----------------------------------------------------------------//
+extern void rewind_destroy(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	スナップショットを全て捨てる（リセット等）
+*/
+//-----------------------------------------------------------------//
+extern void rewind_clear(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	フレーム毎に呼ぶ（間隔毎にスナップショットを取る）
+	@return スナップショットを取った場合「1」
+*/
+//-----------------------------------------------------------------//
+extern int rewind_frame(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	スナップショットを取る
+	@return 成功なら「0」
+*/
+//-----------------------------------------------------------------//
+extern int rewind_capture(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	一つ前のスナップショットに戻す @n
+			最新のスナップショットの後にフレームを進めていれば、最新のスナップショット @n
+			に戻す（続けて呼ぶと、さらに前に戻る）
+	@return 成功なら「0」（戻れない場合「-1」）
+*/
+//-----------------------------------------------------------------//
+extern int rewind_back(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	戻れるスナップショットの数を取得
+	@return スナップショットの数
+*/
+//-----------------------------------------------------------------//
+extern int rewind_count(void);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	統計を取得
+	@return 統計
+*/
+//-----------------------------------------------------------------//
+extern const rewindstat_t *rewind_getstat(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include "nes_rom.h"
+#include "nes_bank.h"
 #include "nes_mmc.h"
 #include "nes_ppu.h"
 #include "nes.h"
@@ -140,47 +141,35 @@ static int rom_allocsram(rominfo_t *rominfo)
 }
 
 /* If there's a trainer, load it in at $7000 */
-static const uint8_t *rom_loadtrainer(const uint8_t *rom, rominfo_t *rominfo)
+static long rom_loadtrainer(FILE *fp, long pos, rominfo_t *rominfo)
 {
-	ASSERT(rom);
+	ASSERT(fp);
 	ASSERT(rominfo);
 
 	if(rominfo->flags & ROM_FLAG_TRAINER) {
-//		fread(rominfo->sram + TRAINER_OFFSET, TRAINER_LENGTH, 1, fp);
-		memcpy(rominfo->sram + TRAINER_OFFSET, rom, TRAINER_LENGTH);
-		rom += TRAINER_LENGTH;
+		if(fread(rominfo->sram + TRAINER_OFFSET, 1, TRAINER_LENGTH, fp) != TRAINER_LENGTH) {
+			log_printf("Read error trainer\n");
+		}
+		pos += TRAINER_LENGTH;
 		log_printf("Read in trainer at $7000\n");
 	}
-	return rom;
+	return pos;
 }
 
-static int rom_loadrom(const uint8_t *rom, rominfo_t *rominfo)
+// PRG/CHR は、バンク・キャッシュが必要な時に読み込む（ファイルはキャッシュが閉じる）
+static int rom_loadrom(FILE *fp, long pos, rominfo_t *rominfo)
 {
-	ASSERT(rom);
+	ASSERT(fp);
 	ASSERT(rominfo);
 
-	/* Allocate ROM space, and load it up! */
-	rominfo->rom = malloc(rominfo->rom_banks * ROM_BANK_LENGTH);
-	if (NULL == rominfo->rom)
-	{
-		log_printf("Could not allocate space for ROM image");
+	if(bank_create(fp, pos, rominfo->rom_banks * (ROM_BANK_LENGTH / BANK_PRG_SIZE),
+		pos + (long)rominfo->rom_banks * ROM_BANK_LENGTH,
+		rominfo->vrom_banks * (VROM_BANK_LENGTH / BANK_CHR_SIZE))) {
 		return -1;
 	}
-///	_fread(rominfo->rom, ROM_BANK_LENGTH, rominfo->rom_banks, fp);
-	memcpy(rominfo->rom, rom, rominfo->rom_banks * ROM_BANK_LENGTH);
-	rom += ROM_BANK_LENGTH * rominfo->rom_banks;
-
-	/* If there's VROM, allocate and stuff it in */
-	if(rominfo->vrom_banks) {
-		rominfo->vrom = malloc(rominfo->vrom_banks * VROM_BANK_LENGTH);
-		if (NULL == rominfo->vrom)
-		{
-			log_printf("Could not allocate space for VROM");
-			return -1;
-		}
-///		_fread(rominfo->vrom, VROM_BANK_LENGTH, rominfo->vrom_banks, fp);
-		memcpy(rominfo->vrom, rom, rominfo->vrom_banks * VROM_BANK_LENGTH);
-	} else {
+
+	/* If there's no VROM, allocate VRAM */
+	if(0 == rominfo->vrom_banks) {
 		rominfo->vram = malloc(VRAM_LENGTH);
 		if(NULL == rominfo->vram) {
 			log_printf("Could not allocate space for VRAM");
@@ -427,37 +416,26 @@ rominfo_t *rom_load(const char *filename)
 
 	{
 		char id[4];
-		if(fread(id, 1, 4, fp) != 4) {
-			return NULL;
-		}
-		if(memcmp(id, ROM_INES_MAGIC, 4) != 0) {
+		if(fread(id, 1, 4, fp) != 4 || memcmp(id, ROM_INES_MAGIC, 4) != 0) {
+			fclose(fp);
 			return NULL;
 		}
 	}
 
-	fseek(fp, 0, SEEK_END);
-	long sz = ftell( fp );
- 	uint8_t *rom = (uint8_t *)malloc(sz);
-	if(rom == NULL) {
-		return NULL;
-	}
-
+	/* ROM 全体は読まない、ヘッダー（とトレーナー）だけ */
+	uint8_t head[sizeof(inesheader_t)];
 	fseek(fp, 0, SEEK_SET);
-
-	if(fread(rom, 1, sz, fp) != sz) {
-		free(rom);
+	if(fread(head, 1, sizeof(head), fp) != sizeof(head)) {
 		fclose(fp);
-		log_printf("Read error ROM file: %s (%ld)\n", filename, sz);
+		log_printf("Read error ROM file: %s\n", filename);
 		return NULL;
 	}
 
-	fclose(fp);
-
-
 	rominfo_t *rominfo;
 
 	rominfo = malloc(sizeof(rominfo_t));
 	if(NULL == rominfo) {
+		fclose(fp);
 		return NULL;
 	}
 	memset(rominfo, 0, sizeof(rominfo_t));
@@ -465,12 +443,8 @@ rominfo_t *rom_load(const char *filename)
 	strncpy(rominfo->filename, filename, PATH_MAX);
 
 	/* Get the header and stick it into rominfo struct */
-	const uint8_t *bin = rom;
-	{
-		bin = rom_getheader(bin, rominfo);
-		if(bin == NULL) {
-   	 	goto _fail;
-		}
+	if(rom_getheader(head, rominfo) == NULL) {
+		goto _fail;
 	}
 
 	/* Make sure we really support the mapper */
@@ -487,9 +461,10 @@ rominfo_t *rom_load(const char *filename)
 		goto _fail;
 	}
 	
-	bin = rom_loadtrainer(bin, rominfo);
 	{
-		int ret = rom_loadrom(bin, rominfo);
+		long pos = rom_loadtrainer(fp, sizeof(head), rominfo);
+		int ret = rom_loadrom(fp, pos, rominfo);
+		fp = NULL;
 		if (ret != 0) {
       		goto _fail;
 		}
@@ -501,12 +476,12 @@ rominfo_t *rom_load(const char *filename)
 	rom_checkforpal(rominfo);
 	log_printf("ROM loaded: %s", rom_getinfo(rominfo));
 
-	free(rom);
-
 	return rominfo;
 
 _fail:
-	free(rom);
+	if(fp != NULL) {
+		fclose(fp);
+	}
 	rom_free(rominfo);
 	return NULL;
 }
@@ -520,10 +495,9 @@ void rom_free(rominfo_t *rominfo)
 
 	rom_savesram(rominfo);
 
-	free(rominfo->rom);
+	bank_destroy();
 	free(rominfo->sram);
 	free(rominfo->vram);
-	free(rominfo->vrom);
 
 	free(rominfo);
 }
@@ -39,8 +39,7 @@ typedef enum
 
 typedef struct rominfo_s
 {
-	uint8_t *rom;
-	uint8_t *vrom;
+	/* PRG/CHR ROM は、バンク・キャッシュ（nes_bank.h）から */
 
 	/* pointers to SRAM and VRAM */
 	uint8_t *sram;
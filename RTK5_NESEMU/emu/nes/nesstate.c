@@ -30,6 +30,7 @@
 #include "log.h"
 #include "libsnss.h"
 #include "nes6502.h"
+#include "nes_bank.h"
 
 #define  FIRST_STATE_SLOT  0
 #define  LAST_STATE_SLOT   9
@@ -189,12 +190,12 @@ static int save_mapperblock(nes_t *state, SNSS_FILE *snssFile)
 
    /* TODO: snss spec should be updated, using 4kB ROM pages.. */
    for (i = 0; i < 4; i++)
-      snssFile->mapperBlock.prgPages[i] = (state->cpu->mem_page[(i + 4) * 2] - state->rominfo->rom) >> 13;
+      snssFile->mapperBlock.prgPages[i] = bank_getmapped(BANK_PRG, i);
 
    if (state->rominfo->vrom_banks)
    {
       for (i = 0; i < 8; i++)
-         snssFile->mapperBlock.chrPages[i] = (ppu_getpage(i) - state->rominfo->vrom + (i * 0x400)) >> 10;
+         snssFile->mapperBlock.chrPages[i] = bank_getmapped(BANK_CHR, i);
    }
    else
    {
@@ -260,6 +261,7 @@ static void load_vramblock(nes_t *state, SNSS_FILE *snssFile)
 
    ASSERT(snssFile->vramBlock.vramSize <= VRAM_8K); /* can't handle more than this! */
    memcpy(state->rominfo->vram, snssFile->vramBlock.vram, snssFile->vramBlock.vramSize);
+   ppu_flushtiles();
 }
 
 static void load_sramblock(nes_t *state, SNSS_FILE *snssFile)
@@ -317,6 +319,49 @@ static void load_mapperblock(nes_t *state, SNSS_FILE *snssFile)
 }
 
 
+void state_capture(SNSS_FILE *snssFile)
+{
+	nes_t *machine = nes_getcontext();
+	int sram_banks;
+
+	ASSERT(machine);
+
+	save_baseblock(machine, snssFile);
+	save_vramblock(machine, snssFile);
+
+	/* SRAM は、書いていなくても保存する（前の状態を残さない） */
+	sram_banks = machine->rominfo->sram_banks;
+	if (sram_banks > 8)
+		sram_banks = 8;
+	snssFile->sramBlock.sramSize = SRAM_1K * sram_banks;
+	snssFile->sramBlock.sramEnabled = true;
+	if (machine->rominfo->sram)
+		memcpy(snssFile->sramBlock.sram, machine->rominfo->sram, snssFile->sramBlock.sramSize);
+
+	save_soundblock(machine, snssFile);
+	save_mapperblock(machine, snssFile);
+}
+
+void state_restore(SNSS_FILE *snssFile)
+{
+	nes_t *machine = nes_getcontext();
+
+	ASSERT(machine);
+
+	/* state_save と同じ順番 */
+	load_baseblock(machine, snssFile);
+	if (machine->rominfo->vram)
+		load_vramblock(machine, snssFile);
+	if (machine->rominfo->sram && snssFile->sramBlock.sramSize)
+		load_sramblock(machine, snssFile);
+	load_soundblock(machine, snssFile);
+	/* load_soundblock は $4015 を書かないので、チャネルの有効／無効を戻す */
+	apu_write(0x4015, snssFile->soundBlock.soundRegisters[0x15]);
+	if (machine->mmc->intf->number)
+		load_mapperblock(machine, snssFile);
+}
+
+
 int state_save(void)
 {
    SNSS_FILE *snssFile;
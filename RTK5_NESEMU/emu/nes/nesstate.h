@@ -24,6 +24,7 @@
 ** $Id: nesstate.h,v 1.2 2001/04/27 14:37:11 neil Exp $
 */
 #include "nes.h"
+#include "libsnss.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,23 @@ extern void state_setslot(int slot);
 extern int state_load();
 extern int state_save();
 
+//-----------------------------------------------------------------//
+/*!
+	@brief	メモリー上の SNSS ブロック（BASR、VRAM、SRAM、SOUN、MPRD）に、@n
+			マシンの状態を保存（ファイルは使わない、巻き戻し用）
+	@param[out]	snssFile	保存先（fp は使わない）
+*/
+//-----------------------------------------------------------------//
+extern void state_capture(SNSS_FILE *snssFile);
+
+//-----------------------------------------------------------------//
+/*!
+	@brief	state_capture で保存した状態を戻す
+	@param[in]	snssFile	保存した状態
+*/
+//-----------------------------------------------------------------//
+extern void state_restore(SNSS_FILE *snssFile);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -105,7 +105,8 @@ namespace {
 	typedef device::dac_out<DAC> DAC_OUT;
 	DAC_OUT		dac_out_;
 
-	typedef utils::sound_out<1024, 512> SOUND_OUT;
+	// FIFO は、描画が垂直同期２回分掛かっても途切れない大きさ（nesemu のペース調整）
+	typedef utils::sound_out<2048, 512> SOUND_OUT;
 	SOUND_OUT	sound_out_;
 
 	class tpu_task {
@@ -206,7 +207,12 @@ namespace {
 	void update_nesemu_()
 	{
 		void* org = reinterpret_cast<void*>(0x00000000);
-		nesemu_.service(org, glcdc_io_.get_xsize(), glcdc_io_.get_ysize());
+		// SELECT + LEFT を押している間、巻き戻す
+		nesemu_.rewind(chip::on(fami_pad_data_, chip::FAMIPAD_ST::SELECT)
+			&& chip::on(fami_pad_data_, chip::FAMIPAD_ST::LEFT));
+		// FIFO の残りで、描画を省くか決める（オーディオを途切れさせない）
+		nesemu_.service(org, glcdc_io_.get_xsize(), glcdc_io_.get_ysize(),
+			sound_out_.at_fifo().length(), sound_out_.at_fifo().size());
 
 		uint32_t len = nesemu_.get_audio_len();
 		const uint16_t* wav = nesemu_.get_audio_buf();
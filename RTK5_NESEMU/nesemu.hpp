@@ -13,6 +13,8 @@
 #include "emu/nes/nesinput.h"
 #include "emu/nes/nesstate.h"
 #include "emu/nes/nes_pal.h"
+#include "emu/nes/nes_bank.h"
+#include "emu/nes/nes_rewind.h"
 
 #include "chip/FAMIPAD.hpp"
 
@@ -41,15 +43,46 @@ namespace emu {
         static const int sample_rate_ = 22050;
 		static const int sample_bits_ = 16;
 		static const int audio_len_ = (sample_rate_ / 60) + 1;
+		static const int frames_max_ = 3;	///< 遅れた場合に、１回のサービスでエミュレートする最大フレーム数
 
-		uint16_t		audio_buf_[audio_len_];
+	public:
+		//=================================================================//
+		/*!
+			@brief  フレームの統計
+		*/
+		//=================================================================//
+		struct stat_t {
+			uint32_t	frames;		///< エミュレートしたフレーム数
+			uint32_t	drawn;		///< 描画したフレーム数
+			uint32_t	catch_up;	///< 追いつく為に、複数フレーム進めた回数
+			uint32_t	lut_build;	///< RGB565 変換テーブルを作った回数
+			stat_t() : frames(0), drawn(0), catch_up(0), lut_build(0) { }
+		};
+
+	private:
+		uint16_t		audio_buf_[audio_len_ * frames_max_];
+		uint32_t		audio_num_;
+
+		uint16_t		lut_[256];		///< RGB565 変換テーブル
+		uint32_t		lut_serial_;	///< テーブルを作った時のパレット番号
+		bool			lut_ok_;
+
+		bool			drawn_;			///< 前のサービスで描画した（vidbuf が新しい）
+		uint32_t		skip_;			///< 連続して描画を省いたフレーム数
+		uint32_t		fifo_last_;		///< 前のサービスの時の FIFO の残り
+		uint32_t		draw_need_;		///< 描画した時に、次のサービスまでに減るサンプル数
+
+		stat_t			stat_;
 
 //		emu::nsfplay	nsfplay_;
 
 		bool			nesrom_;
+		bool			rewind_;		///< 巻き戻し中
 
 		uint32_t		delay_;
 
+		static const int bank_prefetch_ = 1;	///< １フレームで先読みするバンク数
+
 		nesinput_t		inp_[2];
 
 	public:
@@ -58,7 +91,9 @@ namespace emu {
 			@brief  コンストラクタ
 		*/
 		//-----------------------------------------------------------------//
-		nesemu() noexcept : nesrom_(false), delay_(120) { }
+		nesemu() noexcept : audio_num_(audio_len_), lut_serial_(0), lut_ok_(false),
+			drawn_(false), skip_(0), fifo_last_(0), draw_need_(audio_len_),
+			nesrom_(false), rewind_(false), delay_(120) { }
 
 
 		//-----------------------------------------------------------------//
@@ -95,6 +130,8 @@ namespace emu {
 		{
 			if(nes_insert_cart(filename) == 0) {
 				nesrom_ = true;
+				// メモリーが足りない場合は、巻き戻し無しで動かす
+				rewind_create(NES_REWIND_POOL, NES_REWIND_INTERVAL);
 			}
 			return nesrom_;
 		}
@@ -108,6 +145,7 @@ namespace emu {
 		void close()
 		{
 			if(nesrom_) {
+				rewind_destroy();
 				nes_eject_cart();
 				nesrom_ = false;
 			}
@@ -120,9 +158,11 @@ namespace emu {
 			@param[in]	org		フレームバッファのアドレス
 			@param[in]	xs		フレームバッファのＸ幅
 			@param[in]	ys		フレームバッファのＹ幅
+			@param[in]	fifo_len	オーディオ FIFO に溜まっているサンプル数
+			@param[in]	fifo_size	オーディオ FIFO の大きさ（「0」ならペース調整をしない）
 		*/
 		//-----------------------------------------------------------------//
-		void service(void* org, uint32_t xs, uint32_t ys)
+		void service(void* org, uint32_t xs, uint32_t ys, uint32_t fifo_len = 0, uint32_t fifo_size = 0)
 		{
 			if(delay_ > 0) {
 				--delay_;
@@ -135,17 +175,27 @@ namespace emu {
 //					open("Dragon_Quest2_fix.nes");
 //					open("Solstice_J.nes");
 
-// メモリー不足で動作しない・・
+// バンク・キャッシュ（emu/nes/nes_bank.h）で、大きな ROM も動作する
 //					open("Zombie.nes");
 // メモリーマッパーが未対応
 //					open("High_Speed_E.nes");
 				}
 			}
 
+			// 前のサービスから減ったサンプル数（描画した場合、描画に掛かる時間）
+			if(fifo_size > 0) {
+				uint32_t used = fifo_last_ + audio_num_;
+				used = used > fifo_len ? used - fifo_len : 0;
+				if(drawn_) {
+					draw_need_ = used > static_cast<uint32_t>(audio_len_) ? used : audio_len_;
+				}
+				fifo_last_ = fifo_len;
+			}
+			audio_num_ = audio_len_;
+
 			auto nes = nes_getcontext();
 			bitmap_t* v = nes->vidbuf;
-			const rgb_t* lut = get_palette();
-			if(v == nullptr || lut == nullptr) {
+			if(v == nullptr) {
 				return;
 			}
 
@@ -179,49 +229,102 @@ namespace emu {
 				}
 			}
 
-			uint16_t luttmp[256];
-			for(uint32_t i = 0; i < 64; ++i) {
-               	uint16_t r = lut[i].r;  // R
-				uint16_t g = lut[i].g;  // G
-				uint16_t b = lut[i].b;  // B
-				// R(5), G(6), B(5)
-				luttmp[i] = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
-				luttmp[i+128+64] = luttmp[i+128] = luttmp[i+64] = luttmp[i];
+			// パレットが変わった時だけ、RGB565 変換テーブルを作る
+			uint32_t serial;
+			const rgb_t* pal = ppu_getpal(&serial);
+			if(!lut_ok_ || serial != lut_serial_) {
+				for(uint32_t i = 0; i < 64; ++i) {
+					uint16_t r = pal[i].r;  // R
+					uint16_t g = pal[i].g;  // G
+					uint16_t b = pal[i].b;  // B
+					// R(5), G(6), B(5)
+					lut_[i] = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+					lut_[i+128+64] = lut_[i+128] = lut_[i+64] = lut_[i];
+				}
+				lut_serial_ = serial;
+				lut_ok_ = true;
+				++stat_.lut_build;
 			}
-			uint16_t* dst = static_cast<uint16_t*>(org);
-			dst += ((ys - (nes_height_ - 16)) / 2) * xs;
-			const uint8_t* src = v->data;
-			src += v->pitch * 16;
-			for(int h = 0; h < (nes_height_ - 16); ++h) {
-				uint16_t* tmp = dst;
-				tmp += (xs - nes_width_) / 2;
-				for(int w = 0; w < nes_width_ / 16; ++w) {
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
-					*tmp++ = luttmp[*src++]; *tmp++ = luttmp[*src++];
+
+			// 描画を省いたフレームの vidbuf は古いので、変換しない
+			if(drawn_) {
+				uint16_t* dst = static_cast<uint16_t*>(org);
+				dst += ((ys - (nes_height_ - 16)) / 2) * xs;
+				const uint8_t* src = v->data;
+				src += v->pitch * 16;
+				for(int h = 0; h < (nes_height_ - 16); ++h) {
+					uint16_t* tmp = dst;
+					tmp += (xs - nes_width_) / 2;
+					for(int w = 0; w < nes_width_ / 16; ++w) {
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+						*tmp++ = lut_[*src++]; *tmp++ = lut_[*src++];
+					}
+					src += v->pitch - nes_width_;
+					dst += xs;
 				}
-				src += v->pitch - nes_width_;
-				dst += xs;
+				drawn_ = false;
 			}
+
 			if(nesrom_) {
-				apu_process(audio_buf_, audio_len_);
-				nes_emulate(1);
+				// 巻き戻し中は、サービス毎に一つ前のスナップショットに戻して、１フレーム描画する
+				bool back = rewind_ && rewind_back() == 0;
+
+				// オーディオ FIFO の残りでペースを決める：
+				// 描画した時に減る分（＋１フレーム）より少なければ、描画を省き、
+				// FIFO に入る範囲でフレームを進めて（オーディオを複数フレーム分作って）追いつく
+				uint32_t n = 1;
+				bool draw = true;
+				if(!back && fifo_size > 0 && fifo_len < (draw_need_ + audio_len_) && skip_ < NES_SKIP_LIMIT) {
+					draw = false;
+					while(n < static_cast<uint32_t>(frames_max_)
+						&& (fifo_len + (n + 1) * audio_len_) <= fifo_size) {
+						++n;
+					}
+					if(n > 1) ++stat_.catch_up;
+				}
+				for(uint32_t i = 0; i < n; ++i) {
+					apu_process(&audio_buf_[audio_len_ * i], audio_len_);
+					nes_emulate_frame(draw && i == (n - 1));
+					if(!back) rewind_frame();
+				}
+				audio_num_ = audio_len_ * n;
+				stat_.frames += n;
+				if(draw) {
+					++stat_.drawn;
+					skip_ = 0;
+				} else {
+					skip_ += n;
+				}
+				drawn_ = draw;
+				// フレームの残り時間で、マッパーのヒントを先読み
+				bank_service(bank_prefetch_);
 			}
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  オーディオ・バッファの長さを取得
+			@brief  巻き戻しの開始、停止 @n
+					開始している間、サービス毎に NES_REWIND_INTERVAL フレーム戻る
+			@param[in]	on	巻き戻す場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		void rewind(bool on) noexcept { rewind_ = on; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  オーディオ・バッファの長さを取得（追いつく場合、複数フレーム分）
 			@return オーディオ・バッファの長さ
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t get_audio_len() const noexcept { return audio_len_; }
+		uint32_t get_audio_len() const noexcept { return audio_num_; }
 
 
 		//-----------------------------------------------------------------//
@@ -231,6 +334,15 @@ namespace emu {
 		*/
 		//-----------------------------------------------------------------//
 		const uint16_t* get_audio_buf() const noexcept { return audio_buf_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  フレームの統計を取得
+			@return フレームの統計
+		*/
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat() const noexcept { return stat_; }
 	};
 }
 
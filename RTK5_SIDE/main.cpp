@@ -363,14 +363,7 @@ int main(int argc, char** argv)
 
 			SPINV::SND_MGR& snd = spinv_.at_sound();
 			uint32_t len = snd.get_length();
-			const int16_t* wav = snd.get_buffer();
-			for(uint32_t i = 0; i < len; ++i) {
-				while((sound_out_.at_fifo().size() - sound_out_.at_fifo().length()) < 8) {
-				}
-				sound::wave_t t;
-				t.l_ch = t.r_ch = *wav++;
-				sound_out_.at_fifo().put(t);
-			}
+			sound_out_.put(snd.get_buffer(), len);
 		}
 
 		sdc_.service(sdh_.service());
@@ -19,9 +19,10 @@
 */
 #include "arcade.h"
 
-InvadersMachine::InvadersMachine()
+InvadersMachine::InvadersMachine( bool legacy )
+    : core_( *this )
 {
-    cpu_ = new I8080( *this );
+    cpu_ = legacy ? new I8080( *this ) : 0;
     reset();
     memset( ram_, 0, 0x2000 );  // Clear the ROM area
     setFrameRate( 60 );
@@ -32,11 +33,6 @@ InvadersMachine::~InvadersMachine()
     delete cpu_;
 }
 
-unsigned char InvadersMachine::readByte( unsigned addr ) 
-{
-    return addr < sizeof(ram_) ? ram_[addr] : 0xFF;
-}
-
 unsigned char InvadersMachine::readPort( unsigned port ) 
 {
     unsigned char   b = 0;
@@ -88,26 +84,19 @@ void InvadersMachine::writePort( unsigned addr, unsigned char b )
     }
 }
 
-void InvadersMachine::writeByte( unsigned addr, unsigned char b )
+void InvadersMachine::writeVideo( unsigned addr, unsigned char b )
 {
-    if( addr < 0x2000 || addr >= 0x4000 )
-        return;
-
-    ram_[addr] = b;
-
-    if( addr >= 0x2400 ) {
-        // This is a write to video memory. Since the video screen is rotated, 
-        // consecutive bits correspond to vertically consecutive pixels.
-        // This is accounted for in the following code, and an extra buffer
-        // is used to store the video memory in a more useable form.
-		unsigned k, y;
-
-		addr -= 0x2400;
-		y = ((255 - ((addr & 0x1F) * 8) )*224) + (addr / 32);
-        for( k=1; k<=128; k<<=1 ) {
-            video_[y] = b & k;
-			y -= ScreenWidth;
-        }
+    // This is a write to video memory. Since the video screen is rotated, 
+    // consecutive bits correspond to vertically consecutive pixels.
+    // This is accounted for in the following code, and an extra buffer
+    // is used to store the video memory in a more useable form.
+	unsigned k, y;
+
+	addr -= 0x2400;
+	y = ((255 - ((addr & 0x1F) * 8) )*224) + (addr / 32);
+    for( k=1; k<=128; k<<=1 ) {
+        video_[y] = b & k;
+		y -= ScreenWidth;
     }
 }
 
@@ -117,7 +106,8 @@ void InvadersMachine::reset( int ships, int easy )
     if( ships < 3 || ships > 6 ) ships = 3;
 
     // Reset the CPU and the other machine settings
-    cpu_->reset();
+    if( cpu_ ) cpu_->reset();
+    core_.reset();
     port1_ = 0;
     port2i_ = (ships - 3) & 0x03;   // DIP switches
     port2o_ = 0;
@@ -143,15 +133,41 @@ void InvadersMachine::step()
 
     // Before a frame is fully rendered, two interrupts have to occur
     for( int i=0; i<2; i++ ) {
-        // Go on until an interrupt occurs
-        while( cpu_->getCycles() < cycles_per_interrupt_ )
-            cpu_->step();
+        if( cpu_ ) {
+            // Go on until an interrupt occurs
+            while( cpu_->getCycles() < cycles_per_interrupt_ )
+                cpu_->step();
 
-        // Adjust the cycles count
-        cpu_->setCycles( cpu_->getCycles() - cycles_per_interrupt_ );
+            // Adjust the cycles count
+            cpu_->setCycles( cpu_->getCycles() - cycles_per_interrupt_ );
     
-        // Call the proper interrupt
-        cpu_->interrupt( i ? 0x10 : 0x08 );
+            // Call the proper interrupt
+            cpu_->interrupt( i ? 0x10 : 0x08 );
+        }
+        else {
+            // Same as above, the registers are kept in locals until the interrupt
+            core_.exec( cycles_per_interrupt_ );
+            core_.setCycles( core_.getCycles() - cycles_per_interrupt_ );
+            core_.interrupt( i ? 0x10 : 0x08 );
+        }
+    }
+}
+
+void InvadersMachine::getCpuState( CpuState & s ) const
+{
+    if( cpu_ ) {
+        s.B = cpu_->B; s.C = cpu_->C; s.D = cpu_->D; s.E = cpu_->E;
+        s.H = cpu_->H; s.L = cpu_->L; s.A = cpu_->A; s.F = cpu_->F;
+        s.PC = cpu_->PC;
+        s.SP = cpu_->SP;
+        s.cycles = cpu_->getCycles();
+    }
+    else {
+        s.B = core_.B; s.C = core_.C; s.D = core_.D; s.E = core_.E;
+        s.H = core_.H; s.L = core_.L; s.A = core_.A; s.F = core_.F;
+        s.PC = core_.PC;
+        s.SP = core_.SP;
+        s.cycles = core_.getCycles();
     }
 }
 
@@ -23,13 +23,16 @@
 #include <string.h>
 
 #include "i8080.h"
+#include "i8080_core.hpp"
 
 /**
     Space Invaders arcade machine emulator.
 
     This class emulates in software the original Space Invaders arcade machine. It uses
-    the I8080 emulator to emulate the CPU and extends the I8080Environment to provide
-    the required functions to the CPU emulation.
+    the emu::i8080_core emulator to emulate the CPU and extends the I8080Environment to provide
+    the required functions to the CPU emulation. The memory functions are final and inline,
+    so the core calls them directly. The original I8080 emulator can still be selected
+    in the constructor (it is used as a reference by the regression test in side_bench).
 
     For portability, this class does not make direct use of functions that may depend
     on a specific system, such as sound and video. However, it does provide access to
@@ -82,8 +85,21 @@ public:
     };
 
 public:
-    /** Constructor. */
-    InvadersMachine();
+    /** CPU state, used to compare the two CPU emulators. */
+    struct CpuState {
+        unsigned char   B, C, D, E, H, L, A, F;
+        unsigned        PC;
+        unsigned        SP;
+        unsigned        cycles;
+    };
+
+public:
+    /**
+        Constructor.
+
+        @param  legacy  use the original I8080 emulator instead of emu::i8080_core if true
+    */
+    InvadersMachine( bool legacy = false );
 
     /** Destructor. */
     virtual ~InvadersMachine();
@@ -217,17 +233,45 @@ public:
         memcpy( ram_, rom, 0x2000 );
     }
 
+    /**
+        Returns a pointer to the machine memory (16K, ROM at 0x0000, RAM at 0x2000).
+    */
+    const unsigned char * getRAM() const {
+        return ram_;
+    }
+
+    /**
+        Returns the state of the CPU emulator in use.
+
+        @param  s   receives the registers and the cycles count
+    */
+    void getCpuState( CpuState & s ) const;
+
 protected:
+    friend class emu::i8080_core<InvadersMachine>;
+
     // Implementation of the CpuEnvironment interface
-    unsigned char readByte( unsigned addr );
+    unsigned char readByte( unsigned addr ) final {
+        return addr < sizeof(ram_) ? ram_[addr] : 0xFF;
+    }
+
+    void writeByte( unsigned addr, unsigned char b ) final {
+        if( addr < 0x2000 || addr >= 0x4000 )
+            return;
 
-    void writeByte( unsigned, unsigned char );
+        ram_[addr] = b;
 
-    unsigned char readPort( unsigned port );
+        if( addr >= 0x2400 )
+            writeVideo( addr, b );
+    }
 
-    void writePort( unsigned, unsigned char );
+    unsigned char readPort( unsigned port ) final;
+
+    void writePort( unsigned, unsigned char ) final;
 
 private:
+    void writeVideo( unsigned addr, unsigned char b );
+
     unsigned char   port1_;
     unsigned char   port2i_;    // Port 2 in
     unsigned char   port2o_;    // Port 2 out
@@ -240,7 +284,8 @@ private:
     unsigned        sounds_;
     unsigned        fps_;
     unsigned        cycles_per_interrupt_;
-    I8080 *         cpu_;
+    I8080 *         cpu_;       // Original emulator (only if selected)
+    emu::i8080_core<InvadersMachine>    core_;
 };
 
 #endif // ARCADE_H_
@@ -0,0 +1,1280 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	i8080 CPU コア（switch ディスパッチ、インライン・メモリー・アクセス） @n
+			I8080（i8080.cpp）と、命令、フラグ、サイクル数、PC、SP の扱いが @n
+			全て同じ（CALL C が、条件不成立でオペランドを飛ばさない等の癖も同じ） @n
+			なので、置き換えても、フレーム単位で同じ状態になる。@n
+			・命令は、一つの switch でディスパッチし、exec の中では @n
+			  レジスターをローカル変数に置く。@n
+			・メモリー、ポートは、ENV の readByte、writeByte、readPort、writePort を @n
+			  直接呼ぶ（ENV の関数を final、又は、非仮想にすると、インライン展開される）。@n
+			・INR、DCR、論理演算、DAA のフラグはテーブルで求める。@n
+			ENV は、I8080Environment と同じ名前の関数を持つクラス（RTK5_SIDE の @n
+			InvadersMachine、rx64m_SIDE でも、ENV を用意すれば、そのまま使える）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace emu {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  i8080 CPU コア・クラス（I8080 と同じインターフェース）
+		@param[in]	ENV	メモリー、ポートの環境クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class ENV>
+	class i8080_core {
+	public:
+		enum Flags : uint8_t {
+			Carry     = 0x01,
+			AddSub    = 0x02,
+			Parity    = 0x04,	///< オーバーフローと兼用
+			Flag3     = 0x08,
+			HalfCarry = 0x10,
+			Flag5     = 0x20,
+			Interrupt = Flag5,
+			Zero      = 0x40,
+			Sign      = 0x80
+		};
+
+		uint8_t		B;
+		uint8_t		C;
+		uint8_t		D;
+		uint8_t		E;
+		uint8_t		H;
+		uint8_t		L;
+		uint8_t		A;
+		uint8_t		F;
+		uint32_t	PC;
+		uint32_t	SP;		///< I8080 と同じく、PUSH、POP、CALL、RET ではマスクしない
+
+	private:
+		ENV&		env_;
+		uint32_t	cycles_;
+		uint8_t		halted_;
+
+		static const uint8_t cyc_[256];
+		static const uint8_t szp_[256];
+		static const uint8_t inr_tbl_[256];
+		static const uint8_t dcr_tbl_[256];
+
+		static uint32_t hl_(uint8_t h, uint8_t l) { return (static_cast<uint32_t>(h) << 8) | l; }
+
+		uint32_t word_(uint32_t& pc)
+		{
+			uint32_t t = env_.readByte(pc) | (static_cast<uint32_t>(env_.readByte(pc + 1)) << 8);
+			pc += 2;
+			return t;
+		}
+
+		void call_(uint32_t& pc, uint32_t& sp, uint32_t adr)
+		{
+			sp -= 2;
+			env_.writeByte(sp, pc & 0xFF);
+			env_.writeByte(sp + 1, (pc >> 8) & 0xFF);
+			pc = adr & 0xFFFF;
+		}
+
+		void ret_(uint32_t& pc, uint32_t& sp)
+		{
+			pc = env_.readByte(sp) | (static_cast<uint32_t>(env_.readByte(sp + 1)) << 8);
+			sp += 2;
+		}
+
+		static uint8_t inr_(uint8_t& f, uint8_t v)
+		{
+			++v;
+			f = (f & (Carry | Flag3 | Flag5)) | inr_tbl_[v];
+			return v;
+		}
+
+		static uint8_t dcr_(uint8_t& f, uint8_t v)
+		{
+			--v;
+			f = (f & (Carry | AddSub | Flag3 | Flag5)) | dcr_tbl_[v];
+			return v;
+		}
+
+		static void add_(uint8_t& a, uint8_t& f, uint8_t op, uint8_t cf)
+		{
+			uint32_t x = a + op + (cf ? 1 : 0);
+			f = (f & (Flag3 | Flag5)) | (szp_[x & 0xFF] & (Sign | Zero)) | (x >> 8)
+				| ((a ^ op ^ x) & HalfCarry) | ((~(a ^ op) & (x ^ op) & 0x80) >> 5);
+			a = x;
+		}
+
+		static uint8_t sub_(uint8_t a, uint8_t& f, uint8_t op, uint8_t cf)
+		{
+			uint8_t x = a - op - (cf ? 1 : 0);
+			// キャリー（ボロー）は、I8080 と同じ条件
+			f = AddSub | (f & (Flag3 | Flag5)) | (szp_[x] & (Sign | Zero))
+				| ((x >= a && (op | cf)) ? Carry : 0)
+				| ((a ^ op ^ x) & HalfCarry) | (((a ^ op) & (x ^ a) & 0x80) >> 5);
+			return x;
+		}
+
+		static void dad_(uint8_t& f, uint8_t& h, uint8_t& l, uint32_t rp)
+		{
+			uint32_t hl = hl_(h, l);
+			uint32_t x = hl + rp;
+			f &= (Flag3 | Flag5 | Sign | Zero | Parity);
+			if(x > 0xFFFF) f |= Carry;
+			if(((hl & 0xFFF) + (rp & 0xFFF)) > 0xFFF) f |= HalfCarry;
+			l = x & 0xFF;
+			h = (x >> 8) & 0xFF;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	env	メモリー、ポートの環境
+		*/
+		//-----------------------------------------------------------------//
+		i8080_core(ENV& env) noexcept : env_(env) { reset(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  リセット
+		*/
+		//-----------------------------------------------------------------//
+		void reset() noexcept
+		{
+			B = 0;
+			C = 0;
+			D = 0;
+			E = 0;
+			H = 0;
+			L = 0;
+			A = 0;
+			F = 0;
+			PC = 0;
+			SP = 0xF000;
+			halted_ = 0;
+			cycles_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サイクル数が limit に達するまで実行
+			@param[in]	limit	サイクル数
+		*/
+		//-----------------------------------------------------------------//
+		void exec(uint32_t limit)
+		{
+			uint8_t b = B;
+			uint8_t c = C;
+			uint8_t d = D;
+			uint8_t e = E;
+			uint8_t h = H;
+			uint8_t l = L;
+			uint8_t a = A;
+			uint8_t f = F;
+			uint32_t pc = PC;
+			uint32_t sp = SP;
+			uint32_t cyc = cycles_;
+
+			while(cyc < limit) {
+				uint32_t op = env_.readByte(pc++);
+				cyc += cyc_[op];
+				switch(op) {
+				case 0x00:	// NOP
+					break;
+				case 0x01:	// LXI B
+					c = env_.readByte(pc++);
+					b = env_.readByte(pc++);
+					break;
+				case 0x02:	// STAX B
+					env_.writeByte((static_cast<uint32_t>(b) << 8) | c, a);
+					break;
+				case 0x03:	// INX B
+					if(++c == 0) ++b;
+					break;
+				case 0x04:	// INR B
+					b = inr_(f, b);
+					break;
+				case 0x05:	// DCR B
+					b = dcr_(f, b);
+					break;
+				case 0x06:	// MVI B
+					b = env_.readByte(pc++);
+					break;
+				case 0x07:	// RLC
+					a = (a << 1) | (a >> 7);
+					f = (f & ~(AddSub | HalfCarry | Carry)) | (a & Carry);
+					break;
+				case 0x09:	// DAD B
+					dad_(f, h, l, (static_cast<uint32_t>(b) << 8) | c);
+					break;
+				case 0x0A:	// LDAX B
+					a = env_.readByte((static_cast<uint32_t>(b) << 8) | c);
+					break;
+				case 0x0B:	// DCX B
+					if(c-- == 0) --b;
+					break;
+				case 0x0C:	// INR C
+					c = inr_(f, c);
+					break;
+				case 0x0D:	// DCR C
+					c = dcr_(f, c);
+					break;
+				case 0x0E:	// MVI C
+					c = env_.readByte(pc++);
+					break;
+				case 0x0F:	// RRC
+					a = (a >> 1) | (a << 7);
+					f = (f & ~(AddSub | HalfCarry | Carry)) | (a >> 7);
+					break;
+				case 0x11:	// LXI D
+					e = env_.readByte(pc++);
+					d = env_.readByte(pc++);
+					break;
+				case 0x12:	// STAX D
+					env_.writeByte((static_cast<uint32_t>(d) << 8) | e, a);
+					break;
+				case 0x13:	// INX D
+					if(++e == 0) ++d;
+					break;
+				case 0x14:	// INR D
+					d = inr_(f, d);
+					break;
+				case 0x15:	// DCR D
+					d = dcr_(f, d);
+					break;
+				case 0x16:	// MVI D
+					d = env_.readByte(pc++);
+					break;
+				case 0x17:	// RAL
+					{
+						uint8_t t = a;
+						a = (a << 1) | (f & Carry);
+						f = (f & ~(AddSub | HalfCarry | Carry)) | (t >> 7);
+					}
+					break;
+				case 0x19:	// DAD D
+					dad_(f, h, l, (static_cast<uint32_t>(d) << 8) | e);
+					break;
+				case 0x1A:	// LDAX D
+					a = env_.readByte((static_cast<uint32_t>(d) << 8) | e);
+					break;
+				case 0x1B:	// DCX D
+					if(e-- == 0) --d;
+					break;
+				case 0x1C:	// INR E
+					e = inr_(f, e);
+					break;
+				case 0x1D:	// DCR E
+					e = dcr_(f, e);
+					break;
+				case 0x1E:	// MVI E
+					e = env_.readByte(pc++);
+					break;
+				case 0x1F:	// RAR
+					{
+						uint8_t t = a;
+						a = (a >> 1) | ((f & Carry) << 7);
+						f = (f & ~(AddSub | HalfCarry | Carry)) | (t & Carry);
+					}
+					break;
+				case 0x21:	// LXI H
+					l = env_.readByte(pc++);
+					h = env_.readByte(pc++);
+					break;
+				case 0x22:	// SHLD
+					{
+						uint32_t t = word_(pc);
+						env_.writeByte(t, l);
+						env_.writeByte(t + 1, h);
+					}
+					break;
+				case 0x23:	// INX H
+					if(++l == 0) ++h;
+					break;
+				case 0x24:	// INR H
+					h = inr_(f, h);
+					break;
+				case 0x25:	// DCR H
+					h = dcr_(f, h);
+					break;
+				case 0x26:	// MVI H
+					h = env_.readByte(pc++);
+					break;
+				case 0x27:	// DAA
+					if((a & 0x0F) > 9 || (f & HalfCarry)) {
+						a += 0x06;
+						f |= HalfCarry;
+					} else {
+						f &= ~HalfCarry;
+					}
+					if(a > 0x9F || (f & Carry)) {
+						a += 0x60;
+						f |= Carry;
+					} else {
+						f &= ~Carry;
+					}
+					f = (f & ~(Parity | Sign | Zero)) | szp_[a];
+					break;
+				case 0x29:	// DAD H
+					dad_(f, h, l, (static_cast<uint32_t>(h) << 8) | l);
+					break;
+				case 0x2A:	// LHLD
+					{
+						uint32_t t = word_(pc);
+						l = env_.readByte(t);
+						h = env_.readByte(t + 1);
+					}
+					break;
+				case 0x2B:	// DCX H
+					if(l-- == 0) --h;
+					break;
+				case 0x2C:	// INR L
+					l = inr_(f, l);
+					break;
+				case 0x2D:	// DCR L
+					l = dcr_(f, l);
+					break;
+				case 0x2E:	// MVI L
+					l = env_.readByte(pc++);
+					break;
+				case 0x2F:	// CMA
+					a ^= 0xFF;
+					f |= AddSub | HalfCarry;
+					break;
+				case 0x31:	// LXI SP
+					sp = word_(pc);
+					break;
+				case 0x32:	// STA
+					env_.writeByte(word_(pc), a);
+					break;
+				case 0x33:	// INX SP
+					sp = (sp + 1) & 0xFFFF;
+					break;
+				case 0x34:	// INR M
+					env_.writeByte(hl_(h, l), inr_(f, env_.readByte(hl_(h, l))));
+					break;
+				case 0x35:	// DCR M
+					env_.writeByte(hl_(h, l), dcr_(f, env_.readByte(hl_(h, l))));
+					break;
+				case 0x36:	// MVI M
+					env_.writeByte(hl_(h, l), env_.readByte(pc++));
+					break;
+				case 0x37:	// STC
+					f |= Carry;
+					break;
+				case 0x39:	// DAD SP
+					dad_(f, h, l, sp);
+					break;
+				case 0x3A:	// LDA
+					a = env_.readByte(word_(pc));
+					break;
+				case 0x3B:	// DCX SP
+					sp = (sp - 1) & 0xFFFF;
+					break;
+				case 0x3C:	// INR A
+					a = inr_(f, a);
+					break;
+				case 0x3D:	// DCR A
+					a = dcr_(f, a);
+					break;
+				case 0x3E:	// MVI A
+					a = env_.readByte(pc++);
+					break;
+				case 0x3F:	// CMC
+					f ^= Carry;
+					break;
+				case 0x40:	// MOV B,B
+					break;
+				case 0x41:	// MOV B,C
+					b = c;
+					break;
+				case 0x42:	// MOV B,D
+					b = d;
+					break;
+				case 0x43:	// MOV B,E
+					b = e;
+					break;
+				case 0x44:	// MOV B,H
+					b = h;
+					break;
+				case 0x45:	// MOV B,L
+					b = l;
+					break;
+				case 0x46:	// MOV B,M
+					b = env_.readByte(hl_(h, l));
+					break;
+				case 0x47:	// MOV B,A
+					b = a;
+					break;
+				case 0x48:	// MOV C,B
+					c = b;
+					break;
+				case 0x49:	// MOV C,C
+					break;
+				case 0x4A:	// MOV C,D
+					c = d;
+					break;
+				case 0x4B:	// MOV C,E
+					c = e;
+					break;
+				case 0x4C:	// MOV C,H
+					c = h;
+					break;
+				case 0x4D:	// MOV C,L
+					c = l;
+					break;
+				case 0x4E:	// MOV C,M
+					c = env_.readByte(hl_(h, l));
+					break;
+				case 0x4F:	// MOV C,A
+					c = a;
+					break;
+				case 0x50:	// MOV D,B
+					d = b;
+					break;
+				case 0x51:	// MOV D,C
+					d = c;
+					break;
+				case 0x52:	// MOV D,D
+					break;
+				case 0x53:	// MOV D,E
+					d = e;
+					break;
+				case 0x54:	// MOV D,H
+					d = h;
+					break;
+				case 0x55:	// MOV D,L
+					d = l;
+					break;
+				case 0x56:	// MOV D,M
+					d = env_.readByte(hl_(h, l));
+					break;
+				case 0x57:	// MOV D,A
+					d = a;
+					break;
+				case 0x58:	// MOV E,B
+					e = b;
+					break;
+				case 0x59:	// MOV E,C
+					e = c;
+					break;
+				case 0x5A:	// MOV E,D
+					e = d;
+					break;
+				case 0x5B:	// MOV E,E
+					break;
+				case 0x5C:	// MOV E,H
+					e = h;
+					break;
+				case 0x5D:	// MOV E,L
+					e = l;
+					break;
+				case 0x5E:	// MOV E,M
+					e = env_.readByte(hl_(h, l));
+					break;
+				case 0x5F:	// MOV E,A
+					e = a;
+					break;
+				case 0x60:	// MOV H,B
+					h = b;
+					break;
+				case 0x61:	// MOV H,C
+					h = c;
+					break;
+				case 0x62:	// MOV H,D
+					h = d;
+					break;
+				case 0x63:	// MOV H,E
+					h = e;
+					break;
+				case 0x64:	// MOV H,H
+					break;
+				case 0x65:	// MOV H,L
+					h = l;
+					break;
+				case 0x66:	// MOV H,M
+					h = env_.readByte(hl_(h, l));
+					break;
+				case 0x67:	// MOV H,A
+					h = a;
+					break;
+				case 0x68:	// MOV L,B
+					l = b;
+					break;
+				case 0x69:	// MOV L,C
+					l = c;
+					break;
+				case 0x6A:	// MOV L,D
+					l = d;
+					break;
+				case 0x6B:	// MOV L,E
+					l = e;
+					break;
+				case 0x6C:	// MOV L,H
+					l = h;
+					break;
+				case 0x6D:	// MOV L,L
+					break;
+				case 0x6E:	// MOV L,M
+					l = env_.readByte(hl_(h, l));
+					break;
+				case 0x6F:	// MOV L,A
+					l = a;
+					break;
+				case 0x70:	// MOV M,B
+					env_.writeByte(hl_(h, l), b);
+					break;
+				case 0x71:	// MOV M,C
+					env_.writeByte(hl_(h, l), c);
+					break;
+				case 0x72:	// MOV M,D
+					env_.writeByte(hl_(h, l), d);
+					break;
+				case 0x73:	// MOV M,E
+					env_.writeByte(hl_(h, l), e);
+					break;
+				case 0x74:	// MOV M,H
+					env_.writeByte(hl_(h, l), h);
+					break;
+				case 0x75:	// MOV M,L
+					env_.writeByte(hl_(h, l), l);
+					break;
+				case 0x76:	// HLT
+					halted_ = 1;
+					--pc;
+					break;
+				case 0x77:	// MOV M,A
+					env_.writeByte(hl_(h, l), a);
+					break;
+				case 0x78:	// MOV A,B
+					a = b;
+					break;
+				case 0x79:	// MOV A,C
+					a = c;
+					break;
+				case 0x7A:	// MOV A,D
+					a = d;
+					break;
+				case 0x7B:	// MOV A,E
+					a = e;
+					break;
+				case 0x7C:	// MOV A,H
+					a = h;
+					break;
+				case 0x7D:	// MOV A,L
+					a = l;
+					break;
+				case 0x7E:	// MOV A,M
+					a = env_.readByte(hl_(h, l));
+					break;
+				case 0x7F:	// MOV A,A
+					break;
+				case 0x80:	// ADD B
+					add_(a, f, b, 0);
+					break;
+				case 0x81:	// ADD C
+					add_(a, f, c, 0);
+					break;
+				case 0x82:	// ADD D
+					add_(a, f, d, 0);
+					break;
+				case 0x83:	// ADD E
+					add_(a, f, e, 0);
+					break;
+				case 0x84:	// ADD H
+					add_(a, f, h, 0);
+					break;
+				case 0x85:	// ADD L
+					add_(a, f, l, 0);
+					break;
+				case 0x86:	// ADD M
+					add_(a, f, env_.readByte(hl_(h, l)), 0);
+					break;
+				case 0x87:	// ADD A
+					add_(a, f, a, 0);
+					break;
+				case 0x88:	// ADC B
+					add_(a, f, b, f & Carry);
+					break;
+				case 0x89:	// ADC C
+					add_(a, f, c, f & Carry);
+					break;
+				case 0x8A:	// ADC D
+					add_(a, f, d, f & Carry);
+					break;
+				case 0x8B:	// ADC E
+					add_(a, f, e, f & Carry);
+					break;
+				case 0x8C:	// ADC H
+					add_(a, f, h, f & Carry);
+					break;
+				case 0x8D:	// ADC L
+					add_(a, f, l, f & Carry);
+					break;
+				case 0x8E:	// ADC M
+					add_(a, f, env_.readByte(hl_(h, l)), f & Carry);
+					break;
+				case 0x8F:	// ADC A
+					add_(a, f, a, f & Carry);
+					break;
+				case 0x90:	// SUB B
+					a = sub_(a, f, b, 0);
+					break;
+				case 0x91:	// SUB C
+					a = sub_(a, f, c, 0);
+					break;
+				case 0x92:	// SUB D
+					a = sub_(a, f, d, 0);
+					break;
+				case 0x93:	// SUB E
+					a = sub_(a, f, e, 0);
+					break;
+				case 0x94:	// SUB H
+					a = sub_(a, f, h, 0);
+					break;
+				case 0x95:	// SUB L
+					a = sub_(a, f, l, 0);
+					break;
+				case 0x96:	// SUB M
+					a = sub_(a, f, env_.readByte(hl_(h, l)), 0);
+					break;
+				case 0x97:	// SUB A
+					a = sub_(a, f, a, 0);
+					break;
+				case 0x98:	// SBB B
+					a = sub_(a, f, b, f & Carry);
+					break;
+				case 0x99:	// SBB C
+					a = sub_(a, f, c, f & Carry);
+					break;
+				case 0x9A:	// SBB D
+					a = sub_(a, f, d, f & Carry);
+					break;
+				case 0x9B:	// SBB E
+					a = sub_(a, f, e, f & Carry);
+					break;
+				case 0x9C:	// SBB H
+					a = sub_(a, f, h, f & Carry);
+					break;
+				case 0x9D:	// SBB L
+					a = sub_(a, f, l, f & Carry);
+					break;
+				case 0x9E:	// SBB M
+					a = sub_(a, f, env_.readByte(hl_(h, l)), f & Carry);
+					break;
+				case 0x9F:	// SBB A
+					a = sub_(a, f, a, f & Carry);
+					break;
+				case 0xA0:	// ANA B
+					a &= b;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA1:	// ANA C
+					a &= c;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA2:	// ANA D
+					a &= d;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA3:	// ANA E
+					a &= e;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA4:	// ANA H
+					a &= h;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA5:	// ANA L
+					a &= l;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA6:	// ANA M
+					a &= env_.readByte(hl_(h, l));
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA7:	// ANA A
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA8:	// XRA B
+					a ^= b;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xA9:	// XRA C
+					a ^= c;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAA:	// XRA D
+					a ^= d;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAB:	// XRA E
+					a ^= e;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAC:	// XRA H
+					a ^= h;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAD:	// XRA L
+					a ^= l;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAE:	// XRA M
+					a ^= env_.readByte(hl_(h, l));
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xAF:	// XRA A
+					a = 0;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB0:	// ORA B
+					a |= b;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB1:	// ORA C
+					a |= c;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB2:	// ORA D
+					a |= d;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB3:	// ORA E
+					a |= e;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB4:	// ORA H
+					a |= h;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB5:	// ORA L
+					a |= l;
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB6:	// ORA M
+					a |= env_.readByte(hl_(h, l));
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB7:	// ORA A
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xB8:	// CMP B
+					sub_(a, f, b, 0);
+					break;
+				case 0xB9:	// CMP C
+					sub_(a, f, c, 0);
+					break;
+				case 0xBA:	// CMP D
+					sub_(a, f, d, 0);
+					break;
+				case 0xBB:	// CMP E
+					sub_(a, f, e, 0);
+					break;
+				case 0xBC:	// CMP H
+					sub_(a, f, h, 0);
+					break;
+				case 0xBD:	// CMP L
+					sub_(a, f, l, 0);
+					break;
+				case 0xBE:	// CMP M
+					sub_(a, f, env_.readByte(hl_(h, l)), 0);
+					break;
+				case 0xBF:	// CMP A
+					sub_(a, f, a, 0);
+					break;
+				case 0xC0:	// RNZ
+					if(!(f & Zero)) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xC1:	// POP B
+					c = env_.readByte(sp++);
+					b = env_.readByte(sp++);
+					break;
+				case 0xC2:	// JNZ
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Zero)) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xC3:	// JMP
+					pc = env_.readByte(pc) | (static_cast<uint32_t>(env_.readByte(pc + 1)) << 8);
+					break;
+				case 0xC4:	// CNZ
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Zero)) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xC5:	// PUSH B
+					env_.writeByte(--sp, b);
+					env_.writeByte(--sp, c);
+					break;
+				case 0xC6:	// ADI
+					add_(a, f, env_.readByte(pc++), 0);
+					break;
+				case 0xC7:	// RST 0
+					call_(pc, sp, 0x00);
+					break;
+				case 0xC8:	// RZ
+					if(f & Zero) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xC9:	// RET
+					ret_(pc, sp);
+					break;
+				case 0xCA:	// JZ
+					{
+						uint32_t t = word_(pc);
+						if(f & Zero) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xCC:	// CZ
+					{
+						uint32_t t = word_(pc);
+						if(f & Zero) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xCD:	// CALL
+					call_(pc, sp, word_(pc));
+					break;
+				case 0xCE:	// ACI
+					add_(a, f, env_.readByte(pc++), f & Carry);
+					break;
+				case 0xCF:	// RST 1
+					call_(pc, sp, 0x08);
+					break;
+				case 0xD0:	// RNC
+					if(!(f & Carry)) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xD1:	// POP D
+					e = env_.readByte(sp++);
+					d = env_.readByte(sp++);
+					break;
+				case 0xD2:	// JNC
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Carry)) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xD3:	// OUT
+					env_.writePort(env_.readByte(pc++), a);
+					break;
+				case 0xD4:	// CNC
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Carry)) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xD5:	// PUSH D
+					env_.writeByte(--sp, d);
+					env_.writeByte(--sp, e);
+					break;
+				case 0xD6:	// SUI
+					a = sub_(a, f, env_.readByte(pc++), 0);
+					break;
+				case 0xD7:	// RST 2
+					call_(pc, sp, 0x10);
+					break;
+				case 0xD8:	// RC
+					if(f & Carry) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xDA:	// JC
+					{
+						uint32_t t = word_(pc);
+						if(f & Carry) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xDB:	// IN
+					a = env_.readPort(env_.readByte(pc++));
+					break;
+				case 0xDC:	// CC
+					// I8080 と同じく、条件が成立しない場合、オペランドを飛ばさない
+					if(f & Carry) {
+						call_(pc, sp, word_(pc));
+						cyc += 7;
+					}
+					break;
+				case 0xDE:	// SBI
+					a = sub_(a, f, env_.readByte(pc++), f & Carry);
+					break;
+				case 0xDF:	// RST 3
+					call_(pc, sp, 0x18);
+					break;
+				case 0xE0:	// RPO
+					if(!(f & Parity)) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xE1:	// POP H
+					l = env_.readByte(sp++);
+					h = env_.readByte(sp++);
+					break;
+				case 0xE2:	// JPO
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Parity)) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xE3:	// XTHL
+					{
+						uint8_t t = env_.readByte(sp);
+						env_.writeByte(sp, l);
+						l = t;
+						t = env_.readByte(sp + 1);
+						env_.writeByte(sp + 1, h);
+						h = t;
+					}
+					break;
+				case 0xE4:	// CPO
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Parity)) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xE5:	// PUSH H
+					env_.writeByte(--sp, h);
+					env_.writeByte(--sp, l);
+					break;
+				case 0xE6:	// ANI
+					a &= env_.readByte(pc++);
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xE7:	// RST 4
+					call_(pc, sp, 0x20);
+					break;
+				case 0xE8:	// RPE
+					if(f & Parity) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xE9:	// PCHL
+					pc = hl_(h, l);
+					break;
+				case 0xEA:	// JPE
+					{
+						uint32_t t = word_(pc);
+						if(f & Parity) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xEB:	// XCHG
+					{
+						uint8_t t = d;
+						d = h;
+						h = t;
+						t = e;
+						e = l;
+						l = t;
+					}
+					break;
+				case 0xEC:	// CPE
+					{
+						uint32_t t = word_(pc);
+						if(f & Parity) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xEE:	// XRI
+					a ^= env_.readByte(pc++);
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xEF:	// RST 5
+					call_(pc, sp, 0x28);
+					break;
+				case 0xF0:	// RP
+					if(!(f & Sign)) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xF1:	// POP PSW
+					f = env_.readByte(sp++);
+					a = env_.readByte(sp++);
+					break;
+				case 0xF2:	// JP
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Sign)) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xF3:	// DI
+					f &= ~Interrupt;
+					break;
+				case 0xF4:	// CP
+					{
+						uint32_t t = word_(pc);
+						if(!(f & Sign)) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xF5:	// PUSH PSW
+					env_.writeByte(--sp, a);
+					env_.writeByte(--sp, f);
+					break;
+				case 0xF6:	// ORI
+					a |= env_.readByte(pc++);
+					f = (f & (Flag3 | Flag5)) | szp_[a];
+					break;
+				case 0xF7:	// RST 6
+					call_(pc, sp, 0x30);
+					break;
+				case 0xF8:	// RM
+					if(f & Sign) {
+						ret_(pc, sp);
+						cyc += 6;
+					}
+					break;
+				case 0xF9:	// SPHL
+					sp = hl_(h, l);
+					break;
+				case 0xFA:	// JM
+					{
+						uint32_t t = word_(pc);
+						if(f & Sign) {
+							pc = t;
+							cyc += 5;
+						}
+					}
+					break;
+				case 0xFB:	// EI
+					f |= Interrupt;
+					break;
+				case 0xFC:	// CM
+					{
+						uint32_t t = word_(pc);
+						if(f & Sign) {
+							call_(pc, sp, t);
+							cyc += 7;
+						}
+					}
+					break;
+				case 0xFE:	// CPI
+					sub_(a, f, env_.readByte(pc++), 0);
+					break;
+				case 0xFF:	// RST 7
+					call_(pc, sp, 0x38);
+					break;
+				case 0x08:
+				case 0x10:
+				case 0x18:
+				case 0x20:
+				case 0x28:
+				case 0x30:
+				case 0x38:
+				case 0xCB:
+				case 0xD9:
+				case 0xDD:
+				case 0xED:
+				case 0xFD:
+					break;	// 未定義（I8080 と同じく、何もしない）
+				}
+				pc &= 0xFFFF;
+			}
+
+			B = b;
+			C = c;
+			D = d;
+			E = e;
+			H = h;
+			L = l;
+			A = a;
+			F = f;
+			PC = pc;
+			SP = sp;
+			cycles_ = cyc;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  １命令実行
+		*/
+		//-----------------------------------------------------------------//
+		void step() { exec(cycles_ + 1); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  割り込み（割り込み許可の場合）
+			@param[in]	address	割り込みハンドラーのアドレス
+		*/
+		//-----------------------------------------------------------------//
+		void interrupt(uint32_t address)
+		{
+			if(F & Interrupt) {
+				if(halted_) {
+					PC++;
+					halted_ = 0;
+				}
+				env_.writeByte(--SP, (PC >> 8) & 0xFF);
+				env_.writeByte(--SP, PC & 0xFF);
+				PC = address & 0xFFFF;
+			}
+		}
+
+
+		uint32_t AF() const noexcept { return (static_cast<uint32_t>(A) << 8) | F; }
+		uint32_t BC() const noexcept { return (static_cast<uint32_t>(B) << 8) | C; }
+		uint32_t DE() const noexcept { return (static_cast<uint32_t>(D) << 8) | E; }
+		uint32_t HL() const noexcept { return (static_cast<uint32_t>(H) << 8) | L; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サイクル数を取得
+			@return サイクル数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t getCycles() const noexcept { return cycles_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サイクル数を設定
+			@param[in]	value	サイクル数
+		*/
+		//-----------------------------------------------------------------//
+		void setCycles(uint32_t value) noexcept { cycles_ = value; }
+	};
+
+
+	// 命令毎のサイクル数（I8080 の Opcode_ と同じ、条件成立の加算は命令で行う）
+	template <class ENV>
+	const uint8_t i8080_core<ENV>::cyc_[256] = {
+		 4, 10,  7,  6,  5,  5,  7,  4,  4, 11,  7,  6,  5,  5,  7,  4,
+		 4, 10,  7,  6,  5,  5,  7,  4,  4, 11,  7,  6,  5,  5,  7,  4,
+		 4, 10, 16,  6,  5,  5,  7,  4,  4, 11, 16,  6,  5,  5,  7,  4,
+		 4, 10, 13,  6, 10, 10, 10,  4,  4, 11, 13,  6,  5,  5,  7,  4,
+		 5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5,
+		 5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5,
+		 5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5,
+		 7,  7,  7,  7,  7,  7,  7,  7,  5,  5,  5,  5,  5,  5,  7,  5,
+		 4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4,
+		 4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4,
+		 4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4,
+		 4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4,
+		 5, 10, 10, 10, 11, 11,  7, 11,  5, 10, 10,  4, 11, 17,  7, 11,
+		 5, 10, 10, 10, 11, 11,  7, 11,  5,  4, 10, 10, 11,  4,  7, 11,
+		 5, 10, 10,  4, 11, 11,  7, 11,  5,  4, 10,  4, 11,  4,  7, 11,
+		 5, 10, 10,  4, 11, 11,  7, 11,  5,  6, 10,  4, 11,  4,  7, 11
+	};
+
+	// 結果のパリティ、サイン、ゼロ（I8080::PSZ_ と同じ）
+	template <class ENV>
+	const uint8_t i8080_core<ENV>::szp_[256] = {
+		0x44, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+		0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+		0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+		0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+		0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+		0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+		0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+		0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04, 0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+		0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+		0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+		0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+		0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+		0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+		0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+		0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+		0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80, 0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84
+	};
+
+	// INR の結果に対するフラグ（ハーフキャリー、オーバーフロー、サイン、ゼロ）
+	template <class ENV>
+	const uint8_t i8080_core<ENV>::inr_tbl_[256] = {
+		0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x94, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x90, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+	};
+
+	// DCR の結果に対するフラグ（AddSub、ハーフキャリー、オーバーフロー、サイン、ゼロ）
+	template <class ENV>
+	const uint8_t i8080_core<ENV>::dcr_tbl_[256] = {
+		0x42, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12,
+		0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x16,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92,
+		0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x92
+	};
+}
@@ -14,19 +14,47 @@ namespace utils {
 
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
     /*!
-        @brief  fifo クラス
+        @brief  fifo クラス @n
+				格納できる数は（SIZE - 1）
 		@param[in]	UNIT	基本形
 		@param[in]	SIZE	バッファサイズ（最大６５５３６）
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class UNIT, uint32_t SIZE>
 	class fixed_fifo {
+	public:
+		//=================================================================//
+		/*!
+			@brief  連続した領域（バッファの終端で折り返す場合、二つになる）
+		*/
+		//=================================================================//
+		struct span_t {
+			UNIT*		org[2];
+			uint32_t	len[2];
+
+			uint32_t size() const noexcept { return len[0] + len[1]; }
+		};
 
+	private:
 		volatile uint16_t	get_;
 		volatile uint16_t	put_;
 
 		UNIT	buff_[SIZE];
 
+		span_t make_span_(uint32_t pos, uint32_t num) noexcept
+		{
+			span_t sp;
+			sp.org[0] = &buff_[pos];
+			sp.len[0] = num;
+			sp.org[1] = &buff_[0];
+			sp.len[1] = 0;
+			if((pos + num) > SIZE) {
+				sp.len[0] = SIZE - pos;
+				sp.len[1] = num - sp.len[0];
+			}
+			return sp;
+		}
+
 	public:
         //-----------------------------------------------------------------//
         /*!
@@ -138,6 +166,96 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空いている領域を返す（書き込んだら put_go(n) で確定する）
+			@return	空いている領域
+        */
+        //-----------------------------------------------------------------//
+		span_t write_span() noexcept {
+			return make_span_(put_, SIZE - 1 - length());
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納ポイントをまとめて移動
+			@param[in]	n	移動する数
+        */
+        //-----------------------------------------------------------------//
+		void put_go(uint32_t n) noexcept {
+			uint32_t put = put_ + n;
+			if(put >= SIZE) {
+				put -= SIZE;
+			}
+			put_ = put;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納されている領域を返す（読み出したら get_go(n) で確定する）
+			@return	格納されている領域
+        */
+        //-----------------------------------------------------------------//
+		span_t read_span() noexcept {
+			return make_span_(get_, length());
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  取得ポイントをまとめて移動
+			@param[in]	n	移動する数
+        */
+        //-----------------------------------------------------------------//
+		void get_go(uint32_t n) noexcept {
+			uint32_t get = get_ + n;
+			if(get >= SIZE) {
+				get -= SIZE;
+			}
+			get_ = get;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  まとめて格納（空きが足りない場合、入る分だけ）
+			@param[in]	src	値の先頭
+			@param[in]	n	数
+			@return	格納した数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t put(const UNIT* src, uint32_t n) noexcept {
+			span_t sp = write_span();
+			if(n > sp.size()) n = sp.size();
+			uint32_t l = n < sp.len[0] ? n : sp.len[0];
+			for(uint32_t i = 0; i < l; ++i) sp.org[0][i] = src[i];
+			for(uint32_t i = l; i < n; ++i) sp.org[1][i - l] = src[i];
+			put_go(n);
+			return n;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  まとめて取得（足りない場合、ある分だけ）
+			@param[out]	dst	値の先頭
+			@param[in]	n	数
+			@return	取得した数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get(UNIT* dst, uint32_t n) noexcept {
+			span_t sp = read_span();
+			if(n > sp.size()) n = sp.size();
+			uint32_t l = n < sp.len[0] ? n : sp.len[0];
+			for(uint32_t i = 0; i < l; ++i) dst[i] = sp.org[0][i];
+			for(uint32_t i = l; i < n; ++i) dst[i] = sp.org[1][i - l];
+			get_go(n);
+			return n;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  get 位置を返す
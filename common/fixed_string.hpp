@@ -151,8 +151,10 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		fixed_string& operator = (const fixed_string& src) noexcept {
-			std::strncpy(text_, src.c_str(), SIZE);
-			pos_ = src.pos_;
+			if(&src != this) {
+				std::memcpy(text_, src.text_, sizeof(text_));
+				pos_ = src.pos_;
+			}
 			return *this;
 		}
 
@@ -0,0 +1,122 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	HTTP ユーティリティー @n
+			HTTP サーバー（net2、r_net）で共通に使う、ヘッダー解析と @n
+			Content-Type の生成
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  HTTP ユーティリティー・クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct http_utils {
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  英大文字を小文字にする
+			@param[in]	ch	文字
+			@return 変換後の文字
+		*/
+		//-----------------------------------------------------------------//
+		static char lower(char ch)
+		{
+			if(ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+			return ch;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ヘッダー行が「key:」で始まるか（大文字、小文字を区別しない）
+			@param[in]	line	ヘッダー行
+			@param[in]	key		キー
+			@return 一致したら値の先頭（前の空白を除く）、それ以外は「nullptr」
+		*/
+		//-----------------------------------------------------------------//
+		static const char* match_key(const char* line, const char* key)
+		{
+			while(*key != 0) {
+				if(lower(*line) != lower(*key)) return nullptr;
+				++line;
+				++key;
+			}
+			if(*line != ':') return nullptr;
+			++line;
+			while(*line == ' ' || *line == '\t') ++line;
+			return line;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  カンマ区切りの値にトークンが含まれるか @n
+					「Accept-Encoding: gzip;q=0」のように、「q=0」は拒否とする。
+			@param[in]	value	ヘッダーの値（nullptr の場合「false」）
+			@param[in]	token	トークン（大文字、小文字を区別しない）
+			@return 受け付けるなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		static bool has_token(const char* value, const char* token)
+		{
+			if(value == nullptr) return false;
+			uint32_t n = std::strlen(token);
+			while(*value != 0) {
+				while(*value == ' ' || *value == ',') ++value;
+				uint32_t i = 0;
+				while(i < n && lower(value[i]) == lower(token[i])) ++i;
+				if(i == n && (value[n] == 0 || value[n] == ',' || value[n] == ' ' || value[n] == ';')) {
+					const char* q = &value[n];
+					while(*q == ' ' || *q == ';') ++q;
+					if(q[0] != 'q' || q[1] != '=') return true;
+					q += 2;
+					while(*q == '0' || *q == '.') ++q;
+					return *q != 0 && *q != ',' && *q != ' ';  // 「q=0」は拒否
+				}
+				while(*value != 0 && *value != ',') ++value;
+			}
+			return false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  拡張子から「Content-Type:」行を出力する
+			@param[in]	path	ファイルのパス
+		*/
+		//-----------------------------------------------------------------//
+		template <class FMT>
+		static void make_content_type(const char* path)
+		{
+			FMT("Content-Type: ");
+			const char* ext = std::strrchr(path, '.');
+			if(ext != nullptr) {
+				++ext;
+				if(std::strcmp(ext, "png") == 0 || std::strcmp(ext, "jpeg") == 0
+				  || std::strcmp(ext, "jpg") == 0 || std::strcmp(ext, "gif") == 0) {
+					FMT("image/%s\n") % ext;
+				} else if(std::strcmp(ext, "ico") == 0) {
+					FMT("image/x-icon\n");
+				} else if(std::strcmp(ext, "js") == 0) {
+					FMT("application/javascript\n");
+				} else if(std::strcmp(ext, "htm") == 0) {
+					FMT("text/html\n");
+				} else {
+					FMT("text/%s\n") % ext;
+				}
+			} else {
+				FMT("text/plain\n");
+			}
+		}
+	};
+}
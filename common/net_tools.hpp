@@ -13,6 +13,9 @@
 #include <random>
 #include "common/byte_order.h"
 #include "common/time.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if defined(BIG_ENDIAN)
 #elif defined(LITTLE_ENDIAN)
@@ -77,30 +80,230 @@ namespace net {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  イーサーネット・チェック・サムの計算
+			@brief  １の補数和の桁上げを、１６ビットに畳み込む
+			@param[in]	sum	和
+			@return １６ビットの和
+		*/
+		//-----------------------------------------------------------------//
+		static inline uint16_t fold_sum(uint64_t sum)
+		{
+			sum = (sum & 0xffffffff) + (sum >> 32);
+			sum = (sum & 0xffffffff) + (sum >> 32);
+			uint32_t s = (sum & 0xffff) + (sum >> 16);
+			s = (s & 0xffff) + (s >> 16);
+			return (s & 0xffff) + (s >> 16);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  二つの部分和を加える
+			@param[in]	a	部分和
+			@param[in]	b	部分和
+			@return 部分和
+		*/
+		//-----------------------------------------------------------------//
+		static inline uint16_t join_sum(uint16_t a, uint16_t b)
+		{
+			uint32_t s = static_cast<uint32_t>(a) + b;
+			return (s & 0xffff) + (s >> 16);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  部分和の計算 @n
+					３２ビット単位で加算し、最後に畳み込む（ホストでは SSE2 で @n
+					１６バイト単位）@n
+					※ブロックが奇数オフセットから始まる場合は、結果を @n
+					上位と下位のバイトを交換してから、join_sum で加える事
 			@param[in]	src	ソース
 			@param[in]	len	バイト数
-			@param[in]	sumorg	サム初期値（通常「０」）
-			@return チェック・サム
+			@param[in]	sumorg	部分和の初期値（通常「０」）
+			@return 部分和（補数を取る前の値、ネットワーク・バイト順の数値）
 		*/
 		//-----------------------------------------------------------------//
-		static uint16_t calc_sum(const void* src, uint16_t len, uint16_t sumorg = 0)
+		static uint16_t add_sum(const void* src, uint16_t len, uint16_t sumorg = 0)
 		{
 			const uint8_t* d = static_cast<const uint8_t*>(src);
-			uint32_t sum = sumorg;
-			bool mod = false;
-			if(len & 1) {
-				len &= 0xfffe;
-				mod = true;
+			// ネイティブ・バイト順で加算し、最後にバイト順を戻す（RFC1071）
+			uint64_t sum = htons(sumorg);
+#if defined(__SSE2__)
+			if(len >= 32) {
+				const __m128i zero = _mm_setzero_si128();
+				__m128i acc = zero;
+				while(len >= 16) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+					acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+					acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+					d += 16;
+					len -= 16;
+				}
+				uint32_t t[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(t), acc);
+				sum += static_cast<uint64_t>(t[0]) + t[1] + t[2] + t[3];
+			}
+#endif
+			while(len >= 16) {
+				uint32_t w[4];
+				std::memcpy(w, d, 16);
+				sum += w[0];
+				sum += w[1];
+				sum += w[2];
+				sum += w[3];
+				d += 16;
+				len -= 16;
 			}
-			for(uint16_t i = 0; i < len; i += 2) {
-				sum += (d[0] << 8) | d[1];
+			while(len >= 4) {
+				uint32_t w;
+				std::memcpy(&w, d, 4);
+				sum += w;
+				d += 4;
+				len -= 4;
+			}
+			if(len >= 2) {
+				uint16_t w;
+				std::memcpy(&w, d, 2);
+				sum += w;
 				d += 2;
+				len -= 2;
 			}
-			if(mod) {
+			if(len > 0) {
+#ifdef LITTLE_ENDIAN
+				sum += d[0];
+#else
 				sum += d[0] << 8;
+#endif
+			}
+			return htons(fold_sum(sum));
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コピーしながら部分和を計算（送信バッファへの書き込み用）
+			@param[out]	dst	コピー先
+			@param[in]	src	ソース
+			@param[in]	len	バイト数
+			@param[in]	sumorg	部分和の初期値（通常「０」）
+			@return 部分和（補数を取る前の値）
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t copy_sum(void* dst, const void* src, uint16_t len, uint16_t sumorg = 0)
+		{
+			uint8_t* o = static_cast<uint8_t*>(dst);
+			const uint8_t* d = static_cast<const uint8_t*>(src);
+			uint64_t sum = htons(sumorg);
+#if defined(__SSE2__)
+			if(len >= 32) {
+				const __m128i zero = _mm_setzero_si128();
+				__m128i acc = zero;
+				while(len >= 16) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+					acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+					acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+					d += 16;
+					o += 16;
+					len -= 16;
+				}
+				uint32_t t[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(t), acc);
+				sum += static_cast<uint64_t>(t[0]) + t[1] + t[2] + t[3];
 			}
-			return ~((sum & 0xffff) + (sum >> 16));
+#endif
+			while(len >= 16) {
+				uint32_t w[4];
+				std::memcpy(w, d, 16);
+				std::memcpy(o, w, 16);
+				sum += w[0];
+				sum += w[1];
+				sum += w[2];
+				sum += w[3];
+				d += 16;
+				o += 16;
+				len -= 16;
+			}
+			while(len >= 4) {
+				uint32_t w;
+				std::memcpy(&w, d, 4);
+				std::memcpy(o, &w, 4);
+				sum += w;
+				d += 4;
+				o += 4;
+				len -= 4;
+			}
+			if(len >= 2) {
+				uint16_t w;
+				std::memcpy(&w, d, 2);
+				std::memcpy(o, &w, 2);
+				sum += w;
+				d += 2;
+				o += 2;
+				len -= 2;
+			}
+			if(len > 0) {
+				o[0] = d[0];
+#ifdef LITTLE_ENDIAN
+				sum += d[0];
+#else
+				sum += d[0] << 8;
+#endif
+			}
+			return htons(fold_sum(sum));
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  イーサーネット・チェック・サムの計算
+			@param[in]	src	ソース
+			@param[in]	len	バイト数
+			@param[in]	sumorg	サム初期値（通常「０」）
+			@return チェック・サム
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t calc_sum(const void* src, uint16_t len, uint16_t sumorg = 0)
+		{
+			return ~add_sum(src, len, sumorg);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  チェック・サムの差分更新（RFC1624）@n
+					ヘッダーの１６ビット・フィールドだけが変わる場合に使う
+			@param[in]	sum		元のチェック・サム
+			@param[in]	old_val	元のフィールド値
+			@param[in]	new_val	新しいフィールド値
+			@return 新しいチェック・サム
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t update_sum(uint16_t sum, uint16_t old_val, uint16_t new_val)
+		{
+			// HC' = ~(~HC + ~m + m')
+			uint32_t s = static_cast<uint16_t>(~sum);
+			s += static_cast<uint16_t>(~old_val);
+			s += new_val;
+			s = (s & 0xffff) + (s >> 16);
+			s = (s & 0xffff) + (s >> 16);
+			return ~s;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  チェック・サムの差分更新（RFC1624、３２ビット・フィールド）
+			@param[in]	sum		元のチェック・サム
+			@param[in]	old_val	元のフィールド値
+			@param[in]	new_val	新しいフィールド値
+			@return 新しいチェック・サム
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t update_sum32(uint16_t sum, uint32_t old_val, uint32_t new_val)
+		{
+			sum = update_sum(sum, old_val >> 16, new_val >> 16);
+			return update_sum(sum, old_val & 0xffff, new_val & 0xffff);
 		}
 
 
@@ -0,0 +1,382 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	Web パック・テンプレート @n
+			パッカーで作成した圧縮済み静的ファイル・アーカイブを読み出す。@n
+			インデックスとパス文字列は RAM に置き、小さなファイルは LRU @n
+			キャッシュに保持して SD カードへのアクセスを省く。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include "ff12b/src/ff.h"
+#include "common/web_pack_st.hpp"
+#include "common/format.hpp"
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  web_pack class テンプレート
+		@param[in]	SDC			ＳＤカードファイル操作インスタンス
+		@param[in]	MAX_ENTRY	エントリーの最大数
+		@param[in]	NAME_SIZE	パス文字列領域の最大サイズ
+		@param[in]	CACHE_NUM	キャッシュ・スロット数（１以上）
+		@param[in]	CACHE_SLOT	キャッシュ・スロットのサイズ（これ以下のファイルを保持）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class SDC, uint32_t MAX_ENTRY = 128, uint32_t NAME_SIZE = 4096,
+		uint32_t CACHE_NUM = 8, uint32_t CACHE_SLOT = 2048>
+	class web_pack {
+	public:
+		typedef web_pack_st::entry_t entry_t;
+
+		//=================================================================//
+		/*!
+			@brief  読み出し中のアセット
+		*/
+		//=================================================================//
+		struct asset_t {
+			int32_t			idx;	///< エントリーのインデックス
+			bool			gz;		///< gzip データの場合「true」
+			const uint8_t*	ram;	///< キャッシュ上のデータ（nullptr ならパックから読む）
+			uint32_t		org;	///< パック内の先頭位置
+			uint32_t		size;	///< サイズ
+			uint32_t		pos;	///< 読み出し位置
+			asset_t() : idx(-1), gz(false), ram(nullptr), org(0), size(0), pos(0) { }
+		};
+
+	private:
+		// デバッグ以外で出力を無効にする
+#ifdef WEB_PACK_DEBUG
+		typedef utils::format debug_format;
+#else
+		typedef utils::null_format debug_format;
+#endif
+
+		SDC&		sdc_;
+		FIL			fil_;
+		bool		open_;
+
+		uint32_t	num_;
+		entry_t		index_[MAX_ENTRY];
+		char		names_[NAME_SIZE];
+
+		struct cache_t {
+			int32_t		idx;
+			bool		gz;
+			uint32_t	stamp;
+			uint8_t		data[CACHE_SLOT];
+		};
+		cache_t		cache_[CACHE_NUM];
+		uint32_t	stamp_;
+
+		uint32_t	hit_;
+		uint32_t	miss_;
+
+
+		bool read_at_(uint32_t ofs, void* dst, uint32_t len)
+		{
+			if(f_tell(&fil_) != ofs) {
+				if(f_lseek(&fil_, ofs) != FR_OK) return false;
+			}
+			UINT br = 0;
+			if(f_read(&fil_, dst, len, &br) != FR_OK) return false;
+			return br == len;
+		}
+
+
+		// キャッシュから探し、無ければ一番古いスロットへ読み込む
+		const uint8_t* load_cache_(int32_t idx, bool gz, uint32_t org, uint32_t size)
+		{
+			++stamp_;
+			uint32_t old = 0;
+			uint32_t age = 0;
+			for(uint32_t i = 0; i < CACHE_NUM; ++i) {
+				cache_t& c = cache_[i];
+				if(c.idx == idx && c.gz == gz) {
+					c.stamp = stamp_;
+					++hit_;
+					return c.data;
+				}
+				uint32_t n = c.idx < 0 ? 0xffffffff : (stamp_ - c.stamp);  // 空きスロットを優先
+				if(n > age) {
+					age = n;
+					old = i;
+				}
+			}
+			++miss_;
+			cache_t& c = cache_[old];
+			c.idx = -1;
+			if(!read_at_(org, c.data, size)) return nullptr;
+			c.idx = idx;
+			c.gz = gz;
+			c.stamp = stamp_;
+			return c.data;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	sdc	SDC コンテキスト
+		*/
+		//-----------------------------------------------------------------//
+		web_pack(SDC& sdc) : sdc_(sdc), fil_(), open_(false), num_(0),
+			stamp_(0), hit_(0), miss_(0)
+		{
+			for(uint32_t i = 0; i < CACHE_NUM; ++i) {
+				cache_[i].idx = -1;
+				cache_[i].stamp = 0;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  パック・ファイルを開き、インデックスを読み込む
+			@param[in]	path	パック・ファイルのパス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool open(const char* path)
+		{
+			close();
+			if(!sdc_.open(&fil_, path, FA_READ)) {
+				debug_format("Web pack: can't open '%s'\n") % path;
+				return false;
+			}
+			open_ = true;
+
+			web_pack_st::header_t h;
+			if(!read_at_(0, &h, sizeof(h)) || !web_pack_st::check_magic(h)) {
+				debug_format("Web pack: '%s' is not pack\n") % path;
+				close();
+				return false;
+			}
+			if(h.num > MAX_ENTRY || h.name_size > NAME_SIZE) {
+				debug_format("Web pack: index over (%d/%d, %d/%d)\n")
+					% h.num % MAX_ENTRY % h.name_size % NAME_SIZE;
+				close();
+				return false;
+			}
+			if(!read_at_(sizeof(h), index_, h.num * sizeof(entry_t))
+			  || !read_at_(sizeof(h) + h.num * sizeof(entry_t), names_, h.name_size)) {
+				debug_format("Web pack: index read error\n");
+				close();
+				return false;
+			}
+			num_ = h.num;
+			debug_format("Web pack: '%s' %d entries\n") % path % num_;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  パック・ファイルを閉じる
+		*/
+		//-----------------------------------------------------------------//
+		void close()
+		{
+			if(open_) {
+				sdc_.close(&fil_);
+				open_ = false;
+			}
+			num_ = 0;
+			for(uint32_t i = 0; i < CACHE_NUM; ++i) {
+				cache_[i].idx = -1;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  オープンしているか
+			@return オープンしていれば「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_open() const { return open_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  エントリー数を取得
+			@return エントリー数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t size() const { return num_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  パスを探す（ハッシュの二分探索）
+			@param[in]	path	パス
+			@return エントリーのインデックス（無い場合「-1」）
+		*/
+		//-----------------------------------------------------------------//
+		int32_t find(const char* path) const
+		{
+			uint32_t h = web_pack_st::hash(path);
+			uint32_t lo = 0;
+			uint32_t hi = num_;
+			while(lo < hi) {
+				uint32_t mid = (lo + hi) / 2;
+				if(index_[mid].hash < h) lo = mid + 1;
+				else hi = mid;
+			}
+			for(uint32_t i = lo; i < num_ && index_[i].hash == h; ++i) {
+				if(std::strcmp(&names_[index_[i].name], path) == 0) {
+					return static_cast<int32_t>(i);
+				}
+			}
+			return -1;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  エントリーを取得
+			@param[in]	idx	インデックス
+			@return エントリー
+		*/
+		//-----------------------------------------------------------------//
+		const entry_t& get_entry(int32_t idx) const { return index_[idx]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  パスを取得
+			@param[in]	idx	インデックス
+			@return パス
+		*/
+		//-----------------------------------------------------------------//
+		const char* get_name(int32_t idx) const { return &names_[index_[idx].name]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アセットを開く @n
+					gzip を受け付ける場合で、gzip データがあればそちらを選ぶ。@n
+					キャッシュ・スロットに収まるサイズなら、キャッシュから読む。
+			@param[in]	path	パス
+			@param[in]	gzip	gzip を受け付ける場合「true」
+			@param[out]	a		アセット
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool open_asset(const char* path, bool gzip, asset_t& a)
+		{
+			if(!open_) return false;
+			int32_t idx = find(path);
+			if(idx < 0) return false;
+
+			const entry_t& e = index_[idx];
+			a.idx = idx;
+			a.gz = gzip && e.gz_size > 0;
+			a.org = a.gz ? e.gz_offset : e.offset;
+			a.size = a.gz ? e.gz_size : e.size;
+			a.pos = 0;
+			a.ram = nullptr;
+			if(a.size > 0 && a.size <= CACHE_SLOT) {
+				a.ram = load_cache_(idx, a.gz, a.org, a.size);
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アセットの読み出し位置を設定
+			@param[in]	a	アセット
+			@param[in]	pos	位置
+		*/
+		//-----------------------------------------------------------------//
+		void seek(asset_t& a, uint32_t pos) const
+		{
+			a.pos = pos < a.size ? pos : a.size;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アセットのパック内の読み出し位置を返す（セクタ境界の判定用）
+			@param[in]	a	アセット
+			@return パック内の位置
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t tell(const asset_t& a) const { return a.org + a.pos; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アセットの読み出し
+			@param[in]	a	アセット
+			@param[out]	dst	読み出し先
+			@param[in]	len	最大長
+			@return 読み出した長さ（エラーなら０）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t read(asset_t& a, void* dst, uint32_t len)
+		{
+			if(len > (a.size - a.pos)) len = a.size - a.pos;
+			if(len == 0) return 0;
+			if(a.ram != nullptr) {
+				std::memcpy(dst, &a.ram[a.pos], len);
+			} else if(!read_at_(a.org + a.pos, dst, len)) {
+				return 0;
+			}
+			a.pos += len;
+			return len;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  クラスタ・サイズを返す（一度に読み込む量の上限）
+			@return クラスタ・サイズ
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_cluster_size() const
+		{
+			if(!open_) return web_pack_st::ALIGN;
+			return static_cast<uint32_t>(fil_.obj.fs->csize) * web_pack_st::ALIGN;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャッシュのヒット数を取得
+			@return ヒット数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_hit() const { return hit_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャッシュのミス数を取得
+			@return ミス数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_miss() const { return miss_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  エントリーの一覧
+		*/
+		//-----------------------------------------------------------------//
+		void list() const
+		{
+			for(uint32_t i = 0; i < num_; ++i) {
+				const entry_t& e = index_[i];
+				utils::format("%s: %d (gzip: %d)\n") % get_name(i) % e.size % e.gz_size;
+			}
+		}
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	Web パック（圧縮済み静的ファイル・アーカイブ）構造体 @n
+			ホスト側のパッカー（web_pack）と、ターゲット側の読み出し（utils::web_pack） @n
+			で共有する。@n
+			数値は全てリトル・エンディアンで、次の順に並ぶ。@n
+				header_t、entry_t × num（hash 昇順）、パス文字列（name_size）、@n
+				データ（align 境界に配置）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  Web パック構造体
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct web_pack_st {
+
+		static const uint32_t ALIGN = 512;	///< データ配置の境界（セクタ・サイズ）
+
+		//=================================================================//
+		/*!
+			@brief  ヘッダー（１６バイト）
+		*/
+		//=================================================================//
+		struct header_t {
+			char		magic[4];	///< "WPK1"
+			uint32_t	num;		///< エントリー数
+			uint32_t	name_size;	///< パス文字列領域のサイズ
+			uint32_t	align;		///< データ配置の境界
+		};
+
+
+		//=================================================================//
+		/*!
+			@brief  エントリー（３２バイト）
+		*/
+		//=================================================================//
+		struct entry_t {
+			uint32_t	hash;		///< パスのハッシュ（FNV-1a）
+			uint32_t	name;		///< パス文字列領域内のオフセット
+			uint32_t	offset;		///< 無圧縮データの位置
+			uint32_t	size;		///< 無圧縮データのサイズ
+			uint32_t	gz_offset;	///< gzip データの位置
+			uint32_t	gz_size;	///< gzip データのサイズ（０なら無し）
+			uint32_t	mtime;		///< 更新時間（UNIX 時間）
+			uint32_t	crc;		///< 無圧縮データの CRC32（ETag に使う）
+		};
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  マジックの検査
+			@param[in]	h	ヘッダー
+			@return 正しいなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		static bool check_magic(const header_t& h)
+		{
+			return h.magic[0] == 'W' && h.magic[1] == 'P' && h.magic[2] == 'K' && h.magic[3] == '1';
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  パスのハッシュ（FNV-1a ３２ビット）
+			@param[in]	path	パス
+			@return ハッシュ
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t hash(const char* path)
+		{
+			uint32_t h = 2166136261u;
+			while(*path != 0) {
+				h ^= static_cast<uint8_t>(*path++);
+				h *= 16777619u;
+			}
+			return h;
+		}
+	};
+}
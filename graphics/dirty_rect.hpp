@@ -0,0 +1,222 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	更新領域（ダーティー矩形）管理クラス @n
+			描画で変更された矩形を集め、重なる、又は接する矩形は一つにまとめる。@n
+			render の DIRTY パラメーターに指定すると、描画関数が自動で登録する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace graphics {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	更新領域を管理しない場合のクラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class dirty_null {
+	public:
+		void add(int16_t x, int16_t y, int16_t w, int16_t h) noexcept { }
+		void clear() noexcept { }
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	更新領域管理クラス
+		@param[in]	N	矩形の最大数（溢れた場合、面積の増加が最小になる矩形と統合）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint8_t N>
+	class dirty_rect {
+	public:
+
+		//=============================================================//
+		/*!
+			@brief	矩形
+		*/
+		//=============================================================//
+		struct rect_t {
+			int16_t	x;
+			int16_t	y;
+			int16_t	w;
+			int16_t	h;
+		};
+
+	private:
+		rect_t		rect_[N];
+		uint8_t		num_;
+
+		static int32_t area_(const rect_t& r) noexcept
+		{
+			return static_cast<int32_t>(r.w) * static_cast<int32_t>(r.h);
+		}
+
+
+		static rect_t union_(const rect_t& a, const rect_t& b) noexcept
+		{
+			int16_t x0 = a.x < b.x ? a.x : b.x;
+			int16_t y0 = a.y < b.y ? a.y : b.y;
+			int16_t x1 = (a.x + a.w) > (b.x + b.w) ? (a.x + a.w) : (b.x + b.w);
+			int16_t y1 = (a.y + a.h) > (b.y + b.h) ? (a.y + a.h) : (b.y + b.h);
+			rect_t r;
+			r.x = x0;
+			r.y = y0;
+			r.w = x1 - x0;
+			r.h = y1 - y0;
+			return r;
+		}
+
+
+		// 重なっている、又は接している場合「true」
+		static bool touch_(const rect_t& a, const rect_t& b) noexcept
+		{
+			return a.x <= (b.x + b.w) && b.x <= (a.x + a.w)
+				&& a.y <= (b.y + b.h) && b.y <= (a.y + a.h);
+		}
+
+
+		// a が b に含まれる場合「true」
+		static bool inside_(const rect_t& a, const rect_t& b) noexcept
+		{
+			return b.x <= a.x && b.y <= a.y && (a.x + a.w) <= (b.x + b.w) && (a.y + a.h) <= (b.y + b.h);
+		}
+
+
+		void remove_(uint8_t idx) noexcept
+		{
+			--num_;
+			rect_[idx] = rect_[num_];
+		}
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-------------------------------------------------------------//
+		dirty_rect() noexcept : rect_(), num_(0) { }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	矩形を追加
+			@param[in]	x	開始位置 X
+			@param[in]	y	開始位置 Y
+			@param[in]	w	横幅
+			@param[in]	h	高さ
+		*/
+		//-------------------------------------------------------------//
+		void add(int16_t x, int16_t y, int16_t w, int16_t h) noexcept
+		{
+			if(w <= 0 || h <= 0) return;
+
+			rect_t r;
+			r.x = x;
+			r.y = y;
+			r.w = w;
+			r.h = h;
+			// 最後に登録した矩形に含まれる場合が多いので、先に調べる
+			if(num_ > 0 && inside_(r, rect_[num_ - 1])) return;
+
+			uint8_t i = 0;
+			while(i < num_) {
+				const rect_t& t = rect_[i];
+				if(inside_(r, t)) return;
+				if(touch_(r, t)) {
+					// 統合した矩形は、他の矩形と接する場合があるので、最初から調べ直す
+					r = union_(r, t);
+					remove_(i);
+					i = 0;
+				} else {
+					++i;
+				}
+			}
+			while(num_ >= N) {
+				uint8_t idx = 0;
+				int32_t inc = 0x7fffffff;
+				for(uint8_t j = 0; j < num_; ++j) {
+					int32_t n = area_(union_(r, rect_[j])) - area_(rect_[j]);
+					if(n < inc) {
+						inc = n;
+						idx = j;
+					}
+				}
+				r = union_(r, rect_[idx]);
+				remove_(idx);
+			}
+			rect_[num_] = r;
+			++num_;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	全ての矩形を消去
+		*/
+		//-------------------------------------------------------------//
+		void clear() noexcept { num_ = 0; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	矩形の数を取得
+			@return 矩形の数
+		*/
+		//-------------------------------------------------------------//
+		uint8_t size() const noexcept { return num_; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	矩形を取得
+			@param[in]	idx	インデックス
+			@return 矩形
+		*/
+		//-------------------------------------------------------------//
+		const rect_t& get(uint8_t idx) const noexcept { return rect_[idx]; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	矩形の面積の合計を取得
+			@return 面積（ピクセル数）
+		*/
+		//-------------------------------------------------------------//
+		uint32_t area() const noexcept
+		{
+			uint32_t a = 0;
+			for(uint8_t i = 0; i < num_; ++i) {
+				a += area_(rect_[i]);
+			}
+			return a;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	領域が、更新された矩形と重なるか検査
+			@param[in]	x	開始位置 X
+			@param[in]	y	開始位置 Y
+			@param[in]	w	横幅
+			@param[in]	h	高さ
+			@return 重なる場合「true」
+		*/
+		//-------------------------------------------------------------//
+		bool intersect(int16_t x, int16_t y, int16_t w, int16_t h) const noexcept
+		{
+			for(uint8_t i = 0; i < num_; ++i) {
+				const rect_t& t = rect_[i];
+				if(x < (t.x + t.w) && t.x < (x + w) && y < (t.y + t.h) && t.y < (y + h)) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
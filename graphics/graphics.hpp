@@ -8,8 +8,12 @@
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cstring>
+#include <utility>
 #include "graphics/color.hpp"
+#include "graphics/dirty_rect.hpp"
 #include "common/intmath.hpp"
+#include "common/byte_order.h"
 
 namespace graphics {
 
@@ -48,9 +52,11 @@ namespace graphics {
 		@param[in]	HEIGHT	高さ
 		@param[in]	AFONT	ASCII フォント・クラス
 		@param[in]	KFONT	漢字フォントクラス
+		@param[in]	DIRTY	更新領域管理クラス（dirty_rect 等）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <typename T, uint16_t WIDTH, uint16_t HEIGHT, class AFONT = afont_null, class KFONT = kfont_null>
+	template <typename T, uint16_t WIDTH, uint16_t HEIGHT, class AFONT = afont_null, class KFONT = kfont_null,
+		class DIRTY = dirty_null>
 	class render {
 	public:
 		typedef T value_type;
@@ -86,6 +92,178 @@ namespace graphics {
 
 		int8_t		round_[round_radius];
 
+		DIRTY		dirty_;
+
+
+		// 矩形を画面でクリップする（描画する領域が無い場合「false」）
+		static bool clip_(int16_t& x, int16_t& y, int16_t& w, int16_t& h) noexcept
+		{
+			if(x < 0) {
+				w += x;
+				x = 0;
+			}
+			if(y < 0) {
+				h += y;
+				y = 0;
+			}
+			if((x + w) > static_cast<int16_t>(WIDTH)) {
+				w = static_cast<int16_t>(WIDTH) - x;
+			}
+			if((y + h) > static_cast<int16_t>(HEIGHT)) {
+				h = static_cast<int16_t>(HEIGHT) - y;
+			}
+			return w > 0 && h > 0;
+		}
+
+
+		// 水平方向のスパンを塗る（８、１６ビットのピクセルは、３２ビット単位で書く）
+		static void fill_span_(T* out, int16_t w, T c) noexcept
+		{
+			if(sizeof(T) < 4 && w >= 16) {
+				while((reinterpret_cast<uintptr_t>(out) & 3) != 0) {
+					*out++ = c;
+					--w;
+				}
+				uint32_t c32 = static_cast<uint32_t>(c);
+				if(sizeof(T) == 1) c32 |= c32 << 8;
+				c32 |= c32 << 16;
+				uint32_t* o = reinterpret_cast<uint32_t*>(out);
+				int16_t n = w / (4 / sizeof(T));
+				w -= n * (4 / sizeof(T));
+				while(n >= 4) {
+					o[0] = c32;
+					o[1] = c32;
+					o[2] = c32;
+					o[3] = c32;
+					o += 4;
+					n -= 4;
+				}
+				while(n > 0) {
+					*o++ = c32;
+					--n;
+				}
+				out = reinterpret_cast<T*>(o);
+			}
+			while(w > 0) {
+				*out++ = c;
+				--w;
+			}
+		}
+
+
+		// １ビット・イメージのビット位置から、最大２４ビットを取り出す
+		static uint32_t get_bits_(const uint8_t* p, uint32_t pos, uint32_t n) noexcept
+		{
+			p += pos >> 3;
+			uint32_t sh = pos & 7;
+			uint32_t bits = *p++;
+			for(uint32_t i = 8; i < (sh + n); i += 8) {
+				bits |= static_cast<uint32_t>(*p++) << i;
+			}
+			return (bits >> sh) & ((1 << n) - 1);
+		}
+
+
+		// ２ピクセルを uint32_t に詰める（左のピクセルを下位アドレスに置く）
+		// byte_order.h の BIG_ENDIAN などは値が無いので、コンパイラ定義のマクロで判定する
+		static uint32_t pack_pair_(T left, T right) noexcept
+		{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+			return (static_cast<uint32_t>(left) << 16) | right;
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+			return (static_cast<uint32_t>(right) << 16) | left;
+#else
+#error "graphics.hpp requires __BYTE_ORDER__ (GCC) to select the pixel pair order."
+#endif
+		}
+
+
+		// ビットマップの１行を展開する（背景有りは２ピクセル単位のテーブル、無しはセット・ビットのみ書く）
+		void expand_row_(T* out, const uint8_t* p, uint32_t pos, int16_t w, bool b, const uint32_t* pair)
+		noexcept {
+			const T col[2] = { bc_, fc_ };
+			while(w > 0) {
+				uint32_t n = w > 24 ? 24 : w;
+				uint32_t bits = get_bits_(p, pos, n);
+				pos += n;
+				w -= n;
+				if(b) {
+					if(sizeof(T) == 2) {
+						if((reinterpret_cast<uintptr_t>(out) & 2) != 0) {
+							*out++ = col[bits & 1];
+							bits >>= 1;
+							--n;
+						}
+						uint32_t* o = reinterpret_cast<uint32_t*>(out);
+						while(n >= 2) {
+							*o++ = pair[bits & 3];
+							bits >>= 2;
+							n -= 2;
+						}
+						out = reinterpret_cast<T*>(o);
+					}
+					while(n > 0) {
+						*out++ = col[bits & 1];
+						bits >>= 1;
+						--n;
+					}
+				} else {
+					while(bits != 0) {
+						out[__builtin_ctz(bits)] = fc_;
+						bits &= bits - 1;
+					}
+					out += n;
+				}
+			}
+		}
+
+
+		// 更新領域に登録する（画面でクリップする）
+		void mark_(int16_t x, int16_t y, int16_t w, int16_t h) noexcept
+		{
+			if(clip_(x, y, w, h)) dirty_.add(x, y, w, h);
+		}
+
+
+		// 点を描画する（更新領域には登録しない）
+		bool plot_(int16_t x, int16_t y, T c) noexcept
+		{
+			auto m = stipple_mask_;
+			stipple_mask_ <<= 1;
+			if(stipple_mask_ == 0) stipple_mask_ = 1;
+
+			if((stipple_ & m) == 0) {
+				return false;
+			}
+			if(static_cast<uint16_t>(x) >= WIDTH) return false;
+			if(static_cast<uint16_t>(y) >= HEIGHT) return false;
+			fb_[y * line_offset + x] = c;
+			return true;
+		}
+
+
+		// 破線パターン付きのビットマップ描画（plot 経由）
+		void draw_bitmap_plot_(int16_t x, int16_t y, const uint8_t* p, uint8_t w, uint8_t h, bool b)
+		noexcept {
+			mark_(x, y, w, h);
+			uint8_t k = 1;
+			uint8_t c = *p++;
+			for(uint8_t i = 0; i < h; ++i) {
+				int16_t xx = x;
+				for(uint8_t j = 0; j < w; ++j) {
+					if(c & k) plot_(xx, y, fc_);
+					else if(b) plot_(xx, y, bc_);
+					k <<= 1;
+					if(k == 0) {
+						k = 1;
+						c = *p++;
+					}
+					++xx;
+				}
+				++y;
+			}
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -94,7 +272,7 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		render(T* org, KFONT& kf) noexcept : fb_(org), kfont_(kf),
 			fc_(COLOR::White), bc_(COLOR::Black),
-			code_(0), cnt_(0), stipple_(-1), stipple_mask_(1)
+			code_(0), cnt_(0), stipple_(-1), stipple_mask_(1), dirty_()
 		{
 			for(int16_t r = 0; r < round_radius; ++r) {
 				round_[r] = intmath::sqrt16((round_radius * round_radius) - (r * r)).val;
@@ -111,6 +289,16 @@ namespace graphics {
 		const T* fb() const noexcept { return fb_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	更新領域管理クラスの参照 @n
+					フレームの先頭で「clear()」し、描画後に更新された矩形を参照する。
+			@return 更新領域管理クラス
+		*/
+		//-----------------------------------------------------------------//
+		DIRTY& at_dirty() noexcept { return dirty_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	フォア・カラーの取得
@@ -177,16 +365,7 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void plot(int16_t x, int16_t y, T c) noexcept
 		{
-			auto m = stipple_mask_;
-			stipple_mask_ <<= 1;
-			if(stipple_mask_ == 0) stipple_mask_ = 1;
-
-			if((stipple_ & m) == 0) {
-				return;
-			}
-			if(static_cast<uint16_t>(x) >= WIDTH) return;
-			if(static_cast<uint16_t>(y) >= HEIGHT) return;
-			fb_[y * line_offset + x] = c;
+			if(plot_(x, y, c)) dirty_.add(x, y, 1, 1);
 		}
 
 
@@ -212,10 +391,8 @@ namespace graphics {
 			if((x + w) >= static_cast<int16_t>(WIDTH)) {
 				w = static_cast<int16_t>(WIDTH) - x;
 			}
-			T* out = &fb_[y * line_offset + x];
-			for(int16_t i = 0; i < w; ++i) {
-				*out++ = c;
-			}
+			dirty_.add(x, y, w, 1);
+			fill_span_(&fb_[y * line_offset + x], w, c);
 		}
 
 
@@ -241,6 +418,7 @@ namespace graphics {
 			if((y + h) >= static_cast<int16_t>(HEIGHT)) {
 				h = static_cast<int16_t>(HEIGHT) - y;
 			}
+			dirty_.add(x, y, 1, h);
 			T* out = &fb_[y * line_offset + x];
 			for(int16_t i = 0; i < h; ++i) {
 				*out = c;
@@ -261,10 +439,13 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void fill_box(int16_t x, int16_t y, int16_t w, int16_t h, T c) noexcept
 		{
-			if(w <= 0 || h <= 0) return;
+			if(!clip_(x, y, w, h)) return;
 
-			for(int16_t yy = y; yy < (y + h); ++yy) {
-				line_h(yy, x, w, c);
+			dirty_.add(x, y, w, h);
+			T* out = &fb_[y * line_offset + x];
+			for(int16_t i = 0; i < h; ++i) {
+				fill_span_(out, w, c);
+				out += line_offset;
 			}
 		}
 
@@ -302,6 +483,7 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void clear(T c) noexcept
 		{
+			dirty_.add(0, 0, width, height);
 			if(sizeof(T) == 2) {  // 16 bits pixel
 				uint32_t c32 = (static_cast<uint32_t>(c) << 16) | c;
 				uint32_t* out = reinterpret_cast<uint32_t*>(fb_);
@@ -352,12 +534,14 @@ namespace graphics {
 			if(x2 >= x1) { dx = x2 - x1; sx = 1; } else { dx = x1 - x2; sx = -1; }
 			if(y2 >= y1) { dy = y2 - y1; sy = 1; } else { dy = y1 - y2; sy = -1; }
 
+			mark_(x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, dx + 1, dy + 1);
+
 			int16_t m = 0;
 			int16_t x = x1;
 			int16_t y = y1;
 			if(dx > dy) {
 				for(int16_t i = 0; i <= dx; i++) {
-					plot(x, y, c);
+					plot_(x, y, c);
 					m += dy;
 					if(m >= dx) {
 						m -= dx;
@@ -367,7 +551,7 @@ namespace graphics {
 				}
 			} else {
 				for(int16_t i = 0; i <= dy; i++) {
-					plot(x, y, c);
+					plot_(x, y, c);
 					m += dx;
 					if(m >= dy) {
 						m -= dy;
@@ -415,15 +599,16 @@ namespace graphics {
 			int16_t dy = 1;
 			int16_t err = dx - (r << 1);
 
+			mark_(x0 - r, y0 - r, r * 2 + 1, r * 2 + 1);
 			while(x >= y) {
-				plot(x0 + x, y0 + y, c);
-				plot(x0 + y, y0 + x, c);
-				plot(x0 - y, y0 + x, c);
-				plot(x0 - x, y0 + y, c);
-				plot(x0 - x, y0 - y, c);
-				plot(x0 - y, y0 - x, c);
-				plot(x0 + y, y0 - x, c);
-				plot(x0 + x, y0 - y, c);
+				plot_(x0 + x, y0 + y, c);
+				plot_(x0 + y, y0 + x, c);
+				plot_(x0 - y, y0 + x, c);
+				plot_(x0 - x, y0 + y, c);
+				plot_(x0 - x, y0 - y, c);
+				plot_(x0 - y, y0 - x, c);
+				plot_(x0 + y, y0 - x, c);
+				plot_(x0 + x, y0 - y, c);
 
 				if(err <= 0) {
 					y++;
@@ -490,16 +675,63 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void scroll(int16_t h) noexcept
 		{
+			if(h >= static_cast<int16_t>(HEIGHT) || h <= -static_cast<int16_t>(HEIGHT)) return;
+
+			if(h != 0) dirty_.add(0, 0, width, height);
 			if(h > 0) {
-				for(int32_t i = 0; i < (line_offset * (HEIGHT - h)); ++i) {
-					fb_[i] = fb_[i + (line_offset * h)];
-				}
+				std::memmove(&fb_[0], &fb_[line_offset * h], line_offset * (HEIGHT - h) * sizeof(T));
 			} else if(h < 0) {
 				h = -h;
-				for(int32_t i = (line_offset * (HEIGHT - h)) - 1; i >= 0; --i) {
-					fb_[i + (line_offset * h)] = fb_[i];
-				}
-			}			
+				std::memmove(&fb_[line_offset * h], &fb_[0], line_offset * (HEIGHT - h) * sizeof(T));
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イメージを転送する（画面でクリップされる）
+			@param[in]	src		転送元イメージ
+			@param[in]	stride	転送元イメージの横幅（ピクセル数）
+			@param[in]	sx		転送元Ｘ
+			@param[in]	sy		転送元Ｙ
+			@param[in]	w		転送する幅
+			@param[in]	h		転送する高さ
+			@param[in]	x		転送先Ｘ
+			@param[in]	y		転送先Ｙ
+		*/
+		//-----------------------------------------------------------------//
+		void blit(const T* src, int16_t stride, int16_t sx, int16_t sy, int16_t w, int16_t h,
+			int16_t x, int16_t y) noexcept
+		{
+			if(src == nullptr) return;
+
+			int16_t ox = x;
+			int16_t oy = y;
+			if(!clip_(x, y, w, h)) return;
+			dirty_.add(x, y, w, h);
+			src += (sy + y - oy) * stride + sx + x - ox;
+			T* out = &fb_[y * line_offset + x];
+			for(int16_t i = 0; i < h; ++i) {
+				std::memcpy(out, src, w * sizeof(T));
+				src += stride;
+				out += line_offset;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イメージ全体を転送する（画面でクリップされる）
+			@param[in]	x	転送先Ｘ
+			@param[in]	y	転送先Ｙ
+			@param[in]	src	転送元イメージ
+			@param[in]	w	イメージの幅
+			@param[in]	h	イメージの高さ
+		*/
+		//-----------------------------------------------------------------//
+		void blit(int16_t x, int16_t y, const T* src, int16_t w, int16_t h) noexcept
+		{
+			blit(src, w, 0, 0, w, h, x, y);
 		}
 
 
@@ -519,21 +751,31 @@ namespace graphics {
 			if(img == nullptr) return;
 
 			const uint8_t* p = static_cast<const uint8_t*>(img);
-			uint8_t k = 1;
-			uint8_t c = *p++;
-			for(uint8_t i = 0; i < h; ++i) {
-				int16_t xx = x;
-				for(uint8_t j = 0; j < w; ++j) {
-					if(c & k) plot(xx, y, fc_);
-					else if(b) plot(xx, y, bc_);
-					k <<= 1;
-					if(k == 0) {
-						k = 1;
-						c = *p++;
-					}
-					++xx;
-				}
-				++y;
+			if(stipple_ != 0xffffffff) {
+				draw_bitmap_plot_(x, y, p, w, h, b);
+				return;
+			}
+
+			int16_t cx = x;
+			int16_t cy = y;
+			int16_t cw = w;
+			int16_t ch = h;
+			if(!clip_(cx, cy, cw, ch)) return;
+			dirty_.add(cx, cy, cw, ch);
+
+			// 背景有りの場合の２ピクセル分のカラー（ビット０が左）
+			const uint32_t pair[4] = {
+				pack_pair_(bc_, bc_),
+				pack_pair_(fc_, bc_),
+				pack_pair_(bc_, fc_),
+				pack_pair_(fc_, fc_)
+			};
+			uint32_t pos = (cy - y) * w + (cx - x);
+			T* out = &fb_[cy * line_offset + cx];
+			for(int16_t i = 0; i < ch; ++i) {
+				expand_row_(out, p, pos, cw, b, pair);
+				pos += w;
+				out += line_offset;
 			}
 		}
 
@@ -723,7 +965,7 @@ namespace graphics {
 			int16_t x = (width  - w) / 2;
 			int16_t y = (height - h) / 2;
 			frame(x, y, w, h, COLOR::White);
-			fill(x + 1, y + 1, w - 2, h - 2, COLOR::Black);
+			fill_box(x + 1, y + 1, w - 2, h - 2, COLOR::Black);
 			auto l = get_text_length(text);
 			x += (w - l) / 2;
 			y += (h - font_height) / 2;
@@ -746,7 +988,7 @@ namespace graphics {
 		void draw_button(int16_t x, int16_t y, int16_t w, int16_t h, const char* text) noexcept
 		{
 			auto len = get_text_length(text);
-			fill(x, y, w, h, bc_);
+			fill_box(x, y, w, h, bc_);
 			x += (w - len) / 2;
 			y += (h - font_height) / 2;
 			draw_text(x, y, text);
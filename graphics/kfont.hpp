@@ -9,11 +9,16 @@
 */
 //=====================================================================//
 #include <cstdint>
+#include <cstring>
 #include "ff12b/src/ff.h"
 
 // 漢字フォントデータをＳＤカード上に置いて、キャッシュアクセスする場合有効にする
 // #define CASH_KFONT
 
+// unicode からリニア・インデックスへの変換テーブル（graphics/kfont_uni.cpp）を使う場合有効にする
+// ※無効の場合、ff_convert による二分探索で変換する
+// #define KFONT_UNI_TABLE
+
 extern "C" {
 #ifdef CASH_KFONT
 	int fatfs_get_mount();
@@ -28,16 +33,27 @@ namespace graphics {
 	};
 #endif
 
+#ifdef KFONT_UNI_TABLE
+	struct kfont_uni {
+		static const uint8_t page_[256];		///< unicode 上位バイト → テーブル番号（0xff は無し）
+		static const uint16_t liner_[][256];	///< unicode 下位バイト → リニア・インデックス
+	};
+#endif
+
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief	漢字フォント・テンプレート・クラス
+		@brief	漢字フォント・テンプレート・クラス @n
+				CASH_KFONT の場合、フォント・ファイルは開いたままにして、@n
+				セクタ単位で読み込んだブロックから、グリフをキャッシュへ取り出す。@n
+				キャッシュはハッシュで引き、溢れた場合はクロック方式で入れ替える。
 		@param[in]	WIDTH	フォントの横幅
 		@param[in]	HEIGHT	フォントの高さ
-		@param[in]	CASHN	キャッシュ数
+		@param[in]	CASHN	キャッシュ数（２５５以下）
+		@param[in]	BLOCKN	セクタ・ブロック数
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 #ifdef CASH_KFONT
-	template <int8_t WIDTH, int8_t HEIGHT, uint8_t CASHN>
+	template <int8_t WIDTH, int8_t HEIGHT, uint8_t CASHN, uint8_t BLOCKN = 2>
 #else
 	template <int8_t WIDTH, int8_t HEIGHT>
 #endif
@@ -46,13 +62,135 @@ namespace graphics {
 		static const uint32_t FONTS = ((WIDTH * HEIGHT) + 7) / 8;
 
 #ifdef CASH_KFONT
+		static const uint32_t HASHN = 64;		///< ハッシュ・テーブルのサイズ（２のべき乗）
+		static const uint32_t SECTOR = 512;		///< 先読みするブロックのサイズ
+		static const uint8_t  NONE = 0xff;
+
 		struct kanji_cash {
 			uint16_t	code;
+			uint8_t		next;	///< 同じハッシュの次のエントリー
+			uint8_t		ref;	///< 参照ビット
 			uint8_t		bitmap[FONTS];
-			kanji_cash() noexcept : code(0), bitmap{ 0 } { }
+			kanji_cash() noexcept : code(0), next(NONE), ref(0), bitmap{ 0 } { }
 		};
 		kanji_cash cash_[CASHN];
+		uint8_t	hash_[HASHN];
 		uint8_t cash_idx_;
+		uint8_t cash_num_;
+
+		struct block_t {
+			uint32_t	sector;
+			uint32_t	stamp;
+			uint8_t		data[SECTOR];
+		};
+		block_t		block_[BLOCKN];
+		uint32_t	stamp_;
+
+		FIL			fil_;
+		bool		open_;
+
+		uint32_t	hit_;
+		uint32_t	miss_;
+		uint32_t	read_;
+
+		static uint32_t hash_idx_(uint16_t code) noexcept {
+			return (code ^ (code >> 6)) & (HASHN - 1);
+		}
+
+
+		void unlink_(uint8_t idx) noexcept {
+			uint8_t* p = &hash_[hash_idx_(cash_[idx].code)];
+			while(*p != NONE) {
+				if(*p == idx) {
+					*p = cash_[idx].next;
+					return;
+				}
+				p = &cash_[*p].next;
+			}
+		}
+
+
+		// 空きが無ければ、参照ビットの落ちているエントリーを選ぶ
+		uint8_t select_() noexcept {
+			if(cash_num_ < CASHN) {
+				return cash_num_++;
+			}
+			while(1) {
+				++cash_idx_;
+				if(cash_idx_ >= CASHN) cash_idx_ = 0;
+				kanji_cash& c = cash_[cash_idx_];
+				if(c.ref == 0) break;
+				c.ref = 0;
+			}
+			unlink_(cash_idx_);
+			return cash_idx_;
+		}
+
+
+		void close_() noexcept {
+			if(open_) {
+				f_close(&fil_);
+				open_ = false;
+			}
+			for(uint8_t i = 0; i < BLOCKN; ++i) {
+				block_[i].sector = 0xffffffff;
+			}
+		}
+
+
+		const uint8_t* load_block_(uint32_t sector) noexcept {
+			++stamp_;
+			uint8_t old = 0;
+			uint32_t age = 0;
+			for(uint8_t i = 0; i < BLOCKN; ++i) {
+				block_t& b = block_[i];
+				if(b.sector == sector) {
+					b.stamp = stamp_;
+					return b.data;
+				}
+				uint32_t n = b.sector == 0xffffffff ? 0xffffffff : (stamp_ - b.stamp);
+				if(n > age) {
+					age = n;
+					old = i;
+				}
+			}
+			if(!open_) {
+				if(f_open(&fil_, "/kfont16.bin", FA_READ) != FR_OK) {
+					return nullptr;
+				}
+				open_ = true;
+			}
+			block_t& b = block_[old];
+			b.sector = 0xffffffff;
+			UINT rs = 0;
+			if(f_lseek(&fil_, sector * SECTOR) != FR_OK
+			  || f_read(&fil_, b.data, SECTOR, &rs) != FR_OK || rs == 0) {
+				close_();  // カードの入れ替え等で無効になった場合、次回開き直す
+				return nullptr;
+			}
+			++read_;
+			b.sector = sector;
+			b.stamp = stamp_;
+			return b.data;
+		}
+
+
+		bool read_glyph_(uint32_t lin, uint8_t* dst) noexcept {
+			uint32_t pos = lin * FONTS;
+			uint32_t len = FONTS;
+			while(len > 0) {  // セクタ境界を跨ぐグリフは、二つのブロックから取り出す
+				auto p = load_block_(pos / SECTOR);
+				if(p == nullptr) return false;
+				uint32_t ofs = pos % SECTOR;
+				uint32_t n = SECTOR - ofs;
+				if(n > len) n = len;
+				std::memcpy(dst, &p[ofs], n);
+				dst += n;
+				pos += n;
+				len -= n;
+			}
+			return true;
+		}
 #endif
 
 		static uint16_t sjis_to_liner_(uint16_t sjis)
@@ -82,16 +220,44 @@ namespace graphics {
 		}
 
 	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	unicode をフォントのリニア・インデックスに変換
+			@param[in]	code	文字コード（unicode）
+			@return リニア・インデックス（無い場合「0xffff」）
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t to_liner(uint16_t code) noexcept
+		{
+#ifdef KFONT_UNI_TABLE
+			auto n = kfont_uni::page_[code >> 8];
+			if(n == 0xff) return 0xffff;
+			return kfont_uni::liner_[n][code & 0xff];
+#else
+			return sjis_to_liner_(ff_convert(code, 0));
+#endif
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		kfont() noexcept 
+		kfont() noexcept
 #ifdef CASH_KFONT
-			: cash_(), cash_idx_(0)
-#endif
+			: cash_(), cash_idx_(0), cash_num_(0), stamp_(0), fil_(), open_(false),
+			hit_(0), miss_(0), read_(0)
+			{
+				for(uint32_t i = 0; i < HASHN; ++i) hash_[i] = NONE;
+				for(uint8_t i = 0; i < BLOCKN; ++i) {
+					block_[i].sector = 0xffffffff;
+					block_[i].stamp = 0;
+				}
+			}
+#else
 			{ }
+#endif
 
 
 		//-----------------------------------------------------------------//
@@ -123,56 +289,74 @@ namespace graphics {
 
 #ifdef CASH_KFONT
 			// キャッシュ内検索
-			int8_t n = -1;
-			for(uint8_t i = 0; i < CASHN; ++i) {
+			for(uint8_t i = hash_[hash_idx_(code)]; i != NONE; i = cash_[i].next) {
 				if(cash_[i].code == code) {
+					cash_[i].ref = 1;
+					++hit_;
 					return &cash_[i].bitmap[0];
-				} else if(cash_[i].code == 0) {
-					n = i;
-				}
-			}
-			if(n >= 0) cash_idx_ = n;
-			else {
-				for(uint8_t i = 0; i < CASHN; ++i) {
-					++cash_idx_;
-					if(cash_idx_ >= CASHN) cash_idx_ = 0;
-					if(cash_[cash_idx_].code != 0) {
-						break;
-					}
 				}
 			}
+			++miss_;
 
-			if(fatfs_get_mount() == 0) return nullptr;
+			if(fatfs_get_mount() == 0) {
+				close_();
+				return nullptr;
+			}
 #endif
-			uint32_t lin = sjis_to_liner_(ff_convert(code, 0));
+			uint32_t lin = to_liner(code);
 
 			if(lin == 0xffff) {
 				return nullptr;
 			}
 #ifdef CASH_KFONT
-			FIL fp;
-			if(f_open(&fp, "/kfont16.bin", FA_READ) != FR_OK) {
-				return nullptr;
-			}
- 
-			if(f_lseek(&fp, lin * FONTS) != FR_OK) {
-				f_close(&fp);
-				return nullptr;
-			}
-
-			UINT rs;
-			if(f_read(&fp, &cash_[cash_idx_].bitmap[0], FONTS, &rs) != FR_OK) {
-				f_close(&fp);
+			uint8_t idx = select_();
+			kanji_cash& c = cash_[idx];
+			c.code = 0;
+			if(!read_glyph_(lin, &c.bitmap[0])) {
+				c.next = NONE;
+				// 登録に失敗したエントリーは、次に選ばれるように空きとして扱う
+				if(idx == (cash_num_ - 1)) --cash_num_;
 				return nullptr;
 			}
-			cash_[cash_idx_].code = code;
+			c.code = code;
+			c.ref = 0;
+			uint8_t& h = hash_[hash_idx_(code)];
+			c.next = h;
+			h = idx;
 
-			f_close(&fp);
-
-			return &cash_[cash_idx_].bitmap[0];
+			return &c.bitmap[0];
 #else
 			return &kfont_bitmap::kfont_start[lin * FONTS];
 #endif
 		}
+
+
+#ifdef CASH_KFONT
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュのヒット数を取得
+			@return ヒット数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_hit() const noexcept { return hit_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュのミス数を取得
+			@return ミス数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_miss() const noexcept { return miss_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ファイルから読み込んだブロック数を取得
+			@return ブロック数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_read() const noexcept { return read_; }
+#endif
 	};
 }
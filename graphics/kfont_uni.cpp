@@ -0,0 +1,1768 @@
+//=====================================================================//
+/*!	@file
+	@brief	unicode → 漢字フォント・リニア・インデックス変換テーブル @n
+			※graphics_bench -uni で生成（CP932）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#ifndef KFONT_UNI_TABLE
+#define KFONT_UNI_TABLE
+#endif
+#include "graphics/kfont.hpp"
+
+namespace graphics {
+
+const uint8_t kfont_uni::page_[256] = {
+0x00,0xFF,0xFF,0x01,0x02,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0x03,0x04,0x05,0x06,0x07,0x08,0x09,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0x0A,0xFF,0x0B,0x0C,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x0D,0x0E,
+0x0F,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,
+0x1F,0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,
+0x2F,0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,
+0x3F,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,
+0x4F,0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x5F,
+};
+
+const uint16_t kfont_uni::liner_[][256] = {
+{ // U+0000
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0057,0x000E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x004A,0x003D,0xFFFF,0xFFFF,0x000C,0xFFFF,0x00B6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x003E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x003F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+0300
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x01D6,0x01D7,0x01D8,0x01D9,0x01DA,0x01DB,0x01DC,0x01DD,0x01DE,0x01DF,0x01E0,0x01E1,0x01E2,0x01E3,0x01E4,
+0x01E5,0x01E6,0xFFFF,0x01E7,0x01E8,0x01E9,0x01EA,0x01EB,0x01EC,0x01ED,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x01F6,0x01F7,0x01F8,0x01F9,0x01FA,0x01FB,0x01FC,0x01FD,0x01FE,0x01FF,0x0200,0x0201,0x0202,0x0203,0x0204,
+0x0205,0x0206,0xFFFF,0x0207,0x0208,0x0209,0x020A,0x020B,0x020C,0x020D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+0400
+0xFFFF,0x023A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0234,0x0235,0x0236,0x0237,0x0238,0x0239,0x023B,0x023C,0x023D,0x023E,0x023F,0x0240,0x0241,0x0242,0x0243,0x0244,
+0x0245,0x0246,0x0247,0x0248,0x0249,0x024A,0x024B,0x024C,0x024D,0x024E,0x024F,0x0250,0x0251,0x0252,0x0253,0x0254,
+0x0264,0x0265,0x0266,0x0267,0x0268,0x0269,0x026B,0x026C,0x026D,0x026E,0x026F,0x0270,0x0271,0x0272,0x0273,0x0274,
+0x0275,0x0276,0x0277,0x0278,0x0279,0x027A,0x027B,0x027C,0x027D,0x027E,0x027F,0x0280,0x0281,0x0282,0x0283,0x0284,
+0xFFFF,0x026A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2000
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x001D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x001C,0xFFFF,0xFFFF,0x0025,0x0026,0xFFFF,0xFFFF,0x0027,0x0028,0xFFFF,0xFFFF,
+0x00B4,0x00B5,0xFFFF,0xFFFF,0xFFFF,0x0024,0x0023,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x00B0,0xFFFF,0x004B,0x004C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0065,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2100
+0xFFFF,0xFFFF,0xFFFF,0x004D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04A9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x04AB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x00AF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x047C,0x047D,0x047E,0x047F,0x0480,0x0481,0x0482,0x0483,0x0484,0x0485,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0068,0x0069,0x0067,0x006A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x008A,0xFFFF,0x008B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2200
+0x008C,0xFFFF,0x009C,0x008D,0xFFFF,0xFFFF,0xFFFF,0x009D,0x0077,0xFFFF,0xFFFF,0x0078,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x04BB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x00A2,0xFFFF,0xFFFF,0x00A4,0x0046,0x04BF,
+0x0099,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0021,0xFFFF,0x0087,0x0088,0x007E,0x007D,0x00A6,0x00A7,0xFFFF,0x04BA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0047,0x00A5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x00A3,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x009F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0041,0x009E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0044,0x0045,0xFFFF,0xFFFF,0x00A0,0x00A1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x007B,0x007C,0xFFFF,0xFFFF,0x0079,0x007A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x009A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04C0,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2300
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x009B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2400
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0468,0x0469,0x046A,0x046B,0x046C,0x046D,0x046E,0x046F,0x0470,0x0471,0x0472,0x0473,0x0474,0x0475,0x0476,0x0477,
+0x0478,0x0479,0x047A,0x047B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2500
+0x0292,0x029D,0x0293,0x029E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0294,0xFFFF,0xFFFF,0x029F,
+0x0295,0xFFFF,0xFFFF,0x02A0,0x0297,0xFFFF,0xFFFF,0x02A2,0x0296,0xFFFF,0xFFFF,0x02A1,0x0298,0x02AD,0xFFFF,0xFFFF,
+0x02A8,0xFFFF,0xFFFF,0x02A3,0x029A,0x02AF,0xFFFF,0xFFFF,0x02AA,0xFFFF,0xFFFF,0x02A5,0x0299,0xFFFF,0xFFFF,0x02A9,
+0x02AE,0xFFFF,0xFFFF,0x02A4,0x029B,0xFFFF,0xFFFF,0x02AB,0x02B0,0xFFFF,0xFFFF,0x02A6,0x029C,0xFFFF,0xFFFF,0x02AC,
+0xFFFF,0xFFFF,0x02B1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x02A7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0060,0x005F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0062,0x0061,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0064,0x0063,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x005E,0x005D,0xFFFF,0xFFFF,0xFFFF,0x005A,0xFFFF,0xFFFF,0x005C,0x005B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x00BB,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+2600
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0059,0x0058,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0049,0xFFFF,0x0048,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x00B3,0xFFFF,0xFFFF,0x00B2,0xFFFF,0x00B1,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+3000
+0x0000,0x0001,0x0002,0x0016,0xFFFF,0x0018,0x0019,0x001A,0x0031,0x0032,0x0033,0x0034,0x0035,0x0036,0x0037,0x0038,
+0x0039,0x003A,0x0066,0x006B,0x002B,0x002C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04A7,0xFFFF,0x04A8,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x011A,0x011B,0x011C,0x011D,0x011E,0x011F,0x0120,0x0121,0x0122,0x0123,0x0124,0x0125,0x0126,0x0127,0x0128,
+0x0129,0x012A,0x012B,0x012C,0x012D,0x012E,0x012F,0x0130,0x0131,0x0132,0x0133,0x0134,0x0135,0x0136,0x0137,0x0138,
+0x0139,0x013A,0x013B,0x013C,0x013D,0x013E,0x013F,0x0140,0x0141,0x0142,0x0143,0x0144,0x0145,0x0146,0x0147,0x0148,
+0x0149,0x014A,0x014B,0x014C,0x014D,0x014E,0x014F,0x0150,0x0151,0x0152,0x0153,0x0154,0x0155,0x0156,0x0157,0x0158,
+0x0159,0x015A,0x015B,0x015C,0x015D,0x015E,0x015F,0x0160,0x0161,0x0162,0x0163,0x0164,0x0165,0x0166,0x0167,0x0168,
+0x0169,0x016A,0x016B,0x016C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x000A,0x000B,0x0014,0x0015,0xFFFF,
+0xFFFF,0x0178,0x0179,0x017A,0x017B,0x017C,0x017D,0x017E,0x017F,0x0180,0x0181,0x0182,0x0183,0x0184,0x0185,0x0186,
+0x0187,0x0188,0x0189,0x018A,0x018B,0x018C,0x018D,0x018E,0x018F,0x0190,0x0191,0x0192,0x0193,0x0194,0x0195,0x0196,
+0x0197,0x0198,0x0199,0x019A,0x019B,0x019C,0x019D,0x019E,0x019F,0x01A0,0x01A1,0x01A2,0x01A3,0x01A4,0x01A5,0x01A6,
+0x01A7,0x01A8,0x01A9,0x01AA,0x01AB,0x01AC,0x01AD,0x01AE,0x01AF,0x01B0,0x01B1,0x01B2,0x01B3,0x01B4,0x01B5,0x01B6,
+0x01B7,0x01B8,0x01B9,0x01BA,0x01BB,0x01BC,0x01BD,0x01BE,0x01BF,0x01C0,0x01C1,0x01C2,0x01C3,0x01C4,0x01C5,0x01C6,
+0x01C7,0x01C8,0x01C9,0x01CA,0x01CB,0x01CC,0x01CD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0005,0x001B,0x0012,0x0013,0xFFFF,
+},
+{ // U+3200
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x04B1,0x04B2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04B3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04AC,0x04AD,0x04AE,0x04AF,0x04B0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+3300
+0xFFFF,0xFFFF,0xFFFF,0x048D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0491,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0488,0xFFFF,0xFFFF,0xFFFF,0x048B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0489,0x0493,0xFFFF,0xFFFF,0x0492,0x048C,0xFFFF,0xFFFF,0xFFFF,0x0494,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x048E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0496,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0487,0x0495,0xFFFF,0xFFFF,0x048A,0xFFFF,0xFFFF,
+0xFFFF,0x048F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0490,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04A6,0x04B6,0x04B5,0x04B4,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x049A,0x049B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0497,0x0498,0x0499,0xFFFF,
+0xFFFF,0x049D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x049C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x04AA,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+4E00
+0x05CD,0x0CD5,0xFFFF,0x0A00,0xFFFF,0xFFFF,0xFFFF,0x0FC7,0x0AEB,0x099B,0x0AEA,0x0659,0xFFFF,0x0EE3,0x1046,0xFFFF,
+0x1143,0x05EE,0xFFFF,0xFFFF,0x06E9,0x1144,0x0B65,0x121F,0x078D,0x0F27,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AEC,0xFFFF,
+0xFFFF,0x10A3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F2F,0xFFFF,0xFFFF,0xFFFF,0x1145,0xFFFF,0xFFFF,0x0CC1,0xFFFF,0xFFFF,
+0xFFFF,0x1146,0x080F,0xFFFF,0xFFFF,0xFFFF,0x1147,0xFFFF,0x0736,0x0C8B,0xFFFF,0x0A30,0x1148,0xFFFF,0xFFFF,0x1149,
+0xFFFF,0xFFFF,0x114A,0x0E08,0xFFFF,0x078E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E0A,0xFFFF,0x0DD8,0x0894,0x0F7E,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A98,0x114B,0x0AED,0x114C,0x0652,0xFFFF,0xFFFF,0xFFFF,0x07FA,0x08C1,0x1012,
+0xFFFF,0xFFFF,0x137B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1077,0xFFFF,0x0DF2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06FE,0xFFFF,
+0x076C,0xFFFF,0x114D,0xFFFF,0xFFFF,0x114E,0x10A0,0xFFFF,0x1044,0x0C07,0x1150,0x09E1,0x0DE8,0xFFFF,0x1153,0xFFFF,
+0xFFFF,0x05FD,0x08B0,0xFFFF,0x08AF,0x05C7,0xFFFF,0xFFFF,0x110E,0x110D,0xFFFF,0x0940,0x0582,0xFFFF,0x1154,0x1155,
+0x1156,0x0F7F,0x1157,0xFFFF,0x08C3,0x05C8,0x0FBD,0xFFFF,0x07B3,0xFFFF,0xFFFF,0x07B4,0x07B5,0x0D1B,0x10A1,0xFFFF,
+0x1158,0xFFFF,0xFFFF,0x1159,0xFFFF,0xFFFF,0x115A,0xFFFF,0xFFFF,0xFFFF,0x0B30,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0A61,0x0B31,0x115F,0xFFFF,0x115D,0xFFFF,0x115E,0x078F,0xFFFF,0xFFFF,0x0930,0x068D,0xFFFF,0x115C,0x115B,0x0F16,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09B1,0x09B0,0x0C3B,0x1160,0x0EE4,0x0BA8,0xFFFF,0xFFFF,0xFFFF,0x0017,0x1161,0x1163,
+0xFFFF,0xFFFF,0xFFFF,0x0C62,0x10C6,0x05AB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1162,0x065B,0xFFFF,
+0x07D9,0xFFFF,0x0CC2,0xFFFF,0xFFFF,0xFFFF,0x0862,0x1164,0xFFFF,0xFFFF,0xFFFF,0x0DF7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+4F00
+0xFFFF,0x0744,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1165,0x05AC,0xFFFF,0xFFFF,0x08B1,0x0745,0x0F09,
+0x0E63,0x0790,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x068E,0xFFFF,0x1188,0x0D58,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E3F,
+0x1167,0xFFFF,0xFFFF,0xFFFF,0x0E6D,0xFFFF,0x10C7,0xFFFF,0x0B10,0xFFFF,0x09B2,0xFFFF,0x09E2,0x065D,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0D0A,0xFFFF,0xFFFF,0x0C7D,0x116B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05AD,0x0D1C,0x0A62,
+0x0941,0x102B,0xFFFF,0x0C4B,0xFFFF,0x065C,0xFFFF,0x116A,0xFFFF,0x1045,0x1166,0x1168,0x097B,0x1169,0x131B,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1171,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1174,
+0x1172,0xFFFF,0xFFFF,0x065F,0xFFFF,0x0F28,0x116C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1170,0x08C4,0xFFFF,0xFFFF,0x09B3,
+0xFFFF,0xFFFF,0xFFFF,0x06FF,0xFFFF,0xFFFF,0x1175,0xFFFF,0x116D,0xFFFF,0xFFFF,0x10C8,0xFFFF,0x09E3,0xFFFF,0x116E,
+0xFFFF,0x1173,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1176,0xFFFF,0x116F,0xFFFF,0xFFFF,0x07B6,0xFFFF,0x05AE,0xFFFF,0xFFFF,
+0x07B7,0x065E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x131C,0xFFFF,0x0FC4,0x0EFD,0x08C5,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B12,0x109C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F45,
+0xFFFF,0xFFFF,0x082B,0x0C22,0x0681,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A7A,0xFFFF,0xFFFF,0xFFFF,0x117A,0xFFFF,
+0x117F,0x117D,0xFFFF,0xFFFF,0x1178,0xFFFF,0xFFFF,0x0C2C,0x117B,0xFFFF,0x117E,0x117C,0xFFFF,0x0F4A,0xFFFF,0x1179,
+0xFFFF,0x0B11,0xFFFF,0x0FBE,0x1180,0x1181,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A4B,0x118E,
+0xFFFF,0xFFFF,0xFFFF,0x0E23,0xFFFF,0x0EC5,0x1189,0xFFFF,0x0F5D,0xFFFF,0x0653,0xFFFF,0xFFFF,0xFFFF,0x118D,0xFFFF,
+},
+{ // U+5000
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1187,0x1190,0xFFFF,0xFFFF,0x0BF1,0xFFFF,0x0895,0xFFFF,0x0E2F,0xFFFF,0x1748,
+0xFFFF,0x118F,0x0D74,0xFFFF,0x1184,0xFFFF,0x08C7,0xFFFF,0xFFFF,0x08C6,0x1182,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A23,
+0xFFFF,0x118A,0xFFFF,0x0F5C,0x0CA8,0x1186,0x0864,0xFFFF,0x1183,0x118B,0x1185,0x10B6,0x118C,0x1104,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07FB,0xFFFF,0xFFFF,0x0863,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1191,0xFFFF,0xFFFF,0xFFFF,0x1192,0x1196,0x05AF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F3D,
+0x1195,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1194,0x1198,0xFFFF,0xFFFF,0xFFFF,0x1197,0xFFFF,0x0D1D,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0865,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1199,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0A0E,0xFFFF,0x0C23,0x0D1E,0x080B,0xFFFF,0x119A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x076D,0xFFFF,0xFFFF,
+0x119B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x119D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F80,0xFFFF,0xFFFF,
+0xFFFF,0x0859,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x099C,0x0EA8,0x119C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0952,0x104A,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x119F,0x11A2,0x119E,0x0951,0xFFFF,0x0AA4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x082C,0xFFFF,
+0xFFFF,0xFFFF,0x11A3,0xFFFF,0xFFFF,0x07E4,0xFFFF,0xFFFF,0xFFFF,0x11A0,0x11A1,0xFFFF,0xFFFF,0x0DA4,0xFFFF,0x0C1B,
+0xFFFF,0x07B8,0xFFFF,0xFFFF,0xFFFF,0x0F98,0x11A4,0xFFFF,0xFFFF,0xFFFF,0x10A2,0xFFFF,0xFFFF,0xFFFF,0x11A5,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x11A8,0xFFFF,0x11A6,0xFFFF,0x0BED,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11A7,0x11A9,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11AB,0xFFFF,0xFFFF,0xFFFF,0x11AA,0xFFFF,0x0F35,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+5100
+0x076E,0x11AD,0x11AE,0xFFFF,0x064C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11AC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0A3D,0xFFFF,0x11B1,0x11B0,0x11AF,0xFFFF,0x1177,0xFFFF,0x11B2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AA5,
+0xFFFF,0x11B3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x102C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1002,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11B5,0xFFFF,0xFFFF,0x11B4,0x11B7,0x11B6,0xFFFF,0xFFFF,0x11B8,
+0x11B9,0x05D5,0xFFFF,0x0886,0x082E,0x0A63,0x0CD6,0x07B9,0x0BA9,0x08C8,0xFFFF,0x091D,0x11BB,0x0FF1,0x0D5D,0xFFFF,
+0x09E4,0xFFFF,0x11BA,0xFFFF,0x11BC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D75,0xFFFF,0x06F0,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x11BD,0xFFFF,0xFFFF,0x0DF3,0xFFFF,0xFFFF,0x0BD3,0x11BF,0x11C0,0x0E5D,0x08C9,0x10FE,0x11C1,0xFFFF,
+0xFFFF,0x07BB,0xFFFF,0xFFFF,0xFFFF,0x0F29,0x0C33,0x0806,0x0D4C,0xFFFF,0xFFFF,0xFFFF,0x0866,0xFFFF,0xFFFF,0xFFFF,
+0x11C2,0xFFFF,0x11C3,0xFFFF,0xFFFF,0x0DD7,0x061E,0xFFFF,0xFFFF,0x11C6,0x098A,0xFFFF,0x11C5,0x0953,0xFFFF,0x11C7,
+0x19A3,0x11C8,0x0F8C,0x11C9,0xFFFF,0x11CA,0x11CB,0x0AEE,0xFFFF,0x0A15,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0700,0xFFFF,0x11CE,0xFFFF,0x11CC,0x0FE6,0x11CD,0xFFFF,0x0EE9,0x11CF,0x11D0,0x11D1,0x0D76,0xFFFF,0xFFFF,0xFFFF,
+0x11D5,0x11D3,0x11D4,0x11D2,0x0970,0x11D6,0x1013,0x10C9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11D7,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B69,0x11D8,0x0A81,0xFFFF,0xFFFF,0x11D9,0xFFFF,0x0CD7,0x10A4,0x0D77,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1222,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11DA,0x1E7E,0x07DA,0xFFFF,0xFFFF,
+0x11DB,0x0FA9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A8F,0x0C79,0xFFFF,0x11DD,0x0DD9,0xFFFF,0xFFFF,0x11DE,0xFFFF,0xFFFF,
+0x11DF,0x06A9,0xFFFF,0xFFFF,0xFFFF,0x11E0,0x07BC,0xFFFF,0x0DC1,0x0639,0x0A77,0xFFFF,0xFFFF,0x0E52,0x11E1,0xFFFF,
+},
+{ // U+5200
+0x0D78,0xFFFF,0xFFFF,0x0B32,0x11E2,0xFFFF,0x0F19,0x0B9B,0x06FB,0xFFFF,0x0702,0x11E3,0xFFFF,0xFFFF,0x11E5,0xFFFF,
+0xFFFF,0x082D,0xFFFF,0xFFFF,0x11E4,0xFFFF,0xFFFF,0x10D8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A90,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E6E,0x0F39,0xFFFF,0x11E6,0xFFFF,0x107F,0x11E7,0xFFFF,0xFFFF,0xFFFF,0x11E8,0xFFFF,
+0x0D95,0xFFFF,0xFFFF,0x11E9,0xFFFF,0xFFFF,0x0B6A,0x098B,0x0867,0x11EA,0x09B4,0x091E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0D1F,0x11EC,0xFFFF,0xFFFF,0x0C24,0xFFFF,0xFFFF,0x097C,0x11ED,0x11EE,0x0BCF,0xFFFF,0x11EB,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11F0,0xFFFF,0x0F81,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0913,0xFFFF,0xFFFF,0x11EF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0868,0x096B,0x0E40,0xFFFF,0xFFFF,0xFFFF,0x11F3,0x11F1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F0A,
+0x0AEF,0x11FA,0x06DF,0x11F4,0x11F2,0x0BEE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x11F6,0xFFFF,0x11F5,
+0xFFFF,0xFFFF,0xFFFF,0x06BF,0xFFFF,0xFFFF,0xFFFF,0x0853,0x11FB,0x1092,0xFFFF,0xFFFF,0xFFFF,0x11F7,0xFFFF,0xFFFF,
+0xFFFF,0x11FC,0x11F9,0xFFFF,0x11F8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10B4,0xFFFF,0xFFFF,0xFFFF,0x08CA,
+0x0660,0xFFFF,0xFFFF,0x10D9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A9C,0x0D6F,0x0914,0x11FF,0x1200,0xFFFF,0xFFFF,
+0xFFFF,0x10CA,0xFFFF,0xFFFF,0x10EE,0x1202,0xFFFF,0xFFFF,0xFFFF,0x08CB,0xFFFF,0xFFFF,0x1201,0xFFFF,0x06AA,0xFFFF,
+0xFFFF,0x1203,0xFFFF,0x0FA1,0xFFFF,0x0CF5,0xFFFF,0x102D,0xFFFF,0x0F46,0xFFFF,0xFFFF,0xFFFF,0x1204,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1D36,0xFFFF,0xFFFF,0x0DA5,0xFFFF,0x1205,0x0703,0x0FDC,0xFFFF,0xFFFF,0xFFFF,0x0AA6,0x1206,0x0F54,
+0x120A,0xFFFF,0x0B6B,0x1207,0x07E5,0xFFFF,0x1208,0x0704,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0821,0x120B,0xFFFF,0x120C,0xFFFF,0xFFFF,0x120D,0x120E,0x0A24,0xFFFF,0xFFFF,0xFFFF,0x08CC,0x1007,
+},
+{ // U+5300
+0xFFFF,0x1011,0x0DEC,0xFFFF,0xFFFF,0x0F5E,0x120F,0xFFFF,0x1210,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1212,0xFFFF,0x1214,
+0x1213,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1215,0x065A,0x0F97,0xFFFF,0x0989,0x1216,0xFFFF,0xFFFF,0x0BF8,0xFFFF,0xFFFF,
+0x0AA7,0x07BE,0xFFFF,0x1217,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E8C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1218,
+0xFFFF,0x1219,0xFFFF,0x121A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x121B,0x0EB3,0x07FD,0x05C6,0xFFFF,0xFFFF,0xFFFF,0x0DB4,
+0x121C,0x0A64,0xFFFF,0x0BAA,0xFFFF,0x121E,0x121D,0x0AA8,0x08B2,0x1220,0x0E6F,0xFFFF,0xFFFF,0x1221,0xFFFF,0xFFFF,
+0xFFFF,0x0E8D,0x0C31,0x0C6B,0x07BD,0xFFFF,0xFFFF,0x0DE3,0x0C8C,0xFFFF,0x0E41,0xFFFF,0x0F99,0xFFFF,0x1223,0xFFFF,
+0x0BAB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0828,0xFFFF,0xFFFF,0x1224,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1225,0x05EB,
+0x05D6,0x0746,0xFFFF,0x0C25,0x0788,0x1078,0xFFFF,0x1228,0x0654,0xFFFF,0xFFFF,0x1227,0xFFFF,0xFFFF,0xFFFF,0x07BF,
+0xFFFF,0xFFFF,0x1229,0xFFFF,0x101A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x122A,0xFFFF,0x10B7,0xFFFF,0x08CD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0887,
+0x122B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x122D,0x122C,0xFFFF,0x0B42,0x05F8,0xFFFF,0xFFFF,0xFFFF,0x061D,0x122E,0xFFFF,
+0x122F,0xFFFF,0xFFFF,0x0888,0xFFFF,0xFFFF,0x1230,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07A5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x099D,0x1231,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FBF,0x0942,0x0791,0x102E,0x0BEF,0x0E70,0x0A46,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A6E,0xFFFF,0x0A31,0x0A3E,0xFFFF,0x0A9D,0xFFFF,0x0E71,0xFFFF,0xFFFF,0xFFFF,0x1234,
+0xFFFF,0x0602,0x0BF0,0x08CE,0x0896,0x07FC,0xFFFF,0xFFFF,0x1238,0x0C7C,0x0C7B,0x07C0,0x0AA9,0x1239,0x1237,0x0661,
+0x0C63,0x0A01,0x09B6,0x05E5,0xFFFF,0xFFFF,0x06EB,0x0915,0x09B5,0xFFFF,0x123A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+5400
+0xFFFF,0x123B,0xFFFF,0x0780,0x06C1,0xFFFF,0xFFFF,0xFFFF,0x0916,0x077F,0x0D18,0x05E4,0x0DA6,0x0FE7,0x08D0,0x1080,
+0x0D5E,0x08CF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0822,0xFFFF,0x1244,0xFFFF,0x07F8,
+0x0F95,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E8E,0xFFFF,0xFFFF,0x1243,0xFFFF,0x0737,0x123E,0x123F,0x1241,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1242,0xFFFF,0x0792,0x0B44,0xFFFF,0x0F1A,0x1240,0x123C,0x08B4,0xFFFF,
+0x123D,0xFFFF,0x10E7,0xFFFF,0xFFFF,0xFFFF,0x0F5F,0xFFFF,0x0D21,0x08B3,0x091F,0xFFFF,0xFFFF,0xFFFF,0x1245,0xFFFF,
+0xFFFF,0x0DD2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1249,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A47,0xFFFF,0x0A3F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x124C,0x124A,0xFFFF,0x0FCC,0xFFFF,0x1247,0x1250,0x124B,0xFFFF,0xFFFF,0xFFFF,0x124E,0x0897,0x0FE8,0xFFFF,0xFFFF,
+0x124F,0xFFFF,0xFFFF,0xFFFF,0x1251,0xFFFF,0x1253,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x097D,0x1105,0xFFFF,0x1248,0x1246,
+0x1252,0xFFFF,0x124D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1255,0xFFFF,0x125E,0x1257,0xFFFF,0xFFFF,0x125B,0xFFFF,0xFFFF,0x125C,0x1258,0xFFFF,0xFFFF,0x1279,
+0xFFFF,0xFFFF,0x0976,0x06AC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1256,0xFFFF,0xFFFF,0xFFFF,0x1260,0x05D7,0x125F,0xFFFF,
+0x0586,0x0ED9,0x125D,0xFFFF,0x1259,0xFFFF,0xFFFF,0x1254,0x125A,0x0955,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1261,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x05D8,0x126A,0xFFFF,0xFFFF,0x1262,0x1263,0xFFFF,0x0AAA,0x0FB4,0xFFFF,0xFFFF,0xFFFF,0x1268,0x1267,0xFFFF,
+0xFFFF,0xFFFF,0x0D46,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1269,0xFFFF,0xFFFF,0x1266,0xFFFF,0xFFFF,
+},
+{ // U+5500
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05F3,0xFFFF,0x0943,0x0B13,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1264,
+0x0D79,0xFFFF,0xFFFF,0xFFFF,0x1265,0xFFFF,0x0583,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x126F,0x102A,
+0xFFFF,0x0AAC,0xFFFF,0x1275,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1274,0x126B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C40,0xFFFF,
+0x126C,0xFFFF,0xFFFF,0xFFFF,0x0C6C,0x1271,0x0AAB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x126E,0xFFFF,0xFFFF,0x100D,
+0xFFFF,0xFFFF,0xFFFF,0x082F,0xFFFF,0xFFFF,0x1272,0x1273,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1270,0x1276,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x126D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x127C,0x1281,0xFFFF,0x127D,0xFFFF,
+0x1278,0xFFFF,0xFFFF,0x1282,0x0BD0,0xFFFF,0xFFFF,0x1284,0xFFFF,0x08D1,0x127A,0x0CD8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x127E,0x1277,0x0706,0xFFFF,0x0747,0x06E0,0x127F,0x127B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0869,0x1285,0x1283,0x0BF2,0x0781,0x07C1,0xFFFF,0x1280,0xFFFF,
+0x0809,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0603,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1289,0x1287,0xFFFF,0x12C0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x128C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1286,0xFFFF,0x128A,0xFFFF,0xFFFF,0x1288,
+0xFFFF,0xFFFF,0xFFFF,0x09B7,0x128B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x128E,0xFFFF,0x1293,0xFFFF,0xFFFF,0xFFFF,0x1291,0x1290,0xFFFF,
+},
+{ // U+5600
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C8D,0xFFFF,0xFFFF,0x0662,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x128D,0xFFFF,0x128F,0x0AAD,0x05F2,0xFFFF,0xFFFF,0x1292,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x067B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x129D,
+0xFFFF,0x0B01,0x1299,0xFFFF,0x1297,0xFFFF,0x1298,0xFFFF,0x129A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x05FC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BD8,0xFFFF,0x1294,0xFFFF,
+0x1295,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06F5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x129C,0xFFFF,0xFFFF,0xFFFF,0x0748,0xFFFF,0x129F,0x129B,0x129E,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F1B,0xFFFF,0xFFFF,0xFFFF,0x0DCA,0xFFFF,0x0E69,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12A1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12A0,0x06C0,0xFFFF,0xFFFF,0x12A2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12A5,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12A4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12A3,0xFFFF,0x0E0C,0xFFFF,0xFFFF,0x12A6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12A7,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12A9,0xFFFF,0x12A8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12AB,0xFFFF,0xFFFF,0xFFFF,
+0x12AE,0x12AC,0x12AA,0x12AD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12AF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12B0,0xFFFF,
+0xFFFF,0x12B1,0xFFFF,0x12B2,0xFFFF,0xFFFF,0xFFFF,0x12B3,0x11C4,0xFFFF,0x0A45,0x09B8,0xFFFF,0xFFFF,0x0690,0xFFFF,
+0x05D9,0xFFFF,0xFFFF,0x0C9F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12B4,0xFFFF,
+0x0931,0xFFFF,0x05B0,0x0B41,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12B5,0x0898,0xFFFF,0xFFFF,0x0920,0xFFFF,0x12B7,
+},
+{ // U+5700
+0x12B6,0xFFFF,0xFFFF,0x0F4D,0x12B8,0xFFFF,0xFFFF,0xFFFF,0x12BA,0x12B9,0xFFFF,0x12BB,0xFFFF,0x12BC,0xFFFF,0x086A,
+0xFFFF,0xFFFF,0x061F,0x12BD,0xFFFF,0xFFFF,0x12BF,0xFFFF,0x12BE,0xFFFF,0xFFFF,0xFFFF,0x12C1,0xFFFF,0xFFFF,0x0D71,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12C2,0x0596,0x096C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0830,0xFFFF,0xFFFF,
+0x0CAA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12C3,0x12C4,0xFFFF,0xFFFF,0x12C6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12C7,0xFFFF,0x0971,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07E6,0xFFFF,0xFFFF,0x0F82,0xFFFF,0xFFFF,0xFFFF,0x12C5,0x12C8,
+0x094E,0x08D2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x12CC,0xFFFF,0xFFFF,0x0932,0xFFFF,0x0C8E,0xFFFF,0xFFFF,0x12C9,0x0D13,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12CD,
+0xFFFF,0xFFFF,0x0B45,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12CB,0x12CE,0xFFFF,0x0832,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x12CF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12D0,0xFFFF,0x08D3,0x06BB,0x12D2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12D3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12D4,0xFFFF,0xFFFF,0x12D1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12CA,0xFFFF,0xFFFF,0x12D5,0xFFFF,0xFFFF,0x12D6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FAF,0xFFFF,0xFFFF,0x0AF0,0xFFFF,
+0xFFFF,0xFFFF,0x12D8,0x12D9,0x12D7,0xFFFF,0x12DB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E0B,0xFFFF,0xFFFF,0x05C9,
+0x0EE5,0xFFFF,0xFFFF,0x12DC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B02,0xFFFF,0xFFFF,0x0A02,0xFFFF,0x0E30,0x0749,0xFFFF,0x0978,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+5800
+0x0FA4,0xFFFF,0x0DA7,0xFFFF,0xFFFF,0x086B,0x0C4C,0xFFFF,0xFFFF,0xFFFF,0x12DA,0x12DD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C41,0xFFFF,0xFFFF,0xFFFF,0x12DE,0xFFFF,0xFFFF,0xFFFF,0x12DF,0xFFFF,0xFFFF,
+0xFFFF,0x12E1,0xFFFF,0xFFFF,0x0D22,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0707,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E7A,
+0x0620,0x0F60,0xFFFF,0xFFFF,0x0AF1,0x0D5F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0973,0xFFFF,0xFFFF,0x12E7,0xFFFF,0xFFFF,
+0x0F2A,0x10C2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0691,0x12E3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0BD9,0x12E6,0xFFFF,0x0D7A,0xFFFF,0xFFFF,0x0D60,0x0D7B,0x0E6A,0x0D06,0xFFFF,0xFFFF,0xFFFF,0x0956,0xFFFF,
+0xFFFF,0xFFFF,0x12E2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0635,0xFFFF,0x0D4D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x12E4,0xFFFF,0x12E0,0xFFFF,0xFFFF,0x0B33,0xFFFF,0xFFFF,0xFFFF,0x12E8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A75,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x07C2,0xFFFF,0x12E9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0F55,0xFFFF,0xFFFF,0xFFFF,0x0C1C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CFF,0xFFFF,0xFFFF,0x12EB,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F9A,0xFFFF,0xFFFF,0x12EC,0xFFFF,0xFFFF,0x12F1,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0F1C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12F0,0x12EA,0x12ED,0x12EF,0xFFFF,0xFFFF,0x0933,0xFFFF,
+0xFFFF,0x0F36,0xFFFF,0xFFFF,0xFFFF,0x12F2,0xFFFF,0x0CA0,0xFFFF,0xFFFF,0x0692,0xFFFF,0x0AF2,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x12F4,0xFFFF,0x12F3,0xFFFF,0x0917,0xFFFF,0x12F5,0x12F7,0x12F6,0xFFFF,0xFFFF,0x12F9,0xFFFF,0x12EE,0x12FB,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x12FA,0x12F8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09B9,0x0B34,0xFFFF,0x0BF3,0x12FC,
+0x0B7D,0x05CE,0x0E37,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D14,0xFFFF,0x12FE,0x12FD,0x12FF,0x1300,0x1301,0xFFFF,0xFFFF,
+},
+{ // U+5900
+0xFFFF,0xFFFF,0x1302,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F3E,0x1303,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0663,
+0x1304,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1043,0x06AB,0xFFFF,0x1226,0x0A6F,0x0C3C,0x1305,0x1014,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0FDD,0xFFFF,0xFFFF,0x1307,0xFFFF,0x0C64,0xFFFF,0x0D4E,0x0C3D,0x0EE6,0x1308,0x1309,0x063A,0xFFFF,
+0xFFFF,0x0A03,0x130A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05B1,0x130B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x130C,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0621,0xFFFF,0xFFFF,0x074A,0x0DD5,0x0F61,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1310,0x0BF4,
+0x130F,0x0833,0xFFFF,0xFFFF,0x0FA6,0x130E,0xFFFF,0x0D7C,0x1312,0xFFFF,0x1311,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1314,0xFFFF,0x1313,0xFFFF,0xFFFF,0x063B,0xFFFF,0x1315,0x0AAE,0x1317,0x0C80,0xFFFF,0x1316,0xFFFF,0x0F20,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0A9E,0x0D72,0xFFFF,0xFFFF,0xFFFF,0x1318,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08D4,0xFFFF,0xFFFF,
+0xFFFF,0x1319,0x0DF4,0x0E8F,0x0FFA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DF8,0xFFFF,0xFFFF,0x1322,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x076F,0xFFFF,0xFFFF,0x104C,0xFFFF,0xFFFF,0x0FD8,0xFFFF,0x1381,0xFFFF,0x131A,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x131D,0xFFFF,0x0C42,0xFFFF,0xFFFF,0x0F83,0xFFFF,0xFFFF,0xFFFF,0x0D61,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x131E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FB0,0xFFFF,0x0957,0xFFFF,0xFFFF,0x0AAF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x131F,0xFFFF,0xFFFF,0x09BB,0xFFFF,0x09BA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x059A,0x0899,0xFFFF,0x0B6C,0x05B2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1323,0x1324,0xFFFF,0x1321,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05F7,0x0708,0xFFFF,0x1320,0xFFFF,0x0FEE,0x0EC0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0589,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05DA,0xFFFF,0xFFFF,0xFFFF,0x09BC,
+},
+{ // U+5A00
+0xFFFF,0x05B3,0xFFFF,0x0584,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1329,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1327,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FE5,0xFFFF,0x132A,0xFFFF,0x1328,0xFFFF,0xFFFF,0x1326,
+0x0B14,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1325,0xFFFF,0xFFFF,0xFFFF,0x0F47,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08B5,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x132E,0x132F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AB0,0xFFFF,0xFFFF,0xFFFF,
+0x132B,0x10EF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E1F,0xFFFF,0xFFFF,0x132D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0934,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1330,0xFFFF,0xFFFF,0xFFFF,0x0EE7,0xFFFF,0xFFFF,0xFFFF,0x1331,0xFFFF,0x132C,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FE4,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0E31,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1332,0x0EC1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1333,0x1337,0x1334,0xFFFF,
+0xFFFF,0x0664,0x1336,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A04,0xFFFF,0x1335,0x086C,0xFFFF,0xFFFF,0xFFFF,
+0x1343,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x133C,0x1339,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0CBF,0xFFFF,0x1338,0xFFFF,0xFFFF,0x133A,0xFFFF,0xFFFF,0x133B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x133D,0x133E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+5B00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x074B,0xFFFF,0x1340,0x133F,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1341,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0AF3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1344,0xFFFF,0x0D15,0xFFFF,0xFFFF,0xFFFF,
+0x0604,0xFFFF,0x1342,0xFFFF,0xFFFF,0xFFFF,0x1345,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1346,0xFFFF,
+0x1349,0xFFFF,0xFFFF,0x1347,0xFFFF,0x1348,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x09BD,0x134A,0xFFFF,0xFFFF,0x08D5,0x134B,0xFFFF,0x09E5,0x0C35,0xFFFF,0x134C,0x134D,0x09C5,0x08D6,0xFFFF,0x0FFB,
+0xFFFF,0xFFFF,0xFFFF,0x075F,0x089A,0x134E,0x06D3,0xFFFF,0xFFFF,0x134F,0xFFFF,0x0C36,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1350,0x1378,0xFFFF,0x1351,0xFFFF,0x1352,0xFFFF,0xFFFF,0x1353,0xFFFF,0x1355,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1356,0xFFFF,0xFFFF,0x1357,0xFFFF,0x0C6D,0xFFFF,0x05E6,0x0A32,0x05A3,0xFFFF,0x0BF6,0x0709,0x09FE,0xFFFF,0x08D7,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D7D,0xFFFF,0x0A48,0x070A,0x0CC3,0x0D23,0x0599,0x0770,0x0F62,0xFFFF,0x0A0B,
+0xFFFF,0xFFFF,0x0789,0x0BAC,0x0A05,0x102F,0x1358,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0793,0xFFFF,
+0x0958,0xFFFF,0xFFFF,0x06AD,0x0622,0x0AB1,0x0665,0xFFFF,0x1359,0x104D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A70,
+0xFFFF,0xFFFF,0x0A2D,0x135A,0x074C,0x0DC7,0x0FD2,0x135B,0xFFFF,0x135C,0xFFFF,0xFFFF,0x0EE8,0xFFFF,0xFFFF,0xFFFF,
+0x135E,0xFFFF,0x0701,0x080C,0x135D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x070B,0xFFFF,0x0B15,0x1362,0x098C,
+0xFFFF,0x0666,0x1361,0xFFFF,0x135F,0x1363,0x1360,0x0DFE,0x15D6,0x0B16,0xFFFF,0x1364,0xFFFF,0xFFFF,0x10A5,0xFFFF,
+0x1365,0xFFFF,0xFFFF,0x1367,0xFFFF,0x0CD9,0x1366,0xFFFF,0x0B64,0xFFFF,0x09E6,0xFFFF,0xFFFF,0xFFFF,0x0C4D,0x0A40,
+},
+{ // U+5C00
+0xFFFF,0x0F04,0x0BAD,0xFFFF,0x0A16,0x1368,0x0AB2,0x1369,0x136A,0x05B4,0x0C37,0x0B35,0xFFFF,0x136B,0x0DA8,0x0AB3,
+0xFFFF,0x0AB4,0xFFFF,0x136C,0xFFFF,0xFFFF,0x0BAE,0xFFFF,0xFFFF,0xFFFF,0x0AB5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x136D,0xFFFF,0x136E,0xFFFF,0x1009,0xFFFF,0xFFFF,0xFFFF,0x136F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07DB,0xFFFF,0xFFFF,
+0xFFFF,0x0A49,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1370,0x1371,0x0A25,0x0B0F,0x0DE9,0x0B37,0x0EA9,0x0DF5,
+0x07DE,0x1372,0xFFFF,0xFFFF,0xFFFF,0x07A6,0x1373,0xFFFF,0x0813,0xFFFF,0x0DC4,0x064D,0xFFFF,0x09BE,0x1374,0x1377,
+0x1376,0x0812,0xFFFF,0x1375,0xFFFF,0x0D4F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C2D,0xFFFF,
+0x0D62,0x0A11,0xFFFF,0xFFFF,0x0BF7,0x1081,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1379,0xFFFF,0x137A,0x0DCB,
+0xFFFF,0x099E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x137C,0xFFFF,0xFFFF,0x137D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x137E,0xFFFF,0xFFFF,0xFFFF,
+0x074D,0x137F,0xFFFF,0xFFFF,0x1380,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0649,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BDA,0x073D,0xFFFF,0x1382,0x0FD1,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0C4F,0xFFFF,0x06D4,0xFFFF,0xFFFF,0x1384,0x1386,0x0738,0xFFFF,0xFFFF,0x1383,0x1385,0xFFFF,0x1388,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1387,0xFFFF,0x1389,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x138A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0DB2,0x07C3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0682,0x138B,0x1390,0xFFFF,0xFFFF,0x138E,0xFFFF,0x0F64,
+0x0F63,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D7E,0xFFFF,0xFFFF,0xFFFF,0x138D,0x0A7B,0xFFFF,0x138C,0xFFFF,0xFFFF,
+},
+{ // U+5D00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B55,0xFFFF,0xFFFF,0xFFFF,0x1391,0xFFFF,0xFFFF,0x0977,0xFFFF,
+0xFFFF,0x1397,0xFFFF,0xFFFF,0x1398,0x1392,0x06AE,0x1393,0x139C,0x139B,0x139A,0x1396,0xFFFF,0xFFFF,0xFFFF,0x1395,
+0xFFFF,0xFFFF,0x1399,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F65,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13A0,0x139D,0xFFFF,0x139F,0xFFFF,
+0x1079,0xFFFF,0x139E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1394,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B56,0xFFFF,0xFFFF,0x13A1,0xFFFF,0xFFFF,0x0944,
+0xFFFF,0xFFFF,0xFFFF,0x13A2,0xFFFF,0xFFFF,0x13A3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x13A6,0xFFFF,0x13A5,0xFFFF,0xFFFF,0x13A4,0xFFFF,0xFFFF,0xFFFF,0x0D7F,0x138F,0xFFFF,0xFFFF,0xFFFF,
+0x13AC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13A8,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x13A7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13A9,0xFFFF,0x13AA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13AD,0xFFFF,0xFFFF,0x10CB,0xFFFF,0x13AE,0x13AB,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13AF,0xFFFF,0xFFFF,0x0739,0x13B0,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x13B2,0x13B1,0xFFFF,0xFFFF,0x13B3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13B4,0xFFFF,0x0BAF,0x0A4A,0xFFFF,
+0xFFFF,0x0A8B,0xFFFF,0x0C02,0xFFFF,0x08D8,0x0945,0x08D9,0x07A7,0xFFFF,0xFFFF,0x13B5,0xFFFF,0xFFFF,0x0946,0xFFFF,
+0xFFFF,0x089B,0x13B6,0x0FCF,0x0E16,0x13B7,0xFFFF,0x08DA,0xFFFF,0xFFFF,0xFFFF,0x0705,0xFFFF,0x0C82,0x07E7,0xFFFF,
+},
+{ // U+5E00
+0xFFFF,0xFFFF,0x09BF,0x0EEA,0xFFFF,0xFFFF,0x0E72,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13B8,0x074E,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x13BB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CDA,0xFFFF,0xFFFF,0x13BA,0x13B9,0x13BC,0xFFFF,0x0D24,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B46,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09C0,0xFFFF,0x0B8B,0xFFFF,0x0C50,
+0x0759,0xFFFF,0xFFFF,0x0CDB,0xFFFF,0xFFFF,0x13BD,0x13BE,0x0AF4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F84,0xFFFF,0xFFFF,
+0x13C1,0xFFFF,0xFFFF,0x13C0,0x13BF,0x0F0C,0xFFFF,0x13C8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FA5,0xFFFF,0x13C2,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13C4,0x0FB6,0xFFFF,0x13C3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13C5,
+0xFFFF,0x0E59,0x13C6,0x0F2B,0x13C7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x070C,0x0F2C,0x0E02,0x13C9,0x13CA,0xFFFF,0x08DB,0x070D,0x13CB,0x0889,0x104B,0x1030,0x074F,0x13CD,
+0xFFFF,0x0CDC,0xFFFF,0x08DC,0x0AB6,0xFFFF,0xFFFF,0x0E90,0xFFFF,0xFFFF,0x0AB7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A9F,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D25,0x0F66,0x0D50,0xFFFF,0xFFFF,0x08DD,0xFFFF,0x0EEB,0xFFFF,0xFFFF,0xFFFF,
+0x13CE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D70,0x094F,0xFFFF,0xFFFF,0xFFFF,0x089C,0xFFFF,0x0D26,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05A4,0x0A95,0x08DE,0x104E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x13CF,0x13D0,0x0E24,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13D1,0x10DC,0x10F0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13D3,
+0x13D2,0xFFFF,0xFFFF,0x06C2,0xFFFF,0xFFFF,0x13D4,0xFFFF,0xFFFF,0xFFFF,0x13D7,0x13D8,0xFFFF,0x13D6,0xFFFF,0x0ECF,
+0x0AB8,0x13DA,0x13D9,0x13D5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13DB,0x13DC,0xFFFF,0xFFFF,0x13DD,0xFFFF,0xFFFF,0xFFFF,
+0x13E0,0x13DE,0xFFFF,0x13DF,0x13E1,0xFFFF,0x0623,0x0D27,0x13E2,0xFFFF,0x086D,0x0693,0x0E09,0xFFFF,0x13E3,0x0DF0,
+},
+{ // U+5F00
+0xFFFF,0x0F48,0xFFFF,0x13E4,0x10F1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13E5,0x0F2D,0x13E8,0x1142,0x1152,0xFFFF,0x09F9,
+0x0DEA,0x13E9,0xFFFF,0x0794,0x0CDD,0x05DB,0x13EA,0x0F13,0x08DF,0xFFFF,0xFFFF,0x0CAB,0xFFFF,0xFFFF,0xFFFF,0x0D28,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1018,0x088A,0x089D,0xFFFF,0x13EB,0xFFFF,0xFFFF,0xFFFF,0x13EC,0xFFFF,0x13F2,
+0xFFFF,0x0A2E,0xFFFF,0xFFFF,0xFFFF,0x0CDE,0xFFFF,0x07C4,0x13ED,0xFFFF,0xFFFF,0xFFFF,0x0EBA,0xFFFF,0x0CA1,0xFFFF,
+0xFFFF,0x13EE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x13EF,0xFFFF,0x07C5,0xFFFF,0x13F0,0xFFFF,0x13F1,0xFFFF,
+0xFFFF,0x13F3,0xFFFF,0x0D8D,0xFFFF,0xFFFF,0x13F4,0x13F5,0xFFFF,0x13F6,0xFFFF,0xFFFF,0x13E7,0x13E6,0xFFFF,0xFFFF,
+0xFFFF,0x13F7,0x0834,0xFFFF,0xFFFF,0xFFFF,0x0EB6,0xFFFF,0xFFFF,0x0959,0x0EC6,0x0CDF,0x0EDA,0x13F8,0xFFFF,0xFFFF,
+0x0AB9,0x0605,0xFFFF,0x13F9,0xFFFF,0xFFFF,0xFFFF,0x13FA,0xFFFF,0x101B,0xFFFF,0xFFFF,0x0E91,0xFFFF,0xFFFF,0x13FD,
+0x063C,0x0B6D,0x13FC,0x13FB,0x0835,0x0C51,0xFFFF,0x1401,0x13FF,0xFFFF,0x13FE,0x108C,0x08B6,0xFFFF,0xFFFF,0xFFFF,
+0x0AA0,0x1400,0x0D63,0x0A65,0xFFFF,0xFFFF,0xFFFF,0x0DB5,0x1404,0x1403,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1402,0xFFFF,
+0x1405,0x08B7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1406,0x0F0B,0x0A82,0xFFFF,0xFFFF,0x1407,0x0EAA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0DB6,0x0CE0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D47,0xFFFF,0xFFFF,0x1408,0x0762,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0B17,0xFFFF,0x0EBB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0750,0x0DF9,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1409,0x09C1,0x0F85,0x0F86,0xFFFF,0xFFFF,0x063D,0x140E,0xFFFF,0xFFFF,
+0x0CC4,0xFFFF,0xFFFF,0xFFFF,0x140B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0694,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x143E,0x140D,0xFFFF,0xFFFF,0xFFFF,0x0E03,0xFFFF,0xFFFF,0x140C,0xFFFF,0xFFFF,0x140A,0xFFFF,0x0929,0xFFFF,0x1410,
+},
+{ // U+6000
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1416,0x141C,
+0x1414,0xFFFF,0x0D73,0xFFFF,0xFFFF,0x1419,0x0EEC,0xFFFF,0xFFFF,0x1413,0xFFFF,0x1418,0x10CC,0x09C2,0xFFFF,0xFFFF,
+0x0C52,0x1411,0xFFFF,0xFFFF,0xFFFF,0x0795,0x141B,0x0B6E,0x0624,0x1415,0x0695,0x141A,0xFFFF,0xFFFF,0xFFFF,0x07C6,
+0xFFFF,0x1417,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x141D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x141F,0x1429,0x1427,0xFFFF,0xFFFF,0x1424,0xFFFF,0xFFFF,0xFFFF,0x1423,0x10DD,0xFFFF,0x1425,0xFFFF,0xFFFF,
+0x07C7,0xFFFF,0x08E0,0xFFFF,0xFFFF,0x0AA1,0xFFFF,0xFFFF,0xFFFF,0x142C,0x141E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1422,
+0x1412,0xFFFF,0x0697,0x1426,0x1428,0x0CAC,0xFFFF,0xFFFF,0x0935,0x0655,0x1420,0x142B,0x142A,0x07C8,0xFFFF,0x0C26,
+0x06E1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0836,0xFFFF,0x1421,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x142D,0xFFFF,0x1430,0x1432,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A06,0xFFFF,0x1438,0x0D29,0x142E,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1436,0xFFFF,0x0696,0xFFFF,0x1434,0x1435,0xFFFF,0xFFFF,0x1431,0x1433,0xFFFF,0xFFFF,0xFFFF,0x08B8,
+0x1031,0xFFFF,0xFFFF,0x070E,0xFFFF,0xFFFF,0x0618,0x1437,0xFFFF,0x0E0D,0x058E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0E92,0x140F,0x143D,0x1441,0x100E,0xFFFF,0x143A,0xFFFF,0xFFFF,0xFFFF,0x0D80,0x143F,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AF5,0x1440,0x0DCC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x110A,0xFFFF,0x143C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1442,0xFFFF,0x092A,0xFFFF,0x0B8C,0xFFFF,0xFFFF,0x05B5,
+0x143B,0x1439,0xFFFF,0x0BF9,0xFFFF,0xFFFF,0xFFFF,0x142F,0x099F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0C43,0x144E,0xFFFF,0x0BFA,0x1449,0xFFFF,0x1446,0x1447,0xFFFF,0x0A2F,0x144A,0x144D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6100
+0x1448,0x0A4C,0xFFFF,0x144B,0xFFFF,0xFFFF,0x1445,0xFFFF,0x1025,0x1024,0xFFFF,0xFFFF,0xFFFF,0x144F,0x1450,0x05B6,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1444,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0807,0x0587,0xFFFF,0xFFFF,0xFFFF,0x070F,
+0xFFFF,0x144C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1454,0x1453,0xFFFF,0xFFFF,0xFFFF,0x1458,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1459,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1457,0x145A,0x1452,0x1456,
+0xFFFF,0xFFFF,0x145B,0xFFFF,0x145C,0xFFFF,0xFFFF,0x1451,0x09E7,0xFFFF,0x1455,0x0C53,0x08E1,0x1443,0x0B18,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1469,0xFFFF,0x0F56,0xFFFF,0xFFFF,0x145F,0x1460,0x1461,0xFFFF,0xFFFF,0x1468,0xFFFF,0x1467,
+0xFFFF,0xFFFF,0x0FC8,0x0710,0xFFFF,0x1465,0xFFFF,0x0838,0x06AF,0xFFFF,0xFFFF,0x1462,0xFFFF,0xFFFF,0x109D,0x1464,
+0x05B7,0x1466,0xFFFF,0x145D,0x1463,0x146A,0x0837,0x145E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1064,0xFFFF,
+0xFFFF,0xFFFF,0x1032,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x146D,0xFFFF,0xFFFF,0x1471,0xFFFF,0xFFFF,0xFFFF,0x0C1D,0xFFFF,
+0x10DE,0x1472,0xFFFF,0xFFFF,0x146F,0xFFFF,0x146C,0xFFFF,0xFFFF,0x146B,0x1470,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F1D,0xFFFF,0xFFFF,0x0DA9,0xFFFF,0x0839,0xFFFF,0x1473,0x146E,0xFFFF,0x1474,0xFFFF,
+0xFFFF,0xFFFF,0x086E,0xFFFF,0xFFFF,0xFFFF,0x064E,0xFFFF,0xFFFF,0xFFFF,0x147C,0xFFFF,0xFFFF,0xFFFF,0x0711,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x147A,0xFFFF,0xFFFF,0x147B,0x0936,0x1479,0x1477,0x1476,0x147D,0x1475,0x147F,0xFFFF,0xFFFF,
+0x0698,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1481,0xFFFF,0xFFFF,0x1480,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0CE1,0xFFFF,0x1484,0xFFFF,0x1482,0x1478,0x086F,0xFFFF,0x1483,0xFFFF,0x1487,0x1486,0x1488,0x1485,
+},
+{ // U+6200
+0x1489,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x148A,0x148B,0x0F57,0xFFFF,0x148D,0x148C,0x0A66,0xFFFF,
+0x0B6F,0x0683,0x0699,0xFFFF,0x148E,0xFFFF,0x05A0,0xFFFF,0xFFFF,0xFFFF,0x0B8D,0x148F,0xFFFF,0x1BAC,0x1490,0x0854,
+0xFFFF,0x1491,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BB0,0xFFFF,0xFFFF,0xFFFF,0x1492,0xFFFF,0xFFFF,0xFFFF,0x1493,0x0771,
+0x1494,0xFFFF,0x1495,0x1496,0x0C54,0xFFFF,0xFFFF,0xFFFF,0x089E,0xFFFF,0xFFFF,0x100A,0xFFFF,0xFFFF,0xFFFF,0x0F87,
+0x0A91,0x1497,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BB1,0x1C62,0x0E93,0xFFFF,0x0A33,0xFFFF,0x095A,0x1498,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0C44,0xFFFF,0x0F14,0xFFFF,0xFFFF,0x0C6E,0xFFFF,0xFFFF,0x149B,0xFFFF,0xFFFF,0x1499,0xFFFF,
+0x149C,0xFFFF,0xFFFF,0x149A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x149D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F1E,0xFFFF,
+0xFFFF,0x0598,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EED,0xFFFF,0xFFFF,0x0E94,0xFFFF,0xFFFF,0x149E,0xFFFF,0x14A1,0x0ABA,
+0x0772,0xFFFF,0x149F,0x14A6,0x0ABB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14A0,0x0E17,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1065,0x14A2,0x14A3,0x14A7,0x0D81,0x14A4,0x08E2,0x0B9F,0xFFFF,0xFFFF,0x14B5,0x0E65,0xFFFF,0x0C6F,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E95,0x14FA,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0F67,0xFFFF,0xFFFF,0xFFFF,0x0D2A,0xFFFF,0xFFFF,0xFFFF,0x0FC0,0xFFFF,0x14AA,0x063E,0x0CC5,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x14B3,0xFFFF,0xFFFF,0x0C8F,0x14AD,0x14B4,0x14AF,0x14B6,0x14B2,0xFFFF,0x14B1,0x0E42,0xFFFF,0x14AB,
+0x069A,0x14A9,0x07A8,0x0C70,0x14A5,0xFFFF,0xFFFF,0x14A8,0x08E3,0x0B9C,0xFFFF,0x0ABC,0x14B0,0x0E25,0xFFFF,0xFFFF,
+0x07A9,0x06C3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06E2,0x0B04,0x14B8,0x14BD,
+0xFFFF,0x14B9,0xFFFF,0x0870,0xFFFF,0x14BE,0x098D,0x0918,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A4D,0x14AC,
+},
+{ // U+6300
+0xFFFF,0x09E8,0x14BB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09C3,0x14BC,0x05A5,0xFFFF,0xFFFF,0x14B7,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0CE2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07AA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07C9,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14BA,0x0588,0xFFFF,0xFFFF,0x0950,0xFFFF,0xFFFF,0xFFFF,0x0B19,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D2B,0xFFFF,0xFFFF,0x0E85,0x14C0,0x0BFD,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C27,0xFFFF,0xFFFF,0x0996,0x14C1,0xFFFF,0x14C3,
+0x14BF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F4E,0xFFFF,0x0CF6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BFB,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F68,0x0A17,0x14CF,0xFFFF,0x14CE,0xFFFF,0xFFFF,0x0B5B,0xFFFF,
+0xFFFF,0xFFFF,0x0871,0xFFFF,0xFFFF,0xFFFF,0x14C8,0x0ABE,0xFFFF,0xFFFF,0x0DDD,0x0E04,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x14C6,0xFFFF,0xFFFF,0x0BFC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A41,0x14CB,0xFFFF,0xFFFF,0x0ABD,0xFFFF,0x14C5,0x14CA,
+0xFFFF,0xFFFF,0x0E26,0xFFFF,0xFFFF,0xFFFF,0x14C4,0xFFFF,0x0814,0xFFFF,0xFFFF,0x06D8,0xFFFF,0xFFFF,0xFFFF,0x14CC,
+0x1090,0x095B,0x0C90,0x14C9,0xFFFF,0x0B9D,0xFFFF,0x08E4,0x0B47,0x0625,0x0BDB,0x14C7,0x077C,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x083A,0xFFFF,0x0D08,0x14CD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BFE,0xFFFF,0xFFFF,0x14D0,0xFFFF,
+0x14D2,0xFFFF,0xFFFF,0x0C34,0x14D8,0xFFFF,0x14D3,0xFFFF,0xFFFF,0x14D5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ED0,
+0x0D2C,0xFFFF,0x14D6,0xFFFF,0xFFFF,0xFFFF,0x1033,0xFFFF,0xFFFF,0xFFFF,0x104F,0x0712,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x058F,0xFFFF,0x14D4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14D1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0751,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0626,0xFFFF,0x14D7,0xFFFF,0xFFFF,0xFFFF,0x1050,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6400
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14DB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C38,0xFFFF,0x14E2,
+0xFFFF,0xFFFF,0xFFFF,0x14DC,0xFFFF,0xFFFF,0x14D9,0x14E0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14C2,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14DD,0xFFFF,0x14E1,0xFFFF,0xFFFF,0xFFFF,0x0E73,0x0D82,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14DA,0xFFFF,0x14DE,0xFFFF,0xFFFF,0xFFFF,0x083B,0xFFFF,0xFFFF,0xFFFF,0x097E,0xFFFF,
+0xFFFF,0xFFFF,0x0B9E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14E6,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D3D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14E3,0xFFFF,0x0FAB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14E4,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14E5,0xFFFF,0x0FF7,0xFFFF,0x0B63,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0855,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14EC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x09A0,0x14E9,0xFFFF,0x14E8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E05,0xFFFF,0xFFFF,0xFFFF,0x0DAA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D48,0x14EA,0xFFFF,0xFFFF,0xFFFF,0x14EB,0xFFFF,0x0EFE,0xFFFF,0x0E18,0x098E,0xFFFF,
+0x0BB2,0xFFFF,0x0F9B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06C4,0xFFFF,0x14F2,0x14ED,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1051,0x14F4,0xFFFF,0xFFFF,0x14F0,0xFFFF,0x14F1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x14EF,0xFFFF,0x14AE,0xFFFF,0xFFFF,0xFFFF,0x14F3,0xFFFF,0x14EE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x14F8,0x14F9,0x0D3E,0x14FB,0xFFFF,0xFFFF,0x098F,0x14F6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0773,0xFFFF,0xFFFF,0x14FC,
+0xFFFF,0x14F5,0x1500,0xFFFF,0x14FF,0xFFFF,0x14FE,0xFFFF,0xFFFF,0xFFFF,0x1501,0xFFFF,0xFFFF,0x1503,0x0AF6,0xFFFF,
+},
+{ // U+6500
+0x1502,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1506,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1504,0xFFFF,0xFFFF,0xFFFF,0x1505,0x14DF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1508,0x1507,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x14E7,0x1509,0x14FD,0xFFFF,0xFFFF,0x09C4,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x150A,0x150B,0x150D,0x150C,0x150E,0x069B,0xFFFF,0x08E5,0xFFFF,0xFFFF,0x0F69,0x0B70,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x089F,0xFFFF,0xFFFF,0x1510,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1513,0xFFFF,0x0EE1,
+0xFFFF,0x0796,0xFFFF,0xFFFF,0xFFFF,0x1512,0x1511,0x0E27,0x1514,0x07CA,0xFFFF,0xFFFF,0xFFFF,0x1516,0x1515,0xFFFF,
+0xFFFF,0xFFFF,0x0713,0x09A1,0xFFFF,0xFFFF,0x0DCD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x083C,0xFFFF,0xFFFF,0xFFFF,
+0x0B57,0xFFFF,0x1517,0xFFFF,0x0B71,0x0D3F,0xFFFF,0x0EEE,0x1518,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1519,0x151A,0xFFFF,0xFFFF,0xFFFF,0x0F25,0x1354,0x0B87,0xFFFF,0xFFFF,0x0EDB,0xFFFF,0x0965,0xFFFF,
+0x0E96,0x0E74,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D64,0xFFFF,0x10A6,0xFFFF,0x151C,0x0A19,0xFFFF,0xFFFF,0x151D,
+0xFFFF,0x0597,0xFFFF,0xFFFF,0x07E9,0x0B8E,0xFFFF,0x0EEF,0xFFFF,0xFFFF,0xFFFF,0x151E,0x09AD,0x0CA2,0xFFFF,0x09C6,
+0x0B1A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x151F,0xFFFF,0x0F6A,0xFFFF,0xFFFF,0x0636,0x09C7,0xFFFF,0xFFFF,
+0xFFFF,0x1522,0xFFFF,0x1520,0x1523,0x109E,0x1521,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BBC,0x1524,0xFFFF,0xFFFF,0x0C2F,
+0xFFFF,0xFFFF,0x1525,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0753,0xFFFF,0x1527,0xFFFF,0x1526,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1528,0x1529,0x0754,0xFFFF,0xFFFF,0x0DF1,0x0C91,0x07A3,0x09C8,0x0C00,0xFFFF,0xFFFF,0x0A83,0x0591,0xFFFF,0xFFFF,
+0xFFFF,0x152A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x063F,0x152E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6600
+0xFFFF,0xFFFF,0x08E6,0x152D,0xFFFF,0xFFFF,0x0938,0x0ABF,0xFFFF,0xFFFF,0x152C,0xFFFF,0x0AC0,0xFFFF,0x0FE9,0x0937,
+0xFFFF,0xFFFF,0xFFFF,0x05B8,0x0B8F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1533,0xFFFF,0xFFFF,0x0B72,
+0x0606,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A7C,0xFFFF,0x0FB1,0x097F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AC1,0xFFFF,0x0B68,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1532,0x1530,0x1531,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CC6,0xFFFF,0xFFFF,0x1551,
+0xFFFF,0x1537,0x09E9,0x08E7,0x1535,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1536,0xFFFF,0x0B1B,0xFFFF,0xFFFF,0xFFFF,0x1534,
+0xFFFF,0xFFFF,0x099A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1539,0x1538,0x153D,
+0xFFFF,0xFFFF,0x153E,0xFFFF,0x153A,0xFFFF,0x069D,0x153B,0x153C,0x0E86,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EF0,0x083D,
+0x153F,0xFFFF,0xFFFF,0xFFFF,0x0B73,0xFFFF,0x0AC2,0xFFFF,0xFFFF,0xFFFF,0x0CAD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x07DC,0xFFFF,0x1540,0x1544,0xFFFF,0xFFFF,0x0668,0x1541,0x1543,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1542,0xFFFF,
+0xFFFF,0x0A92,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CA3,0x05A6,0x1545,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1546,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0CE3,0xFFFF,0xFFFF,0xFFFF,0x10D6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09AE,0xFFFF,0xFFFF,0x0F58,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F88,0xFFFF,0xFFFF,0xFFFF,0x154D,0x1548,0xFFFF,0xFFFF,0x154B,0xFFFF,0x154A,0xFFFF,
+0xFFFF,0x1547,0xFFFF,0xFFFF,0x154C,0xFFFF,0xFFFF,0x0DD3,0xFFFF,0x1549,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x154E,0xFFFF,0xFFFF,0x0A93,0x154F,0xFFFF,0x1052,0x0E4B,0xFFFF,0xFFFF,
+0x1550,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1552,0xFFFF,0xFFFF,0x1553,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1554,0xFFFF,0x07DF,0x0607,0x08E8,0x1555,0xFFFF,0x1556,0x0A98,0x0C01,0xFFFF,0xFFFF,0x1235,0x0BDD,0x0BDC,0x0C55,
+},
+{ // U+6700
+0x0954,0xFFFF,0xFFFF,0x1193,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0861,0x1034,0xFFFF,0x0F6B,0xFFFF,0x0F0D,0xFFFF,0x1557,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0980,0x0CF8,0x1558,0x10F2,0xFFFF,0xFFFF,0xFFFF,0x0F89,0xFFFF,0x0CE4,0x1559,0x0755,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x155A,0x155B,0x1003,0xFFFF,0x0FCD,0x0FC1,0x0FA7,0x0990,0x155D,0xFFFF,
+0xFFFF,0x0A34,0xFFFF,0xFFFF,0x0F9C,0xFFFF,0x155F,0x1562,0x1561,0xFFFF,0x0752,0xFFFF,0xFFFF,0x0797,0xFFFF,0x155E,
+0xFFFF,0x1560,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1563,0xFFFF,0xFFFF,0x0B5C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1082,0x05AA,
+0x096D,0x0C39,0xFFFF,0x0A26,0xFFFF,0xFFFF,0x0AF8,0xFFFF,0xFFFF,0x1566,0xFFFF,0xFFFF,0x0D65,0xFFFF,0x1564,0x0C28,
+0x1565,0x0AF7,0x1006,0x1567,0x1568,0x106F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x156D,0xFFFF,0xFFFF,0x08E9,0xFFFF,0x0E28,
+0x156A,0x0D83,0x152B,0x152F,0xFFFF,0x0786,0xFFFF,0x0E1A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x156C,0xFFFF,0x0AC3,0x0E75,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1572,0xFFFF,0x0EAB,0xFFFF,0x1569,0xFFFF,0x156F,0x156E,0xFFFF,0xFFFF,0xFFFF,
+0x0B90,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FB8,0xFFFF,0x10B8,0xFFFF,0xFFFF,0x0FB2,0xFFFF,0x0669,0x09C9,0xFFFF,0xFFFF,
+0x110B,0x1571,0x0B58,0xFFFF,0xFFFF,0xFFFF,0x1570,0xFFFF,0xFFFF,0x156B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08A0,
+0xFFFF,0xFFFF,0xFFFF,0x1577,0x1575,0xFFFF,0x066A,0x1573,0x1579,0x157F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0C45,0xFFFF,0xFFFF,0x0F2E,0xFFFF,0x1581,0xFFFF,0xFFFF,0xFFFF,0x0EB1,0xFFFF,0xFFFF,0xFFFF,0x1580,0x0E43,
+0x0F8A,0x0714,0xFFFF,0x0BB8,0x0A67,0xFFFF,0xFFFF,0xFFFF,0x0D0C,0xFFFF,0x1035,0xFFFF,0xFFFF,0x157C,0x157B,0xFFFF,
+0xFFFF,0xFFFF,0x157D,0xFFFF,0x157A,0xFFFF,0xFFFF,0x1582,0xFFFF,0x1578,0xFFFF,0xFFFF,0x1576,0xFFFF,0x157E,0x1574,
+0xFFFF,0x0CC7,0xFFFF,0x1021,0x0A0F,0x0981,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0947,0xFFFF,0xFFFF,0x0FBA,0x06BC,
+},
+{ // U+6800
+0xFFFF,0xFFFF,0x0D07,0x0DBF,0x0608,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0BB3,0xFFFF,0xFFFF,0x0B75,0x081D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1584,0xFFFF,
+0xFFFF,0x08EA,0x06F7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1586,0x06EF,0x158C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1589,0xFFFF,0x0BB4,0xFFFF,0xFFFF,0xFFFF,0x06C6,0x0939,0xFFFF,0xFFFF,0x06C5,0x095C,0xFFFF,0xFFFF,
+0x1587,0x0858,0x083E,0x0D84,0xFFFF,0xFFFF,0x1585,0xFFFF,0x05A7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1588,0x158A,0xFFFF,
+0x07E2,0x081F,0xFFFF,0x0715,0x0782,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x158D,0xFFFF,0xFFFF,0x0986,0x0FBC,0xFFFF,0x09A2,
+0xFFFF,0xFFFF,0xFFFF,0x158E,0xFFFF,0xFFFF,0xFFFF,0x0EBF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x159A,0xFFFF,0x0650,0x158F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15A0,0x1590,
+0xFFFF,0x10A7,0xFFFF,0x1597,0xFFFF,0x0E32,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x159F,0xFFFF,0x1592,
+0xFFFF,0xFFFF,0xFFFF,0x0595,0x1594,0xFFFF,0xFFFF,0x08EB,0xFFFF,0xFFFF,0xFFFF,0x1596,0xFFFF,0x1595,0xFFFF,0x1591,
+0x159C,0xFFFF,0x0AC4,0xFFFF,0xFFFF,0xFFFF,0x1306,0x08B9,0x1083,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1593,0xFFFF,0x0D2D,
+0x069E,0x093A,0xFFFF,0x158B,0xFFFF,0x159B,0x06DC,0xFFFF,0xFFFF,0x1599,0x159D,0xFFFF,0x0D85,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0757,0xFFFF,0x15BB,0xFFFF,0xFFFF,0x0FF2,0x15A2,0x0756,0xFFFF,0x15A9,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0F8B,0xFFFF,0x15AA,0x15AC,0xFFFF,0x15B0,0x15A4,0xFFFF,0x0C85,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D86,
+0x15B4,0x15A7,0xFFFF,0x15B1,0xFFFF,0xFFFF,0xFFFF,0x15AB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B1C,0x15B5,
+0xFFFF,0xFFFF,0x0B74,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15B3,0x0716,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6900
+0x1113,0x15A1,0xFFFF,0xFFFF,0x15AF,0x05B9,0xFFFF,0xFFFF,0x15A3,0xFFFF,0xFFFF,0x0FE3,0x15A8,0x0B05,0x0D00,0x159E,
+0xFFFF,0xFFFF,0x15AE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B5D,0x15B8,0x06EC,0x0872,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x15BA,0x15A5,0x15B9,0xFFFF,0x15B2,0x15A6,0xFFFF,0x15B6,0xFFFF,0x15B7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x15C8,0xFFFF,0xFFFF,0xFFFF,0x0DC3,0xFFFF,0x15AD,0xFFFF,0xFFFF,0x15C4,0xFFFF,0xFFFF,0xFFFF,0x15C6,0xFFFF,0x0D11,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1053,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0F05,0x15C1,0x0C47,0xFFFF,0xFFFF,0xFFFF,0x15C7,0x0BDE,0xFFFF,0x15BE,0x15CB,0x15CA,0xFFFF,
+0x0DE4,0x15C9,0x0DDF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15CD,0x15C0,0xFFFF,0x07DD,0x15C3,0x0A84,
+0xFFFF,0xFFFF,0xFFFF,0x0E33,0x15C5,0x07E0,0xFFFF,0x15BD,0x15BF,0x15BC,0xFFFF,0xFFFF,0x10F3,0x06D5,0x15C2,0xFFFF,
+0xFFFF,0x15CC,0x06B0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0974,0xFFFF,0xFFFF,0xFFFF,0x061C,0xFFFF,
+0xFFFF,0x15DD,0xFFFF,0xFFFF,0x10F4,0x15E0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B1D,0x15DF,0xFFFF,0xFFFF,0xFFFF,
+0x15DE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15DB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15CF,0xFFFF,
+0xFFFF,0x15EC,0x15CE,0xFFFF,0x15E1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15D9,0xFFFF,0xFFFF,0x15D4,0x15D1,
+0xFFFF,0x15D2,0xFFFF,0x15DA,0xFFFF,0xFFFF,0xFFFF,0x1E7B,0xFFFF,0xFFFF,0x15D7,0x08EC,0x0D01,0x0C03,0x15D5,0xFFFF,
+0x15D0,0xFFFF,0xFFFF,0x15D3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1054,0x0FB5,0xFFFF,0xFFFF,0xFFFF,0x15D8,0x15E2,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15EA,0x15E3,0xFFFF,0xFFFF,0x15F0,0xFFFF,0x15EE,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x15E9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15E8,0xFFFF,0x0D09,0xFFFF,0x0C04,0xFFFF,0x15E6,
+},
+{ // U+6A00
+0xFFFF,0xFFFF,0x15E4,0xFFFF,0xFFFF,0x15EB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15F1,0x0EA6,0x15F7,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x15F2,0x15F5,0x15EF,0xFFFF,0xFFFF,0x0CCF,0xFFFF,0x0EC7,0xFFFF,0x15E5,0xFFFF,0xFFFF,0x15ED,0x0AC5,
+0xFFFF,0x0FF8,0x1601,0x15F4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0873,0x0640,0x06DA,0xFFFF,0xFFFF,0x15DC,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AC6,0x15F9,0xFFFF,0x1600,0x0A42,0x06ED,0xFFFF,0xFFFF,0x0C89,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15F6,0xFFFF,0xFFFF,0x15FB,0x15FF,0xFFFF,0xFFFF,0x07CB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0783,0x15FD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0758,
+0xFFFF,0x0DC0,0x15FC,0xFFFF,0xFFFF,0xFFFF,0x15FE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x15F8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15FA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06DB,
+0x0CA4,0xFFFF,0xFFFF,0xFFFF,0x1605,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1603,0x08BA,0xFFFF,
+0x1602,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1608,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1583,0xFFFF,0xFFFF,0xFFFF,
+0x1604,0xFFFF,0x1606,0x1607,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1613,0xFFFF,0x160F,0xFFFF,0x1598,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x160E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x160D,0xFFFF,0xFFFF,0x160A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x15F3,0x160C,0x160B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1611,0xFFFF,0x10E9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1614,0x0810,0xFFFF,0xFFFF,0x1610,0x1612,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E58,0xFFFF,0x1615,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1619,0x1616,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6B00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x107A,0x1617,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x15E7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x161A,0xFFFF,0xFFFF,0xFFFF,0x161B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05F4,0xFFFF,0x161D,
+0x085A,0x09EA,0xFFFF,0x07EA,0xFFFF,0xFFFF,0xFFFF,0x0641,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1066,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x161F,0x161E,0x1621,0x0774,0xFFFF,0xFFFF,0x07EB,0x0717,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1624,0xFFFF,0xFFFF,0xFFFF,0x1623,0xFFFF,0x1625,0xFFFF,0xFFFF,0x066B,0xFFFF,0x0C92,0xFFFF,
+0x1626,0xFFFF,0xFFFF,0x0718,0x1628,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1627,0xFFFF,0x1629,0xFFFF,0xFFFF,0xFFFF,0x162A,
+0xFFFF,0x162B,0x09CA,0x0B76,0x092E,0xFFFF,0x0EFF,0xFFFF,0xFFFF,0x0F4F,0x1107,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09E0,
+0xFFFF,0xFFFF,0xFFFF,0x095D,0x10D7,0xFFFF,0xFFFF,0xFFFF,0x162C,0x162D,0xFFFF,0x09CB,0xFFFF,0xFFFF,0xFFFF,0x162E,
+0x162F,0xFFFF,0xFFFF,0x1631,0x1630,0xFFFF,0x0FA3,0xFFFF,0xFFFF,0x0A85,0x0A35,0x09AF,0xFFFF,0x1632,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1634,0x0B06,0xFFFF,0x1633,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1635,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1636,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1637,0x1638,0xFFFF,0xFFFF,0xFFFF,0x1639,
+0xFFFF,0x163B,0x163A,0x163C,0x0642,0x0CA5,0xFFFF,0x163D,0xFFFF,0xFFFF,0x0991,0x06C7,0x163E,0xFFFF,0xFFFF,0x0D59,
+0x12E5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x075A,0x163F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1640,0xFFFF,0x0F59,0x0FB3,0xFFFF,
+0xFFFF,0xFFFF,0x0DBC,0x1641,0x0E97,0xFFFF,0xFFFF,0xFFFF,0x0EAC,0xFFFF,0xFFFF,0x0FFC,0xFFFF,0xFFFF,0xFFFF,0x1642,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1644,0x1643,0xFFFF,0xFFFF,0x1646,
+0xFFFF,0xFFFF,0xFFFF,0x1645,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6C00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1648,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09CC,
+0xFFFF,0x0FDA,0xFFFF,0x1649,0x164A,0xFFFF,0xFFFF,0x075B,0xFFFF,0xFFFF,0xFFFF,0x164B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x164D,0x164C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B48,0xFFFF,0xFFFF,0x0EC8,0x0609,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E76,0xFFFF,
+0x0D2E,0x0A68,0x0798,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E77,0xFFFF,
+0x09F7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x164F,0xFFFF,0x0719,0xFFFF,0xFFFF,0x0637,0xFFFF,0xFFFF,0x0DE7,0x164E,0x08ED,
+0x0CAE,0xFFFF,0x1650,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1658,0xFFFF,0x1651,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0C3E,0xFFFF,0x0799,0x1659,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x085B,0xFFFF,0xFFFF,0x075C,0x1657,0xFFFF,
+0xFFFF,0x1655,0x1652,0x1067,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CF9,0xFFFF,0xFFFF,0xFFFF,0x0DCE,0x1653,0xFFFF,0xFFFF,
+0x165B,0xFFFF,0x165A,0x0816,0xFFFF,0xFFFF,0x064A,0xFFFF,0xFFFF,0x0948,0x1654,0x1656,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0FA2,0x0C71,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FC2,0xFFFF,0xFFFF,0x1663,0xFFFF,
+0xFFFF,0x1664,0xFFFF,0x066C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F15,0x1026,0x1666,0x09EC,0x0AC7,0x165F,0x1665,0x0627,
+0xFFFF,0x07CC,0xFFFF,0xFFFF,0x165C,0x1661,0xFFFF,0xFFFF,0xFFFF,0x0BB5,0x0E44,0xFFFF,0x0E98,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x165E,0xFFFF,0x0F6C,0xFFFF,0x1660,0xFFFF,0x1669,0xFFFF,0x1667,0xFFFF,0x1662,0xFFFF,0xFFFF,
+0xFFFF,0x0F6D,0x0E1B,0x079A,0xFFFF,0x0D3C,0xFFFF,0xFFFF,0x0CC8,0xFFFF,0x166A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1668,
+0x0C56,0x165D,0xFFFF,0x060A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6D00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1055,0x1675,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1674,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BB7,0xFFFF,0x1671,0xFFFF,0x1073,0xFFFF,0xFFFF,0x0DAB,0x166B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CFE,0xFFFF,0xFFFF,0xFFFF,0x060B,0x08EE,0x166E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0A4E,0x1673,0xFFFF,0x1672,0x166D,0xFFFF,0x1670,0xFFFF,0xFFFF,0x06E3,0xFFFF,0x166F,0x0E1C,0xFFFF,
+0xFFFF,0x1093,0xFFFF,0xFFFF,0x0AF9,0x0BB6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x167B,0x1679,0xFFFF,0x0EDC,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1676,0x1678,0xFFFF,0x05F9,0xFFFF,0xFFFF,0x08EF,0x10F5,0xFFFF,0x06B8,0xFFFF,0x0EF1,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1068,0xFFFF,0xFFFF,0x069F,0x0B1E,0x167A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x167F,0xFFFF,0xFFFF,0x0AC8,0xFFFF,0xFFFF,0xFFFF,0x1037,0xFFFF,0x167C,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1677,0xFFFF,0x167D,0xFFFF,0xFFFF,0xFFFF,0x10C3,0xFFFF,0x0D8A,0x0DB7,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06B1,
+0xFFFF,0xFFFF,0x0614,0xFFFF,0xFFFF,0x1683,0xFFFF,0xFFFF,0x1686,0xFFFF,0xFFFF,0xFFFF,0x10A8,0xFFFF,0xFFFF,0xFFFF,
+0x106B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x168D,0x1687,0x1684,0xFFFF,0xFFFF,0xFFFF,0x10B9,0x168A,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0A71,0x168C,0xFFFF,0xFFFF,0x1691,0xFFFF,0xFFFF,0x0D88,0x168F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1689,0xFFFF,
+0xFFFF,0x0C93,0xFFFF,0xFFFF,0x1690,0xFFFF,0x1685,0xFFFF,0x168B,0xFFFF,0x1692,0x05DD,0x1688,0xFFFF,0x1693,0xFFFF,
+0xFFFF,0x0B1F,0xFFFF,0x0A86,0xFFFF,0x0F12,0xFFFF,0x093B,0xFFFF,0x1680,0x168E,0x0D51,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+6E00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B77,0xFFFF,0x06E4,0x095E,0x0AC9,0x1682,0x0A69,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x083F,0xFFFF,0x1681,0xFFFF,0xFFFF,0xFFFF,0x1697,0x0A94,0x088B,0xFFFF,0x16A6,0xFFFF,0x16A0,
+0x07AB,0x0D66,0xFFFF,0x169B,0x16A4,0x0590,0x05F1,0xFFFF,0xFFFF,0x0656,0xFFFF,0x169D,0x0C29,0x1694,0x1696,0x08F0,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16A7,0xFFFF,0x16A2,0xFFFF,0xFFFF,0xFFFF,0x169A,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x16A1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FD4,0xFFFF,0xFFFF,0x169F,0x16A3,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08A1,0xFFFF,0x0ACA,0xFFFF,0xFFFF,0x0C94,0xFFFF,0xFFFF,0xFFFF,0x1699,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1036,0xFFFF,0xFFFF,0xFFFF,0x169C,0xFFFF,0xFFFF,0x1695,0x0D89,
+0xFFFF,0xFFFF,0x1698,0xFFFF,0xFFFF,0xFFFF,0x169E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1114,0x0A07,
+0x0FC9,0xFFFF,0x16A8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E5F,0xFFFF,0xFFFF,0x16B4,
+0x088C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A87,0xFFFF,0x16AA,0xFFFF,0xFFFF,0xFFFF,0x1094,0x08F1,0xFFFF,0x16B7,
+0xFFFF,0xFFFF,0x05CF,0xFFFF,0xFFFF,0x16B5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16A9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16AF,
+0xFFFF,0xFFFF,0x16B1,0xFFFF,0xFFFF,0xFFFF,0x1056,0x16AC,0xFFFF,0xFFFF,0x0D45,0xFFFF,0xFFFF,0x16AE,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x16B6,0xFFFF,0x16B0,0x0FF0,0xFFFF,0xFFFF,0xFFFF,0x16AB,0xFFFF,0x09EB,0x16C3,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x06E5,0xFFFF,0x16AD,0x16B2,0x16B3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C69,0x0C57,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16BB,0xFFFF,0xFFFF,0x16C1,
+0xFFFF,0xFFFF,0x16BF,0xFFFF,0x0D40,0xFFFF,0xFFFF,0x16C6,0x16BC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16BD,0x16A5,
+},
+{ // U+6F00
+0xFFFF,0x07B0,0x0EC9,0xFFFF,0xFFFF,0xFFFF,0x0A08,0xFFFF,0xFFFF,0x0926,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10F6,
+0xFFFF,0x16B9,0xFFFF,0x16C5,0x0628,0x0C05,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0E4C,0xFFFF,0x071A,0x10DF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FCA,0x0D0B,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x16C0,0x16C2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BD1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16C4,0x16BE,
+0xFFFF,0x16B8,0xFFFF,0xFFFF,0xFFFF,0x071C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x085C,0xFFFF,0xFFFF,0xFFFF,0x16D2,0xFFFF,0xFFFF,0x16CD,0x0BB9,0xFFFF,0xFFFF,0x06DE,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A88,0xFFFF,0x16D6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16CF,0x0CE5,0x16CC,
+0x0D12,0xFFFF,0xFFFF,0xFFFF,0x16EF,0xFFFF,0xFFFF,0xFFFF,0x16C9,0xFFFF,0x16C8,0xFFFF,0x16D1,0xFFFF,0xFFFF,0xFFFF,
+0x16CB,0x16CA,0x16D0,0xFFFF,0x0B62,0xFFFF,0x16C7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16D3,0xFFFF,
+0xFFFF,0x16D4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x071B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x16D9,0xFFFF,0x16D8,0x16DA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16DD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0D5A,0xFFFF,0x16D7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16DB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0856,0x0C76,0x16D5,0x0E0E,0xFFFF,0xFFFF,0x16DC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16E1,0x16DF,0xFFFF,0xFFFF,0x16E2,0xFFFF,0xFFFF,0x16E5,0xFFFF,0xFFFF,0xFFFF,0x16DE,
+0x0919,0x0DFB,0xFFFF,0xFFFF,0x167E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x107B,0x16E0,0xFFFF,0x16E4,0x0C72,
+0xFFFF,0x16E3,0xFFFF,0x16CE,0xFFFF,0xFFFF,0x1CEC,0xFFFF,0xFFFF,0xFFFF,0x16E8,0xFFFF,0xFFFF,0xFFFF,0x16EC,0xFFFF,
+},
+{ // U+7000
+0xFFFF,0x16EA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16E6,0xFFFF,0x16E7,0xFFFF,0xFFFF,0xFFFF,0x16EB,
+0xFFFF,0x16E9,0xFFFF,0xFFFF,0xFFFF,0x0EDD,0xFFFF,0xFFFF,0x16F1,0xFFFF,0x16EE,0x16ED,0xFFFF,0x16F0,0x0DC9,0x16F2,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CD0,0x0C6A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B66,0xFFFF,0xFFFF,0xFFFF,
+0x16F3,0xFFFF,0x16F5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16F4,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16BA,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x16F6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DDC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x16F7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x066D,0xFFFF,0xFFFF,0xFFFF,0x0D8B,
+0x06A0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x079B,0xFFFF,0xFFFF,0xFFFF,0x0A27,0x095F,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10EA,0x0B49,0xFFFF,0xFFFF,0xFFFF,0x0629,0xFFFF,
+0xFFFF,0xFFFF,0x16F9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16F8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16FC,0x0C95,0x16FF,0x16FA,
+0xFFFF,0xFFFF,0xFFFF,0x16FE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x16FD,0x0D57,0x05BA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10DA,0xFFFF,0xFFFF,0x1701,0xFFFF,0xFFFF,0xFFFF,0x05E7,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1703,0xFFFF,0xFFFF,0xFFFF,0x1702,0xFFFF,0x1700,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x16FB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F6E,0xFFFF,0xFFFF,0xFFFF,0x1705,0xFFFF,0xFFFF,
+},
+{ // U+7100
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1704,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x062A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1707,0x0F1F,0xFFFF,0x1706,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0FDE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ACC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BD2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ACB,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10E0,0xFFFF,0xFFFF,0x170D,0xFFFF,0x0BBA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1709,0x170E,0xFFFF,0xFFFF,0x062B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x170C,0xFFFF,0x0E34,0x1708,0x170B,0x0ACD,0xFFFF,0x0E82,0xFFFF,0xFFFF,0x170F,0xFFFF,0x0A1A,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BBB,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1712,0xFFFF,0xFFFF,0xFFFF,0x170A,0xFFFF,0x081A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1710,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1057,0x1713,0xFFFF,0xFFFF,0xFFFF,0x1E7F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A76,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1714,0xFFFF,0xFFFF,0xFFFF,0x1715,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0E01,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1717,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1718,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0E06,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D8C,0x171A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x171C,0xFFFF,
+0x10BA,0xFFFF,0x1719,0xFFFF,0x171B,0x062C,0xFFFF,0x1716,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1296,
+0x171D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C06,0x09A3,0x171F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x171E,0x0B07,0x1236,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1720,0xFFFF,0xFFFF,0xFFFF,0x1722,0xFFFF,0x1711,0x1721,0xFFFF,0xFFFF,0x1723,
+},
+{ // U+7200
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E4D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1724,0xFFFF,0xFFFF,
+0x1725,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1726,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1727,0xFFFF,0x0D17,0xFFFF,0x1729,0x1728,0xFFFF,0xFFFF,
+0x172A,0xFFFF,0x172B,0xFFFF,0xFFFF,0x0A28,0x0EF2,0xFFFF,0xFFFF,0xFFFF,0x1015,0x172C,0x172D,0x0BF5,0x09ED,0x172E,
+0x172F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1730,0x0F3F,0x0E78,0xFFFF,0xFFFF,0x1731,0x0E2A,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0CE6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1732,0x0684,0xFFFF,0x07A4,0xFFFF,0x0FEF,0xFFFF,0x0FDF,
+0xFFFF,0x0651,0x10F7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F9D,0xFFFF,0x0F17,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0B78,0xFFFF,0x1733,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DB8,0xFFFF,0xFFFF,0xFFFF,0x0874,0x1734,0xFFFF,
+0x0961,0x1736,0x1735,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1737,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1738,0xFFFF,0xFFFF,0xFFFF,0x1739,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0775,0xFFFF,0x173A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x173B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0875,0xFFFF,0xFFFF,0x0E79,
+0xFFFF,0xFFFF,0x173D,0xFFFF,0xFFFF,0xFFFF,0x0AFA,0xFFFF,0xFFFF,0x173C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x07CD,0x173E,0x1740,0xFFFF,0x173F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1741,0xFFFF,
+0x08A2,0xFFFF,0x1742,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07FE,0xFFFF,0x0BDF,0xFFFF,0x092C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1744,0x1745,0x1743,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A36,0xFFFF,0xFFFF,0x0DBD,0x07CE,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1747,0x0C87,0x1746,0xFFFF,0xFFFF,0x10F8,0x0E35,0xFFFF,0xFFFF,
+},
+{ // U+7300
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x174A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x174C,0x1749,0xFFFF,0xFFFF,0xFFFF,0x0FFD,0x174B,0x174D,0xFFFF,0x10A9,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1751,0xFFFF,0xFFFF,0xFFFF,0x1750,0x0CD1,0x0E00,0xFFFF,0xFFFF,0x0876,0x174F,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x174E,0xFFFF,0x1038,0x1039,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1752,0x062D,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0925,0x09CD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1753,0x1754,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1756,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0A6A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1758,0xFFFF,0x1757,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1759,0xFFFF,0x06C8,0xFFFF,0xFFFF,0x175B,0xFFFF,0xFFFF,0x175A,0xFFFF,0x175D,0x175C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x088D,0xFFFF,0xFFFF,0x108D,0xFFFF,0x07E1,0xFFFF,0x0643,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07FF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x073A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x10CD,0x175F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1761,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1762,0xFFFF,0x066E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x175E,0xFFFF,0x09A4,0xFFFF,0xFFFF,0x0CFA,0x1760,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1765,0xFFFF,
+0x0A37,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1763,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0831,0xFFFF,0xFFFF,0x0E7A,0x1764,0xFFFF,
+0xFFFF,0x177F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x176A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x088E,0xFFFF,
+},
+{ // U+7400
+0xFFFF,0xFFFF,0xFFFF,0x079C,0xFFFF,0x1767,0x1084,0xFFFF,0xFFFF,0x1095,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0C73,0xFFFF,0xFFFF,0x1769,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x176B,0x10BB,0x07EC,0x0EAD,0x0E1D,0xFFFF,0xFFFF,0xFFFF,0x176C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x176E,
+0xFFFF,0x1771,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x176D,0xFFFF,0xFFFF,0xFFFF,0x1770,0x08BB,0x060C,0x1772,0xFFFF,0x0B53,0x176F,
+0x10C1,0xFFFF,0xFFFF,0x1775,0x1E7D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1773,0x1776,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1768,
+0x1774,0xFFFF,0xFFFF,0x0949,0xFFFF,0xFFFF,0x1777,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1778,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1085,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1779,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x177A,0xFFFF,
+0xFFFF,0xFFFF,0x1766,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x177B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x071D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09EE,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x177C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x177D,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x177E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05FA,0xFFFF,0xFFFF,0xFFFF,
+0x1780,0xFFFF,0x0ECA,0x1781,0xFFFF,0xFFFF,0x06FD,0x1782,0xFFFF,0x1783,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1784,0xFFFF,
+0x1786,0x1787,0x1785,0xFFFF,0xFFFF,0xFFFF,0x0EE2,0x1789,0x1788,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7500
+0xFFFF,0xFFFF,0xFFFF,0x178B,0x178A,0x178C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x178D,0x178F,0x178E,0xFFFF,
+0xFFFF,0x0928,0xFFFF,0x1791,0xFFFF,0x1790,0xFFFF,0xFFFF,0x071E,0xFFFF,0x0B36,0xFFFF,0x0D53,0xFFFF,0x1792,0x0B79,
+0xFFFF,0xFFFF,0xFFFF,0x09A5,0xFFFF,0x0638,0x1793,0xFFFF,0x1058,0xFFFF,0xFFFF,0x0F50,0x1794,0xFFFF,0xFFFF,0xFFFF,
+0x0D5B,0x103A,0x08F2,0x0B20,0xFFFF,0xFFFF,0xFFFF,0x0CA6,0x1211,0xFFFF,0x0CE7,0x0685,0x1795,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1796,0xFFFF,0x179B,0xFFFF,0xFFFF,0x1799,0x1798,0x150F,0x06A1,0x1797,0xFFFF,0x05BB,
+0xFFFF,0x0E5B,0xFFFF,0xFFFF,0x0E7B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1096,0x179C,0x179A,0x0CB7,0x0B67,0xFFFF,0xFFFF,
+0x0E5C,0xFFFF,0x0EBC,0xFFFF,0x179E,0x1091,0x0840,0x179F,0xFFFF,0x179D,0x0E87,0x17A0,0xFFFF,0x17A1,0xFFFF,0xFFFF,
+0x05BC,0xFFFF,0xFFFF,0x0AFB,0x17A6,0xFFFF,0x17A3,0x0DE2,0x17A2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x075D,
+0xFFFF,0xFFFF,0x17A9,0xFFFF,0xFFFF,0xFFFF,0x17A4,0x17A5,0xFFFF,0x17A8,0x17A7,0x0EB4,0xFFFF,0xFFFF,0x0BE1,0x0BE0,
+0xFFFF,0x0776,0xFFFF,0xFFFF,0x17AA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17AB,0xFFFF,0xFFFF,0x17AC,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x17AE,0xFFFF,0x17AD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0615,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x17B6,0x0E99,0x17B0,0xFFFF,0x17B2,0xFFFF,0xFFFF,0x17B4,0x0B21,0xFFFF,0xFFFF,0x17B5,0x17B3,0x0A09,0xFFFF,
+0xFFFF,0xFFFF,0x17AF,0x17B1,0xFFFF,0x0ED1,0xFFFF,0x0ACE,0xFFFF,0xFFFF,0x17B8,0xFFFF,0xFFFF,0x17B7,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x17B9,0xFFFF,0x09EF,0x093C,0xFFFF,0xFFFF,0x0D8E,0x17BA,0xFFFF,0x0D04,0xFFFF,0xFFFF,0x17BC,0xFFFF,
+0xFFFF,0xFFFF,0x1086,0x17BB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C08,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x17C1,0xFFFF,0x17C3,0x17C4,0x0CAF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17C2,0xFFFF,0x17BF,0xFFFF,0x17BD,0x17BE,
+},
+{ // U+7600
+0xFFFF,0x17C0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17C7,0xFFFF,0x17C5,0xFFFF,0x17C6,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17C8,
+0x17CA,0x17CB,0x17CC,0xFFFF,0x17CD,0xFFFF,0xFFFF,0x17C9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x17CF,0xFFFF,0xFFFF,0xFFFF,0x17CE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17D0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x10AA,0xFFFF,0xFFFF,0xFFFF,0x17D3,0x17D1,0x17D2,0xFFFF,0xFFFF,0xFFFF,0x073B,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1027,0xFFFF,0xFFFF,0xFFFF,0x0F37,0xFFFF,0x17D5,0xFFFF,0xFFFF,0xFFFF,0x17D4,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x17D6,0x17D7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x17DB,0x17D8,0x17D9,0x17DA,0xFFFF,0x17DC,0xFFFF,0xFFFF,0xFFFF,
+0x17DD,0xFFFF,0x17DE,0xFFFF,0xFFFF,0xFFFF,0x17DF,0xFFFF,0x17E0,0xFFFF,0x0E60,0x0D67,0x17E1,0x0E45,0x0EC3,0xFFFF,
+0x17E2,0xFFFF,0xFFFF,0x17E3,0x0D41,0xFFFF,0x06A2,0x08F3,0x17E4,0xFFFF,0xFFFF,0x17E5,0xFFFF,0xFFFF,0x17E6,0xFFFF,
+0x0994,0xFFFF,0xFFFF,0x17E8,0xFFFF,0xFFFF,0x17E7,0xFFFF,0xFFFF,0x17E9,0x17EA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E9A,0xFFFF,
+0x17EB,0xFFFF,0xFFFF,0xFFFF,0x17EC,0xFFFF,0xFFFF,0x1E64,0x17ED,0x17EE,0x17EF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0999,
+0xFFFF,0xFFFF,0x17F0,0x0E29,0xFFFF,0xFFFF,0x0FAA,0xFFFF,0x060D,0xFFFF,0x0616,0xFFFF,0xFFFF,0x17F1,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x17F3,0xFFFF,0xFFFF,0xFFFF,0x17F2,0x0D87,0xFFFF,0xFFFF,0xFFFF,0x0B7A,0x1620,0xFFFF,0x17F4,0x0FEA,
+0xFFFF,0x17F5,0xFFFF,0x071F,0x0E88,0x17F6,0xFFFF,0x17F7,0xFFFF,0xFFFF,0x17F8,0xFFFF,0xFFFF,0xFFFF,0x1005,0xFFFF,
+0xFFFF,0xFFFF,0x0FFE,0xFFFF,0x0CF7,0xFFFF,0xFFFF,0xFFFF,0x0C09,0xFFFF,0xFFFF,0x17FA,0xFFFF,0xFFFF,0x0A89,0xFFFF,
+},
+{ // U+7700
+0xFFFF,0x0ACF,0xFFFF,0xFFFF,0x17FD,0xFFFF,0xFFFF,0x17FC,0x17FB,0x0EAE,0xFFFF,0x0720,0x087A,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1803,0xFFFF,0xFFFF,0x1800,0x0B22,
+0x0FDB,0xFFFF,0xFFFF,0xFFFF,0x17FF,0x1801,0x1802,0xFFFF,0xFFFF,0x17FE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1804,0x1805,0xFFFF,0x0CE8,0xFFFF,0x073C,0xFFFF,0xFFFF,0xFFFF,
+0x0CC0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1806,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1807,0x180A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0B4A,0xFFFF,0x0DB9,0xFFFF,0x180B,0x0F9E,0xFFFF,0x1808,0xFFFF,0xFFFF,0x1809,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x180E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x180D,0x180C,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1810,0xFFFF,0xFFFF,0x180F,0xFFFF,
+0xFFFF,0x1811,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1813,0xFFFF,
+0x1812,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F3A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A7D,0x10AB,0xFFFF,0xFFFF,
+0x1814,0xFFFF,0xFFFF,0x0DAC,0xFFFF,0xFFFF,0x1815,0xFFFF,0xFFFF,0x1816,0xFFFF,0x181A,0x1818,0x1819,0xFFFF,0x1817,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x181B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x181C,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x181D,0xFFFF,0xFFFF,0x181E,0x0FE0,0x181F,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1019,0x1820,0xFFFF,0x0CA9,0xFFFF,0x0E3D,0xFFFF,0x0800,0xFFFF,0xFFFF,0xFFFF,0x0C96,0x1821,0x07CF,
+0xFFFF,0xFFFF,0xFFFF,0x0B91,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1822,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7800
+0xFFFF,0xFFFF,0x094A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1823,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1824,0xFFFF,0x0877,0x0962,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1826,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D6D,0x0963,0x0785,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0F6F,0xFFFF,0x0E1E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D6E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x090B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1828,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AD0,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1097,0x08F4,0xFFFF,0xFFFF,0x0878,
+0xFFFF,0xFFFF,0x0E54,0xFFFF,0x182A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x182C,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x08BC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x182B,0x0D2F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x182E,0x06B2,0x1829,0xFFFF,
+0xFFFF,0x0E9B,0xFFFF,0x05EF,0xFFFF,0x0979,0xFFFF,0x1115,0xFFFF,0xFFFF,0x182D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x182F,0xFFFF,0xFFFF,0xFFFF,0x0F38,0xFFFF,0x0B9A,0x1831,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1832,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1830,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06C9,0xFFFF,0x1838,0xFFFF,0x1837,0xFFFF,
+0xFFFF,0x09F0,0xFFFF,0xFFFF,0xFFFF,0x1839,0x1834,0xFFFF,0xFFFF,0xFFFF,0x183A,0x1835,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0E89,0x1833,0xFFFF,0xFFFF,0x1836,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x183D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x183C,0x0FAC,0xFFFF,0xFFFF,0xFFFF,0x183B,0xFFFF,0xFFFF,0x05CC,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x183F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x183E,0xFFFF,0xFFFF,
+},
+{ // U+7900
+0xFFFF,0x0AD1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1840,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BE2,0xFFFF,
+0xFFFF,0x1842,0x1841,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1843,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1825,0xFFFF,0xFFFF,0xFFFF,0x1827,0x1845,0x1844,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09F1,0xFFFF,0x10CE,0xFFFF,0x0A1B,0xFFFF,
+0x1846,0x082A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0777,0x075E,0x09CE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x103B,0xFFFF,0xFFFF,0x184C,0xFFFF,0x184B,0x0BE3,0x1848,0xFFFF,0xFFFF,0x184A,0xFFFF,0xFFFF,0x0A72,0x0B23,0x1849,
+0x1847,0xFFFF,0x0DFD,0xFFFF,0xFFFF,0x0AD2,0xFFFF,0xFFFF,0x0ECB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0964,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D8F,0xFFFF,0xFFFF,0x184D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x184E,
+0x1864,0x07ED,0xFFFF,0xFFFF,0x1100,0x0BD4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x184F,0xFFFF,0xFFFF,0x066F,0x0D30,0x0F0E,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1850,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07B1,0x1851,0xFFFF,0xFFFF,0x1853,0xFFFF,0xFFFF,0xFFFF,0x1854,0xFFFF,
+0x0DFC,0xFFFF,0xFFFF,0x1855,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1856,0x1857,0xFFFF,0xFFFF,0x07EE,0x0670,0x0DBA,
+0x0A4F,0x09CF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1858,0xFFFF,0x0A50,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0667,0x0ED2,0xFFFF,0xFFFF,0x1859,0xFFFF,0xFFFF,0x0E9C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BE4,
+0xFFFF,0x185C,0xFFFF,0x185D,0x0E3C,0xFFFF,0x0B24,0x185A,0xFFFF,0x0CBC,0xFFFF,0xFFFF,0x185B,0xFFFF,0xFFFF,0xFFFF,
+0x0AD3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05BD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7A00
+0x0760,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x185E,0xFFFF,0xFFFF,0x0D31,0xFFFF,0x185F,0x0B88,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0FD6,0xFFFF,0xFFFF,0x0EB2,0x1860,0x1861,0x0CB0,0xFFFF,0x10AC,0xFFFF,0xFFFF,0x1863,
+0x1862,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A38,0xFFFF,
+0xFFFF,0x1865,0x05D1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1868,0xFFFF,0xFFFF,0xFFFF,0x1866,0x0671,0x0841,0x1867,0x08F5,
+0x0921,0xFFFF,0x0F53,0x1869,0xFFFF,0xFFFF,0x0F9F,0xFFFF,0xFFFF,0x186B,0xFFFF,0xFFFF,0xFFFF,0x0B92,0x060E,0x0657,
+0x058D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x186A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x186C,0x186D,0x0AFC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x186E,0xFFFF,0x06CA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1870,0xFFFF,0xFFFF,0xFFFF,0x085D,0xFFFF,0x079D,0xFFFF,0xFFFF,0x1871,0x080A,0xFFFF,0xFFFF,0x1872,0xFFFF,0x0BBD,
+0xFFFF,0x0DC2,0xFFFF,0x0BA1,0x0982,0xFFFF,0xFFFF,0xFFFF,0x1873,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0CBD,0x0C0A,0xFFFF,0x1875,0x1877,0x1874,0x1876,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0815,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1878,0x0819,0xFFFF,0xFFFF,0xFFFF,0x079E,0x1059,
+0x187A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x187B,0xFFFF,0xFFFF,0xFFFF,0x05ED,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x187E,
+0xFFFF,0xFFFF,0xFFFF,0x06F1,0x187D,0x187C,0xFFFF,0x1880,0x1879,0xFFFF,0x1881,0x108E,0xFFFF,0x1882,0xFFFF,0x1883,
+0xFFFF,0xFFFF,0x130D,0x1885,0xFFFF,0x1884,0xFFFF,0xFFFF,0xFFFF,0x1886,0x1887,0xFFFF,0x109A,0x1888,0xFFFF,0x1D50,
+0x0AD4,0x1889,0x188A,0x0A7E,0xFFFF,0x0DAD,0x188B,0xFFFF,0xFFFF,0xFFFF,0x0C83,0xFFFF,0xFFFF,0x188C,0xFFFF,0x0C97,
+0x188D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07BA,0xFFFF,0x11BE,0x0CB8,0x09FC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0721,
+},
+{ // U+7B00
+0xFFFF,0xFFFF,0x188E,0xFFFF,0x189B,0xFFFF,0x1891,0xFFFF,0x079F,0xFFFF,0x1890,0x189D,0xFFFF,0xFFFF,0xFFFF,0x188F,
+0xFFFF,0x0AD5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1893,0x1894,0xFFFF,0x0D42,0xFFFF,0xFFFF,0x1895,0xFFFF,
+0x06D9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B3D,0x0EF3,0xFFFF,0x1897,0xFFFF,0xFFFF,0xFFFF,0x0C65,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1892,0xFFFF,0x1896,0x1898,0xFFFF,0xFFFF,0x0988,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x189F,0x0EBD,0xFFFF,0x0E57,0x0D90,0xFFFF,0x07EF,0x189E,0x189C,0xFFFF,0x0E66,
+0x1899,0x0CB9,0x0D92,0xFFFF,0x0D91,0xFFFF,0x0983,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18B1,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18A1,0xFFFF,0x18A3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18A6,0xFFFF,0x18A7,0xFFFF,
+0x18A4,0x18A5,0xFFFF,0xFFFF,0x18A2,0x18A0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x189A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F3C,0x0672,0xFFFF,0xFFFF,0xFFFF,0x18AE,0xFFFF,0x18AB,0xFFFF,0x18B0,
+0xFFFF,0xFFFF,0x18AF,0xFFFF,0x0E46,0x0FD0,0xFFFF,0x09A6,0x18A9,0x18B2,0x18AD,0xFFFF,0x18AC,0x18A8,0xFFFF,0x18AA,
+0xFFFF,0x0722,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C98,0xFFFF,0xFFFF,0x0BBE,0xFFFF,0xFFFF,
+0xFFFF,0x0E53,0xFFFF,0xFFFF,0x18B7,0xFFFF,0xFFFF,0xFFFF,0x0E55,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0BA2,0x18B4,0xFFFF,0xFFFF,0x0E80,0xFFFF,0x18B8,0x0F40,0xFFFF,0x0CB6,0xFFFF,0x18B3,0x18B5,0xFFFF,0xFFFF,0x18B6,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18B9,0xFFFF,0xFFFF,
+0x0A0D,0xFFFF,0xFFFF,0xFFFF,0x0DBB,0x18BE,0x18BD,0xFFFF,0xFFFF,0x18BA,0xFFFF,0xFFFF,0xFFFF,0x10F9,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x18C3,0xFFFF,0xFFFF,0x18C7,0x18C4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7C00
+0x18C0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18C1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18C6,0xFFFF,0xFFFF,
+0xFFFF,0x18BB,0x1232,0x18C2,0x18BC,0xFFFF,0xFFFF,0x18C5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18CB,
+0xFFFF,0x0723,0xFFFF,0x18C8,0xFFFF,0xFFFF,0xFFFF,0x18C9,0xFFFF,0xFFFF,0x18CA,0x18CD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18CC,0x0EA7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18CE,0x10E1,0x0F5A,
+0x18D3,0xFFFF,0xFFFF,0x18D0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18CF,0x0B93,0xFFFF,0x18D2,
+0x18D4,0xFFFF,0xFFFF,0xFFFF,0x18D1,0xFFFF,0x18D8,0xFFFF,0x18D5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18D6,
+0x18BF,0xFFFF,0xFFFF,0xFFFF,0x18D7,0x18D9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18DA,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0F33,0xFFFF,0x18DB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x100B,0xFFFF,
+0xFFFF,0x07E3,0x081C,0x18DC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F21,0xFFFF,0x0B4B,0xFFFF,0x0FD9,0xFFFF,0xFFFF,
+0x18DD,0xFFFF,0x1098,0xFFFF,0xFFFF,0x0E47,0xFFFF,0x0BE5,0x0E07,0xFFFF,0xFFFF,0x0A74,0xFFFF,0xFFFF,0xFFFF,0x05A1,
+0xFFFF,0x18E2,0x18E0,0xFFFF,0x18DE,0x06FA,0xFFFF,0x0AD6,0x18E3,0xFFFF,0xFFFF,0x18E1,0xFFFF,0x18DF,0x18E7,0xFFFF,
+0xFFFF,0x18E6,0x18E5,0x18E4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18E8,0xFFFF,0xFFFF,0xFFFF,0x18E9,0x0B7B,0xFFFF,
+0x18EA,0xFFFF,0x18EC,0xFFFF,0xFFFF,0x18EB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08A3,0xFFFF,0xFFFF,0xFFFF,0x0BD7,0xFFFF,
+0xFFFF,0xFFFF,0x18EE,0xFFFF,0xFFFF,0xFFFF,0x0D93,0xFFFF,0x18ED,0xFFFF,0xFFFF,0xFFFF,0x18EF,0xFFFF,0x0F22,0x0C0B,
+0x08F6,0xFFFF,0x18F0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10AD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18F2,
+0xFFFF,0xFFFF,0x18F3,0xFFFF,0x18F4,0xFFFF,0x18F5,0xFFFF,0x09D0,0xFFFF,0x18F6,0x0842,0xFFFF,0xFFFF,0x07A1,0xFFFF,
+},
+{ // U+7D00
+0x0761,0xFFFF,0x18F8,0xFFFF,0x101C,0x08F7,0x18F7,0xFFFF,0xFFFF,0xFFFF,0x18FB,0x100F,0xFFFF,0x0E0F,0xFFFF,0xFFFF,
+0x0EC2,0xFFFF,0xFFFF,0xFFFF,0x0A8A,0x18FA,0xFFFF,0x0A1C,0x08F8,0x09D1,0x07A0,0x0F23,0x18F9,0xFFFF,0xFFFF,0xFFFF,
+0x0BE6,0x0F8D,0x0984,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09D2,0x0D16,0xFFFF,0x18FE,0x10C4,
+0x0966,0xFFFF,0x18FF,0x0B25,0xFFFF,0x1901,0xFFFF,0xFFFF,0xFFFF,0x0AD7,0x093D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1900,
+0xFFFF,0xFFFF,0x0A51,0x088F,0x0BE7,0x18FC,0x1902,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18FD,0x0843,0xFFFF,0x1905,0x1909,
+0x085E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1904,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x190D,0xFFFF,0xFFFF,0x08F9,0xFFFF,
+0xFFFF,0x1074,0x059D,0x190A,0xFFFF,0xFFFF,0x07A2,0xFFFF,0x1907,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1908,0xFFFF,
+0xFFFF,0x0D94,0x1906,0x1903,0xFFFF,0x06A3,0x0BA5,0xFFFF,0xFFFF,0x0879,0xFFFF,0xFFFF,0xFFFF,0x190F,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x190C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x190E,
+0xFFFF,0xFFFF,0xFFFF,0x190B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0844,0x0C30,0x1910,0x0C0D,0xFFFF,0xFFFF,0x191D,
+0xFFFF,0xFFFF,0x1919,0x1913,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1917,0x0A43,0x05BE,0x1912,0x191A,
+0x191E,0x08FA,0x0FFF,0xFFFF,0x0D0F,0x1914,0xFFFF,0xFFFF,0x191C,0xFFFF,0x1911,0x0C99,0xFFFF,0x1916,0x059E,0x0FF3,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1915,0xFFFF,0xFFFF,0x07F0,0x0E9D,0xFFFF,0xFFFF,0xFFFF,0x0C0C,
+0xFFFF,0x10B5,0x0A96,0xFFFF,0xFFFF,0x1945,0xFFFF,0xFFFF,0x191F,0xFFFF,0x0BBF,0xFFFF,0x191B,0x1920,0x1922,0xFFFF,
+0x0D32,0x1925,0xFFFF,0xFFFF,0x1921,0xFFFF,0xFFFF,0xFFFF,0x0F41,0x0724,0xFFFF,0xFFFF,0x0FF4,0xFFFF,0xFFFF,0x05BF,
+0xFFFF,0xFFFF,0x1924,0xFFFF,0x10E2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1923,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7E00
+0xFFFF,0x062E,0xFFFF,0xFFFF,0x0DE1,0x1926,0xFFFF,0xFFFF,0xFFFF,0x192D,0x1927,0x192E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x192A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E4E,0xFFFF,0xFFFF,0x0A13,0x192C,
+0xFFFF,0x1929,0x192F,0x1928,0xFFFF,0xFFFF,0x0A6B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F70,0xFFFF,0xFFFF,0x0A73,0xFFFF,
+0xFFFF,0x192B,0x1937,0xFFFF,0xFFFF,0x1933,0xFFFF,0x1936,0xFFFF,0x1934,0x1938,0x1932,0xFFFF,0x1918,0x0B94,0xFFFF,
+0xFFFF,0x0E7C,0xFFFF,0x1935,0xFFFF,0xFFFF,0x1930,0xFFFF,0xFFFF,0xFFFF,0x0BC0,0x0845,0xFFFF,0x0A52,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B08,0x0BD5,0x193B,0xFFFF,0xFFFF,0x193D,0x193E,0xFFFF,0xFFFF,0x193A,0x193C,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1931,0x1939,0xFFFF,0x1941,0x1940,0xFFFF,0xFFFF,0x0FC5,0xFFFF,0xFFFF,
+0x081E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x193F,0xFFFF,0x1943,0x1942,0x1946,0xFFFF,0x1948,
+0xFFFF,0xFFFF,0x09A7,0x1944,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1949,0x194A,0xFFFF,0xFFFF,0x194B,0xFFFF,0x1951,0x0D52,
+0x194D,0xFFFF,0x194C,0x194E,0x194F,0xFFFF,0x1950,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1952,0x1953,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+7F00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0725,0xFFFF,0x1954,0xFFFF,0x1955,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1956,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1957,0x1958,0x1959,0xFFFF,
+0x195A,0x195B,0xFFFF,0xFFFF,0x195D,0x195C,0xFFFF,0xFFFF,0x195E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x195F,
+0x1960,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1963,0x1961,0x1962,0x096E,0x0846,0xFFFF,0xFFFF,0x0CB1,0xFFFF,
+0x0E64,0xFFFF,0x0A97,0xFFFF,0xFFFF,0x0E20,0xFFFF,0x0E9E,0x1964,0x147E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1965,0x1967,0xFFFF,0x106C,0x1966,0x1969,0x1968,0xFFFF,0x105A,0xFFFF,0x196A,0xFFFF,0x0EAF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x196B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x196E,0xFFFF,0xFFFF,0x196D,0x196C,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x196F,0x0825,0xFFFF,0xFFFF,0xFFFF,0x0BC1,0x0778,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1973,0x1970,
+0xFFFF,0xFFFF,0x1971,0xFFFF,0xFFFF,0xFFFF,0x1974,0xFFFF,0x1975,0x1972,0xFFFF,0xFFFF,0xFFFF,0x05E8,0xFFFF,0xFFFF,
+0xFFFF,0x0644,0xFFFF,0xFFFF,0xFFFF,0x1977,0x1978,0xFFFF,0xFFFF,0xFFFF,0x1979,0xFFFF,0x1069,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0A53,0xFFFF,0x197B,0x197A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0B4C,0x197C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x197D,0xFFFF,0xFFFF,0x197E,0xFFFF,0x073E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0726,0xFFFF,0xFFFF,0x197F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1980,0xFFFF,0x0FA8,0x106A,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+8000
+0x105B,0x10FA,0xFFFF,0x08FC,0x1983,0x0A1D,0x1982,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1984,0x09F2,0xFFFF,0xFFFF,0xFFFF,
+0x0C4E,0xFFFF,0x1985,0xFFFF,0xFFFF,0x08FB,0xFFFF,0x1000,0x1986,0x1987,0xFFFF,0xFFFF,0x1988,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1989,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x198A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x09F3,0xFFFF,0xFFFF,0x1016,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x198C,0xFFFF,0x0C9A,0xFFFF,0x198B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x198E,0xFFFF,0xFFFF,0xFFFF,0x198D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x198F,0xFFFF,0xFFFF,0xFFFF,0x0B7C,0xFFFF,0x1990,0xFFFF,0x1991,0xFFFF,0xFFFF,0xFFFF,0x0F26,0x1992,
+0xFFFF,0x0C0E,0x1993,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1994,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10E3,
+0x1997,0xFFFF,0x1996,0x1995,0x0CE9,0xFFFF,0x1998,0x0B09,0xFFFF,0x1999,0xFFFF,0xFFFF,0xFFFF,0x199A,0x10FB,0x199B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x199C,0x199E,0x199D,0x0E56,0xFFFF,0x0DEE,0xFFFF,0x1101,0x0E5A,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x19A0,0xFFFF,0xFFFF,0x0AD8,0xFFFF,0x0EB9,0xFFFF,0x19A1,0x199F,0xFFFF,0x0727,0xFFFF,0xFFFF,
+0xFFFF,0x08A5,0x09D3,0xFFFF,0xFFFF,0x0E9F,0xFFFF,0xFFFF,0xFFFF,0x087B,0x0F8E,0xFFFF,0x19A4,0x19A2,0xFFFF,0x08FD,
+0xFFFF,0x08FE,0x05CA,0xFFFF,0x0975,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E2C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x05C0,0x19A9,0xFFFF,0x0C9B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E2B,0xFFFF,0x0C58,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19AB,0xFFFF,0xFFFF,0x19A7,0x19AA,0x19A5,0xFFFF,0x19A8,0x0F71,0xFFFF,
+0xFFFF,0x08A6,0xFFFF,0xFFFF,0x05DE,0x19A6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19AD,
+0xFFFF,0x19AE,0xFFFF,0xFFFF,0x0DAE,0xFFFF,0xFFFF,0xFFFF,0x07D0,0xFFFF,0xFFFF,0xFFFF,0x19B9,0x0E10,0xFFFF,0xFFFF,
+},
+{ // U+8100
+0xFFFF,0xFFFF,0x09D4,0xFFFF,0xFFFF,0x07D1,0x0B89,0x1109,0x0FD7,0x19AC,0x0B95,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x078A,0x19AF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x19B1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19B0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19B2,
+0xFFFF,0x0C81,0xFFFF,0x0E11,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CEA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19B6,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19B5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19B3,0xFFFF,0xFFFF,0x0B38,0xFFFF,
+0x0EF4,0x19B8,0xFFFF,0x19B7,0x08FF,0x1116,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19C8,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19BC,0x19BD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A39,0xFFFF,0xFFFF,0x19BB,0xFFFF,
+0x0927,0x19BA,0xFFFF,0xFFFF,0x19BE,0xFFFF,0xFFFF,0xFFFF,0x0CEB,0x0F0F,0x0BC2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C59,
+0x19C2,0xFFFF,0x19C3,0x19BF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19C0,0xFFFF,0x19C1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0900,
+0xFFFF,0xFFFF,0xFFFF,0x19C9,0xFFFF,0x19C5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EF5,0xFFFF,0x0FB7,0x0EB7,0xFFFF,0xFFFF,
+0x19C4,0xFFFF,0xFFFF,0x19C7,0x19C6,0xFFFF,0xFFFF,0xFFFF,0x0F8F,0x19CA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x19CB,0xFFFF,0xFFFF,0x0BD6,0xFFFF,0x19CC,0xFFFF,0xFFFF,0x19CE,0xFFFF,0x19D2,0xFFFF,0xFFFF,0x19CF,0x19CD,0x0E12,
+0x19D0,0xFFFF,0x19D1,0xFFFF,0xFFFF,0xFFFF,0x064F,0xFFFF,0x19D8,0x19D3,0xFFFF,0xFFFF,0xFFFF,0x19D4,0xFFFF,0xFFFF,
+0xFFFF,0x19D5,0xFFFF,0x0C1E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19D7,0x19D6,0x19D9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19DA,
+0x19DB,0xFFFF,0xFFFF,0x0B26,0xFFFF,0x0686,0xFFFF,0x19DC,0x10BC,0xFFFF,0x09F4,0xFFFF,0xFFFF,0x0A54,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x09D5,0x0CB2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19DD,0x19DE,0x05F0,0xFFFF,0x19DF,0xFFFF,
+},
+{ // U+8200
+0xFFFF,0x19E0,0x19E1,0xFFFF,0xFFFF,0x19E2,0xFFFF,0x19E3,0x07D2,0x14F7,0x19E4,0xFFFF,0x0BA6,0x19E5,0x0A14,0xFFFF,
+0x19E6,0xFFFF,0x1151,0xFFFF,0xFFFF,0xFFFF,0x19E7,0x0F4B,0x0735,0xFFFF,0xFFFF,0x0BC3,0x0A7F,0xFFFF,0x0F00,0x0A55,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19E8,0x0901,0x19E9,0x0E7D,0xFFFF,0x19F7,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x19EB,0xFFFF,0x0C46,0x0E48,0x0890,0x19EA,0x0BC4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x19EC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D33,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19EE,0x19ED,0x19F0,0xFFFF,0xFFFF,0x19EF,0xFFFF,0x19F1,
+0xFFFF,0xFFFF,0x19F3,0xFFFF,0x19F2,0xFFFF,0x0728,0xFFFF,0x19F4,0xFFFF,0x19F5,0x19F6,0xFFFF,0xFFFF,0x093E,0x10AE,
+0xFFFF,0x19F8,0x0B0A,0xFFFF,0xFFFF,0xFFFF,0x062F,0x19F9,0x19FA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19FB,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05D3,0xFFFF,0x19FC,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x19FD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EF6,0xFFFF,0xFFFF,0xFFFF,0x0A10,0xFFFF,0x19FF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06A4,0x0593,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x19FE,0x1A01,0x0E21,0xFFFF,0x0B27,
+0xFFFF,0x0673,0xFFFF,0x0F72,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0850,0x07F1,0xFFFF,0x1A00,0xFFFF,0x0687,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06FC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0630,0x1A05,0x10CF,0x0C5A,0xFFFF,0xFFFF,0x0ED3,0xFFFF,0x1A11,0xFFFF,0x0674,0x1A0F,0xFFFF,0x1A0D,0x1A04,
+0xFFFF,0x1A02,0xFFFF,0x1A03,0xFFFF,0x0A2C,0x0801,0x0CD2,0xFFFF,0xFFFF,0xFFFF,0x0DC6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0610,0xFFFF,0x1A07,0x1A06,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A0C,0x1A08,0x1A0B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+8300
+0xFFFF,0xFFFF,0x0FF9,0x1A0A,0x0675,0x06F8,0x1A0E,0xFFFF,0xFFFF,0x1A10,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0847,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A14,0x1A1D,0x1A1E,0xFFFF,0xFFFF,0xFFFF,0x058C,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A25,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05D2,0xFFFF,0xFFFF,0x1A1C,0xFFFF,0xFFFF,0xFFFF,0x1A1B,
+0xFFFF,0x1A16,0x1A15,0xFFFF,0x1A13,0x1A12,0x0CBE,0xFFFF,0x0C78,0x1A18,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1A17,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A1A,0xFFFF,0xFFFF,0xFFFF,0x0C0F,0x0848,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0600,
+0x1A19,0xFFFF,0x0902,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C10,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A2B,0xFFFF,0x1A2C,0xFFFF,0x0676,0xFFFF,0xFFFF,0xFFFF,0x064B,0x1A29,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A1F,0xFFFF,0x1A27,0xFFFF,0x1A2E,0x1A28,0xFFFF,0xFFFF,0xFFFF,0x1A26,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A09,0xFFFF,0xFFFF,0x1A24,0xFFFF,0xFFFF,0xFFFF,0x1A20,0xFFFF,0xFFFF,0xFFFF,0x0729,0x1A22,
+0x1A2D,0xFFFF,0x1A23,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A2F,0xFFFF,0x1A21,0x0E4F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1070,0xFFFF,0xFFFF,0xFFFF,0x1A2A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A40,0xFFFF,0xFFFF,
+0xFFFF,0x1A38,0xFFFF,0xFFFF,0xFFFF,0x0B5E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x077D,0xFFFF,0x07F2,0xFFFF,0x1A33,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0678,0xFFFF,0xFFFF,0x0AD9,0xFFFF,0x1A36,0xFFFF,0xFFFF,0xFFFF,0x0967,0xFFFF,0xFFFF,0x0D68,
+0x1A3B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F5B,0xFFFF,0x1A32,0xFFFF,0xFFFF,0xFFFF,0x0677,
+0x08A7,0x0EB8,0x1A3C,0xFFFF,0x1A30,0xFFFF,0xFFFF,0x1A39,0xFFFF,0xFFFF,0xFFFF,0x1A43,0xFFFF,0x1A34,0xFFFF,0xFFFF,
+},
+{ // U+8400
+0xFFFF,0xFFFF,0xFFFF,0x1A35,0x0DAF,0xFFFF,0xFFFF,0x1A3A,0xFFFF,0xFFFF,0xFFFF,0x1A37,0x0F73,0x1A3D,0x05C1,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A31,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1A3F,0xFFFF,0x1A3E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E3E,0x1A45,0xFFFF,0x1A50,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x06F9,0xFFFF,0xFFFF,0xFFFF,0x1A53,0xFFFF,0xFFFF,0x1A41,0xFFFF,0xFFFF,0xFFFF,0x1A46,0x1075,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A4F,0xFFFF,0xFFFF,0x105C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x108F,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CD3,0xFFFF,0xFFFF,0xFFFF,0x06E6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0F01,0x1A55,0x0D96,0xFFFF,0xFFFF,0x0592,0xFFFF,0xFFFF,0x1A4E,0xFFFF,0x1A4A,0x0C11,0x1A44,0x1A4C,0x1A51,
+0xFFFF,0x0DFF,0xFFFF,0xFFFF,0xFFFF,0x058B,0xFFFF,0x1A49,0xFFFF,0x1A52,0x0F07,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1A4D,0xFFFF,0x1A48,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ADA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0A56,0xFFFF,0xFFFF,0xFFFF,0x09F5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1001,0xFFFF,0xFFFF,0x0ED6,0xFFFF,0xFFFF,0x1A58,
+0xFFFF,0x1A61,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A4B,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x06F2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AFD,0x1A56,0xFFFF,0x1A5B,0x0C12,0xFFFF,0xFFFF,0x1A57,
+0xFFFF,0x1A5E,0xFFFF,0xFFFF,0x0CBA,0xFFFF,0x1A5F,0xFFFF,0xFFFF,0x105D,0x1A54,0x06B3,0xFFFF,0x1A5A,0xFFFF,0xFFFF,
+0x1A5D,0x0FD5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A60,0xFFFF,0xFFFF,0x1A59,0x1A5C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F74,0xFFFF,0x10E4,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A64,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A6B,0xFFFF,0xFFFF,0x1A63,
+},
+{ // U+8500
+0x0A0C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A42,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0F3B,0xFFFF,0x0FCB,0x1A6A,0x1A69,0xFFFF,0x1A65,0x1A66,0xFFFF,0x05F5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A68,
+0xFFFF,0x1A62,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D0E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A67,0x05DF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C1F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F30,0xFFFF,0xFFFF,
+0x1A6C,0x1A70,0xFFFF,0x0E8A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A6F,0x0ADB,0x0A12,0x1A72,0xFFFF,0xFFFF,0x07D3,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A73,0xFFFF,0x0F08,0x1A6E,0xFFFF,0x1A47,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A6D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1112,0x0D97,0x0F02,0xFFFF,0xFFFF,0x1A7A,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A80,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A81,0xFFFF,
+0x1A74,0xFFFF,0xFFFF,0xFFFF,0x0E49,0xFFFF,0xFFFF,0x1A7E,0x1A76,0xFFFF,0x1A78,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1A82,0x1A77,0xFFFF,0xFFFF,0x1A7B,0xFFFF,0xFFFF,0x0631,0xFFFF,0x0DDA,0xFFFF,0x1A7C,0x1A7F,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A75,0xFFFF,0x0BC5,0xFFFF,0x1A79,0x0992,0x0B28,0x0823,0x101D,0xFFFF,0x1022,0x0A99,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A86,0x1A84,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1111,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A83,0xFFFF,0xFFFF,0xFFFF,0x107C,0xFFFF,0x1A85,
+0x1A87,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A88,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A8B,0x1A89,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D98,0x1A8A,0xFFFF,0xFFFF,0xFFFF,0x0E7E,0x1A7D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A9A,0xFFFF,0x1A8C,0x1A91,0x0C13,0xFFFF,0xFFFF,0x1A90,0xFFFF,
+},
+{ // U+8600
+0xFFFF,0xFFFF,0x1A71,0xFFFF,0xFFFF,0xFFFF,0x1A92,0x0BE8,0xFFFF,0xFFFF,0x1A8D,0x1A8F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A8E,0xFFFF,0xFFFF,0x1618,0x1609,0xFFFF,0xFFFF,0x1A94,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1A93,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x107D,0xFFFF,0x17F9,
+0x1A95,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A96,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A97,0x08A8,0xFFFF,
+0x078B,0xFFFF,0xFFFF,0xFFFF,0x1A99,0x11DC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07AC,0xFFFF,0x109F,0xFFFF,0x0808,0x1A9A,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A9B,0xFFFF,0xFFFF,0xFFFF,0x0CC9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1A9C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DEF,0xFFFF,0x059B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0680,0x1AA1,0x1AA2,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A9D,0xFFFF,0x09A8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1A9E,0x0E15,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1A9F,0x1AA0,0x1AAA,0xFFFF,0xFFFF,0xFFFF,0x1AA4,
+0x1AA7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AA3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AA5,0xFFFF,0x1AA6,0x0A21,0xFFFF,0x1AA8,0xFFFF,0x0C9C,0xFFFF,0x0849,0x06BD,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AAB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06BA,0xFFFF,0x1AB0,0xFFFF,0xFFFF,0x1AAC,0x1AAF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E6B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AAD,0xFFFF,0xFFFF,0x1AAE,0x0ED7,0x0E8B,0x1AB1,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C7A,0x1ABB,0xFFFF,0x1AB7,0xFFFF,0xFFFF,0x0688,0xFFFF,
+},
+{ // U+8700
+0x1AB5,0xFFFF,0x0F75,0x1AB6,0xFFFF,0xFFFF,0x1AB3,0xFFFF,0x1AB4,0x1AB9,0x1ABC,0xFFFF,0xFFFF,0x1ABA,0xFFFF,0xFFFF,
+0xFFFF,0x1AB8,0x1AB2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CB3,0xFFFF,0x1AC3,0xFFFF,0x0FD3,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AC1,0xFFFF,0xFFFF,0xFFFF,0x1AC2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1ABD,0xFFFF,0xFFFF,0x1ABF,0xFFFF,0xFFFF,0xFFFF,0x1AC0,0xFFFF,0xFFFF,0xFFFF,0x1ABE,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BA7,0xFFFF,0x10FC,0x1AC7,0xFFFF,0x1AC8,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1ACE,0xFFFF,0x0B0D,0xFFFF,0x1ACA,0xFFFF,0x1ACD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AC5,
+0x1AC4,0xFFFF,0xFFFF,0x1ACF,0xFFFF,0xFFFF,0x0679,0xFFFF,0x1ACB,0xFFFF,0x1AD0,0xFFFF,0xFFFF,0xFFFF,0x1ACC,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AC9,0xFFFF,0x0CEC,0xFFFF,0x1AC6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E3B,
+0xFFFF,0xFFFF,0x1AD4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1042,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AD3,
+0xFFFF,0xFFFF,0x1AD2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1ADB,0xFFFF,0xFFFF,0xFFFF,0x1AD5,
+0xFFFF,0xFFFF,0xFFFF,0x1ADD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x106D,0x1AE0,0xFFFF,0x1AD7,0xFFFF,0xFFFF,
+0x1AD8,0xFFFF,0xFFFF,0xFFFF,0x1ADC,0xFFFF,0x1ADF,0x1ADE,0xFFFF,0xFFFF,0xFFFF,0x1AD6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1AD9,0xFFFF,0x1AEA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1AE3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AE1,
+0xFFFF,0xFFFF,0x1AE2,0xFFFF,0xFFFF,0xFFFF,0x1AE7,0x1AE8,0xFFFF,0x06A5,0xFFFF,0x0779,0xFFFF,0xFFFF,0x1AE6,0xFFFF,
+},
+{ // U+8800
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AD1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AE5,0x1AE9,0x1AE4,
+0xFFFF,0x1AEB,0xFFFF,0xFFFF,0xFFFF,0x1AED,0x1AEC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1AEF,0x1AEE,0x1AA9,0xFFFF,0xFFFF,0xFFFF,0x1AF3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1AF0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AF1,0xFFFF,0xFFFF,0x1AF2,0xFFFF,0x1AF4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x085F,0xFFFF,0x1AF6,0xFFFF,0x1AF5,0xFFFF,0x0A57,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0903,0x166C,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1AF7,0x0A78,0xFFFF,0xFFFF,0xFFFF,0x06B4,0xFFFF,0x1AF8,0xFFFF,0x0611,0xFFFF,0x0ADC,0x1AF9,0xFFFF,
+0xFFFF,0x0904,0x1AFA,0x05C2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ECC,0xFFFF,0xFFFF,0x1AFB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0B4D,0xFFFF,0x1B02,0xFFFF,0xFFFF,0x1AFF,0xFFFF,0x0CCA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B00,0x1AFD,0x07F3,
+0xFFFF,0x1AFC,0x1B03,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0829,0xFFFF,0xFFFF,0x0C5B,0xFFFF,0x1B09,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1B05,0xFFFF,0xFFFF,0xFFFF,0x0C32,0x1B04,0xFFFF,0x1B07,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1AFE,0xFFFF,
+0xFFFF,0xFFFF,0x1B08,0xFFFF,0x1B0A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EA0,0xFFFF,0xFFFF,0x1B06,0xFFFF,
+0x1B0B,0x1B0D,0xFFFF,0xFFFF,0x08A4,0x1B01,0xFFFF,0x05A2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B0C,
+0xFFFF,0x0968,0x10DB,0x1B0E,0x1B0F,0x0C14,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1087,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B10,0x103C,0xFFFF,0xFFFF,0x1B11,0x1B12,0xFFFF,0xFFFF,0x0F51,0x1B13,0xFFFF,0x094D,
+0xFFFF,0x1088,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B18,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1B19,0x0ADD,0x1B17,0xFFFF,0xFFFF,0xFFFF,0x106E,0x1B14,0xFFFF,0xFFFF,0x1B16,0x0B7E,0x0B61,0xFFFF,
+},
+{ // U+8900
+0xFFFF,0xFFFF,0x1B15,0xFFFF,0x1B1A,0xFFFF,0xFFFF,0x0F10,0xFFFF,0xFFFF,0x1B1C,0xFFFF,0x1B1B,0xFFFF,0xFFFF,0xFFFF,
+0x06E7,0xFFFF,0x0F76,0x1B1D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B29,0x1B1F,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B20,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B21,0x1B22,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B26,0xFFFF,0x1B27,0xFFFF,0xFFFF,0x1B25,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1B23,0xFFFF,0x1B1E,0x1B24,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B28,0x1D18,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0645,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B2B,0x07F4,
+0x1B2A,0xFFFF,0xFFFF,0xFFFF,0x1B2D,0xFFFF,0x1B2C,0xFFFF,0xFFFF,0xFFFF,0x1B2F,0xFFFF,0xFFFF,0x1B2E,0xFFFF,0x1B30,
+0xFFFF,0xFFFF,0x0A58,0xFFFF,0x1B31,0xFFFF,0xFFFF,0x1B32,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B33,0x0B7F,
+0xFFFF,0x105E,0xFFFF,0x1B34,0xFFFF,0xFFFF,0x0F11,0x0E19,0x1B35,0xFFFF,0x1B36,0x087C,0xFFFF,0xFFFF,0xFFFF,0x0763,
+0xFFFF,0xFFFF,0xFFFF,0x1B37,0xFFFF,0xFFFF,0x09D6,0x0E14,0x1B38,0xFFFF,0x06CB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1B39,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B3B,0x107E,0xFFFF,0x1B3A,0x0B29,0xFFFF,0x1B3C,0xFFFF,0xFFFF,0x1B3D,
+0xFFFF,0xFFFF,0x1B3E,0x072A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B3F,0xFFFF,0xFFFF,0x1B40,0xFFFF,0x1B41,
+0x1B42,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x06CC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B43,0xFFFF,0x1B44,0x1B45,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x068F,0xFFFF,0xFFFF,0x0B0B,0x1B46,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B47,0xFFFF,0xFFFF,0xFFFF,0x1B48,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+8A00
+0x0891,0xFFFF,0x0D34,0x1B49,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x084A,0xFFFF,0x0B39,0xFFFF,0x1B4C,0xFFFF,0x0D99,0xFFFF,
+0x1B4B,0xFFFF,0xFFFF,0x0824,0xFFFF,0xFFFF,0x1B4A,0x0C74,0x0764,0xFFFF,0xFFFF,0x1B4D,0xFFFF,0x1B4E,0xFFFF,0x0ADE,
+0xFFFF,0xFFFF,0xFFFF,0x0860,0xFFFF,0x1B4F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F77,0xFFFF,0xFFFF,0x0BA0,0xFFFF,0xFFFF,
+0xFFFF,0x07AD,0xFFFF,0x101E,0x0BE9,0xFFFF,0x1B50,0xFFFF,0xFFFF,0xFFFF,0x0B2A,0x0CCB,0x0ADF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1B51,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B54,0xFFFF,0x1B55,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x094B,0x0C3F,0x1B53,0xFFFF,0x0AE0,0x0ECD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B52,0xFFFF,0xFFFF,0x09D7,0xFFFF,
+0x0612,0xFFFF,0x1B59,0x084B,0xFFFF,0xFFFF,0x09D9,0xFFFF,0xFFFF,0x09D8,0xFFFF,0x1110,0x1B58,0x1B57,0x0BC6,0xFFFF,
+0x0784,0x1106,0x06B5,0x0AE1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B56,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1B5B,0xFFFF,0x1B5C,0x1B5A,0xFFFF,0x08A9,0xFFFF,0x1047,0xFFFF,0xFFFF,0x09DA,0x0DFA,0xFFFF,0xFFFF,
+0xFFFF,0x1B5F,0xFFFF,0x0B81,0xFFFF,0x0C9D,0xFFFF,0xFFFF,0x103D,0xFFFF,0x1B62,0xFFFF,0xFFFF,0xFFFF,0x08BD,0xFFFF,
+0x0B80,0x1B5E,0xFFFF,0x1B63,0x08BE,0x1B60,0x1B61,0xFFFF,0x1B5D,0xFFFF,0xFFFF,0xFFFF,0x0BA3,0x0DBE,0xFFFF,0xFFFF,
+0x0C8A,0xFFFF,0x067A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EA1,0xFFFF,0xFFFF,0x077A,0xFFFF,0xFFFF,0x0CED,
+0xFFFF,0xFFFF,0x1B66,0xFFFF,0x1B64,0xFFFF,0xFFFF,0x0CA7,0xFFFF,0xFFFF,0xFFFF,0x0B82,0x072B,0x1B65,0xFFFF,0x0B3E,
+0xFFFF,0xFFFF,0x10AF,0xFFFF,0xFFFF,0xFFFF,0x1103,0xFFFF,0xFFFF,0xFFFF,0x1B67,0x1B72,0x0CEE,0xFFFF,0x1B71,0xFFFF,
+0x1B6E,0x1B76,0x1B6F,0xFFFF,0x1B6B,0xFFFF,0x0D35,0x1B6A,0xFFFF,0xFFFF,0xFFFF,0x1B68,0xFFFF,0x1028,0x09DB,0xFFFF,
+0xFFFF,0x1B6C,0xFFFF,0x1B69,0xFFFF,0xFFFF,0xFFFF,0x1B70,0x0A9B,0xFFFF,0x0892,0xFFFF,0xFFFF,0xFFFF,0x0C77,0xFFFF,
+},
+{ // U+8B00
+0x0F90,0x0619,0x05C3,0xFFFF,0x0D9A,0xFFFF,0xFFFF,0x1B74,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B73,0xFFFF,0x0DDB,0xFFFF,
+0x1B78,0xFFFF,0xFFFF,0xFFFF,0x1B6D,0xFFFF,0x1B77,0x1B79,0xFFFF,0x087D,0x1B75,0x0905,0xFFFF,0x0A1E,0xFFFF,0xFFFF,
+0x1B7A,0x105F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B7D,0xFFFF,0x1B80,0xFFFF,0xFFFF,0x1B7E,0x0EC4,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1B7B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07F5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B7F,0xFFFF,
+0xFFFF,0x1B81,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B85,0xFFFF,0xFFFF,0x1B82,0xFFFF,0x1B84,0x1B83,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B86,0xFFFF,0x09FA,0xFFFF,0x1B88,0x1B87,0x0EF7,0xFFFF,0xFFFF,0x1B8A,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x084C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B89,0x1B8B,0xFFFF,0xFFFF,0x1B8C,
+0x077B,0x1976,0x0AFE,0xFFFF,0x1B8D,0xFFFF,0xFFFF,0x08BF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B8E,0xFFFF,0xFFFF,
+0x1B8F,0xFFFF,0xFFFF,0x09A9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x151B,0xFFFF,0x1B90,0xFFFF,0x1B91,0xFFFF,
+0x0A59,0xFFFF,0x1B92,0x1B93,0xFFFF,0xFFFF,0x1B94,0xFFFF,0xFFFF,0x1B95,0x1B96,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+8C00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C86,0xFFFF,0xFFFF,0x1B97,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B99,
+0xFFFF,0x1B98,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D9B,0xFFFF,0x1B9A,0xFFFF,0x0F78,0xFFFF,0x1B9B,0xFFFF,0x1B9C,0xFFFF,
+0x1B9D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1B9E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DCF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0AE2,0x1B9F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x091A,0x114F,0x1BA0,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BA1,0x0ECE,0x1BA2,0xFFFF,0x1BAA,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1BA3,0xFFFF,0xFFFF,0x1BA5,0xFFFF,0xFFFF,0xFFFF,0x1BA4,0x1BA6,0xFFFF,0x0F91,0x1BA7,0x1BA8,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BA9,0xFFFF,0xFFFF,0xFFFF,0x1BAB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06A8,0x0D20,0xFFFF,
+0x0EF8,0x096F,0x0906,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EDE,0x067C,0x0E7F,0x1BAE,0x072C,0x0B96,0x1BAD,0x1BB2,0x0CD4,
+0x100C,0xFFFF,0x1BB0,0x1BB1,0x0765,0xFFFF,0x1BB3,0x0E36,0x0C5C,0xFFFF,0xFFFF,0x0EA2,0x0D54,0x1BAF,0xFFFF,0x0F92,
+0x0689,0x1BB5,0x10EB,0x0CFB,0x1108,0xFFFF,0xFFFF,0x09DC,0x1BB4,0xFFFF,0x0C2E,0xFFFF,0xFFFF,0x1BC5,0x0BC7,0xFFFF,
+0xFFFF,0x0DED,0xFFFF,0x0EDF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BB8,0x09AA,0x09DD,0xFFFF,0x0AE3,0xFFFF,
+0x0E38,0xFFFF,0x087E,0x1BB7,0x1BB6,0xFFFF,0x0EF9,0xFFFF,0xFFFF,0xFFFF,0x0A0A,0xFFFF,0xFFFF,0x0D69,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BBA,0x1BBB,0x0907,0x1BB9,0xFFFF,0xFFFF,
+},
+{ // U+8D00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BBC,0x1BBD,0xFFFF,0x1BBF,0x0C20,0xFFFF,0x1BBE,0x073F,0xFFFF,0x1BC1,0xFFFF,0x1BC0,
+0x1BC2,0xFFFF,0xFFFF,0x1BC4,0x1BC6,0xFFFF,0x1BC7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B97,0xFFFF,0x0A18,0x1BC8,0xFFFF,0xFFFF,0xFFFF,0x06CD,0xFFFF,0x1BC9,0xFFFF,0xFFFF,
+0x0C15,0x1BCA,0xFFFF,0x1BCB,0x0EFA,0xFFFF,0xFFFF,0x0766,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1BCC,0xFFFF,0xFFFF,0xFFFF,0x0CEF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x061A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BCD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0A3A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B59,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0C2A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BD0,0xFFFF,0xFFFF,0xFFFF,0x1BCF,0xFFFF,
+0xFFFF,0xFFFF,0x1BCE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BD6,0x1BD4,0xFFFF,0xFFFF,0x1BD1,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BD3,0xFFFF,0xFFFF,0xFFFF,0x1BD2,0x1BD5,0xFFFF,0x07AE,0xFFFF,0x1BD9,
+0xFFFF,0x0B98,0xFFFF,0x1BDA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08AA,0xFFFF,0x1BD7,0x1BD8,0xFFFF,0xFFFF,0xFFFF,0x10EC,
+0xFFFF,0xFFFF,0xFFFF,0x0CF0,0xFFFF,0x0BC8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BDB,0xFFFF,0xFFFF,0x1BDE,
+},
+{ // U+8E00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BDC,0x1BDD,0x1060,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D9C,
+0x1BE1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BDF,0x1BE0,0x1BE2,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BF0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1BE5,0xFFFF,0xFFFF,0xFFFF,0x1BE6,0x1BE4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1BE3,0xFFFF,0x0D36,0xFFFF,0xFFFF,0x1BE8,0x1BEC,0x1BE9,0x1BE7,0xFFFF,0x1BEA,0xFFFF,0xFFFF,0xFFFF,
+0x1BEB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BF2,0xFFFF,0xFFFF,0xFFFF,0x1BED,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B99,
+0x1BEF,0xFFFF,0xFFFF,0x1BF1,0x1BEE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1BF4,0xFFFF,0x0A5A,0xFFFF,0x1BF3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BF5,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1BF6,0xFFFF,0xFFFF,0x1BF9,0x1BF8,0xFFFF,0x1BF7,0xFFFF,0xFFFF,0x1BFB,0x1BFA,0xFFFF,0x101F,0xFFFF,0xFFFF,
+0xFFFF,0x1BFD,0xFFFF,0x1BFC,0x1BFE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1BFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1C01,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C00,0x0B2B,0x1C02,0xFFFF,0xFFFF,0x0802,
+0x1C03,0x1C05,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C06,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C07,0x1C04,0xFFFF,0x1C08,0xFFFF,0x0A1F,0x1C09,0x0767,0x0826,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x087F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C0A,0xFFFF,0xFFFF,0xFFFF,0x0DE5,
+0xFFFF,0xFFFF,0x0D55,0x1C0B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C0E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09FD,0xFFFF,0xFFFF,0x1C0D,0x1C0C,0x084D,0x1C0F,0xFFFF,
+},
+{ // U+8F00
+0xFFFF,0xFFFF,0xFFFF,0x06CE,0xFFFF,0x1C11,0xFFFF,0xFFFF,0xFFFF,0x0969,0x1C10,0xFFFF,0x1C19,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C13,0x1C15,0x0F52,0x1C12,0xFFFF,0xFFFF,0xFFFF,0x1C14,0xFFFF,0x1C18,0x1C16,0x0768,0xFFFF,0x1C17,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C1A,0xFFFF,0xFFFF,0x0E2D,0x10BD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A5B,
+0xFFFF,0xFFFF,0xFFFF,0x1C1B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1029,0x1C1D,0xFFFF,0x1C1C,0xFFFF,0xFFFF,0x1C20,0x1048,
+0xFFFF,0xFFFF,0x1C1F,0xFFFF,0x06E8,0x1C1E,0x1C23,0xFFFF,0xFFFF,0x1C22,0xFFFF,0xFFFF,0x1C21,0x0D49,0x1C24,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C25,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C26,0xFFFF,0xFFFF,0x091B,
+0xFFFF,0x0818,0x1C27,0x1C28,0x1C29,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B2C,0x1C2A,0xFFFF,0x09F6,0x1C2B,
+0xFFFF,0xFFFF,0xFFFF,0x1C2C,0xFFFF,0xFFFF,0xFFFF,0x11FE,0x11FD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C2D,0x1947,0x1C2E,
+0x0C7F,0x0B0E,0x0E13,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C2F,0xFFFF,0xFFFF,0x0F42,0x0D0D,0x092D,0xFFFF,0xFFFF,0x0C84,
+0xFFFF,0xFFFF,0x05E9,0xFFFF,0x0FC3,0x0B3A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0851,0xFFFF,
+0xFFFF,0x07F6,0xFFFF,0xFFFF,0x0F43,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C30,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C32,0xFFFF,0xFFFF,0x1C31,0x067D,0xFFFF,0xFFFF,0x0DEB,0x1C33,0x0E4A,0xFFFF,0x0D4A,0xFFFF,0x1C34,
+0x0A79,0xFFFF,0xFFFF,0xFFFF,0x1C36,0xFFFF,0xFFFF,0x0FEB,0x1C45,0x1C38,0x1C39,0xFFFF,0xFFFF,0x0D02,0xFFFF,0xFFFF,
+},
+{ // U+9000
+0x0C5D,0x0C16,0xFFFF,0x0D9D,0xFFFF,0x1C37,0x078C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C40,0xFFFF,0x1C3D,0x1C4A,0x0D9E,
+0x0CBB,0x1C3A,0xFFFF,0x0D37,0x0D6A,0x1C3B,0x1C3F,0x0B43,0xFFFF,0x0E3A,0x0D05,0xFFFF,0xFFFF,0x0B83,0x1C3E,0x0C2B,
+0x0C21,0x1C3C,0x058A,0x10E5,0xFFFF,0xFFFF,0xFFFF,0x1C41,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C5E,0xFFFF,
+0xFFFF,0x0A5C,0x0B2D,0xFFFF,0xFFFF,0x1C43,0x1C42,0xFFFF,0x05D0,0x1C44,0xFFFF,0xFFFF,0x0EBE,0xFFFF,0x1C4C,0xFFFF,
+0xFFFF,0x0DD0,0x0B4E,0xFFFF,0xFFFF,0x0CB4,0xFFFF,0x080D,0xFFFF,0x1C4B,0x103E,0x05FE,0xFFFF,0x0F44,0x067E,0x1C46,
+0x1C47,0x1C48,0x1C49,0x0DB0,0x0C7E,0x05C4,0x1C4D,0xFFFF,0x1C4E,0x1E7C,0xFFFF,0xFFFF,0x0C3A,0xFFFF,0x1C4F,0xFFFF,
+0x0632,0x0BEB,0xFFFF,0x0880,0xFFFF,0x1061,0xFFFF,0xFFFF,0x1C50,0x0D43,0xFFFF,0xFFFF,0xFFFF,0x0C17,0x0A20,0x1C51,
+0xFFFF,0xFFFF,0x1C54,0xFFFF,0xFFFF,0x0A8C,0x1C52,0x0BCA,0x0BC9,0xFFFF,0x05C5,0xFFFF,0x10B0,0x1C56,0xFFFF,0x0EA3,
+0x1C58,0x1C57,0x1C55,0x187F,0x072D,0xFFFF,0xFFFF,0x1C35,0xFFFF,0x1C5A,0x1C59,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C5B,
+0xFFFF,0x103F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0DD6,0xFFFF,0xFFFF,0x0F79,0xFFFF,0x1C5C,0xFFFF,0x0A22,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C5D,
+0xFFFF,0x1C5E,0xFFFF,0xFFFF,0xFFFF,0x1C5F,0xFFFF,0xFFFF,0x0D38,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x05CB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0908,0xFFFF,0xFFFF,0xFFFF,0x10FD,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C63,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0827,0x1C60,0xFFFF,0x1C61,0xFFFF,0xFFFF,0xFFFF,0x0F03,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06CF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1040,0xFFFF,0x07D4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D6B,0xFFFF,0xFFFF,
+},
+{ // U+9100
+0xFFFF,0xFFFF,0x1C64,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C65,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C66,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D39,0xFFFF,0xFFFF,
+0x1C68,0xFFFF,0x1C67,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DC8,0x1C69,0x0A5D,0x0A29,0x0E2E,0x0CCC,0xFFFF,
+0xFFFF,0xFFFF,0x0A3B,0xFFFF,0x0B4F,0xFFFF,0x1C6A,0xFFFF,0x1C6B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0B40,0x1C6C,0xFFFF,0x1C6D,0xFFFF,0xFFFF,0xFFFF,0x1C6E,0x1076,0xFFFF,0x0A5E,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C70,0x1C6F,0xFFFF,0x0909,0xFFFF,0x0922,0x09AB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C73,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A8D,0xFFFF,0x1C72,0xFFFF,0x1C71,0xFFFF,0x0C66,0xFFFF,0xFFFF,
+0x08C0,0xFFFF,0x0B84,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E61,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A60,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1C74,0xFFFF,0x0AE4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C77,0x1C75,0xFFFF,0xFFFF,0xFFFF,0x1C76,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C79,0x1C78,0xFFFF,0xFFFF,0x0AFF,0xFFFF,0x1C7A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1C7B,0x1C7C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0E81,0x0960,0x0A2A,0x1C7D,0xFFFF,0x1C7E,0x1089,0x0A6C,0x1017,0x10B1,
+0x1C7F,0x07F7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C80,0xFFFF,0x0D3A,0xFFFF,0xFFFF,0x1C83,0x06F3,0x0B2E,0xFFFF,0x1C81,
+0xFFFF,0x1C82,0xFFFF,0x0D19,0xFFFF,0xFFFF,0x0FA0,0x0811,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C85,0x1C86,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C84,0xFFFF,0xFFFF,0x1C88,
+},
+{ // U+9200
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DD4,0x06BE,0xFFFF,
+0xFFFF,0x1C8C,0xFFFF,0xFFFF,0x1C89,0x1C8B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C87,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CD2,0xFFFF,0xFFFF,0x1C8A,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10D0,0xFFFF,0xFFFF,0x08AB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C94,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D4B,0x1C8F,0xFFFF,0xFFFF,0x1C92,0x1C90,0xFFFF,0x1C95,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1C96,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C8E,0xFFFF,0xFFFF,0x1C9B,0x0633,0xFFFF,0xFFFF,0x1C8D,0xFFFF,
+0xFFFF,0xFFFF,0x0E5E,0xFFFF,0x1C91,0xFFFF,0x0AE5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x090A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F93,0xFFFF,
+0x07F9,0xFFFF,0xFFFF,0x0A6D,0xFFFF,0x0DB1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0BCC,0xFFFF,0x1C99,0xFFFF,0x1C93,0x1C98,0xFFFF,0x0FEC,0xFFFF,0x0CF1,0x1C9A,0x1C97,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BCB,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C9E,0xFFFF,0x1C9D,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C9C,
+0xFFFF,0xFFFF,0x0F7A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AA2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1C9F,0x0F4C,0xFFFF,0xFFFF,0x0613,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0ED5,0x0CCD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x07AF,0xFFFF,0x1CA1,0xFFFF,0x090C,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9300
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0997,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CA0,
+0x0B50,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0B51,0x1CA4,0x1CA6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0B00,0xFFFF,0x1CA5,0x1CA7,0xFFFF,0xFFFF,0x07E8,0xFFFF,0x0ED4,0xFFFF,0xFFFF,0x0A2B,0x10E6,0xFFFF,0x1CA3,0x0985,
+0xFFFF,0xFFFF,0x1102,0xFFFF,0xFFFF,0x1CA9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CA8,0x1CAA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CA2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0DDE,0xFFFF,0x0D6C,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D10,0xFFFF,0x1CAF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C9E,0x1CAB,0xFFFF,0xFFFF,0xFFFF,
+0x1CAC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0820,0xFFFF,0x1CAE,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0881,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CAD,0xFFFF,0x0AE6,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06F4,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CB3,0xFFFF,0x094C,0x0C18,0xFFFF,0xFFFF,0x0D03,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06B6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CB1,0x1CB2,0x0CFC,0xFFFF,
+0x1CB0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CB4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1CBA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CBD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1CBC,0x0D44,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CB5,0x1CB6,0x1CB9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CBB,0xFFFF,0xFFFF,
+0xFFFF,0x07D5,0xFFFF,0xFFFF,0x1CBE,0x1CB8,0xFFFF,0xFFFF,0x1CB7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9400
+0xFFFF,0xFFFF,0xFFFF,0x1CC2,0xFFFF,0xFFFF,0xFFFF,0x1CC3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1CC4,0xFFFF,0xFFFF,0x1CC1,0x1CC0,0xFFFF,0xFFFF,0xFFFF,0x0AE7,0x0D9F,0x1CBF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1CC8,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CC6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CC7,0x1CC5,0xFFFF,0x0C75,0xFFFF,0x1CC9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1CCA,0xFFFF,0xFFFF,0x1CCC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x072E,0x1CCB,0x1023,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CD7,0x1CCD,0xFFFF,0xFFFF,0x1CD0,0xFFFF,
+0x1CCE,0xFFFF,0x1CCF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CD1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1CD3,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CD4,0xFFFF,0x1CD5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CD8,0x1CD6,0x1CD9,0x1CDB,
+0xFFFF,0x1CDA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9500
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CF2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1010,0xFFFF,0x1CDC,0x0BCD,0xFFFF,0xFFFF,0xFFFF,0x1CDD,0xFFFF,0x0F31,0x1CDE,0x06A6,0xFFFF,0xFFFF,0xFFFF,0x05FB,
+0xFFFF,0x0730,0xFFFF,0x072F,0x1CDF,0xFFFF,0x1CE0,0xFFFF,0x1CE1,0x1CE2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1CE3,0xFFFF,0x0731,0x06D0,0x090D,0x0E67,0xFFFF,0x1CE5,0x1CE4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CE6,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x061B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CE9,0xFFFF,0x1CE8,0x1CE7,0xFFFF,0x1CEA,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1CED,0xFFFF,0xFFFF,0xFFFF,0x05A8,0xFFFF,0xFFFF,0x1CEB,0xFFFF,0x1CEF,0x1CEE,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CF1,0x1CF0,0x1CF2,0xFFFF,0x0DA3,0xFFFF,0xFFFF,0xFFFF,0x1CF3,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1CF4,0x1CF6,0xFFFF,0xFFFF,0x1CF5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9600
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EFB,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1CF7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CF8,0xFFFF,0x0972,0xFFFF,0xFFFF,0xFFFF,0x1CF9,0x1CFA,
+0xFFFF,0xFFFF,0x0F94,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0BEA,0xFFFF,0xFFFF,0xFFFF,0x0585,
+0x0C48,0xFFFF,0x1CFB,0xFFFF,0x0EFC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1CFE,0x1CFC,0x090E,0xFFFF,0x1CFD,
+0x0893,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F32,0x1D00,0x1D02,0x1D01,0x1D03,
+0xFFFF,0xFFFF,0x05E0,0x0B3B,0x0AA3,0x0732,0x1D04,0xFFFF,0xFFFF,0xFFFF,0x0E39,0xFFFF,0x1D06,0xFFFF,0xFFFF,0xFFFF,
+0x05E1,0xFFFF,0x1D05,0x0CFD,0xFFFF,0x10B2,0x0DA0,0x1CFF,0x108B,0xFFFF,0x0882,0xFFFF,0xFFFF,0x1062,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x080E,0x1099,0xFFFF,0x081B,0xFFFF,0x0C5F,0x19B4,0xFFFF,0x1D07,0x06A7,0x0B52,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06D1,0x1D09,0xFFFF,0x1D0A,0x1D08,0x0857,0xFFFF,0x096A,0x0AE8,0xFFFF,0xFFFF,0xFFFF,
+0x05E2,0xFFFF,0xFFFF,0x10BE,0xFFFF,0xFFFF,0xFFFF,0x1D0C,0x1C53,0xFFFF,0x1D0B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1D0F,0x1D0D,0x1D0E,0xFFFF,0x1D10,0xFFFF,0x1D11,0x10D1,0x1D12,0x1D13,0xFFFF,0x0B8A,0x0E6C,0xFFFF,0xFFFF,0xFFFF,
+0x0B60,0x0740,0xFFFF,0xFFFF,0x1041,0x068A,0x0A5F,0x08AC,0xFFFF,0x1D16,0xFFFF,0x1D15,0x09DE,0x1D17,0x1D14,0xFFFF,
+0xFFFF,0x0993,0xFFFF,0xFFFF,0xFFFF,0x1D1B,0x1ADA,0xFFFF,0xFFFF,0x1233,0xFFFF,0x0B5A,0x1D19,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x108A,0x0DE6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05EA,0xFFFF,0x0BA4,0x09FF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0F24,0xFFFF,0x05FF,0xFFFF,0xFFFF,0xFFFF,0x10D2,0x1072,0xFFFF,0x1D1C,0xFFFF,0x0D5C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9700
+0x0A44,0xFFFF,0xFFFF,0xFFFF,0x1D1D,0xFFFF,0x1D1E,0x0B2F,0x1D1F,0xFFFF,0x10D3,0xFFFF,0xFFFF,0x1D1A,0x1D21,0x1D23,
+0xFFFF,0x1D22,0xFFFF,0x1D20,0xFFFF,0xFFFF,0x1D24,0xFFFF,0xFFFF,0x1D25,0xFFFF,0xFFFF,0x0C19,0xFFFF,0x067F,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D26,0xFFFF,0xFFFF,0x0FE1,0xFFFF,0xFFFF,0x1D27,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1D28,0xFFFF,0x10ED,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x155C,0x1D29,0xFFFF,0xFFFF,0xFFFF,0x1D2A,0x1D2B,0xFFFF,
+0xFFFF,0xFFFF,0x1D2F,0xFFFF,0x1D2C,0xFFFF,0x1D2D,0xFFFF,0x1D2E,0x1D30,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0B85,0xFFFF,0xFFFF,0xFFFF,0x1020,0xFFFF,0xFFFF,0x0B86,0xFFFF,0xFFFF,0x1D31,0xFFFF,0x0EA4,0xFFFF,
+0x1D32,0x1E4E,0x0FF5,0xFFFF,0x1D33,0xFFFF,0x1D34,0xFFFF,0x1D35,0x06D2,0xFFFF,0x1D37,0xFFFF,0x0B3C,0xFFFF,0xFFFF,
+0xFFFF,0x1D38,0xFFFF,0xFFFF,0x0817,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D39,0x1D3D,0xFFFF,0x1D3B,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1D3C,0xFFFF,0xFFFF,0x06EE,0x1D3A,0x1D3E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D3F,0xFFFF,0x05A9,0xFFFF,0x1D40,
+0x1D41,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0AE9,0xFFFF,0xFFFF,0xFFFF,0x1D42,0xFFFF,0xFFFF,0xFFFF,
+0x077E,0xFFFF,0xFFFF,0x1D45,0xFFFF,0xFFFF,0x1D44,0xFFFF,0x1D43,0xFFFF,0xFFFF,0x1B7C,0xFFFF,0x0F49,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1D46,0x1D47,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1D48,0xFFFF,0xFFFF,0x1D49,0xFFFF,0x1D4A,0xFFFF,0xFFFF,0x1D4B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0733,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D4C,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D4D,0x0DF6,0xFFFF,
+0xFFFF,0xFFFF,0x1D4F,0x0658,0xFFFF,0x1D52,0x1D51,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x05E3,0xFFFF,0xFFFF,0xFFFF,0x07D6,
+},
+{ // U+9800
+0xFFFF,0x0F34,0x0CF3,0x092F,0xFFFF,0x090F,0x0A8E,0xFFFF,0x0B3F,0xFFFF,0xFFFF,0xFFFF,0x1D54,0xFFFF,0xFFFF,0x1D53,
+0x1049,0x0741,0x0E83,0x0DD1,0xFFFF,0xFFFF,0xFFFF,0x0B5F,0x10B3,0xFFFF,0x084E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1D57,0xFFFF,0xFFFF,0x1D56,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F96,0x0DA1,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x060F,0xFFFF,0xFFFF,0x1D58,0x1D55,0xFFFF,0xFFFF,0x0EE0,0x1071,0x1D59,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D5A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D5C,0x0C67,0x06D6,0x06D7,0x1D5B,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0742,0x0883,0xFFFF,0xFFFF,0x0743,0xFFFF,0xFFFF,0x0D56,0xFFFF,0xFFFF,0x10C5,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x08AD,0xFFFF,0xFFFF,0xFFFF,0x1D5D,0xFFFF,0xFFFF,0xFFFF,0x1D5E,
+0x1D5F,0x1D60,0xFFFF,0x1D62,0x1D61,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F06,0xFFFF,0x1D63,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D64,
+0xFFFF,0x1D65,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D66,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1D68,0x1D67,0xFFFF,0x1D69,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EA5,0x1981,0xFFFF,0xFFFF,0x0B0C,
+0xFFFF,0xFFFF,0x0769,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D6A,0xFFFF,0x1D6B,0xFFFF,0x1209,0x1622,0x0E84,
+0xFFFF,0xFFFF,0x05DC,0xFFFF,0x059C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x09DF,0x0F7B,0x0B03,0xFFFF,
+},
+{ // U+9900
+0xFFFF,0xFFFF,0xFFFF,0x1D6C,0xFFFF,0x1008,0xFFFF,0xFFFF,0xFFFF,0x1D6D,0x1063,0xFFFF,0x0601,0xFFFF,0xFFFF,0xFFFF,
+0x09AC,0xFFFF,0x1D6E,0x068B,0x1D6F,0xFFFF,0xFFFF,0xFFFF,0x1D70,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D72,0x1D73,0xFFFF,
+0x1D75,0x1D71,0xFFFF,0xFFFF,0x1D74,0xFFFF,0xFFFF,0xFFFF,0x0734,0xFFFF,0xFFFF,0xFFFF,0x1D76,0xFFFF,0x1D77,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D78,0x1D79,0xFFFF,
+0xFFFF,0xFFFF,0x1D7A,0xFFFF,0xFFFF,0x1D7C,0xFFFF,0xFFFF,0xFFFF,0x1D7B,0xFFFF,0x1D7E,0x1D81,0xFFFF,0xFFFF,0xFFFF,
+0x1D7D,0x1D7F,0x1D80,0xFFFF,0xFFFF,0x1D82,0xFFFF,0x07D7,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0A3C,0x1D83,0x1D84,0x0910,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D85,0xFFFF,0xFFFF,0x06B9,0xFFFF,0xFFFF,0xFFFF,0x0E22,0x1D86,0x1D87,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x0CB5,0x0DE0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D88,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x0E50,0xFFFF,0xFFFF,0x0C49,0x0617,0x0803,0xFFFF,0x0804,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0CCE,0x1D8D,0x0805,0xFFFF,0xFFFF,0x068C,0xFFFF,0xFFFF,0x1D8C,0xFFFF,0xFFFF,0x1D8A,0xFFFF,0x1D8B,0xFFFF,0x1D89,
+0xFFFF,0xFFFF,0x1D97,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D8E,0x1D8F,0xFFFF,
+0xFFFF,0x1D90,0x1D91,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D93,0xFFFF,0xFFFF,0x1D92,0xFFFF,0xFFFF,0xFFFF,0x0A80,
+},
+{ // U+9A00
+0xFFFF,0x1D94,0xFFFF,0xFFFF,0xFFFF,0x1D96,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x076A,0x1D95,
+0xFFFF,0xFFFF,0x0C1A,0x0884,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D98,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C4A,0xFFFF,0xFFFF,0x1D99,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0DA2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D9A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1D9F,0xFFFF,
+0x1D9D,0xFFFF,0x1D9C,0x1D9E,0xFFFF,0x1D9B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DA1,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DA0,0xFFFF,0x1DA3,0xFFFF,0xFFFF,0x07D8,0x1DA2,0xFFFF,0xFFFF,0xFFFF,0x1DA4,
+0xFFFF,0xFFFF,0x1DA5,0xFFFF,0x1DA7,0x1DA6,0xFFFF,0xFFFF,0xFFFF,0x1DA8,0x1DAA,0x1DA9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x092B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DAB,0xFFFF,0xFFFF,
+0x1DAC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06B7,0xFFFF,0xFFFF,0xFFFF,0x1DAD,0xFFFF,0xFFFF,0xFFFF,
+0x1DAE,0xFFFF,0xFFFF,0xFFFF,0x0B54,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DAF,
+0xFFFF,0x1DB0,0xFFFF,0x1DB1,0x1DB2,0xFFFF,0xFFFF,0xFFFF,0x0911,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DB3,0x1DB4,
+0xFFFF,0xFFFF,0x1DB5,0x1DB6,0xFFFF,0xFFFF,0x1DB7,0xFFFF,0xFFFF,0xFFFF,0x0E62,0x1DB9,0xFFFF,0x0EB5,0x1DBA,0x1DB8,
+0xFFFF,0x1DBC,0xFFFF,0xFFFF,0x1DBB,0xFFFF,0xFFFF,0x1DBD,0xFFFF,0xFFFF,0xFFFF,0x1DBE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9B00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DBF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DC0,0xFFFF,0x1DC1,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DC2,
+0xFFFF,0xFFFF,0x1DC3,0x1DC4,0xFFFF,0x1DC5,0xFFFF,0x1DC6,0x1DC7,0x1DC8,0x1DC9,0xFFFF,0xFFFF,0xFFFF,0x1DCA,0x1DCB,
+0xFFFF,0x161C,0x1DCC,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x18F1,0x076B,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x069C,0x093F,0x1DCE,0x1DCD,0x0FCE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DD0,0x1DD1,0x1DCF,
+0xFFFF,0x1DD2,0xFFFF,0xFFFF,0x0FAD,0xFFFF,0xFFFF,0xFFFF,0x1DD3,0xFFFF,0x07B2,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10E8,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DD4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x1DD6,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x059F,0xFFFF,
+0xFFFF,0x1DD7,0x0F18,0x1DD5,0xFFFF,0xFFFF,0x1DD8,0x1DD9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DDA,
+0x1DDB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DDC,0xFFFF,0x0FB9,0x0998,0xFFFF,0x0987,0x0BCE,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DDD,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DE0,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1DDE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DE1,0xFFFF,0xFFFF,0x08C2,0x1DDF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DE2,
+0xFFFF,0x1DE3,0x1DE4,0xFFFF,0x1DE8,0xFFFF,0x0995,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0C61,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1DE9,0x1DE6,0x1DE5,0x1DE7,0xFFFF,0xFFFF,0xFFFF,0x0852,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1DED,0x1DEC,0x1DEB,0xFFFF,0xFFFF,0x0594,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9C00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DF7,0xFFFF,0x1DF3,0xFFFF,0x1DF4,0x1DF0,0x1DF6,0xFFFF,0x1DF2,0x06DD,0xFFFF,0xFFFF,
+0x110F,0xFFFF,0x1DF5,0x1DF1,0x1DEF,0x1DEE,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1DF9,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1DFC,0xFFFF,0xFFFF,0x1DFB,0x1DFA,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0ED8,0x1DF8,0x05D4,
+0x1DFD,0xFFFF,0x1DFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x06EA,0x1DEA,0x05F6,0xFFFF,0xFFFF,0x1E01,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E00,0x1DFE,0x0C88,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x0FBB,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x10BF,0xFFFF,0xFFFF,0x1E02,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1E03,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E04,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E05,0xFFFF,0x1E06,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0CF4,0xFFFF,0x1E07,0xFFFF,0x0E68,0xFFFF,0x1E0C,0x1E08,0xFFFF,0xFFFF,0xFFFF,
+0x1E09,0xFFFF,0xFFFF,0x0F7C,0x0FED,0xFFFF,0x0DC5,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+9D00
+0xFFFF,0xFFFF,0xFFFF,0x1E0D,0xFFFF,0xFFFF,0x1E0E,0x0DB3,0x1E0B,0x1E0A,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0647,0xFFFF,
+0xFFFF,0xFFFF,0x1E16,0xFFFF,0xFFFF,0x1E15,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0634,0xFFFF,0xFFFF,0xFFFF,0x1E13,
+0xFFFF,0xFFFF,0xFFFF,0x1E12,0xFFFF,0xFFFF,0x1E10,0xFFFF,0x06F6,0xFFFF,0x1E0F,0x09FB,0x0646,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0912,0xFFFF,0xFFFF,0x1E19,0x1E18,
+0xFFFF,0x1E17,0xFFFF,0xFFFF,0x1E14,0xFFFF,0x1E1A,0xFFFF,0x1E1B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x1E20,0x1E1F,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E21,0xFFFF,0xFFFF,0x05EC,0x1E1C,0x1E1D,0xFFFF,
+0x0923,0x0FE2,0xFFFF,0xFFFF,0x1E1E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0F7D,0xFFFF,0xFFFF,0x1E26,
+0xFFFF,0xFFFF,0x1E22,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E27,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E24,0xFFFF,0x1E23,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x084F,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E28,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E29,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E2A,0xFFFF,0x1E25,0xFFFF,0xFFFF,0xFFFF,0x1E11,
+0xFFFF,0xFFFF,0x1E2B,0xFFFF,0x0D1A,0xFFFF,0xFFFF,0xFFFF,0x1E2F,0xFFFF,0x1E30,0x1E2E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1E2D,0x1E33,0xFFFF,0x1E2C,0xFFFF,0x1E31,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E32,
+0xFFFF,0xFFFF,0xFFFF,0x1E35,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E34,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E37,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E38,0xFFFF,0x1E39,
+0xFFFF,0xFFFF,0x110C,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E36,0x0C68,0x097A,0xFFFF,0xFFFF,0x1E3A,0xFFFF,0xFFFF,
+},
+{ // U+9E00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E3B,0x1E3C,0xFFFF,0xFFFF,0x1E3D,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E3E,0xFFFF,0xFFFF,0x0885,0x1E3F,0xFFFF,0xFFFF,0xFFFF,0x1E40,0xFFFF,0x09F8,
+0xFFFF,0x1E41,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E42,0xFFFF,0xFFFF,0x1E43,0x1E44,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0x1E47,0x1E45,0x10FF,0xFFFF,0x1E46,0xFFFF,0x10D4,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E48,0xFFFF,0x10C0,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E49,0x0E51,0xFFFF,0xFFFF,0x1E4A,0x1E4C,0xFFFF,0xFFFF,0x1E4D,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E4B,0x091C,0x0FF6,0x0FAE,0x13CC,0xFFFF,0x1647,0x0FC6,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0648,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E4F,0x0787,0x1E50,0x1E51,
+0x1E52,0xFFFF,0x0924,0xFFFF,0x1E53,0xFFFF,0xFFFF,0xFFFF,0x1755,0x1004,0xFFFF,0x0C60,0x1E54,0x1E56,0x1E55,0xFFFF,
+0x1E57,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E58,0xFFFF,0xFFFF,0x1E59,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E5A,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E5B,0xFFFF,0x1E5C,0x1E5D,0xFFFF,0x1E5E,0xFFFF,0x1E5F,0x1E60,0x1E61,0xFFFF,0xFFFF,
+},
+{ // U+9F00
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E62,0x1E63,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0D3B,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0x08AE,0xFFFF,0x1E65,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0BEC,0x1E66,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E67,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x0EB0,0xFFFF,0xFFFF,0x1E68,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E69,0x1852,0xFFFF,0xFFFF,0x1BC3,0x1D4E,
+0xFFFF,0xFFFF,0x1E6A,0xFFFF,0x1E6B,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E6D,
+0x1E6E,0x1E6F,0x10D5,0x1E6C,0xFFFF,0xFFFF,0x1E70,0x1E71,0xFFFF,0xFFFF,0x1E73,0xFFFF,0x1E72,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0x1E75,0xFFFF,0xFFFF,0xFFFF,0x1E76,0x1E74,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x109B,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E77,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0x1E78,0x186F,0xFFFF,0xFFFF,
+0x1E79,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+{ // U+FF00
+0xFFFF,0x0009,0xFFFF,0x0053,0x004F,0x0052,0x0054,0xFFFF,0x0029,0x002A,0x0055,0x003B,0x0003,0x003C,0x0004,0x001E,
+0x00CB,0x00CC,0x00CD,0x00CE,0x00CF,0x00D0,0x00D1,0x00D2,0x00D3,0x00D4,0x0006,0x0007,0x0042,0x0040,0x0043,0x0008,
+0x0056,0x00DC,0x00DD,0x00DE,0x00DF,0x00E0,0x00E1,0x00E2,0x00E3,0x00E4,0x00E5,0x00E6,0x00E7,0x00E8,0x00E9,0x00EA,
+0x00EB,0x00EC,0x00ED,0x00EE,0x00EF,0x00F0,0x00F1,0x00F2,0x00F3,0x00F4,0x00F5,0x002D,0x001F,0x002E,0x000F,0x0011,
+0x000D,0x00FC,0x00FD,0x00FE,0x00FF,0x0100,0x0101,0x0102,0x0103,0x0104,0x0105,0x0106,0x0107,0x0108,0x0109,0x010A,
+0x010B,0x010C,0x010D,0x010E,0x010F,0x0110,0x0111,0x0112,0x0113,0x0114,0x0115,0x002F,0x0022,0x0030,0x0020,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0x0050,0x0051,0x0089,0x0010,0xFFFF,0x004E,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,0xFFFF,
+},
+};
+
+}
@@ -9,12 +9,14 @@
 */
 //=====================================================================//
 #include <cstdint>
+#include "graphics/retained.hpp"
 
 namespace graphics {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief	メニュー・クラス
+		@brief	メニュー・クラス @n
+				前回と同じ状態の項目は描き直さない（画面を消去した場合「invalidate()」）
 		@param[in]	REND	描画クラス
 		@param[in]	BACK	背面の描画クラス	
 		@param[in]	MAX		最大メニュー数
@@ -54,6 +56,8 @@ namespace graphics {
 
 		bool		focus_;
 
+		retained<MAX>	retained_;
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -65,7 +69,7 @@ namespace graphics {
 			size_(0), mx_(0), my_(0), ox_(0), oy_(0),
 			gap_(0), space_w_(0), space_h_(0), pos_(0),
 			fc_(REND::COLOR::Black), hc_(REND::COLOR::White), bc_(REND::COLOR::Gray),
-			focus_(true)
+			focus_(true), retained_()
 		{ }
 
 
@@ -115,6 +119,14 @@ namespace graphics {
 		uint16_t size() const noexcept { return size_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	次回のレンダリングで、全ての項目を描き直す様にする
+		*/
+		//-----------------------------------------------------------------//
+		void invalidate() noexcept { retained_.invalidate(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	フォーカスを戻す
@@ -167,6 +179,7 @@ namespace graphics {
 			my_ = 0;
 			pos_ = 0;
 			focus_ = false;
+			retained_.invalidate();
 		}
 
 
@@ -205,6 +218,7 @@ namespace graphics {
 			}
 			mx_ = x;
 			my_ = y;
+			retained_.invalidate();
 		}
 
 
@@ -238,10 +252,17 @@ namespace graphics {
 						c = hc_;
 					}
 				}
-				back_(x, y, mx_, obj.h_ + space_h_ * 2, c);
+				// 項目の位置と色が前回と同じなら描かない
+				auto sig = retained<MAX>::hash(c, retained<MAX>::hash((x << 16) | (y & 0xffff)));
+				bool draw = retained_.update(i, sig);
+				if(draw) {
+					back_(x, y, mx_, obj.h_ + space_h_ * 2, c);
+				}
 				y += space_h_;
-				auto t = static_cast<const char*>(obj_[i].src_);
-				rend_.draw_text(x + space_w_, y, t);
+				if(draw) {
+					auto t = static_cast<const char*>(obj_[i].src_);
+					rend_.draw_text(x + space_w_, y, t);
+				}
 				y += obj.h_;
 				y += space_h_;
 				y += gap_ - (gap_ / 2);
@@ -0,0 +1,125 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	描画状態の保持クラス @n
+			ウィジェット毎に、前回描画した時の状態（シグネチャー）を保持し、@n
+			変化した物だけを描き直す為に使う。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace graphics {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	描画状態の保持クラス
+		@param[in]	N	ウィジェットの数
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint16_t N>
+	class retained {
+
+		uint32_t	sig_[N];
+		bool		valid_[N];
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	シグネチャーの初期値
+		*/
+		//-------------------------------------------------------------//
+		static const uint32_t hash_org = 2166136261u;
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	シグネチャーに値を加える（FNV-1a）
+			@param[in]	v	値
+			@param[in]	h	シグネチャー
+			@return シグネチャー
+		*/
+		//-------------------------------------------------------------//
+		static uint32_t hash(uint32_t v, uint32_t h = hash_org) noexcept
+		{
+			for(uint32_t i = 0; i < 4; ++i) {
+				h ^= v & 0xff;
+				h *= 16777619u;
+				v >>= 8;
+			}
+			return h;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	シグネチャーに文字列を加える（FNV-1a）
+			@param[in]	text	文字列
+			@param[in]	h		シグネチャー
+			@return シグネチャー
+		*/
+		//-------------------------------------------------------------//
+		static uint32_t hash(const char* text, uint32_t h = hash_org) noexcept
+		{
+			while(*text != 0) {
+				h ^= static_cast<uint8_t>(*text++);
+				h *= 16777619u;
+			}
+			return h;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-------------------------------------------------------------//
+		retained() noexcept : sig_() { invalidate(); }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	全てのウィジェットを無効にする（次回、全て描き直す）
+		*/
+		//-------------------------------------------------------------//
+		void invalidate() noexcept
+		{
+			for(uint16_t i = 0; i < N; ++i) {
+				valid_[i] = false;
+			}
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ウィジェットを無効にする
+			@param[in]	idx	ウィジェットの番号
+		*/
+		//-------------------------------------------------------------//
+		void invalidate(uint16_t idx) noexcept
+		{
+			if(idx < N) valid_[idx] = false;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	シグネチャーを更新
+			@param[in]	idx	ウィジェットの番号
+			@param[in]	sig	シグネチャー
+			@return 描き直す必要がある場合「true」
+		*/
+		//-------------------------------------------------------------//
+		bool update(uint16_t idx, uint32_t sig) noexcept
+		{
+			if(idx >= N) return true;
+			if(valid_[idx] && sig_[idx] == sig) return false;
+			sig_[idx] = sig;
+			valid_[idx] = true;
+			return true;
+		}
+	};
+}
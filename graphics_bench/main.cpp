@@ -0,0 +1,946 @@
+//=====================================================================//
+/*!	@file
+	@brief	graphics ベンチマーク（ホスト用）@n
+			「-kfont」漢字混じりのページを、スクロールしながら繰り返し描画し、@n
+			フォント・ファイルへのアクセス回数と時間を、従来の kfont と比較する。@n
+			「-render」塗りつぶし、テキスト、ビットマップ、イメージ転送の速度を、@n
+			従来の render と比較する（描画結果が一致する事も確認する）。@n
+			「-wave」RTK5_DSOS の波形画面を、毎回全体を描く場合と、変化した所だけ @n
+			描く場合で比較する（更新領域の面積と、描画結果が一致する事も確認する）。@n
+			「-peak」キャプチャー全体を画面に縮小する場合の、列毎のピーク計算を、@n
+			全サンプルを調べる場合と、ピーク・ピラミッドで比較する。@n
+			「-measure」RTK5_DSOS の計測（振幅、実効値、周期、FFT）の時間と、@n
+			倍精度で計算した場合との誤差を調べる。@n
+			「-trigger」RTK5_DSOS のトリガー判定を、合成した波形で試験し、@n
+			１サンプル当たりの時間を計る（プリ・トリガー、モードも試験する）。@n
+			「-uni」で、graphics/kfont_uni.cpp（unicode 変換テーブル）を出力する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+#include "graphics/font8x16.hpp"
+#include "graphics/kfont.hpp"
+#include "graphics/graphics.hpp"
+#include "kfont_legacy.hpp"
+#include "graphics/dirty_rect.hpp"
+#include "common/format.hpp"
+#include "render_legacy.hpp"
+
+// RTK5_DSOS/capture.hpp はデバイスに依存するので、波形画面が使う定義だけ用意する
+namespace utils {
+
+	struct capture_data {
+		uint16_t	ch0_;
+		uint16_t	ch1_;
+	};
+}
+
+#include "RTK5_DSOS/trigger.hpp"
+#include "RTK5_DSOS/peak_pyramid.hpp"
+#include "RTK5_DSOS/render_wave.hpp"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	static const int16_t LCD_X = 480;
+	static const int16_t LCD_Y = 272;
+
+	struct option_t {
+		std::string	font = "../graphics/kfont16.bin";
+		uint32_t	frames = 200;
+	};
+	option_t	opt_;
+
+	// FatFs のホスト実装（アクセス回数を数える）
+	struct fs_count_t {
+		uint32_t	open = 0;
+		uint32_t	read = 0;
+		uint32_t	sector = 0;  ///< 読み出しで触れたセクタ数（SD カードの転送量の目安）
+		uint32_t	byte = 0;
+	};
+	fs_count_t	count_;
+	std::map<const FIL*, FILE*>	host_fp_;
+
+	uint16_t	fb_[LCD_X * LCD_Y];
+	uint16_t	fb2_[LCD_X * LCD_Y];
+
+	static const int16_t IMG_W = 160;
+	static const int16_t IMG_H = 120;
+	uint16_t	img_[IMG_W * IMG_H];
+	uint8_t		bmp_[32 * 32 / 8];
+
+	uint32_t	seed_;
+	uint32_t rand_() {
+		seed_ = seed_ * 1103515245 + 12345;
+		return (seed_ >> 16) & 0x7fff;
+	}
+
+	// 描画するページ（ファイラーやメニューを想定した漢字混じりのテキスト）
+	const char* text_[] = {
+		"ファイル一覧: /music/アルバム/",
+		"01_春の訪れ.mp3      3,521,024",
+		"02_夏祭りの夜.mp3    4,102,400",
+		"03_秋風と月.wav     12,582,912",
+		"04_冬の星座.mp3      2,987,520",
+		"設定メニュー",
+		"  音量調整　　　　　　 ８０％",
+		"  画面の明るさ　　　　 中",
+		"  時刻合わせ 2018/09/22 12:34",
+		"  言語選択　日本語／English",
+		"測定結果: 電圧 3.30V 電流 120mA",
+		"周波数 1.000kHz 振幅 2.50Vpp",
+		"トリガー 立ち上がり 自動",
+		"記録開始 記録停止 保存 削除",
+		"エラー: カードが挿入されていません",
+		"警告: 残り容量が少なくなりました",
+		"吾輩は猫である。名前はまだ無い。",
+		"どこで生れたかとんと見当がつかぬ。",
+		"何でも薄暗いじめじめした所で",
+		"ニャーニャー泣いていた事だけは記憶",
+		"している。吾輩はここで始めて人間",
+		"というものを見た。しかもあとで聞く",
+		"とそれは書生という人間中で一番獰悪",
+		"な種族であったそうだ。",
+		"春眠暁を覚えず、処処啼鳥を聞く。",
+		"夜来風雨の声、花落つること知る多少",
+		"国破れて山河在り、城春にして草木深し",
+		"時に感じては花にも涙を濺ぎ",
+		"別れを恨んでは鳥にも心を驚かす",
+		"電源を切る前にデータを保存して下さい",
+		"通信速度 115200bps 受信 送信 待機中",
+		"温度 25.3℃ 湿度 48％ 気圧 1013hPa",
+	};
+	static const uint32_t TEXTN = sizeof(text_) / sizeof(text_[0]);
+
+
+	template <class KFONT>
+	double render_(KFONT& kf, uint32_t frames)
+	{
+		typedef graphics::render<uint16_t, LCD_X, LCD_Y, graphics::font8x16, KFONT> RENDER;
+		RENDER	render(fb_, kf);
+		render.set_fore_color(RENDER::COLOR::White);
+		auto st = std::chrono::steady_clock::now();
+		for(uint32_t f = 0; f < frames; ++f) {
+			render.clear(RENDER::COLOR::Black);
+			for(int16_t i = 0; i < (LCD_Y / 16); ++i) {
+				render.draw_text(0, i * 16, text_[(f + i) % TEXTN]);
+			}
+		}
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+		return d.count();
+	}
+
+
+	void report_(const char* title, double t, uint32_t frames)
+	{
+		printf("%-8s: %6.2f [ms/frame], open: %u, read: %u, sector: %u, byte: %u\n",
+			title, t * 1000.0 / frames, count_.open, count_.read, count_.sector, count_.byte);
+	}
+
+
+	template <class KFONT>
+	void test_(const char* title)
+	{
+		KFONT kf;
+		count_ = fs_count_t();
+		auto t = render_(kf, opt_.frames);
+		report_(title, t, opt_.frames);
+		printf("          hit: %u, miss: %u, block: %u\n", kf.get_hit(), kf.get_miss(), kf.get_read());
+	}
+
+
+	void kfont_()
+	{
+		typedef graphics::legacy_kfont<16, 16, 64> LEGACY;
+		typedef graphics::kfont<16, 16, 64> KFONT;
+
+		{
+			LEGACY kf;
+			count_ = fs_count_t();
+			auto t = render_(kf, opt_.frames);
+			report_("legacy", t, opt_.frames);
+		}
+		test_<graphics::kfont<16, 16, 64> >("kfont");
+		test_<graphics::kfont<16, 16, 64, 8> >("block 8");
+		test_<graphics::kfont<16, 16, 255, 8> >("cash 255");
+
+		// 変換のみ（ff_convert の二分探索と、変換テーブル）
+		static const uint32_t LOOP = 200;
+		uint32_t sum = 0;
+		auto st = std::chrono::steady_clock::now();
+		for(uint32_t n = 0; n < LOOP; ++n) {
+			for(uint32_t c = 0x4e00; c < 0xa000; ++c) {
+				sum += LEGACY::sjis_to_liner(ff_convert(c, 0));
+			}
+		}
+		std::chrono::duration<double> d0 = std::chrono::steady_clock::now() - st;
+		st = std::chrono::steady_clock::now();
+		for(uint32_t n = 0; n < LOOP; ++n) {
+			for(uint32_t c = 0x4e00; c < 0xa000; ++c) {
+				sum -= KFONT::to_liner(c);
+			}
+		}
+		std::chrono::duration<double> d1 = std::chrono::steady_clock::now() - st;
+		auto num = LOOP * (0xa000 - 0x4e00);
+		printf("convert : ff_convert %.1f [ns], table %.1f [ns] (check: %u)\n",
+			d0.count() * 1e9 / num, d1.count() * 1e9 / num, sum);
+	}
+
+
+	typedef graphics::kfont<16, 16, 255, 8> RKFONT;
+	typedef graphics::render<uint16_t, LCD_X, LCD_Y, graphics::font8x16, RKFONT> RENDER;
+	typedef graphics::legacy_render<uint16_t, LCD_X, LCD_Y, graphics::font8x16, RKFONT> LEGACY_RENDER;
+
+
+	template <class R>
+	uint32_t bench_fill_(R& r, uint32_t loop)
+	{
+		seed_ = 1;
+		uint32_t pix = 0;
+		for(uint32_t i = 0; i < loop; ++i) {
+			int16_t x = static_cast<int16_t>(rand_() % (LCD_X + 100)) - 50;
+			int16_t y = static_cast<int16_t>(rand_() % (LCD_Y + 100)) - 50;
+			int16_t w = rand_() % 200 + 1;
+			int16_t h = rand_() % 100 + 1;
+			r.fill_box(x, y, w, h, rand_());
+			pix += w * h;
+		}
+		return pix;
+	}
+
+
+	template <class R>
+	uint32_t bench_text_(R& r, uint32_t loop)
+	{
+		seed_ = 1;
+		uint32_t pix = 0;
+		for(uint32_t i = 0; i < loop; ++i) {
+			r.set_fore_color(rand_());
+			int16_t x = static_cast<int16_t>(rand_() % 16) - 8;
+			int16_t y = static_cast<int16_t>(rand_() % (LCD_Y + 16)) - 16;
+			auto e = r.draw_text(x, y, text_[i % TEXTN]);
+			pix += (e - x) * 16;
+		}
+		return pix;
+	}
+
+
+	template <class R>
+	uint32_t bench_bitmap_(R& r, uint32_t loop)
+	{
+		seed_ = 1;
+		uint32_t pix = 0;
+		for(uint32_t i = 0; i < loop; ++i) {
+			r.set_fore_color(rand_());
+			r.set_back_color(rand_());
+			int16_t x = static_cast<int16_t>(rand_() % (LCD_X + 32)) - 32;
+			int16_t y = static_cast<int16_t>(rand_() % (LCD_Y + 32)) - 32;
+			r.draw_bitmap(x, y, bmp_, 32, 32, true);
+			pix += 32 * 32;
+		}
+		return pix;
+	}
+
+
+	// 従来は、イメージを plot で描画していた
+	uint32_t bench_blit_(LEGACY_RENDER& r, uint32_t loop)
+	{
+		seed_ = 1;
+		uint32_t pix = 0;
+		for(uint32_t i = 0; i < loop; ++i) {
+			int16_t x = static_cast<int16_t>(rand_() % (LCD_X + IMG_W)) - IMG_W;
+			int16_t y = static_cast<int16_t>(rand_() % (LCD_Y + IMG_H)) - IMG_H;
+			const uint16_t* p = img_;
+			for(int16_t yy = 0; yy < IMG_H; ++yy) {
+				for(int16_t xx = 0; xx < IMG_W; ++xx) {
+					r.plot(x + xx, y + yy, *p++);
+				}
+			}
+			pix += IMG_W * IMG_H;
+		}
+		return pix;
+	}
+
+
+	uint32_t bench_blit_(RENDER& r, uint32_t loop)
+	{
+		seed_ = 1;
+		uint32_t pix = 0;
+		for(uint32_t i = 0; i < loop; ++i) {
+			int16_t x = static_cast<int16_t>(rand_() % (LCD_X + IMG_W)) - IMG_W;
+			int16_t y = static_cast<int16_t>(rand_() % (LCD_Y + IMG_H)) - IMG_H;
+			r.blit(x, y, img_, IMG_W, IMG_H);
+			pix += IMG_W * IMG_H;
+		}
+		return pix;
+	}
+
+
+	template <class F0, class F1>
+	void compare_(const char* title, F0 f0, F1 f1)
+	{
+		std::memset(fb_, 0, sizeof(fb_));
+		std::memset(fb2_, 0, sizeof(fb2_));
+		auto st = std::chrono::steady_clock::now();
+		uint32_t p0 = f0();
+		std::chrono::duration<double> d0 = std::chrono::steady_clock::now() - st;
+		st = std::chrono::steady_clock::now();
+		uint32_t p1 = f1();
+		std::chrono::duration<double> d1 = std::chrono::steady_clock::now() - st;
+		double m0 = p0 / d0.count() / 1e6;
+		double m1 = p1 / d1.count() / 1e6;
+		bool ok = std::memcmp(fb_, fb2_, sizeof(fb_)) == 0;
+		printf("%-8s: legacy %8.1f [Mpix/s], render %8.1f [Mpix/s], x%.1f, %s\n",
+			title, m0, m1, m1 / m0, ok ? "match" : "MISMATCH");
+	}
+
+
+	void render_bench_()
+	{
+		for(uint32_t i = 0; i < (IMG_W * IMG_H); ++i) {
+			img_[i] = i * 7;
+		}
+		for(uint32_t i = 0; i < sizeof(bmp_); ++i) {
+			bmp_[i] = i * 37 + 11;
+		}
+		RKFONT kf;
+		LEGACY_RENDER r0(fb_, kf);
+		RENDER r1(fb2_, kf);
+		static const uint32_t LOOP = 2000;
+		compare_("fill", [&]() { return bench_fill_(r0, LOOP); }, [&]() { return bench_fill_(r1, LOOP); });
+		compare_("text", [&]() { return bench_text_(r0, LOOP); }, [&]() { return bench_text_(r1, LOOP); });
+		compare_("bitmap", [&]() { return bench_bitmap_(r0, LOOP * 10); }, [&]() { return bench_bitmap_(r1, LOOP * 10); });
+		compare_("blit", [&]() { return bench_blit_(r0, LOOP); }, [&]() { return bench_blit_(r1, LOOP); });
+	}
+
+
+	// 波形を発生するキャプチャー
+	template <uint32_t CAPN>
+	class wave_capture {
+	public:
+		static const uint32_t CAP_NUM = CAPN;
+
+		typedef utils::peak_pyramid<CAPN, utils::capture_data> PEAK;
+		typedef typename PEAK::peak_t peak_t;
+
+	private:
+		utils::capture_data	data_[CAP_NUM];
+		PEAK	peak_;
+
+	public:
+		void make(uint32_t frame)
+		{
+			peak_.clear();
+			for(uint32_t i = 0; i < CAP_NUM; ++i) {
+				float a = static_cast<float>(i + frame * 3) * 0.05f;
+				data_[i].ch0_ = 2048 + static_cast<int16_t>(std::sin(a) * 1200.0f) + rand_() % 64;
+				data_[i].ch1_ = ((i + frame) & 64) != 0 ? 1024 : 3072;
+				peak_.add(data_[i]);
+			}
+		}
+
+		void rebuild()
+		{
+			peak_.clear();
+			for(uint32_t i = 0; i < CAP_NUM; ++i) {
+				peak_.add(data_[i]);
+			}
+		}
+
+		const utils::capture_data& get(uint32_t pos) const { return data_[pos % CAP_NUM]; }
+
+		bool get_peak(int32_t pos, uint32_t len, peak_t& out) const { return peak_.get(data_, pos, len, out); }
+
+		// 全サンプルを調べる場合
+		bool scan_peak(int32_t pos, uint32_t len, peak_t& out) const
+		{
+			out.min[0] = out.min[1] = 0xffff;
+			out.max[0] = out.max[1] = 0;
+			bool ret = false;
+			for(int32_t i = pos; i < (pos + static_cast<int32_t>(len)); ++i) {
+				if(i < 0 || i >= static_cast<int32_t>(CAP_NUM)) continue;
+				const auto& d = data_[i];
+				if(out.min[0] > d.ch0_) out.min[0] = d.ch0_;
+				if(out.max[0] < d.ch0_) out.max[0] = d.ch0_;
+				if(out.min[1] > d.ch1_) out.min[1] = d.ch1_;
+				if(out.max[1] < d.ch1_) out.max[1] = d.ch1_;
+				ret = true;
+			}
+			return ret;
+		}
+	};
+
+	struct wave_touch { };
+
+
+	struct wave_result_t {
+		double		time = 0.0;		///< 全体を描く場合
+		double		time_p = 0.0;	///< 変化した所だけ描く場合
+		uint64_t	area = 0;
+		uint64_t	area_p = 0;
+		uint32_t	ng = 0;
+	};
+
+
+	uint32_t area_(const graphics::dirty_null& d) { return 0; }
+
+	template <uint8_t N>
+	uint32_t area_(const graphics::dirty_rect<N>& d) { return d.area(); }
+
+
+	template <class DIRTY>
+	wave_result_t wave_frames_()
+	{
+		typedef graphics::render<uint16_t, LCD_X, LCD_Y, graphics::font8x16, RKFONT, DIRTY> DRENDER;
+		typedef wave_capture<2048> CAPTURE;
+		typedef utils::render_wave<DRENDER, CAPTURE, wave_touch> WAVE;
+
+		RKFONT kf;
+		DRENDER r0(fb_, kf);
+		DRENDER r1(fb2_, kf);
+		static CAPTURE cap;
+		wave_touch touch;
+		WAVE w0(r0, cap, touch);
+		WAVE w1(r1, cap, touch);
+		std::memset(fb_, 0, sizeof(fb_));
+		std::memset(fb2_, 0, sizeof(fb2_));
+
+		seed_ = 1;
+		wave_result_t t;
+		for(uint32_t f = 0; f < opt_.frames; ++f) {
+			cap.make(f);
+			r0.at_dirty().clear();
+			r1.at_dirty().clear();
+
+			w0.invalidate();  // 従来と同じく、毎回全体を描く
+			auto st = std::chrono::steady_clock::now();
+			w0.update();
+			std::chrono::duration<double> d0 = std::chrono::steady_clock::now() - st;
+			st = std::chrono::steady_clock::now();
+			w1.update();
+			std::chrono::duration<double> d1 = std::chrono::steady_clock::now() - st;
+			t.time += d0.count();
+			t.time_p += d1.count();
+			t.area += area_(r0.at_dirty());
+			t.area_p += area_(r1.at_dirty());
+			if(std::memcmp(fb_, fb2_, sizeof(fb_)) != 0) ++t.ng;
+		}
+		return t;
+	}
+
+
+	void wave_bench_()
+	{
+		// 時間は更新領域を管理しない場合、面積は管理する場合で計る
+		auto t = wave_frames_<graphics::dirty_null>();
+		auto a = wave_frames_<graphics::dirty_rect<16> >();
+		printf("full    : %6.3f [ms/frame], dirty area: %u [pixel/frame]\n",
+			t.time * 1000.0 / opt_.frames, static_cast<uint32_t>(a.area / opt_.frames));
+		printf("partial : %6.3f [ms/frame], dirty area: %u [pixel/frame], x%.1f, %s\n",
+			t.time_p * 1000.0 / opt_.frames, static_cast<uint32_t>(a.area_p / opt_.frames),
+			t.time / t.time_p, (t.ng + a.ng) == 0 ? "match" : "MISMATCH");
+		printf("tracker : %6.3f [ms/frame] (dirty_rect<16> overhead on partial)\n",
+			(a.time_p - t.time_p) * 1000.0 / opt_.frames);
+	}
+
+
+	template <uint32_t CAPN>
+	void peak_depth_()
+	{
+		typedef graphics::render<uint16_t, LCD_X, LCD_Y, graphics::font8x16, RKFONT> WRENDER;
+		typedef wave_capture<CAPN> CAPTURE;
+		typedef utils::render_wave<WRENDER, CAPTURE, wave_touch> WAVE;
+
+		static CAPTURE cap;
+		RKFONT kf;
+		WRENDER r(fb_, kf);
+		wave_touch touch;
+		WAVE w(r, cap, touch);
+		w.set_zoom(255);  // キャプチャー全体
+		auto zoom = w.get_zoom();
+		uint32_t n = 1 << zoom;
+
+		seed_ = 1;
+		cap.make(0);
+		auto st = std::chrono::steady_clock::now();
+		cap.rebuild();
+		std::chrono::duration<double> db = std::chrono::steady_clock::now() - st;
+
+		static const uint32_t LOOP = 100;
+		static const int16_t COLUMN = 440;
+		uint32_t ng = 0;
+		uint32_t sum = 0;
+		st = std::chrono::steady_clock::now();
+		for(uint32_t l = 0; l < LOOP; ++l) {
+			for(int16_t x = 0; x < COLUMN; ++x) {
+				typename CAPTURE::peak_t p;
+				if(cap.scan_peak(x * n, n, p)) sum += p.max[0] - p.min[1];
+			}
+		}
+		std::chrono::duration<double> d0 = std::chrono::steady_clock::now() - st;
+		st = std::chrono::steady_clock::now();
+		for(uint32_t l = 0; l < LOOP; ++l) {
+			for(int16_t x = 0; x < COLUMN; ++x) {
+				typename CAPTURE::peak_t p;
+				if(cap.get_peak(x * n, n, p)) sum -= p.max[0] - p.min[1];
+			}
+		}
+		std::chrono::duration<double> d1 = std::chrono::steady_clock::now() - st;
+		for(int16_t x = 0; x < COLUMN; ++x) {
+			typename CAPTURE::peak_t p0;
+			typename CAPTURE::peak_t p1;
+			bool f0 = cap.scan_peak(x * n, n, p0);
+			bool f1 = cap.get_peak(x * n, n, p1);
+			if(f0 != f1 || (f0 && std::memcmp(&p0, &p1, sizeof(p0)) != 0)) ++ng;
+		}
+
+		st = std::chrono::steady_clock::now();
+		for(uint32_t l = 0; l < LOOP; ++l) {
+			w.update();
+		}
+		std::chrono::duration<double> dw = std::chrono::steady_clock::now() - st;
+
+		printf("%6u samples (1/%-3u): build %5.1f [ns/sample], scan %7.1f [us], pyramid %5.1f [us], "
+			"update %6.1f [us], %s\n", CAPN, n, db.count() * 1e9 / CAPN,
+			d0.count() * 1e6 / LOOP, d1.count() * 1e6 / LOOP, dw.count() * 1e6 / LOOP,
+			(ng == 0 && sum == 0) ? "match" : "MISMATCH");
+	}
+
+
+	void peak_bench_()
+	{
+		peak_depth_<2048>();
+		peak_depth_<16384>();
+		peak_depth_<131072>();
+	}
+
+
+	template <class MEASURE>
+	uint32_t measure_run_(MEASURE& mes, uint32_t len, uint32_t fft_n, uint32_t budget)
+	{
+		mes.start(0, len, 0, fft_n);
+		uint32_t n = 1;
+		while(!mes.service(budget)) ++n;
+		return n;
+	}
+
+
+	void measure_bench_()
+	{
+		typedef wave_capture<4096> CAPTURE;
+		typedef utils::wave_measure<CAPTURE, 4096> MEASURE;
+		static const uint32_t LOOP = 100;
+		static const uint32_t BUDGET = 4096;
+
+		static CAPTURE cap;
+		static MEASURE mes(cap);
+		seed_ = 1;
+		cap.make(0);
+
+		{  // 振幅、実効値、周期
+			auto st = std::chrono::steady_clock::now();
+			for(uint32_t l = 0; l < LOOP; ++l) {
+				measure_run_(mes, CAPTURE::CAP_NUM, 0, BUDGET);
+			}
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+
+			static const double period[2] = { 2.0 * M_PI / 0.05, 128.0 };
+			uint32_t ng = 0;
+			for(uint8_t ch = 0; ch < 2; ++ch) {
+				uint16_t min = 0xffff;
+				uint16_t max = 0;
+				double sum = 0.0;
+				double sum2 = 0.0;
+				for(uint32_t i = 0; i < CAPTURE::CAP_NUM; ++i) {
+					uint16_t v = ch == 0 ? cap.get(i).ch0_ : cap.get(i).ch1_;
+					if(min > v) min = v;
+					if(max < v) max = v;
+					sum += v;
+					sum2 += static_cast<double>(v) * v;
+				}
+				double mean = sum / CAPTURE::CAP_NUM;
+				double rms = std::sqrt(sum2 / CAPTURE::CAP_NUM - mean * mean);
+				const auto& t = mes.get_stat(ch);
+				double p = t.period / 256.0;
+				if(t.min != min || t.max != max || t.mean != static_cast<uint16_t>(mean)
+					|| std::fabs(t.rms / 16.0 - rms) > (1.0 / 16.0)
+					|| std::fabs(p - period[ch]) > 0.5) {
+					++ng;
+				}
+				printf("stat ch%u : rms %7.2f / %7.2f, period %7.2f / %7.2f [sample] (%u cycles)\n",
+					ch, t.rms / 16.0, rms, p, period[ch], t.cycles);
+			}
+			printf("stat     : %5.1f [ns/sample] (2 channels), %s\n",
+				d.count() * 1e9 / LOOP / CAPTURE::CAP_NUM, ng == 0 ? "match" : "MISMATCH");
+		}
+
+		for(uint32_t n = MEASURE::FFT_MIN; n <= MEASURE::FFT_MAX; n <<= 1) {
+			auto st = std::chrono::steady_clock::now();
+			uint32_t call = 0;
+			for(uint32_t l = 0; l < LOOP; ++l) {
+				call = measure_run_(mes, n, n, BUDGET);
+			}
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+
+			// 同じ入力（直流を除き、ハン窓を掛けて８倍）を倍精度で DFT
+			std::vector<double> x(n);
+			double mean = mes.get_stat(0).mean;
+			for(uint32_t i = 0; i < n; ++i) {
+				double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / n);
+				x[i] = (cap.get(i).ch0_ - mean) * 8.0 * w;
+			}
+			const uint16_t* mag = mes.get_fft();
+			double err = 0.0;
+			double top = 0.0;
+			uint32_t peak = 1;
+			for(uint32_t k = 0; k < n / 2; ++k) {
+				double re = 0.0;
+				double im = 0.0;
+				for(uint32_t i = 0; i < n; ++i) {
+					double a = 2.0 * M_PI * ((static_cast<uint64_t>(i) * k) % n) / n;
+					re += x[i] * std::cos(a);
+					im -= x[i] * std::sin(a);
+				}
+				double m = std::sqrt(re * re + im * im) / n;
+				if(std::fabs(m - mag[k]) > err) err = std::fabs(m - mag[k]);
+				if(k > 0 && m > top) {
+					top = m;
+					peak = k;
+				}
+			}
+			bool ok = mes.get_fft_size() == n && mes.get_fft_peak() == peak && err < 8.0;
+			printf("fft %4u : %6.1f [us], %2u x service(%u), peak bin %3u / %3u, max error %4.1f"
+				" (peak %6.1f), %s\n", n, d.count() * 1e6 / LOOP, call, BUDGET,
+				mes.get_fft_peak(), peak, err, top, ok ? "match" : "MISMATCH");
+		}
+	}
+
+
+	// unicode → リニア・インデックス変換テーブルのソースを出力
+	void uni_()
+	{
+		typedef graphics::legacy_kfont<16, 16, 1> LEGACY;
+		std::vector<uint16_t> tbl(0x10000);
+		uint8_t page[256];
+		uint32_t num = 0;
+		for(uint32_t h = 0; h < 256; ++h) {
+			bool use = false;
+			for(uint32_t l = 0; l < 256; ++l) {
+				uint32_t c = (h << 8) | l;
+				tbl[c] = c == 0 ? 0xffff : LEGACY::sjis_to_liner(ff_convert(c, 0));
+				if(tbl[c] != 0xffff) use = true;
+			}
+			page[h] = use ? num++ : 0xff;
+		}
+
+		printf("//=====================================================================//\n");
+		printf("/*!\t@file\n");
+		printf("\t@brief\tunicode → 漢字フォント・リニア・インデックス変換テーブル @n\n");
+		printf("\t\t\t※graphics_bench -uni で生成（CP932）\n");
+		printf("    @author 平松邦仁 (hira@rvf-rc45.net)\n");
+		printf("\t@copyright\tCopyright (C) 2018 Kunihito Hiramatsu @n\n");
+		printf("\t\t\t\tReleased under the MIT license @n\n");
+		printf("\t\t\t\thttps://github.com/hirakuni45/RX/blob/master/LICENSE\n");
+		printf("*/\n");
+		printf("//=====================================================================//\n");
+		printf("#ifndef KFONT_UNI_TABLE\n");
+		printf("#define KFONT_UNI_TABLE\n");
+		printf("#endif\n");
+		printf("#include \"graphics/kfont.hpp\"\n\n");
+		printf("namespace graphics {\n\n");
+		printf("const uint8_t kfont_uni::page_[256] = {\n");
+		for(uint32_t h = 0; h < 256; ++h) {
+			printf("0x%02X,%s", page[h], (h & 15) == 15 ? "\n" : "");
+		}
+		printf("};\n\n");
+		printf("const uint16_t kfont_uni::liner_[][256] = {\n");
+		for(uint32_t h = 0; h < 256; ++h) {
+			if(page[h] == 0xff) continue;
+			printf("{ // U+%02X00\n", h);
+			for(uint32_t l = 0; l < 256; ++l) {
+				printf("0x%04X,%s", tbl[(h << 8) | l], (l & 15) == 15 ? "\n" : "");
+			}
+			printf("},\n");
+		}
+		printf("};\n\n");
+		printf("}\n");
+	}
+
+
+	// トリガーの試験波形
+	struct trigger_wave_t {
+		const char*			name;
+		utils::trigger_type	type;
+		uint16_t			level;
+		uint16_t			hyst;
+		uint16_t			level2;
+		uint32_t			width;
+		uint32_t			width2;
+		uint32_t			period;	///< トリガーが掛かるべき位置の周期
+		uint32_t			phase;	///< トリガーが掛かるべき位置
+		uint32_t			tol;	///< 許容するずれ
+	};
+
+
+	// 周期 200 の台形波（傾き 50 / サンプル、ノイズ ±60）、2000 サンプル毎に
+	// 窓の外へのスパイク、又は、幅 5, 10, 20, 40 サンプルの正パルスの繰り返し
+	uint16_t trigger_sample_(uint32_t i, bool pulse)
+	{
+		int32_t v;
+		if(pulse) {
+			static const uint32_t width[4] = { 5, 10, 20, 40 };
+			uint32_t n = i / 100;
+			v = (i % 100) < width[n & 3] ? 3000 : 1000;
+		} else {
+			uint32_t p = i % 200;
+			if(p < 40) v = 3000 - p * 50;
+			else if(p < 100) v = 1000;
+			else if(p < 140) v = 1000 + (p - 100) * 50;
+			else v = 3000;
+			if((i % 2000) == 1170) v = 3900;
+		}
+		return v + static_cast<int32_t>(rand_() % 121) - 60;
+	}
+
+
+	void trigger_bench_()
+	{
+		static const uint32_t NUM = 200000;
+		static const trigger_wave_t wave[] = {
+			{ "rise   ", utils::trigger_type::RISE,    2000, 200,    0, 0, 0xffffffff,  200,  120, 3 },
+			{ "fall   ", utils::trigger_type::FALL,    2000, 200,    0, 0, 0xffffffff,  200,   20, 3 },
+			{ "window ", utils::trigger_type::WINDOW,   800, 100, 3500, 0, 0xffffffff, 2000, 1170, 0 },
+			{ "pulse+ ", utils::trigger_type::PULSE_P, 2000, 200,    0, 8, 12,          400,  110, 0 },
+		};
+		std::vector<uint16_t> in(NUM);
+
+		uint32_t ng = 0;
+		for(const auto& t : wave) {
+			seed_ = 1;
+			bool pulse = t.type == utils::trigger_type::PULSE_P;
+			for(uint32_t i = 0; i < NUM; ++i) in[i] = trigger_sample_(i, pulse);
+
+			// トリガーは、掛かるべき位置毎に一回、許容範囲の中
+			utils::trigger_eval eval;
+			eval.set(t.type, t.level, t.hyst, t.level2, t.width, t.width2);
+			uint32_t hit = 0;
+			uint32_t miss = 0;
+			for(uint32_t i = 0; i < NUM; ++i) {
+				if(!eval(in[i])) continue;
+				++hit;
+				uint32_t ofs = (i + t.period - t.phase) % t.period;
+				if(ofs > t.tol && (t.period - ofs) > t.tol) ++miss;
+			}
+			uint32_t expect = (NUM - t.phase + t.period - 1) / t.period;
+			if(hit != expect) ++miss;
+
+			// ヒステリシスが無い場合（ノイズで余分にトリガーする）
+			eval.set(t.type, t.level, 0, t.level2, t.width, t.width2);
+			uint32_t hit0 = 0;
+			for(uint32_t i = 0; i < NUM; ++i) {
+				if(eval(in[i])) ++hit0;
+			}
+
+			eval.set(t.type, t.level, t.hyst, t.level2, t.width, t.width2);
+			static const uint32_t LOOP = 20;
+			uint32_t sum = 0;
+			auto st = std::chrono::steady_clock::now();
+			for(uint32_t l = 0; l < LOOP; ++l) {
+				eval.reset();
+				for(uint32_t i = 0; i < NUM; ++i) sum += eval(in[i]);
+			}
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+			if(miss > 0 || sum != hit * LOOP) ++ng;
+			printf("%s: %5u / %5u triggers (%5u without hysteresis), %5.2f [ns/sample], %s\n",
+				t.name, hit, expect, hit0, d.count() * 1e9 / LOOP / NUM, miss == 0 ? "match" : "MISMATCH");
+		}
+
+		// プリ・トリガー付きで取り込み、並べ替えた波形を調べる
+		{
+			static const uint32_t CAPN = 2048;
+			typedef utils::trigger_engine<CAPN> ENGINE;
+			static utils::capture_data data[CAPN];
+			ENGINE eng;
+			eng.at_eval().set(utils::trigger_type::RISE, 2000, 200);
+			eng.set_channel(0);
+
+			uint32_t ok = 0;
+			uint32_t cap = 0;
+			uint32_t forced = 0;
+			uint32_t i = 0;
+			seed_ = 1;
+			static const uint32_t pres[] = { 0, 1, 512, 1024, 2047 };
+			static const utils::capture_trigger modes[] = {
+				utils::capture_trigger::SINGLE, utils::capture_trigger::NORMAL, utils::capture_trigger::AUTO };
+			auto st = std::chrono::steady_clock::now();
+			uint32_t stored = 0;
+			for(auto mode : modes) {
+				for(uint32_t pre : pres) {
+					eng.set_pre(pre);
+					eng.set_auto(1000);
+					eng.start(mode);
+					// AUTO は、トリガーの無い直流を与える
+					bool flat = mode == utils::capture_trigger::AUTO;
+					while(eng.is_store()) {
+						auto& d = data[eng.get_pos()];
+						d.ch0_ = flat ? 1500 : trigger_sample_(i, false);
+						d.ch1_ = i;
+						eng.update(d.ch0_);
+						++i;
+						++stored;
+					}
+					++cap;
+					std::rotate(data, data + eng.get_start(), data + CAPN);
+					if(eng.is_forced()) ++forced;
+					// 連続していて、プリ・トリガー数の位置がトリガー
+					bool f = true;
+					for(uint32_t j = 1; j < CAPN; ++j) {
+						if(static_cast<uint16_t>(data[j].ch1_ - data[j - 1].ch1_) != 1) f = false;
+					}
+					uint32_t trg = static_cast<uint16_t>(i - (CAPN - pre));
+					if(data[pre].ch1_ != trg) f = false;
+					uint32_t ofs = (data[pre].ch1_ + 200 - 120) % 200;  // 立ち上がりの位置
+					if(!flat && ofs > 3 && ofs < 197) f = false;
+					if(f) ++ok;
+				}
+			}
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+			if(ok != cap || forced != 5) ++ng;
+			printf("engine : %u/%u captures (pre 0 to %u, single/normal/auto, %u forced), "
+				"%5.2f [ns/sample], %s\n", ok, cap, CAPN - 1, forced,
+				d.count() * 1e9 / stored, ok == cap ? "match" : "MISMATCH");
+		}
+		printf("trigger: %s\n", ng == 0 ? "match" : "MISMATCH");
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("graphics benchmark Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options]\n", cmd);
+		printf("    -kfont       kanji font render benchmark (default)\n");
+		printf("    -render      render fill, text, bitmap and blit benchmark\n");
+		printf("    -wave        RTK5_DSOS wave screen, full and partial redraw\n");
+		printf("    -peak        RTK5_DSOS min/max pyramid against full scan\n");
+		printf("    -measure     RTK5_DSOS measure and FFT against double precision\n");
+		printf("    -trigger     RTK5_DSOS trigger types and pre-trigger ring\n");
+		printf("    -uni         output unicode table source (kfont_uni.cpp)\n");
+		printf("    -font FILE   kanji font file (default: %s)\n", opt_.font.c_str());
+		printf("    -frames N    render frames (default: %u)\n", opt_.frames);
+	}
+}
+
+
+extern "C" {
+
+	int fatfs_get_mount() { return 1; }
+
+	FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode)
+	{
+		++count_.open;
+		FILE* f = fopen(opt_.font.c_str(), "rb");
+		if(f == nullptr) return FR_NO_FILE;
+		host_fp_[fp] = f;
+		return FR_OK;
+	}
+
+	FRESULT f_close(FIL* fp)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		fclose(it->second);
+		host_fp_.erase(it);
+		return FR_OK;
+	}
+
+	FRESULT f_lseek(FIL* fp, FSIZE_t ofs)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		fseek(it->second, ofs, SEEK_SET);
+		return FR_OK;
+	}
+
+	FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		long pos = ftell(it->second);
+		*br = fread(buff, 1, btr, it->second);
+		++count_.read;
+		count_.byte += *br;
+		if(*br > 0) {
+			count_.sector += (pos + *br - 1) / 512 - pos / 512 + 1;
+		}
+		return FR_OK;
+	}
+};
+
+
+int main(int argc, char* argv[])
+{
+	enum class MODE {
+		KFONT,
+		RENDER,
+		WAVE,
+		PEAK,
+		MEASURE,
+		TRIGGER,
+		UNI
+	};
+	MODE mode = MODE::KFONT;
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-kfont") mode = MODE::KFONT;
+		else if(s == "-render") mode = MODE::RENDER;
+		else if(s == "-wave") mode = MODE::WAVE;
+		else if(s == "-peak") mode = MODE::PEAK;
+		else if(s == "-measure") mode = MODE::MEASURE;
+		else if(s == "-trigger") mode = MODE::TRIGGER;
+		else if(s == "-uni") mode = MODE::UNI;
+		else if(s == "-font" && (i + 1) < argc) opt_.font = argv[++i];
+		else if(s == "-frames" && (i + 1) < argc) opt_.frames = std::atoi(argv[++i]);
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+
+	switch(mode) {
+	case MODE::KFONT:
+		kfont_();
+		break;
+	case MODE::RENDER:
+		render_bench_();
+		break;
+	case MODE::WAVE:
+		wave_bench_();
+		break;
+	case MODE::PEAK:
+		peak_bench_();
+		break;
+	case MODE::MEASURE:
+		measure_bench_();
+		break;
+	case MODE::TRIGGER:
+		trigger_bench_();
+		break;
+	case MODE::UNI:
+		uni_();
+		break;
+	}
+	return 0;
+}
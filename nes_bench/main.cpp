@@ -0,0 +1,1231 @@
+//=====================================================================//
+/*!	@file
+	@brief	NES エミュレーター・ベンチマーク（ホスト用）@n
+			「-bank」バンク・キャッシュ（emu/nes/nes_bank.c）に、マッパーの @n
+			バンク切り替えのトレースを再生し、ヒット率、SD カードの読み込みで @n
+			止まる時間（仮想時間）を、キャッシュの大きさ、先読みの有無毎に表示する。@n
+			トレースは、MMC1（SUROM 512K）、MMC3（TKROM 256K + 256K）の典型的な @n
+			使い方を合成したもの、又は、NES_BANK_TRACE を有効にして記録したファイル。@n
+			割り当てた窓の内容は、ROM イメージと毎回比較する。@n
+			「-emu」エミュレーター・コア（RTK5_NESEMU/emu）を、ホストで全速力で動かし、@n
+			サブシステム（CPU、PPU、マッパー、APU）毎の処理時間と、フレーム／秒を表示する。@n
+			ROM は指定したファイル（複数可）、又は、合成した NROM ２種（CPU、PPU、APU を動かす）と、@n
+			$6000 に PRG を置くマッパー 40。PRG の窓は ROM イメージと比較する。@n
+			nesemu::service のペース調整（描画を省く）を、仮想時間で評価する。@n
+			「-rewind」巻き戻し（emu/nes/nes_rewind.c）のスナップショットの大きさ、@n
+			取る時間、戻す時間と、戻してから同じ画面になるかを表示する（ROM は「-emu」と同じ）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "nes_bank.h"
+#include "nes_rewind.h"
+#include "nesemu.hpp"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	struct option_t {
+		uint32_t	frames = 0;			///< フレーム数（0: -bank 36000（１０分）、-emu 3600）
+		std::string	trace;				///< 再生するトレース・ファイル
+		std::string	save;				///< 合成したトレース（ROM）を保存する
+		std::vector<std::string> rom;	///< -emu で動かす ROM（複数可）
+		double		draw_ms = 0.0;		///< ターゲットで描画するフレームの時間（0: 複数）
+		uint32_t	pool = 0;			///< 巻き戻しのリング（Ｋバイト、0: NES_REWIND_POOL）
+		uint32_t	interval = 0;		///< スナップショットの間隔（0: NES_REWIND_INTERVAL）
+	};
+	option_t	opt_;
+
+	uint32_t	seed_;
+	uint32_t rand_() {
+		seed_ = seed_ * 1103515245 + 12345;
+		return (seed_ >> 16) & 0x7fff;
+	}
+
+	// SD カードのアクセス時間（sound_bench と同じモデル）
+	struct sd_cost_t {
+		uint32_t	seek_us = 1000;		///< f_lseek（クラスタ・チェインを辿る）
+		uint32_t	read_us = 300;		///< f_read の１回毎
+		uint32_t	byte_ns = 250;		///< 転送（４Ｍバイト／秒）
+	};
+	sd_cost_t	sd_cost_;
+
+	static const long ROM_HEAD = 16;	///< iNES ヘッダー
+
+	struct op_t {
+		char	cmd;	///< R: ROM, P: PRG, C: CHR, H: ヒント, S: フレーム（先読み）
+		int		a;
+		int		b;
+		int		c;
+	};
+
+	struct trace_t {
+		std::string			name;
+		int					prg_banks = 0;	///< ８Ｋバイト単位
+		int					chr_banks = 0;	///< １Ｋバイト単位
+		std::vector<op_t>	ops;
+	};
+
+
+	//=================================================================//
+	/*!
+		@brief  マッパーの操作を、nes_mmc.c、map001.c、map004.c と同じ様に @n
+				バンク・キャッシュの操作（トレース）にする
+	*/
+	//=================================================================//
+	struct gen_t {
+		trace_t&	t;
+
+		gen_t(trace_t& tr) : t(tr) { }
+
+		void prg8(int window, int bank) { t.ops.push_back({ 'P', window, bank % t.prg_banks, 0 }); }
+
+		void prg16(int window, int bank)
+		{
+			prg8(window + 0, bank * 2 + 0);
+			prg8(window + 1, bank * 2 + 1);
+		}
+
+		void chr(int page, int num, int bank)
+		{
+			for(int i = 0; i < num; ++i) {
+				t.ops.push_back({ 'C', page + i, (bank + i) % t.chr_banks, 0 });
+			}
+		}
+
+		void hint(int type, int bank, int num) { t.ops.push_back({ 'H', type, bank, num }); }
+
+		void frame() { t.ops.push_back({ 'S', 1, 0, 0 }); }
+
+		// MMC1 レジスター３（$8000 の 16K）
+		void mmc1_prg(int bank)
+		{
+			prg16(0, bank);
+			hint(BANK_PRG, (bank + 1) * 2, 2);
+		}
+
+		// MMC3 R0 〜 R7
+		void mmc3(int reg, int value)
+		{
+			if(reg < 2) {
+				hint(BANK_CHR, ((value >> 1) + 1) * 2, 2);
+				chr(reg * 2, 2, value & 0xfe);
+			} else if(reg < 6) {
+				hint(BANK_CHR, value + 1, 1);
+				chr(reg + 2, 1, value);
+			} else {
+				hint(BANK_PRG, value + 1, 1);
+				prg8(reg - 6, value);
+			}
+		}
+	};
+
+
+	// ステージの切り替え（大抵は次のステージ、時々戻る）
+	int next_area_(int area, int num)
+	{
+		if(area > 0 && (rand_() % 5) == 0) {
+			return rand_() % area;
+		}
+		return (area + 1) % num;
+	}
+
+
+	// MMC1 SUROM（PRG 512K、CHR-RAM）: $C000 は固定、$8000 を、エンジン、ステージ、@n
+	// 音楽（NMI）で切り替える
+	void make_mmc1_(trace_t& t, uint32_t frames)
+	{
+		t.name = "MMC1 SUROM 512K";
+		t.prg_banks = 64;
+		t.chr_banks = 0;
+		t.ops.clear();
+		gen_t g(t);
+		seed_ = 1;
+
+		g.prg16(2, 31);
+		int area = 0;
+		uint32_t area_end = 300 + rand_() % 600;
+		for(uint32_t f = 0; f < frames; ++f) {
+			if(f >= area_end) {
+				area = next_area_(area, 27);
+				area_end = f + 300 + rand_() % 600;
+			}
+			g.mmc1_prg(2);
+			g.mmc1_prg(3 + area);
+			if((f & 3) == 0) {
+				g.mmc1_prg(2);	// イベント処理
+			}
+			g.mmc1_prg(1);		// NMI: 音楽
+			g.mmc1_prg(3 + area);
+			g.frame();
+		}
+	}
+
+
+	// MMC3 TKROM（PRG 256K、CHR 256K）: R6/R7 でエンジン、ステージのデータ、音楽、@n
+	// CHR は、背景（2K x 2）、敵（1K x 3）、アニメーション（1K、８フレーム毎）、@n
+	// ステータス・バー（IRQ で背景を切り替え）
+	void make_mmc3_(trace_t& t, uint32_t frames)
+	{
+		t.name = "MMC3 TKROM 256K+256K";
+		t.prg_banks = 32;
+		t.chr_banks = 256;
+		t.ops.clear();
+		gen_t g(t);
+		seed_ = 2;
+
+		g.prg8(2, 30);
+		g.prg8(3, 31);
+		int area = 0;
+		int enemy[3] = { 128, 129, 130 };
+		uint32_t area_end = 600 + rand_() % 600;
+		for(uint32_t f = 0; f < frames; ++f) {
+			if(f >= area_end) {
+				area = next_area_(area, 24);
+				area_end = f + 600 + rand_() % 600;
+				for(int i = 0; i < 3; ++i) enemy[i] = 128 + rand_() % 96;
+			}
+			int bg = 8 + area * 4;
+			// フレームの先頭（NMI で背景を戻す）
+			g.mmc3(6, 2 + (area & 1));	// 音楽
+			g.mmc3(6, 0);
+			g.mmc3(0, bg);
+			g.mmc3(1, bg + 2);
+			g.mmc3(2, enemy[0]);
+			g.mmc3(3, enemy[1]);
+			g.mmc3(4, enemy[2]);
+			g.mmc3(5, 224 + (area & 7) * 4 + ((f >> 3) & 3));
+			// ゲーム処理
+			g.mmc3(7, 6 + area);
+			if((f & 1) == 0) {
+				g.mmc3(6, 1);
+				g.mmc3(6, 0);
+			}
+			// ステータス・バー（IRQ）
+			g.mmc3(0, 0);
+			g.mmc3(1, 2);
+			g.frame();
+		}
+	}
+
+
+	bool save_trace_(const trace_t& t, const std::string& path)
+	{
+		FILE* fp = fopen(path.c_str(), "wb");
+		if(fp == nullptr) return false;
+		fprintf(fp, "R %d %d\n", t.prg_banks, t.chr_banks);
+		for(const auto& op : t.ops) {
+			if(op.cmd == 'H') fprintf(fp, "H %d %d %d\n", op.a, op.b, op.c);
+			else if(op.cmd == 'S') fprintf(fp, "S %d\n", op.a);
+			else fprintf(fp, "%c %d %d\n", op.cmd, op.a, op.b);
+		}
+		fclose(fp);
+		return true;
+	}
+
+
+	bool load_trace_(trace_t& t, const std::string& path)
+	{
+		FILE* fp = fopen(path.c_str(), "rb");
+		if(fp == nullptr) return false;
+		t.name = path;
+		t.ops.clear();
+		char line[128];
+		while(fgets(line, sizeof(line), fp) != nullptr) {
+			op_t op = { 0, 0, 0, 0 };
+			int n = sscanf(line, "%c %d %d %d", &op.cmd, &op.a, &op.b, &op.c);
+			if(n < 2) continue;
+			if(op.cmd == 'R') {
+				t.prg_banks = op.a;
+				t.chr_banks = op.b;
+			} else {
+				t.ops.push_back(op);
+			}
+		}
+		fclose(fp);
+		return t.prg_banks > 0;
+	}
+
+
+	// ROM イメージ（ファイル位置で決まる値）
+	uint8_t rom_byte_(uint32_t ofs)
+	{
+		uint32_t v = ofs * 2654435761u;
+		return static_cast<uint8_t>((v >> 24) ^ (ofs >> 10));
+	}
+
+
+	bool make_rom_(const trace_t& t, const std::string& path, std::vector<uint8_t>& image)
+	{
+		uint32_t len = ROM_HEAD + t.prg_banks * BANK_PRG_SIZE + t.chr_banks * BANK_CHR_SIZE;
+		image.resize(len);
+		for(uint32_t i = 0; i < len; ++i) {
+			image[i] = rom_byte_(i);
+		}
+		std::memset(&image[0], 0, ROM_HEAD);
+		std::memcpy(&image[0], "NES\x1A", 4);
+		image[4] = t.prg_banks / 2;
+		image[5] = t.chr_banks / 8;
+		image[6] = (t.chr_banks == 0 ? 1 : 4) << 4;
+		FILE* fp = fopen(path.c_str(), "wb");
+		if(fp == nullptr) return false;
+		bool ret = fwrite(&image[0], 1, len, fp) == len;
+		fclose(fp);
+		return ret;
+	}
+
+
+	uint64_t cost_us_(const bankstat_t& a, const bankstat_t& b)
+	{
+		uint64_t us = static_cast<uint64_t>(b.stall_seeks - a.stall_seeks) * sd_cost_.seek_us;
+		us += static_cast<uint64_t>(b.stall_reads - a.stall_reads) * sd_cost_.read_us;
+		us += static_cast<uint64_t>(b.stall_bytes - a.stall_bytes) * sd_cost_.byte_ns / 1000;
+		return us;
+	}
+
+
+	struct result_t {
+		uint32_t	frames = 0;
+		uint32_t	switches = 0;
+		bankstat_t	st;
+		uint32_t	memory = 0;
+		uint64_t	boot_us = 0;	///< 最初のフレーム（空のキャッシュ）
+		uint64_t	stall_us = 0;
+		uint64_t	worst_us = 0;
+		uint32_t	slow = 0;		///< 止まる時間が２ｍｓを超えたフレーム
+		uint64_t	idle_us = 0;	///< 先読み（フレームの空き時間）
+		double		ns = 0.0;		///< 切り替え１回の処理時間（ホスト）
+		bool		ok = true;
+	};
+
+
+	result_t replay_(const trace_t& t, const std::string& path, const std::vector<uint8_t>& image,
+		uint32_t prg, uint32_t chr, bool prefetch, bool verify)
+	{
+		result_t r;
+		bank_setbudget(prg, chr);
+		FILE* fp = fopen(path.c_str(), "rb");
+		if(fp == nullptr || bank_create(fp, ROM_HEAD, t.prg_banks,
+			ROM_HEAD + t.prg_banks * BANK_PRG_SIZE, t.chr_banks) != 0) {
+			r.ok = false;
+			return r;
+		}
+		r.memory = bank_getmemory();
+		bank_clearstat();
+
+		const uint8_t* win[BANK_PRG_WINDOWS + BANK_CHR_WINDOWS] = { nullptr };
+		long org[BANK_PRG_WINDOWS + BANK_CHR_WINDOWS] = { 0 };
+		uint32_t len[BANK_PRG_WINDOWS + BANK_CHR_WINDOWS] = { 0 };
+		bankstat_t frame_st = *bank_getstat();
+		auto t0 = std::chrono::high_resolution_clock::now();
+		for(const auto& op : t.ops) {
+			int w = -1;
+			switch(op.cmd) {
+			case 'P':
+				w = op.a;
+				win[w] = bank_getprg(op.a, op.b);
+				org[w] = ROM_HEAD + static_cast<long>(op.b) * BANK_PRG_SIZE;
+				len[w] = BANK_PRG_SIZE;
+				++r.switches;
+				break;
+			case 'C':
+				w = BANK_PRG_WINDOWS + op.a;
+				win[w] = bank_getchr(op.a, op.b);
+				org[w] = ROM_HEAD + t.prg_banks * BANK_PRG_SIZE + static_cast<long>(op.b) * BANK_CHR_SIZE;
+				len[w] = BANK_CHR_SIZE;
+				++r.switches;
+				break;
+			case 'H':
+				if(prefetch) bank_hint(static_cast<banktype_t>(op.a), op.b, op.c);
+				break;
+			case 'S':
+				{
+					bankstat_t st = *bank_getstat();
+					uint64_t us = cost_us_(frame_st, st);
+					if(r.frames == 0) {
+						r.boot_us = us;
+					} else {
+						r.stall_us += us;
+						if(us > r.worst_us) r.worst_us = us;
+						if(us > 2000) ++r.slow;
+					}
+					++r.frames;
+					if(prefetch) {
+						bankstat_t a = *bank_getstat();
+						bank_service(op.a);
+						bankstat_t b = *bank_getstat();
+						r.idle_us += static_cast<uint64_t>(b.seeks - a.seeks) * sd_cost_.seek_us;
+						r.idle_us += static_cast<uint64_t>(b.reads - a.reads) * sd_cost_.read_us;
+						r.idle_us += static_cast<uint64_t>(b.bytes - a.bytes) * sd_cost_.byte_ns / 1000;
+					}
+					frame_st = *bank_getstat();
+					// 先読みで、割り当て中の窓が壊れていないか
+					if(verify) {
+						for(uint32_t i = 0; i < (BANK_PRG_WINDOWS + BANK_CHR_WINDOWS); ++i) {
+							if(win[i] == nullptr) continue;
+							if(std::memcmp(win[i], &image[org[i]], len[i]) != 0) r.ok = false;
+						}
+					}
+				}
+				break;
+			default:
+				break;
+			}
+			if(verify && w >= 0) {
+				// 切り替えた窓と、他の窓（追い出されていないか）
+				if(std::memcmp(win[w], &image[org[w]], len[w]) != 0) r.ok = false;
+				for(uint32_t i = 0; i < (BANK_PRG_WINDOWS + BANK_CHR_WINDOWS); ++i) {
+					if(win[i] == nullptr) continue;
+					if(win[i][0] != image[org[i]] || win[i][len[i] - 1] != image[org[i] + len[i] - 1]) {
+						r.ok = false;
+					}
+				}
+			}
+		}
+		auto t1 = std::chrono::high_resolution_clock::now();
+		if(r.switches > 0) {
+			r.ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / r.switches;
+		}
+		r.st = *bank_getstat();
+		bank_destroy();
+		return r;
+	}
+
+
+	void bank_trace_(const trace_t& t, const std::string& dir)
+	{
+		std::string path = dir + "/rom.nes";
+		std::vector<uint8_t> image;
+		if(!make_rom_(t, path, image)) {
+			printf("Can't write ROM image: '%s'\n", path.c_str());
+			return;
+		}
+		uint32_t prg_all = t.prg_banks * BANK_PRG_SIZE;
+		uint32_t chr_all = t.chr_banks * BANK_CHR_SIZE;
+		uint32_t frames = 0;
+		for(const auto& op : t.ops) {
+			if(op.cmd == 'S') ++frames;
+		}
+		printf("%s: PRG %uK, CHR %uK, %u frames\n", t.name.c_str(), prg_all / 1024, chr_all / 1024, frames);
+		printf("  legacy rom_load: resident %uK (peak %uK while loading)\n",
+			(prg_all + chr_all) / 1024, (prg_all + chr_all) * 2 / 1024 + 16);
+		printf("  budget PRG/CHR    RAM  prefetch   hit%%   miss    pre/used  boot ms  stall ms  worst ms  >2ms  idle ms  ns/switch\n");
+
+		struct budget_t { uint32_t prg; uint32_t chr; };
+		static const budget_t budget[] = {
+			{  40 * 1024, 16 * 1024 },
+			{  64 * 1024, 24 * 1024 },
+			{  96 * 1024, 32 * 1024 },
+			{ 128 * 1024, 48 * 1024 },
+			{ 0, 0 },	// 全て
+		};
+		bool ok = true;
+		for(const auto& b : budget) {
+			uint32_t prg = b.prg != 0 ? b.prg : prg_all;
+			uint32_t chr = b.prg != 0 ? b.chr : chr_all;
+			if(t.chr_banks == 0) chr = 0;
+			for(uint32_t k = 0; k < 2; ++k) {
+				bool pre = k != 0;
+				auto r = replay_(t, path, image, prg, chr, pre, true);
+				auto s = replay_(t, path, image, prg, chr, pre, false);
+				if(!r.ok) ok = false;
+				uint32_t n = r.st.hits + r.st.misses;
+				printf("  %4uK/%3uK  %5uK   %-4s %8.3f %6u %6u/%-6u %7.1f %9.1f %9.2f %5u %8.1f %9.1f\n",
+					prg / 1024, chr / 1024, r.memory / 1024, pre ? "on" : "off",
+					n > 0 ? r.st.hits * 100.0 / n : 100.0, r.st.misses,
+					r.st.prefetches, r.st.prefetch_hits, r.boot_us / 1000.0,
+					r.stall_us / 1000.0, r.worst_us / 1000.0, r.slow, r.idle_us / 1000.0, s.ns);
+			}
+		}
+		printf("  windows: %s\n\n", ok ? "match (ROM image)" : "MISMATCH");
+		remove(path.c_str());
+	}
+
+
+	void bank_bench_()
+	{
+		char tmp[] = "/tmp/nes_bench_XXXXXX";
+		if(mkdtemp(tmp) == nullptr) {
+			printf("Can't make directory\n");
+			return;
+		}
+		std::string dir = tmp;
+		printf("bank cache: read %u us/call, seek %u us, %u ns/byte (virtual time)\n\n",
+			sd_cost_.read_us, sd_cost_.seek_us, sd_cost_.byte_ns);
+
+		if(!opt_.trace.empty()) {
+			trace_t t;
+			if(!load_trace_(t, opt_.trace)) {
+				printf("Can't load trace: '%s'\n", opt_.trace.c_str());
+			} else {
+				bank_trace_(t, dir);
+			}
+		} else {
+			trace_t t[2];
+			uint32_t frames = opt_.frames != 0 ? opt_.frames : 36000;
+			make_mmc1_(t[0], frames);
+			make_mmc3_(t[1], frames);
+			for(uint32_t i = 0; i < 2; ++i) {
+				if(!opt_.save.empty()) {
+					std::string path = opt_.save + (i == 0 ? "_mmc1.txt" : "_mmc3.txt");
+					if(!save_trace_(t[i], path)) {
+						printf("Can't save trace: '%s'\n", path.c_str());
+					}
+				}
+				bank_trace_(t[i], dir);
+			}
+		}
+		rmdir(dir.c_str());
+	}
+
+
+	//=================================================================//
+	/*!
+		@brief  6502 の簡易アセンブラ（合成 ROM 用、後方分岐のみ）
+	*/
+	//=================================================================//
+	struct asm_t {
+		std::vector<uint8_t>&	prg;
+		uint16_t				org;
+		uint32_t				pos;
+
+		asm_t(std::vector<uint8_t>& p, uint16_t o) : prg(p), org(o), pos(0) { }
+
+		uint16_t pc() const { return org + pos; }
+		void b(uint8_t v) { prg[pos++] = v; }
+		void op(uint8_t c) { b(c); }
+		void imm(uint8_t c, uint8_t v) { b(c); b(v); }
+		void zp(uint8_t c, uint8_t a) { b(c); b(a); }
+		void abs(uint8_t c, uint16_t a) { b(c); b(a & 0xff); b(a >> 8); }
+		void br(uint8_t c, uint16_t target) { b(c); b(static_cast<uint8_t>(target - (pc() + 1))); }
+		void sta(uint16_t a, uint8_t v) { imm(0xA9, v); abs(0x8D, a); }	// LDA #v, STA a
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  NROM を合成 @n
+				BG（横スクロール）、スプライト６４個（OAM DMA）、@n
+				矩形波２、三角波、ノイズを毎フレーム更新し、残りの時間は @n
+				LFSR でメモリーを埋める（CPU）。@n
+				chr_ram の場合、PRG 32K、CHR RAM（PRG から転送）、8x16 スプライト、@n
+				毎フレーム１タイルを書き換える（タイル・キャッシュの無効化）。@n
+				map40 の場合、マッパー 40（PRG 64K、$6000 にバンク６）にして、@n
+				NMI で $6000 からスプライトのタイルを読み、$C000 のバンクを選び直す。
+		@param[in]	path	書き出すファイル
+		@param[in]	chr_ram	CHR RAM の場合「true」
+		@param[in]	map40	マッパー 40 の場合「true」
+		@return 成功なら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool make_nrom_(const std::string& path, bool chr_ram, bool map40 = false)
+	{
+		uint32_t prg_size = map40 ? 0x10000 : (chr_ram ? 0x8000 : 0x4000);
+		std::vector<uint8_t> prg(prg_size, 0xEA);
+		if(map40) {
+			// バンク０〜５（最後の１６Ｋがコード）
+			for(uint32_t i = 0; i < (prg_size - 0x4000); ++i) {
+				prg[i] = ((i >> 13) * 0x11) ^ (i & 0xff);
+			}
+		}
+		std::vector<uint8_t> code(0x4000, 0xEA);
+		asm_t a(code, 0xC000);
+		static const uint16_t pal = 0xC800;
+
+		std::vector<uint8_t> chr(0x2000);
+		for(uint32_t i = 0; i < chr.size(); ++i) {
+			uint32_t t = i >> 4;
+			chr[i] = ((t * 0x9E) ^ ((i & 15) * 0x35) ^ (t >> 3)) & 0xff;
+		}
+		uint8_t ctrl0 = chr_ram ? 0xA0 : 0x80;	// NMI（、8x16 スプライト）
+
+		// reset
+		uint16_t reset = a.pc();
+		a.op(0x78);				// SEI
+		a.op(0xD8);				// CLD
+		a.imm(0xA2, 0xFF);		// LDX #$FF
+		a.op(0x9A);				// TXS
+		a.sta(0x2000, 0x00);
+		a.sta(0x2001, 0x00);
+		for(int i = 0; i < 2; ++i) {
+			uint16_t l = a.pc();
+			a.abs(0x2C, 0x2002);	// BIT $2002
+			a.br(0x10, l);			// BPL
+		}
+		// CHR RAM（$8000 〜 $9FFF から転送）
+		if(chr_ram) {
+			a.sta(0x2006, 0x00);
+			a.sta(0x2006, 0x00);
+			a.imm(0xA9, 0x00); a.zp(0x85, 0x00);
+			a.imm(0xA9, 0x80); a.zp(0x85, 0x01);
+			a.imm(0xA0, 0x00);		// LDY #0
+			uint16_t l = a.pc();
+			a.zp(0xB1, 0x00);		// LDA ($00),Y
+			a.abs(0x8D, 0x2007);	// STA $2007
+			a.op(0xC8);				// INY
+			a.br(0xD0, l);			// BNE
+			a.zp(0xE6, 0x01);		// INC $01
+			a.zp(0xA5, 0x01);		// LDA $01
+			a.imm(0xC9, 0xA0);		// CMP #$A0
+			a.br(0xD0, l);			// BNE
+		}
+		// パレット
+		a.sta(0x2006, 0x3F);
+		a.sta(0x2006, 0x00);
+		a.imm(0xA2, 0x00);		// LDX #0
+		{
+			uint16_t l = a.pc();
+			a.abs(0xBD, pal);		// LDA pal,X
+			a.abs(0x8D, 0x2007);	// STA $2007
+			a.op(0xE8);				// INX
+			a.imm(0xE0, 0x20);		// CPX #32
+			a.br(0xD0, l);			// BNE
+		}
+		// ネームテーブル（$2000 〜 $27FF）
+		a.sta(0x2006, 0x20);
+		a.sta(0x2006, 0x00);
+		a.imm(0xA0, 0x08);		// LDY #8
+		a.imm(0xA2, 0x00);		// LDX #0
+		{
+			uint16_t l = a.pc();
+			a.op(0x8A);				// TXA
+			a.abs(0x8D, 0x2007);	// STA $2007
+			a.op(0xE8);				// INX
+			a.br(0xD0, l);			// BNE
+			a.op(0x88);				// DEY
+			a.br(0xD0, l);			// BNE
+		}
+		// OAM（$0200）
+		{
+			uint16_t l = a.pc();
+			a.op(0x8A);				// TXA
+			a.abs(0x9D, 0x0200);	// STA $0200,X
+			a.op(0xE8);				// INX
+			a.br(0xD0, l);			// BNE
+		}
+		// APU
+		a.sta(0x4015, 0x0F);
+		a.sta(0x4000, 0xBF); a.sta(0x4002, 0x40); a.sta(0x4003, 0x08);
+		a.sta(0x4004, 0x9F); a.sta(0x4006, 0x80); a.sta(0x4007, 0x08);
+		a.sta(0x4008, 0xFF); a.sta(0x400A, 0x60); a.sta(0x400B, 0x08);
+		a.sta(0x400C, 0x3F); a.sta(0x400E, 0x05); a.sta(0x400F, 0x08);
+		a.imm(0xA9, 0x01); a.zp(0x85, 0x10);	// seed
+		a.sta(0x2000, ctrl0);
+		a.sta(0x2001, 0x1E);	// BG, スプライト
+		// メイン・ループ（LFSR）
+		uint16_t main = a.pc();
+		a.imm(0xA0, 0x00);		// LDY #0
+		{
+			uint16_t l = a.pc();
+			a.zp(0xA5, 0x10);		// LDA $10
+			a.op(0x0A);				// ASL A
+			a.imm(0x90, 0x02);		// BCC +2
+			a.imm(0x49, 0x1D);		// EOR #$1D
+			a.zp(0x85, 0x10);		// STA $10
+			a.abs(0x99, 0x0300);	// STA $0300,Y
+			a.op(0xC8);				// INY
+			a.br(0xD0, l);			// BNE
+			a.abs(0x4C, main);		// JMP main
+		}
+		// NMI
+		uint16_t nmi = a.pc();
+		a.op(0x48); a.op(0x8A); a.op(0x48); a.op(0x98); a.op(0x48);
+		a.sta(0x2003, 0x00);
+		a.sta(0x4014, 0x02);	// OAM DMA
+		a.zp(0xE6, 0x11);		// INC $11
+		if(chr_ram) {
+			// タイル（$11）の１６バイトを書き換える
+			a.zp(0xA5, 0x11);		// LDA $11
+			a.op(0x4A); a.op(0x4A); a.op(0x4A); a.op(0x4A);	// LSR x 4
+			a.abs(0x8D, 0x2006);
+			a.zp(0xA5, 0x11);		// LDA $11
+			a.op(0x0A); a.op(0x0A); a.op(0x0A); a.op(0x0A);	// ASL x 4
+			a.abs(0x8D, 0x2006);
+			a.imm(0xA2, 0x10);		// LDX #16
+			uint16_t l = a.pc();
+			a.op(0x8A);				// TXA
+			a.zp(0x45, 0x11);		// EOR $11
+			a.abs(0x8D, 0x2007);	// STA $2007
+			a.op(0xCA);				// DEX
+			a.br(0xD0, l);			// BNE
+		}
+		if(map40) {
+			a.zp(0xA6, 0x11);		// LDX $11
+			a.abs(0xBD, 0x6000);	// LDA $6000,X
+			a.abs(0x8D, 0x0201);	// スプライト０のタイル
+			a.sta(0xE000, 0x06);	// $C000 にバンク６（同じバンクを選び直す）
+		}
+		a.zp(0xA5, 0x11);		// LDA $11
+		a.abs(0x8D, 0x2005);	// スクロール X
+		a.sta(0x2005, 0x00);
+		a.sta(0x2000, ctrl0);
+		a.imm(0xA2, 0x00);		// LDX #0
+		{
+			uint16_t l = a.pc();
+			a.abs(0xFE, 0x0203);	// INC $0203,X
+			a.op(0xE8); a.op(0xE8); a.op(0xE8); a.op(0xE8);
+			a.br(0xD0, l);			// BNE
+		}
+		a.zp(0xA5, 0x11);		// LDA $11
+		a.abs(0x8D, 0x4002);
+		a.op(0x4A);				// LSR A
+		a.abs(0x8D, 0x400A);
+		a.imm(0x29, 0x0F);		// AND #$0F
+		a.abs(0x8D, 0x400E);
+		a.imm(0xD0, 0x05);		// BNE +5（１６フレーム毎に鳴らし直す）
+		a.sta(0x4003, 0x08);
+		uint16_t rti = a.pc();
+		a.op(0x68); a.op(0xA8); a.op(0x68); a.op(0xAA); a.op(0x68);
+		a.op(0x40);				// RTI
+
+		static const uint8_t palette[32] = {
+			0x0F, 0x01, 0x11, 0x21, 0x0F, 0x06, 0x16, 0x26, 0x0F, 0x09, 0x19, 0x29, 0x0F, 0x0C, 0x1C, 0x2C,
+			0x0F, 0x04, 0x14, 0x24, 0x0F, 0x07, 0x17, 0x27, 0x0F, 0x0A, 0x1A, 0x2A, 0x0F, 0x00, 0x10, 0x30
+		};
+		std::memcpy(&code[pal - 0xC000], palette, sizeof(palette));
+		uint16_t vec[3] = { nmi, reset, static_cast<uint16_t>(rti + 5) };
+		for(uint32_t i = 0; i < 3; ++i) {
+			code[0x3FFA + i * 2 + 0] = vec[i] & 0xff;
+			code[0x3FFA + i * 2 + 1] = vec[i] >> 8;
+		}
+		std::memcpy(&prg[prg_size - 0x4000], &code[0], code.size());
+		if(chr_ram) {
+			std::memcpy(&prg[0], &chr[0], chr.size());
+		}
+
+		FILE* fp = fopen(path.c_str(), "wb");
+		if(fp == nullptr) return false;
+		uint8_t head[16] = { 'N', 'E', 'S', 0x1A, static_cast<uint8_t>(prg_size / 0x4000),
+			static_cast<uint8_t>(chr_ram ? 0 : 1), static_cast<uint8_t>(map40 ? 0x81 : 0x01),
+			static_cast<uint8_t>(map40 ? 0x20 : 0x00) };
+		bool ok = fwrite(head, 1, sizeof(head), fp) == sizeof(head);
+		ok = ok && fwrite(&prg[0], 1, prg.size(), fp) == prg.size();
+		if(!chr_ram) {
+			ok = ok && fwrite(&chr[0], 1, chr.size(), fp) == chr.size();
+		}
+		fclose(fp);
+		return ok;
+	}
+
+
+	typedef std::chrono::steady_clock clock_;
+	clock_::time_point	prof_org_;
+	bool				prof_on_ = false;
+
+	double us_(clock_::time_point t0, clock_::time_point t1)
+	{
+		return std::chrono::duration<double, std::micro>(t1 - t0).count();
+	}
+
+
+	/// エミュレーター・コアの計測結果
+	struct core_t {
+		double		cpu_us = 0.0;
+		double		ppu_us = 0.0;
+		double		mmc_us = 0.0;
+		double		apu_us = 0.0;
+		double		total_us = 0.0;
+		uint32_t	frames = 0;
+		uint32_t	sum = 0;		///< 描画したフレームのチェックサム（FNV-1a）
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  コアを N フレーム動かす（nesemu::service と同じ順番）
+		@param[in]	frames	フレーム数
+		@param[in]	draw	描画する場合「true」
+		@param[in]	prof	サブシステム毎に計る場合「true」（画面のチェックサムも計算）
+		@param[in]	snap	フレーム毎に rewind_frame を呼ぶ場合「true」
+		@return 計測結果
+	*/
+	//-----------------------------------------------------------------//
+	core_t run_core_(uint32_t frames, bool draw, bool prof, bool snap = false)
+	{
+		static int16_t audio[(22050 / 60) + 1];
+		core_t r;
+		r.sum = 2166136261;
+		auto p = nes_getprofile();
+		std::memset(p, 0, sizeof(nesprof_t));
+		prof_on_ = prof;
+		auto t0 = clock_::now();
+		for(uint32_t i = 0; i < frames; ++i) {
+			if(prof) {
+				auto a0 = clock_::now();
+				apu_process(audio, sizeof(audio) / sizeof(audio[0]));
+				r.apu_us += us_(a0, clock_::now());
+			} else {
+				apu_process(audio, sizeof(audio) / sizeof(audio[0]));
+			}
+			nes_emulate_frame(draw);
+			if(snap) rewind_frame();
+			if(prof && draw) {
+				prof_on_ = false;
+				const bitmap_t* v = nes_getcontext()->vidbuf;
+				for(int y = 0; y < NES_SCREEN_HEIGHT; ++y) {
+					const uint8_t* p = &v->data[y * v->pitch];
+					for(int x = 0; x < NES_SCREEN_WIDTH; ++x) {
+						r.sum = (r.sum ^ p[x]) * 16777619;
+					}
+				}
+				prof_on_ = true;
+			}
+		}
+		r.total_us = us_(t0, clock_::now());
+		prof_on_ = false;
+		r.cpu_us = p->cpu / 1000.0;
+		r.ppu_us = p->ppu / 1000.0;
+		r.mmc_us = p->mmc / 1000.0;
+		r.frames = frames;
+		return r;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  nesemu::service のペース調整を、仮想時間で評価 @n
+				LCD の垂直同期（60Hz）を待ってサービスを呼び、オーディオを @n
+				FIFO（2048、22050Hz で減る）に積む（RTK5_NESEMU/main.cpp と同じ）。@n
+				サービスの時間は、ホストで計った時間をターゲットに比例させる。
+		@param[in]	emu		エミュレーター
+		@param[in]	fb		フレームバッファ
+		@param[in]	pace	ペース調整する場合「true」
+		@param[in]	draw_us	描画するフレームの時間（ターゲット）
+		@param[in]	skip_us	描画を省いたフレームの時間（ターゲット）
+		@param[in]	conv_us	RGB565 変換の時間（ターゲット）
+		@param[in]	frames	サービスの回数
+	*/
+	//-----------------------------------------------------------------//
+	void pace_(emu::nesemu& emu, std::vector<uint16_t>& fb, bool pace,
+		double draw_us, double skip_us, double conv_us, uint32_t frames)
+	{
+		static const double vsync_us = 1e6 / 60.0;
+		static const double rate = 22050.0 / 1e6;	// サンプル／us
+		static const double fifo_size = 2048.0;
+
+		double t = 0.0;
+		double fifo = 0.0;
+		double under = 0.0;
+		auto drain = [&](double dt) {
+			double n = dt * rate;
+			if(n > fifo) {
+				under += n - fifo;
+				fifo = 0.0;
+			} else {
+				fifo -= n;
+			}
+		};
+
+		auto st0 = emu.get_stat();
+		bool drawn = false;
+		for(uint32_t i = 0; i < frames; ++i) {
+			double v = std::ceil(t / vsync_us) * vsync_us;
+			drain(v - t);
+			t = v;
+
+			auto st = emu.get_stat();
+			emu.service(&fb[0], 480, 272, static_cast<uint32_t>(fifo), pace ? fifo_size : 0);
+			auto sn = emu.get_stat();
+			uint32_t n = sn.frames - st.frames;
+			bool d = sn.drawn != st.drawn;
+			double cost = n * skip_us + (d ? draw_us - skip_us : 0.0) + (drawn ? conv_us : 0.0);
+			drawn = d;
+			drain(cost);
+			t += cost;
+
+			double len = emu.get_audio_len();
+			if((fifo + len) > (fifo_size - 8)) {
+				double w = (fifo + len - (fifo_size - 8)) / rate;
+				drain(w);
+				t += w;
+			}
+			fifo += len;
+		}
+		auto st1 = emu.get_stat();
+		double sec = t / 1e6;
+		printf("  %-6s %7.1f %7.1f %7.1f %9.1f %6u\n", pace ? "on" : "off",
+			(st1.frames - st0.frames) / sec, (st1.drawn - st0.drawn) / sec,
+			frames / sec, under / 22.05, st1.catch_up - st0.catch_up);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  CPU の PRG の窓（$6000、$8000 〜 $E000）が、バンク・キャッシュの @n
+				割り当てたバンクの ROM イメージと同じか検査
+		@param[in]	path	ROM ファイル
+		@param[out]	num		割り当てている窓の数
+		@return 全て同じなら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool prg_windows_(const std::string& path, uint32_t& num)
+	{
+		num = 0;
+		FILE* fp = fopen(path.c_str(), "rb");
+		if(fp == nullptr) return false;
+		std::vector<uint8_t> image;
+		uint8_t tmp[4096];
+		size_t n;
+		while((n = fread(tmp, 1, sizeof(tmp), fp)) > 0) {
+			image.insert(image.end(), tmp, tmp + n);
+		}
+		fclose(fp);
+		if(image.size() < ROM_HEAD) return false;
+		long org = ROM_HEAD + ((image[6] & 0x04) != 0 ? 512 : 0);	// トレーナー
+
+		const auto cpu = nes_getcontext()->cpu;
+		bool ok = true;
+		for(int w = 0; w < BANK_PRG_WINDOWS; ++w) {
+			int bank = bank_getmapped(BANK_PRG, w);
+			if(bank < 0) continue;
+			int page = w == BANK_PRG_SRAM ? 6 : (8 + w * 2);
+			long pos = org + static_cast<long>(bank) * BANK_PRG_SIZE;
+			if((pos + BANK_PRG_SIZE) > static_cast<long>(image.size())
+				|| std::memcmp(cpu->mem_page[page], &image[pos], BANK_PRG_SIZE) != 0) {
+				ok = false;
+			}
+			++num;
+		}
+		return ok;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  ROM をホストで動かして、サブシステム毎の処理時間を表示
+		@param[in]	path	ROM ファイル
+		@param[in]	name	表示名
+		@param[in]	frames	フレーム数
+		@param[in]	pace	ペース調整を評価する場合「true」
+	*/
+	//-----------------------------------------------------------------//
+	void emu_rom_(const std::string& path, const std::string& name, uint32_t frames, bool pace)
+	{
+		emu::nesemu emu;
+		emu.start();
+		if(!emu.open(path.c_str())) {
+			printf("Can't open ROM: '%s'\n\n", path.c_str());
+			return;
+		}
+		printf("%s: %u frames\n", name.c_str(), frames);
+
+		// 立ち上がり（パレット、ネームテーブルの初期化）を除く
+		run_core_(60, true, false);
+
+		auto c = run_core_(frames, true, true);
+		auto ks = run_core_(frames, false, true);
+		// 全体の時間は、計測の負荷を除いて３回の最小
+		core_t d;
+		core_t k;
+		for(uint32_t i = 0; i < 3; ++i) {
+			auto a = run_core_(frames, true, false);
+			if(i == 0 || a.total_us < d.total_us) d = a;
+			auto b = run_core_(frames, false, false);
+			if(i == 0 || b.total_us < k.total_us) k = b;
+		}
+		printf("  subsystem      us/frame   frames/s\n");
+		auto put = [&](const char* name, double us) {
+			printf("  %-12s %10.1f %10.0f\n", name, us / c.frames, us > 0.0 ? c.frames * 1e6 / us : 0.0);
+		};
+		put("CPU", c.cpu_us);
+		put("PPU", c.ppu_us);
+		put("PPU (skip)", ks.ppu_us * c.frames / ks.frames);
+		put("mapper", c.mmc_us);
+		put("APU", c.apu_us);
+		put("core", d.total_us);
+		put("core (skip)", k.total_us);
+
+		// nesemu::service（RGB565 変換を含む）
+		std::vector<uint16_t> fb(480 * 272);
+		auto st0 = emu.get_stat();
+		double svc = 0.0;
+		for(uint32_t j = 0; j < 3; ++j) {
+			auto t0 = clock_::now();
+			for(uint32_t i = 0; i < frames; ++i) {
+				emu.service(&fb[0], 480, 272);
+			}
+			double us = us_(t0, clock_::now());
+			if(j == 0 || us < svc) svc = us;
+		}
+		auto st1 = emu.get_stat();
+		put("service", svc);
+		double conv = svc / frames - d.total_us / frames;
+		if(conv < 0.0) conv = 0.0;
+		printf("  RGB565 LUT built %u times in %u frames\n",
+			st1.lut_build - st0.lut_build, st1.frames - st0.frames);
+		printf("  video checksum %08X\n", c.sum);
+		uint32_t wn;
+		bool wok = prg_windows_(path, wn);
+		printf("  PRG windows: %s (%u mapped)\n\n", wok ? "match (ROM image)" : "MISMATCH", wn);
+
+		if(pace) {
+			// ペース調整（ターゲットの時間は、ホストの比率で換算）
+			double draw = d.total_us / frames + conv;
+			double skip = k.total_us / frames;
+			std::vector<double> target;
+			if(opt_.draw_ms > 0.0) target.push_back(opt_.draw_ms);
+			else target = { 12.0, 18.0, 24.0, 30.0 };
+			for(double ms : target) {
+				double s = ms * 1000.0 / draw;
+				printf("pacing: drawn frame %.1f ms, skipped %.1f ms, RGB565 %.1f ms (target, 60Hz vsync)\n",
+					ms, skip * s / 1000.0, conv * s / 1000.0);
+				printf("  pace   emu fps  draw fps  loop/s  underrun ms  catch-up\n");
+				for(uint32_t i = 0; i < 2; ++i) {
+					pace_(emu, fb, i != 0, (draw - conv) * s, skip * s, conv * s, frames);
+				}
+				printf("\n");
+			}
+		}
+		emu.close();
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  巻き戻しのスナップショットの大きさ、時間を表示
+		@param[in]	path	ROM ファイル
+		@param[in]	name	表示名
+		@param[in]	frames	フレーム数
+	*/
+	//-----------------------------------------------------------------//
+	void rewind_rom_(const std::string& path, const std::string& name, uint32_t frames)
+	{
+		emu::nesemu emu;
+		emu.start();
+		if(!emu.open(path.c_str())) {
+			printf("Can't open ROM: '%s'\n\n", path.c_str());
+			return;
+		}
+		// nesemu::open で作った標準の設定を、オプションで作り直す
+		uint32_t pool = opt_.pool != 0 ? opt_.pool * 1024 : NES_REWIND_POOL;
+		int interval = opt_.interval != 0 ? opt_.interval : NES_REWIND_INTERVAL;
+		if(rewind_create(pool, interval) != 0) {
+			printf("Can't create rewind ring: %u bytes\n\n", pool);
+			emu.close();
+			return;
+		}
+		printf("%s: %u frames, snapshot every %d frames, ring %u bytes\n",
+			name.c_str(), frames, interval, pool);
+
+		run_core_(60, true, false);
+		rewind_clear();
+
+		static int16_t audio[(22050 / 60) + 1];
+		auto st0 = *rewind_getstat();
+		double cap = 0.0;
+		double cap_max = 0.0;
+		for(uint32_t i = 0; i < frames; ++i) {
+			apu_process(audio, sizeof(audio) / sizeof(audio[0]));
+			nes_emulate_frame(true);
+			auto t0 = clock_::now();
+			if(rewind_frame()) {
+				double us = us_(t0, clock_::now());
+				cap += us;
+				if(us > cap_max) cap_max = us;
+			}
+		}
+		auto st1 = *rewind_getstat();
+		uint32_t caps = st1.captures - st0.captures;
+		// 最初のスナップショットは、差分ではない
+		uint32_t deltas = caps > 1 ? caps - 1 : 1;
+		printf("  state image    %6u bytes\n", st1.image);
+		printf("  snapshot       %6.0f bytes avg, %u bytes peak (%.1f%% of image)\n",
+			static_cast<double>(st1.bytes - st0.bytes) / deltas, st1.peak,
+			static_cast<double>(st1.bytes - st0.bytes) * 100.0 / deltas / st1.image);
+		printf("  capture        %6.1f us avg, %.1f us max (%u snapshots)\n",
+			caps > 0 ? cap / caps : 0.0, cap_max, caps);
+
+		int held = rewind_count();
+		double res = 0.0;
+		double res_max = 0.0;
+		uint32_t steps = 0;
+		while(1) {
+			auto t0 = clock_::now();
+			if(rewind_back() != 0) break;
+			double us = us_(t0, clock_::now());
+			res += us;
+			if(us > res_max) res_max = us;
+			++steps;
+		}
+		printf("  restore        %6.1f us avg, %.1f us max (%u steps, %.1f s of history, %u evicted)\n",
+			steps > 0 ? res / steps : 0.0, res_max, steps, held * interval / 60.0,
+			st1.evicts - st0.evicts);
+
+		// スナップショットを取りながら進めて、差分を全て戻してから同じフレームを進め、画面を比べる
+		run_core_(60, true, false);
+		rewind_clear();
+		rewind_capture();
+		static const uint32_t back = 15;
+		uint32_t n = interval * back;
+		auto a = run_core_(n, true, true, true);
+		while(rewind_back() == 0) ;
+		auto b = run_core_(n, true, true);
+		printf("  replay of %u frames after %u steps back: %s (%08X, %08X)\n\n",
+			n, back, a.sum == b.sum ? "identical" : "differs", a.sum, b.sum);
+		emu.close();
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  指定した ROM（無ければ、合成した NROM ２種とマッパー 40）毎に呼ぶ
+		@param[in]	func	ROM 毎の処理（ファイル、表示名、最初の ROM の場合「true」）
+	*/
+	//-----------------------------------------------------------------//
+	void for_roms_(std::function<void(const std::string&, const std::string&, bool)> func)
+	{
+		if(!opt_.rom.empty()) {
+			for(uint32_t i = 0; i < opt_.rom.size(); ++i) {
+				func(opt_.rom[i], opt_.rom[i], i == 0);
+			}
+			return;
+		}
+
+		char tmp[] = "/tmp/nes_bench_XXXXXX";
+		if(mkdtemp(tmp) == nullptr) {
+			printf("Can't make directory\n");
+			return;
+		}
+		std::string dir = tmp;
+		static const char* name[3] = { "synthetic NROM (CHR ROM)", "synthetic NROM (CHR RAM, 8x16)",
+			"synthetic mapper 40 (PRG at $6000)" };
+		static const char* file[3] = { "_chr_rom.nes", "_chr_ram.nes", "_map40.nes" };
+		for(uint32_t i = 0; i < 3; ++i) {
+			std::string path = opt_.save.empty() ? (dir + "/nrom.nes") : (opt_.save + file[i]);
+			if(!make_nrom_(path, i == 1, i == 2)) {
+				printf("Can't write ROM image: '%s'\n", path.c_str());
+				break;
+			}
+			func(path, name[i], i == 0);
+			if(opt_.save.empty()) remove(path.c_str());
+		}
+		rmdir(dir.c_str());
+	}
+
+
+	void emu_bench_()
+	{
+		prof_org_ = clock_::now();
+		uint32_t frames = opt_.frames != 0 ? opt_.frames : 3600;
+		for_roms_([&](const std::string& path, const std::string& name, bool first) {
+			emu_rom_(path, name, frames, first);
+		});
+	}
+
+
+	void rewind_bench_()
+	{
+		prof_org_ = clock_::now();
+		uint32_t frames = opt_.frames != 0 ? opt_.frames : 3600;
+		for_roms_([&](const std::string& path, const std::string& name, bool first) {
+			rewind_rom_(path, name, frames);
+		});
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("nes benchmark Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options]\n", cmd);
+		printf("    -bank          bank cache hit rate and SD stall time (default)\n");
+		printf("    -emu           emulator core frames/s per subsystem and service pacing\n");
+		printf("    -rewind        rewind snapshot size and capture/restore time\n");
+		printf("    -frames N      frames (default: -bank 36000, -emu/-rewind 3600)\n");
+		printf("    -trace FILE    replay a trace recorded with NES_BANK_TRACE\n");
+		printf("    -save PREFIX   save synthetic traces (PREFIX_mmc1.txt, PREFIX_mmc3.txt)\n");
+		printf("                   or the synthetic ROMs (PREFIX_chr_rom.nes, PREFIX_chr_ram.nes,\n");
+		printf("                   PREFIX_map40.nes) with -emu/-rewind\n");
+		printf("    -rom FILE      run FILE with -emu/-rewind instead of the synthetic ROMs (repeatable)\n");
+		printf("    -draw-ms MS    target time of a drawn frame for the pacing model\n");
+		printf("    -pool KB       rewind ring size (default: %u)\n", NES_REWIND_POOL / 1024);
+		printf("    -interval N    frames between rewind snapshots (default: %d)\n", NES_REWIND_INTERVAL);
+	}
+}
+
+
+extern "C" {
+
+	int emu_log(const char* text)
+	{
+		return 0;
+	}
+
+
+	uint32 nes_profile_clock(void)
+	{
+		if(!prof_on_) return 0;
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_::now() - prof_org_).count();
+	}
+
+
+	uint8_t get_fami_pad()
+	{
+		return 0;
+	}
+
+
+	uint16_t sci_length(void)
+	{
+		return 0;
+	}
+
+
+	char sci_getch(void)
+	{
+		return 0;
+	}
+};
+
+
+int main(int argc, char* argv[])
+{
+	enum class MODE {
+		BANK,
+		EMU,
+		REWIND
+	};
+	MODE mode = MODE::BANK;
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-bank") mode = MODE::BANK;
+		else if(s == "-emu") mode = MODE::EMU;
+		else if(s == "-rewind") mode = MODE::REWIND;
+		else if(s == "-pool" && (i + 1) < argc) opt_.pool = std::atoi(argv[++i]);
+		else if(s == "-interval" && (i + 1) < argc) opt_.interval = std::atoi(argv[++i]);
+		else if(s == "-rom" && (i + 1) < argc) opt_.rom.push_back(argv[++i]);
+		else if(s == "-draw-ms" && (i + 1) < argc) opt_.draw_ms = std::atof(argv[++i]);
+		else if(s == "-frames" && (i + 1) < argc) opt_.frames = std::atoi(argv[++i]);
+		else if(s == "-trace" && (i + 1) < argc) opt_.trace = argv[++i];
+		else if(s == "-save" && (i + 1) < argc) opt_.save = argv[++i];
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+
+	switch(mode) {
+	case MODE::BANK:
+		bank_bench_();
+		break;
+	case MODE::EMU:
+		emu_bench_();
+		break;
+	case MODE::REWIND:
+		rewind_bench_();
+		break;
+	}
+	return 0;
+}
@@ -24,6 +24,7 @@ namespace net {
 
 		static const uint16_t ARP_REQUEST_WAIT = 100;   ///< 1 sec
 		static const uint16_t ARP_REQUEST_NUM  = 5;     ///< 5 times
+		static const uint32_t ARP_PENDING_NUM  = 8;     ///< 同時に解決を待てるアドレスの数
 
 		ETHD&		ethd_;
 
@@ -45,9 +46,13 @@ namespace net {
 			arp_h	arp_;
 		} __attribute__((__packed__));
 
-		ip_adrs		req_ipa_;
-		uint16_t	req_wait_;
-		uint16_t	req_num_;
+		struct pending_t {
+			ip_adrs		ipa;
+			uint16_t	wait;
+			uint16_t	num;
+		};
+		pending_t	pending_[ARP_PENDING_NUM];
+		uint32_t	pending_num_;
 
 
 		static const uint8_t* get_arp_head7()
@@ -85,7 +90,7 @@ namespace net {
 			uint32_t all = sizeof(arp_frame);
 			std::memcpy(dst, &t, all);
 
-			uint8_t* p = reinterpret_cast<uint8_t*>(&dst);
+			uint8_t* p = static_cast<uint8_t*>(dst);
 			p += all;
 
 			// ６０バイトに満たない場合は、ダミー・データ（０）を追加する。
@@ -133,7 +138,7 @@ namespace net {
 		*/
 		//-----------------------------------------------------------------//
 		arp(ETHD& ethd, net_info& info) : ethd_(ethd), info_(info), arp_buff_(),
-			req_ipa_(), req_wait_(0), req_num_(0)
+			pending_(), pending_num_(0)
 		{ }
 
 
@@ -220,18 +225,40 @@ namespace net {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  リクエスト
+			@brief  解決待ちか検査
+			@param[in]	ipa		IP アドレス
+			@return 解決待ちなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_pending(const ip_adrs& ipa) const
+		{
+			for(uint32_t i = 0; i < pending_num_; ++i) {
+				if(pending_[i].ipa == ipa) return true;
+			}
+			return false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  リクエスト @n
+					※解決待ちのキューに積み、応答が無い場合は再送する。@n
+					全て応答が無い場合は、否定エントリーとしてキャッシュに登録する
 			@param[in]	ipa		リクエストする IP アドレス
-			@return 正常終了なら「true」
+			@return キューに積んだ（既に解決待ちの）場合「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool request(const ip_adrs& ipa)
 		{
-			if(!req_ipa_.is_any()) return false;
+			if(is_pending(ipa)) return true;
+			if(info_.get_cash().is_negative(ipa)) return false;
+			if(pending_num_ >= ARP_PENDING_NUM) return false;
 
-			req_ipa_   = ipa;
-			req_wait_  = ARP_REQUEST_WAIT;
-			req_num_   = ARP_REQUEST_NUM;
+			pending_t& t = pending_[pending_num_];
+			t.ipa  = ipa;
+			t.wait = ARP_REQUEST_WAIT;
+			t.num  = ARP_REQUEST_NUM;
+			++pending_num_;
 
 			request_sub_(ipa);
 
@@ -252,18 +279,28 @@ namespace net {
 				arp_buff_.get_go();
 			}
 
-			if(req_ipa_.is_any()) return;
-
-			auto idx = info_.at_cash().lookup(req_ipa_);
-			if(info_.at_cash().is_valid(idx)) {
-				req_ipa_.set(0);
-			} else {
-				if(req_wait_) {
-					--req_wait_;
-				} else if(req_num_) {
-					--req_num_;
-					req_wait_ = ARP_REQUEST_WAIT;
-					request_sub_(req_ipa_);
+			uint32_t i = 0;
+			while(i < pending_num_) {
+				pending_t& t = pending_[i];
+				bool done = false;
+				auto idx = info_.at_cash().lookup(t.ipa);
+				if(info_.at_cash().is_valid(idx)) {
+					done = true;
+				} else if(t.wait) {
+					--t.wait;
+				} else if(t.num) {
+					--t.num;
+					t.wait = ARP_REQUEST_WAIT;
+					request_sub_(t.ipa);
+				} else {  // 応答無し
+					info_.at_cash().insert_negative(t.ipa);
+					done = true;
+				}
+				if(done) {
+					--pending_num_;
+					pending_[i] = pending_[pending_num_];
+				} else {
+					++i;
 				}
 			}
 		}
@@ -101,6 +101,9 @@ namespace net {
 		//-----------------------------------------------------------------//
 		void process()
 		{
+			// TCP が受信フレームを借用中は、返却されるまで次を受け取らない
+			if(ipv4_.at_tcp().is_hold()) return;
+
 			// recv
 			void* org;
 			int32_t len = ethd_.recv_buff(&org);
@@ -133,7 +136,9 @@ namespace net {
 					break;
 				}
 
-				ethd_.recv_buff_release();
+				if(!ipv4_.at_tcp().is_hold()) {
+					ethd_.recv_buff_release();
+				}
 			}
 		}
 
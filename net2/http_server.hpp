@@ -1,7 +1,11 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	HTTP サーバー・クラス
+	@brief	HTTP サーバー・クラス @n
+			・持続的接続（keep-alive）と、パイプライン化されたリクエスト @n
+			・ファイルは、クラスタ単位で送信バッファへ直接読み込んで送る @n
+			・ETag/If-None-Match、If-Modified-Since による 304 応答 @n
+			・単一の Range リクエスト（206/416 応答）
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -11,10 +15,12 @@
 #include <cstdio>
 #include <cstring>
 #include <functional>
-#include "common/sdc_io.hpp"
+#include "common/string_utils.hpp"
 #include "common/fixed_string.hpp"
 #include "common/color.hpp"
 #include "common/format.hpp"
+#include "common/web_pack.hpp"
+#include "common/http_utils.hpp"
 #include "net2/tcp.hpp"
 
 #define HTTP_DEBUG
@@ -32,9 +38,11 @@ namespace net {
 		@param[in]	SDC			ＳＤカードファイル操作クラス
 		@param[in]	MAX_LINK	登録リンクの最大数
 		@param[in]	MAX_SIZE	文字列、一時バッファの最大数
+		@param[in]	WEB_PACK	Web パック・クラス
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class ETHERNET, class SDC, uint32_t MAX_LINK = 16, uint32_t MAX_SIZE = 4096>
+	template <class ETHERNET, class SDC, uint32_t MAX_LINK = 16, uint32_t MAX_SIZE = 4096,
+		class WEB_PACK = utils::web_pack<SDC> >
 	class http_server {
 	public:
 		typedef utils::line_manage<2048, 20> LINE_MAN;
@@ -59,6 +67,8 @@ namespace net {
 	private:
 
 		static const uint16_t DISCONNECT_LOOP = 25;   ///< ０．２５秒
+		static const uint32_t SECTOR_SIZE = 512;      ///< ファイル読み込みの最小単位
+		static const int RESPONSE_SPACE = 1024;       ///< 応答ヘッダーを送る為に必要な送信バッファの空き
 
 		// デバッグ以外で出力を無効にする
 #ifdef HTTP_DEBUG
@@ -76,6 +86,21 @@ namespace net {
 		uint8_t			send_buff_[8192];
 		uint32_t		desc_;
 
+		char			req_buff_[2048];  ///< 受信したリクエスト（パイプライン用）
+		uint32_t		req_len_;
+		uint32_t		req_count_;       ///< 接続中に処理したリクエスト数
+		uint32_t		idle_loop_;       ///< 持続的接続の無通信時間（10ms 単位）
+		bool			keep_;
+
+		FIL				file_;
+		bool			file_open_;
+		uint32_t		file_remain_;     ///< 送信するファイルの残り
+
+		WEB_PACK*		pack_;
+		typename WEB_PACK::asset_t	asset_;
+		bool			asset_open_;
+		uint32_t		cluster_;         ///< 一度に読み込む最大サイズ
+
 		time_t			last_modified_;
 		char			server_name_[32];
 		uint32_t		timeout_;
@@ -166,6 +191,353 @@ namespace net {
 			return -1;
 		}
 
+
+		const char* find_header_(const char* key) const
+		{
+			for(uint32_t i = 1; i < line_man_.size(); ++i) {
+				const char* p = line_man_[i];
+				if(p[0] == 0) break;  // ヘッダーの終端
+				const char* v = utils::http_utils::match_key(p, key);
+				if(v != nullptr) return v;
+			}
+			return nullptr;
+		}
+
+
+		static const char* get_num_(const char* p, uint32_t& val)
+		{
+			if(*p < '0' || *p > '9') return nullptr;
+			val = 0;
+			while(*p >= '0' && *p <= '9') {
+				val *= 10;
+				val += *p - '0';
+				++p;
+			}
+			return p;
+		}
+
+
+		// HTTP-date（例：「Sun, 11 Jan 2004 16:06:23 GMT」）の解析
+		static bool parse_date_(const char* p, time_t& t)
+		{
+			p = std::strchr(p, ',');
+			if(p == nullptr) return false;
+			++p;
+			while(*p == ' ') ++p;
+			struct tm m;
+			uint32_t v;
+			if((p = get_num_(p, v)) == nullptr) return false;
+			m.tm_mday = v;
+			while(*p == ' ') ++p;
+			m.tm_mon = -1;
+			for(int i = 0; i < 12; ++i) {
+				if(std::strncmp(p, get_mon(i), 3) == 0) {
+					m.tm_mon = i;
+					break;
+				}
+			}
+			if(m.tm_mon < 0) return false;
+			p += 3;
+			while(*p == ' ') ++p;
+			if((p = get_num_(p, v)) == nullptr) return false;
+			m.tm_year = v - 1900;
+			while(*p == ' ') ++p;
+			if((p = get_num_(p, v)) == nullptr || *p != ':') return false;
+			m.tm_hour = v;
+			if((p = get_num_(p + 1, v)) == nullptr || *p != ':') return false;
+			m.tm_min = v;
+			if((p = get_num_(p + 1, v)) == nullptr) return false;
+			m.tm_sec = v;
+			m.tm_isdst = 0;
+			t = mktime_gmt(&m);
+			return true;
+		}
+
+
+		enum class range_type : uint8_t {
+			none,			///< 範囲指定無し（全体）
+			ok,				///< 範囲指定
+			unsatisfiable,	///< 範囲外
+		};
+
+
+		// 「bytes=first-last」、「bytes=first-」、「bytes=-suffix」の単一範囲のみ扱う
+		static range_type parse_range_(const char* p, uint32_t fsz, uint32_t& first, uint32_t& last)
+		{
+			if(std::strncmp(p, "bytes=", 6) != 0) return range_type::none;
+			p += 6;
+			if(std::strchr(p, ',') != nullptr) return range_type::none;  // 複数範囲は全体を返す
+			uint32_t a = 0;
+			uint32_t b = 0;
+			if(*p == '-') {
+				if(get_num_(p + 1, b) == nullptr) return range_type::none;
+				if(b == 0 || fsz == 0) return range_type::unsatisfiable;
+				if(b > fsz) b = fsz;
+				first = fsz - b;
+				last = fsz - 1;
+				return range_type::ok;
+			}
+			if((p = get_num_(p, a)) == nullptr || *p != '-') return range_type::none;
+			++p;
+			if(get_num_(p, b) == nullptr) {
+				b = fsz - 1;
+			} else if(b < a) {
+				return range_type::none;
+			}
+			if(a >= fsz) return range_type::unsatisfiable;
+			if(b >= fsz) b = fsz - 1;
+			first = a;
+			last = b;
+			return range_type::ok;
+		}
+
+
+		static const char* status_str_(int status)
+		{
+			switch(status) {
+			case 200: return "OK";
+			case 206: return "Partial Content";
+			case 304: return "Not Modified";
+			case 400: return "Bad Request";
+			case 404: return "Not Found";
+			case 413: return "Payload Too Large";
+			case 416: return "Range Not Satisfiable";
+			default:  return "NG";
+			}
+		}
+
+
+		void make_date_(const char* key, time_t t)
+		{
+			struct tm *m = gmtime(&t);
+			// Sun, 11 Jan 2004 16:06:23 GMT
+			http_format("%s: %s, %02d %s %4d %02d:%02d:%02d GMT\n")
+				% key
+				% get_wday(m->tm_wday)
+				% static_cast<uint32_t>(m->tm_mday)
+				% get_mon(m->tm_mon)
+				% static_cast<uint32_t>(m->tm_year + 1900)
+				% static_cast<uint32_t>(m->tm_hour)
+				% static_cast<uint32_t>(m->tm_min)
+				% static_cast<uint32_t>(m->tm_sec);
+		}
+
+
+		void make_connection_(bool keep)
+		{
+			if(keep) {
+				http_format("Keep-Alive: timeout=%u,max=%u\n") % timeout_ % max_;
+			}
+			http_format("Connection: %s\n") % (keep == true ? "keep-alive" : "close");
+		}
+
+
+		void close_file_()
+		{
+			if(file_open_) {
+				sdc_.close(&file_);
+				file_open_ = false;
+			}
+			asset_open_ = false;
+			file_remain_ = 0;
+		}
+
+
+		bool read_body_(void* dst, uint32_t len, UINT& br)
+		{
+			if(asset_open_) {
+				br = pack_->read(asset_, dst, len);
+				return br > 0;
+			}
+			return f_read(&file_, dst, len, &br) == FR_OK && br > 0;
+		}
+
+
+		// ファイル（又は Web パックのアセット）の内容を、送信バッファへ直接読み込む
+		void pump_file_()
+		{
+			auto& tcp = eth_.at_ipv4().at_tcp();
+			while(file_remain_ > 0) {
+				void* dst;
+				int span = tcp.send_span(desc_, dst);
+				if(span < 0) {  // 接続が切れた
+					close_file_();
+					keep_ = false;
+					return;
+				}
+				uint32_t n = span;
+				if(n > file_remain_) n = file_remain_;
+				uint32_t pos = asset_open_ ? pack_->tell(asset_) : f_tell(&file_);
+				uint32_t ofs = pos % SECTOR_SIZE;
+				if(ofs != 0) {  // セクタ境界に揃える
+					if(n > (SECTOR_SIZE - ofs)) n = SECTOR_SIZE - ofs;
+				} else if(n >= SECTOR_SIZE) {  // セクタ単位（最大クラスタ）で直接読み込む
+					n &= ~(SECTOR_SIZE - 1);
+					if(n > cluster_) n = cluster_;
+				} else if(n < file_remain_ && span >= tcp.get_send_space(desc_)) {
+					break;  // 送信バッファに空きが出来るまで待つ
+				}
+				if(n == 0) break;
+				UINT br = 0;
+				if(!read_body_(dst, n, br)) {
+					debug_format("HTTP Server: file read error\n");
+					close_file_();
+					keep_ = false;  // 応答が途中で終わるので、接続を閉じる
+					return;
+				}
+				tcp.send_go(desc_, br);
+				file_remain_ -= br;
+			}
+			if(file_remain_ == 0) {
+				close_file_();
+			}
+		}
+
+
+		// リクエストの条件（If-None-Match、If-Modified-Since、Range）を評価して @n
+		// 応答ヘッダーを送り、ステータスと送るボディーの範囲を返す
+		int send_header_(const char* path, uint32_t fsz, time_t mt, const char* etag, bool gz, bool vary,
+			uint32_t& first, uint32_t& last)
+		{
+			int status = 200;
+			const char* inm = find_header_("If-None-Match");
+			if(inm != nullptr) {
+				if(std::strstr(inm, etag) != nullptr || std::strcmp(inm, "*") == 0) status = 304;
+			} else {
+				const char* ims = find_header_("If-Modified-Since");
+				time_t t;
+				if(ims != nullptr && parse_date_(ims, t) && mt <= t) status = 304;
+			}
+
+			first = 0;
+			last = fsz > 0 ? fsz - 1 : 0;
+			if(status == 200) {
+				const char* range = find_header_("Range");
+				const char* if_range = find_header_("If-Range");
+				if(range != nullptr && (if_range == nullptr || std::strcmp(if_range, etag) == 0)) {
+					auto rt = parse_range_(range, fsz, first, last);
+					if(rt == range_type::ok) status = 206;
+					else if(rt == range_type::unsatisfiable) status = 416;
+				}
+			}
+
+			http_format::chaout().clear();
+			http_format("HTTP/1.1 %d %s\n") % status % status_str_(status);
+			make_date_("Date", get_time());
+			http_format("Server: %s\n") % server_name_;
+			make_date_("Last-Modified", mt);
+			http_format("ETag: %s\n") % etag;
+			http_format("Accept-Ranges: bytes\n");
+			if(vary) {
+				http_format("Vary: Accept-Encoding\n");
+			}
+			if(status == 200 || status == 206) {
+				utils::http_utils::make_content_type<http_format>(path);
+				if(gz) {
+					http_format("Content-Encoding: gzip\n");
+				}
+				if(status == 206) {
+					http_format("Content-Range: bytes %u-%u/%u\n") % first % last % fsz;
+				}
+				http_format("Content-Length: %u\n") % (fsz > 0 ? (last - first + 1) : 0);
+			} else if(status == 416) {
+				http_format("Content-Range: bytes */%u\n") % fsz;
+				http_format("Content-Length: 0\n");
+			}
+			make_connection_(keep_);
+			http_format("\n");
+			http_format::chaout().flush();
+
+			debug_format("HTTP Server: file '%s' (%d) %u-%u/%u%s\n")
+				% path % status % first % last % fsz % (gz ? " gzip" : "");
+			return status;
+		}
+
+
+		// バッファ中の完全なリクエスト（ヘッダー＋ボディー）の長さを返す
+		uint32_t find_request_end_() const
+		{
+			uint32_t hend = 0;
+			for(uint32_t i = 0; i < req_len_; ++i) {
+				if(req_buff_[i] != '\n') continue;
+				if((i + 1) < req_len_ && req_buff_[i + 1] == '\n') {
+					hend = i + 2;
+					break;
+				}
+				if((i + 2) < req_len_ && req_buff_[i + 1] == '\r' && req_buff_[i + 2] == '\n') {
+					hend = i + 3;
+					break;
+				}
+			}
+			if(hend == 0) return 0;
+
+			uint32_t clen = 0;
+			const char* p = req_buff_;
+			const char* end = req_buff_ + hend;
+			while(p < end) {
+				const char* v = utils::http_utils::match_key(p, "Content-Length");
+				if(v != nullptr) {
+					get_num_(v, clen);
+					break;
+				}
+				while(p < end && *p != '\n') ++p;
+				++p;
+			}
+			if((hend + clen) > req_len_) return 0;
+			return hend + clen;
+		}
+
+
+		void dispatch_request_(uint32_t len)
+		{
+			line_man_.clear();
+			auto pos = analize_request(req_buff_, len);
+			if(line_man_.empty()) {
+				debug_format("HTTP Server: request fail section.\n");
+				return;
+			}
+
+			++req_count_;
+			const char* t = line_man_[0];
+			const char* conn = find_header_("Connection");
+			if(std::strstr(t, "HTTP/1.1") != nullptr) {
+				keep_ = conn == nullptr || !utils::http_utils::has_token(conn, "close");
+			} else {
+				keep_ = conn != nullptr && utils::http_utils::has_token(conn, "keep-alive");
+			}
+			if(req_count_ >= max_) keep_ = false;
+
+			char path[256];
+			path[0] = 0;
+			if(strncmp(t, "GET ", 4) == 0) {
+				get_path_(t + 4, path);
+				debug_format("HTTP Server: GET '%s' (%d)\n") % path % len;
+				bool find = exec_link(path, false);
+				if(!find) {
+					debug_format("HTTP Server: can't find GET: '%s'\n") % path;
+					make_info(404, 0, keep_);
+					http_format::chaout().flush();
+				}
+			} else if(strncmp(t, "POST ", 5) == 0) {
+				get_path_(t + 5, path);
+				debug_format("HTTP Server: POST '%s' (%d)\n") % path % len;
+				keep_ = false;  // CGI の応答は長さが判らないので、接続を閉じる
+				parse_cgi(pos);
+				bool find = exec_link(path, true);
+				if(!find) {
+					debug_format("HTTP Server: can't find POST: '%s' (%d)\n") % path % len;
+					make_info(404, 0, keep_);
+					http_format::chaout().flush();
+				}
+			} else {
+				debug_format("HTTP Server: request fail command '%s'\n") % t;
+				keep_ = false;
+				make_info(400, 0, keep_);
+				http_format::chaout().flush();
+			}
+			line_man_.clear();
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -176,6 +548,9 @@ namespace net {
 		//-----------------------------------------------------------------//
 		http_server(ETHERNET& eth, SDC& sdc) : eth_(eth), sdc_(sdc),
 			line_man_(0x0a), desc_(ETHERNET::TCP_OPEN_MAX),
+			req_len_(0), req_count_(0), idle_loop_(0), keep_(false),
+			file_(), file_open_(false), file_remain_(0),
+			pack_(nullptr), asset_(), asset_open_(false), cluster_(SECTOR_SIZE),
 			last_modified_(0), server_name_{ 0 }, timeout_(15), max_(60),
 			count_(0), disconnect_loop_(0), delay_loop_(0),
 			link_num_(0), link_{ },
@@ -257,37 +632,12 @@ namespace net {
 		uint32_t make_info(int status, int length, bool keep = false)
 		{
 			uint32_t lp = 0;
-			http_format("HTTP/1.1 %d ") % status;
-			if(status == 200) {
-				http_format("OK\n");
-			} else if(status == 404) {
-				http_format("Not Found\n");
-			} else {
-				http_format("NG\n");
-			}
+			http_format("HTTP/1.1 %d %s\n") % status % status_str_(status);
 
 			time_t t = get_time();
-			struct tm *m = gmtime(&t);
-			// Sun, 11 Jan 2004 16:06:23 GMT
-			http_format("Date: %s, %02d %s %4d %02d:%02d:%02d GMT\n")
-				% get_wday(m->tm_wday)
-				% static_cast<uint32_t>(m->tm_mon + 1)
-				% get_mon(m->tm_mon)
-				% static_cast<uint32_t>(m->tm_year + 1900)
-				% static_cast<uint32_t>(m->tm_hour)
-				% static_cast<uint32_t>(m->tm_min)
-				% static_cast<uint32_t>(m->tm_sec);
+			make_date_("Date", t);
 			http_format("Server: %s\n") % server_name_;
-
-			http_format("Last-Modified: %s,%02d %s %4d %02d:%02d:%02d GMT\n")
-				% get_wday(m->tm_wday)
-				% static_cast<uint32_t>(m->tm_mon + 1)
-				% get_mon(m->tm_mon)
-				% static_cast<uint32_t>(m->tm_year + 1900)
-				% static_cast<uint32_t>(m->tm_hour)
-				% static_cast<uint32_t>(m->tm_min)
-				% static_cast<uint32_t>(m->tm_sec);
-			http_format("Accept_ranges: bytes\n");
+			make_date_("Last-Modified", t);
 			if(length >= 0) {
 				http_format("Content-Length: %d\n") % length;
 			} else {
@@ -296,10 +646,7 @@ namespace net {
 				// % http_format::chaout().at_str().capacity();
 				http_format("     \n");
 			}
-			if(keep) {
-				http_format("Keep-Alive: timeout=%u,max=%u\n") % timeout_ % max_;
-			}
-			http_format("Connection: %s\n") % (keep == true ? "keep-alive" : "close");
+			make_connection_(keep);
 			http_format("Content-Type: text/html\n\n");
 
 			return lp;
@@ -337,8 +684,14 @@ namespace net {
 			uint32_t clp = 0;
 			uint32_t org = 0;
 
-			if(std::strcmp(path, "/favicon.ico") == 0) {
-				clp = make_info(404, -1, false);
+			if(!cgi && find_link_(path, cgi) < 0 && send_asset(path)) {
+				return true;
+			}
+
+			if(std::strcmp(path, "/favicon.ico") == 0 && find_link_(path, cgi) < 0) {
+				http_format::chaout().clear();
+				clp = make_info(404, -1, keep_);
+				org = http_format::chaout().size();
 				http_format("<!DOCTYPE HTML><html><head><title>404 Not Found</title></head>");
 				http_format("<body></body></html>");
 				uint32_t end = http_format::chaout().size();
@@ -360,10 +713,14 @@ namespace net {
 
 			link_t& t = link_[idx];
 
+			if(t.file_ != nullptr) {
+				return send_file(t.file_);
+			}
+
 			if(!cgi) {
 				http_format::chaout().clear();
 
-				clp = make_info(200, -1, true);
+				clp = make_info(200, -1, keep_);
 				org = http_format::chaout().size();
 				http_format("<!DOCTYPE HTML>\n");
 				http_format("<html>\n");
@@ -503,48 +860,101 @@ namespace net {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  ファイル送信
+			@brief  ファイル送信 @n
+					応答ヘッダーを送り、ファイルの内容は service から、クラスタ単位で @n
+					送信バッファへ直接読み込んで送る。@n
+					リクエストの条件（If-None-Match、If-Modified-Since、Range）を評価する
 			@param[in]	path	ファイル・パス
 			@return 成功なら「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool send_file(const char* path)
 		{
-			FILE* fp = fopen(path, "rb");
-			if(fp == nullptr) {
+			close_file_();
+			if(!sdc_.open(&file_, path, FA_READ)) {
 				return false;
 			}
-			uint32_t fsz = sdc_.size(path);
-
-			http_format::chaout().clear();
-			http_format("HTTP/1.1 200 OK\n");
-			http_format("Content-Type: ");
-			const char* ext = strrchr(path, '.');
-			if(ext != nullptr) {
-				++ext;
-				if(strcmp(ext, "png") == 0 || strcmp(ext, "jpeg") == 0 || strcmp(ext, "jpg") == 0) {
-					http_format("image/%s\n") % ext;
-				} else {
-					http_format("text/%s\n") % ext;
+			uint32_t fsz = f_size(&file_);
+			time_t mt = sdc_.get_time(path);
+			char etag[24];
+			utils::sformat("\"%x-%x\"", etag, sizeof(etag)) % static_cast<uint32_t>(mt) % fsz;
+
+			uint32_t first;
+			uint32_t last;
+			int status = send_header_(path, fsz, mt, etag, false, false, first, last);
+
+			if((status == 200 || status == 206) && fsz > 0) {
+				if(first > 0 && f_lseek(&file_, first) != FR_OK) {
+					sdc_.close(&file_);
+					keep_ = false;
+					return true;
 				}
+				file_open_ = true;
+				cluster_ = static_cast<uint32_t>(file_.obj.fs->csize) * SECTOR_SIZE;
+				file_remain_ = last - first + 1;
+				pump_file_();
 			} else {
-				http_format("text/plain\n");
-			}
-			http_format("Content-Length: %u\n") % fsz;
-			http_format("Connection: close\n\n");
-			http_format::chaout().flush();				
-			uint8_t tmp[512];
-			uint32_t total = 0;
-			uint32_t len;
-			while((len = fread(tmp, 1, sizeof(tmp), fp)) == sizeof(tmp)) {
-				eth_.at_tcp().send(desc_, tmp, sizeof(tmp));
-				total += len;
+				sdc_.close(&file_);
 			}
-			if(len > 0) {
-				eth_.at_tcp().send(desc_, tmp, len);
-				total += len;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  Web パックを設定 @n
+					登録リンクに無いパスは、Web パックから探して送る
+			@param[in]	pack	Web パック（nullptr で無効）
+		*/
+		//-----------------------------------------------------------------//
+		void set_web_pack(WEB_PACK* pack) { pack_ = pack; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  Web パックのアセット送信 @n
+					クライアントが gzip を受け付け、圧縮データがあれば @n
+					「Content-Encoding: gzip」で送る。@n
+					「/」で終わるパスは「index.html」を補う。
+			@param[in]	path	パス
+			@return パックにあれば「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool send_asset(const char* path)
+		{
+			if(pack_ == nullptr || !pack_->is_open()) return false;
+
+			char tmp[256];
+			uint32_t l = std::strlen(path);
+			if(l > 0 && path[l - 1] == '/' && (l + 10) < sizeof(tmp)) {
+				std::strcpy(tmp, path);
+				std::strcat(tmp, "index.html");
+				path = tmp;
+			}
+
+			close_file_();
+			const char* ae = find_header_("Accept-Encoding");
+			bool gzip = utils::http_utils::has_token(ae, "gzip");
+			if(!pack_->open_asset(path, gzip, asset_)) {
+				return false;
 			}
-			fclose(fp);
+			const auto& e = pack_->get_entry(asset_.idx);
+			char etag[24];
+			utils::sformat("\"%08x%s\"", etag, sizeof(etag)) % e.crc % (asset_.gz ? "-gz" : "");
+
+			uint32_t first;
+			uint32_t last;
+			int status = send_header_(path, asset_.size, e.mtime, etag, asset_.gz, e.gz_size > 0,
+				first, last);
+
+			if((status == 200 || status == 206) && asset_.size > 0) {
+				pack_->seek(asset_, first);
+				asset_open_ = true;
+				cluster_ = pack_->get_cluster_size();
+				file_remain_ = last - first + 1;
+				pump_file_();
+			}
+			return true;
 		}
 
 
@@ -598,62 +1008,71 @@ namespace net {
 					line_man_.clear();
 					favicon_ = false;
 					other_link_ = false;
+					req_len_ = 0;
+					req_count_ = 0;
+					idle_loop_ = 0;
+					keep_ = true;
 					disconnect_loop_ = DISCONNECT_LOOP;
 					task_ = task::main_loop;
 				}
 				break;
 
 			case task::main_loop:
-				if(tcp.connected(desc_)) {
-					char tmp[2048];  // 大きな POST データに備えた大きさ
-					int len = tcp.recv(desc_, tmp, sizeof(tmp));
-					if(len == 0) {
-						break;
+				if(!tcp.connected(desc_)) {
+					debug_format("HTTP Server: connection un-link (out main).\n");
+					close_file_();
+					keep_ = false;
+					task_ = task::disconnect_delay;
+					break;
+				}
+				if(file_open_ || asset_open_) {  // ファイル送信中は、次のリクエストを待たせる
+					pump_file_();
+					idle_loop_ = 0;
+					break;
+				}
+				if(!keep_) {
+					disconnect_loop_ = DISCONNECT_LOOP;
+					task_ = task::disconnect_delay;
+					break;
+				}
+				if(req_len_ < sizeof(req_buff_)) {
+					int len = tcp.recv(desc_, &req_buff_[req_len_], sizeof(req_buff_) - req_len_);
+					if(len > 0) {
+						req_len_ += len;
+						idle_loop_ = 0;
 					}
-/// tmp[len] = 0;
-/// utils::format("Recv:\n%s\n") % tmp;
-					auto pos = analize_request(tmp, len);
-					if(pos > 0) {
-						if(!line_man_.empty()) {
-							char path[256];
-							path[0] = 0;
-							const char* t = line_man_[0];
-							if(strncmp(t, "GET ", 4) == 0) {
-								get_path_(t + 4, path);
-								debug_format("HTTP Server: GET '%s' (%d)\n") % path % len;
-								bool find = exec_link(path, false);
-								if(!find) {
-									debug_format("HTTP Server: can't find GET: '%s'\n") % path;
-									make_info(404, -1, false);
-									http_format::chaout().flush();
-								}
-							} else if(strncmp(t, "POST ", 5) == 0) {
-								get_path_(t + 5, path);
-								debug_format("HTTP Server: POST '%s' (%d)\n") % path % len;
-								parse_cgi(pos);
-								bool find = exec_link(path, true);
-								if(!find) {
-									debug_format("HTTP Server: can't find POST: '%s' (%d)\n") % path % len;
-									make_info(404, -1, false);
-									http_format::chaout().flush();
-								}
-							} else {
-								debug_format("HTTP Server: request fail command '%s'\n") % t;
-							}
-							line_man_.clear();
-							task_ = task::disconnect_delay;
+				}
+				{
+					uint32_t n = find_request_end_();
+					if(n == 0) {
+						if(req_len_ >= sizeof(req_buff_)) {
+							debug_format("HTTP Server: request too large\n");
+							req_len_ = 0;
+							keep_ = false;
+							make_info(413, 0, keep_);
+							http_format::chaout().flush();
+						} else if(idle_loop_ >= (timeout_ * 100)) {
+							debug_format("HTTP Server: keep-alive timeout\n");
+							keep_ = false;
 						} else {
-							debug_format("HTTP Server: request fail section.\n");
+							++idle_loop_;
 						}
+						break;
+					}
+					// 応答ヘッダーを送る空きが出来るまで待つ
+					if(tcp.get_send_space(desc_) < RESPONSE_SPACE) break;
+
+					dispatch_request_(n);
+					// 処理したリクエストを捨てて、パイプラインの次を先頭に詰める
+					req_len_ -= n;
+					if(req_len_ > 0) {
+						std::memmove(req_buff_, &req_buff_[n], req_len_);
 					}
-				} else {
-					debug_format("HTTP Server: connection un-link (out main).\n");
-					task_ = task::disconnect_delay;
 				}
 				break;
 
 			case task::disconnect_delay:
-				{
+				if(keep_) {
 					auto len = tcp.get_recv_length(desc_);
 					if(len > 0) {
 						disconnect_loop_ = DISCONNECT_LOOP;
@@ -82,20 +82,15 @@ namespace net {
 				eth_h* d_eh = reinterpret_cast<eth_h*>(dst);
 				swap_copy_eth_h(d_eh, &eh);
 				ipv4_h* d_ih = reinterpret_cast<ipv4_h*>(static_cast<uint8_t*>(dst) + sizeof(eth_h));
+				// アドレスの入れ替えでは、IPV4 ヘッダーのサムは変わらない
 				swap_copy_ipv4_h(d_ih, &ih);
-				{
-					d_ih->set_csum(0x0000);
-					uint16_t sum = tools::calc_sum(d_ih, sizeof(ipv4_h));
-					d_ih->set_csum(sum);
-				}
 				uint8_t* d_msg = static_cast<uint8_t*>(dst);
 				d_msg += sizeof(eth_h) + sizeof(ipv4_h);
 				std::memcpy(d_msg, msg, len);
 				d_msg[0] = 0x00;
-				d_msg[2] = 0x00;
-				d_msg[3] = 0x00;
-				{
-					uint16_t sum = tools::calc_sum(d_msg, len);
+				{  // type(8)/code(0) -> type(0)/code(0) の差分だけ、サムを更新（RFC1624）
+					const uint16_t* p = static_cast<const uint16_t*>(msg);
+					uint16_t sum = tools::update_sum(tools::htons(p[1]), 0x0800, 0x0000);
 					d_msg[2] = sum >> 8;
 					d_msg[3] = sum;
 				}
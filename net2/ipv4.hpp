@@ -153,7 +153,7 @@ namespace net {
 		//-----------------------------------------------------------------//
 		void service(ARP& arp)
 		{
-			udp_.service();
+			udp_.service(arp);
 			tcp_.service(arp);
 		}
 	};
@@ -1,7 +1,11 @@
 #pragma once
 //=========================================================================//
 /*! @file
-    @brief  MAC アドレス・キャッシュ機構
+    @brief  MAC アドレス・キャッシュ機構 @n
+			IP アドレスをキーとするオープン・アドレス法（線形探索）のハッシュ表。@n
+			・使われなくなったエントリーは、エージングで消去する @n
+			・満杯の場合は、標本の中で最も長く参照されていないエントリーを追い出す @n
+			・応答の無かったアドレスは、否定エントリーとして一定時間保持する
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -20,7 +24,7 @@ namespace net {
 	struct arp_info {
 		ip_adrs		ipa;
 		uint8_t		mac[6];
-		uint16_t	time;
+		uint16_t	time;	///< 登録、又は参照した時刻（update の呼び出し単位）
 	};
 
 
@@ -32,9 +36,138 @@ namespace net {
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template<uint32_t SIZE>
 	class mac_cash {
+	public:
+		static const uint16_t AGE_LIMIT      = 12000;	///< 有効期限（update 単位、約 20 分）
+		static const uint16_t NEGATIVE_LIMIT = 100;		///< 否定エントリーの保持時間（約 10 秒）
+
+	private:
+		// 負荷率を 50% 以下に保つ為、SIZE の倍以上の２のべき乗
+		static const uint32_t TS0_ = SIZE * 2 - 1;
+		static const uint32_t TS1_ = TS0_ | (TS0_ >> 1);
+		static const uint32_t TS2_ = TS1_ | (TS1_ >> 2);
+		static const uint32_t TS3_ = TS2_ | (TS2_ >> 4);
+		static const uint32_t TS4_ = TS3_ | (TS3_ >> 8);
+		static const uint32_t TABLE_SIZE = (TS4_ | (TS4_ >> 16)) + 1;
+
+		enum class state : uint8_t {
+			EMPTY,
+			VALID,
+			NEGATIVE,
+		};
 
-		arp_info	info_[SIZE];
+		arp_info	info_[TABLE_SIZE];
+		state		state_[TABLE_SIZE];
 		uint32_t	pos_;
+		uint16_t	time_;
+		uint16_t	sweep_;
+
+		static const uint32_t DIET_SAMPLE = 8;	///< 追い出し候補の標本数
+
+		static uint32_t hash_(const ip_adrs& ipa) noexcept
+		{
+			uint32_t h = ipa.getw();
+			h ^= h >> 16;
+			h *= 0x45d9f3b;
+			h ^= h >> 16;
+			return h & (TABLE_SIZE - 1);
+		}
+
+
+		uint16_t age_(uint32_t idx) const noexcept
+		{
+			return time_ - info_[idx].time;
+		}
+
+
+		bool expired_(uint32_t idx) const noexcept
+		{
+			if(state_[idx] == state::NEGATIVE) return age_(idx) >= NEGATIVE_LIMIT;
+			else return age_(idx) >= AGE_LIMIT;
+		}
+
+
+		uint32_t find_(const ip_adrs& ipa) const noexcept
+		{
+			uint32_t i = hash_(ipa);
+			while(state_[i] != state::EMPTY) {
+				if(info_[i].ipa == ipa) return i;
+				i = (i + 1) & (TABLE_SIZE - 1);
+			}
+			return TABLE_SIZE;
+		}
+
+
+		// 後続のエントリーを詰めて、削除の目印を残さない
+		void erase_slot_(uint32_t i) noexcept
+		{
+			state_[i] = state::EMPTY;
+			--pos_;
+			uint32_t j = i;
+			while(1) {
+				j = (j + 1) & (TABLE_SIZE - 1);
+				if(state_[j] == state::EMPTY) break;
+				uint32_t k = hash_(info_[j].ipa);
+				// k が (i, j] の範囲なら、そのままで探索可能
+				if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+				info_[i] = info_[j];
+				state_[i] = state_[j];
+				state_[j] = state::EMPTY;
+				i = j;
+			}
+		}
+
+
+		// 否定エントリーを優先し、次に古い順
+		uint32_t victim_age_(uint32_t idx) const noexcept
+		{
+			uint32_t a = age_(idx);
+			if(state_[idx] == state::NEGATIVE) a += 0x10000;
+			return a;
+		}
+
+
+		// start から DIET_SAMPLE 個のエントリーを標本とし、最も古い物を消去（近似 LRU）
+		void diet_(uint32_t start) noexcept
+		{
+			uint32_t n = TABLE_SIZE;
+			uint32_t t = 0;
+			uint32_t cnt = 0;
+			for(uint32_t i = 0; i < TABLE_SIZE && cnt < DIET_SAMPLE; ++i) {
+				uint32_t j = (start + i) & (TABLE_SIZE - 1);
+				if(state_[j] == state::EMPTY) continue;
+				++cnt;
+				uint32_t a = victim_age_(j);
+				if(n >= TABLE_SIZE || a > t) {
+					t = a;
+					n = j;
+				}
+			}
+			if(n < TABLE_SIZE) {
+				erase_slot_(n);
+			}
+		}
+
+
+		uint32_t put_(const ip_adrs& ipa, const uint8_t* mac, state st) noexcept
+		{
+			uint32_t n = find_(ipa);
+			if(n >= TABLE_SIZE) {
+				if(pos_ >= SIZE) {
+					diet_(hash_(ipa));
+				}
+				n = hash_(ipa);
+				while(state_[n] != state::EMPTY) {
+					n = (n + 1) & (TABLE_SIZE - 1);
+				}
+				info_[n].ipa = ipa;
+				++pos_;
+			}
+			if(mac != nullptr) std::memcpy(info_[n].mac, mac, 6);
+			else std::memset(info_[n].mac, 0x00, 6);
+			info_[n].time = time_;
+			state_[n] = st;
+			return n;
+		}
 
 	public:
 		//-----------------------------------------------------------------//
@@ -42,7 +175,7 @@ namespace net {
 			@brief  コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		mac_cash() : pos_(0) { }
+		mac_cash() : pos_(0), time_(0), sweep_(0) { clear(); }
 
 
 		//-----------------------------------------------------------------//
@@ -56,7 +189,7 @@ namespace net {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  現在のサイズを返す
+			@brief  現在のサイズを返す（否定エントリーを含む）
 			@return 現在のサイズ
 		*/
 		//-----------------------------------------------------------------//
@@ -70,7 +203,7 @@ namespace net {
 			@return 有効なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool is_valid(uint32_t idx) const { return idx != SIZE; } 
+		bool is_valid(uint32_t idx) const { return idx < TABLE_SIZE; }
 
 
 		//-----------------------------------------------------------------//
@@ -78,24 +211,44 @@ namespace net {
 			@brief  キャッシュをクリア
 		*/
 		//-----------------------------------------------------------------//
-		void clear() noexcept { pos_ = 0; }
+		void clear() noexcept
+		{
+			for(uint32_t i = 0; i < TABLE_SIZE; ++i) {
+				state_[i] = state::EMPTY;
+			}
+			pos_ = 0;
+		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	検索
+			@brief	検索 @n
+					※否定エントリー、期限切れのエントリーは無効を返す
 			@param[in]	ipa	検索アドレス
-			@return 無ければ「SIZE」
+			@return 無ければ無効なインデックス（is_valid で検査）
 		*/
 		//-----------------------------------------------------------------//
 		uint32_t lookup(const ip_adrs& ipa) const noexcept
 		{
-			for(uint32_t i = 0; i < pos_; ++i) {
-				if(info_[i].ipa == ipa) {
-					return i;
-				}
+			uint32_t n = find_(ipa);
+			if(n < TABLE_SIZE && state_[n] == state::VALID && !expired_(n)) {
+				return n;
 			}
-			return SIZE;
+			return TABLE_SIZE;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	否定エントリーか検査（保持時間内のみ）
+			@param[in]	ipa	検索アドレス
+			@return 否定エントリーなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_negative(const ip_adrs& ipa) const noexcept
+		{
+			uint32_t n = find_(ipa);
+			return n < TABLE_SIZE && state_[n] == state::NEGATIVE && !expired_(n);
 		}
 
 
@@ -120,46 +273,46 @@ namespace net {
 			if(tools::check_allzero_mac(mac)) {  // MAC の任意アドレス確認
 				return false;
 			}
-			uint32_t n = lookup(ipa);
-			if(n < SIZE) {  // 登録済みアドレス
-				std::memcpy(info_[n].mac, mac, 6);  // MAC アドレスを更新
-				info_[n].time = 0;  // タイムスタンプ、リセット
-				return true;
-			} else {
-				if(pos_ < SIZE) {
-					info_[pos_].ipa = ipa;
-					std::memcpy(info_[pos_].mac, mac, 6);
-					info_[pos_].time = 0;
-//					utils::format("Insert ARP cash (%d): %s -> %s\n")
-//						% pos_
-//						% tools::ip_str(ipa.get())
-//						% tools::mac_str(mac);
-					++pos_;
-					return true;
-				} else {  // バッファが満杯の場合の処理
-					diet();
-					return insert(ipa, mac);
-				}
+			put_(ipa, mac, state::VALID);
+//			utils::format("Insert ARP cash: %s -> %s\n")
+//				% ipa.c_str()
+//				% tools::mac_str(mac);
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  否定エントリーの登録 @n
+					※ARP 要求に応答が無かったアドレスを、NEGATIVE_LIMIT の間保持する
+			@param[in]	ipa	登録アドレス
+			@return 登録できたら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool insert_negative(const ip_adrs& ipa) noexcept
+		{
+			if(ipa.is_any()) return false;
+			uint32_t n = find_(ipa);
+			if(n < TABLE_SIZE && state_[n] == state::VALID && !expired_(n)) {
+				return false;  // 有効なエントリーは上書きしない
 			}
+			put_(ipa, nullptr, state::NEGATIVE);
+			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	削除 @n
-					※終端を、空いた場所に移動して、サイズを１つ減らす
+			@brief	削除
 			@param[in]	ipa	検索アドレス
 			@return 削除した場合「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool erase(const ip_adrs& ipa) noexcept
 		{
-			auto n = lookup(ipa);
-			if(n < SIZE) {
-				if(n != (pos_ - 1)) {
-					info_[n] = info_[pos_ - 1];
-				}
-				--pos_;
+			auto n = find_(ipa);
+			if(n < TABLE_SIZE) {
+				erase_slot_(n);
 				return true;
 			}
 			return false;
@@ -168,15 +321,15 @@ namespace net {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  リセット
+			@brief  リセット（参照された事を記録する）
 			@param[in]	idx	参照ポイント
 			@return リセット出来た場合「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool reset(uint32_t idx) noexcept
 		{
-			if(idx < pos_) {
-				info_[idx].time = 0;
+			if(idx < TABLE_SIZE && state_[idx] == state::VALID) {
+				info_[idx].time = time_;
 				return true;
 			} else {
 				return false;
@@ -187,7 +340,8 @@ namespace net {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  ダイエット @n
-					※利用頻度が最も低い候補を消去する
+					※否定エントリー、又は、最も長く参照されていない候補を消去する @n
+					（全体を走査する、登録時の追い出しは標本による近似）
 		*/
 		//-----------------------------------------------------------------//
 		void diet() noexcept
@@ -195,16 +349,18 @@ namespace net {
 			if(pos_ < SIZE) {
 				return;
 			}
-			uint32_t n = SIZE;
-			uint16_t t = 0;
-			for(uint32_t i = 0; i < pos_; ++i) {
-				if(info_[i].time > t) {
-					t = info_[i].time;
+			uint32_t n = TABLE_SIZE;
+			uint32_t t = 0;
+			for(uint32_t i = 0; i < TABLE_SIZE; ++i) {
+				if(state_[i] == state::EMPTY) continue;
+				uint32_t a = victim_age_(i);
+				if(n >= TABLE_SIZE || a > t) {
+					t = a;
 					n = i;
 				}
 			}
-			if(n < SIZE) {
-				erase(n);
+			if(n < TABLE_SIZE) {
+				erase_slot_(n);
 			}
 		}
 
@@ -218,7 +374,7 @@ namespace net {
 		//-----------------------------------------------------------------//
 		const arp_info& operator[] (uint32_t idx) const noexcept
 		{
-			if(idx >= pos_) {
+			if(idx >= TABLE_SIZE || state_[idx] != state::VALID) {
 				static arp_info info;
 				std::memset(info.mac, 0x00, 6);
 				info.time = 0;
@@ -231,16 +387,17 @@ namespace net {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  アップデート @n
-					※登録済みのタイムカウントを進める
+					※時刻を進め、エントリーを一つずつ巡回して、期限切れを消去する
 		*/
 		//-----------------------------------------------------------------//
 		void update() noexcept
 		{
-			for(uint32_t i = 0; i < pos_; ++i) {
-				if(info_[i].time < 0xffff) {
-					++info_[i].time;
-				}
+			++time_;
+			uint32_t i = sweep_;
+			if(state_[i] != state::EMPTY && expired_(i)) {
+				erase_slot_(i);
 			}
+			sweep_ = (i + 1) & (TABLE_SIZE - 1);
 		}
 
 
@@ -251,14 +408,15 @@ namespace net {
 		//-----------------------------------------------------------------//
 		void list() const noexcept
 		{
-			for(uint32_t i = 0; i < pos_; ++i) {
-				utils::format("ARP Cash (%d): %s -> %s (%d)\n")
+			for(uint32_t i = 0; i < TABLE_SIZE; ++i) {
+				if(state_[i] == state::EMPTY) continue;
+				utils::format("ARP Cash (%d): %s -> %s (%d)%s\n")
 					% i
 					% info_[i].ipa.c_str()
 					% tools::mac_str(info_[i].mac)
-					% static_cast<uint32_t>(info_[i].time);
+					% static_cast<uint32_t>(age_(i))
+					% (state_[i] == state::NEGATIVE ? " negative" : "");
 			}
 		}
 	};
 }
-
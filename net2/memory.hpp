@@ -126,6 +126,28 @@ namespace net {
 
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納位置から連続して書ける領域を返す（コピーしない）@n
+						※書き終えたら「put_go」で格納ポイントを進める
+			@param[out]	ptr	領域の先頭
+			@return	連続して書けるバイト数
+        */
+        //-----------------------------------------------------------------//
+		uint16_t put_span(void*& ptr) const noexcept {
+			uint16_t get = get_;
+			uint16_t put = put_;
+			ptr = &buff_[put];
+			if(put >= get) {
+				uint16_t n = size_ - put;
+				if(get == 0) --n;  // 満杯と空を区別する為、一つ空ける
+				return n;
+			} else {
+				return get - put - 1;
+			}
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  取得ポイントの移動
@@ -168,6 +190,79 @@ namespace net {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  取得位置からのオフセットを指定して値をコピー（ポインターは更新しない）
+			@param[out]	dst	コピー先
+			@param[in]	ofs	取得位置からのオフセット
+			@param[in]	len	長さ
+        */
+        //-----------------------------------------------------------------//
+		void copy(void* dst, uint16_t ofs, uint16_t len) const noexcept {
+			uint16_t pos = get_ + ofs;
+			if(pos >= size_) pos -= size_;
+			uint16_t fsz = size_ - pos;
+			if(fsz <= len) {
+				std::memcpy(dst, &buff_[pos], fsz);
+				len -= fsz;
+				pos = 0;
+				dst = static_cast<void*>(static_cast<uint8_t*>(dst) + fsz);
+			}
+			if(len > 0) {
+				std::memcpy(dst, &buff_[pos], len);
+			}
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  オフセットを指定して値をコピーしながら、部分和を計算 @n
+					（ポインターは更新しない）
+			@param[out]	dst	コピー先
+			@param[in]	ofs	取得位置からのオフセット
+			@param[in]	len	長さ
+			@param[in]	sum	部分和の初期値
+			@return	部分和（補数を取る前の値）
+        */
+        //-----------------------------------------------------------------//
+		uint16_t copy_sum(void* dst, uint16_t ofs, uint16_t len, uint16_t sum = 0) const noexcept {
+			uint16_t pos = get_ + ofs;
+			if(pos >= size_) pos -= size_;
+			uint16_t fsz = size_ - pos;
+			if(fsz <= len) {
+				sum = tools::copy_sum(dst, &buff_[pos], fsz, sum);
+				len -= fsz;
+				pos = 0;
+				dst = static_cast<void*>(static_cast<uint8_t*>(dst) + fsz);
+				if(len > 0 && (fsz & 1) != 0) {  // 奇数位置からの続きは、バイトを交換して加える
+					uint16_t s = tools::copy_sum(dst, &buff_[pos], len);
+					return tools::join_sum(sum, (s >> 8) | (s << 8));
+				}
+			}
+			if(len > 0) {
+				sum = tools::copy_sum(dst, &buff_[pos], len, sum);
+			}
+			return sum;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  取得位置から連続して読める領域を返す（コピーしない）@n
+					※読み終えたら「get_go」で取得ポイントを進める
+			@param[out]	ptr	領域の先頭
+			@return	連続して読めるバイト数
+        */
+        //-----------------------------------------------------------------//
+		uint16_t get_span(const void*& ptr) const noexcept {
+			uint16_t get = get_;
+			uint16_t put = put_;
+			ptr = &buff_[get];
+			if(put >= get) return put - get;
+			else return size_ - get;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  get 位置を返す
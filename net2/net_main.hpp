@@ -8,7 +8,7 @@
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
-#include "common/renesas.hpp"
+#include "common/format.hpp"
 #include "common/ip_adrs.hpp"
 #include "common/dhcp_client.hpp"
 #include "net2/ethernet.hpp"
@@ -90,9 +90,10 @@ namespace net {
 		ip_adrs		dns2;    ///< Domain Name Server 2ND
 
 		uint32_t	re_send_syn_count_;
+		uint32_t	re_send_count_;  ///< TCP データ再送の回数
 
 	private:
-		typedef mac_cash<8> CASH;
+		typedef mac_cash<32> CASH;
 		CASH		cash_;
 
 		net_share	share_;
@@ -104,7 +105,7 @@ namespace net {
 		*/
 		//-----------------------------------------------------------------//
 		net_info() noexcept : mac{ 0 }, ip(), mask(), gw(), dns(), dns2(),
-			re_send_syn_count_(0),
+			re_send_syn_count_(0), re_send_count_(0),
 			cash_(),
 			share_() { }
 
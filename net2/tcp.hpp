@@ -42,9 +42,11 @@ namespace net {
 		static const uint16_t SEND_MAX      = 1460;      ///< 標準的なパケットの最大数
 		static const uint16_t SYN_TIMEOUT   = 30 * 100;  ///< SYN_RCVD を送って、ACK が返るまでの最大時間
 
-		static const uint16_t RESEND_WAIT   = 90;        ///< 0.9 sec (unit: 10ms)再送
-		static const uint16_t RESEND_SPAN   = 20;        ///< 再送に対する揺らぎ
+		static const uint16_t RTO_INIT      = 100;       ///< 再送タイムアウト初期値 1 sec (unit: 10ms, RFC6298)
+		static const uint16_t RTO_MIN       = 20;        ///< 再送タイムアウト最小値 0.2 sec
+		static const uint16_t RTO_MAX       = 60 * 100;  ///< 再送タイムアウト最大値 60 sec
 		static const uint16_t RESEND_LIMIT  = 5;         ///< 再送の最大回数
+		static const uint16_t DUP_ACK_LIMIT = 3;         ///< 高速再送を行う重複 ACK 数
 
 		static const uint16_t CLOSE_TIME_OUT = 5 * 1000 / 10;  // 5 sec (unit: 10ms)
 
@@ -88,7 +90,6 @@ namespace net {
 			uint16_t	flag_;
 		};
 
-		typedef utils::fixed_fifo<data_info, ETHD::TXD_NUM + 1> SEND_INFO;
 		typedef utils::fixed_fifo<data_info, ETHD::RXD_NUM + 1> RECV_INFO;
 
 		struct context {
@@ -101,8 +102,7 @@ namespace net {
 			volatile send_task	send_task_;
 			volatile recv_task	recv_task_;
 			bool				close_req_;
-			bool				request_ip_;
-			volatile uint16_t	send_wait_;
+			volatile uint16_t	send_wait_;  // 再送タイマー（０で停止）
 			uint16_t	resend_cnt_;
 
 			uint16_t	src_port_;
@@ -110,6 +110,7 @@ namespace net {
 
 			uint16_t	send_time_;
 			uint16_t	close_delay_;
+			uint16_t	close_time_;  // FIN を送ってからの時間
 
 			uint16_t	send_max_;
 			uint16_t	id_;
@@ -122,7 +123,6 @@ namespace net {
 			memory		send_;
 			memory		recv_;
 
-			SEND_INFO	send_info_;
 			RECV_INFO	recv_info_;
 
 			uint32_t	timer_ref_;
@@ -130,8 +130,22 @@ namespace net {
 
 			uint32_t	recv_seq_;
 			uint32_t	recv_ack_;
-			uint32_t	send_seq_;
+			uint32_t	send_seq_;  // ACK 待ちの先頭（SND.UNA）
 			uint32_t	send_ack_;
+			uint32_t	send_nxt_;  // 次に送るシーケンス（SND.NXT）
+			uint32_t	send_high_; // 送った最大のシーケンス
+
+			uint16_t	peer_window_;  // 相手の受信ウィンドウ
+			uint16_t	recv_window_;  // 最後に通知した受信ウィンドウ
+			uint16_t	dup_ack_;      // 重複 ACK の数
+			uint16_t	srtt_;         // 平滑化 RTT（x8）
+			uint16_t	rttvar_;       // RTT 偏差（x4）
+			uint16_t	rto_;          // 再送タイムアウト
+			bool		rtt_run_;      // RTT 計測中
+			bool		recovery_;     // 再送からの回復中
+			uint32_t	rtt_seq_;
+			uint32_t	rtt_ref_;
+			uint32_t	recover_;      // 回復完了となるシーケンス
 
 			volatile uint32_t	send_fin_ack_;
 			volatile uint32_t	send_fin_seq_;
@@ -142,7 +156,10 @@ namespace net {
 			volatile bool		recv_fin_set_;  // FIN を受信した
 			volatile bool		recv_fin_ret_;  // 受信した FIN に対する ACK を送った
 
-			volatile uint16_t	send_len_;
+			bool				zero_copy_;  // 受信セグメントを借用する
+			bool				prepare_;    // 送信バッファ準備中
+			const uint8_t*		hold_ptr_;   // 借用中の受信セグメント
+			volatile uint16_t	hold_len_;
 
 
 			void init(void* send_buff, uint16_t send_size, void* recv_buff, uint16_t recv_size)
@@ -163,7 +180,6 @@ namespace net {
 				send_task_ = send_task::idle;
 				recv_task_ = recv_task::idle;
 				close_req_ = false;
-				request_ip_ = false;
 				send_wait_ = 0;
 				resend_cnt_ = 0;
 
@@ -177,6 +193,7 @@ namespace net {
 
 				send_time_ = 0;
 				close_delay_ = 0;
+				close_time_ = 0;
 				
 				send_max_ = SEND_MAX; // 通常の最大転送バイト
 				id_ = 0;              // 識別子の初期値
@@ -188,7 +205,6 @@ namespace net {
 
 				send_.clear();
 				recv_.clear();
-				send_info_.clear();
 				recv_info_.clear();
 
 				timer_ref_ = 0;
@@ -197,6 +213,20 @@ namespace net {
 				recv_ack_ = 0;
 				send_seq_ = tools::rand() & 0x7fffffff;
 				send_ack_ = 0;
+				send_nxt_ = send_seq_;
+				send_high_ = send_seq_;
+
+				peer_window_ = 0;
+				recv_window_ = 0;
+				dup_ack_ = 0;
+				srtt_ = 0;
+				rttvar_ = 0;
+				rto_ = RTO_INIT;
+				rtt_run_ = false;
+				recovery_ = false;
+				rtt_seq_ = 0;
+				rtt_ref_ = 0;
+				recover_ = 0;
 
 				send_fin_ack_ = 0;
 				send_fin_seq_ = 0;
@@ -207,13 +237,18 @@ namespace net {
 				recv_fin_set_ = false;
 				recv_fin_ret_ = false;
 
-				send_len_ = 0;
+				zero_copy_ = false;
+				prepare_ = false;
+				hold_ptr_ = nullptr;
+				hold_len_ = 0;
 			}
 		};
 
 		typedef udp_tcp_common<context, NMAX> COMMON;
 		COMMON		common_;
 
+		volatile uint32_t	hold_desc_;  ///< 受信フレームを借用しているディスクリプタ
+
 
 		struct frame_t {
 			eth_h	eh_;
@@ -239,10 +274,9 @@ namespace net {
 		};
 
 
-		uint16_t make_send_wait_()
-		{
-			return RESEND_WAIT - (rand() % RESEND_SPAN); 
-		}
+		// シーケンス番号の比較（３２ビットの周回を考慮）
+		static bool seq_lt_(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+		static bool seq_le_(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) <= 0; }
 
 
 		uint32_t delta_time_(uint32_t ref)
@@ -258,7 +292,8 @@ namespace net {
 		}
 
 
-		uint16_t make_seg_(context& ctx, uint8_t flags, uint32_t ack, uint32_t seq, const uint8_t* dst_mac, const uint8_t* dst_ip, frame_t& t, bool data)
+		// ofs: 送信リングの先頭（SND.UNA）からのオフセット、len: 上乗せするデータ長
+		uint16_t make_seg_(context& ctx, uint8_t flags, uint32_t ack, uint32_t seq, const uint8_t* dst_mac, const uint8_t* dst_ip, frame_t& t, uint16_t ofs = 0, uint16_t len = 0, bool inplace = false)
 		{
 			t.eh_.set_dst(dst_mac);  // 転送先の MAC
 			t.eh_.set_src(info_.mac);      // 転送元の MAC
@@ -267,42 +302,26 @@ namespace net {
 			uint16_t all = sizeof(frame_t);
 			uint8_t* p = reinterpret_cast<uint8_t*>(&t) + all;
 
-			// 送信データを上乗せする場合
-			uint16_t send_len = 0;
-			if(data && ctx.send_len_ == 0
-				&& ctx.recv_task_ == recv_task::established
-				&& ctx.send_task_ == send_task::established) {
-
-//				uint16_t ofs = 0;
-//				ctx.send_info_.				
-
-				send_len = ctx.send_.length();
-				if(send_len > 0) {
-					if(ctx.send_max_ < send_len) {  // 転送できるリミットの調整
-						send_len = ctx.send_max_;
-					}
-					ctx.send_.get(p, send_len, false);
-					debug_format("TCP %s Send: src_port(%d) dst_port(%d) %d bytes desc(%d)\n")
-						% (ctx.server_ ? "Server" : "Client")
-						% ctx.src_port_ % ctx.dst_port_
-						% send_len
-						% ctx.desc_;
-					all += send_len;
-/// p[send_len] = 0;
-/// utils::format("%s") % (char*)p;
-					p += send_len;
-					flags |= tcp_h::MASK_PSH;
-					ctx.send_wait_ = make_send_wait_();
-					ctx.resend_cnt_ = 0;
-
-					data_info& di = ctx.send_info_.put_at();
-					di.seq_ = seq;
-					di.ack_ = ack;
-					di.len_ = send_len;
-					di.flag_ = 0;
-					ctx.send_info_.put_go();
-					ctx.send_len_ = send_len;
+			// 送信データを上乗せする場合（データ部の部分和は、コピーと同時に計算）
+			uint16_t send_len = len;
+			uint16_t data_sum = 0;
+			if(send_len > 0) {
+				if(inplace) {  // データは、既に送信バッファに書き込まれている
+					// 再送用に、送信リングにも積んでおく
+					ctx.send_.put(p, send_len);
+					data_sum = tools::add_sum(p, send_len);
+				} else {
+					data_sum = ctx.send_.copy_sum(p, ofs, send_len);
 				}
+				debug_format("TCP %s Send%s: src_port(%d) dst_port(%d) %d bytes desc(%d)\n")
+					% (ctx.server_ ? "Server" : "Client")
+					% (inplace ? " (zero copy)" : "")
+					% ctx.src_port_ % ctx.dst_port_
+					% send_len
+					% ctx.desc_;
+				all += send_len;
+				p += send_len;
+				flags |= tcp_h::MASK_PSH;
 			}
 
 			t.ipv4_.set_ver_hlen(0x45);
@@ -324,7 +343,11 @@ namespace net {
 			t.tcp_.set_ack(ack);
 			t.tcp_.set_length(tcp_len - send_len);  // TCP Header Length
 			t.tcp_.set_flags(flags);
-			t.tcp_.set_window(ctx.window_);
+			// 受信リングの空きを、ウィンドウとして通知する
+			uint16_t win = ctx.recv_.size() - ctx.recv_.length() - 1;
+			if(win > ctx.window_) win = ctx.window_;
+			t.tcp_.set_window(win);
+			ctx.recv_window_ = win;
 			t.tcp_.set_csum(0x0000);
 			t.tcp_.set_urgent_ptr(ctx.urgent_ptr_);
 
@@ -339,9 +362,9 @@ namespace net {
 			smh.dst_.set(dst_ip);
 			smh.fix_ = 0x0600;
 			smh.len_ = tools::htons(tcp_len);
-			uint16_t sum = tools::calc_sum(&smh, sizeof(csum_h));
-			sum = tools::calc_sum(&t.tcp_, tcp_len, ~sum);
-			t.tcp_.set_csum(sum);
+			uint16_t sum = tools::add_sum(&smh, sizeof(csum_h));
+			sum = tools::add_sum(&t.tcp_, tcp_len - send_len, sum);
+			t.tcp_.set_csum(~tools::join_sum(sum, data_sum));
 
 			return all;
 		}
@@ -430,8 +453,15 @@ namespace net {
 					ctx.net_time_ref_ = delta_time_(ctx.timer_ref_);
 					if(ctx.net_time_ref_ == 0) ++ctx.net_time_ref_;  // ０の場合、最低値を設定
 					++ctx.send_seq_;
+					ctx.send_nxt_ = ctx.send_seq_;
+					ctx.send_high_ = ctx.send_seq_;
+					ctx.peer_window_ = tcp->get_window();
 					ctx.recv_task_ = recv_task::established;
 					debug_format("TCP Server Connection: desc(%d)\n") % ctx.desc_; 
+				} else if(tcp->get_flag_syn() && ctx.recv_seq_ == (ctx.send_ack_ - 1)) {
+					// SYN の再送は、SYN/ACK が失われた為なので、SYN/ACK を再送する
+					send = true;
+					flags |= tcp_h::MASK_SYN | tcp_h::MASK_ACK;
 				}
 				break;
 
@@ -444,6 +474,9 @@ namespace net {
 					ctx.net_time_ref_ = delta_time_(ctx.timer_ref_);
 					if(ctx.net_time_ref_ == 0) ++ctx.net_time_ref_;  // ０の場合、最低値を設定
 					ctx.send_seq_ = ctx.recv_ack_;
+					ctx.send_nxt_ = ctx.send_seq_;
+					ctx.send_high_ = ctx.send_seq_;
+					ctx.peer_window_ = tcp->get_window();
 					ctx.send_ack_ = ctx.recv_seq_ + 1;
 					send = true;
 					flags |= tcp_h::MASK_ACK;
@@ -458,42 +491,51 @@ namespace net {
 //	% ctx.recv_seq_ % ctx.recv_ack_ % recv_len;
 //debug_format("(EST) HOST: SEQ: 0x%08X, ACK: 0x%08X\n")
 //	% ctx.send_seq_ % ctx.send_ack_;
+				if(tcp->get_flag_syn()) {  // SYN/ACK の再送は、こちらの ACK が失われた為なので、ACK を返す
+					if(!ctx.server_ && tcp->get_flag_ack() && (ctx.recv_seq_ + 1) == ctx.send_ack_) {
+						send = true;
+						flags |= tcp_h::MASK_ACK;
+					}
+					break;
+				}
 				if(tcp->get_flag_ack()) {
 					if(ctx.send_fin_set_ && !ctx.send_fin_ret_) {  // 送った FIN に対する ACK 確認
-#if 0
-debug_format("TCP Send FIN to ACK match desc(%d)\n") % ctx.desc_;
-debug_format("(EST) RECV: SEQ: 0x%08X, ACK: 0x%08X recv_len(%d)\n")
-	% ctx.recv_seq_ % ctx.recv_ack_ % recv_len;
-debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
-	% ctx.send_fin_seq_ % ctx.send_fin_ack_;
-#endif
-						if(ctx.recv_seq_ == ctx.send_fin_ack_ && ctx.recv_ack_ == ctx.send_fin_seq_) {
+						// 同時クローズでは相手の FIN（ACK は FIN の手前）、そうでなければ FIN の次を指す ACK が来る
+						// （相手が先に FIN を送っていれば、SEQ はその FIN の次になる）
+						uint32_t ds = ctx.recv_seq_ - ctx.send_fin_ack_;
+						uint32_t da = ctx.recv_ack_ - ctx.send_fin_seq_;
+						if(ds <= 1 && da <= 1) {
 							debug_format("Send FIN to ACK OK\n");
 							ctx.send_fin_ret_ = true;
 						}
 					}
-
-					if(ctx.send_info_.length() > 0 && ctx.send_len_ > 0) {  // 転送データがあるなら ACK 確認
-						const data_info& di = ctx.send_info_.get_at();
-						if(ctx.recv_seq_ == di.ack_ && ctx.recv_ack_ >= (di.seq_ + di.len_)) {
-							ctx.send_.get_go(di.len_);  // 転送データが無事送れたので、バッファを進める
-							ctx.send_seq_ += di.len_;
-							debug_format("TCP %s Send OK: %d/%d bytes desc(%d)\n")
-								% (ctx.server_ ? "Server" : "Client")
-								% di.len_ % ctx.send_.length() % ctx.desc_;
-							ctx.send_wait_ = make_send_wait_();
-							ctx.resend_cnt_ = 0;
-							ctx.send_info_.get_go();  // 確認情報を進める
-							ctx.send_len_ = 0;
-						}
-					}
+					recv_ack_(ctx, recv_len == 0 && !tcp->get_flag_fin(), tcp->get_window());
 				}
 
 				if(tcp->get_flag_psh()) {  // データ受信
 // utils::format("PSH:    SEQ: 0x%08X, ACK: 0x%08X (%d)\n") % ctx.recv_seq_ % ctx.recv_ack_ % recv_len;
 // utils::format("SERVER: SEQ: 0x%08X, ACK: 0x%08X\n") % ctx.send_seq_ % ctx.send_ack_;
-					if(recv_len > 0 && recv_len < (ctx.recv_.size() - ctx.recv_.length() - 1)) {
-						if(ctx.recv_ack_ == ctx.send_seq_ && ctx.recv_seq_ >= ctx.send_ack_) {
+					// ゼロ・コピー：受信リングが空なら、受信フレームをそのまま借用する
+					if(recv_len > 0 && ctx.recv_seq_ != ctx.send_ack_) {
+						// 順番が違うセグメントは捨てて、期待するシーケンスを ACK で通知
+						send = true;
+						flags |= tcp_h::MASK_ACK;
+					} else if(recv_len > 0 && ctx.zero_copy_ && ctx.recv_.length() == 0
+						&& hold_desc_ >= NMAX) {
+						{
+							send = true;
+							ctx.hold_ptr_ = reinterpret_cast<const uint8_t*>(tcp) + tcp->get_length();
+							ctx.hold_len_ = recv_len;
+							hold_desc_ = ctx.desc_;
+							debug_format("TCP %s Recv OK (zero copy): %d bytes desc(%d)\n")
+								% (ctx.server_ ? "Server" : "Client")
+								% recv_len
+								% ctx.desc_;
+							ctx.send_ack_ += recv_len;
+							flags |= tcp_h::MASK_ACK;
+						}
+					} else if(recv_len > 0 && recv_len <= (ctx.recv_.size() - ctx.recv_.length() - 1)) {
+						{
 							send = true;
 							const uint8_t* org = reinterpret_cast<const uint8_t*>(tcp);
 							org += tcp->get_length();
@@ -521,81 +563,231 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 				if(t == nullptr) {
 					return false;
 				}
-				bool data = false;  // データ転送を「相乗り」しない
-				auto all = make_seg_(ctx, flags, ctx.send_ack_, ctx.send_seq_,
-					eh.get_src(), ih.get_src_ipa(), *t, data);
+				auto all = make_seg_(ctx, flags, ctx.send_ack_, ctx.send_nxt_,
+					eh.get_src(), ih.get_src_ipa(), *t);
 				ethd_.send(all);
 			}
+
+			// ACK で窓が開いたら、続きを送る
+			if(ctx.recv_task_ == recv_task::established && ctx.send_task_ == send_task::established) {
+				send_window_(ctx);
+			}
 			return true;
 		}
 
 
+		// 借用している受信フレームを返却
+		void hold_release_(context& ctx)
+		{
+			ctx.hold_ptr_ = nullptr;
+			ctx.hold_len_ = 0;
+			if(hold_desc_ == ctx.desc_) {
+				hold_desc_ = NMAX;
+				ethd_.recv_buff_release();
+			}
+		}
+
+
 		// 割り込み「外」からの FIN 送信
 		void send_flags_(context& ctx, uint8_t flags, uint32_t ack, uint32_t seq)
 		{
 			frame_t* t = get_send_frame_();
 			if(t != nullptr) {
-				auto all = make_seg_(ctx, flags, ack, seq, ctx.mac_, ctx.adrs_.get(), *t, false);
+				auto all = make_seg_(ctx, flags, ack, seq, ctx.mac_, ctx.adrs_.get(), *t);
 				ethd_.send(all);
 			}
 		}
 
 
+		// RTT の計測値から、再送タイムアウトを更新（RFC6298）
+		void update_rto_(context& ctx, uint32_t rtt)
+		{
+			if(rtt == 0) rtt = 1;  // 計測単位（10ms）未満
+			if(rtt > RTO_MAX) rtt = RTO_MAX;
+			if(ctx.srtt_ == 0) {  // 最初の計測
+				ctx.srtt_ = rtt << 3;
+				ctx.rttvar_ = rtt << 1;
+			} else {
+				int32_t err = static_cast<int32_t>(rtt) - (ctx.srtt_ >> 3);
+				ctx.srtt_ += err;  // SRTT = 7/8 SRTT + 1/8 R
+				if(err < 0) err = -err;
+				ctx.rttvar_ += err - (ctx.rttvar_ >> 2);  // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+			}
+			calc_rto_(ctx);
+		}
+
+
+		// 再送タイムアウトの計算（タイムアウトによる倍加は解除される）
+		void calc_rto_(context& ctx)
+		{
+			uint32_t rto = (ctx.srtt_ >> 3) + ctx.rttvar_;  // SRTT + 4 * RTTVAR
+			if(rto < RTO_MIN) rto = RTO_MIN;
+			else if(rto > RTO_MAX) rto = RTO_MAX;
+			ctx.rto_ = rto;
+		}
+
+
+		// 先頭（SND.UNA）の１セグメントを再送
+		void resend_(context& ctx)
+		{
+			uint32_t flight = ctx.send_nxt_ - ctx.send_seq_;
+			uint16_t len = ctx.send_max_;
+			if(len > flight) len = flight;
+			if(len == 0) return;
+
+			frame_t* t = get_send_frame_();
+			if(t == nullptr) return;
+			auto all = make_seg_(ctx, tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_seq_,
+				ctx.mac_, ctx.adrs_.get(), *t, 0, len);
+			ethd_.send(all);
+			ctx.rtt_run_ = false;  // 再送したセグメントでは RTT を計らない（Karn）
+			ctx.send_wait_ = ctx.rto_;
+			info_.re_send_count_++;
+		}
+
+
+		// ACK の処理（累積 ACK、重複 ACK による高速再送）
+		void recv_ack_(context& ctx, bool pure, uint16_t window)
+		{
+			uint32_t ack = ctx.recv_ack_;
+			bool update = ctx.peer_window_ != window;
+			ctx.peer_window_ = window;
+
+			if(seq_lt_(ctx.send_seq_, ack) && seq_le_(ack, ctx.send_high_)) {
+				uint32_t len = ack - ctx.send_seq_;
+				ctx.send_.get_go(len);  // 転送データが無事送れたので、バッファを進める
+				ctx.send_seq_ = ack;
+				if(seq_lt_(ctx.send_nxt_, ack)) ctx.send_nxt_ = ack;  // 再送の途中
+				ctx.dup_ack_ = 0;
+				ctx.resend_cnt_ = 0;
+				debug_format("TCP %s Send OK: %d/%d bytes desc(%d)\n")
+					% (ctx.server_ ? "Server" : "Client")
+					% len % ctx.send_.length() % ctx.desc_;
+
+				if(ctx.rtt_run_ && seq_le_(ctx.rtt_seq_, ack)) {
+					ctx.rtt_run_ = false;
+					update_rto_(ctx, delta_time_(ctx.rtt_ref_));
+				} else if(ctx.srtt_ != 0) {
+					calc_rto_(ctx);
+				}
+
+				if(ctx.send_seq_ == ctx.send_nxt_) {
+					ctx.send_wait_ = 0;  // 全て届いたので、再送タイマー停止
+				} else {
+					ctx.send_wait_ = ctx.rto_;
+				}
+
+				if(ctx.recovery_) {
+					if(seq_lt_(ack, ctx.recover_)) {  // 部分 ACK なら、次の欠落を直ちに再送
+						resend_(ctx);
+					} else {
+						ctx.recovery_ = false;
+					}
+				}
+			} else if(ack == ctx.send_seq_ && ctx.send_seq_ != ctx.send_nxt_ && pure && !update) {
+				++ctx.dup_ack_;
+				if(ctx.dup_ack_ == DUP_ACK_LIMIT && !ctx.recovery_) {
+					debug_format("TCP Fast Retransmit: seq(0x%08X) desc(%d)\n")
+						% ctx.send_seq_ % ctx.desc_;
+					ctx.recovery_ = true;
+					ctx.recover_ = ctx.send_nxt_;
+					resend_(ctx);
+				}
+			}
+		}
+
+
+		// 相手の受信ウィンドウ内で、未送信のデータを送る
+		void send_window_(context& ctx, bool probe = false)
+		{
+			while(1) {
+				uint32_t flight = ctx.send_nxt_ - ctx.send_seq_;
+				uint32_t len = ctx.send_.length();
+				if(len <= flight) break;  // 未送信データが無い
+				len -= flight;
+
+				uint32_t win = ctx.peer_window_;
+				if(win <= flight) {
+					// ゼロ・ウィンドウ・プローブは１バイト
+					if(!probe || flight > 0) break;
+					win = flight + 1;
+				}
+				if(len > (win - flight)) len = win - flight;
+				if(len > ctx.send_max_) len = ctx.send_max_;
+
+				frame_t* t = get_send_frame_();
+				if(t == nullptr) break;
+				auto all = make_seg_(ctx, tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_nxt_,
+					ctx.mac_, ctx.adrs_.get(), *t, flight, len);
+				ethd_.send(all);
+
+				if(!ctx.rtt_run_ && !seq_lt_(ctx.send_nxt_, ctx.send_high_)) {  // 新しいデータで計測
+					ctx.rtt_run_ = true;
+					ctx.rtt_seq_ = ctx.send_nxt_ + len;
+					ctx.rtt_ref_ = get_counter();
+				}
+				if(ctx.send_wait_ == 0) ctx.send_wait_ = ctx.rto_;
+				ctx.send_nxt_ += len;
+				if(seq_lt_(ctx.send_high_, ctx.send_nxt_)) ctx.send_high_ = ctx.send_nxt_;
+				probe = false;
+			}
+		}
+
+
 		// 割り込み「外」からのデータ送信
 		void send_(context& ctx)
 		{
 			// 受信タスクが、「established」か確認
 			if(ctx.recv_task_ != recv_task::established) return;
 
-			// 転送バッファが一杯で送れない場合
-			if(ctx.send_info_.length() >= (ctx.send_info_.size() - 1)) return;
-
-			bool data = false;
-			if(ctx.send_.length() > 0) data = true;  // 転送データがあるか？
+			ethd_.enable_interrupt(false);
 
-			// 再送の検査
-			if(ctx.send_info_.length() > 0) {
-				if(ctx.send_wait_ > 0) {
-					--ctx.send_wait_;
-				} else {  // 送信データ再送
+			bool probe = false;
+			// 再送タイマーの検査
+			if(ctx.send_wait_ > 0) {
+				--ctx.send_wait_;
+				if(ctx.send_wait_ == 0) {  // 送信データ再送
 					++ctx.resend_cnt_;
 					// 再送回数がリミットに達したらリセットを送って強制終了
 					if(ctx.resend_cnt_ >= RESEND_LIMIT) {
 						debug_format("TCP ReSend Limit for RST: desc(%d)\n") % ctx.desc_;
-						ethd_.enable_interrupt(false);
-						send_flags_(ctx, tcp_h::MASK_RST, ctx.send_ack_, ctx.send_seq_);
-						ethd_.enable_interrupt(true);
+						send_flags_(ctx, tcp_h::MASK_RST, ctx.send_ack_, ctx.send_nxt_);
 						ctx.recv_task_ = recv_task::close;
 						ctx.send_task_ = send_task::close;
+						ethd_.enable_interrupt();
+						return;
+					}
+					// タイムアウト毎に、再送タイムアウトを倍にする
+					uint32_t rto = ctx.rto_ * 2;
+					ctx.rto_ = rto > RTO_MAX ? RTO_MAX : rto;
+					ctx.dup_ack_ = 0;
+					if(ctx.send_seq_ != ctx.send_nxt_) {
+						// 受信側は順番が違うセグメントを捨てる場合があるので、先頭から送り直す
+						debug_format("TCP ReSend Timeout: seq(0x%08X) rto(%d) desc(%d)\n")
+							% ctx.send_seq_ % ctx.rto_ % ctx.desc_;
+						ctx.recovery_ = false;
+						ctx.rtt_run_ = false;
+						ctx.send_nxt_ = ctx.send_seq_;
+						info_.re_send_count_++;
 					} else {
-						data = true;
+						probe = true;
 					}
 				}
+			} else if(ctx.send_seq_ == ctx.send_nxt_ && ctx.peer_window_ == 0
+				&& ctx.send_.length() > 0) {
+				ctx.send_wait_ = ctx.rto_;  // ゼロ・ウィンドウ・プローブの待ち
 			}
 
-			if(!data) return;
-
-			ethd_.enable_interrupt(false);
-
-			uint16_t len = ctx.send_.length();
-			frame_t* t = nullptr;
-			if(len == 0) {
-				goto send_exit;
-			}
+			send_window_(ctx, probe);
 
-			t = get_send_frame_();
-			if(t == nullptr) {
-				goto send_exit;
-			}
-			{
-				auto all = make_seg_(ctx, tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_seq_,
-					ctx.mac_, ctx.adrs_.get(), *t, true);
-				ethd_.send(all);
+			// 受信ウィンドウが閉じかけていて、アプリが読んで開いたら、通知する
+			if(ctx.recv_window_ < ctx.send_max_) {
+				uint16_t win = ctx.recv_.size() - ctx.recv_.length() - 1;
+				if(win >= ctx.send_max_ || win >= (ctx.recv_.size() / 2)) {
+					send_flags_(ctx, tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_nxt_);
+				}
 			}
-/// dump(t->ipv4_, " (send_)");
-/// dump(t->tcp_,  " (send_)");
 
-		send_exit:
 			ethd_.enable_interrupt();
 		}
 
@@ -609,7 +801,7 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		*/
 		//-----------------------------------------------------------------//
 		tcp(ETHD& ethd, net_info& info, uint32_t seq = 1) noexcept : ethd_(ethd), info_(info),
-			last_state_(net_state::OK)
+			last_state_(net_state::OK), hold_desc_(NMAX)
 
 		{ }
 
@@ -717,8 +909,9 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 			}
 
 			// 同じポートがある場合は無効（ロック状態）
+			// ※自分自身は、前に使った時の値が残っているので除外
 			for(uint32_t i = 0; i < NMAX; ++i) {
-				if(!common_.at_blocks().is_alloc(i)) continue;
+				if(i == desc || !common_.at_blocks().is_alloc(i)) continue;
 				const context& ctx = common_.get_blocks().get(i);
 				uint16_t pp;
 				if(server) {
@@ -752,7 +945,6 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 					ctx.send_task_ = send_task::sync_ack;
 					send_syn = true;
 				} else {  // MAC アドレスが判っていない場合
-					ctx.request_ip_ = true;
 					ctx.recv_task_ = recv_task::idle;
 					ctx.send_task_ = send_task::sync_mac;
 				}
@@ -944,6 +1136,57 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの空き取得
+			@param[in]	desc	ディスクリプタ
+			@return 送信バッファの空き（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int get_send_space(uint32_t desc) const noexcept
+		{
+			if(!probe(desc)) return -1;
+			return common_.get_send_space(desc);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの連続した空き領域を取得 @n
+					ファイル等を、送信バッファへ直接読み込む場合に使う。@n
+					書き込んだら「send_go」でデータを確定する
+			@param[in]	desc	ディスクリプタ
+			@param[out]	ptr		領域の先頭
+			@return 連続して書けるバイト数（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int send_span(uint32_t desc, void*& ptr) noexcept
+		{
+			if(!probe(desc)) return -1;
+
+			const context& ctx = common_.get_blocks().get(desc);
+			if(ctx.close_req_ || ctx.recv_fin_) {
+				return -1;
+			}
+			return common_.send_span(desc, ptr);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファに直接書き込んだデータを確定
+			@param[in]	desc	ディスクリプタ
+			@param[in]	len		書き込んだバイト数
+			@return 確定したバイト数（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int send_go(uint32_t desc, uint16_t len) noexcept
+		{
+			if(!probe(desc)) return -1;
+			return common_.send_go(desc, len);
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  データ受信
@@ -956,7 +1199,19 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		int recv(uint32_t desc, void* dst, uint16_t len) noexcept
 		{
 			if(!probe(desc)) return -1;
-			return common_.recv(desc, dst, len);
+
+			const context& ctx = common_.get_blocks().get(desc);
+			if(ctx.hold_len_ == 0 || ctx.recv_.length() > 0) {
+				return common_.recv(desc, dst, len);
+			}
+			// 借用中のセグメントから読む
+			const void* src;
+			int l = recv_borrow(desc, src);
+			if(l <= 0) return l;
+			if(l > len) l = len;
+			std::memcpy(dst, src, l);
+			recv_return(desc, l);
+			return l;
 		}
 
 
@@ -970,10 +1225,194 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		int get_recv_length(uint32_t desc) const noexcept
 		{
 			if(!probe(desc)) return -1;
-			return common_.get_recv_length(desc);
+			const context& ctx = common_.get_blocks().get(desc);
+			return common_.get_recv_length(desc) + ctx.hold_len_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ゼロ・コピー受信の設定 @n
+					有効にすると、受信リングが空の時、受信セグメントをリングに @n
+					コピーせず、ディスクリプタ・バッファのまま保持する。@n
+					※借用中は、次のフレームを受信しないので、速やかに返却する事 @n
+					※借用中に ACK を待つとデッドロックするので、送れない場合は、@n
+					「recv」でコピーして返却する事
+			@param[in]	desc	ディスクリプタ
+			@param[in]	ena		無効にする場合「false」
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool set_zero_copy(uint32_t desc, bool ena = true) noexcept
+		{
+			if(!probe(desc)) return false;
+
+			context& ctx = common_.at_blocks().at(desc);
+			ctx.zero_copy_ = ena;
+			return true;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  受信データの借用（コピーしない）@n
+					受信リングにデータがあれば、その連続領域、無ければ、@n
+					借用中の受信セグメントを返す。
+			@param[in]	desc	ディスクリプタ
+			@param[out]	ptr		データの先頭
+			@return 読めるバイト数（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int recv_borrow(uint32_t desc, const void*& ptr) noexcept
+		{
+			if(!probe(desc)) return -1;
+
+			const context& ctx = common_.get_blocks().get(desc);
+			if(ctx.recv_.length() > 0) {
+				return ctx.recv_.get_span(ptr);
+			}
+			ptr = ctx.hold_ptr_;
+			return ctx.hold_len_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  借用した受信データの返却 @n
+					受信セグメントを全て読み終えたら、ディスクリプタ・バッファを @n
+					イーサーネット・ドライバーに返す。
+			@param[in]	desc	ディスクリプタ
+			@param[in]	len		読み終えたバイト数
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool recv_return(uint32_t desc, uint16_t len) noexcept
+		{
+			if(!probe(desc)) return false;
+
+			context& ctx = common_.at_blocks().at(desc);
+			if(ctx.recv_.length() > 0) {
+				if(len > ctx.recv_.length()) return false;
+				ctx.recv_.get_go(len);
+				return true;
+			}
+			if(len > ctx.hold_len_) return false;
+			ctx.hold_ptr_ += len;
+			ctx.hold_len_ -= len;
+			if(ctx.hold_len_ == 0) {
+				ethd_.enable_interrupt(false);
+				hold_release_(ctx);
+				ethd_.enable_interrupt(true);
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  受信フレームを借用しているか @n
+					※借用中は、ethernet::process で次のフレームを処理しない
+			@return 借用中なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_hold() const noexcept { return hold_desc_ < NMAX; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの準備（ゼロ・コピー送信）@n
+					ディスクリプタ・バッファのペイロード領域を直接返す。@n
+					書き込んだら「send_commit」、止める場合「send_cancel」を呼ぶ。@n
+					※準備中は、受信割り込みを止めるので、速やかに完了させる事 @n
+					※送信リングに未送信データがある場合は、順序を守る為、失敗する
+			@param[in]	desc	ディスクリプタ
+			@param[out]	max		書き込めるバイト数
+			@return ペイロード領域（失敗なら「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		void* send_prepare(uint32_t desc, uint16_t& max) noexcept
+		{
+			max = 0;
+			if(!probe(desc)) return nullptr;
+
+			context& ctx = common_.at_blocks().at(desc);
+			if(ctx.close_req_ || ctx.recv_fin_ || ctx.prepare_) return nullptr;
+			if(ctx.recv_task_ != recv_task::established) return nullptr;
+			if(ctx.send_task_ != send_task::established) return nullptr;
+			// 未送信データがある場合は、順序を守る為、失敗する
+			uint32_t flight = ctx.send_nxt_ - ctx.send_seq_;
+			if(ctx.send_.length() != flight) return nullptr;
+			if(ctx.peer_window_ <= flight) return nullptr;
+
+			uint16_t spc = ctx.send_.size() - ctx.send_.length() - 1;
+			if(spc > ctx.send_max_) spc = ctx.send_max_;
+			if(spc > (ctx.peer_window_ - flight)) spc = ctx.peer_window_ - flight;
+			if(spc == 0) return nullptr;
+			if(spc > (ETHD::EMAC_BUFSIZE - sizeof(frame_t))) spc = ETHD::EMAC_BUFSIZE - sizeof(frame_t);
+
+			ethd_.enable_interrupt(false);
+			frame_t* t = get_send_frame_();
+			if(t == nullptr) {
+				ethd_.enable_interrupt(true);
+				return nullptr;
+			}
+			ctx.prepare_ = true;
+			max = spc;
+			return t->next(t);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの確定（ゼロ・コピー送信）@n
+					ヘッダーを付加して送信する。
+			@param[in]	desc	ディスクリプタ
+			@param[in]	len		書き込んだバイト数（０ならキャンセル）
+			@return 送信バイト（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int send_commit(uint32_t desc, uint16_t len) noexcept
+		{
+			if(!probe(desc)) return -1;
+
+			context& ctx = common_.at_blocks().at(desc);
+			if(!ctx.prepare_) return -1;
+			ctx.prepare_ = false;
+			int ret = len;
+			if(len > ctx.send_max_ || (ctx.send_.length() + len) >= ctx.send_.size()) {  // 準備した領域を超えている
+				ret = -1;
+			} else if(len > 0) {
+				frame_t* t = get_send_frame_();  // 準備したバッファと同じ
+				if(t == nullptr) {
+					ethd_.enable_interrupt(true);
+					return -1;
+				}
+				auto all = make_seg_(ctx, tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_nxt_,
+					ctx.mac_, ctx.adrs_.get(), *t, 0, len, true);
+				ethd_.send(all);
+				if(!ctx.rtt_run_) {
+					ctx.rtt_run_ = true;
+					ctx.rtt_seq_ = ctx.send_nxt_ + len;
+					ctx.rtt_ref_ = get_counter();
+				}
+				if(ctx.send_wait_ == 0) ctx.send_wait_ = ctx.rto_;
+				ctx.send_nxt_ += len;
+				ctx.send_high_ = ctx.send_nxt_;
+			}
+			ethd_.enable_interrupt(true);
+			return ret;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの準備を取り消す
+			@param[in]	desc	ディスクリプタ
+		*/
+		//-----------------------------------------------------------------//
+		void send_cancel(uint32_t desc) noexcept { send_commit(desc, 0); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  クローズ
@@ -1019,12 +1458,7 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 
 				context& ctx = common_.at_blocks().at(i);  // コンテキスト取得
 
-				uint16_t sum = tools::calc_sum(&ih, sizeof(ipv4_h));
-				if(sum != 0) {
-					debug_format("TCP IPV4 Header Sum Error: %04X -> %04X\n") % ih.get_csum() % sum;
-					continue;
-				}
-
+				// IPV4 ヘッダーのサムは、ipv4::process で検査済み
 				// 転送先の確認
 				if(info_.ip != ih.get_dst_ipa()) continue;
 				// 転送元の確認
@@ -1082,8 +1516,7 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 						send_flags_(ctx, tcp_h::MASK_SYN, ctx.send_ack_, ctx.send_seq_);
 						ctx.send_task_ = send_task::sync_ack;
 						ethd_.enable_interrupt(true);
-					} else if(ctx.request_ip_) {
-						ctx.request_ip_ = false;
+					} else {  // 解決待ちのキューに積む（積み済み、否定エントリーの場合は何もしない）
 						arp.request(ctx.adrs_);
 					}
 					break;
@@ -1108,28 +1541,51 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 					break;
 
 				case send_task::established:
+					// サーバー：ハンドシェークの ACK が返らない場合、SYN/ACK を再送する
+					if(ctx.recv_task_ == recv_task::syn_rcvd && delta_time_(ctx.timer_ref_) >= ctx.rto_) {
+						debug_format("TCP Server SYN/ACK re-send: desc(%d)\n") % i;
+						ethd_.enable_interrupt(false);
+						send_flags_(ctx, tcp_h::MASK_SYN | tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_seq_);
+						ctx.timer_ref_ = get_counter();
+						ethd_.enable_interrupt(true);
+					}
 					send_(ctx);
 					// ・FIN を受け取っても、送信データがあれば、送る事ができる。
 					// ・FIN を送っても、受信データがあれば、それを受け取る必要がある。
 					// ※この「サービス」は、受信動作（割り込み）とは非同期なので、
 					// FIN を送った後で、少しの間、受信データが無い事を確認する為の
 					// 「間」をとる必要がある。
-					if(ctx.send_info_.length() == 0 && ctx.close_req_) {
+					if(ctx.send_.length() == 0 && ctx.close_req_) {
 						if(!ctx.send_fin_set_) {
 							debug_format("TCP Close REQUEST for Send FIN: desc(%d)\n") % i;
 							ethd_.enable_interrupt(false);
-							send_flags_(ctx, tcp_h::MASK_FIN, ctx.send_ack_, ctx.send_seq_);
+							send_flags_(ctx, tcp_h::MASK_FIN | tcp_h::MASK_ACK, ctx.send_ack_, ctx.send_nxt_);
 							ctx.send_fin_ack_ = ctx.send_ack_;
-							ctx.send_fin_seq_ = ctx.send_seq_;
+							ctx.send_fin_seq_ = ctx.send_nxt_;
 							ctx.send_fin_set_ = true;
 							ethd_.enable_interrupt(true);
+						} else {
+							++ctx.close_time_;
+							// ACK が返らない（FIN が失われた）場合は、再送タイムアウト毎に FIN を再送
+							if(!ctx.send_fin_ret_ && (ctx.close_time_ % ctx.rto_) == 0) {
+								debug_format("TCP Re-Send FIN: desc(%d)\n") % i;
+								ethd_.enable_interrupt(false);
+								send_flags_(ctx, tcp_h::MASK_FIN | tcp_h::MASK_ACK, ctx.send_fin_ack_, ctx.send_fin_seq_);
+								ethd_.enable_interrupt(true);
+							}
+							// 相手の FIN、ACK が揃わない場合でも、一定時間で開放する
+							if(ctx.close_time_ >= CLOSE_TIME_OUT) {
+								debug_format("TCP Close Timeout: desc(%d)\n") % i;
+								ctx.send_task_ = send_task::close;
+								break;
+							}
 						}
 
 						if(ctx.send_fin_set_ && ctx.send_fin_ret_ && ctx.recv_fin_set_) {
 							++ctx.close_delay_;
 							if(ctx.close_delay_ >= 15) {  // 0.15 sec
 								ethd_.enable_interrupt(false);
-								send_flags_(ctx, tcp_h::MASK_ACK, ctx.recv_fin_ack_ + 1, ctx.recv_fin_seq_);
+								send_flags_(ctx, tcp_h::MASK_ACK, ctx.recv_fin_seq_ + 1, ctx.send_fin_seq_ + 1);
 								ethd_.enable_interrupt(true);
 								debug_format("TCP Recv FIN to Send ACK: desc(%d)\n") % i;
 								ctx.recv_fin_ret_ = true;
@@ -1142,6 +1598,11 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 					break;
 
 				case send_task::close:  // 強制クローズ
+					if(hold_desc_ == i) {
+						ethd_.enable_interrupt(false);
+						hold_release_(ctx);
+						ethd_.enable_interrupt(true);
+					}
 					common_.at_blocks().lock(i);
 					common_.at_blocks().erase(i);
 					break;
@@ -9,6 +9,7 @@
 */
 //=========================================================================//
 #include "net2/udp_tcp_common.hpp"
+#include "net2/arp.hpp"
 
 #define UDP_DEBUG
 
@@ -47,6 +48,8 @@ namespace net {
 
 		static const uint16_t TIME_OUT = 20 * 1000 / 10;  // 20 sec (unit: 10ms)
 
+		typedef arp<ETHD> ARP;
+
 		ETHD&		ethd_;
 
 		net_info&	info_;
@@ -175,11 +178,12 @@ namespace net {
 			p->udp_.set_dst_port(ctx.port_);
 			p->udp_.set_length(sizeof(udp_h) + len);
 			p->udp_.set_csum(0x0000);
-			ctx.send_.get(static_cast<uint8_t*>(dst) + sizeof(frame_t), len);
-
-			uint16_t sum = tools::calc_sum(&smh, sizeof(csum_h));
-			sum = tools::calc_sum(&p->udp_, sizeof(udp_h) + len, ~sum);
-			p->udp_.set_csum(sum);
+			// 送信データのコピーと同時にサムを計算
+			uint16_t sum = tools::add_sum(&smh, sizeof(csum_h));
+			sum = tools::add_sum(&p->udp_, sizeof(udp_h), sum);
+			sum = ctx.send_.copy_sum(static_cast<uint8_t*>(dst) + sizeof(frame_t), 0, len, sum);
+			ctx.send_.get_go(len);
+			p->udp_.set_csum(~sum);
 
 // dump(p->ipv4_);
 // dump(p->udp_);
@@ -264,10 +268,11 @@ namespace net {
 			@param[in]	desc	ディスクリプタ
 			@param[in]	adrs	アドレス
 			@param[in]	port	ポート
+			@param[in]	dst_port	送信先ポート（「０」の場合、最初の受信で決定）
 			@return 正常なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool start(uint32_t desc, const ip_adrs& adrs, uint16_t port) noexcept
+		bool start(uint32_t desc, const ip_adrs& adrs, uint16_t port, uint16_t dst_port = 0) noexcept
 		{
 			if(!common_.get_blocks().is_alloc(desc)) return false;
 
@@ -301,6 +306,7 @@ namespace net {
 			}
 #endif
 			ctx.reset(adrs, port);
+			ctx.port_ = dst_port;
 
 			if(adrs.is_any() || adrs.is_brodcast()) {
 				ctx.send_task_ = send_task::main;
@@ -467,9 +473,10 @@ namespace net {
 		/*!
 			@brief  サービス（１０ｍｓ毎に呼ぶ）@n
 					※割り込み外から呼ぶ事
+			@param[in]	arp	ARP コンテキスト
 		*/
 		//-----------------------------------------------------------------//
-		void service() noexcept
+		void service(ARP& arp) noexcept
 		{
 			for(uint32_t i = 0; i < NMAX; ++i) {
 
@@ -480,6 +487,8 @@ namespace net {
 				case send_task::sync_mac:
 					if(common_.check_mac(ctx, info_)) {
 						ctx.send_task_ = send_task::main;
+					} else {  // 解決待ちのキューに積む（送信データはリングで待つ）
+						arp.request(ctx.adrs_);
 					}
 					break;
 
@@ -58,9 +58,10 @@ namespace net {
 		//-----------------------------------------------------------------//
 		bool check_mac(CTX& ctx, net_info& info) noexcept
 		{
-			const auto& cash = info.get_cash();
+			auto& cash = info.at_cash();
 			auto idx = cash.lookup(ctx.adrs_);
 			if(cash.is_valid(idx)) {
+				cash.reset(idx);  // 参照された事を記録（LRU）
 				std::memcpy(ctx.mac_, cash[idx].mac, 6);
 				debug_format("UDP/TCP MAC lookup: %s at %s\n")
 					% ctx.adrs_.c_str()
@@ -136,6 +137,60 @@ namespace net {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの空き取得
+			@param[in]	desc	ディスクリプタ
+			@return 送信バッファの空き（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int get_send_space(uint32_t desc) const noexcept
+		{
+			if(!blocks_.is_alloc(desc)) return -1;
+			if(blocks_.is_lock(desc)) return -1;
+
+			const CTX& ctx = blocks_.get(desc);
+			return ctx.send_.size() - ctx.send_.length() - 1;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファの連続した空き領域を取得
+			@param[in]	desc	ディスクリプタ
+			@param[out]	ptr		領域の先頭
+			@return 連続して書けるバイト数（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int send_span(uint32_t desc, void*& ptr) noexcept
+		{
+			if(!blocks_.is_alloc(desc)) return -1;
+			if(blocks_.is_lock(desc)) return -1;
+
+			CTX& ctx = blocks_.at(desc);
+			return ctx.send_.put_span(ptr);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送信バッファに直接書き込んだデータを確定
+			@param[in]	desc	ディスクリプタ
+			@param[in]	len		書き込んだバイト数
+			@return 確定したバイト数（負の値はエラー）
+		*/
+		//-----------------------------------------------------------------//
+		int send_go(uint32_t desc, uint16_t len) noexcept
+		{
+			if(!blocks_.is_alloc(desc)) return -1;
+			if(blocks_.is_lock(desc)) return -1;
+
+			CTX& ctx = blocks_.at(desc);
+			ctx.send_.put_go(len);
+			return len;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  受信
@@ -0,0 +1,558 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ホスト用 Ethernet I/O 制御（net2 負荷試験用）@n
+			RX600/ether_io.hpp と同じインターフェースを、メモリー上の @n
+			「ワイヤー」（フレームのリング・バッファ）で実現する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include "common/fixed_fifo.hpp"
+
+extern "C" {
+	uint32_t get_counter();
+}
+
+namespace device {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ether_stat_t クラス（ether_io.hpp のサブセット）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct ether_stat_t {
+		uint32_t	recv_request_;
+		uint32_t	recv_bytes_;
+		uint32_t	send_request_;
+		uint32_t	send_bytes_;
+		uint32_t	send_full_;		///< ワイヤーが満杯で送れなかった回数
+
+		bool		link_;
+
+		ether_stat_t() :
+			recv_request_(0), recv_bytes_(0), send_request_(0), send_bytes_(0),
+			send_full_(0), link_(false) { }
+
+		void reset() {
+			recv_request_ = 0;
+			recv_bytes_   = 0;
+			send_request_ = 0;
+			send_bytes_   = 0;
+			send_full_    = 0;
+		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ether_wire クラス @n
+				片方向の伝送路（フレーム単位の FIFO）@n
+				遅延（get_counter の単位）と、損失率を設定できる。
+		@param[in]	NUM		フレーム格納数
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t NUM = 64>
+	class ether_wire {
+	public:
+		static const uint32_t FRAME_SIZE = 1536;	///< フレーム・バッファの最大値
+
+		struct frame_t {
+			uint32_t	time_;	///< 到着時間
+			uint16_t	len_;
+			uint8_t		buff_[FRAME_SIZE];
+		};
+
+	private:
+		typedef utils::fixed_fifo<frame_t, NUM> FIFO;
+		FIFO		fifo_;
+
+		uint32_t	frames_;
+		uint32_t	bytes_;
+
+		uint32_t	delay_;
+		uint32_t	loss_;
+		uint32_t	lost_;
+		uint32_t	seed_;
+
+		// 再現性の為、固定種の線形合同法を使う
+		uint32_t rand_() {
+			seed_ = seed_ * 1103515245 + 12345;
+			return (seed_ >> 16) & 0x7fff;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		ether_wire() : fifo_(), frames_(0), bytes_(0),
+			delay_(0), loss_(0), lost_(0), seed_(1) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  伝送路の特性を設定
+			@param[in]	delay	遅延（10ms 単位）
+			@param[in]	loss	損失率（1/1000 単位）
+			@param[in]	seed	損失の乱数種
+		*/
+		//-----------------------------------------------------------------//
+		void set_feature(uint32_t delay, uint32_t loss, uint32_t seed = 1) {
+			delay_ = delay;
+			loss_ = loss;
+			seed_ = seed;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  クリア
+		*/
+		//-----------------------------------------------------------------//
+		void clear() {
+			fifo_.clear();
+			frames_ = 0;
+			bytes_ = 0;
+			lost_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  格納可能か検査
+			@return 格納可能なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool probe_put() const { return fifo_.length() < (fifo_.size() - 1); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  格納されているフレーム数
+			@return フレーム数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t length() const { return fifo_.length(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  先頭フレームが到着しているか
+			@return 到着していれば「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool ready() const {
+			if(fifo_.length() == 0) return false;
+			return static_cast<int32_t>(get_counter() - fifo_.get_at().time_) >= 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  格納位置のフレームを参照（put_go で確定）
+			@return フレーム
+		*/
+		//-----------------------------------------------------------------//
+		frame_t& put_at() { return fifo_.put_at(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  格納を確定
+		*/
+		//-----------------------------------------------------------------//
+		void put_go() {
+			++frames_;
+			bytes_ += fifo_.put_at().len_;
+			if(loss_ > 0 && (rand_() % 1000) < loss_) {  // 損失
+				++lost_;
+				return;
+			}
+			fifo_.put_at().time_ = get_counter() + delay_;
+			fifo_.put_go();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  先頭フレームの参照
+			@return フレーム
+		*/
+		//-----------------------------------------------------------------//
+		const frame_t& get_at() const { return fifo_.get_at(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  先頭フレームを捨てる
+		*/
+		//-----------------------------------------------------------------//
+		void get_go() { fifo_.get_go(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  通過したフレーム数
+			@return フレーム数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_frames() const { return frames_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  通過したバイト数
+			@return バイト数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_bytes() const { return bytes_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  損失したフレーム数
+			@return フレーム数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_lost() const { return lost_; }
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ホスト用 Ethernet I/O 制御クラス @n
+				ether_io と同じ「recv_buff/recv_buff_release/send_buff/send」@n
+				の契約を、ether_wire のペアで実現する。
+		@param[in]	WIRE	伝送路クラス
+		@param[in]	TXDN	送信バッファ数（標準４）
+		@param[in]	RXDN	受信バッファ数（標準４）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class WIRE, uint32_t TXDN = 4, uint32_t RXDN = 4>
+	class ether_host {
+	public:
+		static const int EMAC_BUFSIZE = 1536;	///< イーサーネット・バッファ最大値
+		static const uint32_t TXD_NUM = TXDN;	///< 送信バッファ数
+		static const uint32_t RXD_NUM = RXDN;	///< 受信バッファ数
+
+		static const int OK    = 0;
+		static const int ERROR = -1;
+		static const int ERROR_LINK = -2;
+		static const int ERROR_TACT = -4;	///< Transmission buffer dryness error.
+
+	private:
+		WIRE&		rx_;
+		WIRE&		tx_;
+
+		uint8_t		mac_addr_[6];
+		bool		open_;
+		bool		link_req_;
+		bool		intr_;
+
+		ether_stat_t	stat_;
+
+		const uint8_t*	recv_ptr_;
+		uint32_t		recv_mod_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	rx	受信側ワイヤー
+			@param[in]	tx	送信側ワイヤー
+		*/
+		//-----------------------------------------------------------------//
+		ether_host(WIRE& rx, WIRE& tx) : rx_(rx), tx_(tx), mac_addr_{ 0 },
+			open_(false), link_req_(false), intr_(true), stat_(),
+			recv_ptr_(nullptr), recv_mod_(0)
+			{ }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	MAC アドレスの取得（６バイト）
+			@return MAC アドレス
+		*/
+		//-----------------------------------------------------------------//
+		const uint8_t* get_mac() const noexcept { return mac_addr_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	状態の取得
+			@return ether_stat_t の参照
+		*/
+		//-----------------------------------------------------------------//
+		const ether_stat_t& get_stat() const noexcept { return stat_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	割り込みの制御 @n
+					※ホストでは状態を記録するだけ
+			@param[in]	flag	「false」の場合禁止
+		*/
+		//-----------------------------------------------------------------//
+		void enable_interrupt(bool flag = true) { intr_ = flag; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	割り込み許可状態の取得
+			@return 許可なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool get_interrupt() const { return intr_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	インサーネット・ドライバーをオープン
+			@param[in]	mac_addr	MAC address 48 (6 bytes)
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool open(const uint8_t* mac_addr)
+		{
+			std::memcpy(mac_addr_, mac_addr, 6);
+			stat_.reset();
+			recv_ptr_ = nullptr;
+			recv_mod_ = 0;
+			open_ = true;
+			link_req_ = true;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	インサーネット・ドライバーをクローズ
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool close()
+		{
+			open_ = false;
+			stat_.link_ = false;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リンク状態を強制的に変更（切断の再現用）
+			@param[in]	link	リンク状態
+		*/
+		//-----------------------------------------------------------------//
+		void set_link(bool link)
+		{
+			if(link) {
+				link_req_ = true;
+			} else {
+				stat_.link_ = false;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ポーリングによるリンク・ステータスの更新
+		*/
+		//-----------------------------------------------------------------//
+		void polling_link_status() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リンク・サービス
+			@return リンク・アップなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool service_link()
+		{
+			if(open_ && link_req_) {
+				link_req_ = false;
+				stat_.link_ = true;
+				return true;
+			}
+			return false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信バッファの取得
+			@param[out]	buf	受信バッファ・ポインター
+			@return エラー・ステータス（受信バイト数）
+		*/
+		//-----------------------------------------------------------------//
+		int32_t recv_buff(void** buf)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			if(!rx_.ready()) return 0;
+
+			const auto& t = rx_.get_at();
+			*buf = const_cast<uint8_t*>(t.buff_);
+			return t.len_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信バッファ開放
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t recv_buff_release()
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			if(rx_.ready()) {
+				rx_.get_go();
+			}
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送バッファの取得
+			@param[out]	buf	転送バッファ・ポインター
+			@param[out]	len	転送最大数
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t send_buff(void** buf, uint16_t& len)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			if(!tx_.probe_put()) {
+				++stat_.send_full_;
+				return ERROR_TACT;
+			}
+			auto& t = tx_.put_at();
+			*buf = t.buff_;
+			len = EMAC_BUFSIZE;
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送
+			@param[in]	len	転送バイト数
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t send(uint32_t len)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			tx_.put_at().len_ = len;
+			tx_.put_go();
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・データ
+			@param[in]	dst	転送先
+			@param[in]	len	リード長
+			@return リード数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t read(void* dst, uint32_t len)
+		{
+			uint32_t ret = 0;
+			if(recv_ptr_ != nullptr && recv_mod_ > 0) {
+				if(len >= recv_mod_) {
+					ret = recv_mod_;
+					std::memcpy(dst, recv_ptr_, recv_mod_);
+					recv_ptr_ = nullptr;
+					recv_mod_ = 0;
+					recv_buff_release();
+				} else {
+					std::memcpy(dst, recv_ptr_, len);
+					recv_ptr_ += len;
+					recv_mod_ -= len;
+					ret = len;
+				}
+				return ret;
+			}
+
+			void* ptr;
+			auto l = recv_buff(&ptr);
+			if(l > 0) {
+				if(l > static_cast<int32_t>(len)) {
+					recv_mod_ = l - len;
+					recv_ptr_ = static_cast<const uint8_t*>(ptr) + len;
+					l = len;
+				}
+				stat_.recv_request_++;
+				stat_.recv_bytes_ += l;
+				ret = l;
+				std::memcpy(dst, ptr, l);
+				if(recv_ptr_ == nullptr) {
+					recv_buff_release();
+				}
+			}
+			return ret;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・データ
+			@param[in]	hsrc	ヘッダー転送元
+			@param[in]	hlen	ヘッダー長さ
+			@param[in]	bsrc	ボディー転送元
+			@param[in]	blen	ボディー長さ
+			@return ライト数
+		*/
+		//-----------------------------------------------------------------//
+		int32_t write(const void* hsrc, uint32_t hlen, const void* bsrc, uint32_t blen)
+		{
+			void* buf;
+			uint16_t buf_size;
+			if(send_buff(&buf, buf_size) == OK && buf_size >= (hlen + blen)) {
+				std::memcpy(buf, hsrc, hlen);
+				std::memcpy(static_cast<uint8_t*>(buf) + hlen, bsrc, blen);
+				if(send(hlen + blen) == OK) {
+					stat_.send_request_++;
+					stat_.send_bytes_ += hlen + blen;
+					return 0;
+				}
+			}
+			return -5;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・データ
+			@param[in]	src	転送元
+			@param[in]	len	長さ
+			@return ライト数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t write(const void* src, uint32_t len)
+		{
+			void* ptr;
+			uint16_t maxlen;
+			uint32_t ret = 0;
+			if(send_buff(&ptr, maxlen) == OK) {
+				ret = len > maxlen ? maxlen : len;
+				std::memcpy(ptr, src, ret);
+				if(send(ret) == OK) {
+					stat_.send_request_++;
+					stat_.send_bytes_ += ret;
+				}
+			}
+			return ret;
+		}
+	};
+}
@@ -0,0 +1,319 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	Linux TAP デバイスによる Ethernet I/O 制御（net2 負荷試験用）@n
+			RX600/ether_io.hpp と同じインターフェースで、ホストの @n
+			TAP インターフェースにフレームを流す。@n
+			※事前に「ip tuntap add dev tap0 mode tap」等で作成しておく事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include "ether_host.hpp"
+
+namespace device {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  TAP Ethernet I/O 制御クラス
+		@param[in]	TXDN	送信バッファ数（標準４）
+		@param[in]	RXDN	受信バッファ数（標準４）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t TXDN = 4, uint32_t RXDN = 4>
+	class ether_tap {
+	public:
+		static const int EMAC_BUFSIZE = 1536;	///< イーサーネット・バッファ最大値
+		static const uint32_t TXD_NUM = TXDN;	///< 送信バッファ数
+		static const uint32_t RXD_NUM = RXDN;	///< 受信バッファ数
+
+		static const int OK    = 0;
+		static const int ERROR = -1;
+		static const int ERROR_LINK = -2;
+
+	private:
+		int			fd_;
+		uint8_t		mac_addr_[6];
+		bool		link_req_;
+
+		ether_stat_t	stat_;
+
+		uint8_t		recv_[EMAC_BUFSIZE];
+		int32_t		recv_len_;
+		uint8_t		send_[EMAC_BUFSIZE];
+
+		const uint8_t*	recv_ptr_;
+		uint32_t		recv_mod_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		ether_tap() : fd_(-1), mac_addr_{ 0 }, link_req_(false), stat_(),
+			recv_len_(0), recv_ptr_(nullptr), recv_mod_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  デストラクター
+		*/
+		//-----------------------------------------------------------------//
+		~ether_tap() { close(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  TAP デバイスに接続
+			@param[in]	name	インターフェース名（例：「tap0」）
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool attach(const char* name)
+		{
+			fd_ = ::open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+			if(fd_ < 0) return false;
+
+			struct ifreq ifr;
+			std::memset(&ifr, 0, sizeof(ifr));
+			ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+			std::strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+			if(ioctl(fd_, TUNSETIFF, &ifr) < 0) {
+				::close(fd_);
+				fd_ = -1;
+				return false;
+			}
+			return true;
+		}
+
+
+		const uint8_t* get_mac() const noexcept { return mac_addr_; }
+
+		const ether_stat_t& get_stat() const noexcept { return stat_; }
+
+		void enable_interrupt(bool flag = true) { }
+
+		void polling_link_status() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	インサーネット・ドライバーをオープン
+			@param[in]	mac_addr	MAC address 48 (6 bytes)
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool open(const uint8_t* mac_addr)
+		{
+			if(fd_ < 0) return false;
+			std::memcpy(mac_addr_, mac_addr, 6);
+			stat_.reset();
+			recv_len_ = 0;
+			recv_ptr_ = nullptr;
+			recv_mod_ = 0;
+			link_req_ = true;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	インサーネット・ドライバーをクローズ
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool close()
+		{
+			if(fd_ >= 0) {
+				::close(fd_);
+				fd_ = -1;
+			}
+			stat_.link_ = false;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リンク・サービス
+			@return リンク・アップなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool service_link()
+		{
+			if(link_req_) {
+				link_req_ = false;
+				stat_.link_ = true;
+				return true;
+			}
+			return false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信バッファの取得
+			@param[out]	buf	受信バッファ・ポインター
+			@return エラー・ステータス（受信バイト数）
+		*/
+		//-----------------------------------------------------------------//
+		int32_t recv_buff(void** buf)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			if(recv_len_ == 0) {
+				auto l = ::read(fd_, recv_, sizeof(recv_));
+				if(l <= 0) return 0;
+				recv_len_ = l;
+			}
+			*buf = recv_;
+			return recv_len_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信バッファ開放
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t recv_buff_release()
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			recv_len_ = 0;
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送バッファの取得
+			@param[out]	buf	転送バッファ・ポインター
+			@param[out]	len	転送最大数
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t send_buff(void** buf, uint16_t& len)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			*buf = send_;
+			len = EMAC_BUFSIZE;
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送
+			@param[in]	len	転送バイト数
+			@return エラー・ステータス
+		*/
+		//-----------------------------------------------------------------//
+		int32_t send(uint32_t len)
+		{
+			if(!stat_.link_) return ERROR_LINK;
+			if(::write(fd_, send_, len) != static_cast<ssize_t>(len)) {
+				return ERROR;
+			}
+			return OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・データ
+			@param[in]	dst	転送先
+			@param[in]	len	リード長
+			@return リード数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t read(void* dst, uint32_t len)
+		{
+			uint32_t ret = 0;
+			if(recv_ptr_ != nullptr && recv_mod_ > 0) {
+				if(len >= recv_mod_) {
+					ret = recv_mod_;
+					std::memcpy(dst, recv_ptr_, recv_mod_);
+					recv_ptr_ = nullptr;
+					recv_mod_ = 0;
+					recv_buff_release();
+				} else {
+					std::memcpy(dst, recv_ptr_, len);
+					recv_ptr_ += len;
+					recv_mod_ -= len;
+					ret = len;
+				}
+				return ret;
+			}
+
+			void* ptr;
+			auto l = recv_buff(&ptr);
+			if(l > 0) {
+				if(l > static_cast<int32_t>(len)) {
+					recv_mod_ = l - len;
+					recv_ptr_ = static_cast<const uint8_t*>(ptr) + len;
+					l = len;
+				}
+				stat_.recv_request_++;
+				stat_.recv_bytes_ += l;
+				ret = l;
+				std::memcpy(dst, ptr, l);
+				if(recv_ptr_ == nullptr) {
+					recv_buff_release();
+				}
+			}
+			return ret;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・データ
+			@param[in]	hsrc	ヘッダー転送元
+			@param[in]	hlen	ヘッダー長さ
+			@param[in]	bsrc	ボディー転送元
+			@param[in]	blen	ボディー長さ
+			@return ライト数
+		*/
+		//-----------------------------------------------------------------//
+		int32_t write(const void* hsrc, uint32_t hlen, const void* bsrc, uint32_t blen)
+		{
+			if(!stat_.link_ || sizeof(send_) < (hlen + blen)) return -5;
+			std::memcpy(send_, hsrc, hlen);
+			std::memcpy(send_ + hlen, bsrc, blen);
+			if(send(hlen + blen) != OK) return -5;
+			stat_.send_request_++;
+			stat_.send_bytes_ += hlen + blen;
+			return 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・データ
+			@param[in]	src	転送元
+			@param[in]	len	長さ
+			@return ライト数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t write(const void* src, uint32_t len)
+		{
+			if(!stat_.link_) return 0;
+			uint32_t ret = len > sizeof(send_) ? sizeof(send_) : len;
+			std::memcpy(send_, src, ret);
+			if(send(ret) != OK) return 0;
+			stat_.send_request_++;
+			stat_.send_bytes_ += ret;
+			return ret;
+		}
+	};
+}
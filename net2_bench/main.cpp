@@ -0,0 +1,1162 @@
+//=====================================================================//
+/*!	@file
+	@brief	net2 負荷試験（ホスト用ベンチマーク）@n
+			二つの net_main をメモリー上のワイヤーで接続し、@n
+			TCP/UDP のトランザクションを仮想時間（10ms 単位）で駆動する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "common/format.hpp"
+#include "ether_host.hpp"
+#include "ether_tap.hpp"
+#include "mac_cash_legacy.hpp"
+#include "net2/net_main.hpp"
+
+// common/time.h の代わり（ホストの time.h を使うので、http_server が使う関数だけ宣言）
+extern "C" {
+	time_t mktime_gmt(const struct tm* tmp);
+	const char* get_wday(uint8_t idx);
+	const char* get_mon(uint8_t idx);
+}
+#include "net2/http_server.hpp"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	static const uint32_t UDPN = 2;  // UDP の経路数
+	static const uint32_t TCPN = 2;  // TCP の経路数
+
+	typedef device::ether_wire<64> WIRE;
+	WIRE	wire_ab_;  // A ---> B
+	WIRE	wire_ba_;  // B ---> A
+
+	typedef device::ether_host<WIRE> ETHD;
+	ETHD	ethd_a_(wire_ba_, wire_ab_);
+	ETHD	ethd_b_(wire_ab_, wire_ba_);
+
+	typedef net::net_main<ETHD, UDPN, TCPN> NET_MAIN;
+	NET_MAIN	net_a_(ethd_a_);  // サーバー側
+	NET_MAIN	net_b_(ethd_b_);  // クライアント側
+
+	typedef device::ether_tap<> TAPD;
+	typedef net::net_main<TAPD, UDPN, TCPN> NET_TAP;
+
+	// ＳＤカードの代わり（作業ディレクトリのファイルを FatFs の代わりに読む）
+	struct sdc_host {
+		std::string	root;
+		time_t		mtime = 0;
+
+		bool open(FIL* fp, const char* path, BYTE mode) const {
+			return f_open(fp, (root + path).c_str(), mode) == FR_OK;
+		}
+		bool close(FIL* fp) const { return f_close(fp) == FR_OK; }
+		time_t get_time(const char* path) const { return mtime; }
+	};
+	sdc_host	sdc_;
+
+	typedef net::http_server<NET_MAIN::ETHERNET, sdc_host> HTTP;
+	HTTP	http_(net_a_.at_ethernet(), sdc_);
+
+	FATFS	fatfs_;
+	std::map<const FIL*, FILE*>	host_fp_;
+
+	volatile uint32_t	counter_ = 0;
+
+	static const uint16_t TCP_PORT = 3000;
+	static const uint16_t UDP_PORT = 3001;
+	static const uint32_t CLOSE_LIMIT = 10 * 100;  ///< クローズ完了を待つ最大時間（TCP のクローズ・タイムアウト 5 sec の倍）
+	static const uint32_t CONNECT_LIMIT = 5 * 100;  ///< 再接続までの時間（5 sec）
+
+	struct option_t {
+		bool		tcp = true;
+		bool		reconnect = false;
+		bool		verbose = false;
+		bool		zero_copy = false;
+		bool		bulk = false;
+		bool		http = false;
+		uint32_t	delay = 0;  // ワイヤー遅延（10ms 単位）
+		uint32_t	loss = 0;   // ワイヤー損失率（1/1000 単位）
+		uint32_t	count = 1000;
+		uint32_t	size = 256;
+		uint32_t	limit = 100 * 60 * 60;  // 仮想時間の上限（1 hour）
+		std::string	tap;
+	};
+	option_t	opt_;
+
+	struct result_t {
+		uint32_t	trans = 0;
+		uint32_t	bytes = 0;
+		uint32_t	latency = 0;   ///< トランザクション毎の往復時間の合計（10ms 単位）
+		uint32_t	latency_max = 0;
+		uint32_t	connects = 0;
+		uint32_t	stalls = 0;    ///< クローズが完了しなかった回数
+		uint32_t	closes = 0;    ///< クローズの回数
+		uint32_t	close_ticks = 0;  ///< クローズ要求から、コンテキスト開放までの時間の合計（10ms 単位）
+		uint32_t	close_max = 0;
+		uint32_t	ticks = 0;
+	};
+
+	uint8_t	a_send_[16384];
+	uint8_t	a_recv_[16384];
+	uint8_t	b_send_[16384];
+	uint8_t	b_recv_[16384];
+	uint8_t	work_[4096];
+
+
+	// 仮想時間を１０ｍｓ進める
+	void tick_()
+	{
+		++counter_;
+		net_a_.service();
+		net_b_.service();
+	}
+
+
+	// ワイヤー上のフレームを全て受信処理する（割り込みの代わり）
+	void pump_()
+	{
+		uint32_t n = 0;
+		while((wire_ab_.ready() || wire_ba_.ready()) && n < 256) {
+			net_a_.process();
+			net_b_.process();
+			++n;
+		}
+	}
+
+
+	void step_()
+	{
+		tick_();
+		pump_();
+	}
+
+
+	bool start_()
+	{
+		static const uint8_t mac_a[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0A };
+		static const uint8_t mac_b[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0B };
+
+		net_a_.at_ethernet().at_info().ip.set(192, 168, 3, 20);
+		net_b_.at_ethernet().at_info().ip.set(192, 168, 3, 21);
+		if(!net_a_.start(mac_a)) return false;
+		if(!net_b_.start(mac_b)) return false;
+
+		// DHCP のタイムアウトを経て、固定 IP でメインループに入るまで待つ
+		uint32_t n = 0;
+		while(!net_a_.check_main() || !net_b_.check_main()) {
+			step_();
+			++n;
+			if(n >= 1000) return false;
+		}
+		return true;
+	}
+
+
+	const net::ip_adrs& get_ip_(NET_MAIN& net) { return net.get_info().ip; }
+
+
+	// クローズ完了（コンテキスト開放）を待つ
+	bool wait_close_(NET_MAIN::ETHERNET::IPV4::TCP& tcp, uint32_t desc, result_t& r)
+	{
+		uint32_t n = 0;
+		while(tcp.probe(desc)) {
+			step_();
+			++n;
+			if(n >= CLOSE_LIMIT) {
+				++r.stalls;
+				tcp.close(desc);
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  TCP ベンチマーク @n
+				クライアント（B）が size バイトを送り、サーバー（A）がエコーする。
+		@param[out]	r	結果
+	*/
+	//-----------------------------------------------------------------//
+	void bench_tcp_(result_t& r)
+	{
+		auto& tcp_a = net_a_.at_ethernet().at_ipv4().at_tcp();
+		auto& tcp_b = net_b_.at_ethernet().at_ipv4().at_tcp();
+
+		enum class task { open, connect, send, recv, close };
+		task t = task::open;
+
+		uint32_t da = TCPN;
+		uint32_t db = TCPN;
+		uint32_t sent = 0;
+		uint32_t recvd = 0;
+		uint32_t ref = 0;
+		uint32_t wait = 0;
+		bool abort = false;
+
+		for(uint32_t i = 0; i < sizeof(work_); ++i) {
+			work_[i] = 0x20 + (i % 95);
+		}
+
+		auto start = counter_;
+		while(!abort && r.trans < opt_.count && (counter_ - start) < opt_.limit) {
+			switch(t) {
+			case task::open:
+				// 前回のクローズが終わらず、コンテキストが開放されない場合は中断
+				++wait;
+				if(wait >= CLOSE_LIMIT) {
+					++r.stalls;
+					abort = true;
+					break;
+				}
+				if(!tcp_a.open(a_send_, sizeof(a_send_), a_recv_, sizeof(a_recv_), da)) break;
+				if(!tcp_a.start(da, net::ip_adrs(), TCP_PORT, true)) {
+					tcp_a.close(da);
+					break;
+				}
+				if(!tcp_b.open(b_send_, sizeof(b_send_), b_recv_, sizeof(b_recv_), db)) break;
+				if(!tcp_b.start(db, get_ip_(net_a_), TCP_PORT, false)) {
+					tcp_b.close(db);
+					break;
+				}
+				if(opt_.zero_copy) tcp_a.set_zero_copy(da);
+				wait = 0;
+				t = task::connect;
+				break;
+
+			case task::connect:
+				if(tcp_b.connected(db) && tcp_a.connected(da)) {
+					++r.connects;
+					sent = 0;
+					t = task::send;
+				} else {
+					++wait;
+					if(wait >= CONNECT_LIMIT) {
+						tcp_b.re_connect(db);
+						wait = 0;
+					}
+				}
+				break;
+
+			case task::send:
+				if(sent == 0) ref = counter_;
+				{
+					int l = tcp_b.send(db, &work_[sent], opt_.size - sent);
+					if(l > 0) sent += l;
+				}
+				if(sent >= opt_.size) {
+					recvd = 0;
+					t = task::recv;
+				}
+				break;
+
+			case task::recv:
+				{
+					int l = tcp_b.recv(db, &work_[recvd], opt_.size - recvd);
+					if(l > 0) recvd += l;
+				}
+				if(recvd >= opt_.size) {
+					++r.trans;
+					r.bytes += opt_.size * 2;
+					auto lt = counter_ - ref;
+					r.latency += lt;
+					if(r.latency_max < lt) r.latency_max = lt;
+					if(opt_.reconnect) {
+						t = task::close;
+					} else {
+						sent = 0;
+						t = task::send;
+					}
+				}
+				break;
+
+			case task::close:
+				{
+					auto cr = counter_;
+					tcp_b.close(db);
+					// サーバーは FIN を受けたらクローズする（FIN が失われた場合も、クローズする）
+					while(!tcp_a.is_fin(da) && tcp_a.probe(da) && (counter_ - cr) < CLOSE_LIMIT) {
+						step_();
+					}
+					tcp_a.close(da);
+					if(wait_close_(tcp_b, db, r) && wait_close_(tcp_a, da, r)) {
+						auto ct = counter_ - cr;
+						++r.closes;
+						r.close_ticks += ct;
+						if(r.close_max < ct) r.close_max = ct;
+					}
+				}
+				wait = 0;
+				t = task::open;
+				break;
+			}
+
+			// サーバー（A）のエコー
+			if(opt_.zero_copy) {
+				// 受信セグメントを借用し、送信ディスクリプタへ直接書き込む
+				const void* src;
+				int l = tcp_a.recv_borrow(da, src);
+				if(l > 0) {
+					uint16_t max;
+					void* dst = tcp_a.send_prepare(da, max);
+					if(dst != nullptr) {
+						if(l > max) l = max;
+						std::memcpy(dst, src, l);
+						tcp_a.send_commit(da, l);
+						tcp_a.recv_return(da, l);
+					} else {  // 直接送れない場合は、コピーして受信フレームを返却
+						uint8_t tmp[1536];
+						l = tcp_a.recv(da, tmp, sizeof(tmp));
+						if(l > 0) tcp_a.send(da, tmp, l);
+					}
+				}
+			} else if(tcp_a.connected(da)) {
+				int l = tcp_a.get_recv_length(da);
+				int s = sizeof(a_send_) - 1 - tcp_a.get_send_length(da);
+				if(l > s) l = s;
+				if(l > 0) {
+					uint8_t tmp[1536];
+					if(l > static_cast<int>(sizeof(tmp))) l = sizeof(tmp);
+					l = tcp_a.recv(da, tmp, l);
+					if(l > 0) tcp_a.send(da, tmp, l);
+				}
+			}
+
+			step_();
+		}
+		r.ticks = counter_ - start;
+
+		if(t != task::open) {
+			tcp_b.close(db);
+			tcp_a.close(da);
+			wait_close_(tcp_b, db, r);
+			wait_close_(tcp_a, da, r);
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  TCP バルク転送ベンチマーク @n
+				クライアント（B）が size x count バイトを送り続け、@n
+				サーバー（A）は受け取って捨てる。
+		@param[out]	r	結果
+	*/
+	//-----------------------------------------------------------------//
+	void bench_bulk_(result_t& r)
+	{
+		auto& tcp_a = net_a_.at_ethernet().at_ipv4().at_tcp();
+		auto& tcp_b = net_b_.at_ethernet().at_ipv4().at_tcp();
+
+		uint32_t da;
+		uint32_t db;
+		if(!tcp_a.open(a_send_, sizeof(a_send_), a_recv_, sizeof(a_recv_), da)) return;
+		if(!tcp_a.start(da, net::ip_adrs(), TCP_PORT, true)) return;
+		if(!tcp_b.open(b_send_, sizeof(b_send_), b_recv_, sizeof(b_recv_), db)) return;
+		if(!tcp_b.start(db, get_ip_(net_a_), TCP_PORT, false)) return;
+
+		uint32_t wait = 0;
+		while(!tcp_b.connected(db) || !tcp_a.connected(da)) {
+			step_();
+			++wait;
+			if((wait % CONNECT_LIMIT) == 0) tcp_b.re_connect(db);
+			if(wait >= opt_.limit) return;
+		}
+		++r.connects;
+
+		for(uint32_t i = 0; i < opt_.size; ++i) {
+			work_[i] = 0x20 + (i % 95);
+		}
+		uint32_t total = opt_.size * opt_.count;
+		uint32_t sent = 0;
+		uint32_t pos = 0;
+		auto start = counter_;
+		while(r.bytes < total && (counter_ - start) < opt_.limit) {
+			while(sent < total) {
+				uint32_t l = opt_.size - pos;
+				if(l > (total - sent)) l = total - sent;
+				int n = tcp_b.send(db, &work_[pos], l);
+				if(n <= 0) break;
+				sent += n;
+				pos += n;
+				if(pos >= opt_.size) {
+					pos = 0;
+					++r.trans;
+				}
+			}
+
+			uint8_t tmp[1536];
+			int n;
+			while((n = tcp_a.recv(da, tmp, sizeof(tmp))) > 0) {
+				r.bytes += n;
+			}
+			step_();
+		}
+		r.ticks = counter_ - start;
+
+		tcp_b.close(db);
+		tcp_a.close(da);
+		wait_close_(tcp_b, db, r);
+		wait_close_(tcp_a, da, r);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  UDP ベンチマーク @n
+				クライアント（B）が size バイトのデータグラムを送り、@n
+				サーバー（A）がエコーする。
+		@param[out]	r	結果
+	*/
+	//-----------------------------------------------------------------//
+	void bench_udp_(result_t& r)
+	{
+		auto& udp_a = net_a_.at_ethernet().at_ipv4().at_udp();
+		auto& udp_b = net_b_.at_ethernet().at_ipv4().at_udp();
+
+		// UDP は MAC の解決を行わないので、キャッシュを直接設定しておく
+		net_a_.at_ethernet().at_info().at_cash().insert(get_ip_(net_b_), ethd_b_.get_mac());
+		net_b_.at_ethernet().at_info().at_cash().insert(get_ip_(net_a_), ethd_a_.get_mac());
+
+		uint32_t da;
+		uint32_t db;
+		if(!udp_a.open(a_send_, sizeof(a_send_), a_recv_, sizeof(a_recv_), da)) return;
+		if(!udp_a.start(da, get_ip_(net_b_), UDP_PORT)) return;
+		if(!udp_b.open(b_send_, sizeof(b_send_), b_recv_, sizeof(b_recv_), db)) return;
+		if(!udp_b.start(db, get_ip_(net_a_), UDP_PORT + 1, UDP_PORT)) return;
+		++r.connects;
+
+		uint32_t size = opt_.size;
+		if(size > 1472) size = 1472;
+		for(uint32_t i = 0; i < size; ++i) {
+			work_[i] = 0x20 + (i % 95);
+		}
+
+		bool wait_echo = false;
+		uint32_t ref = 0;
+		auto start = counter_;
+		while(r.trans < opt_.count && (counter_ - start) < opt_.limit) {
+			if(!wait_echo) {
+				if(udp_b.send(db, work_, size) == static_cast<int>(size)) {
+					ref = counter_;
+					wait_echo = true;
+				}
+			} else if(udp_b.get_recv_length(db) >= static_cast<int>(size)) {
+				udp_b.recv(db, work_, size);
+				++r.trans;
+				r.bytes += size * 2;
+				auto lt = counter_ - ref;
+				r.latency += lt;
+				if(r.latency_max < lt) r.latency_max = lt;
+				wait_echo = false;
+			} else if((counter_ - ref) >= 100) {  // 1 sec でロストとみなす
+				++r.stalls;
+				wait_echo = false;
+			}
+
+			int l = udp_a.get_recv_length(da);
+			if(l > 0) {
+				uint8_t tmp[1536];
+				if(l > static_cast<int>(sizeof(tmp))) l = sizeof(tmp);
+				l = udp_a.recv(da, tmp, l);
+				if(l > 0) udp_a.send(da, tmp, l);
+			}
+
+			step_();
+		}
+		r.ticks = counter_ - start;
+
+		udp_a.close(da);
+		udp_b.close(db);
+		step_();
+	}
+
+
+	struct http_res_t {
+		int			status = 0;
+		std::string	head;
+		std::string	body;
+	};
+
+	// 受信したバイト列から、応答を一つ取り出す（ボディは Content-Length 分）
+	bool parse_res_(std::string& in, http_res_t& res)
+	{
+		auto e = in.find("\r\n\r\n");
+		if(e == std::string::npos || in.size() < 12) return false;
+		uint32_t len = 0;
+		auto p = in.find("Content-Length: ");
+		if(p != std::string::npos && p < e) len = std::atoi(&in[p + 16]);
+		if(in.size() < (e + 4 + len)) return false;
+		res.status = std::atoi(&in[9]);  // "HTTP/1.1 200 OK"
+		res.head = in.substr(0, e + 2);
+		res.body = in.substr(e + 4, len);
+		in.erase(0, e + 4 + len);
+		return true;
+	}
+
+
+	std::string header_(const http_res_t& res, const char* key)
+	{
+		std::string k = std::string(key) + ": ";
+		auto p = res.head.find(k);
+		if(p == std::string::npos) return "";
+		p += k.size();
+		return res.head.substr(p, res.head.find("\r\n", p) - p);
+	}
+
+
+	// パイプライン（全てのリクエストを一度に送る）で、n 個の応答を受け取る
+	bool http_pipe_(NET_MAIN::ETHERNET::IPV4::TCP& tcp, uint32_t desc, const std::string& req, uint32_t n,
+		std::vector<http_res_t>& out)
+	{
+		out.clear();
+		std::string in;
+		uint32_t sent = 0;
+		uint32_t n_loop = 0;
+		while(out.size() < n && n_loop < CLOSE_LIMIT) {
+			if(sent < req.size()) {
+				int l = tcp.send(desc, &req[sent], req.size() - sent);
+				if(l > 0) sent += l;
+			}
+			char tmp[1536];
+			int l = tcp.recv(desc, tmp, sizeof(tmp));
+			if(l > 0) {
+				in.append(tmp, l);
+				n_loop = 0;
+			}
+			http_res_t res;
+			while(out.size() < n && parse_res_(in, res)) {
+				out.push_back(res);
+			}
+			http_.service(80);
+			step_();
+			++n_loop;
+		}
+		return out.size() == n && in.empty();
+	}
+
+
+	std::vector<std::string>	http_log_;
+	uint32_t	http_error_ = 0;
+
+	void http_check_(bool ok, const char* name, const http_res_t& res)
+	{
+		char tmp[256];
+		snprintf(tmp, sizeof(tmp), "  %-28s %s (%d, %u bytes)", name, ok ? "OK" : "NG",
+			res.status, static_cast<uint32_t>(res.body.size()));
+		http_log_.push_back(tmp);
+		if(!ok) ++http_error_;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  HTTP サーバー試験 @n
+				サーバー（A）は作業ディレクトリ（ＳＤカードの代わり）のファイルを @n
+				送り、クライアント（B）はパイプライン化したリクエストで、@n
+				200/206/416/404 と、ETag、If-Modified-Since による 304 を確認する。
+		@param[out]	r	結果
+		@return 全て正常なら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool bench_http_(result_t& r)
+	{
+		static const uint32_t DATA_SIZE = 20000;  // 送信バッファ、クラスタより大きくする
+
+		char dir[] = "/tmp/net2_bench.XXXXXX";
+		if(mkdtemp(dir) == nullptr) return false;
+		sdc_.root = dir;
+		sdc_.mtime = 1500000000;  // 2017/07/14 02:40:00 GMT
+		std::string data;
+		for(uint32_t i = 0; i < DATA_SIZE; ++i) {
+			data += static_cast<char>((i * 7 + (i >> 8)) & 0xff);
+		}
+		std::string file = sdc_.root + "/data.bin";
+		FILE* fp = fopen(file.c_str(), "wb");
+		if(fp == nullptr) return false;
+		fwrite(data.data(), 1, data.size(), fp);
+		fclose(fp);
+
+		fatfs_.csize = 8;  // 4096 バイト・クラスタ
+		http_.set_file("/data.bin", "data", "/data.bin");
+		http_.start("net2_bench");
+
+		auto& tcp_b = net_b_.at_ethernet().at_ipv4().at_tcp();
+		uint32_t db = TCPN;
+		static uint8_t send[8192];
+		static uint8_t recv[32768];
+		auto start = counter_;
+		bool ok = false;
+		for(uint32_t i = 0; i < 100; ++i) {  // サーバーのリッスンを待つ
+			http_.service(80);
+			step_();
+		}
+		if(tcp_b.open(send, sizeof(send), recv, sizeof(recv), db)
+			&& tcp_b.start(db, get_ip_(net_a_), 80, false)) {
+			uint32_t n = 0;
+			while(!tcp_b.connected(db) && n < CONNECT_LIMIT) {
+				http_.service(80);
+				step_();
+				++n;
+			}
+			ok = tcp_b.connected(db);
+		}
+		if(!ok) {
+			http_log_.push_back("  connect NG");
+			++http_error_;
+			return false;
+		}
+		++r.connects;
+
+		std::vector<http_res_t> res;
+		auto ref = counter_;
+		ok = http_pipe_(tcp_b, db,
+			"GET /data.bin HTTP/1.1\r\nHost: a\r\n\r\n"
+			"GET /data.bin HTTP/1.1\r\nHost: a\r\nRange: bytes=100-1099\r\n\r\n"
+			"GET /data.bin HTTP/1.1\r\nHost: a\r\nRange: bytes=30000-\r\n\r\n"
+			"GET /none.bin HTTP/1.1\r\nHost: a\r\n\r\n", 4, res);
+		auto lt = counter_ - ref;
+		r.latency += lt;
+		r.latency_max = lt;
+		if(ok) {
+			r.trans += 4;
+			r.bytes += res[0].body.size() + res[1].body.size();
+			http_check_(res[0].status == 200 && res[0].body == data, "GET (200, body)", res[0]);
+			http_check_(res[1].status == 206 && res[1].body == data.substr(100, 1000)
+				&& header_(res[1], "Content-Range") == "bytes 100-1099/20000", "Range (206, body)", res[1]);
+			http_check_(res[2].status == 416
+				&& header_(res[2], "Content-Range") == "bytes */20000", "Range over (416)", res[2]);
+			http_check_(res[3].status == 404, "GET none (404)", res[3]);
+
+			auto etag = header_(res[0], "ETag");
+			auto date = header_(res[0], "Last-Modified");
+			std::string req = "GET /data.bin HTTP/1.1\r\nHost: a\r\nIf-None-Match: " + etag + "\r\n\r\n";
+			req += "GET /data.bin HTTP/1.1\r\nHost: a\r\nIf-Modified-Since: " + date + "\r\n\r\n";
+			req += "GET /data.bin HTTP/1.1\r\nHost: a\r\nIf-None-Match: \"other\"\r\n"
+				"Range: bytes=19000-\r\nConnection: close\r\n\r\n";
+			ref = counter_;
+			ok = http_pipe_(tcp_b, db, req, 3, res);
+			lt = counter_ - ref;
+			r.latency += lt;
+			if(r.latency_max < lt) r.latency_max = lt;
+			if(ok) {
+				r.trans += 3;
+				r.bytes += res[2].body.size();
+				http_check_(res[0].status == 304 && res[0].body.empty(), "If-None-Match (304)", res[0]);
+				http_check_(res[1].status == 304 && res[1].body.empty(), "If-Modified-Since (304)", res[1]);
+				http_check_(res[2].status == 206 && res[2].body == data.substr(19000), "Range, close (206)", res[2]);
+				// 「Connection: close」なので、サーバーがクローズする
+				uint32_t n = 0;
+				while(!tcp_b.is_fin(db) && n < CLOSE_LIMIT) {
+					http_.service(80);
+					step_();
+					++n;
+				}
+				http_check_(tcp_b.is_fin(db), "server close (FIN)", res[2]);
+			}
+		}
+		if(!ok) {
+			http_log_.push_back("  pipeline NG (response missing or extra bytes)");
+			++http_error_;
+		}
+		tcp_b.close(db);
+		for(uint32_t i = 0; i < CLOSE_LIMIT && tcp_b.probe(db); ++i) {
+			http_.service(80);
+			step_();
+		}
+		r.ticks = counter_ - start;
+
+		unlink(file.c_str());
+		rmdir(dir);
+		return http_error_ == 0;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  TAP デバイスに net2 スタックを接続して、TCP/UDP エコー・サーバー @n
+				として動かす（外部ツールからの負荷試験用）
+	*/
+	//-----------------------------------------------------------------//
+	int run_tap_()
+	{
+		static TAPD tapd;
+		if(!tapd.attach(opt_.tap.c_str())) {
+			utils::format("Can't attach TAP device: '%s'\n") % opt_.tap.c_str();
+			return -1;
+		}
+		static NET_TAP net(tapd);
+		static const uint8_t mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0A };
+		if(!net.start(mac)) return -1;
+
+		auto& tcp = net.at_ethernet().at_ipv4().at_tcp();
+		auto& udp = net.at_ethernet().at_ipv4().at_udp();
+		uint32_t dt = TCPN;
+		uint32_t du = UDPN;
+		bool udp_open = false;
+
+		auto ref = std::chrono::steady_clock::now();
+		while(1) {
+			// 受信フレームは即座に処理し、サービスは実時間 10ms 毎
+			net.process();
+			auto now = std::chrono::steady_clock::now();
+			if(std::chrono::duration_cast<std::chrono::milliseconds>(now - ref).count() < 10) {
+				usleep(100);
+				continue;
+			}
+			ref = now;
+			++counter_;
+			net.service();
+			if(!net.check_main()) continue;
+
+			if(!udp_open) {
+				if(udp.open(a_send_, sizeof(a_send_), a_recv_, sizeof(a_recv_), du)) {
+					udp_open = udp.start(du, net::ip_adrs(), UDP_PORT);
+				}
+			}
+			if(!tcp.probe(dt)) {
+				if(tcp.open(b_send_, sizeof(b_send_), b_recv_, sizeof(b_recv_), dt)) {
+					if(!tcp.start(dt, net::ip_adrs(), TCP_PORT, true)) tcp.close(dt);
+				}
+			} else if(tcp.is_fin(dt)) {
+				tcp.close(dt);
+			} else if(tcp.connected(dt)) {
+				uint8_t tmp[1536];
+				int l = tcp.recv(dt, tmp, sizeof(tmp));
+				if(l > 0) tcp.send(dt, tmp, l);
+			}
+			if(udp_open) {
+				uint8_t tmp[1536];
+				int l = udp.recv(du, tmp, sizeof(tmp));
+				if(l > 0) udp.send(du, tmp, l);
+			}
+		}
+		return 0;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  従来の１６ビット単位のサム計算（比較用）
+	*/
+	//-----------------------------------------------------------------//
+	uint16_t legacy_sum_(const void* src, uint16_t len, uint16_t sumorg = 0)
+	{
+		const uint8_t* d = static_cast<const uint8_t*>(src);
+		uint32_t sum = sumorg;
+		while(len > 1) {
+			sum += (d[0] << 8) | d[1];
+			d += 2;
+			len -= 2;
+		}
+		if(len > 0) {
+			sum += d[0] << 8;
+		}
+		sum = (sum & 0xffff) + (sum >> 16);
+		return ~((sum & 0xffff) + (sum >> 16));
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  チェック・サム計算のマイクロ・ベンチマーク @n
+				従来の計算と結果を照合し、サイズ毎の処理速度を比較する
+		@return 結果が一致しない場合「false」
+	*/
+	//-----------------------------------------------------------------//
+	bool bench_csum_()
+	{
+		static const uint16_t sizes[] = { 20, 40, 64, 128, 256, 512, 576, 1024, 1460 };
+		static uint8_t src[1536 + 16];
+		static uint8_t dst[1536 + 16];
+		uint32_t seed = 12345;
+		for(uint32_t i = 0; i < sizeof(src); ++i) {
+			seed = seed * 1103515245 + 12345;
+			src[i] = seed >> 16;
+		}
+
+		// 奇数長、非整列、初期値、コピー、差分更新の照合
+		bool ok = true;
+		for(uint16_t len = 0; len <= 1500; ++len) {
+			for(uint32_t ofs = 0; ofs < 4; ++ofs) {
+				uint16_t org = len * 7;
+				uint16_t a = legacy_sum_(&src[ofs], len, org);
+				if(a != net::tools::calc_sum(&src[ofs], len, org)) ok = false;
+				uint16_t c = net::tools::copy_sum(&dst[ofs], &src[ofs], len, org);
+				if(a != static_cast<uint16_t>(~c)) ok = false;
+				if(std::memcmp(&dst[ofs], &src[ofs], len) != 0) ok = false;
+			}
+			if(len >= 2) {
+				uint16_t old = legacy_sum_(src, len);
+				uint16_t w = (src[0] << 8) | src[1];
+				uint16_t nw = w ^ len;
+				std::memcpy(dst, src, len);
+				dst[0] = nw >> 8;
+				dst[1] = nw;
+				if(net::tools::update_sum(old, w, nw) != legacy_sum_(dst, len)) ok = false;
+			}
+		}
+		utils::format("checksum verify: %s%s\n") % (ok ? "OK" : "NG")
+#if defined(__SSE2__)
+			% " (SSE2)";
+#else
+			% "";
+#endif
+
+		utils::format("  size   legacy(MB/s)  calc_sum(MB/s)  copy_sum(MB/s)\n");
+		volatile uint16_t sink = 0;
+		for(auto len : sizes) {
+			uint32_t loop = (64 * 1024 * 1024) / len;
+			double mbs[3];
+			for(uint32_t k = 0; k < 3; ++k) {
+				auto t0 = std::chrono::steady_clock::now();
+				for(uint32_t i = 0; i < loop; ++i) {
+					const uint8_t* p = &src[i & 15];
+					if(k == 0) sink = legacy_sum_(p, len);
+					else if(k == 1) sink = net::tools::calc_sum(p, len);
+					else sink = net::tools::copy_sum(dst, p, len);
+				}
+				auto t1 = std::chrono::steady_clock::now();
+				double sec = std::chrono::duration<double>(t1 - t0).count();
+				mbs[k] = sec > 0.0 ? (static_cast<double>(loop) * len / sec / 1e6) : 0.0;
+			}
+			utils::format("  %4d  %12.1f  %14.1f  %14.1f\n") % len
+				% static_cast<float>(mbs[0]) % static_cast<float>(mbs[1]) % static_cast<float>(mbs[2]);
+		}
+		(void)sink;
+		return ok;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  MAC キャッシュの計測（一つのサイズ）
+		@param[in]	cash	キャッシュ
+		@param[in]	num		登録するホスト数
+		@param[out]	hit		ヒット時の検索時間（ns）
+		@param[out]	miss	ミス時の検索時間（ns）
+		@param[out]	churn	ホスト数が倍の場合の、検索＋登録時間（ns）
+		@return 検索結果の MAC が正しければ「true」
+	*/
+	//-----------------------------------------------------------------//
+	template <class CASH>
+	bool bench_cash_sub_(CASH& cash, uint32_t num, double& hit, double& miss, double& churn)
+	{
+		static const uint32_t LOOP = 1000000;
+		auto host = [](uint32_t i) { return net::ip_adrs(10, 0, 1 + (i / 200), 1 + (i % 200)); };
+		uint8_t mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+		bool ok = true;
+		cash.clear();
+		for(uint32_t i = 0; i < num; ++i) {
+			mac[4] = i >> 8;
+			mac[5] = i;
+			cash.insert(host(i), mac);
+		}
+		for(uint32_t i = 0; i < num; ++i) {
+			auto idx = cash.lookup(host(i));
+			if(!cash.is_valid(idx) || cash[idx].mac[5] != static_cast<uint8_t>(i)) ok = false;
+		}
+
+		uint32_t seed = 1;
+		uint32_t found = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < LOOP; ++i) {
+			seed = seed * 1103515245 + 12345;
+			if(cash.is_valid(cash.lookup(host((seed >> 16) % num)))) ++found;
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < LOOP; ++i) {
+			seed = seed * 1103515245 + 12345;
+			if(cash.is_valid(cash.lookup(host(num + (seed >> 16) % num)))) ++found;
+		}
+		auto t2 = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < LOOP; ++i) {
+			seed = seed * 1103515245 + 12345;
+			auto ipa = host((seed >> 16) % (num * 2));
+			if(!cash.is_valid(cash.lookup(ipa))) {
+				cash.insert(ipa, mac);
+			}
+			if((i % 64) == 0) cash.update();
+		}
+		auto t3 = std::chrono::steady_clock::now();
+		if(found != LOOP) ok = false;
+
+		hit   = std::chrono::duration<double, std::nano>(t1 - t0).count() / LOOP;
+		miss  = std::chrono::duration<double, std::nano>(t2 - t1).count() / LOOP;
+		churn = std::chrono::duration<double, std::nano>(t3 - t2).count() / LOOP;
+		return ok;
+	}
+
+
+	template <uint32_t SIZE>
+	bool bench_cash_size_()
+	{
+		static net::legacy_mac_cash<SIZE> legacy;
+		static net::mac_cash<SIZE> hashed;
+		double h[2], m[2], c[2];
+		bool ok = bench_cash_sub_(legacy, SIZE, h[0], m[0], c[0]);
+		ok &= bench_cash_sub_(hashed, SIZE, h[1], m[1], c[1]);
+		utils::format("  %4d  %7.1f %7.1f  %7.1f %7.1f  %7.1f %7.1f  %s\n") % SIZE
+			% static_cast<float>(h[0]) % static_cast<float>(h[1])
+			% static_cast<float>(m[0]) % static_cast<float>(m[1])
+			% static_cast<float>(c[0]) % static_cast<float>(c[1])
+			% (ok ? "OK" : "NG");
+		return ok;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  MAC キャッシュのマイクロ・ベンチマーク @n
+				従来の線形探索と、ハッシュ表の検索時間を比較する
+		@return 検索結果が正しくない場合「false」
+	*/
+	//-----------------------------------------------------------------//
+	bool bench_cash_()
+	{
+		utils::format("MAC cash lookup (ns/op): legacy / hashed\n");
+		utils::format("  size      hit            miss           churn(x2 hosts)\n");
+		bool ok = bench_cash_size_<16>();
+		ok &= bench_cash_size_<64>();
+		ok &= bench_cash_size_<256>();
+		return ok;
+	}
+
+
+	void help_(const char* cmd)
+	{
+		utils::format("net2 load test (host) Version %s\n") % version_;
+		utils::format("usage:\n");
+		utils::format("    %s [options]\n") % cmd;
+		utils::format("    -tcp            TCP request/echo transactions (default)\n");
+		utils::format("    -udp            UDP datagram/echo transactions\n");
+		utils::format("    -n COUNT        number of transactions (default %d)\n") % opt_.count;
+		utils::format("    -s SIZE         payload bytes per request (default %d)\n") % opt_.size;
+		utils::format("    -reconnect      open/close TCP connection per transaction\n");
+		utils::format("    -zc             TCP echo server uses zero copy borrow/prepare/commit\n");
+		utils::format("    -bulk           TCP bulk transfer of COUNT x SIZE bytes (B -> A)\n");
+		utils::format("    -http           HTTP server on A (stub SD card), pipelined GET/range/304 from B\n");
+		utils::format("    -delay TICKS    one way wire delay (10ms ticks)\n");
+		utils::format("    -loss PERMILLE  wire frame loss rate (1/1000)\n");
+		utils::format("    -csum           checksum micro benchmark (legacy vs word-at-a-time)\n");
+		utils::format("    -arp            MAC cash micro benchmark (legacy vs hashed)\n");
+		utils::format("    -tap IFNAME     run the stack as echo server on a TAP device\n");
+		utils::format("    -verbose        show net2 debug output\n");
+	}
+}
+
+
+extern "C" {
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	仮想タイマーカウンタの取得（10ms 単位）
+		@return タイマーカウンタ
+	 */
+	//-----------------------------------------------------------------//
+	uint32_t get_counter() { return counter_; }
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  GMT 時間の取得
+		@return GMT 時間
+	*/
+	//-----------------------------------------------------------------//
+	time_t get_time() { return 0; }
+
+
+	time_t mktime_gmt(const struct tm* tmp)
+	{
+		struct tm t = *tmp;
+		return timegm(&t);
+	}
+
+
+	const char* get_wday(uint8_t idx)
+	{
+		static const char* wday[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+		return wday[idx % 7];
+	}
+
+
+	const char* get_mon(uint8_t idx)
+	{
+		static const char* mon[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+			"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+		return mon[idx % 12];
+	}
+
+
+	int tcp_send(uint32_t desc, const void* src, uint32_t len)
+	{
+		auto& tcp = net_a_.at_ethernet().at_ipv4().at_tcp();
+		return tcp.send(desc, src, len);
+	}
+}
+
+
+// FatFs の代わり（ホストのファイルを読む）
+FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode)
+{
+	FILE* f = fopen(path, "rb");
+	if(f == nullptr) return FR_NO_FILE;
+	fseek(f, 0, SEEK_END);
+	fp->obj.fs = &fatfs_;
+	fp->obj.objsize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	fp->fptr = 0;
+	host_fp_[fp] = f;
+	return FR_OK;
+}
+
+
+FRESULT f_close(FIL* fp)
+{
+	auto it = host_fp_.find(fp);
+	if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+	fclose(it->second);
+	host_fp_.erase(it);
+	return FR_OK;
+}
+
+
+FRESULT f_lseek(FIL* fp, FSIZE_t ofs)
+{
+	auto it = host_fp_.find(fp);
+	if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+	if(ofs > fp->obj.objsize) ofs = fp->obj.objsize;
+	fseek(it->second, ofs, SEEK_SET);
+	fp->fptr = ofs;
+	return FR_OK;
+}
+
+
+FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br)
+{
+	auto it = host_fp_.find(fp);
+	if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+	*br = fread(buff, 1, btr, it->second);
+	fp->fptr += *br;
+	return FR_OK;
+}
+
+
+int main(int argc, char* argv[])
+{
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-tcp") opt_.tcp = true;
+		else if(s == "-udp") opt_.tcp = false;
+		else if(s == "-reconnect") opt_.reconnect = true;
+		else if(s == "-verbose") opt_.verbose = true;
+		else if(s == "-zc") opt_.zero_copy = true;
+		else if(s == "-bulk") opt_.bulk = true;
+		else if(s == "-http") opt_.http = true;
+		else if(s == "-delay" && (i + 1) < argc) opt_.delay = std::atoi(argv[++i]);
+		else if(s == "-loss" && (i + 1) < argc) opt_.loss = std::atoi(argv[++i]);
+		else if(s == "-n" && (i + 1) < argc) opt_.count = std::atoi(argv[++i]);
+		else if(s == "-s" && (i + 1) < argc) opt_.size = std::atoi(argv[++i]);
+		else if(s == "-tap" && (i + 1) < argc) opt_.tap = argv[++i];
+		else if(s == "-csum") return bench_csum_() ? 0 : -1;
+		else if(s == "-arp") return bench_cash_() ? 0 : -1;
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+	if(opt_.size == 0 || opt_.size > 4000) opt_.size = 256;
+
+	if(!opt_.tap.empty()) {
+		return run_tap_();
+	}
+
+	// net2 のデバッグ出力（標準出力）を抑止
+	int out = dup(1);
+	if(!opt_.verbose) {
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, 1);
+		close(null);
+	}
+
+	result_t r;
+	bool start = start_();
+	auto t0 = std::chrono::steady_clock::now();
+	if(start) {
+		wire_ab_.set_feature(opt_.delay, opt_.loss, 1);
+		wire_ba_.set_feature(opt_.delay, opt_.loss, 2);
+		if(opt_.http) bench_http_(r);
+		else if(opt_.bulk) bench_bulk_(r);
+		else if(opt_.tcp) bench_tcp_(r);
+		else bench_udp_(r);
+	}
+	auto t1 = std::chrono::steady_clock::now();
+
+	dup2(out, 1);
+	close(out);
+
+	if(!start) {
+		utils::format("net2 start fail\n");
+		return -1;
+	}
+
+	double sec = std::chrono::duration<double>(t1 - t0).count();
+	double vsec = static_cast<double>(r.ticks) / 100.0;
+	if(opt_.http) {
+		utils::format("HTTP: %d requests (pipelined), %s\n") % r.trans
+			% (http_error_ == 0 ? "OK" : "NG");
+		for(const auto& l : http_log_) {
+			utils::format("%s\n") % l.c_str();
+		}
+	} else {
+		utils::format("%s: %d transactions, %d bytes/request%s%s\n")
+			% (opt_.bulk ? "TCP bulk" : (opt_.tcp ? "TCP" : "UDP")) % r.trans % opt_.size
+			% (opt_.reconnect ? " (reconnect)" : "")
+			% (opt_.zero_copy ? " (zero copy)" : "");
+	}
+	utils::format("  connects: %d, stalls: %d\n") % r.connects % r.stalls;
+	if(r.closes > 0) {
+		utils::format("  close: %.2f avg, %d max (10ms ticks)\n")
+			% (static_cast<float>(r.close_ticks) / static_cast<float>(r.closes))
+			% r.close_max;
+	}
+	if(r.trans > 0) {
+		utils::format("  latency: %.2f avg, %d max (10ms ticks)\n")
+			% (static_cast<float>(r.latency) / static_cast<float>(r.trans))
+			% r.latency_max;
+	}
+	utils::format("  virtual: %.2f sec, %.1f trans/sec, %.1f KB/sec\n")
+		% static_cast<float>(vsec)
+		% static_cast<float>(vsec > 0.0 ? r.trans / vsec : 0.0)
+		% static_cast<float>(vsec > 0.0 ? r.bytes / vsec / 1024.0 : 0.0);
+	utils::format("  wall:    %.3f sec, %.1f trans/sec, %.1f ticks/sec\n")
+		% static_cast<float>(sec)
+		% static_cast<float>(sec > 0.0 ? r.trans / sec : 0.0)
+		% static_cast<float>(sec > 0.0 ? r.ticks / sec : 0.0);
+	utils::format("  wire A->B: %d frames, %d bytes / B->A: %d frames, %d bytes\n")
+		% wire_ab_.get_frames() % wire_ab_.get_bytes()
+		% wire_ba_.get_frames() % wire_ba_.get_bytes();
+	utils::format("  wire delay: %d ticks, loss: %d/1000, lost A->B: %d, B->A: %d\n")
+		% opt_.delay % opt_.loss % wire_ab_.get_lost() % wire_ba_.get_lost();
+	utils::format("  send full: A(%d), B(%d)\n")
+		% ethd_a_.get_stat().send_full_ % ethd_b_.get_stat().send_full_;
+	utils::format("  TCP re-send: A(%d), B(%d)\n")
+		% net_a_.get_info().re_send_count_ % net_b_.get_info().re_send_count_;
+
+	return http_error_ == 0 ? 0 : 1;
+}
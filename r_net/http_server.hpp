@@ -17,6 +17,8 @@
 #include "common/sdc_io.hpp"
 #include "common/fixed_string.hpp"
 #include "common/color.hpp"
+#include "common/web_pack.hpp"
+#include "common/http_utils.hpp"
 
 // #define HTTP_DEBUG
 
@@ -32,9 +34,11 @@ namespace net {
 		@param[in]	SDC	ＳＤカードファイル操作インスタンス
 		@param[in]	MAX_LINK	登録リンクの最大数
 		@param[in]	MAX_SIZE	文字列、一時バッファの最大数
+		@param[in]	WEB_PACK	Web パック・クラス
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class SDC, uint32_t MAX_LINK = 16, uint32_t MAX_SIZE = 4096>
+	template <class SDC, uint32_t MAX_LINK = 16, uint32_t MAX_SIZE = 4096,
+		class WEB_PACK = utils::web_pack<SDC> >
 	class http_server {
 	public:
 		typedef utils::line_manage<2048, 20> LINE_MAN;
@@ -71,6 +75,8 @@ namespace net {
 
 		LINE_MAN		line_man_;
 
+		WEB_PACK*		pack_;
+
 		time_t			last_modified_;
 		char			server_name_[32];
 		uint32_t		timeout_;
@@ -155,6 +161,19 @@ namespace net {
 			return -1;
 		}
 
+
+		// ヘッダーの値を探す（キーの大文字、小文字は区別しない）
+		const char* find_header_(const char* key) const
+		{
+			for(uint32_t i = 1; i < line_man_.size(); ++i) {
+				const char* p = line_man_[i];
+				if(p[0] == 0) break;  // ヘッダーの終端
+				const char* v = utils::http_utils::match_key(p, key);
+				if(v != nullptr) return v;
+			}
+			return nullptr;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -164,6 +183,7 @@ namespace net {
 		*/
 		//-----------------------------------------------------------------//
 		http_server(ethernet& e, SDC& sdc) : eth_(e), sdc_(sdc), http_(e), line_man_(0x0a),
+			pack_(nullptr),
 			last_modified_(0), server_name_{ 0 }, timeout_(15), max_(60),
 			count_(0), disconnect_loop_(0),
 			link_num_(0), link_{ },
@@ -325,6 +345,10 @@ namespace net {
 //			}
 
 			int idx = find_link_(path, cgi);
+			if(idx < 0 && !cgi && send_asset(path)) {
+				return true;
+			}
+
 			uint32_t org = http_format::chaout().size();
 			uint32_t clp = 0;
 			bool ret = false;
@@ -495,18 +519,7 @@ namespace net {
 
 			http_format::chaout().clear();
 			http_format("HTTP/1.1 200 OK\n");
-			http_format("Content-Type: ");
-			const char* ext = strrchr(path, '.');
-			if(ext != nullptr) {
-				++ext;
-				if(strcmp(ext, "png") == 0 || strcmp(ext, "jpeg") == 0 || strcmp(ext, "jpg") == 0) {
-					http_format("image/%s\n") % ext;
-				} else {
-					http_format("text/%s\n") % ext;
-				}
-			} else {
-				http_format("text/plain\n");
-			}
+			utils::http_utils::make_content_type<http_format>(path);
 			http_format("Content-Length: %u\n") % fsz;
 			http_format("Connection: close\n\n");
 			http_format::chaout().flush();				
@@ -522,6 +535,87 @@ namespace net {
 				total += len;
 			}
 			fclose(fp);
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  Web パックを設定 @n
+					登録リンクに無いパスは、Web パックから探して送る
+			@param[in]	pack	Web パック（nullptr で無効）
+		*/
+		//-----------------------------------------------------------------//
+		void set_web_pack(WEB_PACK* pack) { pack_ = pack; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  Web パックのアセット送信 @n
+					クライアントが gzip を受け付け、圧縮データがあれば @n
+					「Content-Encoding: gzip」で送る。@n
+					「/」で終わるパスは「index.html」を補う。
+			@param[in]	path	パス
+			@return パックにあれば「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool send_asset(const char* path)
+		{
+			if(pack_ == nullptr || !pack_->is_open()) return false;
+
+			char tmp[256];
+			uint32_t l = std::strlen(path);
+			if(l > 0 && path[l - 1] == '/' && (l + 10) < sizeof(tmp)) {
+				std::strcpy(tmp, path);
+				std::strcat(tmp, "index.html");
+				path = tmp;
+			}
+
+			typename WEB_PACK::asset_t a;
+			bool gzip = utils::http_utils::has_token(find_header_("Accept-Encoding"), "gzip");
+			if(!pack_->open_asset(path, gzip, a)) {
+				return false;
+			}
+			const auto& e = pack_->get_entry(a.idx);
+			char etag[24];
+			utils::sformat("\"%08x%s\"", etag, sizeof(etag)) % e.crc % (a.gz ? "-gz" : "");
+			const char* inm = find_header_("If-None-Match");
+			bool match = inm != nullptr && std::strstr(inm, etag) != nullptr;
+
+			http_format::chaout().clear();
+			if(match) {
+				http_format("HTTP/1.1 304 Not Modified\n");
+			} else {
+				http_format("HTTP/1.1 200 OK\n");
+			}
+			http_format("ETag: %s\n") % etag;
+			if(e.gz_size > 0) {
+				http_format("Vary: Accept-Encoding\n");
+			}
+			if(!match) {
+				utils::http_utils::make_content_type<http_format>(path);
+				if(a.gz) {
+					http_format("Content-Encoding: gzip\n");
+				}
+				http_format("Content-Length: %u\n") % a.size;
+			}
+			http_format("Connection: close\n\n");
+			http_format::chaout().flush();
+
+			debug_format("HTTP Server: asset '%s' (%d)%s\n") % path % a.size % (a.gz ? " gzip" : "");
+
+			if(match) return true;
+
+			if(a.ram != nullptr) {  // キャッシュ上のデータは、そのまま送る
+				http_.write(a.ram, a.size);
+				return true;
+			}
+			uint8_t buff[1024];
+			uint32_t len;
+			while((len = pack_->read(a, buff, sizeof(buff))) > 0) {
+				http_.write(buff, len);
+			}
+			return true;
 		}
 
 
@@ -8,6 +8,8 @@
 */
 //=====================================================================//
 #include <iostream>
+#include <thread>
+#include <chrono>
 #include "rx_prog.hpp"
 #include "conf_in.hpp"
 #include "motsx_io.hpp"
@@ -20,6 +22,7 @@ namespace {
 	const std::string conf_file_ = "rx_prog.conf";
 	const uint32_t progress_num_ = 50;
 	const char progress_cha_ = '#';
+	const uint32_t verify_block_ = 1024;  ///< ベリファイで一度に読み出す最大サイズ
 
 	utils::conf_in conf_in_;
 	utils::motsx_io motsx_;
@@ -107,6 +110,8 @@ namespace {
 		std::string com_name;
 		bool	dp = false;
 
+		utils::strings	ports;	///< 複数のポートを指定した場合、並列に書き込む
+
 		std::string id_val;
 		bool	id = false;
 
@@ -117,6 +122,7 @@ namespace {
 		bool	erase = false;
 		bool	write = false;
 		bool	verify = false;
+		bool	delta = false;
 		bool	device_list = false;
 		bool	progress = false;
 		bool	erase_data = false;
@@ -148,6 +154,13 @@ namespace {
 		}
 
 
+		void add_port(const std::string& t) {
+			for(const auto& s : utils::split_text(t, ",")) {
+				if(!s.empty()) ports.push_back(s);
+			}
+		}
+
+
 		bool set_str(const std::string& t) {
 			bool ok = true;
 			if(br) {
@@ -157,7 +170,7 @@ namespace {
 				device = t;
 				dv = false;
 			} else if(dp) {
-				com_path = t;
+				add_port(t);
 				dp = false;
 			} else if(id) {
 				id_val = t;
@@ -175,6 +188,349 @@ namespace {
 	};
 
 
+	struct image_t {
+		std::vector<uint32_t>	pages;	///< 全ページ（消去、ベリファイ）
+		std::vector<uint32_t>	writes;	///< 書き込むページ（全て 0xFF のページを除く）
+	};
+	image_t image_;
+
+
+	void create_image_()
+	{
+		image_.pages.clear();
+		image_.writes.clear();
+		for(const auto& a : motsx_.create_area_map()) {
+			uint32_t adr = a.min_ & 0xffffff00;
+			while(adr <= a.max_) {
+				image_.pages.push_back(adr);
+				if(!motsx_.is_blank(adr)) {
+					image_.writes.push_back(adr);
+				}
+				if(adr == 0xffffff00) break;
+				adr += 256;
+			}
+		}
+	}
+
+
+	struct delta_t {
+		uint32_t	blocks = 0;		///< 比較したブロック数
+		uint32_t	skip = 0;		///< 一致していて、書き換えなかったブロック数
+		uint32_t	fill = 0;		///< 消去せずに、空きページへ書き足したブロック数
+		uint32_t	erase = 0;		///< 消去して、書き直したブロック数
+		uint32_t	pages = 0;		///< 書き込んだページ数
+		uint32_t	erase_blocks = 0;	///< ブロック消去が出来るブロック数
+		uint32_t	erase_pages = 0;	///< ブロック消去が出来るブロックのページ数
+		double		read_time = 0.0;	///< 読み出し（比較）時間
+		double		write_time = 0.0;	///< 消去、書き込み時間
+		double		erase_time = 0.0;	///< 消去時間（write_time に含む）
+	};
+
+
+	bool is_blank_(const uint8_t* p)
+	{
+		for(uint32_t i = 0; i < 256; ++i) {
+			if(p[i] != 0xff) return false;
+		}
+		return true;
+	}
+
+
+	double elapsed_(const std::chrono::steady_clock::time_point& st)
+	{
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+		return d.count();
+	}
+
+
+	bool write_pages_(rx::prog& prog_, const std::vector<uint32_t>& wr)
+	{
+		if(wr.empty()) return true;
+
+		if(!prog_.start_write(true)) {
+			return false;
+		}
+		for(auto a : wr) {
+			auto& mem = motsx_.get_memory(a);
+			if(!prog_.write(a, &mem[0])) {
+				return false;
+			}
+		}
+		return prog_.final_write();
+	}
+
+
+	// 消去ブロック毎にデバイスを読み出して比較し、異なるブロックだけを書き換える
+	bool delta_(rx::prog& prog_, bool progress, delta_t& dt)
+	{
+		if(progress) {
+			std::cout << "Delta:  " << std::flush;
+		}
+		page_t page;
+		std::vector<uint8_t> dev;
+		std::vector<uint32_t> wr;
+		std::vector<uint32_t> pend;
+		uint32_t i = 0;
+		while(i < image_.pages.size()) {
+			uint32_t adr = image_.pages[i];
+			uint32_t bsz = prog_.get_erase_block(adr);
+			uint32_t mask = ~((bsz == 0 ? 256 : bsz) - 1);
+			uint32_t n = 1;
+			while((i + n) < image_.pages.size() && (image_.pages[i + n] & mask) == (adr & mask)) {
+				++n;
+			}
+
+			// ブロック内の連続したページは、まとめて読み出す
+			auto st = std::chrono::steady_clock::now();
+			dev.resize(n * 256);
+			uint32_t j = 0;
+			while(j < n) {
+				uint32_t org = image_.pages[i + j];
+				uint32_t m = 1;
+				while((j + m) < n && (m * 256) < verify_block_ && image_.pages[i + j + m] == (org + m * 256)) {
+					++m;
+				}
+				if(!prog_.read_area(org, &dev[j * 256], m * 256)) {
+					return false;
+				}
+				j += m;
+			}
+			dt.read_time += elapsed_(st);
+
+			// 異なるページが消去状態なら、消去せずに書き足せる
+			wr.clear();
+			bool dirty = false;
+			uint32_t dirty_adr = 0;
+			for(j = 0; j < n; ++j) {
+				uint32_t a = image_.pages[i + j];
+				const auto& mem = motsx_.get_memory(a);
+				const uint8_t* d = &dev[j * 256];
+				if(std::memcmp(&mem[0], d, 256) == 0) continue;
+				if(is_blank_(d)) {
+					wr.push_back(a);
+				} else if(!dirty) {
+					dirty = true;
+					dirty_adr = a;
+				}
+			}
+
+			st = std::chrono::steady_clock::now();
+			++dt.blocks;
+			if(bsz != 0) {
+				++dt.erase_blocks;
+				dt.erase_pages += n;
+			}
+			if(dirty) {
+				if(bsz == 0) {
+					std::cerr << std::endl << boost::format("Erase required: %08X (block erase not supported)")
+						% dirty_adr << std::endl;
+					prog_.end();
+					return false;
+				}
+				// 消去されていないページで要求すると、ブロック全体が消去される
+				if(!prog_.erase_page(dirty_adr)) {
+					return false;
+				}
+				dt.erase_time += elapsed_(st);
+				wr.clear();
+				for(j = 0; j < n; ++j) {
+					uint32_t a = image_.pages[i + j];
+					if(!motsx_.is_blank(a)) wr.push_back(a);
+				}
+				++dt.erase;
+			} else if(wr.empty()) {
+				++dt.skip;
+			} else {
+				++dt.fill;
+			}
+			// ブロック消去が出来ない場合、途中で止まると中途半端に書き換わるので、
+			// 全ページの比較が済むまで書き足しを保留する
+			if(bsz == 0) {
+				pend.insert(pend.end(), wr.begin(), wr.end());
+			} else if(!write_pages_(prog_, wr)) {  // 次のブロックを読み出す前に、書き込みを完了させる
+				return false;
+			}
+			dt.pages += wr.size();
+			dt.write_time += elapsed_(st);
+
+			i += n;
+			page.n += n;
+			if(progress) {
+				progress_(image_.pages.size(), page);
+			}
+		}
+		auto st = std::chrono::steady_clock::now();
+		if(!write_pages_(prog_, pend)) {
+			return false;
+		}
+		dt.write_time += elapsed_(st);
+		if(progress) {
+			std::cout << std::endl << std::flush;
+		}
+		return true;
+	}
+
+
+	void delta_report_(const std::string& head, const delta_t& dt, int speed)
+	{
+		// 全て書き直した場合との差（書き込み時間は実測の平均、無ければ転送時間で見積もる）
+		double page_time = static_cast<double>(4 + 256 + 2) * 10.0 / speed;
+		if(dt.pages > 0) {
+			page_time = (dt.write_time - dt.erase_time) / dt.pages;
+		}
+		uint32_t skip = image_.writes.size() > dt.pages ? image_.writes.size() - dt.pages : 0;
+		double saved = skip * page_time - dt.read_time;
+		// 全て書き直す場合は、ページ毎にブランク・チェック（コマンド１４バイト、応答７バイト）して、
+		// 消去出来るブロックを全て消去する（消去時間は実測の平均）
+		saved += dt.erase_pages * static_cast<double>(14 + 7) * 10.0 / speed;
+		if(dt.erase > 0 && dt.erase_blocks > dt.erase) {
+			saved += (dt.erase_blocks - dt.erase) * (dt.erase_time / dt.erase);
+		}
+		std::cout << head << boost::format("Delta blocks: %d (skip: %d, fill: %d, erase: %d)")
+			% dt.blocks % dt.skip % dt.fill % dt.erase << std::endl;
+		std::cout << head << boost::format("Delta pages: %d / %d written, compare %.2f [s], write %.2f [s]")
+			% dt.pages % image_.writes.size() % dt.read_time % dt.write_time << std::endl;
+		std::cout << head << boost::format("Delta saved: %.2f [s] (estimated)") % saved << std::endl;
+	}
+
+
+	// Windwos系シリアル・ポート（COMx）の変換
+	std::string convert_port_(const std::string& path, bool verbose)
+	{
+		if(path.empty() || path[0] == '/') return path;
+
+		std::string s = utils::to_lower_text(path);
+		std::string out = path;
+		if(s.size() > 3 && s[0] == 'c' && s[1] == 'o' && s[2] == 'm') {
+			int val;
+			if(utils::string_to_int(&s[3], val)) {
+				if(val >= 1 ) {
+					--val;
+					out = "/dev/ttyS" + (boost::format("%d") % val).str();
+				}
+			}
+		}
+		if(verbose) {
+			std::cout << "# Serial port alias: " << path << " ---> " << out << std::endl;
+		}
+		return out;
+	}
+
+
+	// 一つのポートに対して、消去、書き込み、ベリファイを行う
+	bool program_(const options& opts, const std::string& port, int speed, const rx::protocol::rx_t& rx,
+		bool progress, delta_t& dt)
+	{
+		rx::prog prog_(opts.verbose);
+		if(!prog_.start(port, speed, rx)) {
+			prog_.end();
+			return false;
+		}
+
+		//=====================================
+		if(opts.delta) {  // delta (erase, write)
+			if(!delta_(prog_, progress, dt)) {
+				prog_.end();
+				return false;
+			}
+		}
+
+		//=====================================
+		if(opts.erase && !opts.delta) {  // erase
+			if(progress) {
+				std::cout << "Erase:  " << std::flush;
+			}
+			page_t page;
+			for(auto adr : image_.pages) {
+				if(progress) {
+					progress_(image_.pages.size(), page);
+				}
+				if(!prog_.erase_page(adr)) {  // 256 バイト単位で消去要求を送る
+					prog_.end();
+					return false;
+				}
+				++page.n;
+			}
+			if(progress) {
+				std::cout << std::endl << std::flush;
+			}
+		}
+
+		//=====================================
+		if(opts.write && !opts.delta) {  // write
+			if(!image_.writes.empty()) {
+				if(!prog_.start_write(true)) {
+					prog_.end();
+					return false;
+				}
+			}
+			if(progress) {
+				std::cout << "Write:  " << std::flush;
+			}
+			// 全て 0xFF のページは、消去状態と同じなので送らない
+			page_t page;
+			for(auto adr : image_.writes) {
+				if(progress) {
+					progress_(image_.writes.size(), page);
+				}
+				auto& mem = motsx_.get_memory(adr);
+				if(!prog_.write(adr, &mem[0])) {
+					prog_.end();
+					return false;
+				}
+				++page.n;
+			}
+			if(progress) {
+				std::cout << std::endl << std::flush;
+			}
+			if(!prog_.final_write()) {
+				prog_.end();
+				return false;
+			}
+		}
+
+		//=====================================
+		if(opts.verify) {  // verify
+			if(progress) {
+				std::cout << "Verify: " << std::flush;
+			}
+			// 連続したページは、まとめて読み出す
+			page_t page;
+			std::vector<uint8_t> src;
+			uint32_t i = 0;
+			while(i < image_.pages.size()) {
+				uint32_t org = image_.pages[i];
+				uint32_t n = 1;
+				while((i + n) < image_.pages.size() && (n * 256) < verify_block_
+					&& image_.pages[i + n] == (org + n * 256)) {
+					++n;
+				}
+				src.clear();
+				for(uint32_t j = 0; j < n; ++j) {
+					const auto& mem = motsx_.get_memory(org + j * 256);
+					src.insert(src.end(), mem.begin(), mem.end());
+				}
+				if(progress) {
+					progress_(image_.pages.size(), page);
+				}
+				if(!prog_.verify_area(org, &src[0], n * 256)) {
+					prog_.end();
+					return false;
+				}
+				i += n;
+				page.n += n;
+			}
+			if(progress) {
+				progress_(image_.pages.size(), page);
+				std::cout << std::endl << std::flush;
+			}
+		}
+
+		prog_.end();
+		return true;
+	}
+
+
 	void help_(const std::string& cmd)
 	{
 		using namespace std;
@@ -188,6 +544,7 @@ namespace {
 		cout << endl;
 		cout << "Options :" << endl;
 		cout << "    -P PORT,   --port=PORT     Specify serial port" << endl;
+		cout << "                               (PORT,PORT,... or repeat: program in parallel)" << endl;
 		cout << "    -s SPEED,  --speed=SPEED   Specify serial speed" << endl;
 		cout << "    -d DEVICE, --device=DEVICE Specify device name" << endl;
 		cout << "    -e, --erase                Perform a device erase to a minimum" << endl;
@@ -199,6 +556,7 @@ namespace {
 ///		cout << "    --area=ORG[:,]END          Specify read area" << endl;
 		cout << "    -v, --verify               Perform data verify" << endl;
 		cout << "    -w, --write                Perform data write" << endl;
+		cout << "    --delta                    Erase and write only blocks that differ" << endl;
 		cout << "    --progress                 display Progress output" << endl;
 		cout << "    --device-list              Display device list" << endl;
 		cout << "    --verbose                  Verbose output" << endl;
@@ -266,7 +624,7 @@ int main(int argc, char* argv[])
 				opts.device = &p[std::strlen("--device=")];
 			} else if(p == "-P") opts.dp = true;
 			else if(p.find("--port=") == 0) {
-				opts.com_path = &p[std::strlen("--port=")];
+				opts.add_port(&p[std::strlen("--port=")]);
 ///			} else if(p == "-a") {
 ///				opts.area = true;
 ///			} else if(p.find("--area=") == 0) {
@@ -283,6 +641,8 @@ int main(int argc, char* argv[])
 				opts.write = true;
 			} else if(p == "-v" || p == "--verify") {
 				opts.verify = true;
+			} else if(p == "--delta") {
+				opts.delta = true;
 			} else if(p == "--progress") {
 				opts.progress = true;
 			} else if(p == "--device-list") {
@@ -309,11 +669,18 @@ int main(int argc, char* argv[])
 			opts.help = true;
 		}
 	}
+	if(opts.ports.empty()) {
+		if(!opts.com_path.empty()) opts.ports.push_back(opts.com_path);
+	} else {
+		opts.com_path = opts.ports[0];
+	}
 	if(opts.verbose) {
 		std::cout << "# Platform: '" << opts.platform << '\'' << std::endl;
 		std::cout << "# Configuration file path: '" << conf_path << '\'' << std::endl;
 		std::cout << "# Device: '" << opts.device << '\'' << std::endl;
-		std::cout << "# Serial port path: '" << opts.com_path << '\'' << std::endl;
+		for(const auto& s : opts.ports) {
+			std::cout << "# Serial port path: '" << s << '\'' << std::endl;
+		}
 		std::cout << "# Serial port speed: " << opts.com_speed << std::endl;
 	}
 
@@ -339,7 +706,6 @@ int main(int argc, char* argv[])
 	}
 
 	// 入力ファイルの読み込み
-	uint32_t pageall = 0;
 	if(!opts.inp_file.empty()) {
 		if(opts.verbose) {
 			std::cout << "# Input file path: '" << opts.inp_file << '\'' << std::endl;
@@ -348,35 +714,19 @@ int main(int argc, char* argv[])
 			std::cerr << "Can't open input file: '" << opts.inp_file << "'" << std::endl;
 			return -1;
 		}
-		pageall = motsx_.get_total_page();
+		create_image_();
 		if(opts.verbose) {
 			motsx_.list_area_map("# ");
+			std::cout << "# Pages: " << image_.pages.size() << ", write: " << image_.writes.size()
+				<< " (skip blank: " << (image_.pages.size() - image_.writes.size()) << ")" << std::endl;
 		}
 	}
 
-    // Windwos系シリアル・ポート（COMx）の変換
-    if(!opts.com_path.empty() && opts.com_path[0] != '/') {
-		std::string s = utils::to_lower_text(opts.com_path);
-        if(s.size() > 3 && s[0] == 'c' && s[1] == 'o' && s[2] == 'm') {
-            int val;
-            if(utils::string_to_int(&s[3], val)) {
-                if(val >= 1 ) {
-                    --val;
-                    opts.com_name = opts.com_path;
-                    opts.com_path = "/dev/ttyS" + (boost::format("%d") % val).str();
-                }
-            }
-        }
+	for(auto& path : opts.ports) {
+		path = convert_port_(path, opts.verbose);
 		if(opts.verbose) {
-			std::cout << "# Serial port alias: " << opts.com_name << " ---> " << opts.com_path << std::endl;
+			std::cout << "# Serial port path: '" << path << '\'' << std::endl;
 		}
-    }
-	if(opts.com_path.empty()) {
-		std::cerr << "Serial port path not found." << std::endl;
-		return -1;
-	}
-	if(opts.verbose) {
-		std::cout << "# Serial port path: '" << opts.com_path << '\'' << std::endl;
 	}
 	int com_speed = 0;
 	if(!utils::string_to_int(opts.com_speed, com_speed)) {
@@ -384,7 +734,7 @@ int main(int argc, char* argv[])
 		return -1;		
 	}
 
-	if(!opts.erase && !opts.write && !opts.verify) return 0;
+	if(!opts.erase && !opts.write && !opts.verify && !opts.delta) return 0;
 //		&& opts.sequrity_set.empty() && !opts.sequrity_get && !opts.sequrity_release) return 0;
 
 	rx::protocol::rx_t rx;
@@ -419,112 +769,38 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	rx::prog prog_(opts.verbose);
-	if(!prog_.start(opts.com_path, com_speed, rx)) {
-		prog_.end();
-		return -1;
-	}
-
-	//=====================================
-	if(opts.erase) {  // erase
-		auto areas = motsx_.create_area_map();
-
-		if(opts.progress) {
-			std::cout << "Erase:  " << std::flush;
-		}
-
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				if(!prog_.erase_page(adr)) {  // 256 バイト単位で消去要求を送る
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
-		}
-		if(opts.progress) {
-			std::cout << std::endl << std::flush;
+	if(opts.ports.size() == 1) {
+		delta_t dt;
+		bool ok = program_(opts, opts.ports[0], com_speed, rx, opts.progress, dt);
+		if(ok && opts.delta) {
+			delta_report_("", dt, com_speed);
 		}
+		return ok ? 0 : -1;
 	}
 
-	//=====================================
-	if(opts.write) {  // write
-		auto areas = motsx_.create_area_map();
-		if(!areas.empty()) {
-			if(!prog_.start_write(true)) {
-				prog_.end();
-				return -1;
-			}
-		}
-		
-		if(opts.progress) {
-			std::cout << "Write:  " << std::flush;
-		}
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
-				auto mem = motsx_.get_memory(adr);
-				if(!prog_.write(adr, &mem[0])) {
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
-		}
-		if(opts.progress) {
-			std::cout << std::endl << std::flush;
+	// 複数のポートへ並列に書き込む（パース済みのイメージは共有）
+	std::vector<char> oks(opts.ports.size(), 0);
+	std::vector<double> times(opts.ports.size(), 0.0);
+	std::vector<delta_t> dts(opts.ports.size());
+	{
+		std::vector<std::thread> ths;
+		for(uint32_t i = 0; i < opts.ports.size(); ++i) {
+			ths.emplace_back([&, i]() {
+				auto st = std::chrono::steady_clock::now();
+				oks[i] = program_(opts, opts.ports[i], com_speed, rx, false, dts[i]);
+				times[i] = elapsed_(st);
+			});
 		}
-		if(!prog_.final_write()) {
-			prog_.end();
-			return -1;
+		for(auto& th : ths) {
+			th.join();
 		}
 	}
-
-	//=====================================
-	if(opts.verify) {  // verify
-		auto areas = motsx_.create_area_map();
-		if(opts.progress) {
-			std::cout << "Verify: " << std::flush;
-		}
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
-				auto mem = motsx_.get_memory(adr);
-				if(!prog_.verify_page(adr, &mem[0])) {
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
-		}
-		if(opts.progress) {
-			std::cout << std::endl << std::flush;
-		}
+	uint32_t errs = 0;
+	for(uint32_t i = 0; i < opts.ports.size(); ++i) {
+		std::cout << boost::format("%s: %s (%.2f [s])") % opts.ports[i]
+			% (oks[i] ? "OK" : "NG") % times[i] << std::endl;
+		if(!oks[i]) ++errs;
+		else if(opts.delta) delta_report_("    ", dts[i], com_speed);
 	}
-
-	prog_.end();
+	return errs == 0 ? 0 : -1;
 }
@@ -427,5 +427,20 @@ namespace utils {
 			}
 			return cit->second.array_;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページが全て 0xff か（書き込みを省けるページ）
+			@param[in]	address	ベースとなるアドレス
+			@return 全て 0xff なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_blank(uint32_t address) const {
+			for(auto v : get_memory(address)) {
+				if(v != 0xff) return false;
+			}
+			return true;
+		}
 	};
 }
@@ -76,6 +76,12 @@ namespace utils {
 			fd_ = -1;
 		}
 
+		// モデム制御線の無いデバイス（疑似端末など）は ENOTTY を返すので、成功とみなす
+		bool modem_(unsigned long req, int& status) const {
+			if(ioctl(fd_, req, &status) != -1) return true;
+			return errno == ENOTTY;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -174,8 +180,8 @@ namespace utils {
 				return false;
 			}
 
-			int status;
-			if(ioctl(fd_, TIOCMGET, &status) == -1) {
+			int status = 0;
+			if(!modem_(TIOCMGET, status)) {
 				close_();
 				return false;
 			}
@@ -216,8 +222,8 @@ namespace utils {
 		bool close() {
 			if(fd_ < 0) return false;
 
-			int status;
-			if(ioctl(fd_, TIOCMGET, &status) == -1) {
+			int status = 0;
+			if(!modem_(TIOCMGET, status)) {
 				close_();
 				return false;
 			}
@@ -225,7 +231,7 @@ namespace utils {
 			status &= ~TIOCM_DTR;    /* turn off DTR */
 			status &= ~TIOCM_RTS;    /* turn off RTS */
 
-			if(ioctl(fd_, TIOCMSET, &status) == -1) {
+			if(!modem_(TIOCMSET, status)) {
 				close_();
 				return false;
 			}
@@ -445,15 +451,15 @@ namespace utils {
 		bool enable_DTR(bool ena = true) {
 			if(fd_ < 0) return false;
 
-			int status;
-			if(ioctl(fd_, TIOCMGET, &status) == -1) {
+			int status = 0;
+			if(!modem_(TIOCMGET, status)) {
 				return false;
 			}
 
 			if(ena) status |= TIOCM_DTR;
 			else status &= ~TIOCM_DTR;
 
-			if(ioctl(fd_, TIOCMSET, &status) == -1) {
+			if(!modem_(TIOCMSET, status)) {
 				return false;
 			}
 
@@ -471,15 +477,15 @@ namespace utils {
 		bool enable_RTS(bool ena = true) {
 			if(fd_ < 0) return false;
 
-			int status;
-			if(ioctl(fd_, TIOCMGET, &status) == -1) {
+			int status = 0;
+			if(!modem_(TIOCMGET, status)) {
 				return false;
 			}
 
 			if(ena) status |= TIOCM_RTS;
 			else status &= ~TIOCM_RTS;
 
-			if(ioctl(fd_, TIOCMSET, &status) == -1) {
+			if(!modem_(TIOCMSET, status)) {
 				return false;
 			}
 			return true;
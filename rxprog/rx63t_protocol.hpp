@@ -1077,6 +1077,16 @@ namespace rx63t {
 		bool get_protect() const { return id_protect_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	消去ブロックのサイズを取得
+			@param[in]	address	アドレス
+			@return 消去ブロックのサイズ（ブロック消去は未対応なので「０」）
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t get_erase_block(uint32_t address) { return 0; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	イレース・ページ
@@ -1115,13 +1125,27 @@ namespace rx63t {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	リード・ページ
+			@brief	リード・ページ（２５６バイト）
 			@param[in]	adr	アドレス
 			@param[out]	dst	リード・データ
 			@return エラー無ければ「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool read_page(uint32_t adr, uint8_t* dst) {
+			return read_area(adr, dst, 256);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・エリア（一度のコマンドで読み出す）
+			@param[in]	adr	アドレス
+			@param[out]	dst	リード・データ
+			@param[in]	len	長さ
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool read_area(uint32_t adr, uint8_t* dst, uint32_t len) {
 			if(!connection_) return false;
 			if(!pe_turn_on_) return false;
 
@@ -1130,7 +1154,7 @@ namespace rx63t {
 			cmd[1] = 9;
 			cmd[2] = 0x01;  // user-area, data-area
 			put32_big_(&cmd[3], adr);
-			put32_big_(&cmd[7], 256);
+			put32_big_(&cmd[7], len);
 			cmd[11] = sum_(cmd, 11);
 			if(!write_(cmd, 12)) {
 				return false;
@@ -1148,6 +1172,9 @@ namespace rx63t {
 					return false;
 				}
 				auto rs = get32_big_(&head[1]);
+				if(rs > len) {
+					return false;
+				}
 				/// std::cout << "Read size: " << rs << std::endl;
 				tv.tv_sec  = 5;
 				tv.tv_usec = 0;
@@ -625,6 +625,20 @@ namespace rx64m {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	消去ブロックのサイズを取得
+			@param[in]	address	アドレス
+			@return 消去ブロックのサイズ
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t get_erase_block(uint32_t address) {
+			if(address >= 0xFFFF0000) return 8192;  // 8K block
+			else if(address >= 0xFFC00000) return 32768;  // 32K block
+			else return 256;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	イレース・ページ
@@ -658,11 +672,7 @@ namespace rx64m {
 				}
 				// erase NG;
 				// std::cout << boost::format("Erase NG: %08X") % address << std::endl;
-				if(address >= 0xFFFF0000) {  // 8K block
-					org = address & 0xFFFFE000;
-				} else if(address >= 0xFFC00000) {  // 32K block
-					org = address & 0xFFFF8000;
-				}
+				org = address & ~(get_erase_block(address) - 1);
 				put32_big_(&tmp[0], org);
 				if(!command_(0x12, tmp, 4)) {  // erase command
 					return false;
@@ -784,6 +794,25 @@ namespace rx64m {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・エリア（ページ単位で読み出す）
+			@param[in]	adr	アドレス
+			@param[out]	dst	リード・データ
+			@param[in]	len	長さ（２５６の倍数）
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool read_area(uint32_t adr, uint8_t* dst, uint32_t len) {
+			for(uint32_t i = 0; i < len; i += 256) {
+				if(!read_page(adr + i, dst + i)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	終了
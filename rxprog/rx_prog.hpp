@@ -63,6 +63,19 @@ namespace rx {
 		};
 
 
+		struct erase_block_visitor {
+			using result_type = uint32_t;
+
+			uint32_t adr_;
+			erase_block_visitor(uint32_t adr) : adr_(adr) { }
+
+    		template <class T>
+    		uint32_t operator()(T& x) {
+				return x.get_erase_block(adr_);
+			}
+		};
+
+
 		struct read_page_visitor {
 			using result_type = bool;
 
@@ -77,6 +90,22 @@ namespace rx {
 		};
 
 
+		struct read_area_visitor {
+			using result_type = bool;
+
+			uint32_t adr_;
+			uint8_t* dst_;
+			uint32_t len_;
+			read_area_visitor(uint32_t adr, uint8_t* dst, uint32_t len) :
+				adr_(adr), dst_(dst), len_(len) { }
+
+    		template <class T>
+    		bool operator()(T& x) {
+				return x.read_area(adr_, dst_, len_);
+			}
+		};
+
+
 		struct select_write_visitor {
 			using result_type = bool;
 
@@ -175,6 +204,19 @@ namespace rx {
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	消去ブロックのサイズを取得
+			@param[in]	adr	アドレス
+			@return 消去ブロックのサイズ（ブロック消去が出来ない場合「０」）
+		*/
+		//-------------------------------------------------------------//
+		uint32_t get_erase_block(uint32_t adr) {
+			erase_block_visitor vis(adr);
+			return boost::apply_visitor(vis, protocol_);
+		}
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	リード・ページ（２５６バイト）
@@ -194,6 +236,26 @@ namespace rx {
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	リード・エリア（２５６の倍数、まとめて読み出す）
+			@param[in]	adr	開始アドレス
+			@param[out]	dst	書き込みアドレス
+			@param[in]	len	長さ
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool read_area(uint32_t adr, uint8_t* dst, uint32_t len) {
+			read_area_visitor vis(adr, dst, len);
+           	if(!boost::apply_visitor(vis, protocol_)) {
+				end();
+				std::cerr << "Read area error." << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	ベリファイ・ページ（２５６バイト）
@@ -203,12 +265,26 @@ namespace rx {
 		*/
 		//-------------------------------------------------------------//
 		bool verify_page(uint32_t adr, const uint8_t* src) {
-			uint8_t dev[256];
-			if(!read_page(adr, &dev[0])) {
+			return verify_area(adr, src, 256);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ベリファイ・エリア（２５６の倍数、まとめて読み出す）
+			@param[in]	adr	開始アドレス
+			@param[in]	src	書き込みアドレス
+			@param[in]	len	長さ
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool verify_area(uint32_t adr, const uint8_t* src, uint32_t len) {
+			std::vector<uint8_t> dev(len);
+			if(!read_area(adr, &dev[0], len)) {
 				return false;
 			}
 			uint32_t errcnt = 0;
-			for(uint32_t i = 0; i < 256; ++i) {
+			for(uint32_t i = 0; i < len; ++i) {
 				auto m = *src++;
 				if(dev[i] != m) {
 					++errcnt;
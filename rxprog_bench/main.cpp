@@ -0,0 +1,1130 @@
+//=====================================================================//
+/*!	@file
+	@brief	rx_prog 試験（ホスト用ベンチマーク）@n
+			疑似端末（pty）の向こう側で RX64M/RX24T/RX63T のブート・モードを @n
+			シミュレートし、rx_prog を子プロセスとして実行する。@n
+			シリアルの転送時間と、フラッシュのプログラム／消去時間は @n
+			シミュレーター側で実時間として待つので、rx_prog の書き込み、@n
+			ベリファイ、差分書き込み（--delta）、複数ポートの結果と @n
+			時間をホスト（Linux）だけで確認出来る。@n
+			※先に ../rxprog をビルドしておく事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <limits.h>
+#include <sys/wait.h>
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	typedef std::chrono::steady_clock CLOCK;
+
+	struct option_t {
+		std::string	prog = "../rxprog/rx_prog";
+		std::string	legacy;				///< 比較用の rx_prog（書き込みとベリファイだけ行う）
+		std::string	device;				///< 空なら全てのデバイス
+		uint32_t	speed = 230400;
+		uint32_t	page_us = 1000;		///< ２５６バイトのプログラム時間
+		uint32_t	erase_us = 20000;	///< ブロックの消去時間
+		uint32_t	repeat = 3;			///< 比較の繰り返し回数（最良値を取る）
+		bool		verbose = false;
+	};
+	option_t	opt_;
+
+	enum class DEVICE {
+		RX64M,
+		RX24T,
+		RX63T
+	};
+
+	const char* device_name_(DEVICE dev)
+	{
+		switch(dev) {
+		case DEVICE::RX64M: return "RX64M";
+		case DEVICE::RX24T: return "RX24T";
+		case DEVICE::RX63T: return "RX63T";
+		}
+		return "";
+	}
+
+	// イメージは、上位の 32K バイト（RX64M では 8K ブロック x 4）に置く
+	static const uint32_t IMAGE_ORG = 0xFFFF8000;
+	static const uint32_t IMAGE_BLOCK = 8192;
+	static const uint32_t IMAGE_BLOCKS = 4;
+	static const uint32_t IMAGE_DATA = 8;	///< ブロック毎のデータ・ページ数（その次は 0xFF のページ）
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  ページ単位のフラッシュ・メモリー（無いページは消去状態）
+	*/
+	//-----------------------------------------------------------------//
+	struct flash_t {
+		typedef std::array<uint8_t, 256> page_t;
+		std::map<uint32_t, page_t>	map_;
+
+		void clear() { map_.clear(); }
+
+		bool blank(uint32_t adr) const {
+			auto it = map_.find(adr & 0xffffff00);
+			if(it == map_.end()) return true;
+			for(auto v : it->second) {
+				if(v != 0xff) return false;
+			}
+			return true;
+		}
+
+		void read(uint32_t adr, uint8_t* dst) const {
+			auto it = map_.find(adr & 0xffffff00);
+			if(it == map_.end()) std::memset(dst, 0xff, 256);
+			else std::memcpy(dst, &it->second[0], 256);
+		}
+
+		// 消去されていないページへは書けない
+		bool program(uint32_t adr, const uint8_t* src) {
+			if(!blank(adr)) return false;
+			page_t& p = map_[adr & 0xffffff00];
+			std::memcpy(&p[0], src, 256);
+			return true;
+		}
+
+		void erase(uint32_t org, uint32_t len) {
+			for(uint32_t i = 0; i < len; i += 256) {  // 最上位のブロックで溢れない様に
+				map_.erase(org + i);
+			}
+		}
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  書き込むイメージ（ページ・アドレスと内容）
+	*/
+	//-----------------------------------------------------------------//
+	typedef std::map<uint32_t, flash_t::page_t> image_t;
+
+	image_t make_image_(uint32_t seed)
+	{
+		image_t img;
+		for(uint32_t b = 0; b < IMAGE_BLOCKS; ++b) {
+			for(uint32_t p = 0; p <= IMAGE_DATA; ++p) {
+				auto& page = img[IMAGE_ORG + b * IMAGE_BLOCK + p * 256];
+				for(uint32_t i = 0; i < 256; ++i) {
+					seed = seed * 1103515245 + 12345;
+					page[i] = p == IMAGE_DATA ? 0xff : (seed >> 16);
+				}
+			}
+		}
+		return img;
+	}
+
+	uint32_t page_adr_(uint32_t block, uint32_t page) { return IMAGE_ORG + block * IMAGE_BLOCK + page * 256; }
+
+	void load_(flash_t& flash, const image_t& img)
+	{
+		flash.clear();
+		for(const auto& m : img) {
+			flash.program(m.first, &m.second[0]);
+		}
+	}
+
+	bool match_(const flash_t& flash, const image_t& img)
+	{
+		for(const auto& m : img) {
+			uint8_t tmp[256];
+			flash.read(m.first, tmp);
+			if(std::memcmp(tmp, &m.second[0], 256) != 0) return false;
+		}
+		return true;
+	}
+
+	uint32_t data_pages_(const image_t& img)
+	{
+		uint32_t n = 0;
+		for(const auto& m : img) {
+			for(auto v : m.second) {
+				if(v != 0xff) { ++n; break; }
+			}
+		}
+		return n;
+	}
+
+	// S3 レコードで保存
+	bool save_mot_(const std::string& path, const image_t& img)
+	{
+		FILE* fp = fopen(path.c_str(), "wb");
+		if(fp == nullptr) return false;
+		for(const auto& m : img) {
+			for(uint32_t ofs = 0; ofs < 256; ofs += 32) {
+				uint32_t adr = m.first + ofs;
+				uint32_t sum = 4 + 32 + 1;
+				fprintf(fp, "S3%02X%08X", 4 + 32 + 1, adr);
+				for(uint32_t i = 0; i < 4; ++i) sum += (adr >> (i * 8)) & 0xff;
+				for(uint32_t i = 0; i < 32; ++i) {
+					fprintf(fp, "%02X", m.second[ofs + i]);
+					sum += m.second[ofs + i];
+				}
+				fprintf(fp, "%02X\n", ~sum & 0xff);
+			}
+		}
+		fprintf(fp, "S70500000000FA\n");
+		fclose(fp);
+		return true;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  シミュレーターの統計
+	*/
+	//-----------------------------------------------------------------//
+	struct stat_t {
+		uint32_t	program = 0;	///< プログラムしたページ数
+		uint32_t	erase = 0;		///< 消去したブロック数
+		uint32_t	blank = 0;		///< ブランク・チェックの回数
+		uint32_t	read = 0;		///< 読み出したページ数
+		uint32_t	error = 0;		///< 書き込みエラー、フレーム・エラーの回数
+		uint32_t	gap_n = 0;
+		double		gap = 0.0;		///< 書き込み応答から、次の書き込みコマンドまでの時間の合計
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ブート・モードのシミュレーター @n
+				pty のマスター側で、rx_prog が送るコマンドに応答する。
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class boot_sim {
+
+		DEVICE		dev_;
+		int			master_ = -1;
+		int			slave_ = -1;	///< 開いておき、rx_prog が閉じてもマスターが EIO にならない様にする
+		std::string	name_;
+
+		uint32_t	baud_ = 9600;
+		bool		connect_ = false;
+		CLOCK::time_point	line_;		///< 回線（又はデバイス）が空く時間
+		CLOCK::time_point	resp_;		///< 最後の書き込み応答を送った時間
+		bool		resp_ok_ = false;
+
+		std::atomic<bool>	stop_;
+		std::thread	th_;
+
+		// 転送時間、処理時間を待つ（１バイト、１０ビット）
+		void busy_(double us) {
+			auto now = CLOCK::now();
+			if(line_ < now) line_ = now;
+			line_ += std::chrono::microseconds(static_cast<int64_t>(us));
+			std::this_thread::sleep_until(line_);
+		}
+
+		void wire_(uint32_t n) { busy_(n * 10.0 * 1e6 / baud_); }
+
+		bool recv_(void* dst, uint32_t len, int timeout = -1) {
+			uint8_t* p = static_cast<uint8_t*>(dst);
+			uint32_t n = 0;
+			int wait = 0;
+			while(n < len && !stop_) {
+				pollfd fds;
+				fds.fd = master_;
+				fds.events = POLLIN;
+				if(poll(&fds, 1, 10) <= 0) {
+					wait += 10;
+					if(timeout >= 0 && wait >= timeout) return false;
+					continue;
+				}
+				auto l = ::read(master_, p + n, len - n);
+				if(l > 0) n += l;
+			}
+			if(n < len) return false;
+			wire_(len);
+			return true;
+		}
+
+		void send_(const void* src, uint32_t len) {
+			wire_(len);
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			while(len > 0) {
+				auto l = ::write(master_, p, len);
+				if(l <= 0) return;
+				p += l;
+				len -= l;
+			}
+		}
+
+		void send_(uint8_t ch) { send_(&ch, 1); }
+
+		static uint8_t sum_(const uint8_t* p, uint32_t len) {
+			uint32_t sum = 0;
+			for(uint32_t i = 0; i < len; ++i) sum += p[i];
+			return (0 - sum) & 0xff;
+		}
+
+		static uint32_t get32_big_(const uint8_t* p) {
+			return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+				| (static_cast<uint32_t>(p[2]) << 8) | p[3];
+		}
+
+		static void put32_big_(uint8_t* p, uint32_t v) {
+			p[0] = v >> 24;
+			p[1] = v >> 16;
+			p[2] = v >> 8;
+			p[3] = v;
+		}
+
+		static uint32_t rx64m_block_(uint32_t adr) {
+			if(adr >= 0xFFFF0000) return 8192;
+			else if(adr >= 0xFFC00000) return 32768;
+			else return 256;
+		}
+
+		// 書き込みコマンドの到着で、前の書き込み応答からの時間（ホスト側の処理時間）を計る
+		// （間に他のコマンドがあれば計らない）
+		void write_arrive_(const CLOCK::time_point& t) {
+			if(resp_ok_) {
+				std::chrono::duration<double> d = t - resp_;
+				stat_.gap += d.count();
+				++stat_.gap_n;
+			}
+			resp_ok_ = false;
+		}
+
+		void write_done_() {
+			resp_ = CLOCK::now();
+			resp_ok_ = true;
+		}
+
+		//=============================================================//
+		// RX64M（SOH フレーム）
+
+		bool frame_(uint8_t& soh, uint8_t& cmd, std::vector<uint8_t>& data, CLOCK::time_point& t) {
+			do {
+				if(!recv_(&soh, 1)) return false;
+			} while(soh != 0x01 && soh != 0x81);  // 同期が外れたバイトは捨てる
+			t = CLOCK::now();
+			uint8_t tmp[4 + 1024 + 2];
+			tmp[0] = soh;
+			if(!recv_(&tmp[1], 3)) return false;
+			uint32_t len = (static_cast<uint32_t>(tmp[1]) << 8) | tmp[2];
+			if(len == 0 || len > 1025) {
+				++stat_.error;
+				return false;
+			}
+			if(!recv_(&tmp[4], len - 1 + 2)) return false;
+			if(sum_(&tmp[1], 3 + len - 1) != tmp[4 + len - 1] || tmp[4 + len] != 0x03) {
+				++stat_.error;
+				return false;
+			}
+			cmd = tmp[3];
+			data.assign(&tmp[4], &tmp[4 + len - 1]);
+			return true;
+		}
+
+		void status_(uint8_t res) {
+			uint8_t tmp[6] = { 0x81, 0x00, 0x01, res, 0, 0x03 };
+			tmp[4] = sum_(&tmp[1], 3);
+			send_(tmp, sizeof(tmp));
+		}
+
+		void error_(uint8_t res, uint8_t err) {
+			uint8_t tmp[7] = { 0x81, 0x00, 0x02, res, err, 0, 0x03 };
+			tmp[5] = sum_(&tmp[1], 4);
+			send_(tmp, sizeof(tmp));
+		}
+
+		void data_(uint8_t res, const uint8_t* src, uint32_t len) {
+			std::vector<uint8_t> tmp(4 + len + 2);
+			tmp[0] = 0x81;
+			tmp[1] = (len + 1) >> 8;
+			tmp[2] = (len + 1) & 0xff;
+			tmp[3] = res;
+			std::memcpy(&tmp[4], src, len);
+			tmp[4 + len] = sum_(&tmp[1], 3 + len);
+			tmp[4 + len + 1] = 0x03;
+			send_(&tmp[0], tmp.size());
+		}
+
+		// データ要求（status_back_ は 7 バイト送るので、余分な 1 バイトも捨てる）
+		bool request_() {
+			uint8_t soh;
+			uint8_t cmd;
+			std::vector<uint8_t> d;
+			CLOCK::time_point t;
+			if(!frame_(soh, cmd, d, t)) return false;
+			uint8_t tmp;
+			recv_(&tmp, 1, 5);
+			return true;
+		}
+
+		void rx64m_() {
+			uint8_t soh;
+			uint8_t cmd;
+			std::vector<uint8_t> d;
+			CLOCK::time_point t;
+			if(!frame_(soh, cmd, d, t)) return;
+			if(soh != 0x01) return;
+
+			if(cmd != 0x13) resp_ok_ = false;
+
+			uint8_t tmp[256];
+			switch(cmd) {
+			case 0x00:  // 同期
+			case 0x36:  // エンディアン
+				status_(cmd);
+				break;
+			case 0x38:  // デバイス・タイプ
+				status_(cmd);
+				if(!request_()) return;
+				std::memset(tmp, 0, 24);
+				std::memcpy(tmp, "R5F564MF", 8);
+				put32_big_(&tmp[8],  24000000);
+				put32_big_(&tmp[12],  8000000);
+				put32_big_(&tmp[16], 120000000);
+				put32_big_(&tmp[20],  8000000);
+				data_(cmd, tmp, 24);
+				break;
+			case 0x32:  // 周波数
+				status_(cmd);
+				if(!request_()) return;
+				put32_big_(&tmp[0], 120000000);
+				put32_big_(&tmp[4],  60000000);
+				data_(cmd, tmp, 8);
+				break;
+			case 0x34:  // ボーレート（応答は変更前の速度）
+				status_(cmd);
+				if(d.size() >= 4) baud_ = get32_big_(&d[0]);
+				break;
+			case 0x2C:  // ID 認証モード
+				status_(cmd);
+				if(!request_()) return;
+				tmp[0] = 0xff;
+				data_(cmd, tmp, 1);
+				break;
+			case 0x10:  // ブランク・チェック
+				++stat_.blank;
+				if(flash_.blank(get32_big_(&d[0]))) status_(cmd);
+				else error_(0x90, 0xe0);
+				break;
+			case 0x12:  // ブロック消去
+				{
+					uint32_t adr = get32_big_(&d[0]);
+					uint32_t bsz = rx64m_block_(adr);
+					busy_(opt_.erase_us);
+					flash_.erase(adr & ~(bsz - 1), bsz);
+					++stat_.erase;
+					status_(cmd);
+				}
+				break;
+			case 0x13:  // 書き込み
+				{
+					write_arrive_(t);
+					uint32_t adr = get32_big_(&d[0]);
+					status_(cmd);
+					std::vector<uint8_t> data;
+					if(!frame_(soh, cmd, data, t)) return;
+					if(soh != 0x81 || data.size() != 256) {
+						++stat_.error;
+						error_(0x93, 0xe1);
+						return;
+					}
+					busy_(opt_.page_us);
+					if(flash_.program(adr, &data[0])) {
+						++stat_.program;
+						status_(0x13);
+					} else {
+						++stat_.error;
+						error_(0x93, 0xe1);
+					}
+					write_done_();
+				}
+				break;
+			case 0x15:  // 読み出し
+				{
+					uint32_t adr = get32_big_(&d[0]);
+					status_(cmd);
+					if(!frame_(soh, cmd, d, t)) return;
+					flash_.read(adr, tmp);
+					++stat_.read;
+					data_(0x15, tmp, 256);
+				}
+				break;
+			default:
+				++stat_.error;
+				error_(cmd | 0x80, 0xc0);
+				break;
+			}
+		}
+
+		//=============================================================//
+		// RX24T/RX63T（１バイト・コマンド）
+
+		// ヘッダー、データ、SUM の形で送る
+		void reply_(const std::vector<uint8_t>& head, const std::vector<uint8_t>& body, bool sum_all) {
+			std::vector<uint8_t> tmp(head);
+			tmp.insert(tmp.end(), body.begin(), body.end());
+			if(sum_all) tmp.push_back(sum_(&tmp[0], tmp.size()));
+			else tmp.push_back(sum_(&body[0], body.size()));
+			send_(&tmp[0], tmp.size());
+		}
+
+		static void push32_(std::vector<uint8_t>& v, uint32_t a) {
+			v.push_back(a >> 24);
+			v.push_back(a >> 16);
+			v.push_back(a >> 8);
+			v.push_back(a);
+		}
+
+		// 領域リスト（RX24T は数も含めた長さ、RX63T は数を別に送る）
+		void areas_(uint8_t res, const std::vector<uint32_t>& as) {
+			std::vector<uint8_t> body;
+			for(auto a : as) push32_(body, a);
+			uint8_t num = as.size() / 2;
+			if(dev_ == DEVICE::RX24T) {
+				body.insert(body.begin(), num);
+				reply_({ res, static_cast<uint8_t>(body.size()) }, body, true);
+			} else {
+				reply_({ res, static_cast<uint8_t>(body.size() + 1), num }, body, false);
+			}
+		}
+
+		void rx24t_() {
+			uint8_t cmd;
+			if(!recv_(&cmd, 1)) return;
+			auto t = CLOCK::now();
+			if(cmd != 0x50) resp_ok_ = false;
+
+			uint8_t tmp[4 + 256 + 16];
+
+			switch(cmd) {
+			case 0x20:  // サポート・デバイス
+				{
+					const char* name = dev_ == DEVICE::RX24T ? "R5F524T8" : "R5F563T6";
+					uint32_t code = dev_ == DEVICE::RX24T ? 0x3E14 : 0x3604;
+					std::vector<uint8_t> body;
+					body.push_back(4 + std::strlen(name));
+					for(uint32_t i = 0; i < 4; ++i) body.push_back(code >> (i * 8));
+					body.insert(body.end(), name, name + std::strlen(name));
+					if(dev_ == DEVICE::RX24T) {
+						body.insert(body.begin(), 1);
+						reply_({ 0x30, static_cast<uint8_t>(body.size()) }, body, true);
+					} else {
+						reply_({ 0x30, static_cast<uint8_t>(body.size() + 1), 1 }, body, false);
+					}
+				}
+				break;
+			case 0x21:  // クロック・モード
+				reply_({ 0x31, 1 }, { 0x00 }, false);
+				break;
+			case 0x22:  // 逓倍比
+				reply_({ 0x32, 11, 2 }, { 4, 1, 2, 4, 8, 4, 1, 2, 4, 8 }, false);
+				break;
+			case 0x23:  // 動作周波数
+				reply_({ 0x33, 9, 2 }, { 0x03, 0x20, 0x27, 0x10, 0x03, 0x20, 0x13, 0x88 }, false);
+				break;
+			case 0x24:  // ユーザー・ブート領域
+				areas_(0x34, { 0xFF7FC000, 0xFF7FFFFF });
+				break;
+			case 0x25:  // ユーザー領域
+				areas_(0x35, { dev_ == DEVICE::RX24T ? 0xFFFE0000 : 0xFFFF0000, 0xFFFFFFFF });
+				break;
+			case 0x26:  // ブロック情報
+				if(dev_ == DEVICE::RX24T) {
+					std::vector<uint8_t> body;
+					body.push_back(2);
+					push32_(body, 0xFFFE0000); push32_(body, 2048); push32_(body, 64);
+					push32_(body, 0x00100000); push32_(body, 1024); push32_(body, 8);
+					reply_({ 0x36, 0, static_cast<uint8_t>(body.size()) }, body, true);
+				} else {
+					std::vector<uint8_t> body;
+					push32_(body, 0xFFFF0000); push32_(body, 0xFFFF7FFF);
+					push32_(body, 0xFFFF8000); push32_(body, 0xFFFFFFFF);
+					reply_({ 0x36, 0, static_cast<uint8_t>(body.size() + 1), 2 }, body, false);
+				}
+				break;
+			case 0x27:  // プログラム・サイズ
+				reply_({ 0x37, 2 }, { 0x01, 0x00 }, true);
+				break;
+			case 0x2A:  // データ量域の有無
+				reply_({ 0x3A, 1 }, { static_cast<uint8_t>(dev_ == DEVICE::RX24T ? 0x1D : 0x21) }, true);
+				break;
+			case 0x2B:  // データ量域
+				areas_(0x3B, { 0x00100000, 0x00101FFF });
+				break;
+			case 0x10:  // デバイス選択
+			case 0x11:  // クロック・モード選択
+			case 0x3F:  // ボーレート（応答は変更前の速度）
+				if(!recv_(&tmp[0], 1)) return;
+				if(!recv_(&tmp[1], tmp[0] + 1)) return;
+				if(cmd == 0x10 && dev_ == DEVICE::RX24T) send_(0x46);
+				else send_(0x06);
+				if(cmd == 0x3F) baud_ = ((static_cast<uint32_t>(tmp[1]) << 8) | tmp[2]) * 100;
+				break;
+			case 0x06:  // ボーレート変更後の確認
+			case 0x42:  // ユーザー・ブート領域の書き込み選択
+			case 0x43:  // ユーザー／データ領域の書き込み選択
+				send_(0x06);
+				break;
+			case 0x40:  // P/E ステータス（ID プロテクト無し）
+				send_(0x26);
+				break;
+			case 0x50:  // 書き込み
+				{
+					write_arrive_(t);
+					if(!recv_(tmp, 4)) return;
+					uint32_t adr = get32_big_(tmp);
+					if(adr == 0xffffffff) {  // 終了
+						if(!recv_(tmp, 1)) return;
+						send_(0x06);
+						break;
+					}
+					if(!recv_(&tmp[4], 256 + 1)) return;
+					busy_(opt_.page_us);
+					if(flash_.program(adr, &tmp[4])) {
+						++stat_.program;
+						send_(0x06);
+					} else {
+						++stat_.error;
+						uint8_t err[2] = { 0xd0, 0x53 };
+						send_(err, 2);
+					}
+					write_done_();
+				}
+				break;
+			case 0x52:  // 読み出し（まとめて）
+				{
+					if(!recv_(tmp, 11)) return;
+					uint32_t adr = get32_big_(&tmp[2]);
+					uint32_t len = get32_big_(&tmp[6]);
+					std::vector<uint8_t> body(len);
+					for(uint32_t i = 0; i < len; i += 256) {
+						flash_.read(adr + i, &body[i]);
+						++stat_.read;
+					}
+					std::vector<uint8_t> head = { 0x52 };
+					push32_(head, len);
+					reply_(head, body, true);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		void loop_() {
+			while(!stop_) {
+				if(!connect_) {
+					uint8_t ch;
+					if(!recv_(&ch, 1)) continue;
+					if(ch == 0x00) {
+						send_(0x00);
+					} else if(ch == 0x55) {
+						send_(dev_ == DEVICE::RX64M ? 0xC1 : 0xE6);
+						connect_ = true;
+					}
+				} else if(dev_ == DEVICE::RX64M) {
+					rx64m_();
+				} else {
+					rx24t_();
+				}
+			}
+		}
+
+	public:
+		flash_t	flash_;
+		stat_t	stat_;
+
+		boot_sim(DEVICE dev) : dev_(dev), stop_(false) { }
+
+		~boot_sim() {
+			stop();
+			if(slave_ >= 0) ::close(slave_);
+			if(master_ >= 0) ::close(master_);
+		}
+
+		bool open() {
+			master_ = posix_openpt(O_RDWR | O_NOCTTY);
+			if(master_ < 0) return false;
+			if(grantpt(master_) != 0 || unlockpt(master_) != 0) return false;
+			name_ = ptsname(master_);
+			slave_ = ::open(name_.c_str(), O_RDWR | O_NOCTTY);
+			if(slave_ < 0) return false;
+			termios t;
+			tcgetattr(slave_, &t);
+			cfmakeraw(&t);
+			tcsetattr(slave_, TCSANOW, &t);
+			return true;
+		}
+
+		const std::string& get_name() const { return name_; }
+
+		void start() {
+			stop();
+			baud_ = 9600;
+			connect_ = false;
+			resp_ok_ = false;
+			line_ = CLOCK::now();
+			stat_ = stat_t();
+			stop_ = false;
+			th_ = std::thread(&boot_sim::loop_, this);
+		}
+
+		void stop() {
+			stop_ = true;
+			if(th_.joinable()) th_.join();
+			// 残ったデータは捨てる
+			if(master_ >= 0) {
+				uint8_t tmp[256];
+				pollfd fds;
+				fds.fd = master_;
+				fds.events = POLLIN;
+				while(poll(&fds, 1, 0) > 0 && ::read(master_, tmp, sizeof(tmp)) > 0) ;
+			}
+		}
+	};
+
+
+	std::string work_;  ///< 一時ディレクトリ（rx_prog.conf とイメージ）
+
+	// 実行ファイルと同じ場所の rx_prog.conf に、RX63T のクロック設定用のデバイスを加える
+	bool make_conf_(const std::string& prog)
+	{
+		std::string dir = prog.substr(0, prog.rfind('/') + 1);
+		std::ifstream in(dir + "rx_prog.conf");
+		if(!in) return false;
+		std::ofstream out(work_ + "/rx_prog.conf");
+		std::string line;
+		while(std::getline(in, line)) {
+			out << line << '\n';
+			if(line.find("[DEFAULT]") == 0) out << "device = R5F563T6\n";
+		}
+		return true;
+	}
+
+
+	struct run_t {
+		bool		ok = false;
+		double		time = 0.0;
+		std::string	out;
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  rx_prog を実行する（標準出力、エラー出力は取り込む）
+		@param[in]	prog	実行ファイル
+		@param[in]	args	引数
+		@return 結果
+	*/
+	//-----------------------------------------------------------------//
+	run_t run_(const std::string& prog, const std::vector<std::string>& args)
+	{
+		run_t r;
+		int fds[2];
+		if(pipe(fds) != 0) return r;
+
+		auto st = CLOCK::now();
+		pid_t pid = fork();
+		if(pid == 0) {
+			if(chdir(work_.c_str()) != 0) _exit(127);
+			dup2(fds[1], 1);
+			dup2(fds[1], 2);
+			::close(fds[0]);
+			::close(fds[1]);
+			std::vector<char*> argv;
+			argv.push_back(const_cast<char*>(prog.c_str()));
+			for(const auto& s : args) argv.push_back(const_cast<char*>(s.c_str()));
+			argv.push_back(nullptr);
+			execv(prog.c_str(), &argv[0]);
+			_exit(127);
+		}
+		::close(fds[1]);
+		char tmp[1024];
+		ssize_t l;
+		while((l = ::read(fds[0], tmp, sizeof(tmp))) > 0) {
+			r.out.append(tmp, l);
+		}
+		::close(fds[0]);
+		int status = 0;
+		waitpid(pid, &status, 0);
+		std::chrono::duration<double> d = CLOCK::now() - st;
+		r.time = d.count();
+		r.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		if(opt_.verbose) {
+			printf("%s", r.out.c_str());
+		}
+		return r;
+	}
+
+
+	std::vector<std::string> args_(DEVICE dev, const std::string& ports, bool delta, const std::string& mot)
+	{
+		std::vector<std::string> args = { "-d", device_name_(dev), "-s", std::to_string(opt_.speed),
+			"-P", ports };
+		if(delta) {
+			args.push_back("--delta");
+		} else {
+			args.push_back("--erase");
+			args.push_back("--write");
+		}
+		args.push_back("--verify");
+		args.push_back(mot);
+		return args;
+	}
+
+
+	// rx_prog（書き込み、ベリファイ）を一回実行する
+	run_t program_(const std::string& prog, boot_sim& sim, DEVICE dev, bool delta, const std::string& mot)
+	{
+		sim.start();
+		auto r = run_(prog, args_(dev, sim.get_name(), delta, mot));
+		sim.stop();
+		return r;
+	}
+
+
+	struct delta_t {
+		int		blocks = -1;
+		int		skip = -1;
+		int		fill = -1;
+		int		erase = -1;
+		int		pages = -1;
+		int		total = -1;
+		double	saved = 0.0;
+	};
+
+	// 報告の行を取り出す（複数ポートの場合は n 番目）
+	delta_t parse_delta_(const std::string& out, uint32_t n = 0)
+	{
+		delta_t d;
+		auto pos = std::string::npos;
+		for(uint32_t i = 0; i <= n; ++i) {
+			pos = out.find("Delta blocks:", pos == std::string::npos ? 0 : pos + 1);
+			if(pos == std::string::npos) return d;
+		}
+		sscanf(&out[pos], "Delta blocks: %d (skip: %d, fill: %d, erase: %d)",
+			&d.blocks, &d.skip, &d.fill, &d.erase);
+		auto p = out.find("Delta pages:", pos);
+		if(p != std::string::npos) sscanf(&out[p], "Delta pages: %d / %d", &d.pages, &d.total);
+		p = out.find("Delta saved:", pos);
+		if(p != std::string::npos) sscanf(&out[p], "Delta saved: %lf", &d.saved);
+		return d;
+	}
+
+
+	uint32_t errors_ = 0;
+
+	void check_(bool ok, const char* what)
+	{
+		if(!ok) {
+			printf("  NG: %s\n", what);
+			++errors_;
+		}
+	}
+
+	void report_(const char* name, const run_t& r, const boot_sim& sim, bool expect = true)
+	{
+		const auto& s = sim.stat_;
+		printf("  %-14s %s %6.3f [s], program: %2u, erase: %u, read: %2u", name, r.ok == expect ? "OK" : "NG",
+			r.time, s.program, s.erase, s.read);
+		if(s.gap_n > 0) {
+			printf(", host gap: %.0f [us/page]", s.gap * 1e6 / s.gap_n);
+		}
+		printf("\n");
+	}
+
+	bool same_(const delta_t& d, int blocks, int skip, int fill, int erase, int pages)
+	{
+		return d.blocks == blocks && d.skip == skip && d.fill == fill && d.erase == erase && d.pages == pages;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  デバイス毎の試験 @n
+				・消去状態への書き込み（全て 0xFF のページは送らない）@n
+				・書き込み済みへの書き直し（RX64M はブロック消去）@n
+				・差分書き込み（一致ブロックのスキップ、空きページへの書き足し、@n
+				　ブロック消去して書き直し、報告される節約時間）
+		@param[in]	dev	デバイス
+	*/
+	//-----------------------------------------------------------------//
+	void test_device_(DEVICE dev)
+	{
+		printf("%s: %u [bps], program %u [us/page], erase %u [us/block]\n", device_name_(dev),
+			opt_.speed, opt_.page_us, opt_.erase_us);
+
+		boot_sim sim(dev);
+		if(!sim.open()) {
+			printf("  Can't open pty\n");
+			++errors_;
+			return;
+		}
+
+		// base: 基本イメージ、other: 全てのデータ・ページが異なる
+		// fill: base の block1 の空きページにデータを加える
+		// delta: fill に加えて block2 の１バイトを変える（消去が必要）
+		auto base = make_image_(1);
+		auto other = make_image_(2);
+		auto fill = base;
+		fill[page_adr_(1, IMAGE_DATA)] = other[page_adr_(1, 0)];
+		auto delta = fill;
+		delta[page_adr_(2, 3)][17] ^= 0x5a;
+
+		save_mot_(work_ + "/base.mot", base);
+		save_mot_(work_ + "/other.mot", other);
+		save_mot_(work_ + "/fill.mot", fill);
+		save_mot_(work_ + "/delta.mot", delta);
+		uint32_t pages = data_pages_(base);
+
+		sim.flash_.clear();
+		auto r = program_(opt_.prog, sim, dev, false, "base.mot");
+		report_("write", r, sim);
+		check_(r.ok && match_(sim.flash_, base), "write: flash != image");
+		check_(sim.stat_.program == pages, "write: blank pages were sent");
+
+		if(dev == DEVICE::RX64M) {
+			r = program_(opt_.prog, sim, dev, false, "other.mot");
+			report_("rewrite", r, sim);
+			check_(r.ok && match_(sim.flash_, other), "rewrite: flash != image");
+			check_(sim.stat_.erase == IMAGE_BLOCKS, "rewrite: erase blocks");
+
+			// 全て書き直す場合と、差分書き込みの比較
+			load_(sim.flash_, base);
+			auto full = program_(opt_.prog, sim, dev, false, "delta.mot");
+			report_("full (delta)", full, sim);
+			check_(full.ok && match_(sim.flash_, delta), "full: flash != image");
+
+			load_(sim.flash_, base);
+			r = program_(opt_.prog, sim, dev, true, "delta.mot");
+			report_("--delta", r, sim);
+			auto d = parse_delta_(r.out);
+			check_(r.ok && match_(sim.flash_, delta), "delta: flash != image");
+			check_(same_(d, 4, 2, 1, 1, 1 + IMAGE_DATA), "delta: skip 2, fill 1, erase 1, pages 9");
+			check_(sim.stat_.erase == 1 && sim.stat_.program == (1 + IMAGE_DATA), "delta: device counts");
+			printf("  delta report: blocks %d (skip %d, fill %d, erase %d), pages %d / %d\n",
+				d.blocks, d.skip, d.fill, d.erase, d.pages, d.total);
+			printf("  delta saved: %.3f [s] measured, %.3f [s] reported\n", full.time - r.time, d.saved);
+			// 見積もりなので、全て書き直した時間の 10% 以内なら良しとする
+			check_(std::fabs((full.time - r.time) - d.saved) < (full.time * 0.1), "delta: saved time report");
+
+			r = program_(opt_.prog, sim, dev, true, "delta.mot");
+			report_("--delta same", r, sim);
+			d = parse_delta_(r.out);
+			check_(r.ok && same_(d, 4, 4, 0, 0, 0) && sim.stat_.program == 0, "delta same: skip all");
+		} else {
+			// ブロック消去が出来ないので、ページ毎に比較して、書き足しだけ出来る
+			int n = base.size();
+			load_(sim.flash_, base);
+			r = program_(opt_.prog, sim, dev, true, "fill.mot");
+			report_("--delta fill", r, sim);
+			auto d = parse_delta_(r.out);
+			check_(r.ok && match_(sim.flash_, fill), "delta fill: flash != image");
+			check_(same_(d, n, n - 1, 1, 0, 1) && sim.stat_.program == 1, "delta fill: fill 1 page");
+			printf("  delta report: blocks %d (skip %d, fill %d, erase %d), pages %d / %d\n",
+				d.blocks, d.skip, d.fill, d.erase, d.pages, d.total);
+
+			load_(sim.flash_, base);
+			r = program_(opt_.prog, sim, dev, true, "delta.mot");
+			report_("--delta erase", r, sim, false);  // 消去が必要なので、止まるのが正しい
+			check_(!r.ok && r.out.find("Erase required") != std::string::npos,
+				"delta erase: must stop with 'Erase required'");
+			check_(sim.stat_.error == 0, "delta erase: no write over programmed pages");
+			check_(sim.stat_.program == 0 && match_(sim.flash_, base), "delta erase: flash must be untouched");
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  複数ポート（RX64M x 2）の並列書き込み、差分書き込み
+	*/
+	//-----------------------------------------------------------------//
+	void test_ports_()
+	{
+		printf("RX64M x 2: parallel ports\n");
+		boot_sim a(DEVICE::RX64M);
+		boot_sim b(DEVICE::RX64M);
+		if(!a.open() || !b.open()) {
+			printf("  Can't open pty\n");
+			++errors_;
+			return;
+		}
+		auto base = make_image_(1);
+		auto delta = base;
+		delta[page_adr_(2, 3)][17] ^= 0x5a;
+		save_mot_(work_ + "/base.mot", base);
+		save_mot_(work_ + "/delta.mot", delta);
+		std::string ports = a.get_name() + "," + b.get_name();
+
+		a.flash_.clear();
+		b.flash_.clear();
+		a.start();
+		auto one = run_(opt_.prog, args_(DEVICE::RX64M, a.get_name(), false, "base.mot"));
+		a.stop();
+		report_("one port", one, a);
+
+		a.flash_.clear();
+		a.start();
+		b.start();
+		auto r = run_(opt_.prog, args_(DEVICE::RX64M, ports, false, "base.mot"));
+		a.stop();
+		b.stop();
+		report_("two ports", r, a);
+		check_(r.ok && match_(a.flash_, base) && match_(b.flash_, base), "two ports: flash != image");
+		check_(r.out.find(a.get_name() + ": OK") != std::string::npos
+			&& r.out.find(b.get_name() + ": OK") != std::string::npos, "two ports: summary lines");
+
+		a.start();
+		b.start();
+		r = run_(opt_.prog, args_(DEVICE::RX64M, ports, true, "delta.mot"));
+		a.stop();
+		b.stop();
+		report_("two --delta", r, a);
+		auto da = parse_delta_(r.out, 0);
+		auto db = parse_delta_(r.out, 1);
+		check_(r.ok && match_(a.flash_, delta) && match_(b.flash_, delta), "two --delta: flash != image");
+		check_(same_(da, 4, 3, 0, 1, IMAGE_DATA) && same_(db, 4, 3, 0, 1, IMAGE_DATA),
+			"two --delta: per port report");
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  比較用の rx_prog との書き込み時間の比較（最良値）
+		@param[in]	dev	デバイス
+	*/
+	//-----------------------------------------------------------------//
+	void compare_(DEVICE dev)
+	{
+		boot_sim sim(dev);
+		if(!sim.open()) return;
+		auto base = make_image_(1);
+		save_mot_(work_ + "/base.mot", base);
+
+		const std::string* progs[2] = { &opt_.legacy, &opt_.prog };
+		double best[2] = { 1e9, 1e9 };
+		double gap[2] = { 0.0, 0.0 };
+		uint32_t program[2] = { 0, 0 };
+		bool ok = true;
+		for(uint32_t n = 0; n < opt_.repeat; ++n) {
+			for(uint32_t i = 0; i < 2; ++i) {
+				sim.flash_.clear();
+				auto r = program_(*progs[i], sim, dev, false, "base.mot");
+				if(!r.ok || !match_(sim.flash_, base)) ok = false;
+				if(r.time < best[i]) best[i] = r.time;
+				if(sim.stat_.gap_n > 0) gap[i] = sim.stat_.gap * 1e6 / sim.stat_.gap_n;
+				program[i] = sim.stat_.program;
+			}
+		}
+		printf("  %-6s legacy %6.3f [s] (%2u pages, gap %4.0f [us]), current %6.3f [s] (%2u pages, gap %4.0f [us])%s\n",
+			device_name_(dev), best[0], program[0], gap[0], best[1], program[1], gap[1], ok ? "" : " NG");
+		if(!ok) ++errors_;
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("rx_prog benchmark Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options]\n", cmd);
+		printf("    -prog PATH     rx_prog to test (default: %s)\n", opt_.prog.c_str());
+		printf("    -legacy PATH   compare erase/write/verify time with another rx_prog\n");
+		printf("    -device NAME   RX64M, RX24T or RX63T (default: all)\n");
+		printf("    -speed BPS     serial speed (default: %u)\n", opt_.speed);
+		printf("    -page-us US    program time of a 256 byte page (default: %u)\n", opt_.page_us);
+		printf("    -erase-us US   erase time of a block (default: %u)\n", opt_.erase_us);
+		printf("    -repeat N      runs per program with -legacy, best is taken (default: %u)\n", opt_.repeat);
+		printf("    -verbose       show rx_prog output\n");
+	}
+
+
+	std::string full_path_(const std::string& path)
+	{
+		char tmp[PATH_MAX];
+		if(realpath(path.c_str(), tmp) == nullptr) return path;
+		return tmp;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-prog" && (i + 1) < argc) opt_.prog = argv[++i];
+		else if(s == "-legacy" && (i + 1) < argc) opt_.legacy = argv[++i];
+		else if(s == "-device" && (i + 1) < argc) opt_.device = argv[++i];
+		else if(s == "-speed" && (i + 1) < argc) opt_.speed = std::atoi(argv[++i]);
+		else if(s == "-page-us" && (i + 1) < argc) opt_.page_us = std::atoi(argv[++i]);
+		else if(s == "-erase-us" && (i + 1) < argc) opt_.erase_us = std::atoi(argv[++i]);
+		else if(s == "-repeat" && (i + 1) < argc) opt_.repeat = std::atoi(argv[++i]);
+		else if(s == "-verbose") opt_.verbose = true;
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+
+	opt_.prog = full_path_(opt_.prog);
+	if(access(opt_.prog.c_str(), X_OK) != 0) {
+		printf("Can't execute: '%s' (build ../rxprog first)\n", opt_.prog.c_str());
+		return -1;
+	}
+	if(!opt_.legacy.empty()) opt_.legacy = full_path_(opt_.legacy);
+
+	char tmp[] = "/tmp/rxprog_bench.XXXXXX";
+	if(mkdtemp(tmp) == nullptr) return -1;
+	work_ = tmp;
+	if(!make_conf_(opt_.prog)) {
+		printf("Can't load rx_prog.conf beside '%s'\n", opt_.prog.c_str());
+		return -1;
+	}
+
+	static const DEVICE devs[] = { DEVICE::RX64M, DEVICE::RX24T, DEVICE::RX63T };
+	for(auto dev : devs) {
+		if(!opt_.device.empty() && opt_.device != device_name_(dev)) continue;
+		test_device_(dev);
+	}
+	if(opt_.device.empty() || opt_.device == "RX64M") {
+		test_ports_();
+	}
+	if(!opt_.legacy.empty()) {
+		printf("erase/write/verify, best of %u:\n", opt_.repeat);
+		for(auto dev : devs) {
+			if(!opt_.device.empty() && opt_.device != device_name_(dev)) continue;
+			compare_(dev);
+		}
+	}
+
+	static const char* files[] = { "rx_prog.conf", "base.mot", "other.mot", "fill.mot", "delta.mot" };
+	for(auto f : files) {
+		unlink((work_ + "/" + f).c_str());
+	}
+	rmdir(work_.c_str());
+
+	printf("%s (%u errors)\n", errors_ == 0 ? "match" : "mismatch", errors_);
+	return errors_ == 0 ? 0 : -1;
+}
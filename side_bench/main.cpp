@@ -0,0 +1,599 @@
+//=====================================================================//
+/*!	@file
+	@brief	Space Invaders エミュレーター・ベンチマーク（ホスト用）@n
+			「-cpu」i8080 コア（RTK5_SIDE/side/i8080_core.hpp）と、元の I8080 @n
+			（i8080.cpp）を、乱数で埋めた 64K のメモリー（自己書き換えを含む）で、@n
+			１命令毎に比べる（レジスター、サイクル数、ポートの読み書き、メモリー）。@n
+			「-machine」InvadersMachine を、二つの CPU で動かし、フレーム毎に @n
+			CPU、メモリー、画面、サウンドを比べる。@n
+			「-bench」InvadersMachine を、二つの CPU で N フレーム動かし、@n
+			命令／秒、フレーム／秒を表示する。@n
+			ROM は指定したディレクトリ（invaders.h、.g、.f、.e）、又は、合成した @n
+			プログラム（シフト・レジスターを使うスプライト描画、BCD スコア、割り込み）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "side/arcade.h"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	struct option_t {
+		uint32_t	frames = 0;			///< フレーム数（0: -machine 7200、-bench 3600）
+		uint32_t	seeds = 64;			///< -cpu のメモリー・パターン数
+		uint32_t	steps = 200000;		///< -cpu のパターン毎の命令数
+		std::string	rom;				///< ROM のディレクトリ
+		std::string	save;				///< 合成した ROM を保存する
+	};
+	option_t	opt_;
+
+	uint32_t	seed_;
+	uint32_t rand_() {
+		seed_ = seed_ * 1103515245 + 12345;
+		return (seed_ >> 16) & 0x7fff;
+	}
+
+
+	//=================================================================//
+	/*!
+		@brief  64K のフラットなメモリー（両方の CPU で使う）@n
+				ポートの読み出しは、回数で値が変わる（順番の比較）
+	*/
+	//=================================================================//
+	class flat_env : public I8080Environment {
+		uint8_t		mem_[0x10000];
+		uint32_t	in_;
+		uint32_t	out_;
+
+	public:
+		flat_env() : in_(0), out_(2166136261) { }
+
+		void fill(uint32_t seed)
+		{
+			in_ = 0;
+			out_ = 2166136261;
+			seed_ = seed;
+			for(uint32_t i = 0; i < sizeof(mem_); ++i) {
+				mem_[i] = rand_() >> 3;
+			}
+		}
+
+		const uint8_t* get_mem() const { return mem_; }
+		uint32_t get_in() const { return in_; }
+		uint32_t get_out() const { return out_; }
+
+		unsigned char readByte(unsigned addr) final {
+			return addr < sizeof(mem_) ? mem_[addr] : 0xFF;
+		}
+
+		void writeByte(unsigned addr, unsigned char value) final {
+			if(addr < sizeof(mem_)) mem_[addr] = value;
+		}
+
+		unsigned char readPort(unsigned port) final {
+			++in_;
+			return (port * 13 + in_) & 0xFF;
+		}
+
+		void writePort(unsigned port, unsigned char value) final {
+			out_ = (out_ ^ ((port << 8) | value)) * 16777619;
+		}
+	};
+
+
+	template <class CPU>
+	void load_regs_(CPU& cpu, const uint32_t* v)
+	{
+		cpu.B = v[0]; cpu.C = v[1]; cpu.D = v[2]; cpu.E = v[3];
+		cpu.H = v[4]; cpu.L = v[5]; cpu.A = v[6]; cpu.F = v[7];
+		cpu.PC = v[8];
+		cpu.SP = v[9];
+		cpu.setCycles(v[10]);
+	}
+
+
+	template <class CPU>
+	void get_state_(const CPU& cpu, InvadersMachine::CpuState& s)
+	{
+		s.B = cpu.B; s.C = cpu.C; s.D = cpu.D; s.E = cpu.E;
+		s.H = cpu.H; s.L = cpu.L; s.A = cpu.A; s.F = cpu.F;
+		s.PC = cpu.PC;
+		s.SP = cpu.SP;
+		s.cycles = cpu.getCycles();
+	}
+
+
+	bool same_(const InvadersMachine::CpuState& a, const InvadersMachine::CpuState& b)
+	{
+		return a.B == b.B && a.C == b.C && a.D == b.D && a.E == b.E && a.H == b.H
+			&& a.L == b.L && a.A == b.A && a.F == b.F && a.PC == b.PC && a.SP == b.SP
+			&& a.cycles == b.cycles;
+	}
+
+
+	void print_state_(const char* head, const InvadersMachine::CpuState& s)
+	{
+		printf("    %-8s A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X PC:%04X SP:%X cycles:%u\n",
+			head, s.A, s.F, s.B, s.C, s.D, s.E, s.H, s.L, s.PC, s.SP, s.cycles);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  CPU 単体の比較（１命令毎） @n
+				メモリー、レジスター、SP（0xFFFF 付近、0 付近を含む）を乱数で埋め、@n
+				乱数の間隔で割り込み（RST 1、RST 2）を入れる。
+		@return 全て同じなら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool cpu_check_()
+	{
+		static flat_env env0;
+		static flat_env env1;
+		uint32_t ops[256] = { 0 };
+		uint64_t total = 0;
+		bool ok = true;
+
+		printf("i8080 core vs I8080: %u patterns x %u instructions\n", opt_.seeds, opt_.steps);
+		for(uint32_t n = 0; n < opt_.seeds && ok; ++n) {
+			env0.fill(n + 1);
+			env1.fill(n + 1);
+			I8080 ref(env0);
+			emu::i8080_core<flat_env> cpu(env1);
+
+			seed_ = ~n;
+			uint32_t v[11];
+			for(int i = 0; i < 8; ++i) v[i] = rand_() & 0xFF;
+			v[8] = ((rand_() << 1) ^ rand_()) & 0xFFFF;
+			static const uint32_t sps[4] = { 0x0001, 0xFFFF, 0x2400, 0x8000 };
+			v[9] = (n & 4) ? sps[n & 3] : (((rand_() << 1) ^ rand_()) & 0xFFFF);
+			v[10] = 0;
+			load_regs_(ref, v);
+			load_regs_(cpu, v);
+
+			uint32_t next = rand_() & 0x3FF;
+			for(uint32_t i = 0; i < opt_.steps; ++i) {
+				++ops[env0.readByte(ref.PC)];
+				ref.step();
+				cpu.step();
+				if(i == next) {
+					uint32_t adr = (i & 1) ? 0x10 : 0x08;
+					ref.interrupt(adr);
+					cpu.interrupt(adr);
+					next += 1 + (rand_() & 0x3FF);
+				}
+				InvadersMachine::CpuState a, b;
+				get_state_(ref, a);
+				get_state_(cpu, b);
+				if(!same_(a, b)) {
+					printf("  pattern %u: registers differ after %u instructions\n", n, i + 1);
+					print_state_("I8080", a);
+					print_state_("core", b);
+					ok = false;
+					break;
+				}
+				// サイクル数は、InvadersMachine と同じ様に、割り込み毎に戻す
+				if(ref.getCycles() >= 16666) {
+					ref.setCycles(ref.getCycles() - 16666);
+					cpu.setCycles(cpu.getCycles() - 16666);
+				}
+			}
+			if(ok && (std::memcmp(env0.get_mem(), env1.get_mem(), 0x10000) != 0
+				|| env0.get_in() != env1.get_in() || env0.get_out() != env1.get_out())) {
+				printf("  pattern %u: memory or port access differs\n", n);
+				ok = false;
+			}
+			total += opt_.steps;
+		}
+
+		uint32_t cover = 0;
+		for(int i = 0; i < 256; ++i) {
+			if(ops[i]) ++cover;
+		}
+		printf("  instructions: %llu, opcodes executed: %u / 256\n",
+			static_cast<unsigned long long>(total), cover);
+		printf("  result: %s\n", ok ? "identical" : "DIFFERS");
+		return ok;
+	}
+
+
+	//=================================================================//
+	/*!
+		@brief  8080 の簡易アセンブラ（ラベルの前方参照あり）
+	*/
+	//=================================================================//
+	struct asm_t {
+		std::vector<uint8_t>&	rom;
+		uint16_t				pos;
+		std::map<std::string, uint16_t>	label;
+		std::vector<std::pair<uint16_t, std::string> >	fix;
+
+		asm_t(std::vector<uint8_t>& r) : rom(r), pos(0) { }
+
+		void org(uint16_t a) { pos = a; }
+		void b(uint8_t v) { rom[pos++] = v; }
+		void w(uint16_t v) { b(v & 0xff); b(v >> 8); }
+		void op(uint8_t c) { b(c); }
+		void imm(uint8_t c, uint8_t v) { b(c); b(v); }
+		void abs(uint8_t c, uint16_t a) { b(c); w(a); }
+		void at(const std::string& l) { label[l] = pos; }
+		void to(uint8_t c, const std::string& l) { b(c); fix.push_back({ pos, l }); w(0); }
+
+		void link()
+		{
+			for(const auto& f : fix) {
+				uint16_t a = label.at(f.second);
+				rom[f.first] = a & 0xff;
+				rom[f.first + 1] = a >> 8;
+			}
+		}
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  ROM を合成 @n
+				割り込み（RST 1、RST 2）でフレームを数え、入力を読み、サウンド・ポートに書く。@n
+				メインは、シフト・レジスター（ポート 2、4、3）で 16 x 2 バイトの @n
+				スプライトを 96 個、画面に XOR で描き、スプライト毎に BCD のスコアを @n
+				足す（DAA）。残りは、同じ描画を繰り返す（フレームを待たない）。
+		@param[out]	rom	ROM（8K）
+	*/
+	//-----------------------------------------------------------------//
+	void make_rom_(std::vector<uint8_t>& rom)
+	{
+		rom.assign(0x2000, 0);
+		asm_t a(rom);
+
+		// スプライトのパターン（0x1000 〜）
+		for(uint32_t i = 0; i < 0x1000; ++i) {
+			uint32_t t = i >> 4;
+			rom[0x1000 + i] = ((t * 0x9E) ^ ((i & 15) * 0x35) ^ (t >> 3)) & 0xff;
+		}
+
+		a.org(0x0000);
+		a.to(0xC3, "start");		// JMP start
+		a.org(0x0008);
+		a.to(0xC3, "isr1");			// JMP isr1
+		a.org(0x0010);
+		a.to(0xC3, "isr2");			// JMP isr2
+
+		a.org(0x0040);
+		a.at("isr1");
+		a.op(0xF5);					// PUSH PSW
+		a.op(0xE5);					// PUSH H
+		a.abs(0x21, 0x2000);		// LXI H,2000
+		a.op(0x34);					// INR M（フレーム）
+		a.imm(0xDB, 1);				// IN 1
+		a.abs(0x32, 0x2001);		// STA 2001
+		a.op(0xE1);					// POP H
+		a.op(0xF1);					// POP PSW
+		a.op(0xFB);					// EI
+		a.op(0xC9);					// RET
+
+		a.at("isr2");
+		a.op(0xF5);					// PUSH PSW
+		a.op(0xC5);					// PUSH B
+		a.abs(0x3A, 0x2000);		// LDA 2000
+		a.imm(0xE6, 0x1E);			// ANI 1E
+		a.imm(0xD3, 3);				// OUT 3
+		a.op(0x47);					// MOV B,A
+		a.op(0x0F);					// RRC
+		a.op(0xA8);					// XRA B
+		a.imm(0xD3, 5);				// OUT 5
+		a.op(0xC1);					// POP B
+		a.op(0xF1);					// POP PSW
+		a.op(0xFB);					// EI
+		a.op(0xC9);					// RET
+
+		a.at("score");				// BCD スコア（2010、2011）に 5 を足す
+		a.op(0xF5);					// PUSH PSW
+		a.abs(0x3A, 0x2010);		// LDA 2010
+		a.imm(0xC6, 0x05);			// ADI 5
+		a.op(0x27);					// DAA
+		a.abs(0x32, 0x2010);		// STA 2010
+		a.to(0xD2, "score_end");	// JNC score_end
+		a.abs(0x3A, 0x2011);		// LDA 2011
+		a.imm(0xCE, 0x00);			// ACI 0
+		a.op(0x27);					// DAA
+		a.abs(0x32, 0x2011);		// STA 2011
+		a.at("score_end");
+		a.op(0xF1);					// POP PSW
+		a.op(0xC9);					// RET
+
+		a.at("start");
+		a.abs(0x31, 0x2400);		// LXI SP,2400
+		a.op(0xFB);					// EI
+		a.at("frame");
+		a.abs(0x3A, 0x2000);		// LDA 2000
+		a.imm(0xE6, 0x07);			// ANI 7
+		a.imm(0xD3, 2);				// OUT 2（シフト量）
+		a.abs(0x11, 0x1000);		// LXI D,1000
+		a.abs(0x21, 0x2400);		// LXI H,2400
+		a.imm(0x0E, 96);			// MVI C,96
+		a.at("sprite");
+		a.imm(0x06, 16);			// MVI B,16
+		a.at("row");
+		a.op(0x1A);					// LDAX D
+		a.imm(0xD3, 4);				// OUT 4
+		a.imm(0xDB, 3);				// IN 3
+		a.op(0xAE);					// XRA M
+		a.op(0x77);					// MOV M,A
+		a.op(0x23);					// INX H
+		a.op(0xAF);					// XRA A
+		a.imm(0xD3, 4);				// OUT 4
+		a.imm(0xDB, 3);				// IN 3
+		a.op(0xAE);					// XRA M
+		a.op(0x77);					// MOV M,A
+		a.op(0x13);					// INX D
+		a.op(0x05);					// DCR B
+		a.to(0xC2, "row");			// JNZ row
+		a.op(0xE5);					// PUSH H
+		a.abs(0x2A, 0x2004);		// LHLD 2004
+		a.op(0x19);					// DAD D
+		a.abs(0x22, 0x2004);		// SHLD 2004
+		a.op(0xE1);					// POP H
+		a.to(0xCD, "score");		// CALL score
+		a.op(0x0D);					// DCR C
+		a.to(0xC2, "sprite");		// JNZ sprite
+		a.to(0xC3, "frame");		// JMP frame
+
+		a.link();
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  ROM を用意（-rom のディレクトリ、又は、合成）
+		@param[out]	rom	ROM（8K）
+		@return 成功なら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool load_rom_(std::vector<uint8_t>& rom)
+	{
+		if(opt_.rom.empty()) {
+			make_rom_(rom);
+			if(!opt_.save.empty()) {
+				FILE* fp = fopen(opt_.save.c_str(), "wb");
+				if(fp == nullptr) return false;
+				fwrite(&rom[0], 1, rom.size(), fp);
+				fclose(fp);
+			}
+			return true;
+		}
+
+		static const char* files[] = {
+			"invaders.h", "invaders.g", "invaders.f", "invaders.e"
+		};
+		rom.assign(0x2000, 0);
+		for(int i = 0; i < 4; ++i) {
+			std::string path = opt_.rom + "/" + files[i];
+			FILE* fp = fopen(path.c_str(), "rb");
+			if(fp == nullptr) {
+				printf("Can't open: '%s'\n", path.c_str());
+				return false;
+			}
+			size_t n = fread(&rom[i * 0x800], 1, 0x800, fp);
+			fclose(fp);
+			if(n != 0x800) {
+				printf("Short ROM: '%s'\n", path.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	// コイン、スタート、左右、ショットを決まった順に入れる
+	void input_(InvadersMachine& m, uint32_t frame)
+	{
+		if(frame == 60) m.fireEvent(InvadersMachine::CoinInserted);
+		if(frame == 120) m.fireEvent(InvadersMachine::KeyOnePlayerDown);
+		if(frame == 130) m.fireEvent(InvadersMachine::KeyOnePlayerUp);
+		if(frame < 300) return;
+
+		uint32_t t = frame % 240;
+		if(t == 0) m.fireEvent(InvadersMachine::KeyLeftDown);
+		if(t == 100) m.fireEvent(InvadersMachine::KeyLeftUp);
+		if(t == 120) m.fireEvent(InvadersMachine::KeyRightDown);
+		if(t == 220) m.fireEvent(InvadersMachine::KeyRightUp);
+		if((frame % 20) == 0) m.fireEvent(InvadersMachine::KeyFireDown);
+		if((frame % 20) == 5) m.fireEvent(InvadersMachine::KeyFireUp);
+		if((frame % 1800) == 1000) m.fireEvent(InvadersMachine::CoinInserted);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  InvadersMachine をフレーム毎に比べる
+		@return 全て同じなら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool machine_check_()
+	{
+		std::vector<uint8_t> rom;
+		if(!load_rom_(rom)) return false;
+
+		uint32_t frames = opt_.frames ? opt_.frames : 7200;
+		static InvadersMachine ref(true);
+		static InvadersMachine fast;
+		ref.setROM(reinterpret_cast<const char*>(&rom[0]));
+		fast.setROM(reinterpret_cast<const char*>(&rom[0]));
+		ref.reset();
+		fast.reset();
+
+		printf("InvadersMachine i8080 core vs I8080: %s, %u frames\n",
+			opt_.rom.empty() ? "synthetic ROM" : opt_.rom.c_str(), frames);
+		uint32_t sounds = 0;
+		for(uint32_t i = 0; i < frames; ++i) {
+			input_(ref, i);
+			input_(fast, i);
+			ref.step();
+			fast.step();
+			InvadersMachine::CpuState a, b;
+			ref.getCpuState(a);
+			fast.getCpuState(b);
+			const char* err = nullptr;
+			if(!same_(a, b)) err = "CPU";
+			else if(std::memcmp(ref.getRAM(), fast.getRAM(), 0x4000) != 0) err = "memory";
+			else if(std::memcmp(ref.getVideo(), fast.getVideo(),
+				InvadersMachine::ScreenWidth * InvadersMachine::ScreenHeight) != 0) err = "video";
+			else if(ref.getSounds() != fast.getSounds()) err = "sound";
+			if(err != nullptr) {
+				printf("  frame %u: %s differs\n", i, err);
+				print_state_("I8080", a);
+				print_state_("core", b);
+				printf("  result: DIFFERS\n");
+				return false;
+			}
+			sounds |= fast.getSounds();
+		}
+		printf("  sounds played: %03X\n", sounds);
+		printf("  result: identical\n");
+		return true;
+	}
+
+
+	typedef std::chrono::steady_clock clock_;
+
+	double ms_(clock_::time_point t0, clock_::time_point t1)
+	{
+		return std::chrono::duration<double, std::milli>(t1 - t0).count();
+	}
+
+
+	double run_(InvadersMachine& m, const std::vector<uint8_t>& rom, uint32_t frames)
+	{
+		m.setROM(reinterpret_cast<const char*>(&rom[0]));
+		m.reset();
+		auto t0 = clock_::now();
+		for(uint32_t i = 0; i < frames; ++i) {
+			input_(m, i);
+			m.step();
+		}
+		return ms_(t0, clock_::now());
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  命令／秒、フレーム／秒を計る @n
+				命令数は、i8080_core を１命令毎に動かして数える（InvadersMachine::step と同じ手順）。@n
+				時間は、InvadersMachine::step で計る（３回の最小）。
+	*/
+	//-----------------------------------------------------------------//
+	void bench_()
+	{
+		std::vector<uint8_t> rom;
+		if(!load_rom_(rom)) return;
+
+		uint32_t frames = opt_.frames ? opt_.frames : 3600;
+
+		// 命令数
+		static InvadersMachine env;
+		env.setROM(reinterpret_cast<const char*>(&rom[0]));
+		env.reset();
+		emu::i8080_core<InvadersMachine> cpu(env);
+		uint32_t cpi = 2000000 / (2 * env.getFrameRate());
+		uint64_t count = 0;
+		for(uint32_t i = 0; i < frames; ++i) {
+			input_(env, i);
+			for(int j = 0; j < 2; ++j) {
+				while(cpu.getCycles() < cpi) {
+					cpu.step();
+					++count;
+				}
+				cpu.setCycles(cpu.getCycles() - cpi);
+				cpu.interrupt(j ? 0x10 : 0x08);
+			}
+		}
+
+		static InvadersMachine ref(true);
+		static InvadersMachine fast;
+		double ref_ms = 0.0;
+		double fast_ms = 0.0;
+		for(int n = 0; n < 3; ++n) {
+			double t = run_(ref, rom, frames);
+			if(n == 0 || t < ref_ms) ref_ms = t;
+			t = run_(fast, rom, frames);
+			if(n == 0 || t < fast_ms) fast_ms = t;
+		}
+
+		printf("InvadersMachine: %s, %u frames, %llu instructions (%.0f / frame)\n",
+			opt_.rom.empty() ? "synthetic ROM" : opt_.rom.c_str(), frames,
+			static_cast<unsigned long long>(count), static_cast<double>(count) / frames);
+		printf("  %-12s %9s %12s %12s\n", "CPU", "ms", "frames/s", "Minst/s");
+		printf("  %-12s %9.1f %12.0f %12.1f\n", "I8080", ref_ms,
+			frames * 1000.0 / ref_ms, count / ref_ms / 1000.0);
+		printf("  %-12s %9.1f %12.0f %12.1f\n", "i8080_core", fast_ms,
+			frames * 1000.0 / fast_ms, count / fast_ms / 1000.0);
+		printf("  speed up: %.2f\n", ref_ms / fast_ms);
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("side benchmark Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options]\n", cmd);
+		printf("    -cpu           compare i8080 core and I8080 per instruction on random memory (default)\n");
+		printf("    -machine       compare InvadersMachine with both CPUs per frame\n");
+		printf("    -bench         instructions/s and frames/s with both CPUs\n");
+		printf("    -frames N      frames (default: -machine 7200, -bench 3600)\n");
+		printf("    -seeds N       -cpu memory patterns (default: 64)\n");
+		printf("    -steps N       -cpu instructions per pattern (default: 200000)\n");
+		printf("    -rom DIR       directory of invaders.h/.g/.f/.e instead of the synthetic ROM\n");
+		printf("    -save FILE     save the synthetic ROM (8K)\n");
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	enum class MODE {
+		CPU,
+		MACHINE,
+		BENCH
+	};
+	MODE mode = MODE::CPU;
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-cpu") mode = MODE::CPU;
+		else if(s == "-machine") mode = MODE::MACHINE;
+		else if(s == "-bench") mode = MODE::BENCH;
+		else if(s == "-frames" && (i + 1) < argc) opt_.frames = std::atoi(argv[++i]);
+		else if(s == "-seeds" && (i + 1) < argc) opt_.seeds = std::atoi(argv[++i]);
+		else if(s == "-steps" && (i + 1) < argc) opt_.steps = std::atoi(argv[++i]);
+		else if(s == "-rom" && (i + 1) < argc) opt_.rom = argv[++i];
+		else if(s == "-save" && (i + 1) < argc) opt_.save = argv[++i];
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+
+	int ret = 0;
+	switch(mode) {
+	case MODE::CPU:
+		ret = cpu_check_() ? 0 : 1;
+		break;
+	case MODE::MACHINE:
+		ret = machine_check_() ? 0 : 1;
+		break;
+	case MODE::BENCH:
+		bench_();
+		break;
+	}
+	return ret;
+}
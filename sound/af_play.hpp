@@ -9,6 +9,7 @@
 */
 //=====================================================================//
 #include <cstdint>
+#include "sound/tag.hpp"
 
 namespace sound {
 
@@ -33,6 +34,18 @@ namespace sound {
 		};
 
 
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	デコード・ステップの結果
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class STEP {
+			FRAME,		///< フレーム（ブロック）を出力した
+			END,		///< 終端
+			ERROR,		///< エラー
+		};
+
+
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		/*!
 			@brief	制御タスク型
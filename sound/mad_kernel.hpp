@@ -0,0 +1,296 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	libmad 出力変換、サブバンド・フィルター・カーネル @n
+			mad_synth の PCM バッファ全体を、丸め（ディザー）とクリップをして @n
+			１６ビットに変換する。@n
+			サブバンド・フィルターは、フレームのサブバンド・サンプルを一度に処理する。@n
+			ホストで SSE2 が使える場合は、SIMD で処理する（結果は同じ）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <mad.h>
+#include "sound/sound_out.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sound {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  libmad カーネル
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct mad_kernel {
+
+		//=================================================================//
+		/*!
+			@brief  ディザー（高域 TPDF、±１LSB）@n
+					４サンプル毎に独立した乱数列（左右で８列）を使う
+		*/
+		//=================================================================//
+		struct dither_t {
+			uint32_t	seed[8];
+			int32_t		prev[8];
+
+			dither_t(uint32_t s = 1) noexcept
+			{
+				for(uint32_t i = 0; i < 8; ++i) {
+					seed[i] = s + i * 0x9e3779b9;
+					prev[i] = 0;
+				}
+			}
+		};
+
+		static const uint32_t PCM_SHIFT = MAD_F_FRACBITS - 15;	///< １６ビットへのシフト
+
+	private:
+		static const uint32_t LCG_MUL = 1664525;
+		static const uint32_t LCG_ADD = 1013904223;
+		static const uint32_t DITHER_SHIFT = 32 - PCM_SHIFT;
+
+		static int32_t dither_(dither_t& d, uint32_t lane) noexcept
+		{
+			d.seed[lane] = d.seed[lane] * LCG_MUL + LCG_ADD;
+			int32_t r = d.seed[lane] >> DITHER_SHIFT;
+			int32_t v = r - d.prev[lane];
+			d.prev[lane] = r;
+			return v;
+		}
+
+
+		// 丸め、ディザーを加え、１６ビットにクリップ（端の値でも溢れない様に、先に１ビット落とす）
+		static int16_t pcm_(mad_fixed_t v, int32_t dt) noexcept
+		{
+			int32_t a = (v >> 1) + (((1 << (PCM_SHIFT - 1)) + dt) >> 1);
+			a >>= PCM_SHIFT - 1;
+			a = a > 32767 ? 32767 : a;
+			a = a < -32768 ? -32768 : a;
+			return static_cast<int16_t>(a);
+		}
+
+
+		// ディザー無しの丸め（pcm_ と同じ結果、先にクリップして、足しても溢れない様にする）
+		static int16_t round_(mad_fixed_t v) noexcept
+		{
+			static const int32_t rnd = 1 << (PCM_SHIFT - 1);
+			v = v > (MAD_F_ONE - rnd - 1) ? (MAD_F_ONE - rnd - 1) : v;
+			v = v < -MAD_F_ONE ? -MAD_F_ONE : v;
+			return static_cast<int16_t>((v + rnd) >> PCM_SHIFT);
+		}
+
+
+		template <bool DITHER>
+		static int16_t sample_(mad_fixed_t v, dither_t* d, uint32_t lane) noexcept
+		{
+			if(DITHER) return pcm_(v, dither_(*d, lane));
+			else return round_(v);
+		}
+
+
+		// ディザー、ステレオの有無で分ける（ループの中で分岐しない）
+		template <bool DITHER, bool STEREO>
+		static void convert_scalar_(const mad_fixed_t* l, const mad_fixed_t* r, uint32_t n,
+			wave_t* out, dither_t* d, uint32_t i) noexcept
+		{
+			for(; i < n; ++i) {
+				int16_t a = sample_<DITHER>(l[i], d, i & 3);
+				int16_t b = STEREO ? sample_<DITHER>(r[i], d, 4 + (i & 3)) : a;
+				out[i].l_ch = static_cast<uint16_t>(a);
+				out[i].r_ch = static_cast<uint16_t>(b);
+			}
+		}
+
+
+		static void convert_scalar_(const mad_fixed_t* l, const mad_fixed_t* r, uint32_t n,
+			wave_t* out, dither_t* d, uint32_t i) noexcept
+		{
+			if(d != nullptr) {
+				if(r != nullptr) convert_scalar_<true,  true >(l, r, n, out, d, i);
+				else             convert_scalar_<true,  false>(l, r, n, out, d, i);
+			} else {
+				if(r != nullptr) convert_scalar_<false, true >(l, r, n, out, d, i);
+				else             convert_scalar_<false, false>(l, r, n, out, d, i);
+			}
+		}
+
+#if defined(__SSE2__)
+		// 符号付き３２ビット乗算の下位３２ビット（SSE2 には無いので、偶数、奇数で分ける）
+		static __m128i mullo_(__m128i a, __m128i b) noexcept
+		{
+			__m128i e = _mm_mul_epu32(a, b);
+			__m128i o = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(e, _MM_SHUFFLE(0, 0, 2, 0)),
+				_mm_shuffle_epi32(o, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+
+		static __m128i dither_sse_(__m128i& seed, __m128i& prev) noexcept
+		{
+			seed = _mm_add_epi32(mullo_(seed, _mm_set1_epi32(LCG_MUL)), _mm_set1_epi32(LCG_ADD));
+			__m128i r = _mm_srli_epi32(seed, DITHER_SHIFT);
+			__m128i v = _mm_sub_epi32(r, prev);
+			prev = r;
+			return v;
+		}
+
+
+		static __m128i pcm_sse_(__m128i v, __m128i dt) noexcept
+		{
+			__m128i rnd = _mm_add_epi32(_mm_set1_epi32(1 << (PCM_SHIFT - 1)), dt);
+			__m128i a = _mm_add_epi32(_mm_srai_epi32(v, 1), _mm_srai_epi32(rnd, 1));
+			return _mm_srai_epi32(a, PCM_SHIFT - 1);
+		}
+
+
+		static uint32_t convert_sse_(const mad_fixed_t* l, const mad_fixed_t* r, uint32_t n,
+			wave_t* out, dither_t* d) noexcept
+		{
+			const __m128i zero = _mm_setzero_si128();
+			__m128i sl = zero, pl = zero, sr = zero, pr = zero;
+			if(d != nullptr) {
+				sl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&d->seed[0]));
+				pl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&d->prev[0]));
+				sr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&d->seed[4]));
+				pr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&d->prev[4]));
+			}
+			uint32_t i = 0;
+			for(; (i + 4) <= n; i += 4) {
+				__m128i dl = zero;
+				__m128i dr = zero;
+				if(d != nullptr) {
+					dl = dither_sse_(sl, pl);
+					if(r != nullptr) dr = dither_sse_(sr, pr);
+				}
+				__m128i a = pcm_sse_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&l[i])), dl);
+				__m128i b = a;
+				if(r != nullptr) {
+					b = pcm_sse_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&r[i])), dr);
+				}
+				// 飽和パックで１６ビットにクリップし、左右を交互に並べる
+				__m128i w = _mm_unpacklo_epi16(_mm_packs_epi32(a, a), _mm_packs_epi32(b, b));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), w);
+			}
+			if(d != nullptr) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&d->seed[0]), sl);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&d->prev[0]), pl);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&d->seed[4]), sr);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&d->prev[4]), pr);
+			}
+			return i;
+		}
+#endif
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サブバンド・フィルターのゲインを作る @n
+					mad_f_mul（FPM_DEFAULT）の、第二引数の丸めを先に済ませる
+			@param[in]	filter	ゲイン（３２バンド、MAD_F_ONE で等倍）
+			@param[out]	gain	変換したゲイン（３２バンド）
+		*/
+		//-----------------------------------------------------------------//
+		static void make_gain(const mad_fixed_t* filter, mad_fixed_t* gain) noexcept
+		{
+			for(uint32_t i = 0; i < 32; ++i) {
+				gain[i] = (filter[i] + (1L << 15)) >> 16;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サブバンド・フィルター（ポータブル） @n
+					結果は mad_f_mul（FPM_DEFAULT）と同じ
+			@param[in]	sb		サブバンド・サンプル（[num][32] の並び）
+			@param[in]	num		スロット数
+			@param[in]	gain	make_gain で作ったゲイン
+		*/
+		//-----------------------------------------------------------------//
+		static void subband_scalar(mad_fixed_t* sb, uint32_t num, const mad_fixed_t* gain) noexcept
+		{
+			for(uint32_t s = 0; s < num; ++s) {
+				for(uint32_t i = 0; i < 32; i += 4) {
+					sb[i + 0] = ((sb[i + 0] + (1L << 11)) >> 12) * gain[i + 0];
+					sb[i + 1] = ((sb[i + 1] + (1L << 11)) >> 12) * gain[i + 1];
+					sb[i + 2] = ((sb[i + 2] + (1L << 11)) >> 12) * gain[i + 2];
+					sb[i + 3] = ((sb[i + 3] + (1L << 11)) >> 12) * gain[i + 3];
+				}
+				sb += 32;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サブバンド・フィルター（SSE2 が使える場合は SIMD）
+			@param[in]	sb		サブバンド・サンプル（[num][32] の並び）
+			@param[in]	num		スロット数
+			@param[in]	gain	make_gain で作ったゲイン
+		*/
+		//-----------------------------------------------------------------//
+		static void subband(mad_fixed_t* sb, uint32_t num, const mad_fixed_t* gain) noexcept
+		{
+#if defined(__SSE2__)
+			__m128i g[8];
+			for(uint32_t i = 0; i < 8; ++i) {
+				g[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&gain[i * 4]));
+			}
+			const __m128i rnd = _mm_set1_epi32(1 << 11);
+			for(uint32_t s = 0; s < num; ++s) {
+				for(uint32_t i = 0; i < 8; ++i) {
+					__m128i* p = reinterpret_cast<__m128i*>(&sb[i * 4]);
+					__m128i v = _mm_srai_epi32(_mm_add_epi32(_mm_loadu_si128(p), rnd), 12);
+					_mm_storeu_si128(p, mullo_(v, g[i]));
+				}
+				sb += 32;
+			}
+#else
+			subband_scalar(sb, num, gain);
+#endif
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  PCM 変換（ポータブル）
+			@param[in]	l	左（モノラルの場合も）
+			@param[in]	r	右（モノラルの場合「nullptr」）
+			@param[in]	n	サンプル数
+			@param[out]	out	出力
+			@param[in]	d	ディザー（使わない場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		static void convert_scalar(const mad_fixed_t* l, const mad_fixed_t* r, uint32_t n,
+			wave_t* out, dither_t* d = nullptr) noexcept
+		{
+			convert_scalar_(l, r, n, out, d, 0);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  PCM 変換（SSE2 が使える場合は SIMD）
+			@param[in]	l	左（モノラルの場合も）
+			@param[in]	r	右（モノラルの場合「nullptr」）
+			@param[in]	n	サンプル数
+			@param[out]	out	出力
+			@param[in]	d	ディザー（使わない場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		static void convert(const mad_fixed_t* l, const mad_fixed_t* r, uint32_t n,
+			wave_t* out, dither_t* d = nullptr) noexcept
+		{
+			uint32_t i = 0;
+#if defined(__SSE2__)
+			i = convert_sse_(l, r, n, out, d);
+#endif
+			convert_scalar_(l, r, n, out, d, i);
+		}
+	};
+}
@@ -0,0 +1,559 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	サウンド・ミキサー @n
+			８ビット、１６ビットのモノラル PCM を、ボイス毎のゲイン、パンで @n
+			ステレオにミックスする。@n
+			固定長のブロック毎に３２ビットで累積し、最後に１６ビットに飽和させる。@n
+			等倍、中央のボイスはゲインを掛けずにモノラルで累積し、最後のボイスは @n
+			累積せずに出力と同時に加える。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include "sound/sound_out.hpp"
+
+namespace sound {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  サウンド・ミキサー・クラス
+		@param[in]	SNDMAX	同時発音数
+		@param[in]	RDRLEN	レンダリング・バッファ長さ
+		@param[in]	BLKLEN	ブロック長さ（４の倍数）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t SNDMAX, uint32_t RDRLEN, uint32_t BLKLEN = 128>
+	class mixer {
+
+		static_assert(BLKLEN >= 4 && (BLKLEN & 3) == 0, "BLKLEN must be a multiple of 4");
+		static_assert(SNDMAX <= 32, "SNDMAX must be 32 or less");
+
+	public:
+		static const uint16_t GAIN_ONE = 256;	///< ゲイン 1.0
+		static const uint16_t GAIN_MAX = 1024;	///< ゲインの最大値 (4.0)
+		static const int8_t   PAN_LEFT  = -127;	///< パン（左）
+		static const int8_t   PAN_RIGHT =  127;	///< パン（右）
+
+	private:
+		// ボイスのミックス方法（ゲイン設定時に決める）
+		enum class KIND : uint8_t {
+			MUTE,		///< 無音（位置だけ進める）
+			DIRECT8,	///< ８ビット、等倍、中央（モノラルで累積、マスターは最後に掛ける）
+			DIRECT16,	///< １６ビット、等倍、中央
+			PAN8,		///< ８ビット、左右のゲインを掛けてステレオで累積
+			PAN16,		///< １６ビット、左右のゲインを掛けてステレオで累積
+		};
+
+		struct snd_t {
+			const int8_t*	org8_;
+			const int16_t*	org16_;
+			uint32_t		len_;
+			uint32_t		pos_;
+			bool			loop_;
+			uint16_t		gain_;
+			int8_t			pan_;
+			KIND			kind_;
+			int32_t			gl_;	///< 左のゲイン（マスター込み、８ビットは２５６倍）
+			int32_t			gr_;	///< 右のゲイン
+			snd_t() : org8_(nullptr), org16_(nullptr), len_(0), pos_(0), loop_(false),
+				gain_(GAIN_ONE), pan_(0), kind_(KIND::MUTE), gl_(0), gr_(0) { }
+		};
+		snd_t		snd_[SNDMAX];
+
+		wave_t		final_[RDRLEN];
+		int32_t		acc_[BLKLEN * 2];	///< PAN8, PAN16 の累積（ステレオ、マスター込み）
+		int32_t		dir_[BLKLEN];		///< DIRECT8, DIRECT16 の累積（１６ビット単位、マスター無し）
+
+		uint16_t	master_;
+		uint32_t	dec_;
+
+		// ゲイン、パン、マスターから左右のゲインを作る（中央で左右とも等倍）
+		void make_gain_(snd_t& snd) const noexcept
+		{
+			int32_t g = (static_cast<int32_t>(snd.gain_) * master_) >> 8;
+			int32_t l = 127 - snd.pan_;
+			if(l > 127) l = 127;
+			int32_t r = 127 + snd.pan_;
+			if(r > 127) r = 127;
+			snd.gl_ = g * l / 127;
+			snd.gr_ = g * r / 127;
+			bool w16 = snd.org16_ != nullptr;
+			if(!w16) {
+				snd.gl_ <<= 8;
+				snd.gr_ <<= 8;
+			}
+			if(snd.gl_ == 0 && snd.gr_ == 0) {
+				snd.kind_ = KIND::MUTE;
+			} else if(snd.gain_ == GAIN_ONE && snd.pan_ == 0) {
+				snd.kind_ = w16 ? KIND::DIRECT16 : KIND::DIRECT8;
+			} else {
+				snd.kind_ = w16 ? KIND::PAN16 : KIND::PAN8;
+			}
+		}
+
+
+		// ボイスを、サンプルの終端で区切って処理（終端でループ、又は停止）@n
+		// 処理したサンプル数を返す
+		template <class FUNC>
+		static uint32_t run_(snd_t& snd, uint32_t num, FUNC func) noexcept
+		{
+			uint32_t ofs = 0;
+			while(ofs < num) {
+				uint32_t run = snd.len_ - snd.pos_;
+				if(run > (num - ofs)) run = num - ofs;
+				func(ofs, snd.pos_, run);
+				snd.pos_ += run;
+				ofs += run;
+				if(snd.pos_ >= snd.len_) {
+					if(snd.loop_) {
+						snd.pos_ = 0;
+					} else {
+						snd.len_ = 0;
+						break;
+					}
+				}
+			}
+			return ofs;
+		}
+
+
+		// モノラルのソースを、ステレオの累積バッファに加える（４サンプル展開）@n
+		// SET: ブロックで最初のボイスは、加えずに書き込む（クリア不要）
+		template <bool SET, typename T>
+		static void mix_(int32_t* acc, const T* src, uint32_t n, int32_t gl, int32_t gr) noexcept
+		{
+			while(n >= 4) {
+				int32_t s0 = src[0];
+				int32_t s1 = src[1];
+				int32_t s2 = src[2];
+				int32_t s3 = src[3];
+				acc[0] = (SET ? 0 : acc[0]) + s0 * gl;
+				acc[1] = (SET ? 0 : acc[1]) + s0 * gr;
+				acc[2] = (SET ? 0 : acc[2]) + s1 * gl;
+				acc[3] = (SET ? 0 : acc[3]) + s1 * gr;
+				acc[4] = (SET ? 0 : acc[4]) + s2 * gl;
+				acc[5] = (SET ? 0 : acc[5]) + s2 * gr;
+				acc[6] = (SET ? 0 : acc[6]) + s3 * gl;
+				acc[7] = (SET ? 0 : acc[7]) + s3 * gr;
+				src += 4;
+				acc += 8;
+				n -= 4;
+			}
+			while(n > 0) {
+				int32_t s = *src++;
+				acc[0] = (SET ? 0 : acc[0]) + s * gl;
+				acc[1] = (SET ? 0 : acc[1]) + s * gr;
+				acc += 2;
+				--n;
+			}
+		}
+
+
+		// 等倍、中央のソースを、モノラルの累積バッファに加える（ゲインの掛け算無し）
+		template <bool SET, typename T>
+		static void add_(int32_t* dir, const T* src, uint32_t n) noexcept
+		{
+			static const int32_t sh = sizeof(T) == 1 ? 8 : 0;
+			while(n >= 4) {
+				dir[0] = (SET ? 0 : dir[0]) + (static_cast<int32_t>(src[0]) << sh);
+				dir[1] = (SET ? 0 : dir[1]) + (static_cast<int32_t>(src[1]) << sh);
+				dir[2] = (SET ? 0 : dir[2]) + (static_cast<int32_t>(src[2]) << sh);
+				dir[3] = (SET ? 0 : dir[3]) + (static_cast<int32_t>(src[3]) << sh);
+				src += 4;
+				dir += 4;
+				n -= 4;
+			}
+			while(n > 0) {
+				*dir = (SET ? 0 : *dir) + (static_cast<int32_t>(*src) << sh);
+				++src;
+				++dir;
+				--n;
+			}
+		}
+
+
+		// ボイスを１ブロック分、累積バッファに加える
+		template <KIND kind, bool SET>
+		void mix_voice_(snd_t& snd, uint32_t num) noexcept
+		{
+			uint32_t ofs = run_(snd, num, [this, &snd](uint32_t o, uint32_t p, uint32_t n) {
+				switch(kind) {
+				case KIND::DIRECT8:  add_<SET>(&dir_[o], snd.org8_ + p, n);  break;
+				case KIND::DIRECT16: add_<SET>(&dir_[o], snd.org16_ + p, n); break;
+				case KIND::PAN8:     mix_<SET>(&acc_[o * 2], snd.org8_ + p, n, snd.gl_, snd.gr_);  break;
+				case KIND::PAN16:    mix_<SET>(&acc_[o * 2], snd.org16_ + p, n, snd.gl_, snd.gr_); break;
+				default: break;
+				}
+			});
+			// 書き込みで停止した場合、残りを０にする
+			if(SET) {
+				for(uint32_t i = ofs; i < num; ++i) {
+					if(kind == KIND::DIRECT8 || kind == KIND::DIRECT16) {
+						dir_[i] = 0;
+					} else {
+						acc_[i * 2 + 0] = 0;
+						acc_[i * 2 + 1] = 0;
+					}
+				}
+			}
+		}
+
+
+		// 累積バッファ毎に、ブロックの最初のボイスだけ書き込みで処理
+		template <KIND kind>
+		void voice_(snd_t& snd, uint32_t num, bool& use) noexcept
+		{
+			if(use) {
+				mix_voice_<kind, false>(snd, num);
+			} else {
+				mix_voice_<kind, true>(snd, num);
+				use = true;
+			}
+		}
+
+
+		static int32_t clip_(int32_t v) noexcept
+		{
+			v = v > 32767 ? 32767 : v;
+			v = v < -32768 ? -32768 : v;
+			return v;
+		}
+
+
+		// １サンプルを１６ビットに飽和させて出力
+		template <bool PAN, bool DIR, bool SRC, typename T>
+		static void put_(wave_t& out, const int32_t* acc, const int32_t* dir, const T* src,
+			uint32_t i, int32_t m) noexcept
+		{
+			static const int32_t sh = sizeof(T) == 1 ? 8 : 0;
+			if(SRC && !DIR && !PAN) {  // 等倍のボイス１つ（マスターは等倍以下）は飽和しない
+				int32_t s = static_cast<int32_t>(src[i]) * m;
+				uint16_t v = static_cast<uint16_t>(sh == 8 ? s : (s >> 8));
+				out.l_ch = v;
+				out.r_ch = v;
+				return;
+			}
+			int32_t d = 0;
+			if(DIR) d += dir[i];
+			if(SRC) d += static_cast<int32_t>(src[i]) << sh;
+			d *= m;
+			if(PAN) {
+				out.l_ch = static_cast<uint16_t>(clip_((d + acc[i * 2 + 0]) >> 8));
+				out.r_ch = static_cast<uint16_t>(clip_((d + acc[i * 2 + 1]) >> 8));
+			} else {
+				uint16_t v = static_cast<uint16_t>(clip_(d >> 8));
+				out.l_ch = v;
+				out.r_ch = v;
+			}
+		}
+
+
+		// １６ビットに飽和させて出力（書き込んだ累積バッファだけ読む、４サンプル展開）@n
+		// SRC: 等倍、中央のボイスを、累積せずにここで加える
+		template <bool PAN, bool DIR, bool SRC, typename T>
+		void render_(uint32_t pos, uint32_t ofs, uint32_t num, const T* src) noexcept
+		{
+			const int32_t m = master_;
+			wave_t* out = &final_[pos + ofs];
+			const int32_t* acc = &acc_[ofs * 2];
+			const int32_t* dir = &dir_[ofs];
+			uint32_t i = 0;
+			while((i + 4) <= num) {
+				put_<PAN, DIR, SRC>(out[i + 0], acc, dir, src, i + 0, m);
+				put_<PAN, DIR, SRC>(out[i + 1], acc, dir, src, i + 1, m);
+				put_<PAN, DIR, SRC>(out[i + 2], acc, dir, src, i + 2, m);
+				put_<PAN, DIR, SRC>(out[i + 3], acc, dir, src, i + 3, m);
+				i += 4;
+			}
+			while(i < num) {
+				put_<PAN, DIR, SRC>(out[i], acc, dir, src, i, m);
+				++i;
+			}
+		}
+
+
+		template <bool SRC, typename T>
+		void render_sel_(bool pan, bool dir, uint32_t pos, uint32_t ofs, uint32_t num, const T* src) noexcept
+		{
+			if(pan) {
+				if(dir) render_<true,  true,  SRC>(pos, ofs, num, src);
+				else    render_<true,  false, SRC>(pos, ofs, num, src);
+			} else {
+				if(dir) render_<false, true,  SRC>(pos, ofs, num, src);
+				else    render_<false, false, SRC>(pos, ofs, num, src);
+			}
+		}
+
+
+		// 等倍、中央のボイスを、出力と同時に加える（停止した後は累積バッファだけ）
+		template <typename T>
+		void fuse_(snd_t& snd, const T* org, bool pan, bool dir, uint32_t pos, uint32_t num) noexcept
+		{
+			uint32_t ofs = run_(snd, num, [=](uint32_t o, uint32_t p, uint32_t n) {
+				render_sel_<true>(pan, dir, pos, o, n, org + p);
+			});
+			if(ofs < num) {
+				render_sel_<false>(pan, dir, pos, ofs, num - ofs, org);
+			}
+		}
+
+
+		static bool direct_(const snd_t& snd) noexcept
+		{
+			return snd.kind_ == KIND::DIRECT8 || snd.kind_ == KIND::DIRECT16;
+		}
+
+
+		template <typename T>
+		uint32_t play_(const T* org, uint32_t len, bool loop, uint16_t gain, int8_t pan) noexcept
+		{
+			if(org == nullptr || len == 0) return SNDMAX;
+
+			for(uint32_t i = 0; i < SNDMAX; ++i) {
+				snd_t& snd = snd_[i];
+				if(snd.len_ != 0) {
+					continue;
+				}
+				snd.org8_  = nullptr;
+				snd.org16_ = nullptr;
+				set_org_(snd, org);
+				snd.len_  = len;
+				snd.pos_  = 0;
+				snd.loop_ = loop;
+				set_gain(i, gain, pan);
+				return i;
+			}
+			return SNDMAX;
+		}
+
+		static void set_org_(snd_t& snd, const int8_t* org) noexcept { snd.org8_ = org; }
+		static void set_org_(snd_t& snd, const int16_t* org) noexcept { snd.org16_ = org; }
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		mixer() noexcept : master_(GAIN_ONE), dec_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  最大発音数を取得
+			@return	最大発音数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t sound_max() const noexcept { return SNDMAX; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  発音（８ビット）@n
+					データは発音中保持され、ミキサーは解放しない。
+			@param[in]	org		サウンド・データ先頭
+			@param[in]	len		サウンド・データ長さ（サンプル）
+			@param[in]	loop	ループの場合「true」
+			@param[in]	gain	ゲイン（GAIN_ONE で等倍）
+			@param[in]	pan		パン（PAN_LEFT 〜 PAN_RIGHT、０で中央）
+			@return	発音ハンドル（空きが無い場合 SNDMAX）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t play(const int8_t* org, uint32_t len, bool loop = false,
+			uint16_t gain = GAIN_ONE, int8_t pan = 0) noexcept
+		{
+			return play_(org, len, loop, gain, pan);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  発音（１６ビット）
+			@param[in]	org		サウンド・データ先頭
+			@param[in]	len		サウンド・データ長さ（サンプル）
+			@param[in]	loop	ループの場合「true」
+			@param[in]	gain	ゲイン（GAIN_ONE で等倍）
+			@param[in]	pan		パン（PAN_LEFT 〜 PAN_RIGHT、０で中央）
+			@return	発音ハンドル（空きが無い場合 SNDMAX）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t play(const int16_t* org, uint32_t len, bool loop = false,
+			uint16_t gain = GAIN_ONE, int8_t pan = 0) noexcept
+		{
+			return play_(org, len, loop, gain, pan);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  発音停止
+			@param[in]	sndhnd	発音ハンドル
+			@return	発音中だった場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool stop(uint32_t sndhnd) noexcept
+		{
+			if(sndhnd >= SNDMAX) return false;
+
+			snd_t& snd = snd_[sndhnd];
+			if(snd.len_ == 0) return false;
+			snd.len_ = 0;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  発音ステータス
+			@param[in]	sndhnd	発音ハンドル
+			@return	発音中なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool status(uint32_t sndhnd) const noexcept
+		{
+			if(sndhnd >= SNDMAX) return false;
+
+			return snd_[sndhnd].len_ != 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ボイスのゲイン、パンを設定
+			@param[in]	sndhnd	発音ハンドル
+			@param[in]	gain	ゲイン（GAIN_ONE で等倍、最大 GAIN_MAX）
+			@param[in]	pan		パン（PAN_LEFT 〜 PAN_RIGHT、０で中央）
+			@return	発音ハンドルが正しくない場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool set_gain(uint32_t sndhnd, uint16_t gain, int8_t pan = 0) noexcept
+		{
+			if(sndhnd >= SNDMAX) return false;
+
+			snd_t& snd = snd_[sndhnd];
+			snd.gain_ = gain > GAIN_MAX ? GAIN_MAX : gain;
+			snd.pan_ = pan < PAN_LEFT ? PAN_LEFT : pan;
+			make_gain_(snd);
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  マスター・ゲインを設定
+			@param[in]	gain	ゲイン（最大 GAIN_ONE）
+		*/
+		//-----------------------------------------------------------------//
+		void set_master(uint16_t gain) noexcept
+		{
+			master_ = gain > GAIN_ONE ? GAIN_ONE : gain;
+			for(uint32_t i = 0; i < SNDMAX; ++i) {
+				make_gain_(snd_[i]);
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  マスター・ゲインを取得
+			@return	マスター・ゲイン
+		*/
+		//-----------------------------------------------------------------//
+		uint16_t get_master() const noexcept { return master_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サウンドバッファを更新
+			@param[in]	dec	レンダリング数のマイナス調整
+		*/
+		//-----------------------------------------------------------------//
+		void update(uint32_t dec = 0) noexcept
+		{
+			if(dec > RDRLEN) dec = RDRLEN;
+			dec_ = dec;
+
+			uint32_t len = RDRLEN - dec;
+
+			// 発音中のボイスを、ブロックの外で調べておく（DIRECT を後ろに並べる）@n
+			// 途中で停止したボイスは len_ が０になり、以降のブロックでは飛ばす
+			uint8_t act[SNDMAX];
+			uint32_t actn = 0;
+			for(uint32_t i = 0; i < SNDMAX; ++i) {
+				snd_t& snd = snd_[i];
+				if(snd.len_ == 0) continue;
+				if(snd.kind_ == KIND::MUTE) {
+					run_(snd, len, [](uint32_t, uint32_t, uint32_t) { });
+				} else if(!direct_(snd)) {
+					act[actn++] = i;
+				}
+			}
+			for(uint32_t i = 0; i < SNDMAX; ++i) {
+				const snd_t& snd = snd_[i];
+				if(snd.len_ != 0 && direct_(snd)) {
+					act[actn++] = i;
+				}
+			}
+
+			for(uint32_t pos = 0; pos < len; pos += BLKLEN) {
+				uint32_t num = len - pos;
+				if(num > BLKLEN) num = BLKLEN;
+
+				// 最後の DIRECT ボイスは、累積せずに出力で加える
+				uint32_t end = actn;
+				while(end > 0 && snd_[act[end - 1]].len_ == 0) --end;
+				snd_t* last = nullptr;
+				if(end > 0 && direct_(snd_[act[end - 1]])) {
+					--end;
+					last = &snd_[act[end]];
+				}
+
+				bool pan = false;
+				bool dir = false;
+				for(uint32_t n = 0; n < end; ++n) {
+					snd_t& snd = snd_[act[n]];
+					if(snd.len_ == 0) {
+						continue;
+					}
+					switch(snd.kind_) {
+					case KIND::DIRECT8:  voice_<KIND::DIRECT8>(snd, num, dir);  break;
+					case KIND::DIRECT16: voice_<KIND::DIRECT16>(snd, num, dir); break;
+					case KIND::PAN8:     voice_<KIND::PAN8>(snd, num, pan);     break;
+					default:             voice_<KIND::PAN16>(snd, num, pan);    break;
+					}
+				}
+
+				if(last == nullptr) {
+					render_sel_<false>(pan, dir, pos, 0, num, static_cast<const int8_t*>(nullptr));
+				} else if(last->kind_ == KIND::DIRECT8) {
+					fuse_(*last, last->org8_, pan, dir, pos, num);
+				} else {
+					fuse_(*last, last->org16_, pan, dir, pos, num);
+				}
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サウンドバッファ・サイズの取得
+			@return	サウンドバッファ・サイズ
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_length() const noexcept { return RDRLEN - dec_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サウンドバッファの取得（符号付き１６ビット・ステレオ）@n
+					sound_out の FIFO にそのまま積める。
+			@return	サウンドバッファ
+		*/
+		//-----------------------------------------------------------------//
+		const wave_t* get_buffer() const noexcept { return final_; }
+	};
+}
@@ -13,10 +13,7 @@
 #include "common/file_io.hpp"
 #include "sound/id3_mgr.hpp"
 #include "sound/af_play.hpp"
-
-extern "C" {
-	void set_sample_rate(uint32_t freq);
-};
+#include "sound/mad_kernel.hpp"
 
 namespace sound {
 
@@ -28,6 +25,7 @@ namespace sound {
 	class mp3_in : public af_play {
 
 		static const uint32_t INPUT_BUFFER_SIZE = 2048;
+		static const uint32_t PCM_BLOCK = 64;	///< 出力にまとめて渡す数
 
 		mad_stream	mad_stream_;
 		mad_frame	mad_frame_;
@@ -36,12 +34,21 @@ namespace sound {
 
 		uint8_t		input_buffer_[INPUT_BUFFER_SIZE + MAD_BUFFER_GUARD];
 
-		// サブバンド領域フィルター特性用。
+		// サブバンド領域フィルター特性用（mad_kernel::make_gain で変換したゲイン）
 		mad_fixed_t		subband_filter_[32];
 		bool			subband_filter_enable_;
 		bool			id3v1_;
 
+		mad_kernel::dither_t	dither_;
+		bool			dither_enable_;
+
+		tag_t			tag_;
+		uint32_t		forg_;
+		uint32_t		pos_;
 		uint32_t		time_;
+		bool			info_;
+		bool			eof_;
+		bool			open_;
 
 
 		int fill_read_buffer_(utils::file_io& fin, mad_stream& strm)
@@ -93,12 +100,14 @@ namespace sound {
 				if(id3v1_) {
 					if(fin.tell() >= (fin.get_file_size() - 128)) return -1;
 				} else {
-					if(fin.eof()) return -1;
+					if(eof_) return -1;
 				}
+				// 終端では、ガードを加えて、残りのフレームをデコードしてから終わる
 				size = rs;
 				if(rs < req) {
 					memset(&ptr[rs], 0, MAD_BUFFER_GUARD);
 					size += MAD_BUFFER_GUARD;
+					eof_ = true;
 				}
 
 				/* Pipe the new buffer content to libmad's stream decoder
@@ -113,121 +122,238 @@ namespace sound {
 		}
 
 
-		/****************************************************************************
-		 * Applies a frequency-domain filter to audio data in the subband-domain.	*
-		 ****************************************************************************/
+		// サブバンド領域のフィルター（フレーム全体を一度に処理）
 		void apply_filter_(mad_frame& frame)
 		{
-			/* There is two application loops, each optimized for the number
-			 * of audio channels to process. The first alternative is for
-			 * two-channel frames, the second is for mono-audio.
-			 */
-			int num = MAD_NSBSAMPLES(&frame.header);
+			uint32_t num = MAD_NSBSAMPLES(&frame.header);
 			if(frame.header.mode != MAD_MODE_SINGLE_CHANNEL) {
-				for(int ch = 0; ch < 2; ++ch) {
-					for(int s = 0; s < num; ++s) {
-						for(int sb = 0; sb < 32; ++sb) {
-							frame.sbsample[ch][s][sb] =
-								mad_f_mul(frame.sbsample[ch][s][sb], subband_filter_[sb]);
-						}
-					}
+				// チャネル間も連続しているので、全スロットの場合はまとめる
+				if(num == 36) {
+					mad_kernel::subband(&frame.sbsample[0][0][0], num * 2, subband_filter_);
+				} else {
+					mad_kernel::subband(&frame.sbsample[0][0][0], num, subband_filter_);
+					mad_kernel::subband(&frame.sbsample[1][0][0], num, subband_filter_);
 				}
 			} else {
-				for(int s = 0; s < num; ++s) {
-					for(int sb = 0; sb < 32; ++sb) {
-						frame.sbsample[0][s][sb] =
-							mad_f_mul(frame.sbsample[0][s][sb], subband_filter_[sb]);
-					}
-				}
+				mad_kernel::subband(&frame.sbsample[0][0][0], num, subband_filter_);
 			}
 		}
 
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		mp3_in() : subband_filter_enable_(false), id3v1_(false), dither_(), dither_enable_(false),
+			tag_(), forg_(0), pos_(0), time_(0), info_(false), eof_(false), open_(false) { }
 
-		static const short SHRT_MAX_ = 32767;
 
-		/****************************************************************************
-		 * Converts a sample from mad's fixed point number format to a signed		*
-		 * short (16 bits).															*
-		 ****************************************************************************/
-		static short MadFixedToSshort(mad_fixed_t v)
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	デストラクター
+		*/
+		//-----------------------------------------------------------------//
+		~mp3_in() { close(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サブバンド・フィルター（イコライザー）の設定
+			@param[in]	filter	３２バンドのゲイン（MAD_F_ONE で等倍）@n
+								「nullptr」の場合、フィルターを使わない
+		*/
+		//-----------------------------------------------------------------//
+		void set_subband_filter(const mad_fixed_t* filter) noexcept
 		{
-			/* A fixed point number is formed of the following bit pattern:
-			 *
-			 * SWWWFFFFFFFFFFFFFFFFFFFFFFFFFFFF
-			 * MSB                          LSB
-			 * S ==> Sign (0 is positive, 1 is negative)
-			 * W ==> Whole part bits
-			 * F ==> Fractional part bits
-			 *
-			 * This pattern contains MAD_F_FRACBITS fractional bits, one
-			 * should alway use this macro when working on the bits of a fixed
-			 * point number. It is not guaranteed to be constant over the
-			 * different platforms supported by libmad.
-			 *
-			 * The signed short value is formed, after clipping, by the least
-			 * significant whole part bit, followed by the 15 most significant
-			 * fractional part bits. Warning: this is a quick and dirty way to
-			 * compute the 16-bit number, madplay includes much better
-			 * algorithms.
-			 */
+			if(filter == nullptr) {
+				subband_filter_enable_ = false;
+				return;
+			}
+			mad_kernel::make_gain(filter, subband_filter_);
+			subband_filter_enable_ = true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ディザーの設定（標準は無効で、丸めのみ）
+			@param[in]	ena	有効にする場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		void set_dither(bool ena = true) noexcept { dither_enable_ = ena; }
+
 
-			// Clipping..
-			if(v >= MAD_F_ONE) {
-				return SHRT_MAX_;
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	オープン（ID3 タグを解析して、デコーダーを初期化）
+			@param[in]	fin		file_io コンテキスト（参照）
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool open(utils::file_io& fin)
+		{
+			if(!fin.is_open()) {
+				return false;
 			}
-			if(v <= -MAD_F_ONE) {
-				return -SHRT_MAX_;
+			close();
+
+			id3_mgr id3;
+			id3.analize(fin);
+			tag_ = id3.get_tag();
+
+			mad_stream_init(&mad_stream_);
+			mad_frame_init(&mad_frame_);
+			mad_synth_init(&mad_synth_);
+			mad_timer_reset(&mad_timer_);
+			open_ = true;
+
+			forg_ = fin.tell();
+			info_ = false;
+			eof_ = false;
+			pos_ = 0;
+			time_ = 0;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	曲の先頭に戻る
+			@param[in]	fin		file_io コンテキスト（参照）
+		*/
+		//-----------------------------------------------------------------//
+		void restart(utils::file_io& fin)
+		{
+			fin.seek(utils::file_io::SEEK::SET, forg_);
+			mad_stream_finish(&mad_stream_);
+			mad_stream_init(&mad_stream_);
+			mad_timer_reset(&mad_timer_);
+			info_ = false;
+			eof_ = false;
+			pos_ = 0;
+			time_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	１フレームをデコード
+			@param[in]	fin		file_io コンテキスト（参照）
+			@param[in]	out		オーディオ出力（set_rate()、put() を持つ）
+			@return 結果
+		*/
+		//-----------------------------------------------------------------//
+		template <class AUDIO_OUT>
+		STEP step(utils::file_io& fin, AUDIO_OUT& out)
+		{
+			while(1) {
+				if(fill_read_buffer_(fin, mad_stream_) < 0) {
+					return STEP::END;
+				}
+				if(mad_frame_decode(&mad_frame_, &mad_stream_) == 0) {
+					break;
+				}
+				if(MAD_RECOVERABLE(mad_stream_.error) || mad_stream_.error == MAD_ERROR_BUFLEN) {
+					continue;
+				}
+				return STEP::ERROR;
+			}
+
+			if(!info_) {
+				out.set_rate(mad_frame_.header.samplerate);
+				utils::format("Sample Rate: %d\n") % mad_frame_.header.samplerate;
+				info_ = true;
+			}
+
+			mad_timer_add(&mad_timer_, mad_frame_.header.duration);
+
+			if(subband_filter_enable_) {
+				apply_filter_(mad_frame_);
+			}
+
+			mad_synth_frame(&mad_synth_, &mad_frame_);
+
+			uint32_t len = mad_synth_.pcm.length;
+			const mad_fixed_t* l = mad_synth_.pcm.samples[0];
+			const mad_fixed_t* r = nullptr;
+			if(MAD_NCHANNELS(&mad_frame_.header) != 1) {
+				r = mad_synth_.pcm.samples[1];
+			}
+			mad_kernel::dither_t* d = dither_enable_ ? &dither_ : nullptr;
+			for(uint32_t i = 0; i < len; i += PCM_BLOCK) {
+				uint32_t n = len - i;
+				if(n > PCM_BLOCK) n = PCM_BLOCK;
+				sound::wave_t wav[PCM_BLOCK];
+				mad_kernel::convert(l + i, r != nullptr ? r + i : nullptr, n, wav, d);
+				out.put(wav, n);
 			}
+			pos_ += len;
 
-			return (signed short)(v >> (MAD_F_FRACBITS - 15));
+			{
+				uint32_t s = pos_ / mad_frame_.header.samplerate;
+				if(s != time_) {
+					if(update_task_ != nullptr) {
+						(*update_task_)(s);
+					}
+					time_ = s;
+				}
+			}
+			return STEP::FRAME;
 		}
 
-	public:
+
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	コンストラクター
+			@brief	クローズ（デコーダーの終了）
+		*/
+		//-----------------------------------------------------------------//
+		void close()
+		{
+			if(!open_) return;
+			mad_synth_finish(&mad_synth_);
+			mad_frame_finish(&mad_frame_);
+			mad_stream_finish(&mad_stream_);
+			open_ = false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	タグ情報を取得（open の後で有効）
+			@return タグ情報
 		*/
 		//-----------------------------------------------------------------//
-		mp3_in() : subband_filter_enable_(false), id3v1_(false), time_(0) { }
+		const tag_t& get_tag() const noexcept { return tag_; }
 
 
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	デコード
 			@param[in]	fin		file_io コンテキスト（参照）
-			@param[in]	out		オーディオ出力（参照）
+			@param[in]	out		オーディオ出力（set_rate()、put()、mute() を持つ、resampler 等）
 			@return 正常終了なら「true」
 		*/
 		//-----------------------------------------------------------------//
 		template <class AUDIO_OUT>
 		bool decode(utils::file_io& fin, AUDIO_OUT& out)
 		{
-			id3_mgr id3;
-			id3.analize(fin);
+			if(!open(fin)) {
+				return false;
+			}
 			if(tag_task_ != nullptr) {
-				const auto& tag = id3.get_tag();
-				(*tag_task_)(tag);
-//				utils::format("Album:  '%s'\n") % tag.album_;
-//				utils::format("Title:  '%s'\n") % tag.title_;
-//				utils::format("Artist: '%s'\n") % tag.artist_;
-//				utils::format("Year:    %s\n") % tag.year_;
-//				utils::format("Disc:    %s\n") % tag.disc_;
-//				utils::format("Track:   %s\n") % tag.track_;
+				(*tag_task_)(tag_);
+//				utils::format("Album:  '%s'\n") % tag_.album_;
+//				utils::format("Title:  '%s'\n") % tag_.title_;
+//				utils::format("Artist: '%s'\n") % tag_.artist_;
+//				utils::format("Year:    %s\n") % tag_.year_;
+//				utils::format("Disc:    %s\n") % tag_.disc_;
+//				utils::format("Track:   %s\n") % tag_.track_;
 			}
 
-			mad_stream_init(&mad_stream_);
-			mad_frame_init(&mad_frame_);
-			mad_synth_init(&mad_synth_);
-			mad_timer_reset(&mad_timer_);
-
-			uint32_t forg = fin.tell();
-			bool info = false;
-			uint32_t pos = 0;
-			uint32_t frame_count = 0;
 			bool status = true;
 			bool pause = false;
-			while(fill_read_buffer_(fin, mad_stream_) >= 0) {
-
+			while(1) {
 				CTRL ctrl = CTRL::NONE;
 				if(ctrl_task_ != nullptr) {
 					ctrl = (*ctrl_task_)();
@@ -238,11 +364,7 @@ namespace sound {
 					break;
 				} else if(ctrl == CTRL::REPLAY) {
 					out.mute();
-					fin.seek(utils::file_io::SEEK::SET, forg);
-					info = false;
-					pos = 0;
-					time_ = 0;
-					frame_count = 0;
+					restart(fin);
 					status = true;
 					pause = false;
 					continue;
@@ -255,62 +377,16 @@ namespace sound {
 					continue;
 				}
 
-				if(mad_frame_decode(&mad_frame_, &mad_stream_)) {
-					if(MAD_RECOVERABLE(mad_stream_.error)) {
-						continue;
-					} else {
-						if(mad_stream_.error == MAD_ERROR_BUFLEN) {
-							continue;
-						} else {
-							status = false;
-							break;
-						}
-					}
-				}
-
-				if(!info) {
-					set_sample_rate(mad_frame_.header.samplerate);
-					utils::format("Sample Rate: %d\n") % mad_frame_.header.samplerate;
-					info = true;
-				}
-
-				frame_count++;
-				mad_timer_add(&mad_timer_, mad_frame_.header.duration);
-
-				if(subband_filter_enable_) {
-					apply_filter_(mad_frame_);
-				}
-
-				mad_synth_frame(&mad_synth_, &mad_frame_);
-
-				for(uint32_t i = 0; i < mad_synth_.pcm.length; ++i) {
-					while((out.at_fifo().size() - out.at_fifo().length()) < 8) {
-					}
-					sound::wave_t t;
-					if(MAD_NCHANNELS(&mad_frame_.header) == 1) {
-						t.l_ch = t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i]);
-					} else {
-						t.l_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i]);
-						t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[1][i]);
-					}
-					out.at_fifo().put(t);
-					++pos;
-				}
-
-				{
-					uint32_t s = pos / mad_frame_.header.samplerate;
-					if(s != time_) {
-						if(update_task_ != nullptr) {
-							(*update_task_)(s);
-						}
-						time_ = s;
-					}
+				STEP st = step(fin, out);
+				if(st == STEP::END) {
+					break;
+				} else if(st == STEP::ERROR) {
+					status = false;
+					break;
 				}
 			}
 
-			mad_synth_finish(&mad_synth_);
-			mad_frame_finish(&mad_frame_);
-			mad_stream_finish(&mad_stream_);
+			close();
 
 			return status;
 		}
@@ -0,0 +1,374 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	プレイ・リスト・クラス @n
+			曲間が途切れない様に、出力の FIFO に余裕がある時（７／８以上溜まって @n
+			いる時）、次の曲のオープン、タグ（ヘッダー）の解析、先頭のデコードを @n
+			済ませておく。@n
+			曲の終わりでは、先読みしたサンプルを、そのまま続けて出力する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstring>
+#include "common/delay.hpp"
+#include "common/file_io.hpp"
+#include "common/fixed_fifo.hpp"
+#include "common/fixed_string.hpp"
+#include "sound/af_play.hpp"
+#include "sound/mp3_in.hpp"
+#include "sound/wav_in.hpp"
+
+namespace sound {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	プレイ・リスト・クラス
+		@param[in]	AUDIO_OUT	オーディオ出力（set_rate()、put()、mute()、@n
+								get_length()、get_size() を持つ、resampler 等）
+		@param[in]	QUEUE		登録できる曲数（＋１）
+		@param[in]	PRE_LEN		先読みするサンプル数（MP3 の１フレーム以上）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class AUDIO_OUT, uint32_t QUEUE = 32, uint32_t PRE_LEN = 2304>
+	class play_list : public af_play {
+	public:
+		typedef utils::fixed_string<128> PATH;
+
+	private:
+		static const uint32_t FRAME_MAX = 1152;	///< デコーダーが１ステップで出力する最大数
+
+		static_assert(PRE_LEN >= FRAME_MAX, "PRE_LEN must hold one MP3 frame.");
+
+		enum class TYPE : uint8_t {
+			NONE,
+			MP3,
+			WAV,
+		};
+
+		struct slot_t {
+			utils::file_io	fin;
+			TYPE		type;
+			bool		end;	///< 先読みで終端まで出力した
+			mp3_in		mp3;
+			wav_in		wav;
+
+			slot_t() noexcept : fin(), type(TYPE::NONE), end(false), mp3(), wav() { }
+		};
+
+		// 先読みしたサンプルを溜める（空きは、FRAME_MAX 以上ある時だけ書く）
+		struct stage_t {
+			wave_t		buf[PRE_LEN];
+			uint32_t	len;
+			uint32_t	rate;
+
+			stage_t() noexcept : len(0), rate(0) { }
+
+			void set_rate(uint32_t r) noexcept { rate = r; }
+
+			void put(const wave_t* src, uint32_t n) noexcept
+			{
+				for(uint32_t i = 0; i < n; ++i) {
+					buf[len + i] = src[i];
+				}
+				len += n;
+			}
+
+			void mute() noexcept { len = 0; }
+
+			uint32_t space() const noexcept { return PRE_LEN - len; }
+		};
+
+		enum class PREP : uint8_t {
+			IDLE,		///< 次の曲が無い
+			DECODE,		///< 先頭をデコード中
+			READY,		///< 準備完了
+		};
+
+		utils::fixed_fifo<PATH, QUEUE>	queue_;
+
+		slot_t		slot_[2];
+		uint8_t		cur_;
+		PREP		prep_;
+		stage_t		stage_;
+
+
+		static TYPE get_type_(const char* path) noexcept
+		{
+			const char* ext = std::strrchr(path, '.');
+			if(ext == nullptr) return TYPE::NONE;
+			if(std::strcmp(ext, ".mp3") == 0) {
+				return TYPE::MP3;
+			} else if(std::strcmp(ext, ".wav") == 0) {
+				return TYPE::WAV;
+			}
+			return TYPE::NONE;
+		}
+
+
+		bool open_(slot_t& s, const char* path)
+		{
+			TYPE type = get_type_(path);
+			if(type == TYPE::NONE) {
+				return false;
+			}
+			if(!s.fin.open(path, "rb")) {
+				return false;
+			}
+			bool ret;
+			if(type == TYPE::MP3) {
+				s.mp3.set_update_task(nullptr);
+				ret = s.mp3.open(s.fin);
+			} else {
+				s.wav.set_update_task(nullptr);
+				ret = s.wav.open(s.fin);
+			}
+			if(!ret) {
+				s.fin.close();
+				return false;
+			}
+			s.type = type;
+			s.end = false;
+			return true;
+		}
+
+
+		void close_(slot_t& s)
+		{
+			if(s.type == TYPE::MP3) {
+				s.mp3.close();
+			}
+			if(s.type != TYPE::NONE) {
+				s.fin.close();
+			}
+			s.type = TYPE::NONE;
+		}
+
+
+		void restart_(slot_t& s)
+		{
+			if(s.type == TYPE::MP3) {
+				s.mp3.restart(s.fin);
+			} else if(s.type == TYPE::WAV) {
+				s.wav.restart(s.fin);
+			}
+			s.end = false;
+		}
+
+
+		template <class OUT>
+		static STEP step_(slot_t& s, OUT& out)
+		{
+			switch(s.type) {
+			case TYPE::MP3:
+				return s.mp3.step(s.fin, out);
+			case TYPE::WAV:
+				return s.wav.step(s.fin, out);
+			default:
+				return STEP::ERROR;
+			}
+		}
+
+
+		// 次の曲の準備を、１段階（オープン、又は１フレームのデコード）進める
+		void prepare_()
+		{
+			slot_t& s = slot_[cur_ ^ 1];
+			switch(prep_) {
+			case PREP::IDLE:
+				if(queue_.length() > 0) {
+					PATH path = queue_.get();
+					if(open_(s, path.c_str())) {
+						stage_.len = 0;
+						prep_ = PREP::DECODE;
+					}
+				}
+				break;
+			case PREP::DECODE:
+				{
+					STEP st = step_(s, stage_);
+					if(st == STEP::END) {
+						s.end = true;
+						prep_ = PREP::READY;
+					} else if(st == STEP::ERROR) {
+						close_(s);
+						prep_ = PREP::IDLE;
+					} else if(stage_.space() < FRAME_MAX) {
+						prep_ = PREP::READY;
+					}
+				}
+				break;
+			case PREP::READY:
+				break;
+			}
+		}
+
+
+		// 次の曲があるか
+		bool pending_() const noexcept
+		{
+			return prep_ != PREP::IDLE || queue_.length() > 0;
+		}
+
+
+		void tag_(slot_t& s)
+		{
+			if(tag_task_ == nullptr) return;
+			if(s.type == TYPE::MP3) {
+				(*tag_task_)(s.mp3.get_tag());
+			} else {
+				(*tag_task_)(s.wav.get_tag());
+			}
+		}
+
+
+		// 先読みした曲に切り替える（準備ができていない場合は、ここで済ませる）
+		bool switch_(AUDIO_OUT& out, bool first)
+		{
+			close_(slot_[cur_]);
+			while(prep_ != PREP::READY) {
+				if(!pending_()) return false;
+				prepare_();
+			}
+			cur_ ^= 1;
+			prep_ = PREP::IDLE;
+
+			slot_t& s = slot_[cur_];
+			if(s.type == TYPE::MP3) {
+				s.mp3.set_update_task(update_task_);
+			} else {
+				s.wav.set_update_task(update_task_);
+			}
+			// 曲間では、タグの表示等は、先読みを出力して FIFO が満ちてから行う
+			if(first) {
+				tag_(s);
+			}
+			if(stage_.len > 0) {
+				out.set_rate(stage_.rate);
+				out.put(stage_.buf, stage_.len);
+			}
+			if(!first) {
+				tag_(s);
+			}
+			return true;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		play_list() noexcept : queue_(), slot_(), cur_(0), prep_(PREP::IDLE), stage_() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	曲を登録
+			@param[in]	path	ファイル・パス（拡張子「.mp3」、「.wav」）
+			@return 扱えない形式、又は、登録できない場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool add(const char* path) noexcept
+		{
+			if(path == nullptr || get_type_(path) == TYPE::NONE) {
+				return false;
+			}
+			if(queue_.length() >= (queue_.size() - 1)) {
+				return false;
+			}
+			queue_.put(PATH(path));
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録を全て消去（先読みした曲も閉じる）@n
+					再生中に、制御タスクから呼んで「STOP」を返すと、再生を終了する
+		*/
+		//-----------------------------------------------------------------//
+		void clear()
+		{
+			queue_.clear();
+			if(prep_ != PREP::IDLE) {
+				close_(slot_[cur_ ^ 1]);
+				prep_ = PREP::IDLE;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	まだ再生していない曲数を取得
+			@return 曲数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_length() const noexcept { return queue_.length(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録した曲を、順番に再生 @n
+					制御タスクの「STOP」は、次の曲に移る
+			@param[in]	out		オーディオ出力
+			@return 再生した曲数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t play(AUDIO_OUT& out)
+		{
+			uint32_t num = 0;
+			bool pause = false;
+			if(!switch_(out, true)) {
+				return num;
+			}
+			++num;
+			while(1) {
+				slot_t& s = slot_[cur_];
+				CTRL ctrl = CTRL::NONE;
+				if(ctrl_task_ != nullptr) {
+					ctrl = (*ctrl_task_)();
+				}
+				if(ctrl == CTRL::STOP) {
+					out.mute();
+					pause = false;
+					s.end = true;
+				} else if(ctrl == CTRL::REPLAY) {
+					out.mute();
+					restart_(s);
+					pause = false;
+					continue;
+				} else if(ctrl == CTRL::PAUSE) {
+					out.mute();
+					pause = !pause;
+				}
+
+				// 出力に余裕がある場合、次の曲を準備する
+				if(prep_ != PREP::READY && pending_()) {
+					if(pause || out.get_length() >= (out.get_size() - out.get_size() / 8)) {
+						prepare_();
+						continue;
+					}
+				}
+				if(pause) {
+					utils::delay::milli_second(2);
+					continue;
+				}
+
+				if(!s.end) {
+					STEP st = step_(s, out);
+					if(st == STEP::FRAME) {
+						continue;
+					}
+				}
+				if(!switch_(out, false)) {
+					break;
+				}
+				++num;
+			}
+			return num;
+		}
+	};
+}
@@ -0,0 +1,394 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	サンプリング・レート変換クラス @n
+			デコーダーと sound_out の間に入り、入力のレートを、固定の出力レート @n
+			に変換する（ポリフェーズ FIR、固定小数点）。@n
+			フィルターはカイザー窓の sinc で、レートを設定した時に作る。@n
+			MID、HIGH では、隣り合うフェーズの出力を直線補間する。@n
+			入力と出力のレートが同じ場合は、そのまま出力する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cmath>
+#include "sound/sound_out.hpp"
+
+namespace sound {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  サンプリング・レート変換クラス
+		@param[in]	SOUND_OUT	サウンド出力クラス（at_fifo()、mute() を持つ）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class SOUND_OUT>
+	class resampler {
+	public:
+		//=================================================================//
+		/*!
+			@brief  品質
+		*/
+		//=================================================================//
+		enum class QUALITY : uint8_t {
+			LOW,	///< ８タップ、６４フェーズ
+			MID,	///< １６タップ、１２８フェーズ、フェーズ間補間
+			HIGH,	///< ３２タップ、２５６フェーズ、フェーズ間補間
+		};
+
+		static const uint32_t COEF_BITS = 14;	///< 係数の小数部ビット数
+
+	private:
+		static const uint32_t TAPS_MAX  = 32;
+		static const uint32_t PHASE_MAX = 256;
+		static const uint32_t BLOCK_LEN = 64;	///< 出力をまとめて FIFO に書く数
+
+		struct param_t {
+			uint32_t	taps;
+			uint32_t	phase_bits;
+			float		beta;	///< カイザー窓のβ
+			float		roll;	///< 通過域の幅（ナイキスト周波数に対する比）
+			bool		interp;	///< フェーズ間補間
+		};
+
+		static const param_t& get_param_(QUALITY q) noexcept
+		{
+			static const param_t param[] = {
+				{  8, 6, 5.0f, 0.80f, false },
+				{ 16, 7, 7.0f, 0.87f, true  },
+				{ 32, 8, 9.0f, 0.91f, true  },
+			};
+			return param[static_cast<uint32_t>(q)];
+		}
+
+		SOUND_OUT&	out_;
+		uint32_t	out_rate_;
+		uint32_t	in_rate_;
+		QUALITY		quality_;
+		bool		bypass_;
+		bool		interp_;
+
+		uint32_t	taps_;
+		uint32_t	phase_shift_;
+		uint32_t	step_int_;
+		uint32_t	step_frac_;
+		uint32_t	frac_;
+		uint32_t	need_;
+		uint32_t	hpos_;
+
+		// 補間の為に、最後に１フェーズ（１サンプルずれた０フェーズ）を加える
+		int16_t		coef_[(PHASE_MAX + 1) * TAPS_MAX];
+		// 同じ値を２ヶ所に書いて、窓を常に連続した領域で読めるようにする
+		int16_t		hist_l_[TAPS_MAX * 2];
+		int16_t		hist_r_[TAPS_MAX * 2];
+
+
+		// ０次の変形ベッセル関数
+		static float bessel_i0_(float x) noexcept
+		{
+			float sum = 1.0f;
+			float t = 1.0f;
+			float q = x * x * 0.25f;
+			for(uint32_t k = 1; k < 32; ++k) {
+				t *= q / static_cast<float>(k * k);
+				sum += t;
+				if(t < (sum * 1e-8f)) break;
+			}
+			return sum;
+		}
+
+
+		void design_() noexcept
+		{
+			const param_t& prm = get_param_(quality_);
+			taps_ = prm.taps;
+			interp_ = prm.interp;
+			phase_shift_ = 32 - prm.phase_bits;
+			uint32_t phases = 1 << prm.phase_bits;
+
+			// 遮断周波数（入力サンプル当たりのサイクル）
+			float fc = 0.5f * prm.roll;
+			if(out_rate_ < in_rate_) {
+				fc *= static_cast<float>(out_rate_) / static_cast<float>(in_rate_);
+			}
+			const float pi = 3.14159265358979f;
+			float half = static_cast<float>(taps_ / 2);
+			float i0b = bessel_i0_(prm.beta);
+			for(uint32_t p = 0; p <= phases; ++p) {
+				float frac = static_cast<float>(p) / static_cast<float>(phases);
+				float h[TAPS_MAX];
+				float sum = 0.0f;
+				for(uint32_t k = 0; k < taps_; ++k) {
+					float x = static_cast<float>(k) - (half - 1.0f) - frac;
+					float s = 2.0f * fc;
+					if(x != 0.0f) {
+						s = std::sin(2.0f * pi * fc * x) / (pi * x);
+					}
+					float t = x / half;
+					float w = 0.0f;
+					if(t > -1.0f && t < 1.0f) {
+						w = bessel_i0_(prm.beta * std::sqrt(1.0f - t * t)) / i0b;
+					}
+					h[k] = s * w;
+					sum += h[k];
+				}
+				// フェーズ毎に、直流のゲインを１にする
+				int16_t* c = &coef_[p * taps_];
+				for(uint32_t k = 0; k < taps_; ++k) {
+					c[k] = static_cast<int16_t>(std::floor(h[k] / sum * (1 << COEF_BITS) + 0.5f));
+				}
+			}
+		}
+
+
+		void reset_() noexcept
+		{
+			for(uint32_t i = 0; i < (TAPS_MAX * 2); ++i) {
+				hist_l_[i] = 0;
+				hist_r_[i] = 0;
+			}
+			hpos_ = 0;
+			frac_ = 0;
+			need_ = taps_ / 2;
+		}
+
+
+		void setup_() noexcept
+		{
+			bypass_ = in_rate_ == out_rate_ || in_rate_ == 0;
+			if(!bypass_) {
+				uint64_t step = (static_cast<uint64_t>(in_rate_) << 32) / out_rate_;
+				step_int_  = step >> 32;
+				step_frac_ = static_cast<uint32_t>(step);
+				design_();
+			}
+			reset_();
+		}
+
+
+		// FIFO に空きが無い場合、空くまで待つ
+		void write_(const wave_t* src, uint32_t n) noexcept
+		{
+			auto& fifo = out_.at_fifo();
+			while(n > 0) {
+				uint32_t l = fifo.put(src, n);
+				src += l;
+				n -= l;
+			}
+		}
+
+
+		static int32_t mac_(const int16_t* h, const int16_t* x, uint32_t n) noexcept
+		{
+			int32_t a = 1 << (COEF_BITS - 1);
+			while(n > 0) {
+				a += static_cast<int32_t>(h[0]) * x[0];
+				a += static_cast<int32_t>(h[1]) * x[1];
+				a += static_cast<int32_t>(h[2]) * x[2];
+				a += static_cast<int32_t>(h[3]) * x[3];
+				h += 4;
+				x += 4;
+				n -= 4;
+			}
+			return a;
+		}
+
+
+		static uint16_t sat_(int32_t v) noexcept
+		{
+			v >>= COEF_BITS;
+			if(v > 32767) v = 32767;
+			else if(v < -32768) v = -32768;
+			return static_cast<uint16_t>(v);
+		}
+
+
+		void emit_(wave_t& t) noexcept
+		{
+			const int16_t* h = &coef_[(frac_ >> phase_shift_) * taps_];
+			const int16_t* l = &hist_l_[hpos_ + 1];
+			const int16_t* r = &hist_r_[hpos_ + 1];
+			int32_t al = mac_(h, l, taps_);
+			int32_t ar = mac_(h, r, taps_);
+			if(interp_) {
+				// フェーズ内の位置（１６ビット）で、次のフェーズの出力と補間
+				int64_t f = (frac_ << (32 - phase_shift_)) >> 16;
+				const int16_t* h1 = h + taps_;
+				al += ((mac_(h1, l, taps_) - al) * f) >> 16;
+				ar += ((mac_(h1, r, taps_) - ar) * f) >> 16;
+			}
+			t.l_ch = sat_(al);
+			t.r_ch = sat_(ar);
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	out			サウンド出力
+			@param[in]	out_rate	出力のサンプリング・レート
+			@param[in]	quality		品質
+		*/
+		//-----------------------------------------------------------------//
+		resampler(SOUND_OUT& out, uint32_t out_rate, QUALITY quality = QUALITY::MID) noexcept :
+			out_(out), out_rate_(out_rate), in_rate_(out_rate), quality_(quality),
+			bypass_(true), interp_(false), taps_(get_param_(quality).taps), phase_shift_(0),
+			step_int_(1), step_frac_(0), frac_(0), need_(0), hpos_(0)
+		{
+			reset_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  入力のサンプリング・レートを設定 @n
+					レートが変わらない場合、フィルターの状態を保つ（曲間が途切れない）
+			@param[in]	rate	入力のサンプリング・レート
+		*/
+		//-----------------------------------------------------------------//
+		void set_rate(uint32_t rate) noexcept
+		{
+			if(rate == in_rate_) return;
+			in_rate_ = rate;
+			setup_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  入力のサンプリング・レートを取得
+			@return 入力のサンプリング・レート
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_rate() const noexcept { return in_rate_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  出力のサンプリング・レートを取得
+			@return 出力のサンプリング・レート
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_output_rate() const noexcept { return out_rate_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  品質を設定
+			@param[in]	quality	品質
+		*/
+		//-----------------------------------------------------------------//
+		void set_quality(QUALITY quality) noexcept
+		{
+			if(quality == quality_) return;
+			quality_ = quality;
+			taps_ = get_param_(quality).taps;
+			setup_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  品質を取得
+			@return 品質
+		*/
+		//-----------------------------------------------------------------//
+		QUALITY get_quality() const noexcept { return quality_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  変換しているか
+			@return 入力をそのまま出力している場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool is_convert() const noexcept { return !bypass_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  出力の FIFO に溜まっている数を取得
+			@return 出力の FIFO に溜まっている数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_length() noexcept { return out_.at_fifo().length(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  出力の FIFO のサイズを取得
+			@return 出力の FIFO のサイズ
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_size() noexcept { return out_.at_fifo().size(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ミュート（フィルターの状態も消去）
+		*/
+		//-----------------------------------------------------------------//
+		void mute() noexcept
+		{
+			out_.mute();
+			reset_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルをまとめて入力 @n
+					出力の FIFO に空きが無い場合、空くまで待つ
+			@param[in]	src	サンプル（符号付き１６ビット）
+			@param[in]	n	数
+		*/
+		//-----------------------------------------------------------------//
+		void put(const wave_t* src, uint32_t n) noexcept
+		{
+			if(bypass_) {
+				write_(src, n);
+				return;
+			}
+
+			wave_t buf[BLOCK_LEN];
+			uint32_t m = 0;
+			for(uint32_t i = 0; i < n; ++i) {
+				hpos_ = (hpos_ + 1) % taps_;
+				hist_l_[hpos_] = hist_l_[hpos_ + taps_] = static_cast<int16_t>(src[i].l_ch);
+				hist_r_[hpos_] = hist_r_[hpos_ + taps_] = static_cast<int16_t>(src[i].r_ch);
+				--need_;
+				if(need_ > 0) continue;
+
+				// 次に必要な入力数を求めるまで出力（アップ・サンプルでは複数）
+				while(1) {
+					emit_(buf[m]);
+					++m;
+					if(m >= BLOCK_LEN) {
+						write_(buf, m);
+						m = 0;
+					}
+					uint32_t f = frac_ + step_frac_;
+					uint32_t adv = step_int_ + (f < frac_ ? 1 : 0);
+					frac_ = f;
+					if(adv > 0) {
+						need_ = adv;
+						break;
+					}
+				}
+			}
+			write_(buf, m);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルを入力
+			@param[in]	t	サンプル（符号付き１６ビット）
+		*/
+		//-----------------------------------------------------------------//
+		void put(const wave_t& t) noexcept { put(&t, 1); }
+	};
+}
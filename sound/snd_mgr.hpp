@@ -2,8 +2,8 @@
 //=====================================================================//
 /*!	@file
 	@brief	サウンド・マネージャー @n
-			登録した PCM データの発音制御 @n
-			非常にシンプルな構成で、基本的な動作のみ実装
+			登録した PCM データ（８ビット、１６ビット）の発音制御 @n
+			ミックスは sound::mixer で行う
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -12,6 +12,7 @@
 //=====================================================================//
 #include <memory>
 #include "sound/wav_in.hpp"
+#include "sound/mixer.hpp"
 
 namespace sound {
 
@@ -21,31 +22,49 @@ namespace sound {
 		@param[in]	CTXMAX	最大登録数
 		@param[in]	SNDMAX	同時発音数
 		@param[in]	RDRLEN	レンダリング・バッファ長さ
+		@param[in]	BLKLEN	ミックスのブロック長さ（４の倍数）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <uint32_t CTXMAX, uint32_t SNDMAX, uint32_t RDRLEN>
+	template <uint32_t CTXMAX, uint32_t SNDMAX, uint32_t RDRLEN, uint32_t BLKLEN = 128>
 	class snd_mgr {
+	public:
+		typedef mixer<SNDMAX, RDRLEN, BLKLEN> MIXER;
 
-		typedef std::shared_ptr<const int8_t> WAV_PTR;
+	private:
+		typedef std::shared_ptr<const void> WAV_PTR;
 
 		struct ctx_t {
-			WAV_PTR		org_;
-			uint32_t	len_;
-			ctx_t() : org_(), len_(0) { }
+			WAV_PTR			own_;	///< ファイルからロードした場合に保持
+			const int8_t*	org8_;
+			const int16_t*	org16_;
+			uint32_t		len_;
+			ctx_t() : own_(), org8_(nullptr), org16_(nullptr), len_(0) { }
 		};
 		ctx_t	ctx_[CTXMAX];
 
-		struct snd_t {
-			uint32_t	ctx_;
-			uint32_t	pos_;
-			bool		loop_;
-			snd_t() : ctx_(CTXMAX), pos_(0), loop_(false) { }
-		};
-		snd_t	snd_[SNDMAX];
+		MIXER	mixer_;
 
-		int16_t	final_[RDRLEN];
+		template <typename T>
+		uint32_t set_ctx_(const T* org, uint32_t len, const WAV_PTR& own) noexcept
+		{
+			if(org == nullptr || len == 0) return CTXMAX;
 
-		uint32_t	dec_;
+			for(uint32_t i = 0; i < CTXMAX; ++i) {
+				ctx_t& ctx = ctx_[i];
+				if(ctx.len_ == 0) {
+					ctx.own_ = own;
+					ctx.org8_ = nullptr;
+					ctx.org16_ = nullptr;
+					set_org_(ctx, org);
+					ctx.len_ = len;
+					return i;
+				}
+			}
+			return CTXMAX;
+		}
+
+		static void set_org_(ctx_t& ctx, const int8_t* org) noexcept { ctx.org8_ = org; }
+		static void set_org_(ctx_t& ctx, const int16_t* org) noexcept { ctx.org16_ = org; }
 
 	public:
 		//-----------------------------------------------------------------//
@@ -53,7 +72,7 @@ namespace sound {
 			@brief  コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		snd_mgr() noexcept : dec_(0) { }
+		snd_mgr() noexcept { }
 
 
 		//-----------------------------------------------------------------//
@@ -76,28 +95,38 @@ namespace sound {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  サウンド・コンテキストの登録（８ビット）
+			@brief  サウンド・コンテキストの登録（８ビット）@n
+					データは解放しないので、登録している間は保持する事
 			@param[in]	org	サウンド・データ先頭
-			@param[in]	len	サウンド・データ長さ（バイト）
+			@param[in]	len	サウンド・データ長さ（サンプル）
 			@return	コンテキストのハンドル
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t set_sound(const int8_t* org, uint32_t len)
+		uint32_t set_sound(const int8_t* org, uint32_t len) noexcept
 		{
-			for(uint32_t i = 0; i < CTXMAX; ++i) {
-				if(ctx_[i].len_ == 0) {
-					ctx_[i].org_ = WAV_PTR(org);
-					ctx_[i].len_ = len;
-					return i;
-				}
-			}
-			return CTXMAX;
+			return set_ctx_(org, len, WAV_PTR());
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サウンド・コンテキストの登録（１６ビット）@n
+					データは解放しないので、登録している間は保持する事
+			@param[in]	org	サウンド・データ先頭
+			@param[in]	len	サウンド・データ長さ（サンプル）
+			@return	コンテキストのハンドル
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t set_sound(const int16_t* org, uint32_t len) noexcept
+		{
+			return set_ctx_(org, len, WAV_PTR());
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  サウンド・コンテキストの登録
+			@brief  サウンド・コンテキストの登録 @n
+					８ビット、１６ビットの WAV（ステレオはモノラルにする）
 			@param[in]	filename	ファイル名
 			@return	コンテキストハンドル
 		*/
@@ -113,28 +142,55 @@ namespace sound {
 			tag_t tag;
 			if(!wav.load_header(in, tag)) {
 				in.close();
-				return false;
+				return CTXMAX;
 			}
 
 			utils::format("Rate: %d, Bits: %d\n") % wav.get_rate() % wav.get_bits();
 
-			if(!in.seek(utils::file_io::SEEK::SET, wav.get_top())) {
+			uint32_t bits = wav.get_bits();
+			uint32_t chn = wav.get_channel();
+			if((bits != 8 && bits != 16) || (chn != 1 && chn != 2)) {
 				in.close();
-				return false;
+				return CTXMAX;
 			}
 
-			uint32_t len = wav.get_size();
-			int8_t* org = new int8_t[len];
-			if(in.read(org, len) != len) {
+			if(!in.seek(utils::file_io::SEEK::SET, wav.get_top())) {
 				in.close();
 				return CTXMAX;
 			}
-			in.close();
-			for(uint32_t i = 0; i < len; ++i) {
-				org[i] ^= 0x80;
-			}
 
-			return set_sound(org, len);
+			uint32_t len = wav.get_size() / (bits / 8) / chn;
+			uint32_t size = len * (bits / 8) * chn;
+			uint32_t hnd = CTXMAX;
+			if(bits == 8) {
+				int8_t* org = new int8_t[size];
+				WAV_PTR own(org, std::default_delete<int8_t[]>());
+				if(in.read(org, size) == size) {
+					for(uint32_t i = 0; i < len; ++i) {
+						if(chn == 2) {
+							int32_t l = static_cast<int8_t>(org[i * 2] ^ 0x80);
+							int32_t r = static_cast<int8_t>(org[i * 2 + 1] ^ 0x80);
+							org[i] = (l + r) >> 1;
+						} else {
+							org[i] ^= 0x80;
+						}
+					}
+					hnd = set_ctx_(static_cast<const int8_t*>(org), len, own);
+				}
+			} else {
+				int16_t* org = new int16_t[size / 2];
+				WAV_PTR own(org, std::default_delete<int16_t[]>());
+				if(in.read(org, size) == size) {
+					if(chn == 2) {
+						for(uint32_t i = 0; i < len; ++i) {
+							org[i] = (static_cast<int32_t>(org[i * 2]) + org[i * 2 + 1]) >> 1;
+						}
+					}
+					hnd = set_ctx_(static_cast<const int16_t*>(org), len, own);
+				}
+			}
+			in.close();
+			return hnd;
 		}
 
 
@@ -143,23 +199,22 @@ namespace sound {
 			@brief  サウンド・リクエスト
 			@param[in]	ctxhnd	コンテキスト・ハンドル
 			@param[in]	loop	ループの場合「true」
+			@param[in]	gain	ゲイン（MIXER::GAIN_ONE で等倍）
+			@param[in]	pan		パン（MIXER::PAN_LEFT 〜 MIXER::PAN_RIGHT、０で中央）
 			@return	発音ハンドル
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t request(uint32_t ctxhnd, bool loop = false) noexcept
+		uint32_t request(uint32_t ctxhnd, bool loop = false,
+			uint16_t gain = MIXER::GAIN_ONE, int8_t pan = 0) noexcept
 		{
 			if(ctxhnd >= CTXMAX) return SNDMAX;
 
-			for(uint32_t i = 0; i < SNDMAX; ++i) {
-				if(snd_[i].ctx_ < CTXMAX) {
-					continue;
-				}
-				snd_[i].ctx_  = ctxhnd;
-				snd_[i].pos_  = 0;
-				snd_[i].loop_ = loop;
-				return i;
+			const ctx_t& ctx = ctx_[ctxhnd];
+			if(ctx.org16_ != nullptr) {
+				return mixer_.play(ctx.org16_, ctx.len_, loop, gain, pan);
+			} else {
+				return mixer_.play(ctx.org8_, ctx.len_, loop, gain, pan);
 			}
-			return SNDMAX;
 		}
 
 
@@ -170,18 +225,7 @@ namespace sound {
 			@return	成功なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool stop(uint32_t sndhnd) noexcept
-		{
-			if(sndhnd >= SNDMAX) return false;
-
-			snd_t& snd = snd_[sndhnd];
-			if(snd.ctx_ < CTXMAX) {
-				snd.ctx_ = CTXMAX;
-				return true;
-			} else {
-				return false;
-			}
-		}
+		bool stop(uint32_t sndhnd) noexcept { return mixer_.stop(sndhnd); }
 
 
 		//-----------------------------------------------------------------//
@@ -191,55 +235,39 @@ namespace sound {
 			@return	発音中なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool status(uint32_t sndhnd) const noexcept
-		{
-			if(sndhnd >= SNDMAX) return false;
+		bool status(uint32_t sndhnd) const noexcept { return mixer_.status(sndhnd); }
+
 
-			const snd_t& snd = snd_[sndhnd];
-			return snd.ctx_ < CTXMAX;
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ゲイン、パンの設定
+			@param[in]	sndhnd	発音ハンドル
+			@param[in]	gain	ゲイン（MIXER::GAIN_ONE で等倍）
+			@param[in]	pan		パン（０で中央）
+			@return	成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool set_gain(uint32_t sndhnd, uint16_t gain, int8_t pan = 0) noexcept {
+			return mixer_.set_gain(sndhnd, gain, pan);
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  サウンドバッファを更新
-			@param[in]	dec	レンダリング数のマイナス調整
+			@brief  マスター・ゲインの設定
+			@param[in]	gain	ゲイン（最大 MIXER::GAIN_ONE）
 		*/
 		//-----------------------------------------------------------------//
-		void update(uint32_t dec = 0) noexcept
-		{
-			dec_ = dec;
+		void set_master(uint16_t gain) noexcept { mixer_.set_master(gain); }
 
-			for(uint32_t i = 0; i < (RDRLEN - dec); ++i) {
-				final_[i] = 0;
-			}
 
-			for(uint32_t i = 0; i < (SNDMAX - dec); ++i) {
-				snd_t& snd = snd_[i];
-				if(snd.ctx_ >= CTXMAX) {
-					continue;
-				}
-				ctx_t& ctx = ctx_[snd.ctx_];
-				const int8_t* org = ctx.org_.get();
-				for(uint32_t j = 0; j < RDRLEN; ++j) {
-					if(snd.pos_ >= ctx.len_) {
-						if(snd.loop_) {
-							snd.pos_ = 0;
-						} else {
-							snd.ctx_ = CTXMAX;
-						}
-						break;
-					}
-					final_[j] += org[snd.pos_];
-					++snd.pos_;
-				}
-			}
-
-			// 最終ゲイン調整
-			for(uint32_t i = 0; i < (RDRLEN - dec); ++i) {
-				final_[i] *= 256 / SNDMAX;
-			}
-		}
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サウンドバッファを更新
+			@param[in]	dec	レンダリング数のマイナス調整
+		*/
+		//-----------------------------------------------------------------//
+		void update(uint32_t dec = 0) noexcept { mixer_.update(dec); }
 
 
 		//-----------------------------------------------------------------//
@@ -248,19 +276,24 @@ namespace sound {
 			@return	サウンドバッファ・サイズ
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t get_length() const noexcept {
-			return RDRLEN - dec_;
-		}
+		uint32_t get_length() const noexcept { return mixer_.get_length(); }
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  サウンドバッファの取得（最終）
+			@brief  サウンドバッファの取得（最終、ステレオ）
 			@return	サウンドバッファ
 		*/
 		//-----------------------------------------------------------------//
-		const int16_t* get_buffer() const noexcept {
-			return final_;
-		}
+		const wave_t* get_buffer() const noexcept { return mixer_.get_buffer(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ミキサーの参照
+			@return	ミキサー
+		*/
+		//-----------------------------------------------------------------//
+		MIXER& at_mixer() noexcept { return mixer_; }
 	};
 }
@@ -50,6 +50,45 @@ namespace utils {
 
 		FIFO		fifo_;
 
+		// 符号付きから、オフセット付きに変換して転送
+		static void copy_(sound::wave_t* dst, const sound::wave_t* src, uint32_t n) noexcept
+		{
+			while(n >= 4) {
+				dst[0].l_ch = src[0].l_ch ^ 0x8000;
+				dst[0].r_ch = src[0].r_ch ^ 0x8000;
+				dst[1].l_ch = src[1].l_ch ^ 0x8000;
+				dst[1].r_ch = src[1].r_ch ^ 0x8000;
+				dst[2].l_ch = src[2].l_ch ^ 0x8000;
+				dst[2].r_ch = src[2].r_ch ^ 0x8000;
+				dst[3].l_ch = src[3].l_ch ^ 0x8000;
+				dst[3].r_ch = src[3].r_ch ^ 0x8000;
+				dst += 4;
+				src += 4;
+				n -= 4;
+			}
+			while(n > 0) {
+				dst->l_ch = src->l_ch ^ 0x8000;
+				dst->r_ch = src->r_ch ^ 0x8000;
+				++dst;
+				++src;
+				--n;
+			}
+		}
+
+
+		// 波形メモリの終端で分けて転送
+		void copy_wave_(const sound::wave_t* src, uint32_t n) noexcept
+		{
+			while(n > 0) {
+				uint32_t l = OUTS - w_put_;
+				if(l > n) l = n;
+				copy_(&wave_[w_put_], src, l);
+				w_put_ = (w_put_ + l) & (OUTS - 1);
+				src += l;
+				n -= l;
+			}
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -115,21 +154,37 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	サービス
+			@brief	まとめて FIFO に格納 @n
+					空きが無い場合、割り込み（service）で空くまで待つ
+			@param[in]	src	波形（符号付き１６ビット）
+			@param[in]	n	数
+		*/
+		//-----------------------------------------------------------------//
+		void put(const sound::wave_t* src, uint32_t n) noexcept
+		{
+			while(n > 0) {
+				uint32_t l = fifo_.put(src, n);
+				src += l;
+				n -= l;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（FIFO の連続した領域毎に、波形メモリへ転送）
 			@param[in]	num	波形メモリに移動する数
 		*/
 		//-----------------------------------------------------------------//
 		void service(uint32_t num) noexcept
 		{
-			if(fifo_.length() < num) return;
-
-			for(uint32_t i = 0; i < num; ++i) {
-				wave_[w_put_] = fifo_.get();
-				wave_[w_put_].l_ch ^= 0x8000;
-				wave_[w_put_].r_ch ^= 0x8000;
-				++w_put_;
-				w_put_ &= (OUTS - 1);
-			}
+			auto sp = fifo_.read_span();
+			if(sp.size() < num) return;
+
+			uint32_t l = num < sp.len[0] ? num : sp.len[0];
+			copy_wave_(sp.org[0], l);
+			copy_wave_(sp.org[1], num - l);
+			fifo_.get_go(num);
 		}
 	};
 }
@@ -55,8 +55,11 @@ namespace sound {
 		uint8_t		channel_;
 		uint8_t		bits_;
 
+		uint32_t	pos_;
 		uint32_t	time_;
 
+		tag_t		tag_;
+
 
 		bool list_tag_(utils::file_io& fi, uint16_t size, char* dst, uint32_t dstlen) noexcept
 		{
@@ -84,7 +87,7 @@ namespace sound {
 		*/
 		//-------------------------------------------------------------//
 		wav_in() noexcept : data_top_(0), data_size_(0), data_pos_(0),
-			rate_(0), channel_(0), bits_(0), time_(0) { }
+			rate_(0), channel_(0), bits_(0), pos_(0), time_(0), tag_() { }
 
 
 		//-------------------------------------------------------------//
@@ -190,29 +193,136 @@ namespace sound {
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	オープン（ヘッダーを解析して、データの先頭に移動）
+			@param[in]	fin	ファイルＩ／Ｏ
+			@return 扱えるフォーマットなら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool open(utils::file_io& fin) noexcept
+		{
+			tag_.clear();
+			if(!load_header(fin, tag_)) {
+				return false;
+			}
+			if((bits_ != 8 && bits_ != 16) || (channel_ != 1 && channel_ != 2) || rate_ == 0) {
+				return false;
+			}
+			pos_ = 0;
+			time_ = 0;
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	曲の先頭に戻る
+			@param[in]	fin	ファイルＩ／Ｏ
+		*/
+		//-------------------------------------------------------------//
+		void restart(utils::file_io& fin) noexcept
+		{
+			fin.seek(utils::file_io::SEEK::SET, data_top_);
+			data_pos_ = 0;
+			pos_ = 0;
+			time_ = 0;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	１ブロック（最大２５６サンプル）をデコード
+			@param[in]	fin	ファイルＩ／Ｏ
+			@param[in]	out	オーディオ出力（set_rate()、put() を持つ）
+			@return 結果
+		*/
+		//-------------------------------------------------------------//
+		template <class AUDIO_OUT>
+		STEP step(utils::file_io& fin, AUDIO_OUT& out) noexcept
+		{
+			uint32_t unit = (bits_ / 8) * channel_;
+			uint32_t n = (data_size_ - data_pos_) / unit;
+			if(data_pos_ >= data_size_ || n == 0) {
+				return STEP::END;
+			}
+			if(n > 256) n = 256;
+			if(pos_ == 0) {
+				out.set_rate(rate_);
+			}
+
+			uint8_t tmp[1024];
+			if(fin.read(tmp, unit * n) != (unit * n)) {
+				utils::format("Read fail abort...\n");
+				return STEP::ERROR;
+			}
+			sound::wave_t wav[256];
+			const sound::wave_t* blk = wav;
+			if(bits_ == 16) {
+				const uint16_t* src = reinterpret_cast<const uint16_t*>(tmp);
+				if(get_channel() == 2) {  // 並びが同じなので、そのまま渡す
+					blk = reinterpret_cast<const sound::wave_t*>(src);
+				} else {
+					for(uint32_t i = 0; i < n; ++i) {
+						wav[i].l_ch = wav[i].r_ch = src[i];
+					}
+				}
+			} else {  // 8 bits
+				const uint8_t* src = reinterpret_cast<const uint8_t*>(tmp);
+				for(uint32_t i = 0; i < n; ++i) {
+					sound::wave_t& t = wav[i];
+					if(get_channel() == 2) {
+						t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
+						t.l_ch |= (src[0] & 0x7f) << 1;
+						t.r_ch = static_cast<uint16_t>(src[1] ^ 0x80) << 8;
+						t.r_ch |= (src[1] & 0x7f) << 1;
+						src += 2;
+					} else {
+						t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
+						t.l_ch |= (src[0] & 0x7f) << 1;
+						t.r_ch = t.l_ch;
+						++src;
+					}
+				}
+			}
+			out.put(blk, n);
+			pos_ += n;
+			data_pos_ += unit * n;
+
+			{
+				uint32_t s = pos_ / rate_;
+				if(s != time_) {
+					if(update_task_ != nullptr) {
+						(*update_task_)(s);
+					}
+					time_ = s;
+				}
+			}
+			return STEP::FRAME;
+		}
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	デコード
-			@param[in]	fi	ファイルＩ／Ｏ
+			@param[in]	fin	ファイルＩ／Ｏ
+			@param[in]	out	オーディオ出力（set_rate()、put()、mute() を持つ、resampler 等）
 			@return 正常終了なら「true」
 		*/
 		//-------------------------------------------------------------//
 		template <class SOUND_OUT>
 		bool decode(utils::file_io& fin, SOUND_OUT& out) noexcept
 		{
-			tag_t tag;
-			if(!load_header(fin, tag)) {
+			if(!open(fin)) {
 				return false;
 			}
 			if(tag_task_ != nullptr) {
-				(*tag_task_)(tag);
+				(*tag_task_)(tag_);
 			}
 
 			bool status = true;
 			bool pause = false;
-			uint32_t pos = 0;
-			time_ = 0;
-			while(data_pos_ < data_size_) {
+			while(1) {
 				CTRL ctrl = CTRL::NONE;
 				if(ctrl_task_ != nullptr) {
 					ctrl = (*ctrl_task_)();
@@ -223,9 +333,7 @@ namespace sound {
 					break;
 				} else if(ctrl == CTRL::REPLAY) {
 					out.mute();
-					fin.seek(utils::file_io::SEEK::SET, data_top_);
-					pos = 0;
-					time_ = 0;
+					restart(fin);
 					status = true;
 					pause = false;
 					continue;
@@ -238,70 +346,28 @@ namespace sound {
 					continue;
 				}
 
-				uint32_t unit = (bits_ / 8) * channel_;
-				uint8_t tmp[1024];
-				if(fin.read(tmp, unit * 256) != (unit * 256)) {
-					utils::format("Read fail abort...\n");
+				STEP st = step(fin, out);
+				if(st == STEP::END) {
+					break;
+				} else if(st == STEP::ERROR) {
 					out.mute();
 					status = false;
 					break;
 				}
-				if(bits_ == 16) {
-					const uint16_t* src = reinterpret_cast<const uint16_t*>(tmp);
-					for(uint32_t i = 0; i < 256; ++i) {
-						while((out.at_fifo().size() - out.at_fifo().length()) < 8) {
-						}
-						sound::wave_t t;
-						if(get_channel() == 2) {
-							t.l_ch = src[0];
-							t.r_ch = src[1];
-							src += 2;
-						} else {
-							t.l_ch = src[0];
-							t.r_ch = t.l_ch;
-							++src;
-						}
-						out.at_fifo().put(t);
-						++pos;
-					}
-				} else {  // 8 bits
-					const uint8_t* src = reinterpret_cast<const uint8_t*>(tmp);
-					for(uint32_t i = 0; i < 256; ++i) {
-						while((out.at_fifo().size() - out.at_fifo().length()) < 8) {
-						}
-						sound::wave_t t;
-						if(get_channel() == 2) {
-							t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
-							t.l_ch |= (src[0] & 0x7f) << 1;
-							t.r_ch = static_cast<uint16_t>(src[1] ^ 0x80) << 8;
-							t.r_ch |= (src[1] & 0x7f) << 1;
-							src += 2;
-						} else {
-							t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
-							t.l_ch |= (src[0] & 0x7f) << 1;
-							t.r_ch = t.l_ch;
-							++src;
-						}
-						out.at_fifo().put(t);
-						++pos;
-					}
-				}
-
-				{
-					uint32_t s = pos / rate_;
-					if(s != time_) {
-						if(update_task_ != nullptr) {
-							(*update_task_)(s);
-						}
-						time_ = s;
-					}
-				}
-				data_pos_ += unit;
 			}
 			return status;
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	タグ情報を取得（open の後で有効）
+			@return タグ情報
+		*/
+		//-------------------------------------------------------------//
+		const tag_t& get_tag() const noexcept { return tag_; }
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	データ先頭のファイル位置を返す
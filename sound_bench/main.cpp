@@ -0,0 +1,1125 @@
+//=====================================================================//
+/*!	@file
+	@brief	sound ベンチマーク（ホスト用）@n
+			「-mixer」sound::mixer のミックス結果を、６４ビットで計算した場合と @n
+			比較し、ボイス数毎の処理速度（ボイス×サンプル／秒）を、@n
+			従来の snd_mgr のミックスと比較する。@n
+			「-resample」sound::resampler の品質毎の THD+N（正弦波を最小二乗で @n
+			当てはめた残差）と、処理速度を、直線補間と比較する。@n
+			「-fifo」デコーダーから sound_out の波形メモリまでの転送を、@n
+			１サンプル毎の put/get と、連続領域（span）毎の転送で比較する。@n
+			「-mp3」MP3 デコード後段（サブバンド・フィルター、PCM 変換）の @n
+			フレーム／秒を、従来のループ、カーネル（ポータブル、SIMD）で比較する。@n
+			ホストには libmad 本体が無いので、フレームは合成した値を使う。@n
+			「-playlist」sound::play_list と、曲毎の decode で、曲間のアンダーランを @n
+			比較する。file_io はホストのファイルを使い、SD カードのアクセス時間は @n
+			仮想時間で進める（libmad は、デコードできないダミー）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "sound/mixer.hpp"
+#include "sound/resampler.hpp"
+#include "sound/mad_kernel.hpp"
+#include "sound/play_list.hpp"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	struct option_t {
+		uint32_t	frames = 2000;
+	};
+	option_t	opt_;
+
+	uint32_t	seed_;
+	uint32_t rand_() {
+		seed_ = seed_ * 1103515245 + 12345;
+		return (seed_ >> 16) & 0x7fff;
+	}
+
+	static const uint32_t SNDMAX = 16;
+	static const uint32_t RDRLEN = 1024;
+	typedef sound::mixer<SNDMAX, RDRLEN> MIXER;
+	static const uint32_t MIXER_REPEAT = 10;	///< 速度計測の繰り返し（最短を使う）
+
+	// ソース（長さを変えて、ブロックの途中でループ、終了する様にする）
+	struct source_t {
+		std::vector<int8_t>		w8;
+		std::vector<int16_t>	w16;
+	};
+	source_t	src_[SNDMAX];
+
+	void make_source_()
+	{
+		seed_ = 12345;
+		for(uint32_t i = 0; i < SNDMAX; ++i) {
+			uint32_t len = 1500 + rand_() % 3000;
+			src_[i].w8.resize(len);
+			src_[i].w16.resize(len);
+			for(uint32_t j = 0; j < len; ++j) {
+				int16_t v = static_cast<int16_t>(rand_() * 2 - 0x8000);
+				src_[i].w16[j] = v;
+				src_[i].w8[j] = static_cast<int8_t>(v >> 8);
+			}
+		}
+	}
+
+
+	// ６４ビットで計算する、ミキサーの参照実装
+	struct ref_voice_t {
+		uint32_t	idx;
+		bool		w16;
+		uint32_t	pos;
+		bool		loop;
+		bool		play;
+		int64_t		gl;
+		int64_t		gr;
+	};
+
+	void ref_gain_(ref_voice_t& v, uint16_t gain, int8_t pan, uint16_t master)
+	{
+		int64_t g = (static_cast<int64_t>(gain) * master) >> 8;
+		int64_t l = pan > 0 ? 127 - pan : 127;
+		int64_t r = pan < 0 ? 127 + pan : 127;
+		v.gl = g * l / 127;
+		v.gr = g * r / 127;
+		if(!v.w16) {
+			v.gl *= 256;
+			v.gr *= 256;
+		}
+	}
+
+	int16_t ref_sat_(int64_t v)
+	{
+		v >>= 8;
+		if(v > 32767) v = 32767;
+		else if(v < -32768) v = -32768;
+		return static_cast<int16_t>(v);
+	}
+
+	void ref_update_(std::vector<ref_voice_t>& vs, int16_t* out)
+	{
+		for(uint32_t i = 0; i < RDRLEN; ++i) {
+			int64_t l = 0;
+			int64_t r = 0;
+			for(auto& v : vs) {
+				if(!v.play) continue;
+				const source_t& s = src_[v.idx];
+				int64_t a = v.w16 ? s.w16[v.pos] : s.w8[v.pos];
+				l += a * v.gl;
+				r += a * v.gr;
+				++v.pos;
+				if(v.pos >= s.w16.size()) {
+					if(v.loop) v.pos = 0;
+					else v.play = false;
+				}
+			}
+			out[i * 2 + 0] = ref_sat_(l);
+			out[i * 2 + 1] = ref_sat_(r);
+		}
+	}
+
+
+	bool mixer_check_()
+	{
+		static MIXER mixer;
+		std::vector<ref_voice_t> ref;
+		static const uint16_t master = 200;
+		mixer.set_master(master);
+		for(uint32_t i = 0; i < SNDMAX; ++i) {
+			ref_voice_t v;
+			v.idx  = i;
+			v.w16  = (i & 1) == 0;
+			v.pos  = 0;
+			v.loop = (i % 3) != 0;
+			v.play = true;
+			uint16_t gain = 64 + rand_() % 400;
+			int8_t pan = static_cast<int8_t>(static_cast<int32_t>(rand_() % 255) - 127);
+			// 等倍、中央のボイス（DIRECT8、DIRECT16）も混ぜる
+			if((i % 4) == 1 || (i % 4) == 2) {
+				gain = MIXER::GAIN_ONE;
+				pan = 0;
+			}
+			ref_gain_(v, gain, pan, master);
+			uint32_t h;
+			if(v.w16) {
+				h = mixer.play(&src_[i].w16[0], src_[i].w16.size(), v.loop, gain, pan);
+			} else {
+				h = mixer.play(&src_[i].w8[0], src_[i].w8.size(), v.loop, gain, pan);
+			}
+			if(h != i) {
+				printf("mixer   : play handle error %u (%u)\n", h, i);
+				return false;
+			}
+			ref.push_back(v);
+		}
+
+		uint32_t err = 0;
+		uint32_t sat = 0;
+		std::vector<int16_t> out(RDRLEN * 2);
+		for(uint32_t n = 0; n < 20; ++n) {
+			ref_update_(ref, &out[0]);
+			mixer.update();
+			const sound::wave_t* w = mixer.get_buffer();
+			for(uint32_t i = 0; i < RDRLEN; ++i) {
+				if(static_cast<int16_t>(w[i].l_ch) != out[i * 2 + 0]) ++err;
+				if(static_cast<int16_t>(w[i].r_ch) != out[i * 2 + 1]) ++err;
+				if(out[i * 2] == 32767 || out[i * 2] == -32768) ++sat;
+			}
+		}
+		uint32_t stop = 0;
+		for(uint32_t i = 0; i < SNDMAX; ++i) {
+			if(mixer.status(i) != ref[i].play) ++err;
+			if(!mixer.status(i)) ++stop;
+		}
+		printf("mixer   : %u voices, %u samples, error: %u, saturate: %u, stop: %u -> %s\n",
+			SNDMAX, RDRLEN * 20, err, sat, stop, err == 0 ? "match" : "MISMATCH");
+		return err == 0;
+	}
+
+
+	// 従来の snd_mgr::update のミックス（８ビット、サンプル毎、最後にゲイン）
+	void legacy_update_(const std::vector<uint32_t>& pos, uint32_t voices, int16_t* final)
+	{
+		for(uint32_t i = 0; i < RDRLEN; ++i) {
+			final[i] = 0;
+		}
+		for(uint32_t i = 0; i < voices; ++i) {
+			const int8_t* org = &src_[i].w8[0];
+			uint32_t len = src_[i].w8.size();
+			uint32_t p = pos[i];
+			for(uint32_t j = 0; j < RDRLEN; ++j) {
+				if(p >= len) {
+					p = 0;
+				}
+				final[j] += org[p];
+				++p;
+			}
+		}
+		for(uint32_t i = 0; i < RDRLEN; ++i) {
+			final[i] *= 256 / SNDMAX;
+		}
+	}
+
+
+	// unity: 等倍、中央（従来と同じ処理）、それ以外はゲイン、パンを掛ける
+	double mixer_time_(uint32_t voices, bool w16, bool unity, uint32_t& sum)
+	{
+		static MIXER mixer;
+		for(uint32_t i = 0; i < SNDMAX; ++i) {
+			mixer.stop(i);
+		}
+		for(uint32_t i = 0; i < voices; ++i) {
+			uint16_t gain = unity ? MIXER::GAIN_ONE : 180;
+			int8_t pan = unity ? 0 : static_cast<int8_t>(static_cast<int32_t>(i * 16) - 120);
+			if(w16) {
+				mixer.play(&src_[i].w16[0], src_[i].w16.size(), true, gain, pan);
+			} else {
+				mixer.play(&src_[i].w8[0], src_[i].w8.size(), true, gain, pan);
+			}
+		}
+		auto st = std::chrono::steady_clock::now();
+		for(uint32_t n = 0; n < (opt_.frames / MIXER_REPEAT); ++n) {
+			mixer.update();
+			sum += mixer.get_buffer()[n % RDRLEN].l_ch;
+		}
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+		return d.count();
+	}
+
+
+	double legacy_time_(uint32_t voices, uint32_t& sum)
+	{
+		static int16_t final[RDRLEN];
+		std::vector<uint32_t> pos(SNDMAX);
+		auto st = std::chrono::steady_clock::now();
+		for(uint32_t n = 0; n < (opt_.frames / MIXER_REPEAT); ++n) {
+			legacy_update_(pos, voices, final);
+			for(uint32_t i = 0; i < voices; ++i) {
+				pos[i] = (pos[i] + RDRLEN) % src_[i].w8.size();
+			}
+			sum += final[n % RDRLEN];
+		}
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+		return d.count();
+	}
+
+
+	void mixer_bench_()
+	{
+		make_source_();
+		mixer_check_();
+
+		static const uint32_t voices[] = { 1, 2, 4, 8, 12, 16 };
+		uint32_t sum = 0;
+		printf("          [M voice*sample/s]  unity/center          gain/pan\n");
+		printf("voices  :  legacy 8bit      8bit     16bit      8bit     16bit\n");
+		for(uint32_t v : voices) {
+			double num = static_cast<double>(v) * RDRLEN * (opt_.frames / MIXER_REPEAT) / 1e6;
+			// 交互に計測して、最短の時間を使う（ホストの揺らぎを避ける）
+			double t[5] = { 1e9, 1e9, 1e9, 1e9, 1e9 };
+			for(uint32_t n = 0; n < MIXER_REPEAT; ++n) {
+				t[0] = std::min(t[0], legacy_time_(v, sum));
+				t[1] = std::min(t[1], mixer_time_(v, false, true, sum));
+				t[2] = std::min(t[2], mixer_time_(v, true, true, sum));
+				t[3] = std::min(t[3], mixer_time_(v, false, false, sum));
+				t[4] = std::min(t[4], mixer_time_(v, true, false, sum));
+			}
+			printf("%6u  : %12.1f  %8.1f  %8.1f  %8.1f  %8.1f\n", v,
+				num / t[0], num / t[1], num / t[2], num / t[3], num / t[4]);
+		}
+		printf("          (check: %u)\n", sum);
+	}
+
+
+	// 変換結果を受け取るサウンド出力（FIFO の代わりに、全て保存する）
+	struct sink_t {
+		struct fifo_t {
+			std::vector<sound::wave_t>	buf;
+			uint32_t size() const { return 0x7fffffff; }
+			uint32_t length() const { return 0; }
+			uint32_t put(const sound::wave_t* src, uint32_t n) {
+				buf.insert(buf.end(), src, src + n);
+				return n;
+			}
+		};
+		fifo_t	fifo;
+		fifo_t& at_fifo() { return fifo; }
+		void mute() { fifo.buf.clear(); }
+	};
+	typedef sound::resampler<sink_t> RESAMPLER;
+
+
+	void make_sine_(std::vector<sound::wave_t>& in, uint32_t rate, double freq, uint32_t len)
+	{
+		in.resize(len);
+		for(uint32_t i = 0; i < len; ++i) {
+			double v = std::sin(2.0 * M_PI * freq * i / rate) * 16384.0;
+			int16_t s = static_cast<int16_t>(std::floor(v + 0.5));
+			in[i].l_ch = static_cast<uint16_t>(s);
+			in[i].r_ch = static_cast<uint16_t>(-s);
+		}
+	}
+
+
+	// 正弦波を当てはめ、残差（歪＋雑音）と信号の比 [dB] を求める
+	double thdn_(const std::vector<sound::wave_t>& out, uint32_t rate, double freq, uint32_t skip)
+	{
+		double w = 2.0 * M_PI * freq / rate;
+		double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0, y1 = 0, s1 = 0, c1 = 0;
+		uint32_t n = 0;
+		for(uint32_t i = skip; i < (out.size() - skip); ++i) {
+			double s = std::sin(w * i);
+			double c = std::cos(w * i);
+			double y = static_cast<int16_t>(out[i].l_ch);
+			ss += s * s;  sc += s * c;  cc += c * c;
+			ys += y * s;  yc += y * c;  y1 += y;
+			s1 += s;  c1 += c;
+			++n;
+		}
+		// [ss sc s1; sc cc c1; s1 c1 n] * [a b d] = [ys yc y1]
+		double m[3][4] = { { ss, sc, s1, ys }, { sc, cc, c1, yc }, { s1, c1, (double)n, y1 } };
+		for(int i = 0; i < 3; ++i) {
+			for(int j = i + 1; j < 3; ++j) {
+				double f = m[j][i] / m[i][i];
+				for(int k = i; k < 4; ++k) m[j][k] -= f * m[i][k];
+			}
+		}
+		double x[3];
+		for(int i = 2; i >= 0; --i) {
+			double v = m[i][3];
+			for(int k = i + 1; k < 3; ++k) v -= m[i][k] * x[k];
+			x[i] = v / m[i][i];
+		}
+		double sig = 0, err = 0;
+		for(uint32_t i = skip; i < (out.size() - skip); ++i) {
+			double f = x[0] * std::sin(w * i) + x[1] * std::cos(w * i) + x[2];
+			double e = static_cast<int16_t>(out[i].l_ch) - f;
+			sig += f * f;
+			err += e * e;
+		}
+		return 10.0 * std::log10(err / sig);
+	}
+
+
+	// 直線補間（比較用）
+	void linear_(const std::vector<sound::wave_t>& in, uint32_t in_rate, uint32_t out_rate,
+		std::vector<sound::wave_t>& out)
+	{
+		out.clear();
+		uint64_t step = (static_cast<uint64_t>(in_rate) << 32) / out_rate;
+		uint64_t pos = 0;
+		while((pos >> 32) + 1 < in.size()) {
+			uint32_t i = pos >> 32;
+			int32_t f = static_cast<uint32_t>(pos) >> 17;
+			sound::wave_t t;
+			int32_t a = static_cast<int16_t>(in[i].l_ch);
+			int32_t b = static_cast<int16_t>(in[i + 1].l_ch);
+			t.l_ch = a + (((b - a) * f) >> 15);
+			a = static_cast<int16_t>(in[i].r_ch);
+			b = static_cast<int16_t>(in[i + 1].r_ch);
+			t.r_ch = a + (((b - a) * f) >> 15);
+			out.push_back(t);
+			pos += step;
+		}
+	}
+
+
+	void resample_bench_()
+	{
+		struct rate_t {
+			uint32_t	in;
+			uint32_t	out;
+		};
+		static const rate_t rates[] = {
+			{ 22050, 44100 }, { 32000, 44100 }, { 48000, 44100 }, { 44100, 48000 }, { 8000, 44100 }
+		};
+		static const RESAMPLER::QUALITY quality[] = {
+			RESAMPLER::QUALITY::LOW, RESAMPLER::QUALITY::MID, RESAMPLER::QUALITY::HIGH
+		};
+
+		printf("THD+N [dB] (-6 dBFS sine)   linear      LOW      MID     HIGH\n");
+		std::vector<sound::wave_t> in;
+		for(const auto& r : rates) {
+			uint32_t lim = r.in < r.out ? r.in : r.out;
+			double freqs[2] = { 1000.0, lim * 0.4 };
+			for(double f : freqs) {
+				make_sine_(in, r.in, f, r.in);
+				printf("%5u -> %5u, %7.1f Hz:", r.in, r.out, f);
+				std::vector<sound::wave_t> lin;
+				linear_(in, r.in, r.out, lin);
+				printf(" %8.1f", thdn_(lin, r.out, f, 64));
+				for(auto q : quality) {
+					sink_t sink;
+					sink.fifo.buf.reserve(r.out * 2);
+					RESAMPLER rs(sink, r.out, q);
+					rs.set_rate(r.in);
+					for(const auto& t : in) rs.put(t);
+					printf(" %8.1f", thdn_(sink.fifo.buf, r.out, f, 64));
+				}
+				printf("\n");
+			}
+		}
+
+		// 処理速度（出力サンプル、ステレオ）
+		printf("speed [M sample/s]          linear      LOW      MID     HIGH\n");
+		for(const auto& r : rates) {
+			make_sine_(in, r.in, 1000.0, r.in);
+			printf("%5u -> %5u            :", r.in, r.out);
+			uint32_t loop = opt_.frames / 100 + 1;
+			{
+				std::vector<sound::wave_t> lin;
+				uint32_t num = 0;
+				auto st = std::chrono::steady_clock::now();
+				for(uint32_t n = 0; n < loop; ++n) {
+					linear_(in, r.in, r.out, lin);
+					num += lin.size();
+				}
+				std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+				printf(" %8.1f", num / d.count() / 1e6);
+			}
+			for(auto q : quality) {
+				sink_t sink;
+				sink.fifo.buf.reserve(r.out * 2);
+				RESAMPLER rs(sink, r.out, q);
+				rs.set_rate(r.in);
+				uint32_t num = 0;
+				auto st = std::chrono::steady_clock::now();
+				for(uint32_t n = 0; n < loop; ++n) {
+					sink.fifo.buf.clear();
+					for(const auto& t : in) rs.put(t);
+					num += sink.fifo.buf.size();
+				}
+				std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+				printf(" %8.1f", num / d.count() / 1e6);
+			}
+			printf("\n");
+		}
+	}
+
+
+	static const uint32_t FIFO_SIZE = 8192;
+	static const uint32_t WAVE_SIZE = 1024;
+	typedef utils::sound_out<FIFO_SIZE, WAVE_SIZE> SOUND_OUT;
+
+	// 従来の転送（１サンプル毎に、空きを調べて put、service は get 毎に XOR）
+	void legacy_put_(SOUND_OUT& out, const sound::wave_t* src, uint32_t n)
+	{
+		for(uint32_t i = 0; i < n; ++i) {
+			while((out.at_fifo().size() - out.at_fifo().length()) < 8) {
+			}
+			out.at_fifo().put(src[i]);
+		}
+	}
+
+	void legacy_service_(SOUND_OUT& out, uint32_t& w_put, uint32_t num)
+	{
+		if(out.at_fifo().length() < num) return;
+
+		for(uint32_t i = 0; i < num; ++i) {
+			sound::wave_t* w = out.get_wave(w_put);
+			*w = out.at_fifo().get();
+			w->l_ch ^= 0x8000;
+			w->r_ch ^= 0x8000;
+			++w_put;
+			w_put &= (WAVE_SIZE - 1);
+		}
+	}
+
+
+	void fifo_bench_()
+	{
+		// デコーダーの出力単位（MP3 の１フレーム）で書き込み、割り込みの単位で読み出す
+		static const uint32_t FRAME = 1152;
+		static const uint32_t SERVICE = 64;
+		std::vector<sound::wave_t> src(FRAME);
+		seed_ = 1;
+		for(auto& t : src) {
+			t.l_ch = rand_() * 2;
+			t.r_ch = rand_() * 2;
+		}
+
+		static SOUND_OUT out;
+		uint32_t loop = opt_.frames * 10;
+		uint32_t err = 0;
+		double t[2];
+		for(uint32_t k = 0; k < 2; ++k) {
+			out.mute();
+			out.start(0);
+			uint32_t w_put = 0;
+			uint32_t pos = 0;
+			auto st = std::chrono::steady_clock::now();
+			for(uint32_t n = 0; n < loop; ++n) {
+				if(k == 0) {
+					legacy_put_(out, &src[0], FRAME);
+				} else {
+					out.put(&src[0], FRAME);
+				}
+				while(out.at_fifo().length() >= SERVICE) {
+					if(k == 0) {
+						legacy_service_(out, w_put, SERVICE);
+					} else {
+						out.service(SERVICE);
+					}
+					// 波形メモリに入った値を調べる（最後の周回だけ）
+					if(n == (loop - 1)) {
+						for(uint32_t i = 0; i < SERVICE; ++i) {
+							const sound::wave_t& w = *out.get_wave((pos + i) & (WAVE_SIZE - 1));
+							const sound::wave_t& s = src[(pos + i) % FRAME];
+							if(w.l_ch != (s.l_ch ^ 0x8000) || w.r_ch != (s.r_ch ^ 0x8000)) ++err;
+						}
+					}
+					pos += SERVICE;
+				}
+			}
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - st;
+			t[k] = d.count();
+		}
+		double num = static_cast<double>(loop) * FRAME;
+		printf("fifo    : per sample %.2f [ns/sample], span %.2f [ns/sample], error: %u -> %s\n",
+			t[0] * 1e9 / num, t[1] * 1e9 / num, err, err == 0 ? "match" : "MISMATCH");
+	}
+
+
+	// 従来の mp3_in の処理（サブバンド毎の mad_f_mul、サンプル毎の変換）
+	void legacy_filter_(mad_frame& frame, const mad_fixed_t* filter)
+	{
+		int num = MAD_NSBSAMPLES(&frame.header);
+		for(int ch = 0; ch < 2; ++ch) {
+			for(int s = 0; s < num; ++s) {
+				for(int sb = 0; sb < 32; ++sb) {
+					frame.sbsample[ch][s][sb] = mad_f_mul(frame.sbsample[ch][s][sb], filter[sb]);
+				}
+			}
+		}
+	}
+
+	short legacy_pcm_(mad_fixed_t v)
+	{
+		if(v >= MAD_F_ONE) return 32767;
+		if(v <= -MAD_F_ONE) return -32767;
+		return (signed short)(v >> (MAD_F_FRACBITS - 15));
+	}
+
+
+	void mp3_bench_()
+	{
+		static const uint32_t FRAME = 1152;
+		static mad_frame frame;
+		static mad_frame work;
+		static mad_pcm pcm;
+		frame.header.layer = MAD_LAYER_III;
+		frame.header.flags = 0;
+		frame.header.mode = MAD_MODE_STEREO;
+		seed_ = 7;
+		for(uint32_t ch = 0; ch < 2; ++ch) {
+			for(uint32_t s = 0; s < 36; ++s) {
+				for(uint32_t sb = 0; sb < 32; ++sb) {
+					frame.sbsample[ch][s][sb] = (static_cast<int32_t>(rand_()) - 0x4000) << 15;
+				}
+			}
+			// 振幅 1.2 の正弦波（クリップも起こる）
+			for(uint32_t i = 0; i < FRAME; ++i) {
+				double v = std::sin(2.0 * M_PI * (i + ch * 100) * 440.0 / 44100.0) * 1.2;
+				pcm.samples[ch][i] = static_cast<mad_fixed_t>(v * MAD_F_ONE) + (rand_() & 0xff);
+			}
+		}
+		pcm.length = FRAME;
+		mad_fixed_t filter[32];
+		for(uint32_t i = 0; i < 32; ++i) {
+			filter[i] = MAD_F_ONE / 4 + (MAD_F_ONE / 32) * i;  // 0.25 〜 1.22
+		}
+		mad_fixed_t gain[32];
+		sound::mad_kernel::make_gain(filter, gain);
+
+		// 結果の確認
+		uint32_t err_sb = 0;
+		{
+			work = frame;
+			legacy_filter_(work, filter);
+			mad_frame t0 = frame;
+			mad_frame t1 = frame;
+			sound::mad_kernel::subband_scalar(&t0.sbsample[0][0][0], 72, gain);
+			sound::mad_kernel::subband(&t1.sbsample[0][0][0], 72, gain);
+			for(uint32_t ch = 0; ch < 2; ++ch) {
+				for(uint32_t s = 0; s < 36; ++s) {
+					for(uint32_t sb = 0; sb < 32; ++sb) {
+						if(t0.sbsample[ch][s][sb] != work.sbsample[ch][s][sb]) ++err_sb;
+						if(t1.sbsample[ch][s][sb] != work.sbsample[ch][s][sb]) ++err_sb;
+					}
+				}
+			}
+		}
+		uint32_t err_pcm = 0;
+		uint32_t diff = 0;
+		{
+			std::vector<sound::wave_t> w0(FRAME), w1(FRAME), w2(FRAME), w3(FRAME);
+			sound::mad_kernel::dither_t d0, d1;
+			for(uint32_t n = 0; n < 3; ++n) {
+				sound::mad_kernel::convert_scalar(pcm.samples[0], pcm.samples[1], FRAME, &w0[0], &d0);
+				sound::mad_kernel::convert(pcm.samples[0], pcm.samples[1], FRAME, &w1[0], &d1);
+				sound::mad_kernel::convert(pcm.samples[0], pcm.samples[1], FRAME - 3, &w2[0]);
+				for(uint32_t i = 0; i < FRAME; ++i) {
+					if(w0[i].l_ch != w1[i].l_ch || w0[i].r_ch != w1[i].r_ch) ++err_pcm;
+				}
+			}
+			// ディザー無しは、従来の変換と丸め（最大１LSB）だけ違う
+			sound::mad_kernel::convert_scalar(pcm.samples[0], pcm.samples[1], FRAME - 3, &w3[0]);
+			for(uint32_t i = 0; i < (FRAME - 3); ++i) {
+				if(w2[i].l_ch != w3[i].l_ch || w2[i].r_ch != w3[i].r_ch) ++err_pcm;
+				int32_t a = static_cast<int16_t>(w2[i].l_ch);
+				int32_t b = legacy_pcm_(pcm.samples[0][i]);
+				uint32_t d = a > b ? a - b : b - a;
+				if(diff < d) diff = d;
+			}
+		}
+		printf("mp3     : subband error: %u, pcm error: %u (legacy diff %u LSB) -> %s\n",
+			err_sb, err_pcm, diff, (err_sb == 0 && err_pcm == 0 && diff <= 1) ? "match" : "MISMATCH");
+
+		// フレーム／秒（サブバンドのコピーを含む）
+		static const char* title[] = {
+			"legacy", "scalar", "scalar+dither",
+#if defined(__SSE2__)
+			"SSE2", "SSE2+dither"
+#else
+			"(no SIMD)", "(no SIMD)+dither"
+#endif
+		};
+		uint32_t loop = opt_.frames;
+		std::vector<sound::wave_t> wav(FRAME);
+		sound::mad_kernel::dither_t dt;
+		uint32_t sum = 0;
+		// 交互に計測して、最短の時間を使う（ホストの揺らぎを避ける）
+		double best[5] = { 1e9, 1e9, 1e9, 1e9, 1e9 };
+		for(uint32_t m = 0; m < 10; ++m)
+		for(uint32_t k = 0; k < 5; ++k) {
+			sound::mad_kernel::dither_t* d = (k == 2 || k == 4) ? &dt : nullptr;
+			auto st = std::chrono::steady_clock::now();
+			for(uint32_t n = 0; n < loop; ++n) {
+				std::memcpy(work.sbsample, frame.sbsample, sizeof(work.sbsample));
+				work.header = frame.header;
+				if(k == 0) {
+					legacy_filter_(work, filter);
+					for(uint32_t i = 0; i < FRAME; ++i) {
+						wav[i].l_ch = legacy_pcm_(pcm.samples[0][i]);
+						wav[i].r_ch = legacy_pcm_(pcm.samples[1][i]);
+					}
+				} else if(k <= 2) {
+					sound::mad_kernel::subband_scalar(&work.sbsample[0][0][0], 72, gain);
+					sound::mad_kernel::convert_scalar(pcm.samples[0], pcm.samples[1], FRAME, &wav[0], d);
+				} else {
+					sound::mad_kernel::subband(&work.sbsample[0][0][0], 72, gain);
+					sound::mad_kernel::convert(pcm.samples[0], pcm.samples[1], FRAME, &wav[0], d);
+				}
+				sum += wav[n % FRAME].l_ch + work.sbsample[1][n % 36][n & 31];
+			}
+			std::chrono::duration<double> t = std::chrono::steady_clock::now() - st;
+			best[k] = std::min(best[k], t.count());
+		}
+		printf("frames/s:");
+		for(uint32_t k = 0; k < 5; ++k) {
+			printf(" %s %.0f%s", title[k], loop / best[k], k < 4 ? "," : "");
+		}
+		printf("\n          (check: %u)\n", sum);
+	}
+
+
+	// SD カードのアクセス時間（仮想時間で進める）
+	struct sd_cost_t {
+		uint32_t	open_us = 40000;	///< f_open（長いファイル名の検索を含む）
+		uint32_t	seek_us = 1000;		///< f_lseek（クラスタ・チェインを辿る）
+		uint32_t	read_us = 300;		///< f_read の１回毎（転送は４Ｍバイト／秒）
+		uint32_t	tag_us = 60000;		///< タグの表示（LCD への描画）
+	};
+	sd_cost_t	sd_cost_;
+	uint64_t	vclock_;
+	std::map<const FIL*, FILE*>	host_fp_;
+
+
+	// 仮想時間で再生する出力（FIFO が空になったサンプル数を記録する）
+	struct play_sink_t {
+		static const uint32_t SIZE = 8192;
+		static const uint32_t RATE = 44100;
+
+		std::vector<sound::wave_t>	rec;
+		uint32_t	fill = 0;
+		uint64_t	org = 0;
+		uint64_t	pos = 0;
+		bool		run = false;
+		bool		gap = false;
+		uint32_t	under = 0;
+		uint32_t	gaps = 0;
+		uint32_t	rate_err = 0;
+
+		void drain_() {
+			if(!run) return;
+			uint64_t t = (vclock_ - org) * RATE / 1000000;
+			uint32_t d = t - pos;
+			pos = t;
+			if(d > fill) {
+				under += d - fill;
+				if(!gap) ++gaps;
+				gap = true;
+				fill = 0;
+			} else {
+				fill -= d;
+			}
+		}
+
+		void set_rate(uint32_t rate) { if(rate != RATE) ++rate_err; }
+
+		void put(const sound::wave_t* src, uint32_t n) {
+			rec.insert(rec.end(), src, src + n);
+			if(!run) {
+				run = true;
+				org = vclock_;
+				pos = 0;
+			}
+			drain_();
+			gap = false;
+			while(n > 0) {
+				uint32_t sp = SIZE - 1 - fill;
+				if(sp == 0) {  // 空くまで待つ
+					vclock_ += (std::min(n, 64u) * 1000000 + RATE - 1) / RATE;
+					drain_();
+					continue;
+				}
+				uint32_t l = std::min(n, sp);
+				fill += l;
+				n -= l;
+			}
+		}
+
+		void mute() { fill = 0; }
+
+		uint32_t get_length() { drain_(); return fill; }
+
+		uint32_t get_size() const { return SIZE; }
+	};
+
+
+	void tag_task_(const sound::tag_t& tag)
+	{
+		vclock_ += sd_cost_.tag_us;
+	}
+
+
+	void put16_(std::vector<uint8_t>& v, uint16_t a) {
+		v.push_back(a & 0xff);
+		v.push_back(a >> 8);
+	}
+	void put32_(std::vector<uint8_t>& v, uint32_t a) {
+		put16_(v, a & 0xffff);
+		put16_(v, a >> 16);
+	}
+	void put4cc_(std::vector<uint8_t>& v, const char* s) { v.insert(v.end(), s, s + 4); }
+
+
+	// LIST INFO（タイトル）を前に、trail の場合は、data の後にも置く
+	bool write_wav_(const std::string& path, const std::vector<sound::wave_t>& src, uint8_t ch,
+		const char* title, bool trail)
+	{
+		std::vector<uint8_t> list;
+		put4cc_(list, "INFO");
+		put4cc_(list, "INAM");
+		uint32_t tl = std::strlen(title) + 1;
+		put32_(list, tl);
+		list.insert(list.end(), title, title + tl);
+		if(tl & 1) list.push_back(0);
+
+		std::vector<uint8_t> v;
+		put4cc_(v, "RIFF");
+		put32_(v, 0);
+		put4cc_(v, "WAVE");
+		put4cc_(v, "fmt ");
+		put32_(v, 16);
+		put16_(v, 1);
+		put16_(v, ch);
+		put32_(v, play_sink_t::RATE);
+		put32_(v, play_sink_t::RATE * ch * 2);
+		put16_(v, ch * 2);
+		put16_(v, 16);
+		put4cc_(v, "LIST");
+		put32_(v, list.size());
+		v.insert(v.end(), list.begin(), list.end());
+		put4cc_(v, "data");
+		put32_(v, src.size() * ch * 2);
+		for(const auto& t : src) {
+			put16_(v, t.l_ch);
+			if(ch == 2) put16_(v, t.r_ch);
+		}
+		if(trail) {
+			put4cc_(v, "LIST");
+			put32_(v, list.size());
+			v.insert(v.end(), list.begin(), list.end());
+		}
+		uint32_t riff = v.size() - 8;
+		std::memcpy(&v[4], &riff, 4);
+
+		FILE* fp = fopen(path.c_str(), "wb");
+		if(fp == nullptr) return false;
+		fwrite(&v[0], 1, v.size(), fp);
+		fclose(fp);
+		return true;
+	}
+
+
+	struct track_t {
+		uint32_t	len;
+		uint8_t		ch;
+		bool		trail;
+	};
+
+
+	// 曲間で位相が続く正弦波（corner の場合、先読みより短い曲、壊れたファイル、@n
+	// デコードできない MP3 を含む）
+	bool make_tracks_(const std::string& dir, bool corner, std::vector<std::string>& list,
+		std::vector<sound::wave_t>& expect)
+	{
+		static const track_t normal[] = {
+			{ 60000, 2, false }, { 45000, 2, true }, { 70001, 2, false }, { 25000, 1, false },
+			{ 52000, 2, true }, { 44100, 2, false },
+		};
+		static const track_t short_tbl[] = {
+			{ 30000, 2, false }, { 1500, 2, true }, { 70001, 2, true }, { 25000, 1, false },
+			{ 800, 2, false }, { 44100, 2, false }, { 12345, 2, true },
+		};
+		if(mkdir(dir.c_str(), 0700) != 0) return false;
+		const track_t* tbl = corner ? short_tbl : normal;
+		uint32_t num = corner ? (sizeof(short_tbl) / sizeof(track_t)) : (sizeof(normal) / sizeof(track_t));
+		double ph = 0.0;
+		for(uint32_t i = 0; i < num; ++i) {
+			const auto& t = tbl[i];
+			std::vector<sound::wave_t> src(t.len);
+			for(uint32_t j = 0; j < t.len; ++j) {
+				src[j].l_ch = static_cast<int16_t>(std::floor(12000.0 * std::sin(ph) + 0.5));
+				src[j].r_ch = static_cast<int16_t>(std::floor(9000.0 * std::sin(ph * 1.5) + 0.5));
+				if(t.ch == 1) src[j].r_ch = src[j].l_ch;
+				ph += 2.0 * 3.14159265358979 * 440.0 / play_sink_t::RATE;
+			}
+			char name[32];
+			snprintf(name, sizeof(name), "Track %u", i + 1);
+			std::string path = dir + "/" + name + ".wav";
+			if(!write_wav_(path, src, t.ch, name, t.trail)) return false;
+			list.push_back(path);
+			expect.insert(expect.end(), src.begin(), src.end());
+			if(corner && (i == 1 || i == 4)) {  // 壊れたファイル、デコードできない MP3
+				std::string bad = dir + (i == 1 ? "/bad.wav" : "/none.mp3");
+				FILE* fp = fopen(bad.c_str(), "wb");
+				if(fp == nullptr) return false;
+				fprintf(fp, "RIFF....WAVEjunk");
+				fclose(fp);
+				list.push_back(bad);
+			}
+		}
+		return true;
+	}
+
+
+	struct play_result_t {
+		uint32_t	num;
+		uint32_t	under;
+		uint32_t	gaps;
+		bool		match;
+	};
+
+
+	// 曲毎に decode（legacy）、又は、play_list で全て再生する
+	play_result_t play_tracks_(const std::vector<std::string>& list,
+		const std::vector<sound::wave_t>& expect, bool legacy)
+	{
+		typedef sound::play_list<play_sink_t> PLAY_LIST;
+		static PLAY_LIST play_list;
+		static sound::mp3_in mp3;
+		static sound::wav_in wav;
+		play_list.set_tag_task(tag_task_);
+		mp3.set_tag_task(tag_task_);
+		wav.set_tag_task(tag_task_);
+
+		play_sink_t sink;
+		vclock_ = 0;
+		play_result_t r;
+		r.num = 0;
+		if(legacy) {
+			for(const auto& path : list) {
+				utils::file_io fin;
+				if(!fin.open(path.c_str(), "rb")) continue;
+				bool ret;
+				if(path.compare(path.size() - 4, 4, ".mp3") == 0) {
+					ret = mp3.decode(fin, sink);
+				} else {
+					ret = wav.decode(fin, sink);
+				}
+				if(ret) ++r.num;
+				fin.close();
+			}
+		} else {
+			for(const auto& path : list) {
+				play_list.add(path.c_str());
+			}
+			r.num = play_list.play(sink);
+		}
+		r.under = sink.under;
+		r.gaps = sink.gaps;
+		r.match = sink.rec.size() == expect.size() && sink.rate_err == 0;
+		for(uint32_t i = 0; r.match && i < expect.size(); ++i) {
+			r.match = sink.rec[i].l_ch == expect[i].l_ch && sink.rec[i].r_ch == expect[i].r_ch;
+		}
+		return r;
+	}
+
+
+	void playlist_bench_()
+	{
+		char tmp[] = "/tmp/sound_bench_XXXXXX";
+		if(mkdtemp(tmp) == nullptr) {
+			printf("Can't make directory\n");
+			return;
+		}
+		std::string dir = tmp;
+		std::vector<std::string> list[2];
+		std::vector<sound::wave_t> expect[2];
+		for(uint32_t i = 0; i < 2; ++i) {
+			if(!make_tracks_(dir + (i == 0 ? "/n" : "/c"), i != 0, list[i], expect[i])) {
+				printf("Can't write tracks: '%s'\n", dir.c_str());
+				return;
+			}
+		}
+
+		printf("playlist: FIFO %u samples (%.0f ms), tag %u ms, read %u us/call, seek %u us\n",
+			play_sink_t::SIZE, play_sink_t::SIZE * 1000.0 / play_sink_t::RATE,
+			sd_cost_.tag_us / 1000, sd_cost_.read_us, sd_cost_.seek_us);
+		printf("  %u tracks, underrun samples (gaps):\n", static_cast<uint32_t>(list[0].size()));
+		static const uint32_t open_ms[] = { 10, 40, 80, 120, 160, 200 };
+		bool ok = true;
+		for(uint32_t k = 0; k < (sizeof(open_ms) / sizeof(open_ms[0])); ++k) {
+			sd_cost_.open_us = open_ms[k] * 1000;
+			auto a = play_tracks_(list[0], expect[0], true);
+			auto b = play_tracks_(list[0], expect[0], false);
+			if(!a.match || !b.match || a.num != list[0].size() || b.num != list[0].size()) ok = false;
+			printf("  open %3u ms: legacy %6u (%u), play_list %6u (%u)\n", open_ms[k],
+				a.under, a.gaps, b.under, b.gaps);
+		}
+		printf("  output: %s\n", ok ? "match (gapless splice)" : "MISMATCH");
+
+		// 短い曲、壊れたファイルを含む場合（先読みは１曲なので、続くと間に合わない場合がある）
+		sd_cost_ = sd_cost_t();
+		auto c = play_tracks_(list[1], expect[1], false);
+		printf("corner  : %u files, %u tracks played, underrun %u (%u) at open %u ms -> %s\n",
+			static_cast<uint32_t>(list[1].size()), c.num, c.under, c.gaps,
+			sd_cost_.open_us / 1000, c.match && c.num == 7 ? "match" : "MISMATCH");
+
+		for(uint32_t i = 0; i < 2; ++i) {
+			for(const auto& path : list[i]) {
+				remove(path.c_str());
+			}
+		}
+		rmdir((dir + "/n").c_str());
+		rmdir((dir + "/c").c_str());
+		rmdir(dir.c_str());
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("sound benchmark Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options]\n", cmd);
+		printf("    -mixer       mixer against 64 bits reference and legacy (default)\n");
+		printf("    -resample    resampler THD+N and speed against linear interpolation\n");
+		printf("    -fifo        sound_out transfer, per sample against span\n");
+		printf("    -mp3         mp3 subband filter and PCM conversion kernels\n");
+		printf("    -playlist    gapless play_list against decode per file\n");
+		printf("    -frames N    render frames (default: %u)\n", opt_.frames);
+	}
+}
+
+
+extern "C" {
+
+	int make_full_path(const char* src, char* dst, uint16_t dsz)
+	{
+		std::strncpy(dst, src, dsz - 1);
+		dst[dsz - 1] = 0;
+		return 1;
+	}
+
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz)
+	{
+		if(src != dst) std::strncpy(dst, src, dsz);
+	}
+
+	// コード変換（ASCII だけを扱う）
+	WCHAR ff_convert(WCHAR chr, UINT dir) { return chr < 0x80 ? chr : '?'; }
+
+	FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode)
+	{
+		vclock_ += sd_cost_.open_us;
+		FILE* f = fopen(path, "rb");
+		if(f == nullptr) return FR_NO_FILE;
+		fseek(f, 0, SEEK_END);
+		fp->obj.objsize = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		fp->fptr = 0;
+		host_fp_[fp] = f;
+		return FR_OK;
+	}
+
+	FRESULT f_close(FIL* fp)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		fclose(it->second);
+		host_fp_.erase(it);
+		return FR_OK;
+	}
+
+	FRESULT f_lseek(FIL* fp, FSIZE_t ofs)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		vclock_ += sd_cost_.seek_us;
+		if(ofs > fp->obj.objsize) ofs = fp->obj.objsize;
+		fseek(it->second, ofs, SEEK_SET);
+		fp->fptr = ofs;
+		return FR_OK;
+	}
+
+	FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br)
+	{
+		auto it = host_fp_.find(fp);
+		if(it == host_fp_.end()) return FR_INVALID_OBJECT;
+		*br = fread(buff, 1, btr, it->second);
+		fp->fptr += *br;
+		vclock_ += sd_cost_.read_us + *br / 4;
+		return FR_OK;
+	}
+
+	// libmad の代わり（ホストではデコードしない）
+	mad_timer_t const mad_timer_zero = { 0, 0 };
+
+	void mad_timer_add(mad_timer_t*, mad_timer_t) { }
+
+	void mad_stream_init(mad_stream* stream) { std::memset(stream, 0, sizeof(mad_stream)); }
+
+	void mad_stream_finish(mad_stream*) { }
+
+	void mad_stream_buffer(mad_stream* stream, unsigned char const* buffer, unsigned long length)
+	{
+		stream->buffer = buffer;
+		stream->bufend = buffer + length;
+	}
+
+	void mad_frame_init(mad_frame*) { }
+
+	void mad_frame_finish(mad_frame*) { }
+
+	int mad_frame_decode(mad_frame*, mad_stream* stream)
+	{
+		stream->error = MAD_ERROR_NOMEM;
+		return -1;
+	}
+
+	void mad_synth_init(mad_synth*) { }
+
+	void mad_synth_frame(mad_synth*, mad_frame const*) { }
+};
+
+int main(int argc, char* argv[])
+{
+	enum class MODE {
+		MIXER,
+		RESAMPLE,
+		FIFO,
+		MP3,
+		PLAYLIST
+	};
+	MODE mode = MODE::MIXER;
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-mixer") mode = MODE::MIXER;
+		else if(s == "-resample") mode = MODE::RESAMPLE;
+		else if(s == "-fifo") mode = MODE::FIFO;
+		else if(s == "-mp3") mode = MODE::MP3;
+		else if(s == "-playlist") mode = MODE::PLAYLIST;
+		else if(s == "-frames" && (i + 1) < argc) opt_.frames = std::atoi(argv[++i]);
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+
+	switch(mode) {
+	case MODE::MIXER:
+		mixer_bench_();
+		break;
+	case MODE::RESAMPLE:
+		resample_bench_();
+		break;
+	case MODE::FIFO:
+		fifo_bench_();
+		break;
+	case MODE::MP3:
+		mp3_bench_();
+		break;
+	case MODE::PLAYLIST:
+		playlist_bench_();
+		break;
+	}
+	return 0;
+}
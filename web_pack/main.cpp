@@ -0,0 +1,267 @@
+//=====================================================================//
+/*!	@file
+	@brief	Web パック・パッカー（ホスト用）@n
+			Web ルート以下のファイルを gzip で圧縮し、インデックス付きの @n
+			一つのパック・ファイルにまとめる。@n
+			圧縮効果の無いファイルは、無圧縮データのみを格納する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "common/web_pack_st.hpp"
+
+namespace {
+
+	const char* version_ = "0.10";
+
+	struct option {
+		int		level;		///< 圧縮レベル
+		int		gain;		///< gzip を採用する最小の削減率（％）
+		bool	verbose;
+		option() : level(9), gain(5), verbose(false) { }
+	};
+	option	opt_;
+
+	struct file_t {
+		std::string				path;	///< パック内のパス（"/" から始まる）
+		std::vector<uint8_t>	raw;
+		std::vector<uint8_t>	gz;
+		uint32_t				mtime;
+		uint32_t				crc;
+	};
+
+
+	bool read_file_(const std::string& fn, std::vector<uint8_t>& out)
+	{
+		FILE* fp = fopen(fn.c_str(), "rb");
+		if(fp == nullptr) return false;
+		fseek(fp, 0, SEEK_END);
+		long sz = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		out.resize(sz);
+		bool ret = sz == 0 || fread(&out[0], 1, sz, fp) == static_cast<size_t>(sz);
+		fclose(fp);
+		return ret;
+	}
+
+
+	bool gzip_(const std::vector<uint8_t>& src, std::vector<uint8_t>& dst)
+	{
+		z_stream z;
+		z.zalloc = Z_NULL;
+		z.zfree = Z_NULL;
+		z.opaque = Z_NULL;
+		// windowBits + 16 で gzip ヘッダーを付ける
+		if(deflateInit2(&z, opt_.level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return false;
+		}
+		dst.resize(deflateBound(&z, src.size()) + 32);
+		z.next_in = const_cast<Bytef*>(src.empty() ? nullptr : &src[0]);
+		z.avail_in = src.size();
+		z.next_out = &dst[0];
+		z.avail_out = dst.size();
+		int ret = deflate(&z, Z_FINISH);
+		dst.resize(z.total_out);
+		deflateEnd(&z);
+		return ret == Z_STREAM_END;
+	}
+
+
+	bool scan_(const std::string& root, const std::string& path, std::vector<file_t>& list)
+	{
+		std::string dir = root + path;
+		DIR* dp = opendir(dir.c_str());
+		if(dp == nullptr) {
+			fprintf(stderr, "Can't open directory: '%s'\n", dir.c_str());
+			return false;
+		}
+		std::vector<std::string> names;
+		struct dirent* ent;
+		while((ent = readdir(dp)) != nullptr) {
+			if(ent->d_name[0] == '.') continue;
+			names.push_back(ent->d_name);
+		}
+		closedir(dp);
+		std::sort(names.begin(), names.end());
+
+		for(const auto& n : names) {
+			std::string p = path + "/" + n;
+			std::string fn = root + p;
+			struct stat st;
+			if(stat(fn.c_str(), &st) != 0) continue;
+			if(S_ISDIR(st.st_mode)) {
+				if(!scan_(root, p, list)) return false;
+				continue;
+			}
+			if(!S_ISREG(st.st_mode)) continue;
+
+			file_t f;
+			f.path = p;
+			f.mtime = st.st_mtime;
+			if(!read_file_(fn, f.raw)) {
+				fprintf(stderr, "Can't read file: '%s'\n", fn.c_str());
+				return false;
+			}
+			f.crc = crc32(0, f.raw.empty() ? nullptr : &f.raw[0], f.raw.size());
+			if(!gzip_(f.raw, f.gz)) {
+				fprintf(stderr, "Compress error: '%s'\n", fn.c_str());
+				return false;
+			}
+			// 圧縮効果が少ない場合、gzip データは持たない
+			if(f.gz.size() * 100 > f.raw.size() * (100 - opt_.gain)) {
+				f.gz.clear();
+			}
+			list.push_back(f);
+		}
+		return true;
+	}
+
+
+	void put32_(std::vector<uint8_t>& out, uint32_t v)
+	{
+		out.push_back(v);
+		out.push_back(v >> 8);
+		out.push_back(v >> 16);
+		out.push_back(v >> 24);
+	}
+
+
+	uint32_t align_(uint32_t v)
+	{
+		return (v + utils::web_pack_st::ALIGN - 1) & ~(utils::web_pack_st::ALIGN - 1);
+	}
+
+
+	bool write_pack_(const std::string& fn, std::vector<file_t>& list)
+	{
+		typedef utils::web_pack_st st;
+
+		std::sort(list.begin(), list.end(), [](const file_t& a, const file_t& b) {
+			return st::hash(a.path.c_str()) < st::hash(b.path.c_str());
+		});
+
+		uint32_t name_size = 0;
+		for(const auto& f : list) name_size += f.path.size() + 1;
+
+		uint32_t pos = align_(sizeof(st::header_t) + list.size() * sizeof(st::entry_t) + name_size);
+
+		std::vector<uint8_t> head;
+		head.push_back('W');
+		head.push_back('P');
+		head.push_back('K');
+		head.push_back('1');
+		put32_(head, list.size());
+		put32_(head, name_size);
+		put32_(head, st::ALIGN);
+
+		std::vector<uint8_t> names;
+		for(const auto& f : list) {
+			put32_(head, st::hash(f.path.c_str()));
+			put32_(head, names.size());
+			names.insert(names.end(), f.path.begin(), f.path.end());
+			names.push_back(0);
+			put32_(head, pos);
+			put32_(head, f.raw.size());
+			pos = align_(pos + f.raw.size());
+			if(f.gz.empty()) {
+				put32_(head, 0);
+				put32_(head, 0);
+			} else {
+				put32_(head, pos);
+				put32_(head, f.gz.size());
+				pos = align_(pos + f.gz.size());
+			}
+			put32_(head, f.mtime);
+			put32_(head, f.crc);
+		}
+		head.insert(head.end(), names.begin(), names.end());
+
+		FILE* fp = fopen(fn.c_str(), "wb");
+		if(fp == nullptr) {
+			fprintf(stderr, "Can't create file: '%s'\n", fn.c_str());
+			return false;
+		}
+		std::vector<uint8_t> out(head);
+		auto put = [&](const std::vector<uint8_t>& src) {
+			out.resize(align_(out.size()), 0);
+			out.insert(out.end(), src.begin(), src.end());
+		};
+		for(const auto& f : list) {
+			put(f.raw);
+			if(!f.gz.empty()) put(f.gz);
+		}
+		bool ret = fwrite(&out[0], 1, out.size(), fp) == out.size();
+		fclose(fp);
+		if(!ret) {
+			fprintf(stderr, "Write error: '%s'\n", fn.c_str());
+		}
+		return ret;
+	}
+
+
+	void help_(const char* cmd)
+	{
+		printf("Web pack packer Version %s\n", version_);
+		printf("usage:\n");
+		printf("    %s [options] web-root pack-file\n", cmd);
+		printf("    -level N    gzip compression level (default: %d)\n", opt_.level);
+		printf("    -gain N     minimum gzip gain [%%] (default: %d)\n", opt_.gain);
+		printf("    -verbose    list entries\n");
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::string root;
+	std::string out;
+	for(int i = 1; i < argc; ++i) {
+		std::string s = argv[i];
+		if(s == "-level" && (i + 1) < argc) opt_.level = std::atoi(argv[++i]);
+		else if(s == "-gain" && (i + 1) < argc) opt_.gain = std::atoi(argv[++i]);
+		else if(s == "-verbose") opt_.verbose = true;
+		else if(s[0] != '-' && root.empty()) root = s;
+		else if(s[0] != '-' && out.empty()) out = s;
+		else {
+			help_(argv[0]);
+			return 0;
+		}
+	}
+	if(root.empty() || out.empty()) {
+		help_(argv[0]);
+		return 0;
+	}
+	while(root.size() > 1 && root.back() == '/') root.pop_back();
+
+	std::vector<file_t> list;
+	if(!scan_(root, "", list)) return -1;
+	if(!write_pack_(out, list)) return -1;
+
+	uint32_t raw = 0;
+	uint32_t best = 0;
+	for(const auto& f : list) {
+		raw += f.raw.size();
+		best += f.gz.empty() ? f.raw.size() : f.gz.size();
+		if(opt_.verbose) {
+			printf("%-32s %8u", f.path.c_str(), static_cast<uint32_t>(f.raw.size()));
+			if(!f.gz.empty()) {
+				printf(" -> %8u (%u%%)", static_cast<uint32_t>(f.gz.size()),
+					static_cast<uint32_t>(f.gz.size() * 100 / f.raw.size()));
+			}
+			printf("\n");
+		}
+	}
+	printf("%u files, %u bytes -> %u bytes (gzip transfer)\n",
+		static_cast<uint32_t>(list.size()), raw, best);
+	return 0;
+}